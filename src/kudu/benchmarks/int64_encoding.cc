@@ -0,0 +1,148 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+//
+// Micro benchmark comparing the encoded size and decoding speed of the
+// encodings available for 64-bit integer columns, on a few typical
+// distributions of values.
+//
+
+#include <glog/logging.h>
+#include <gflags/gflags.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/cfile/bshuf_block.h"
+#include "kudu/cfile/cfile_writer.h"
+#include "kudu/cfile/delta_bitpacked_block.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/stopwatch.h"
+
+DEFINE_int32(int64_encoding_num_values, 10 * 1000 * 1000,
+             "Number of values to encode for each distribution");
+DEFINE_int32(int64_encoding_decode_rounds, 10,
+             "Number of times to decode the encoded values");
+
+namespace kudu {
+namespace cfile {
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+// Encodes 'values' into as many blocks as needed with builders of type
+// 'Builder', then decodes them 'FLAGS_int64_encoding_decode_rounds' times
+// with decoders of type 'Decoder'.
+template<class Builder, class Decoder>
+void BenchmarkEncoding(const string& encoding, const string& distribution,
+                       const vector<int64_t>& values) {
+  WriterOptions opts;
+  Builder builder(&opts);
+  vector<string> blocks;
+  size_t encoded_size = 0;
+  for (size_t i = 0; i < values.size(); ) {
+    builder.Reset();
+    i += builder.Add(reinterpret_cast<const uint8_t*>(&values[i]), values.size() - i);
+    Slice block = builder.Finish(i);
+    encoded_size += block.size();
+    blocks.push_back(block.ToString());
+  }
+
+  vector<int64_t> decoded(values.size());
+  Arena arena(1024, 1024);
+  ColumnBlock cblock(GetTypeInfo(INT64), nullptr, &decoded[0], decoded.size(), &arena);
+  Stopwatch sw;
+  sw.start();
+  for (int round = 0; round < FLAGS_int64_encoding_decode_rounds; round++) {
+    ColumnDataView dst(&cblock);
+    for (const string& block : blocks) {
+      Decoder decoder((Slice(block)));
+      CHECK_OK(decoder.ParseHeader());
+      size_t n = decoder.Count();
+      CHECK_OK(decoder.CopyNextValues(&n, &dst));
+      dst.Advance(n);
+    }
+  }
+  sw.stop();
+  CHECK(decoded == values) << "values did not round trip";
+
+  double decoded_values = static_cast<double>(values.size()) *
+      FLAGS_int64_encoding_decode_rounds;
+  LOG(INFO) << strings::Substitute(
+      "$0 $1: $2 blocks, $3 bytes ($4 bits/value), decoded at $5 M values/sec",
+      distribution, encoding, blocks.size(), encoded_size,
+      encoded_size * 8.0 / values.size(),
+      decoded_values / sw.elapsed().wall_seconds() / 1e6);
+}
+
+void BenchmarkDistribution(const string& distribution, const vector<int64_t>& values) {
+  BenchmarkEncoding<BShufBlockBuilder<INT64>, BShufBlockDecoder<INT64>>(
+      "BIT_SHUFFLE", distribution, values);
+  BenchmarkEncoding<DeltaBitPackedBlockBuilder<INT64>, DeltaBitPackedBlockDecoder<INT64>>(
+      "DELTA_BITPACKED", distribution, values);
+}
+
+void RunBenchmarks() {
+  const int num_values = FLAGS_int64_encoding_num_values;
+  std::mt19937_64 rng(12345);
+  vector<int64_t> values(num_values);
+
+  // Auto-incrementing IDs.
+  for (int i = 0; i < num_values; i++) {
+    values[i] = 1000000000L + i;
+  }
+  BenchmarkDistribution("sequential ids", values);
+
+  // Microsecond timestamps of events arriving every few milliseconds.
+  int64_t ts = 1457000000000000L;
+  for (int i = 0; i < num_values; i++) {
+    ts += rng() % 10000;
+    values[i] = ts;
+  }
+  BenchmarkDistribution("event timestamps", values);
+
+  // Small, unsorted values.
+  for (int i = 0; i < num_values; i++) {
+    values[i] = rng() % 100000;
+  }
+  BenchmarkDistribution("small random values", values);
+
+  // Values spanning the whole range.
+  for (int i = 0; i < num_values; i++) {
+    values[i] = static_cast<int64_t>(rng());
+  }
+  BenchmarkDistribution("random values", values);
+}
+
+} // namespace cfile
+} // namespace kudu
+
+int main(int argc, char **argv) {
+  FLAGS_logtostderr = 1;
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  kudu::InitGoogleLoggingSafe(argv[0]);
+
+  LOG_TIMING(INFO, "int64 encoding benchmarks") {
+    kudu::cfile::RunBenchmarks();
+  }
+
+  return 0;
+}
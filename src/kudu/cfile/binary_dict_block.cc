@@ -25,6 +25,7 @@
 #include "kudu/cfile/cfile_writer.h"
 #include "kudu/cfile/bshuf_block.h"
 #include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/gutil/casts.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/util/coding.h"
@@ -260,6 +261,44 @@ Status BinaryDictBlockDecoder::CopyNextDecodeStrings(size_t* n, ColumnDataView*
   return Status::OK();
 }
 
+Status BinaryDictBlockDecoder::CopyNextAndEvaluateCodes(size_t* n,
+                                                        const SelectionVector& matching_codes,
+                                                        SelectionVector* sel,
+                                                        ColumnDataView* dst) {
+  DCHECK(parsed_);
+  DCHECK_EQ(mode_, kCodeWordMode);
+  CHECK_EQ(dst->type_info()->physical_type(), BINARY);
+  DCHECK_LE(*n, dst->nrows());
+  DCHECK_EQ(dst->stride(), sizeof(Slice));
+
+  Arena* out_arena = dst->arena();
+  Slice* out = reinterpret_cast<Slice*>(dst->data());
+
+  codeword_buf_.resize((*n)*sizeof(uint32_t));
+
+  BShufBlockDecoder<UINT32>* d_bptr = down_cast<BShufBlockDecoder<UINT32>*>(data_decoder_.get());
+  RETURN_NOT_OK(d_bptr->CopyNextValuesToArray(n, codeword_buf_.data()));
+
+  // Test the code of each selected row, and only copy the strings of the
+  // rows which match.
+  const uint32_t* codewords = reinterpret_cast<const uint32_t*>(codeword_buf_.data());
+  uint8_t* sel_bitmap = sel->mutable_bitmap();
+  size_t sel_idx = dst->first_row_index();
+  for (size_t i = 0; i < *n; i++, sel_idx++) {
+    if (!BitmapTest(sel_bitmap, sel_idx)) {
+      continue;
+    }
+    uint32_t codeword = codewords[i];
+    if (!matching_codes.IsRowSelected(codeword)) {
+      BitmapClear(sel_bitmap, sel_idx);
+      continue;
+    }
+    Slice elem = dict_decoder_->string_at_index(codeword);
+    CHECK(out_arena->RelocateSlice(elem, &out[i]));
+  }
+  return Status::OK();
+}
+
 Status BinaryDictBlockDecoder::CopyNextValues(size_t* n, ColumnDataView* dst) {
   if (mode_ == kCodeWordMode) {
     return CopyNextDecodeStrings(n, dst);
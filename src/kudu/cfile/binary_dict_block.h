@@ -52,6 +52,7 @@
 
 namespace kudu {
 class Arena;
+class SelectionVector;
 namespace cfile {
 
 struct WriterOptions;
@@ -74,6 +75,11 @@ class BinaryDictBlockBuilder : public BlockBuilder {
   // accordingly.
   Status AppendExtraInfo(CFileWriter* c_writer, CFileFooterPB* footer) OVERRIDE;
 
+  // Returns the size of the dictionary block.
+  size_t ExtraInfoSize() const OVERRIDE {
+    return dict_block_.EstimateEncodedSize();
+  }
+
   int Add(const uint8_t* vals, size_t count) OVERRIDE;
 
   Slice Finish(rowid_t ordinal_pos) OVERRIDE;
@@ -142,6 +148,22 @@ class BinaryDictBlockDecoder : public BlockDecoder {
     return data_decoder_->GetFirstRowId();
   }
 
+  // Returns true if the block holds dictionary codes, rather than plain
+  // strings.
+  bool HasCodeWords() const {
+    return mode_ == kCodeWordMode;
+  }
+
+  // Like CopyNextValues(), but evaluates a predicate on the dictionary codes
+  // of the next *n rows: 'matching_codes' has a set bit for each code whose
+  // string matches the predicate. The bits in 'sel' (which is indexed like
+  // the column block under 'dst') of rows with other codes are cleared, and
+  // only the strings of the rows left selected are copied into 'dst'.
+  //
+  // Requires that the block holds dictionary codes.
+  Status CopyNextAndEvaluateCodes(size_t* n, const SelectionVector& matching_codes,
+                                  SelectionVector* sel, ColumnDataView* dst);
+
   static const size_t kMinHeaderSize = sizeof(uint32_t) * 1;
 
  private:
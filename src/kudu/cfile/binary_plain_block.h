@@ -62,6 +62,11 @@ class BinaryPlainBlockBuilder : public BlockBuilder {
   // key should be a Slice *
   Status GetFirstKey(void *key) const OVERRIDE;
 
+  // Return the approximate size of the block if it were finished now.
+  size_t EstimateEncodedSize() const {
+    return size_estimate_;
+  }
+
   // Length of a header.
   static const size_t kMaxHeaderSize = sizeof(uint32_t) * 3;
 
@@ -0,0 +1,94 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Instruction set independent parts of the bit unpackers.
+//
+// This is included by each of the translation units which implement
+// unpackers for a given instruction set. Each of them defines a 'Traits'
+// class with the following member:
+//
+//   // Unpacks the group of eight 'kWidth'-bit values which starts at
+//   // 'group' (and so spans exactly 'kWidth' bytes) into 'out'.
+//   template <int kWidth>
+//   static void UnpackGroup(const uint8_t* group, uint64_t* out);
+//
+// Since the instantiations of the templates below depend on the Traits type,
+// the code generated for one instruction set is never shared with another.
+
+#pragma once
+
+#include <string.h>
+
+#include "kudu/cfile/bitpacking.h"
+
+namespace kudu {
+namespace cfile {
+namespace bitpacking {
+namespace internal {
+
+// Returns value 'j' (0 <= j < 8) of a group of eight 'kWidth'-bit values.
+template <typename Traits, int kWidth>
+inline uint64_t UnpackValue(const uint8_t* group, int j) {
+  const uint64_t mask = kWidth == 64 ? ~0ULL : (1ULL << (kWidth % 64)) - 1;
+  const int bit = j * kWidth;
+  const int shift = bit % 8;
+  uint64_t word;
+  memcpy(&word, group + bit / 8, sizeof(word));
+  uint64_t value = word >> shift;
+  if (kWidth + shift > 64) {
+    // The value spills into a ninth byte.
+    value |= static_cast<uint64_t>(group[bit / 8 + 8]) << (64 - shift);
+  }
+  return value & mask;
+}
+
+template <typename Traits, int kWidth>
+void Unpack(const uint8_t* in, uint64_t* out) {
+  for (int i = 0; i < kBatchSize; i += 8) {
+    Traits::template UnpackGroup<kWidth>(in, out + i);
+    in += kWidth;
+  }
+}
+
+struct UnpackerArray {
+  Unpacker unpackers[kMaxBitWidth + 1];
+};
+
+template <typename Traits, int kWidth>
+struct FillUnpackers {
+  static void Fill(UnpackerArray* array) {
+    array->unpackers[kWidth] = &Unpack<Traits, kWidth>;
+    FillUnpackers<Traits, kWidth - 1>::Fill(array);
+  }
+};
+
+template <typename Traits>
+struct FillUnpackers<Traits, -1> {
+  static void Fill(UnpackerArray* array) {}
+};
+
+template <typename Traits>
+UnpackerArray MakeUnpackers() {
+  UnpackerArray array;
+  FillUnpackers<Traits, kMaxBitWidth>::Fill(&array);
+  return array;
+}
+
+} // namespace internal
+} // namespace bitpacking
+} // namespace cfile
+} // namespace kudu
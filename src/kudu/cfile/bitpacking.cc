@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/bitpacking.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+#include "kudu/cfile/bitpacking-inl.h"
+#include "kudu/gutil/cpu.h"
+
+namespace kudu {
+namespace cfile {
+namespace bitpacking {
+
+namespace internal {
+namespace {
+
+struct ScalarTraits {
+  template <int kWidth>
+  static void UnpackGroup(const uint8_t* group, uint64_t* out) {
+    for (int j = 0; j < 8; j++) {
+      out[j] = UnpackValue<ScalarTraits, kWidth>(group, j);
+    }
+  }
+};
+
+} // anonymous namespace
+
+Unpacker GetScalarUnpacker(int bit_width) {
+  static const UnpackerArray unpackers = MakeUnpackers<ScalarTraits>();
+  return unpackers.unpackers[bit_width];
+}
+
+} // namespace internal
+
+namespace {
+
+bool CpuHasAvx2() {
+  static const bool has_avx2 = base::CPU().has_avx2();
+  return has_avx2;
+}
+
+} // anonymous namespace
+
+void PackBatch(const uint64_t* in, int bit_width, uint8_t* out) {
+  DCHECK_GE(bit_width, 0);
+  DCHECK_LE(bit_width, kMaxBitWidth);
+  memset(out, 0, PackedBatchSize(bit_width));
+  int bit = 0;
+  for (int i = 0; i < kBatchSize; i++) {
+    uint64_t value = bit_width == 64 ? in[i] : in[i] & ((1ULL << bit_width) - 1);
+    int remaining = bit_width;
+    while (remaining > 0) {
+      int shift = bit % 8;
+      int nbits = std::min(8 - shift, remaining);
+      out[bit / 8] |= static_cast<uint8_t>(value << shift);
+      value >>= nbits;
+      bit += nbits;
+      remaining -= nbits;
+    }
+  }
+}
+
+Unpacker GetUnpacker(int bit_width) {
+  DCHECK_GE(bit_width, 0);
+  DCHECK_LE(bit_width, kMaxBitWidth);
+  if (CpuHasAvx2()) {
+    return internal::GetAvx2Unpacker(bit_width);
+  }
+  return internal::GetScalarUnpacker(bit_width);
+}
+
+} // namespace bitpacking
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,71 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Note: this header is included by translation units compiled with extra
+// instruction set flags (see bitpacking_avx2.cc), so it must not pull in
+// anything with inline functions of its own.
+
+namespace kudu {
+namespace cfile {
+namespace bitpacking {
+
+// The number of values which are packed and unpacked together.
+const int kBatchSize = 128;
+
+// The maximum bit width of a packed value.
+const int kMaxBitWidth = 64;
+
+// Returns the number of bytes taken by a batch of 'bit_width'-bit values.
+inline size_t PackedBatchSize(int bit_width) {
+  return bit_width * kBatchSize / 8;
+}
+
+// The unpackers may load up to this many bytes past the end of the last
+// packed batch, so buffers of packed data must be padded accordingly.
+const int kUnpackPadding = 8;
+
+// Packs the low 'bit_width' bits of each of the 'kBatchSize' values in 'in'
+// into 'out', which must have room for PackedBatchSize(bit_width) bytes.
+// Values are packed little-endian, the first value in the lowest bits.
+void PackBatch(const uint64_t* in, int bit_width, uint8_t* out);
+
+// Unpacks a batch of 'kBatchSize' values of a fixed bit width from 'in'
+// into 'out'.
+typedef void (*Unpacker)(const uint8_t* in, uint64_t* out);
+
+// Returns the fastest unpacker supported by the CPU for values of the given
+// bit width, which must be between 0 and kMaxBitWidth.
+Unpacker GetUnpacker(int bit_width);
+
+namespace internal {
+
+// Unpackers using scalar code only.
+Unpacker GetScalarUnpacker(int bit_width);
+
+// Unpackers compiled for AVX2. These must only be used if the CPU supports
+// AVX2.
+Unpacker GetAvx2Unpacker(int bit_width);
+
+} // namespace internal
+} // namespace bitpacking
+} // namespace cfile
+} // namespace kudu
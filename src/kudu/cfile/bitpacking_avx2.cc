@@ -0,0 +1,78 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// AVX2 versions of the bit unpackers.
+//
+// This file is compiled with -mavx2, so any inline function it instantiates
+// may contain AVX2 instructions. If such a function were also used by other
+// translation units, the linker could pick this copy and crash CPUs without
+// AVX2. To avoid that, only the intrinsics and the templates in
+// bitpacking-inl.h (instantiated with types local to this file) may be used
+// here.
+
+#include <immintrin.h>
+
+#include "kudu/cfile/bitpacking-inl.h"
+
+namespace kudu {
+namespace cfile {
+namespace bitpacking {
+namespace internal {
+namespace {
+
+struct Avx2Traits {
+  // Each value is gathered with a single unaligned 64-bit load and then
+  // shifted into place, four values per vector. That works as long as no
+  // value spans more than eight bytes; wider values are unpacked one by one.
+  template <int kWidth>
+  static void UnpackGroup(const uint8_t* group, uint64_t* out) {
+    if (kWidth + 7 > 64) {
+      for (int j = 0; j < 8; j++) {
+        out[j] = UnpackValue<Avx2Traits, kWidth>(group, j);
+      }
+      return;
+    }
+    const long long* base = reinterpret_cast<const long long*>(group);
+    const __m256i mask = _mm256_set1_epi64x(
+        static_cast<long long>(kWidth == 64 ? ~0ULL : (1ULL << (kWidth % 64)) - 1));
+    for (int j = 0; j < 8; j += 4) {
+      const __m256i offsets = _mm256_setr_epi64x((j * kWidth) / 8,
+                                                 ((j + 1) * kWidth) / 8,
+                                                 ((j + 2) * kWidth) / 8,
+                                                 ((j + 3) * kWidth) / 8);
+      const __m256i shifts = _mm256_setr_epi64x((j * kWidth) % 8,
+                                                ((j + 1) * kWidth) % 8,
+                                                ((j + 2) * kWidth) % 8,
+                                                ((j + 3) * kWidth) % 8);
+      __m256i values = _mm256_i64gather_epi64(base, offsets, 1);
+      values = _mm256_and_si256(_mm256_srlv_epi64(values, shifts), mask);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), values);
+    }
+  }
+};
+
+} // anonymous namespace
+
+Unpacker GetAvx2Unpacker(int bit_width) {
+  static const UnpackerArray unpackers = MakeUnpackers<Avx2Traits>();
+  return unpackers.unpackers[bit_width];
+}
+
+} // namespace internal
+} // namespace bitpacking
+} // namespace cfile
+} // namespace kudu
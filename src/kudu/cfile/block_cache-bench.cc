@@ -0,0 +1,216 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Benchmarks of cfile scans through the block cache, comparing reads of the
+// data blocks through the page cache with direct reads which bypass it.
+
+#include <fcntl.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "kudu/cfile/cfile-test-base.h"
+#include "kudu/cfile/cfile_reader.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/gutil/bind.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/errno.h"
+#include "kudu/util/path_util.h"
+#include "kudu/util/stopwatch.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_bool(block_manager_direct_io_reads);
+
+DEFINE_int32(block_cache_bench_num_rows, 0,
+             "Number of rows in the cfile which is scanned. "
+             "If 0, picks a number based on whether slow tests are allowed.");
+DEFINE_int32(block_cache_bench_num_scans, 3,
+             "Number of times to scan the cfile once its blocks are cached.");
+
+using std::string;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+namespace cfile {
+
+using fs::ReadableBlock;
+
+class BlockCacheBench : public CFileTestBase {
+ protected:
+  // Reopens the filesystem, so that the block manager opens its data files
+  // with or without direct I/O.
+  void ReopenFs(bool direct_io) {
+    FLAGS_block_manager_direct_io_reads = direct_io;
+    fs_manager_.reset(new FsManager(env_.get(),
+                                    GetTestPath(Substitute("fs_root_$0", direct_io))));
+    ASSERT_OK(fs_manager_->CreateInitialFileSystemLayout());
+    ASSERT_OK(fs_manager_->Open());
+  }
+
+  // Writes back the data files of the filesystem and drops them from the
+  // page cache, so that the next reads of their blocks go to disk.
+  Status DropDataFilesFromPageCache() {
+    return env_->Walk(fs_manager_->GetDataRootDirs().at(0), Env::PRE_ORDER,
+                      Bind(&BlockCacheBench::DropFileFromPageCacheCb, Unretained(this)));
+  }
+
+  // Returns the number of bytes of the data files of the filesystem which
+  // are in the page cache.
+  Status GetPageCacheResidentBytes(int64_t* bytes) {
+    *bytes = 0;
+    return env_->Walk(fs_manager_->GetDataRootDirs().at(0), Env::PRE_ORDER,
+                      Bind(&BlockCacheBench::CountPageCacheResidentBytesCb,
+                           Unretained(this), bytes));
+  }
+
+  // Scans all the rows of 'reader', caching its data blocks.
+  void Scan(CFileReader* reader, int num_rows) {
+    gscoped_ptr<CFileIterator> iter;
+    ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK));
+    ASSERT_OK(iter->SeekToOrdinal(0));
+    ScopedColumnBlock<UINT32> out(8192);
+    int64_t count = 0;
+    while (iter->HasNext()) {
+      size_t n = out.nrows();
+      ASSERT_OK_FAST(iter->CopyNextValues(&n, &out));
+      count += n;
+    }
+    ASSERT_EQ(num_rows, count);
+  }
+
+ private:
+  Status DropFileFromPageCacheCb(Env::FileType type, const string& dirname,
+                                 const string& basename) {
+    if (type != Env::FILE_TYPE) {
+      return Status::OK();
+    }
+    const string path = JoinPathSegments(dirname, basename);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return Status::IOError(path, ErrnoToString(errno), errno);
+    }
+    // Dirty pages are not dropped, so write them back first.
+    int err = fsync(fd) == 0 ? 0 : errno;
+#if defined(__linux__)
+    if (err == 0) {
+      err = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+#endif
+    close(fd);
+    if (err != 0) {
+      return Status::IOError(path, ErrnoToString(err), err);
+    }
+    return Status::OK();
+  }
+
+  Status CountPageCacheResidentBytesCb(int64_t* bytes, Env::FileType type,
+                                       const string& dirname, const string& basename) {
+    if (type != Env::FILE_TYPE) {
+      return Status::OK();
+    }
+    const string path = JoinPathSegments(dirname, basename);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return Status::IOError(path, ErrnoToString(errno), errno);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      return Status::OK();
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+      return Status::IOError(path, ErrnoToString(errno), errno);
+    }
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    vector<unsigned char> resident((st.st_size + page_size - 1) / page_size);
+    int err = mincore(addr, st.st_size, resident.data()) == 0 ? 0 : errno;
+    munmap(addr, st.st_size);
+    if (err != 0) {
+      return Status::IOError(path, ErrnoToString(err), err);
+    }
+    for (unsigned char r : resident) {
+      if (r & 1) {
+        *bytes += page_size;
+      }
+    }
+    return Status::OK();
+  }
+};
+
+// Scan a cfile whose blocks are not cached yet, which reads them from disk,
+// and then scan it again from the block cache, with and without direct I/O.
+// The cfile is dropped from the page cache before the first scan. With
+// buffered reads, the blocks stay in the page cache as well as in the block
+// cache after it.
+TEST_F(BlockCacheBench, ScanThroughput) {
+  const int kNumRows = FLAGS_block_cache_bench_num_rows > 0 ?
+      FLAGS_block_cache_bench_num_rows : (AllowSlowTests() ? 32 * 1024 * 1024 : 1024 * 1024);
+  const double kMegabytes = static_cast<double>(kNumRows) * sizeof(uint32_t) / (1024 * 1024);
+
+  for (bool direct_io : { false, true }) {
+    NO_FATALS(ReopenFs(direct_io));
+    UInt32DataGenerator<false> generator;
+    BlockId block_id;
+    NO_FATALS(WriteTestFile(&generator, PLAIN_ENCODING, NO_COMPRESSION, kNumRows,
+                            NO_FLAGS, &block_id));
+    gscoped_ptr<ReadableBlock> block;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+    gscoped_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+
+    ASSERT_OK(DropDataFilesFromPageCache());
+    int64_t resident_bytes;
+    ASSERT_OK(GetPageCacheResidentBytes(&resident_bytes));
+    LOG(INFO) << Substitute("$0 reads: $1 MB of the data files in the page cache before "
+                            "the first scan", direct_io ? "Direct" : "Buffered",
+                            static_cast<double>(resident_bytes) / (1024 * 1024));
+
+    Stopwatch sw;
+    sw.start();
+    NO_FATALS(Scan(reader.get(), kNumRows));
+    sw.stop();
+    LOG(INFO) << Substitute("$0 reads: scanned $1 MB from disk at $2 MB/s",
+                            direct_io ? "Direct" : "Buffered", kMegabytes,
+                            kMegabytes / sw.elapsed().wall_seconds());
+
+    Stopwatch cached_sw;
+    cached_sw.start();
+    for (int i = 0; i < FLAGS_block_cache_bench_num_scans; i++) {
+      NO_FATALS(Scan(reader.get(), kNumRows));
+    }
+    cached_sw.stop();
+    ASSERT_OK(GetPageCacheResidentBytes(&resident_bytes));
+    LOG(INFO) << Substitute("$0 reads: scanned $1 MB from the block cache at $2 MB/s",
+                            direct_io ? "Direct" : "Buffered", kMegabytes,
+                            kMegabytes * FLAGS_block_cache_bench_num_scans /
+                            cached_sw.elapsed().wall_seconds());
+    LOG(INFO) << Substitute("$0 reads: $1 MB of the data files in the page cache after "
+                            "the scans", direct_io ? "Direct" : "Buffered",
+                            static_cast<double>(resident_bytes) / (1024 * 1024));
+  }
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -15,11 +15,26 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
 #include "kudu/cfile/block_cache.h"
 #include "kudu/util/cache.h"
+#include "kudu/util/metrics.h"
+#include "kudu/util/random.h"
 #include "kudu/util/slice.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_string(block_cache_eviction_policy);
+DECLARE_int64(block_cache_compressed_capacity_mb);
+DECLARE_int64(block_cache_high_priority_capacity_mb);
+
+METRIC_DECLARE_counter(block_cache_compressed_tier_inserts);
+METRIC_DECLARE_counter(block_cache_compressed_tier_hits);
+METRIC_DECLARE_counter(block_cache_compressed_tier_misses);
+METRIC_DECLARE_gauge_uint64(block_cache_compressed_tier_usage);
+
+using std::string;
 
 namespace kudu {
 namespace cfile {
@@ -55,6 +70,138 @@ TEST(TestBlockCache, TestBasics) {
   // return this data.
   ASSERT_FALSE(cache.Lookup(id, 3, Cache::EXPECT_IN_CACHE, &retrieved_handle));
 
+  // The cache reports the blocks it holds.
+  std::vector<BlockCache::BlockInfo> blocks;
+  cache.GetCachedBlocks(&blocks);
+  ASSERT_EQ(1, blocks.size());
+  ASSERT_EQ(id, blocks[0].file_id);
+  ASSERT_EQ(1, blocks[0].offset);
+  ASSERT_EQ(data_size, blocks[0].size_on_disk);
+  ASSERT_EQ(Cache::NORMAL_PRIORITY, blocks[0].priority);
+}
+
+// Looks up the block at 'offset' of file 'id' in 'cache', inserting it on a
+// miss like a cfile reader does. Returns true on a hit.
+static bool LookupOrInsert(BlockCache* cache, BlockCache::FileId id, uint64_t offset,
+                           size_t block_size, Cache::Priority priority) {
+  BlockCacheHandle handle;
+  if (cache->Lookup(id, offset, Cache::EXPECT_IN_CACHE, priority, &handle)) {
+    return true;
+  }
+  uint8_t* data = cache->Allocate(block_size);
+  CHECK(cache->Insert(id, offset, Slice(data, block_size), block_size, priority, &handle));
+  return false;
+}
+
+// Replays a trace of point lookups, which repeatedly read the blocks of a
+// small set of index and bloom filter blocks, inserted with the given
+// priority, mixed with a scan of a file larger than the cache, and returns
+// the hit rate of the point lookups.
+static double PointLookupHitRateDuringScan(Cache::Priority hot_priority) {
+  const size_t kBlockSize = 1024;
+  const int kCacheBlocks = 1024;
+  const int kHotBlocks = 400;
+  const int kScanBlocks = 50 * kCacheBlocks;
+  const int kScanBlocksPerLookup = 4;
+
+  BlockCache cache(kCacheBlocks * kBlockSize);
+  BlockCache::FileId hot_file(1);
+  BlockCache::FileId scanned_file(2);
+  Random rng(1);
+
+  // Warm the cache up with the hot blocks.
+  for (int i = 0; i < 4 * kHotBlocks; i++) {
+    LookupOrInsert(&cache, hot_file, rng.Uniform(kHotBlocks), kBlockSize, hot_priority);
+  }
+
+  int hits = 0;
+  int lookups = 0;
+  for (int i = 0; i < kScanBlocks; i++) {
+    LookupOrInsert(&cache, scanned_file, i, kBlockSize, Cache::NORMAL_PRIORITY);
+    if (i % kScanBlocksPerLookup == 0) {
+      hits += LookupOrInsert(&cache, hot_file, rng.Uniform(kHotBlocks), kBlockSize,
+                             hot_priority);
+      lookups++;
+    }
+  }
+  return static_cast<double>(hits) / lookups;
+}
+
+// Test that a scan does not flush the blocks used by point lookups from a
+// block cache with the SLRU eviction policy, unlike with the LRU policy.
+TEST(TestBlockCache, TestScanResistance) {
+  google::FlagSaver saver;
+  FLAGS_block_cache_eviction_policy = "LRU";
+  double lru_hit_rate = PointLookupHitRateDuringScan(Cache::NORMAL_PRIORITY);
+  FLAGS_block_cache_eviction_policy = "SLRU";
+  double slru_hit_rate = PointLookupHitRateDuringScan(Cache::NORMAL_PRIORITY);
+  LOG(INFO) << "Point lookup hit rate during a scan: " << lru_hit_rate << " with LRU, "
+            << slru_hit_rate << " with SLRU";
+
+  ASSERT_GT(slru_hit_rate, 0.9);
+  ASSERT_GT(slru_hit_rate, lru_hit_rate + 0.2);
+}
+
+// Test that high priority blocks stay cached during a scan of normal priority
+// blocks, as long as they fit in the capacity reserved for them.
+TEST(TestBlockCache, TestHighPriorityBlocks) {
+  google::FlagSaver saver;
+  FLAGS_block_cache_eviction_policy = "LRU";
+  FLAGS_block_cache_high_priority_capacity_mb = 0;
+  double normal_priority_hit_rate = PointLookupHitRateDuringScan(Cache::HIGH_PRIORITY);
+  FLAGS_block_cache_high_priority_capacity_mb = 1;
+  double high_priority_hit_rate = PointLookupHitRateDuringScan(Cache::HIGH_PRIORITY);
+  LOG(INFO) << "Point lookup hit rate during a scan: " << normal_priority_hit_rate
+            << " without reserved capacity, " << high_priority_hit_rate << " with it";
+
+  ASSERT_GT(high_priority_hit_rate, 0.99);
+  ASSERT_GT(high_priority_hit_rate, normal_priority_hit_rate + 0.2);
+}
+
+// Test that the compressed tier keeps copies of the compressed data inserted
+// into it, up to its capacity, and records its metrics.
+TEST(TestBlockCache, TestCompressedTier) {
+  google::FlagSaver saver;
+  FLAGS_block_cache_eviction_policy = "LRU";
+  FLAGS_block_cache_compressed_capacity_mb = 0;
+  ASSERT_FALSE(BlockCache(1024 * 1024).has_compressed_tier());
+
+  const size_t kBlockSize = 4096;
+  const int kNumBlocks = 1024;
+  FLAGS_block_cache_compressed_capacity_mb = 1;
+  BlockCache cache(1024 * 1024);
+  ASSERT_TRUE(cache.has_compressed_tier());
+  MetricRegistry registry;
+  scoped_refptr<MetricEntity> entity = METRIC_ENTITY_server.Instantiate(&registry, "test");
+  cache.StartInstrumentation(entity);
+  BlockCache::FileId id(1234);
+
+  // The compressed tier only fits a quarter of the blocks.
+  for (int i = 0; i < kNumBlocks; i++) {
+    string data(kBlockSize, static_cast<char>(i));
+    cache.InsertCompressed(id, i, data);
+  }
+  int hits = 0;
+  for (int i = 0; i < kNumBlocks; i++) {
+    BlockCacheHandle handle;
+    if (cache.LookupCompressed(id, i, &handle)) {
+      ASSERT_EQ(string(kBlockSize, static_cast<char>(i)), handle.data().ToString());
+      hits++;
+    }
+  }
+  ASSERT_GT(hits, 0);
+  ASSERT_LE(hits, kNumBlocks / 4);
+  // The most recently inserted block was not evicted.
+  BlockCacheHandle handle;
+  ASSERT_TRUE(cache.LookupCompressed(id, kNumBlocks - 1, &handle));
+
+  ASSERT_EQ(kNumBlocks,
+            METRIC_block_cache_compressed_tier_inserts.Instantiate(entity)->value());
+  ASSERT_EQ(hits + 1, METRIC_block_cache_compressed_tier_hits.Instantiate(entity)->value());
+  ASSERT_EQ(kNumBlocks - hits,
+            METRIC_block_cache_compressed_tier_misses.Instantiate(entity)->value());
+  ASSERT_EQ(hits * kBlockSize,
+            METRIC_block_cache_compressed_tier_usage.Instantiate(entity, 0)->value());
 }
 
 
@@ -15,11 +15,13 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <algorithm>
 #include <gflags/gflags.h>
 
 #include "kudu/cfile/block_cache.h"
 #include "kudu/gutil/port.h"
 #include "kudu/util/cache.h"
+#include "kudu/util/cache_metrics.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/metrics.h"
 #include "kudu/util/slice.h"
@@ -35,6 +37,36 @@ DEFINE_string(block_cache_type, "DRAM",
               "in a memory-mapped file using the NVML library.");
 TAG_FLAG(block_cache_type, experimental);
 
+DEFINE_string(block_cache_eviction_policy, "LRU",
+              "Which eviction policy the block cache uses. Valid choices are "
+              "'LRU', 'SLRU' or 'CLOCK'. LRU, the default, evicts the least recently used "
+              "blocks. SLRU evicts the blocks which were only used once, e.g. by "
+              "a large scan, before the blocks which were used repeatedly, such "
+              "as index and bloom filter blocks, and does not admit new blocks "
+              "into a full cache unless they were used at least as frequently "
+              "as the blocks they would evict. CLOCK approximates LRU, and looks "
+              "up blocks without taking any lock, which scales better with the "
+              "number of concurrent readers. It does not support high priority "
+              "blocks. SLRU and CLOCK are only supported by the DRAM block cache.");
+TAG_FLAG(block_cache_eviction_policy, experimental);
+
+DEFINE_int64(block_cache_high_priority_capacity_mb, 0,
+             "Capacity of the block cache in MB reserved for high priority blocks: "
+             "cfile index and bloom filter blocks. Up to this capacity, these blocks "
+             "are only evicted once no data blocks are left in the cache. Must not "
+             "exceed --block_cache_capacity_mb. Not supported by the NVM block cache.");
+TAG_FLAG(block_cache_high_priority_capacity_mb, experimental);
+
+DEFINE_int64(block_cache_compressed_capacity_mb, 0,
+             "Capacity in MB of the compressed tier of the block cache, which keeps "
+             "the compressed data of the blocks of compressed cfiles, so that blocks "
+             "evicted from the block cache are decompressed from memory rather than "
+             "read from disk. This memory is in addition to --block_cache_capacity_mb, "
+             "and always in DRAM. If 0, the block cache has no compressed tier.");
+TAG_FLAG(block_cache_compressed_capacity_mb, experimental);
+
+using std::vector;
+
 namespace kudu {
 
 class MetricEntity;
@@ -61,19 +93,27 @@ class Deleter : public CacheDeleter {
   explicit Deleter(Cache* cache) : cache_(cache) {
   }
   virtual void Delete(const Slice& slice, void* value) OVERRIDE {
-    Slice *value_slice = reinterpret_cast<Slice *>(value);
+    CachedBlock *block = reinterpret_cast<CachedBlock *>(value);
 
     // The actual data was allocated from the cache's memory
     // (i.e. it may be in nvm)
-    cache_->Free(value_slice->mutable_data());
-    delete value_slice;
+    cache_->Free(block->data.mutable_data());
+    delete block;
   }
  private:
   Cache* cache_;
   DISALLOW_COPY_AND_ASSIGN(Deleter);
 };
 
+// The size of a cached block which the hash table of the CLOCK cache is sized
+// for. Index and bloom filter blocks are much smaller than data blocks, so
+// this errs on the small side: an oversized table only costs a few bytes per
+// slot, whereas an undersized one stops admitting blocks.
+const size_t kEstimatedBlockSize = 8 * 1024;
+
 Cache* CreateCache(int64_t capacity) {
+  const int64_t high_priority_capacity = std::min<int64_t>(
+      FLAGS_block_cache_high_priority_capacity_mb * 1024 * 1024, capacity);
   CacheType t;
   ToUpperCase(FLAGS_block_cache_type, &FLAGS_block_cache_type);
   if (FLAGS_block_cache_type == "NVM") {
@@ -84,19 +124,72 @@ Cache* CreateCache(int64_t capacity) {
     LOG(FATAL) << "Unknown block cache type: '" << FLAGS_block_cache_type
                << "' (expected 'DRAM' or 'NVM')";
   }
-  return NewLRUCache(t, capacity, "block_cache");
+
+  ToUpperCase(FLAGS_block_cache_eviction_policy, &FLAGS_block_cache_eviction_policy);
+  if (FLAGS_block_cache_eviction_policy == "SLRU") {
+    if (t != DRAM_CACHE) {
+      LOG(FATAL) << "The SLRU block cache eviction policy is only supported by "
+                 << "the DRAM block cache";
+    }
+    return NewScanResistantCache(capacity, "block_cache", high_priority_capacity);
+  }
+  if (FLAGS_block_cache_eviction_policy == "CLOCK") {
+    if (t != DRAM_CACHE) {
+      LOG(FATAL) << "The CLOCK block cache eviction policy is only supported by "
+                 << "the DRAM block cache";
+    }
+    return NewClockCache(capacity, "block_cache", kEstimatedBlockSize);
+  }
+  if (FLAGS_block_cache_eviction_policy != "LRU") {
+    LOG(FATAL) << "Unknown block cache eviction policy: '"
+               << FLAGS_block_cache_eviction_policy << "' (expected 'LRU', 'SLRU' or 'CLOCK')";
+  }
+  return NewLRUCache(t, capacity, "block_cache", high_priority_capacity);
 }
 
 } // anonymous namespace
 
+// Deleter of the entries of the compressed tier, whose data is on the heap.
+class BlockCache::CompressedDeleter : public CacheDeleter {
+ public:
+  explicit CompressedDeleter(BlockCache* block_cache) : block_cache_(block_cache) {
+  }
+  virtual void Delete(const Slice& slice, void* value) OVERRIDE {
+    CachedBlock *block = reinterpret_cast<CachedBlock *>(value);
+    if (block_cache_->metrics_) {
+      block_cache_->metrics_->compressed_tier_usage->DecrementBy(block->data.size());
+    }
+    delete[] block->data.mutable_data();
+    delete block;
+  }
+ private:
+  BlockCache* block_cache_;
+  DISALLOW_COPY_AND_ASSIGN(CompressedDeleter);
+};
+
 BlockCache::BlockCache()
   : cache_(CreateCache(FLAGS_block_cache_capacity_mb * 1024 * 1024)) {
   deleter_.reset(new Deleter(cache_.get()));
+  CreateCompressedTier();
 }
 
 BlockCache::BlockCache(size_t capacity)
   : cache_(CreateCache(capacity)) {
   deleter_.reset(new Deleter(cache_.get()));
+  CreateCompressedTier();
+}
+
+BlockCache::~BlockCache() {
+}
+
+void BlockCache::CreateCompressedTier() {
+  if (FLAGS_block_cache_compressed_capacity_mb <= 0) {
+    return;
+  }
+  compressed_deleter_.reset(new CompressedDeleter(this));
+  compressed_cache_.reset(NewLRUCache(DRAM_CACHE,
+                                      FLAGS_block_cache_compressed_capacity_mb * 1024 * 1024,
+                                      "compressed_block_cache"));
 }
 
 uint8_t* BlockCache::Allocate(size_t size) {
@@ -112,9 +205,9 @@ uint8_t* BlockCache::MoveToHeap(uint8_t* p, size_t size) {
 }
 
 bool BlockCache::Lookup(FileId file_id, uint64_t offset, Cache::CacheBehavior behavior,
-                        BlockCacheHandle *handle) {
+                        Cache::Priority priority, BlockCacheHandle *handle) {
   CacheKey key(file_id, offset);
-  Cache::Handle *h = cache_->Lookup(key.slice(), behavior);
+  Cache::Handle *h = cache_->Lookup(key.slice(), behavior, priority);
   if (h != nullptr) {
     handle->SetHandle(cache_.get(), h);
   }
@@ -122,13 +215,17 @@ bool BlockCache::Lookup(FileId file_id, uint64_t offset, Cache::CacheBehavior be
 }
 
 bool BlockCache::Insert(FileId file_id, uint64_t offset, const Slice &block_data,
+                        uint32_t size_on_disk, Cache::Priority priority,
                         BlockCacheHandle *inserted) {
   CacheKey key(file_id, offset);
-  // Allocate a copy of the value Slice (not the referred-to-data!)
+  // Allocate a CachedBlock referring to the data (not a copy of the data!)
   // for insertion in the cache.
-  gscoped_ptr<Slice> value(new Slice(block_data));
-  Cache::Handle *h = cache_->Insert(key.slice(), value.get(), value->size(),
-                                    deleter_.get());
+  gscoped_ptr<CachedBlock> value(new CachedBlock());
+  value->data = block_data;
+  value->size_on_disk = size_on_disk;
+  value->priority = priority;
+  Cache::Handle *h = cache_->Insert(key.slice(), value.get(), block_data.size(),
+                                    deleter_.get(), priority);
   if (h != nullptr) {
     inserted->SetHandle(cache_.get(), h);
     ignore_result(value.release());
@@ -136,8 +233,60 @@ bool BlockCache::Insert(FileId file_id, uint64_t offset, const Slice &block_data
   return h != nullptr;
 }
 
+bool BlockCache::LookupCompressed(FileId file_id, uint64_t offset,
+                                  BlockCacheHandle *handle) {
+  DCHECK(has_compressed_tier());
+  CacheKey key(file_id, offset);
+  Cache::Handle *h = compressed_cache_->Lookup(key.slice(), Cache::EXPECT_IN_CACHE);
+  if (metrics_) {
+    (h != nullptr ? metrics_->compressed_tier_hits : metrics_->compressed_tier_misses)
+        ->Increment();
+  }
+  if (h != nullptr) {
+    handle->SetHandle(compressed_cache_.get(), h);
+  }
+  return h != nullptr;
+}
+
+void BlockCache::InsertCompressed(FileId file_id, uint64_t offset,
+                                  const Slice &compressed_data) {
+  DCHECK(has_compressed_tier());
+  CacheKey key(file_id, offset);
+  uint8_t* data = new uint8_t[compressed_data.size()];
+  memcpy(data, compressed_data.data(), compressed_data.size());
+  // The usage is accounted for before the insert, since the entry may be
+  // evicted, and its deleter called, by the time Insert() returns.
+  if (metrics_) {
+    metrics_->compressed_tier_inserts->Increment();
+    metrics_->compressed_tier_usage->IncrementBy(compressed_data.size());
+  }
+  CachedBlock* value = new CachedBlock();
+  value->data = Slice(data, compressed_data.size());
+  value->size_on_disk = compressed_data.size();
+  value->priority = Cache::NORMAL_PRIORITY;
+  Cache::Handle *h = compressed_cache_->Insert(key.slice(), value, compressed_data.size(),
+                                               compressed_deleter_.get());
+  // DRAM caches always return a handle, which owns the entry.
+  DCHECK(h != nullptr);
+  compressed_cache_->Release(h);
+}
+
+void BlockCache::GetCachedBlocks(vector<BlockInfo>* blocks) {
+  cache_->VisitEntries([&](const Slice& key, void* value) {
+      DCHECK_EQ(sizeof(CacheKey), key.size());
+      CacheKey cache_key(FileId(), 0);
+      memcpy(&cache_key, key.data(), sizeof(cache_key));
+      const CachedBlock* block = reinterpret_cast<const CachedBlock*>(value);
+      blocks->push_back({ FileId(cache_key.file_id_), cache_key.offset_,
+                          block->size_on_disk, block->priority });
+    });
+}
+
 void BlockCache::StartInstrumentation(const scoped_refptr<MetricEntity>& metric_entity) {
   cache_->SetMetrics(metric_entity);
+  if (has_compressed_tier()) {
+    metrics_.reset(new CacheMetrics(metric_entity));
+  }
 }
 
 } // namespace cfile
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <glog/logging.h>
+#include <vector>
 
 #include "kudu/fs/block_id.h"
 #include "kudu/gutil/gscoped_ptr.h"
@@ -31,13 +32,33 @@ DECLARE_string(block_cache_type);
 namespace kudu {
 
 class MetricRegistry;
+struct CacheMetrics;
 
 namespace cfile {
 
 class BlockCacheHandle;
 
+// The value of the entries of the block cache.
+struct CachedBlock {
+  // The data of the block. It is decompressed, except in the compressed tier.
+  Slice data;
+
+  // The size of the block in its file, which is needed to read it again.
+  uint32_t size_on_disk;
+
+  // The priority the block was inserted with.
+  Cache::Priority priority;
+};
+
 // Wrapper around kudu::Cache specifically for caching blocks of CFiles.
 // Provides a singleton and LRU cache for CFile blocks.
+//
+// Optionally, the block cache has a second, compressed tier, which keeps the
+// compressed data of the blocks of compressed CFiles, in a separate DRAM
+// cache of --block_cache_compressed_capacity_mb. Since compressed blocks are
+// several times smaller, the compressed tier holds the data of many more
+// blocks than the same memory would otherwise, so that blocks evicted from
+// the block cache can be decompressed from memory rather than read from disk.
 class BlockCache {
  public:
   // BlockId refers to the unique identifier for a Kudu block, that is, for an
@@ -51,26 +72,79 @@ class BlockCache {
 
   explicit BlockCache(size_t capacity);
 
+  ~BlockCache();
+
   // Lookup the given block in the cache.
   //
   // If the entry is found, then sets *handle to refer to the entry.
   // This object's destructor will release the cache entry so it may be freed again.
   // Alternatively,  handle->Release() may be used to explicitly release it.
   //
+  // 'priority' is the priority the block would be inserted with, and is only
+  // used for the miss metrics: hits count towards the priority of the block.
+  //
   // Returns true to indicate that the entry was found, false otherwise.
-  bool Lookup(FileId file_id, uint64_t offset,
-              Cache::CacheBehavior behavior, BlockCacheHandle *handle);
+  bool Lookup(FileId file_id, uint64_t offset, Cache::CacheBehavior behavior,
+              Cache::Priority priority, BlockCacheHandle *handle);
+
+  // Same as above, for a block of normal priority.
+  bool Lookup(FileId file_id, uint64_t offset, Cache::CacheBehavior behavior,
+              BlockCacheHandle *handle) {
+    return Lookup(file_id, offset, behavior, Cache::NORMAL_PRIORITY, handle);
+  }
 
   // Insert the given block into the cache.
   //
   // The data pointed to by Slice should have been allocated using Allocate().
   // After insertion, the block cache owns this pointer and will free it upon
-  // eviction.
+  // eviction. 'size_on_disk' is the size of the block in its file, which may
+  // differ from the size of the data if the block is compressed.
+  //
+  // Blocks which are costly to lose, such as index and bloom filter blocks,
+  // should be inserted with a high priority, so that they are only evicted
+  // once there are no normal priority blocks left, up to the capacity
+  // reserved for them with --block_cache_high_priority_capacity_mb.
   //
   // The inserted entry is returned in *inserted.
   bool Insert(FileId file_id, uint64_t offset, const Slice &block_data,
+              uint32_t size_on_disk, Cache::Priority priority,
               BlockCacheHandle *inserted);
 
+  // Same as above, for an uncompressed block of normal priority.
+  bool Insert(FileId file_id, uint64_t offset, const Slice &block_data,
+              BlockCacheHandle *inserted) {
+    return Insert(file_id, offset, block_data, block_data.size(), Cache::NORMAL_PRIORITY,
+                  inserted);
+  }
+
+  // A block which is in the cache, and what is needed to read it again.
+  struct BlockInfo {
+    FileId file_id;
+    uint64_t offset;
+    uint32_t size_on_disk;
+    Cache::Priority priority;
+  };
+
+  // Appends the blocks which are in the cache, not counting the compressed
+  // tier, to 'blocks'. Blocks which would be evicted last tend to come first.
+  void GetCachedBlocks(std::vector<BlockInfo>* blocks);
+
+  // Returns true if the block cache has a compressed tier.
+  bool has_compressed_tier() const {
+    return compressed_cache_ != nullptr;
+  }
+
+  // Lookup the compressed data of the given block in the compressed tier.
+  //
+  // Same as Lookup() otherwise. Must only be called if has_compressed_tier().
+  bool LookupCompressed(FileId file_id, uint64_t offset, BlockCacheHandle *handle);
+
+  // Insert a copy of 'compressed_data', the compressed data of the given block
+  // as read from disk, into the compressed tier.
+  //
+  // Must only be called if has_compressed_tier().
+  void InsertCompressed(FileId file_id, uint64_t offset, const Slice &compressed_data);
+
   // Pass a metric entity to the cache to start recording metrics.
   // This should be called before the block cache starts serving blocks.
   // Not calling StartInstrumentation will simply result in no block cache-related metrics.
@@ -100,10 +174,24 @@ class BlockCache {
 
   DISALLOW_COPY_AND_ASSIGN(BlockCache);
 
+  // Creates the compressed tier, if --block_cache_compressed_capacity_mb is
+  // set.
+  void CreateCompressedTier();
+
+  // Metrics of the compressed tier. NULL until StartInstrumentation() is
+  // called. Must be defined before compressed_cache_, whose deleter records
+  // them.
+  gscoped_ptr<CacheMetrics> metrics_;
+
   // Deleter must be defined before cache_ so that cache_ destructs first.
   // (the Cache needs to use the Deleter during destruction)
   gscoped_ptr<CacheDeleter> deleter_;
   gscoped_ptr<Cache> cache_;
+
+  // The compressed tier, if any.
+  class CompressedDeleter;
+  gscoped_ptr<CompressedDeleter> compressed_deleter_;
+  gscoped_ptr<Cache> compressed_cache_;
 };
 
 // Scoped reference to a block from the block cache.
@@ -137,8 +225,8 @@ class BlockCacheHandle {
   // NOTE: this slice is only valid until the block cache handle is
   // destructed or explicitly Released().
   const Slice &data() const {
-    const Slice *slice = reinterpret_cast<const Slice *>(cache_->Value(handle_));
-    return *slice;
+    const CachedBlock *block = reinterpret_cast<const CachedBlock *>(cache_->Value(handle_));
+    return block->data;
   }
 
   bool valid() const {
@@ -0,0 +1,120 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <gtest/gtest.h>
+
+#include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/block_cache_warmer.h"
+#include "kudu/cfile/cfile-test-base.h"
+#include "kudu/cfile/cfile_reader.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/util/pb_util.h"
+#include "kudu/util/test_util.h"
+
+using std::string;
+
+namespace kudu {
+namespace cfile {
+
+using fs::ReadableBlock;
+
+class BlockCacheWarmerTest : public CFileTestBase {
+ protected:
+  // Scans all the rows of the cfile 'block_id', caching its blocks.
+  void Scan(const BlockId& block_id, int num_rows) {
+    gscoped_ptr<ReadableBlock> block;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+    gscoped_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+    gscoped_ptr<CFileIterator> iter;
+    ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK));
+    ASSERT_OK(iter->SeekToOrdinal(0));
+    ScopedColumnBlock<UINT32> out(1024);
+    int64_t count = 0;
+    while (iter->HasNext()) {
+      size_t n = out.nrows();
+      ASSERT_OK_FAST(iter->CopyNextValues(&n, &out));
+      count += n;
+    }
+    ASSERT_EQ(num_rows, count);
+  }
+};
+
+// Persist the blocks cached by a scan, and warm the cache up with them.
+TEST_F(BlockCacheWarmerTest, TestWarmup) {
+  const int kNumRows = 10000;
+
+  // Write two identical cfiles, and cache the blocks of the first one.
+  UInt32DataGenerator<false> generator;
+  BlockId scanned_id;
+  NO_FATALS(WriteTestFile(&generator, PLAIN_ENCODING, NO_COMPRESSION, kNumRows,
+                          SMALL_BLOCKSIZE, &scanned_id));
+  generator.Reset();
+  BlockId warmed_id;
+  NO_FATALS(WriteTestFile(&generator, PLAIN_ENCODING, NO_COMPRESSION, kNumRows,
+                          SMALL_BLOCKSIZE, &warmed_id));
+  NO_FATALS(Scan(scanned_id, kNumRows));
+
+  {
+    BlockCacheWarmer warmer(fs_manager_.get());
+    ASSERT_OK(warmer.SaveCachedBlocks());
+  }
+
+  // The blocks of the scanned cfile were persisted. The block cache is
+  // shared by the whole process, so point the keys at the second cfile,
+  // whose blocks are at the same offsets but are not cached, and add a key
+  // for a cfile which does not exist.
+  const string path = fs_manager_->GetBlockCacheKeysPath();
+  BlockCacheKeysPB pb;
+  ASSERT_OK(pb_util::ReadPBContainerFromPath(env_.get(), path, &pb));
+  BlockCacheKeysPB warm_pb;
+  for (const BlockCacheKeysPB::CachedBlockPB& block : pb.blocks()) {
+    if (block.file_id() == scanned_id.id()) {
+      *warm_pb.add_blocks() = block;
+      warm_pb.mutable_blocks(warm_pb.blocks_size() - 1)->set_file_id(warmed_id.id());
+    }
+  }
+  int num_blocks = warm_pb.blocks_size();
+  ASSERT_GT(num_blocks, 1);
+  BlockCacheKeysPB::CachedBlockPB* missing = warm_pb.add_blocks();
+  *missing = warm_pb.blocks(0);
+  missing->set_file_id(warmed_id.id() + 1000);
+  ASSERT_OK(pb_util::WritePBContainerToPath(env_.get(), path, warm_pb,
+                                            pb_util::OVERWRITE, pb_util::NO_SYNC));
+
+  BlockCacheWarmer warmer(fs_manager_.get());
+  ASSERT_OK(warmer.Start());
+  warmer.WaitForWarmup();
+  BlockCacheWarmer::Progress progress = warmer.GetProgress();
+  ASSERT_TRUE(progress.started);
+  ASSERT_TRUE(progress.done);
+  ASSERT_EQ(num_blocks + 1, progress.blocks_total);
+  ASSERT_EQ(num_blocks, progress.blocks_loaded);
+  ASSERT_EQ(1, progress.blocks_skipped);
+
+  // The blocks of the second cfile are cached now.
+  BlockCache* cache = BlockCache::GetSingleton();
+  for (int i = 0; i < num_blocks; i++) {
+    BlockCacheHandle handle;
+    ASSERT_TRUE(cache->Lookup(warmed_id, warm_pb.blocks(i).offset(), Cache::EXPECT_IN_CACHE,
+                              &handle));
+    ASSERT_EQ(warm_pb.blocks(i).size(), handle.data().size());
+  }
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,283 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/block_cache_warmer.h"
+
+#include <boost/bind.hpp>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <map>
+
+#include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/block_handle.h"
+#include "kudu/cfile/block_pointer.h"
+#include "kudu/cfile/cfile_reader.h"
+#include "kudu/fs/block_manager.h"
+#include "kudu/fs/fs_manager.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/pb_util.h"
+#include "kudu/util/thread.h"
+#include "kudu/util/threadpool.h"
+
+DEFINE_int32(block_cache_keys_save_interval_secs, 300,
+             "Interval in seconds at which the keys of the blocks in the block "
+             "cache are persisted, so that the block cache is warmed up with "
+             "them when the server restarts. They are persisted on shutdown as "
+             "well. If 0, the keys are not persisted and the block cache is not "
+             "warmed up.");
+TAG_FLAG(block_cache_keys_save_interval_secs, advanced);
+
+DEFINE_int32(block_cache_warmup_threads, 1,
+             "Maximum number of threads which read blocks into the block cache "
+             "when warming it up after a restart.");
+TAG_FLAG(block_cache_warmup_threads, advanced);
+
+DEFINE_int32(block_cache_warmup_max_mb_per_sec, 64,
+             "Maximum rate, in MB per second, at which blocks are read into the "
+             "block cache when warming it up after a restart. If 0, the rate "
+             "is not limited.");
+TAG_FLAG(block_cache_warmup_max_mb_per_sec, advanced);
+
+using std::vector;
+
+namespace kudu {
+namespace cfile {
+
+using fs::ReadableBlock;
+
+BlockCacheWarmer::BlockCacheWarmer(FsManager* fs_manager)
+    : fs_manager_(fs_manager),
+      shutdown_latch_(1),
+      warmup_latch_(1),
+      files_remaining_(0) {
+}
+
+BlockCacheWarmer::~BlockCacheWarmer() {
+  Shutdown();
+}
+
+Status BlockCacheWarmer::Start() {
+  if (FLAGS_block_cache_keys_save_interval_secs <= 0) {
+    warmup_latch_.CountDown();
+    return Status::OK();
+  }
+
+  BlockCacheKeysPB pb;
+  Status s = pb_util::ReadPBContainerFromPath(fs_manager_->env(),
+                                              fs_manager_->GetBlockCacheKeysPath(), &pb);
+  if (s.IsNotFound()) {
+    // Nothing was persisted yet, e.g. on the first start of the server.
+    pb.Clear();
+  } else if (!s.ok()) {
+    // Better start cold than not at all.
+    LOG(WARNING) << "Unable to read the keys of the cached blocks, not warming the "
+                 << "block cache up: " << s.ToString();
+    pb.Clear();
+  }
+
+  std::map<BlockId, vector<BlockCacheKeysPB::CachedBlockPB>, BlockIdCompare> blocks_by_file;
+  for (const BlockCacheKeysPB::CachedBlockPB& block : pb.blocks()) {
+    blocks_by_file[BlockId(block.file_id())].push_back(block);
+  }
+
+  {
+    lock_guard<simple_spinlock> l(&lock_);
+    progress_.started = true;
+    progress_.blocks_total = pb.blocks_size();
+    progress_.start_time = MonoTime::Now(MonoTime::FINE);
+    files_remaining_ = blocks_by_file.size();
+    if (blocks_by_file.empty()) {
+      progress_.done = true;
+      progress_.duration = MonoDelta::FromSeconds(0);
+    }
+  }
+
+  if (blocks_by_file.empty()) {
+    warmup_latch_.CountDown();
+  } else {
+    LOG(INFO) << "Warming the block cache up with " << pb.blocks_size() << " blocks of "
+              << blocks_by_file.size() << " cfiles";
+    RETURN_NOT_OK(ThreadPoolBuilder("block-cache-warmup")
+                  .set_max_threads(FLAGS_block_cache_warmup_threads)
+                  .Build(&warmup_pool_));
+    for (const auto& entry : blocks_by_file) {
+      RETURN_NOT_OK(warmup_pool_->SubmitFunc(boost::bind(&BlockCacheWarmer::WarmFile, this,
+                                                         entry.first, entry.second)));
+    }
+  }
+
+  return Thread::Create("cfile", "block_cache_keys_saver",
+                        &BlockCacheWarmer::RunSaveThread, this, &save_thread_);
+}
+
+void BlockCacheWarmer::Shutdown() {
+  if (shutdown_latch_.count() == 0) {
+    return;
+  }
+  shutdown_latch_.CountDown();
+  if (save_thread_) {
+    CHECK_OK(ThreadJoiner(save_thread_.get()).Join());
+    save_thread_.reset();
+  }
+  if (warmup_pool_) {
+    warmup_pool_->Shutdown();
+  }
+
+  // Unless the warm-up was interrupted, in which case the blocks persisted
+  // before are still better than the partially warmed up cache.
+  bool done;
+  {
+    lock_guard<simple_spinlock> l(&lock_);
+    done = progress_.done;
+  }
+  warmup_latch_.CountDown();
+  if (done && FLAGS_block_cache_keys_save_interval_secs > 0) {
+    WARN_NOT_OK(SaveCachedBlocks(), "Unable to persist the keys of the cached blocks");
+  }
+}
+
+Status BlockCacheWarmer::SaveCachedBlocks() {
+  vector<BlockCache::BlockInfo> blocks;
+  BlockCache::GetSingleton()->GetCachedBlocks(&blocks);
+
+  BlockCacheKeysPB pb;
+  for (const BlockCache::BlockInfo& info : blocks) {
+    BlockCacheKeysPB::CachedBlockPB* block = pb.add_blocks();
+    block->set_file_id(info.file_id.id());
+    block->set_offset(info.offset);
+    block->set_size(info.size_on_disk);
+    if (info.priority == Cache::HIGH_PRIORITY) {
+      block->set_high_priority(true);
+    }
+  }
+  RETURN_NOT_OK_PREPEND(pb_util::WritePBContainerToPath(fs_manager_->env(),
+                                                        fs_manager_->GetBlockCacheKeysPath(),
+                                                        pb, pb_util::OVERWRITE,
+                                                        pb_util::NO_SYNC),
+                        "Unable to write the keys of the cached blocks");
+  VLOG(1) << "Persisted the keys of " << blocks.size() << " cached blocks";
+  return Status::OK();
+}
+
+BlockCacheWarmer::Progress BlockCacheWarmer::GetProgress() const {
+  lock_guard<simple_spinlock> l(&lock_);
+  return progress_;
+}
+
+void BlockCacheWarmer::WaitForWarmup() {
+  warmup_latch_.Wait();
+}
+
+void BlockCacheWarmer::RunSaveThread() {
+  const MonoDelta interval = MonoDelta::FromSeconds(FLAGS_block_cache_keys_save_interval_secs);
+  while (!shutdown_latch_.WaitFor(interval)) {
+    // Until the warm-up completes, the cache holds fewer of the hot blocks
+    // than what was persisted last.
+    bool done;
+    {
+      lock_guard<simple_spinlock> l(&lock_);
+      done = progress_.done;
+    }
+    if (done) {
+      WARN_NOT_OK(SaveCachedBlocks(), "Unable to persist the keys of the cached blocks");
+    }
+  }
+}
+
+void BlockCacheWarmer::WarmFile(const BlockId& file_id,
+                                const vector<BlockCacheKeysPB::CachedBlockPB>& blocks) {
+  int64_t num_skipped = blocks.size();
+  gscoped_ptr<ReadableBlock> block;
+  gscoped_ptr<CFileReader> reader;
+  Status s = fs_manager_->OpenBlock(file_id, &block);
+  if (s.ok()) {
+    s = CFileReader::Open(std::move(block), ReaderOptions(), &reader);
+  }
+  if (!s.ok()) {
+    // Most likely, the cfile was deleted since the keys were persisted.
+    VLOG(1) << "Not warming the block cache up with cfile " << file_id.ToString() << ": "
+            << s.ToString();
+  } else {
+    num_skipped = 0;
+    for (const BlockCacheKeysPB::CachedBlockPB& pb : blocks) {
+      if (shutdown_latch_.count() == 0) {
+        // The remaining blocks are neither loaded nor skipped.
+        return;
+      }
+      if (pb.offset() == 0 || pb.offset() + pb.size() >= reader->file_size()) {
+        num_skipped++;
+        continue;
+      }
+      BlockHandle handle;
+      s = reader->ReadBlock(BlockPointer(pb.offset(), pb.size()),
+                            pb.high_priority() ? CFileReader::CACHE_BLOCK_HIGH_PRIORITY
+                                               : CFileReader::CACHE_BLOCK,
+                            &handle);
+      if (!s.ok()) {
+        VLOG(1) << "Unable to read block " << pb.offset() << " of cfile "
+                << file_id.ToString() << ": " << s.ToString();
+        num_skipped++;
+        continue;
+      }
+      {
+        lock_guard<simple_spinlock> l(&lock_);
+        progress_.blocks_loaded++;
+        progress_.bytes_loaded += pb.size();
+      }
+      if (!Throttle()) {
+        return;
+      }
+    }
+  }
+
+  Progress progress;
+  {
+    lock_guard<simple_spinlock> l(&lock_);
+    progress_.blocks_skipped += num_skipped;
+    if (--files_remaining_ == 0) {
+      progress_.done = true;
+      progress_.duration = MonoTime::Now(MonoTime::FINE).GetDeltaSince(progress_.start_time);
+    }
+    progress = progress_;
+  }
+  if (progress.done) {
+    LOG(INFO) << "Warmed the block cache up: " << progress.blocks_loaded << " blocks loaded, "
+              << progress.blocks_skipped << " skipped, in " << progress.duration.ToString();
+    warmup_latch_.CountDown();
+  }
+}
+
+bool BlockCacheWarmer::Throttle() {
+  if (FLAGS_block_cache_warmup_max_mb_per_sec <= 0) {
+    return shutdown_latch_.count() > 0;
+  }
+  MonoTime deadline;
+  {
+    lock_guard<simple_spinlock> l(&lock_);
+    double secs = static_cast<double>(progress_.bytes_loaded) /
+        (FLAGS_block_cache_warmup_max_mb_per_sec * 1024 * 1024);
+    deadline = progress_.start_time;
+    deadline.AddDelta(MonoDelta::FromSeconds(secs));
+  }
+  if (MonoTime::Now(MonoTime::FINE).ComesBefore(deadline)) {
+    return !shutdown_latch_.WaitUntil(deadline);
+  }
+  return shutdown_latch_.count() > 0;
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,143 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CFILE_BLOCK_CACHE_WARMER_H
+#define KUDU_CFILE_BLOCK_CACHE_WARMER_H
+
+#include <vector>
+
+#include "kudu/cfile/cfile.pb.h"
+#include "kudu/fs/block_id.h"
+#include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/countdown_latch.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class FsManager;
+class Thread;
+class ThreadPool;
+
+namespace cfile {
+
+// Warms the block cache up after a restart.
+//
+// While the server runs, the keys of the blocks in the block cache are
+// periodically persisted, along with what is needed to read the blocks, in a
+// file of the metadata root (see --block_cache_keys_save_interval_secs). They
+// are persisted once more on shutdown.
+//
+// On startup, once the filesystem is opened, the blocks which were persisted
+// and still exist are read into the block cache in the background, on a pool
+// of --block_cache_warmup_threads threads, at most at
+// --block_cache_warmup_max_mb_per_sec, so that the warm-up does not starve
+// the foreground reads.
+class BlockCacheWarmer {
+ public:
+  // The progress of the warm-up.
+  struct Progress {
+    Progress()
+        : started(false),
+          done(false),
+          blocks_total(0),
+          blocks_loaded(0),
+          blocks_skipped(0),
+          bytes_loaded(0) {
+    }
+
+    // Whether the warm-up was started, and whether it completed.
+    bool started;
+    bool done;
+
+    // The number of blocks to warm the cache up with, and how many of them
+    // were read so far. Blocks which no longer exist, e.g. because their
+    // cfile was compacted away, or which could not be read are skipped.
+    int64_t blocks_total;
+    int64_t blocks_loaded;
+    int64_t blocks_skipped;
+    int64_t bytes_loaded;
+
+    // The time the warm-up was started at, and the time it took if done.
+    MonoTime start_time;
+    MonoDelta duration;
+  };
+
+  explicit BlockCacheWarmer(FsManager* fs_manager);
+
+  // Shuts the warmer down, if not done already.
+  ~BlockCacheWarmer();
+
+  // Starts warming the block cache up with the blocks persisted by the
+  // previous run of the server, if any, and starts persisting the blocks in
+  // the cache periodically.
+  Status Start();
+
+  // Stops the warm-up if it is in progress, and persists the blocks in the
+  // cache unless the warm-up was interrupted.
+  void Shutdown();
+
+  // Persists the blocks which are in the block cache.
+  Status SaveCachedBlocks();
+
+  // Returns the progress of the warm-up.
+  Progress GetProgress() const;
+
+  // Waits for the warm-up to complete.
+  void WaitForWarmup();
+
+ private:
+  // Persists the blocks in the cache every --block_cache_keys_save_interval_secs
+  // until shut down.
+  void RunSaveThread();
+
+  // Reads the given blocks of the cfile 'file_id' into the block cache.
+  // Runs on 'warmup_pool_'.
+  void WarmFile(const BlockId& file_id,
+                const std::vector<BlockCacheKeysPB::CachedBlockPB>& blocks);
+
+  // Waits until the bytes read by the warm-up so far fit in the rate limit.
+  // Returns false if shutting down.
+  bool Throttle();
+
+  FsManager* const fs_manager_;
+
+  gscoped_ptr<ThreadPool> warmup_pool_;
+  scoped_refptr<Thread> save_thread_;
+
+  // Counts down once on shutdown.
+  CountDownLatch shutdown_latch_;
+
+  // Counts down once the warm-up completes, or is interrupted.
+  CountDownLatch warmup_latch_;
+
+  // Protects 'progress_' and 'files_remaining_'.
+  mutable simple_spinlock lock_;
+  Progress progress_;
+
+  // The number of cfiles whose blocks are still to be read.
+  int64_t files_remaining_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockCacheWarmer);
+};
+
+} // namespace cfile
+} // namespace kudu
+
+#endif
@@ -45,6 +45,12 @@ class BlockBuilder {
     return Status::OK();
   }
 
+  // Return the approximate number of bytes AppendExtraInfo() would append
+  // if it were called now.
+  virtual size_t ExtraInfoSize() const {
+    return 0;
+  }
+
   // Used by the cfile writer to determine whether the current block is full.
   // If it is full, the cfile writer will call FinishCurDataBlock().
   virtual bool IsBlockFull(size_t limit) const = 0;
@@ -149,6 +155,15 @@ class BlockDecoder {
   // header which is shared by all data blocks.
   virtual rowid_t GetFirstRowId() const = 0;
 
+  // If the block stores the 'n' values starting at position 'pos' in the same
+  // in-memory format as a ColumnBlock, sets '*cells' to them and returns true,
+  // so that they may be referenced in place rather than copied.
+  //
+  // The default implementation returns false.
+  virtual bool GetCellsInPlace(size_t pos, size_t n, Slice *cells) const {
+    return false;
+  }
+
   virtual ~BlockDecoder() {}
  private:
   DISALLOW_COPY_AND_ASSIGN(BlockDecoder);
@@ -0,0 +1,260 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/block_readahead.h"
+
+#include <boost/bind.hpp>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "kudu/cfile/index_btree.h"
+#include "kudu/gutil/once.h"
+#include "kudu/util/flag_tags.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/threadpool.h"
+
+DEFINE_int32(cfile_readahead_threads, 8,
+             "Maximum number of threads which read cfile data blocks ahead of "
+             "sequential scans. See --cfile_readahead_blocks.");
+TAG_FLAG(cfile_readahead_threads, advanced);
+
+DEFINE_int32(cfile_inject_readahead_latency_ms, 0,
+             "Number of milliseconds by which each read ahead of a scan is "
+             "delayed before it starts, as if the readahead threads were busy. "
+             "Used for tests.");
+TAG_FLAG(cfile_inject_readahead_latency_ms, unsafe);
+TAG_FLAG(cfile_inject_readahead_latency_ms, hidden);
+
+using std::shared_ptr;
+
+namespace kudu {
+namespace cfile {
+
+namespace {
+
+GoogleOnceType g_readahead_pool_once = GOOGLE_ONCE_INIT;
+ThreadPool* g_readahead_pool;
+
+void InitReadaheadPool() {
+  gscoped_ptr<ThreadPool> pool;
+  CHECK_OK(ThreadPoolBuilder("cfile-readahead")
+           .set_max_threads(FLAGS_cfile_readahead_threads)
+           .Build(&pool));
+  g_readahead_pool = pool.release();
+}
+
+ThreadPool* GetReadaheadPool() {
+  GoogleOnceInit(&g_readahead_pool_once, &InitReadaheadPool);
+  return g_readahead_pool;
+}
+
+} // anonymous namespace
+
+BlockReadahead::BlockReadahead(const CFileReader* reader,
+                               CFileReader::CacheControl cache_control,
+                               int max_blocks,
+                               int64_t max_bytes)
+    : reader_(reader),
+      cache_control_(cache_control),
+      max_blocks_(max_blocks),
+      max_bytes_(max_bytes),
+      has_next_block_(false),
+      window_bytes_(0),
+      blocks_since_reset_(0),
+      read_done_(&lock_),
+      num_in_flight_(0) {
+  DCHECK_GT(max_blocks_, 0);
+}
+
+BlockReadahead::~BlockReadahead() {
+  DropWindow();
+  MutexLock l(lock_);
+  while (num_in_flight_ > 0) {
+    read_done_.Wait();
+  }
+}
+
+void BlockReadahead::Reset() {
+  DropWindow();
+  blocks_since_reset_ = 0;
+}
+
+Status BlockReadahead::ReadBlock(const BlockPointer& idx_root,
+                                 const IndexTreeIterator& idx_iter,
+                                 BlockHandle* block,
+                                 bool* prefetched) {
+  const BlockPointer& ptr = idx_iter.GetCurrentBlockPointer();
+  blocks_since_reset_++;
+  *prefetched = false;
+
+  if (!window_.empty()) {
+    shared_ptr<PendingRead> read = window_.front();
+    if (read->ptr.offset() == ptr.offset()) {
+      window_.pop_front();
+      window_bytes_ -= read->ptr.size();
+      bool claimed = false;
+      {
+        MutexLock l(lock_);
+        *prefetched = read->done;
+        if (!read->started) {
+          // The read is still queued, e.g. behind those of other scans: rather
+          // than wait for a thread to be free, read the block now.
+          read->started = true;
+          claimed = true;
+        }
+        while (!claimed && !read->done) {
+          read_done_.Wait();
+        }
+      }
+      Status s = claimed ? reader_->ReadBlock(ptr, cache_control_, block) : read->status;
+      if (PREDICT_FALSE(!s.ok())) {
+        DropWindow();
+        return s;
+      }
+      if (!claimed) {
+        *block = std::move(read->block);
+      }
+      FillWindow();
+      return Status::OK();
+    }
+    // The iterator did not read the next block: the blocks read ahead are
+    // of no use anymore.
+    DropWindow();
+  }
+
+  RETURN_NOT_OK(reader_->ReadBlock(ptr, cache_control_, block));
+  MaybeStartReadahead(idx_root, idx_iter);
+  return Status::OK();
+}
+
+void BlockReadahead::NoteBlockRead(const BlockPointer& idx_root,
+                                   const IndexTreeIterator& idx_iter) {
+  blocks_since_reset_++;
+  DropWindow();
+  MaybeStartReadahead(idx_root, idx_iter);
+}
+
+void BlockReadahead::MaybeStartReadahead(const BlockPointer& idx_root,
+                                         const IndexTreeIterator& idx_iter) {
+  if (blocks_since_reset_ < 2 || !window_.empty()) {
+    return;
+  }
+  // Start reading ahead from the block after this one.
+  const BlockPointer& ptr = idx_iter.GetCurrentBlockPointer();
+  DropWindow();
+  lookahead_iter_.reset(IndexTreeIterator::Create(reader_, idx_root));
+  Status s = lookahead_iter_->SeekAtOrBefore(idx_iter.GetCurrentKey());
+  if (PREDICT_FALSE(!s.ok() ||
+                    lookahead_iter_->GetCurrentBlockPointer().offset() != ptr.offset())) {
+    VLOG(1) << "Unable to read ahead of block " << ptr.ToString() << " of cfile "
+            << reader_->ToString() << ": " << s.ToString();
+    lookahead_iter_.reset();
+    return;
+  }
+  FillWindow();
+}
+
+void BlockReadahead::FillWindow() {
+  if (!lookahead_iter_) {
+    return;
+  }
+  while (static_cast<int>(window_.size()) < max_blocks_) {
+    if (!has_next_block_) {
+      if (!lookahead_iter_->HasNext()) {
+        return;
+      }
+      Status s = lookahead_iter_->Next();
+      if (PREDICT_FALSE(!s.ok())) {
+        // Leave it to the iterator to report the error, if it gets there.
+        VLOG(1) << "Unable to read ahead in cfile " << reader_->ToString() << ": "
+                << s.ToString();
+        lookahead_iter_.reset();
+        return;
+      }
+      has_next_block_ = true;
+    }
+
+    // Always allow one block in the window, however large.
+    const BlockPointer& ptr = lookahead_iter_->GetCurrentBlockPointer();
+    if (!window_.empty() && window_bytes_ + ptr.size() > max_bytes_) {
+      return;
+    }
+
+    shared_ptr<PendingRead> read(new PendingRead(ptr));
+    {
+      MutexLock l(lock_);
+      num_in_flight_++;
+    }
+    Status s = GetReadaheadPool()->SubmitFunc(boost::bind(&BlockReadahead::DoRead, this, read));
+    if (PREDICT_FALSE(!s.ok())) {
+      {
+        MutexLock l(lock_);
+        num_in_flight_--;
+      }
+      LOG(WARNING) << "Unable to submit readahead of cfile " << reader_->ToString() << ": "
+                   << s.ToString();
+      lookahead_iter_.reset();
+      has_next_block_ = false;
+      return;
+    }
+    has_next_block_ = false;
+    window_.push_back(read);
+    window_bytes_ += ptr.size();
+  }
+}
+
+void BlockReadahead::DoRead(const shared_ptr<PendingRead>& read) {
+  if (PREDICT_FALSE(FLAGS_cfile_inject_readahead_latency_ms > 0)) {
+    SleepFor(MonoDelta::FromMilliseconds(FLAGS_cfile_inject_readahead_latency_ms));
+  }
+  {
+    MutexLock l(lock_);
+    if (read->started) {
+      // Claimed by the iterator, or cancelled.
+      num_in_flight_--;
+      read_done_.Broadcast();
+      return;
+    }
+    read->started = true;
+  }
+
+  BlockHandle block;
+  Status s = reader_->ReadBlock(read->ptr, cache_control_, &block);
+
+  MutexLock l(lock_);
+  read->status = s;
+  read->block = std::move(block);
+  read->done = true;
+  num_in_flight_--;
+  read_done_.Broadcast();
+}
+
+void BlockReadahead::DropWindow() {
+  if (!window_.empty()) {
+    MutexLock l(lock_);
+    for (const shared_ptr<PendingRead>& read : window_) {
+      read->started = true;
+    }
+  }
+  window_.clear();
+  window_bytes_ = 0;
+  lookahead_iter_.reset();
+  has_next_block_ = false;
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,155 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CFILE_BLOCK_READAHEAD_H
+#define KUDU_CFILE_BLOCK_READAHEAD_H
+
+#include <deque>
+#include <memory>
+
+#include "kudu/cfile/block_handle.h"
+#include "kudu/cfile/block_pointer.h"
+#include "kudu/cfile/cfile_reader.h"
+#include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/condition_variable.h"
+#include "kudu/util/mutex.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+namespace cfile {
+
+class IndexTreeIterator;
+
+// Reads the data blocks of a cfile ahead of a CFileIterator which scans it
+// sequentially, so that the I/O of the scan overlaps with its decoding.
+//
+// The blocks are read on a thread pool shared by all the cfiles of the
+// process. Readahead starts once the iterator reads the block after the one
+// it seeked to, so that point lookups do not trigger it, and then keeps up
+// to 'max_blocks' blocks, and up to 'max_bytes' bytes of them, read or being
+// read ahead of the iterator.
+//
+// This class is not thread-safe: it must only be used by its iterator.
+class BlockReadahead {
+ public:
+  BlockReadahead(const CFileReader* reader,
+                 CFileReader::CacheControl cache_control,
+                 int max_blocks,
+                 int64_t max_bytes);
+
+  // Waits for the reads in flight, if any.
+  ~BlockReadahead();
+
+  // Drops the blocks read ahead so far. Must be called whenever the iterator
+  // seeks.
+  void Reset();
+
+  // Sets '*block' to the data block which 'idx_iter', an iterator of the
+  // index tree rooted at 'idx_root', is seeked to.
+  //
+  // If the block was read ahead, waits for its read to complete if needed.
+  // Sets '*prefetched' to true if the block had already been read by then.
+  // Otherwise, reads the block synchronously: so does a read ahead which is
+  // still queued behind the reads of other scans, rather than wait for it.
+  Status ReadBlock(const BlockPointer& idx_root, const IndexTreeIterator& idx_iter,
+                   BlockHandle* block, bool* prefetched);
+
+  // Notes that the iterator read the block which 'idx_iter' is seeked to by
+  // other means than ReadBlock(), so that readahead carries on after it.
+  void NoteBlockRead(const BlockPointer& idx_root, const IndexTreeIterator& idx_iter);
+
+  // Returns true if blocks are being read ahead of the iterator.
+  bool reading_ahead() const {
+    return lookahead_iter_ != nullptr;
+  }
+
+ private:
+  // A block which was read ahead, or is being read.
+  struct PendingRead {
+    explicit PendingRead(const BlockPointer& ptr)
+        : ptr(ptr),
+          started(false),
+          done(false) {
+    }
+
+    const BlockPointer ptr;
+
+    // Protected by the readahead's 'lock_'.
+    //
+    // Set once a thread of the pool starts reading the block, or once the
+    // read is claimed by the iterator or cancelled, in which case the thread
+    // skips it.
+    bool started;
+    bool done;
+    Status status;
+    BlockHandle block;
+  };
+
+  // Starts reading ahead of the block which 'idx_iter' is seeked to, if the
+  // iterator has read past the block it seeked to and is not reading ahead
+  // already.
+  void MaybeStartReadahead(const BlockPointer& idx_root, const IndexTreeIterator& idx_iter);
+
+  // Issues reads of the blocks after the last one in the window until the
+  // window is full, or the end of the file is reached.
+  void FillWindow();
+
+  // Reads the block of 'read' on a thread of the readahead pool.
+  void DoRead(const std::shared_ptr<PendingRead>& read);
+
+  // Drops the blocks in the window and stops reading ahead until the next
+  // sequential read. The reads which have not started yet are cancelled.
+  void DropWindow();
+
+  const CFileReader* const reader_;
+  const CFileReader::CacheControl cache_control_;
+  const int max_blocks_;
+  const int64_t max_bytes_;
+
+  // Iterator of the index tree whose blocks are read ahead, seeked to the
+  // last block in the window, or to the block after it if
+  // 'has_next_block_' is true. NULL if not reading ahead.
+  gscoped_ptr<IndexTreeIterator> lookahead_iter_;
+
+  // True if 'lookahead_iter_' is seeked to a block which did not fit in the
+  // byte budget of the window yet.
+  bool has_next_block_;
+
+  // The blocks read or being read ahead of the iterator, in file order.
+  std::deque<std::shared_ptr<PendingRead> > window_;
+
+  // The number of on-disk bytes of the blocks in 'window_'.
+  int64_t window_bytes_;
+
+  // The number of blocks read since the last Reset().
+  int64_t blocks_since_reset_;
+
+  // Protects the state of the PendingReads and 'num_in_flight_'.
+  mutable Mutex lock_;
+  ConditionVariable read_done_;
+
+  // The number of reads submitted to the pool which have not completed yet,
+  // including the reads of blocks dropped from the window.
+  int num_in_flight_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockReadahead);
+};
+
+} // namespace cfile
+} // namespace kudu
+
+#endif
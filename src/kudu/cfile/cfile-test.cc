@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 #include <glog/logging.h>
 #include <stdlib.h>
+#include <limits>
 #include <list>
 
 #include "kudu/cfile/cfile-test-base.h"
@@ -26,22 +27,34 @@
 #include "kudu/cfile/cfile.pb.h"
 #include "kudu/cfile/index_block.h"
 #include "kudu/cfile/index_btree.h"
+#include "kudu/cfile/zone_map.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/fs/fs-test-util.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/random.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/stopwatch.h"
 
+DECLARE_int64(block_cache_capacity_mb);
+DECLARE_int64(block_cache_compressed_capacity_mb);
 DECLARE_string(block_cache_type);
+DECLARE_bool(cfile_adaptive_encoding);
+DECLARE_int32(cfile_adaptive_encoding_retrial_blocks);
 DECLARE_string(cfile_do_on_finish);
+DECLARE_int32(cfile_readahead_blocks);
+DECLARE_int64(cfile_readahead_max_bytes);
+DECLARE_int32(cfile_inject_readahead_latency_ms);
 
 #if defined(__linux__)
 DECLARE_string(nvm_cache_path);
 DECLARE_bool(nvm_cache_simulate_allocation_failure);
 #endif
 
+METRIC_DECLARE_counter(block_cache_compressed_tier_hits);
 METRIC_DECLARE_counter(block_cache_hits_caching);
 
 METRIC_DECLARE_entity(server);
@@ -204,6 +217,158 @@ class TestCFile : public CFileTestBase {
     TimeSeekAndReadFileWithNulls(generator, block_id, n);
   }
 
+  // Write a nullable UINT32 file whose NULL cells follow 'is_null', and check
+  // that ScanNullBitmap() produces the same null bitmap as Scan() across
+  // batches of random sizes, and that it doesn't disturb a following Scan()
+  // of the same batch.
+  void TestScanNullBitmap(const vector<bool>& is_null) {
+    const size_t num_rows = is_null.size();
+    gscoped_array<uint32_t> values(new uint32_t[num_rows]);
+    gscoped_array<uint8_t> null_bitmap(new uint8_t[BitmapSize(num_rows)]);
+    for (size_t i = 0; i < num_rows; i++) {
+      values[i] = i;
+      BitmapChange(null_bitmap.get(), i, !is_null[i]);
+    }
+
+    gscoped_ptr<WritableBlock> sink;
+    ASSERT_OK(fs_manager_->CreateNewBlock(&sink));
+    BlockId block_id = sink->id();
+    WriterOptions opts;
+    opts.write_posidx = true;
+    opts.storage_attributes.cfile_block_size = 1024;
+    opts.storage_attributes.encoding = PLAIN_ENCODING;
+    CFileWriter w(opts, GetTypeInfo(UINT32), true, std::move(sink));
+    ASSERT_OK(w.Start());
+    ASSERT_OK(w.AppendNullableEntries(null_bitmap.get(), values.get(), num_rows));
+    ASSERT_OK(w.Finish());
+
+    gscoped_ptr<ReadableBlock> block;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+    gscoped_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+    gscoped_ptr<CFileIterator> iter;
+    ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK));
+    ASSERT_OK(iter->SeekToOrdinal(0));
+
+    Random rng(SeedRandom());
+    ScopedColumnBlock<UINT32> nulls_only(num_rows);
+    ScopedColumnBlock<UINT32> full(num_rows);
+    size_t fetched = 0;
+    while (fetched < num_rows) {
+      size_t n = 1 + rng.Uniform(1000);
+      ASSERT_OK(iter->PrepareBatch(&n));
+      ColumnBlock nulls_only_batch(nulls_only.type_info(), nulls_only.null_bitmap(),
+                                   nulls_only.data(), n, nullptr);
+      ColumnBlock full_batch(full.type_info(), full.null_bitmap(), full.data(), n, nullptr);
+      ASSERT_OK(iter->ScanNullBitmap(&nulls_only_batch));
+      ASSERT_OK(iter->Scan(&full_batch));
+      for (size_t i = 0; i < n; i++) {
+        size_t row = fetched + i;
+        ASSERT_EQ(is_null[row], nulls_only_batch.is_null(i)) << "row " << row;
+        ASSERT_EQ(is_null[row], full_batch.is_null(i)) << "row " << row;
+        if (!is_null[row]) {
+          ASSERT_EQ(row, full[i]) << "row " << row;
+        }
+      }
+      ASSERT_OK(iter->FinishBatch());
+      fetched += n;
+    }
+    ASSERT_FALSE(iter->HasNext());
+  }
+
+  // Writes a nullable, dictionary-encoded string column with few distinct
+  // values, and checks that 'pred' is evaluated on the dictionary codes by
+  // ScanAndEvaluate(), matching the same rows as evaluating it on the
+  // scanned values would.
+  void TestScanAndEvaluateDictCodes(const ColumnPredicate& pred) {
+    const size_t kNumRows = 10000;
+    const size_t kNumDistinct = 10;
+    vector<string> strings;
+    gscoped_array<Slice> values(new Slice[kNumRows]);
+    gscoped_array<uint8_t> null_bitmap(new uint8_t[BitmapSize(kNumRows)]);
+    for (size_t i = 0; i < kNumDistinct; i++) {
+      strings.push_back(StringPrintf("v%zu", i));
+    }
+    for (size_t i = 0; i < kNumRows; i++) {
+      values[i] = strings[i % kNumDistinct];
+      BitmapChange(null_bitmap.get(), i, i % 7 != 0);
+    }
+
+    gscoped_ptr<WritableBlock> sink;
+    ASSERT_OK(fs_manager_->CreateNewBlock(&sink));
+    BlockId block_id = sink->id();
+    WriterOptions opts;
+    opts.write_posidx = true;
+    opts.storage_attributes.cfile_block_size = 1024;
+    opts.storage_attributes.encoding = DICT_ENCODING;
+    CFileWriter w(opts, GetTypeInfo(STRING), true, std::move(sink));
+    ASSERT_OK(w.Start());
+    ASSERT_OK(w.AppendNullableEntries(null_bitmap.get(), values.get(), kNumRows));
+    ASSERT_OK(w.Finish());
+
+    gscoped_ptr<ReadableBlock> block;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+    gscoped_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+    gscoped_ptr<CFileIterator> iter;
+    ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK));
+    ASSERT_OK(iter->SeekToOrdinal(0));
+
+    Random rng(SeedRandom());
+    ScopedColumnBlock<STRING> cb(kNumRows);
+    ScopedColumnBlock<STRING> expected_cb(kNumRows);
+    size_t fetched = 0;
+    while (fetched < kNumRows) {
+      size_t n = 1 + rng.Uniform(1000);
+      ASSERT_OK(iter->PrepareBatch(&n));
+      ColumnBlock batch(cb.type_info(), cb.null_bitmap(), cb.data(), n, cb.arena());
+      ColumnBlock expected_batch(expected_cb.type_info(), expected_cb.null_bitmap(),
+                                 expected_cb.data(), n, expected_cb.arena());
+
+      // Some rows are already filtered out, e.g. by another predicate.
+      SelectionVector sel(n);
+      SelectionVector expected_sel(n);
+      sel.SetAllTrue();
+      for (size_t i = 0; i < n; i++) {
+        if ((fetched + i) % 5 == 0) {
+          BitmapClear(sel.mutable_bitmap(), i);
+        }
+      }
+      memcpy(expected_sel.mutable_bitmap(), sel.bitmap(), BitmapSize(n));
+
+      bool evaluated;
+      ASSERT_OK(iter->ScanAndEvaluate(pred, &sel, &batch, &evaluated));
+      ASSERT_TRUE(evaluated);
+      ASSERT_OK(iter->Scan(&expected_batch));
+      pred.Evaluate(expected_batch, &expected_sel);
+
+      for (size_t i = 0; i < n; i++) {
+        size_t row = fetched + i;
+        ASSERT_EQ(expected_sel.IsRowSelected(i), sel.IsRowSelected(i)) << "row " << row;
+        if (sel.IsRowSelected(i)) {
+          ASSERT_FALSE(batch.is_null(i)) << "row " << row;
+          ASSERT_EQ(strings[row % kNumDistinct], cb[i].ToString()) << "row " << row;
+        }
+      }
+      ASSERT_OK(iter->FinishBatch());
+      fetched += n;
+    }
+    ASSERT_FALSE(iter->HasNext());
+
+    // A predicate which matches NULLs cannot be evaluated on the codes.
+    ASSERT_OK(iter->SeekToOrdinal(0));
+    size_t n = 100;
+    ASSERT_OK(iter->PrepareBatch(&n));
+    ColumnBlock batch(cb.type_info(), cb.null_bitmap(), cb.data(), n, cb.arena());
+    SelectionVector sel(n);
+    sel.SetAllTrue();
+    bool evaluated;
+    ASSERT_OK(iter->ScanAndEvaluate(ColumnPredicate::IsNull(pred.column()), &sel, &batch,
+                                    &evaluated));
+    ASSERT_FALSE(evaluated);
+    ASSERT_OK(iter->FinishBatch());
+  }
+
 
   void TestReadWriteRawBlocks(CompressionType compression, int num_entries) {
     // Test Write
@@ -708,6 +873,269 @@ TEST_P(TestCFileBothCacheTypes, TestNullDictStrings) {
   TestNullTypes(&generator, DICT_ENCODING, LZ4);
 }
 
+TEST_P(TestCFileBothCacheTypes, TestScanNullBitmap) {
+  const size_t kRunLength = 5000;
+  vector<bool> is_null;
+  // A run of non-NULL values, spanning several blocks without NULLs, then a
+  // run of NULLs and a run alternating between NULL and non-NULL.
+  is_null.insert(is_null.end(), kRunLength, false);
+  is_null.insert(is_null.end(), kRunLength, true);
+  for (size_t i = 0; i < kRunLength; i++) {
+    is_null.push_back(i % 3 == 0);
+  }
+  NO_FATALS(TestScanNullBitmap(is_null));
+
+  // A file with a single block of only NULLs.
+  NO_FATALS(TestScanNullBitmap(vector<bool>(kRunLength, true)));
+}
+
+TEST_P(TestCFileBothCacheTypes, TestScanAndEvaluateDictCodes) {
+  ColumnSchema col("s", STRING, true);
+  Slice v0("v0");
+  Slice v3("v3");
+  Slice v5("v5");
+  Slice v9("v9");
+  Slice missing("w");
+
+  {
+    SCOPED_TRACE("equality");
+    NO_FATALS(TestScanAndEvaluateDictCodes(ColumnPredicate::Equality(col, &v3)));
+  }
+  {
+    SCOPED_TRACE("range");
+    NO_FATALS(TestScanAndEvaluateDictCodes(ColumnPredicate::Range(col, &v3, &v9)));
+  }
+  {
+    SCOPED_TRACE("IN list");
+    vector<const void*> in_list = { &v0, &v5, &v9, &missing };
+    NO_FATALS(TestScanAndEvaluateDictCodes(ColumnPredicate::InList(col, &in_list)));
+  }
+  {
+    SCOPED_TRACE("no matching code");
+    NO_FATALS(TestScanAndEvaluateDictCodes(ColumnPredicate::Equality(col, &missing)));
+  }
+}
+
+// Test that, with adaptive encoding, an AUTO_ENCODING column is encoded with
+// the encoding that suits its data best, which changes along with the data,
+// and that the file reads back correctly.
+TEST_P(TestCFileBothCacheTypes, TestAdaptiveEncoding) {
+  FLAGS_cfile_adaptive_encoding = true;
+  FLAGS_cfile_adaptive_encoding_retrial_blocks = 4;
+
+  // Long runs of equal values, then random values. Every 7th row is NULL.
+  const size_t kNumRows = 40000;
+  gscoped_array<int32_t> values(new int32_t[kNumRows]);
+  gscoped_array<uint8_t> null_bitmap(new uint8_t[BitmapSize(kNumRows)]);
+  Random rng(SeedRandom());
+  for (size_t i = 0; i < kNumRows; i++) {
+    values[i] = i < kNumRows / 2 ? i / 1000 : rng.Next32();
+    BitmapChange(null_bitmap.get(), i, i % 7 != 0);
+  }
+
+  gscoped_ptr<WritableBlock> sink;
+  ASSERT_OK(fs_manager_->CreateNewBlock(&sink));
+  BlockId block_id = sink->id();
+  WriterOptions opts;
+  opts.write_posidx = true;
+  opts.storage_attributes.cfile_block_size = 1024;
+  CFileWriter w(opts, GetTypeInfo(INT32), true, std::move(sink));
+  ASSERT_OK(w.Start());
+  // Append in uneven batches, so that trials start and finish mid-batch. The
+  // batches start on byte boundaries of the null bitmap.
+  size_t appended = 0;
+  while (appended < kNumRows) {
+    size_t n = std::min<size_t>(kNumRows - appended, 8 * (1 + rng.Uniform(375)));
+    ASSERT_OK(w.AppendNullableEntries(null_bitmap.get() + appended / 8,
+                                      &values[appended], n));
+    appended += n;
+  }
+  ASSERT_OK(w.Finish());
+
+  gscoped_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+  gscoped_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+  ASSERT_EQ(RLE, reader->footer().encoding());
+  ASSERT_GT(reader->footer().data_block_encodings_size(), 0);
+  const auto& changes = reader->footer().data_block_encodings();
+  ASSERT_NE(RLE, changes.Get(changes.size() - 1).encoding());
+
+  gscoped_ptr<CFileIterator> iter;
+  ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK));
+  ASSERT_OK(iter->SeekToOrdinal(0));
+  ScopedColumnBlock<INT32> out(1000);
+  size_t fetched = 0;
+  while (fetched < kNumRows) {
+    size_t n = out.nrows();
+    ASSERT_OK(iter->PrepareBatch(&n));
+    ColumnBlock batch(out.type_info(), out.null_bitmap(), out.data(), n, nullptr);
+    ASSERT_OK(iter->Scan(&batch));
+    for (size_t i = 0; i < n; i++) {
+      size_t row = fetched + i;
+      ASSERT_EQ(row % 7 == 0, batch.is_null(i)) << "row " << row;
+      if (row % 7 != 0) {
+        ASSERT_EQ(values[row], out[i]) << "row " << row;
+      }
+    }
+    ASSERT_OK(iter->FinishBatch());
+    fetched += n;
+  }
+  ASSERT_FALSE(iter->HasNext());
+}
+
+// Scans the UINT32 file written by TestReadahead from row 'start', checking
+// the values, and returns the stats of the iterator.
+static void ScanWithReadahead(CFileReader* reader, rowid_t start, rowid_t num_rows,
+                              IteratorStats* stats) {
+  gscoped_ptr<CFileIterator> iter;
+  ASSERT_OK(reader->NewIterator(&iter, CFileReader::DONT_CACHE_BLOCK));
+  ASSERT_OK(iter->SeekToOrdinal(start));
+  ScopedColumnBlock<UINT32> out(100);
+  rowid_t row = start;
+  while (iter->HasNext()) {
+    // Leave the readahead time to get ahead of the scan.
+    SleepFor(MonoDelta::FromMicroseconds(200));
+    size_t n = out.nrows();
+    ASSERT_OK(iter->CopyNextValues(&n, &out));
+    for (size_t i = 0; i < n; i++) {
+      ASSERT_EQ((row + i) * 10, out[i]) << "row " << row + i;
+    }
+    row += n;
+  }
+  ASSERT_EQ(num_rows, row);
+  *stats = iter->io_statistics();
+}
+
+// Scans the whole file 'block_id' of UINT32 cells in batches, and returns the
+// number of batches in '*num_batches', and the number of those whose cells
+// could be pinned in '*num_pinned'. The pinned cells must match the scanned
+// ones.
+static void ScanPinnedCells(FsManager* fs_manager, const BlockId& block_id,
+                            int* num_batches, int* num_pinned) {
+  gscoped_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager->OpenBlock(block_id, &block));
+  gscoped_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+  gscoped_ptr<CFileIterator> iter;
+  ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK));
+  ASSERT_OK(iter->SeekToOrdinal(0));
+
+  ScopedColumnBlock<UINT32> out(100);
+  *num_batches = 0;
+  *num_pinned = 0;
+  std::vector<PinnedCells> pins;
+  while (iter->HasNext()) {
+    size_t n = out.nrows();
+    ASSERT_OK(iter->PrepareBatch(&n));
+    ASSERT_OK(iter->Scan(&out));
+    PinnedCells pinned;
+    if (iter->GetPinnedCells(&pinned)) {
+      ASSERT_EQ(n * sizeof(uint32_t), pinned.cells.size());
+      ASSERT_EQ(0, memcmp(out.data(), pinned.cells.data(), pinned.cells.size()));
+      pins.push_back(pinned);
+      (*num_pinned)++;
+    }
+    ASSERT_OK(iter->FinishBatch());
+    (*num_batches)++;
+  }
+
+  // The pinned cells outlive the iterator and its reader.
+  iter.reset();
+  reader.reset();
+  const uint32_t* first = reinterpret_cast<const uint32_t*>(pins.empty() ? nullptr :
+                                                            pins.front().cells.data());
+  if (first != nullptr) {
+    ASSERT_EQ(0, first[0]);
+    ASSERT_EQ(10, first[1]);
+  }
+}
+
+// Test that the cells of non-nullable PLAIN blocks can be referenced in place,
+// and that those of other blocks cannot.
+TEST_P(TestCFileBothCacheTypes, TestGetPinnedCells) {
+  const int kNumRows = 10000;
+  int num_batches;
+  int num_pinned;
+  {
+    UInt32DataGenerator<false> generator;
+    BlockId block_id;
+    NO_FATALS(WriteTestFile(&generator, PLAIN_ENCODING, NO_COMPRESSION, kNumRows,
+                            SMALL_BLOCKSIZE, &block_id));
+    NO_FATALS(ScanPinnedCells(fs_manager_.get(), block_id, &num_batches, &num_pinned));
+    // Only the batches which span two blocks are not pinned.
+    ASSERT_GT(num_pinned, 0);
+    ASSERT_LT(num_pinned, num_batches);
+  }
+  {
+    UInt32DataGenerator<true> generator;
+    BlockId block_id;
+    NO_FATALS(WriteTestFile(&generator, PLAIN_ENCODING, NO_COMPRESSION, kNumRows,
+                            SMALL_BLOCKSIZE, &block_id));
+    NO_FATALS(ScanPinnedCells(fs_manager_.get(), block_id, &num_batches, &num_pinned));
+    ASSERT_EQ(0, num_pinned);
+  }
+  {
+    UInt32DataGenerator<false> generator;
+    BlockId block_id;
+    NO_FATALS(WriteTestFile(&generator, BIT_SHUFFLE, NO_COMPRESSION, kNumRows,
+                            SMALL_BLOCKSIZE, &block_id));
+    NO_FATALS(ScanPinnedCells(fs_manager_.get(), block_id, &num_batches, &num_pinned));
+    ASSERT_EQ(0, num_pinned);
+  }
+}
+
+// Test that sequential scans read data blocks ahead, and that the blocks read
+// ahead are the right ones, whether the scan starts at the beginning of the
+// file or in the middle of it.
+TEST_P(TestCFileBothCacheTypes, TestReadahead) {
+  const int kNumRows = 20000;
+  UInt32DataGenerator<false> generator;
+  BlockId block_id;
+  NO_FATALS(WriteTestFile(&generator, PLAIN_ENCODING, NO_COMPRESSION, kNumRows,
+                          NO_FLAGS, &block_id));
+  gscoped_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+  gscoped_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(block), ReaderOptions(), &reader));
+
+  IteratorStats stats;
+  FLAGS_cfile_readahead_blocks = 0;
+  NO_FATALS(ScanWithReadahead(reader.get(), 0, kNumRows, &stats));
+  ASSERT_GT(stats.data_blocks_read_from_disk, 10);
+  ASSERT_EQ(0, stats.data_blocks_prefetched);
+  const int64_t num_blocks = stats.data_blocks_read_from_disk;
+
+  FLAGS_cfile_readahead_blocks = 4;
+  for (rowid_t start : { 0, kNumRows / 2 + 17 }) {
+    SCOPED_TRACE(start);
+    NO_FATALS(ScanWithReadahead(reader.get(), start, kNumRows, &stats));
+    ASSERT_GT(stats.data_blocks_prefetched, 0);
+    // The block seeked to and the one after it are never read ahead.
+    ASSERT_LE(stats.data_blocks_prefetched, stats.data_blocks_read_from_disk - 2);
+    if (start == 0) {
+      ASSERT_EQ(num_blocks, stats.data_blocks_read_from_disk);
+    }
+  }
+
+  // A budget smaller than a block still reads one block ahead.
+  FLAGS_cfile_readahead_max_bytes = 1;
+  NO_FATALS(ScanWithReadahead(reader.get(), 0, kNumRows, &stats));
+  ASSERT_GT(stats.data_blocks_prefetched, 0);
+
+  // The scan does not wait for reads ahead which have not started yet, e.g.
+  // because the readahead threads are busy: it reads the blocks itself.
+  // Waiting for them would take as long as the delay for nearly every block.
+  const int kLatencyMs = 500;
+  FLAGS_cfile_inject_readahead_latency_ms = kLatencyMs;
+  MonoTime start = MonoTime::Now(MonoTime::FINE);
+  NO_FATALS(ScanWithReadahead(reader.get(), 0, kNumRows, &stats));
+  MonoDelta elapsed = MonoTime::Now(MonoTime::FINE).GetDeltaSince(start);
+  ASSERT_EQ(0, stats.data_blocks_prefetched);
+  ASSERT_EQ(num_blocks, stats.data_blocks_read_from_disk);
+  ASSERT_LT(elapsed.ToMilliseconds(), (num_blocks - 2) * kLatencyMs / 2);
+}
+
 TEST_P(TestCFileBothCacheTypes, TestReleaseBlock) {
   gscoped_ptr<WritableBlock> sink;
   ASSERT_OK(fs_manager_->CreateNewBlock(&sink));
@@ -824,6 +1252,73 @@ TEST_P(TestCFileBothCacheTypes, TestCacheKeysAreStable) {
   }
 }
 
+// Scans all the rows of 'reader', a file of UINT32 cells written with
+// UInt32DataGenerator, caching its blocks.
+static void ScanAndVerifyCached(CFileReader* reader, rowid_t num_rows) {
+  gscoped_ptr<CFileIterator> iter;
+  ASSERT_OK(reader->NewIterator(&iter, CFileReader::CACHE_BLOCK));
+  ASSERT_OK(iter->SeekToOrdinal(0));
+  ScopedColumnBlock<UINT32> out(1000);
+  rowid_t row = 0;
+  while (iter->HasNext()) {
+    size_t n = out.nrows();
+    ASSERT_OK(iter->CopyNextValues(&n, &out));
+    for (size_t i = 0; i < n; i++) {
+      ASSERT_EQ((row + i) * 10, out[i]) << "row " << row + i;
+    }
+    row += n;
+  }
+  ASSERT_EQ(num_rows, row);
+}
+
+// Tests that the blocks of a compressed cfile which are evicted from the
+// block cache are decompressed from its compressed tier rather than read
+// from disk again.
+TEST_P(TestCFileBothCacheTypes, TestCompressedTier) {
+  FLAGS_block_cache_capacity_mb = 16;
+  FLAGS_block_cache_compressed_capacity_mb = 16;
+  MetricRegistry registry;
+  scoped_refptr<MetricEntity> entity(METRIC_ENTITY_server.Instantiate(&registry, "test_entity"));
+  BlockCache* cache = BlockCache::GetSingleton();
+  ASSERT_TRUE(cache->has_compressed_tier());
+  cache->StartInstrumentation(entity);
+
+  const int kNumRows = 20000;
+  UInt32DataGenerator<false> generator;
+  BlockId block_id;
+  NO_FATALS(WriteTestFile(&generator, PLAIN_ENCODING, LZ4, kNumRows, NO_FLAGS, &block_id));
+  gscoped_ptr<ReadableBlock> block;
+  ASSERT_OK(fs_manager_->OpenBlock(block_id, &block));
+  size_t bytes_read = 0;
+  gscoped_ptr<ReadableBlock> count_block(
+      new CountingReadableBlock(std::move(block), &bytes_read));
+  gscoped_ptr<CFileReader> reader;
+  ASSERT_OK(CFileReader::Open(std::move(count_block), ReaderOptions(), &reader));
+
+  // The first scan reads the blocks from disk, and caches them in both tiers.
+  NO_FATALS(ScanAndVerifyCached(reader.get(), kNumRows));
+  Counter* compressed_hits = down_cast<Counter*>(
+      entity->FindOrNull(METRIC_block_cache_compressed_tier_hits).get());
+  ASSERT_EQ(0, compressed_hits->value());
+  const size_t bytes_read_after_first_scan = bytes_read;
+
+  // Evict the blocks of the cfile from the block cache, by filling it up
+  // with the blocks of another file.
+  const BlockId filler_id(block_id.id() + 1);
+  const size_t kFillerBlockSize = 1024 * 1024;
+  for (int i = 0; i < 4 * FLAGS_block_cache_capacity_mb; i++) {
+    uint8_t* data = cache->Allocate(kFillerBlockSize);
+    ASSERT_TRUE(data != nullptr);
+    BlockCacheHandle handle;
+    ASSERT_TRUE(cache->Insert(filler_id, i, Slice(data, kFillerBlockSize), &handle));
+  }
+
+  // The second scan decompresses the blocks from the compressed tier.
+  NO_FATALS(ScanAndVerifyCached(reader.get(), kNumRows));
+  ASSERT_GT(compressed_hits->value(), 0);
+  ASSERT_EQ(bytes_read_after_first_scan, bytes_read);
+}
+
 #if defined(__linux__)
 // Inject failures in nvm allocation and ensure that we can still read a file.
 TEST_P(TestCFileBothCacheTypes, TestNvmAllocationFailure) {
@@ -833,5 +1328,50 @@ TEST_P(TestCFileBothCacheTypes, TestNvmAllocationFailure) {
 }
 #endif
 
+// Test that the zone maps of blocks with NaN values never rule out a
+// predicate, since NaN satisfies ranges under TypeInfo::Compare().
+TEST(TestZoneMap, TestNaN) {
+  ColumnSchema col("d", DOUBLE);
+  const double kNaN = std::numeric_limits<double>::quiet_NaN();
+  double lower = 10;
+  ColumnPredicate pred = ColumnPredicate::Range(col, &lower, nullptr);
+
+  // Evaluated on the values, the predicate matches the NaN.
+  double values[] = { 1, kNaN, 3 };
+  ColumnBlock block(col.type_info(), nullptr, values, 3, nullptr);
+  SelectionVector sel(3);
+  sel.SetAllTrue();
+  pred.Evaluate(block, &sel);
+  ASSERT_EQ(1, sel.CountSelected());
+  ASSERT_TRUE(sel.IsRowSelected(1));
+
+  // With or without NaN first, the min and max leave it out, and the zone map
+  // records it.
+  double nan_first[] = { kNaN, 1, 3 };
+  for (const double* cells : { values, nan_first }) {
+    ZoneMapBuilder builder(col.type_info());
+    builder.AddValues(cells, 3);
+    ZoneMapPB pb;
+    builder.ToPB(0, &pb);
+    ASSERT_TRUE(pb.has_nan());
+    double min, max;
+    ASSERT_EQ(sizeof(min), pb.min_value().size());
+    memcpy(&min, pb.min_value().data(), sizeof(min));
+    memcpy(&max, pb.max_value().data(), sizeof(max));
+    ASSERT_EQ(1, min);
+    ASSERT_EQ(3, max);
+    ASSERT_TRUE(ZoneMapMayMatch(pb, pred));
+  }
+
+  // Without the NaN, the block is ruled out.
+  double no_nan[] = { 1, 3 };
+  ZoneMapBuilder builder(col.type_info());
+  builder.AddValues(no_nan, 2);
+  ZoneMapPB pb;
+  builder.ToPB(0, &pb);
+  ASSERT_FALSE(pb.has_nan());
+  ASSERT_FALSE(ZoneMapMayMatch(pb, pred));
+}
+
 } // namespace cfile
 } // namespace kudu
@@ -24,12 +24,18 @@
 #include "kudu/cfile/block_cache.h"
 #include "kudu/cfile/block_handle.h"
 #include "kudu/cfile/block_pointer.h"
+#include "kudu/cfile/block_readahead.h"
 #include "kudu/cfile/cfile.pb.h"
 #include "kudu/cfile/cfile_writer.h" // for kMagicString
 #include "kudu/cfile/gvint_block.h"
 #include "kudu/cfile/index_block.h"
 #include "kudu/cfile/index_btree.h"
+#include "kudu/cfile/binary_dict_block.h"
 #include "kudu/cfile/binary_plain_block.h"
+#include "kudu/cfile/zone_map.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/gutil/casts.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/mathlimits.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -39,6 +45,7 @@
 #include "kudu/util/malloc.h"
 #include "kudu/util/memory/overwrite.h"
 #include "kudu/util/object_pool.h"
+#include "kudu/util/pb_util.h"
 #include "kudu/util/rle-encoding.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
@@ -47,7 +54,23 @@ DEFINE_bool(cfile_lazy_open, true,
             "Allow lazily opening of cfiles");
 TAG_FLAG(cfile_lazy_open, hidden);
 
+DEFINE_int32(cfile_readahead_blocks, 4,
+             "Number of data blocks which each cfile iterator reads ahead of "
+             "sequential scans, in the background. Readahead starts once an "
+             "iterator reads past the block it seeked to. 0 disables readahead.");
+TAG_FLAG(cfile_readahead_blocks, advanced);
+TAG_FLAG(cfile_readahead_blocks, runtime);
+
+DEFINE_int64(cfile_readahead_max_bytes, 8 * 1024 * 1024,
+             "Maximum number of bytes of data blocks which each cfile iterator "
+             "keeps read ahead of sequential scans. At least one block is read "
+             "ahead regardless.");
+TAG_FLAG(cfile_readahead_max_bytes, advanced);
+TAG_FLAG(cfile_readahead_max_bytes, runtime);
+
 using kudu::fs::ReadableBlock;
+using std::unique_ptr;
+using std::vector;
 using strings::Substitute;
 
 namespace kudu {
@@ -77,6 +100,13 @@ static Status ParseMagicAndLength(const Slice &data,
   return Status::OK();
 }
 
+// Returns the priority of the blocks read with the given cache control in
+// the block cache.
+static Cache::Priority CachePriority(CFileReader::CacheControl cache_control) {
+  return cache_control == CFileReader::CACHE_BLOCK_HIGH_PRIORITY ?
+      Cache::HIGH_PRIORITY : Cache::NORMAL_PRIORITY;
+}
+
 CFileReader::CFileReader(const ReaderOptions &options,
                          const uint64_t file_size,
                          gscoped_ptr<ReadableBlock> block) :
@@ -136,6 +166,20 @@ Status CFileReader::InitOnce() {
                                       footer_->encoding(),
                                       &type_encoding_info_));
 
+  for (const DataBlockEncodingPB& change : footer_->data_block_encodings()) {
+    if (change.encoding() == DICT_ENCODING || footer_->encoding() == DICT_ENCODING) {
+      return Status::Corruption("dictionary encoding cannot change between data blocks",
+                                ToString());
+    }
+    if (!block_encoding_changes_.empty() &&
+        change.first_block_offset() <= block_encoding_changes_.back().first) {
+      return Status::Corruption("data block encoding changes out of order", ToString());
+    }
+    const TypeEncodingInfo* info;
+    RETURN_NOT_OK(TypeEncodingInfo::Get(type_info_, change.encoding(), &info));
+    block_encoding_changes_.push_back(std::make_pair(change.first_block_offset(), info));
+  }
+
   VLOG(2) << "Initialized CFile reader. "
           << "Header: " << header_->DebugString()
           << " Footer: " << footer_->DebugString()
@@ -205,7 +249,14 @@ Status CFileReader::ReadAndParseFooter() {
   // Verify if the compression codec is available
   if (footer_->compression() != NO_COMPRESSION) {
     const CompressionCodec* codec;
-    RETURN_NOT_OK(GetCompressionCodec(footer_->compression(), &codec));
+    if (footer_->has_compression_dictionary()) {
+      RETURN_NOT_OK(CreateDictionaryCompressionCodec(footer_->compression(),
+                                                     footer_->compression_dictionary(),
+                                                     &dictionary_codec_));
+      codec = dictionary_codec_.get();
+    } else {
+      RETURN_NOT_OK(GetCompressionCodec(footer_->compression(), &codec));
+    }
     block_uncompressor_.reset(new CompressedBlockDecoder(codec, kBlockSizeLimit));
   }
 
@@ -214,8 +265,6 @@ Status CFileReader::ReadAndParseFooter() {
   return Status::OK();
 }
 
-namespace {
-
 // ScratchMemory owns a memory buffer which could either be allocated on-heap
 // or allocated by a Cache instance. In the case of the default DRAM-based cache,
 // these two are equivalent, but we still make a distinction between "cache-managed"
@@ -301,49 +350,126 @@ class ScratchMemory {
   int size_;
   DISALLOW_COPY_AND_ASSIGN(ScratchMemory);
 };
-} // anonymous namespace
 
 Status CFileReader::ReadBlock(const BlockPointer &ptr, CacheControl cache_control,
                               BlockHandle *ret) const {
+  bool found;
+  RETURN_NOT_OK(LookupCachedBlock(ptr, cache_control, ret, &found));
+  if (found) {
+    // Cache hit
+    return Status::OK();
+  }
+
+  // Cache miss: need to read ourselves.
+  // We issue trace events only in the cache miss case since we expect the
+  // tracing overhead to be small compared to the IO (even if it's a memcpy
+  // from the Linux cache).
+  TRACE_EVENT1("io", "CFileReader::ReadBlock(cache miss)",
+               "cfile", ToString());
+  Slice block;
+  ScratchMemory scratch;
+  AllocateBlockScratch(ptr, cache_control, &scratch);
+  RETURN_NOT_OK(block_->Read(ptr.offset(), ptr.size(), &block, scratch.get()));
+  return FinishBlockRead(ptr, cache_control, block, &scratch, ret);
+}
+
+Status CFileReader::ReadBlocks(fs::BlockManager* block_manager, vector<BlockRead>* reads) {
+  // The reads of the blocks which are not in the cache, with the memory
+  // they are read into.
+  vector<BlockRead*> misses;
+  vector<unique_ptr<ScratchMemory>> scratches;
+  vector<fs::BlockReadRange> ranges;
+  for (BlockRead& read : *reads) {
+    const CFileReader* reader = read.reader;
+    bool found;
+    RETURN_NOT_OK(reader->LookupCachedBlock(read.ptr, read.cache_control, &read.block, &found));
+    if (found) {
+      continue;
+    }
+    unique_ptr<ScratchMemory> scratch(new ScratchMemory());
+    reader->AllocateBlockScratch(read.ptr, read.cache_control, scratch.get());
+    ranges.emplace_back(reader->block_.get(), read.ptr.offset(), read.ptr.size(),
+                        scratch->get());
+    misses.push_back(&read);
+    scratches.push_back(std::move(scratch));
+  }
+  if (misses.empty()) {
+    return Status::OK();
+  }
+
+  TRACE_EVENT1("io", "CFileReader::ReadBlocks(cache miss)",
+               "num_blocks", misses.size());
+  RETURN_NOT_OK(block_manager->ReadBlocks(&ranges));
+  for (size_t i = 0; i < misses.size(); i++) {
+    BlockRead* read = misses[i];
+    RETURN_NOT_OK(read->reader->FinishBlockRead(read->ptr, read->cache_control,
+                                                ranges[i].range.result, scratches[i].get(),
+                                                &read->block));
+  }
+  return Status::OK();
+}
+
+Status CFileReader::LookupCachedBlock(const BlockPointer &ptr, CacheControl cache_control,
+                                      BlockHandle *ret, bool *found) const {
   DCHECK(init_once_.initted());
   CHECK(ptr.offset() > 0 &&
         ptr.offset() + ptr.size() < file_size_) <<
     "bad offset " << ptr.ToString() << " in file of size "
                   << file_size_;
   BlockCacheHandle bc_handle;
-  Cache::CacheBehavior cache_behavior = cache_control == CACHE_BLOCK ?
+  Cache::CacheBehavior cache_behavior = cache_control != DONT_CACHE_BLOCK ?
       Cache::EXPECT_IN_CACHE : Cache::NO_EXPECT_IN_CACHE;
   BlockCache* cache = BlockCache::GetSingleton();
-  if (cache->Lookup(block_->id(), ptr.offset(), cache_behavior, &bc_handle)) {
+  if (cache->Lookup(block_->id(), ptr.offset(), cache_behavior,
+                    CachePriority(cache_control), &bc_handle)) {
     *ret = BlockHandle::WithDataFromCache(&bc_handle);
-    // Cache hit
+    *found = true;
     return Status::OK();
   }
 
-  // Cache miss: need to read ourselves.
-  // We issue trace events only in the cache miss case since we expect the
-  // tracing overhead to be small compared to the IO (even if it's a memcpy
-  // from the Linux cache).
-  TRACE_EVENT1("io", "CFileReader::ReadBlock(cache miss)",
-               "cfile", ToString());
-  Slice block;
+  // Decompress the block from the compressed tier rather than reading it
+  // from disk, if it is there.
+  *found = false;
+  if (block_uncompressor_ != nullptr && cache->has_compressed_tier() &&
+      cache->LookupCompressed(block_->id(), ptr.offset(), &bc_handle)) {
+    ScratchMemory scratch;
+    RETURN_NOT_OK(DecompressAndCacheBlock(ptr, cache_control, bc_handle.data(),
+                                          &scratch, false, ret));
+    *found = true;
+  }
+  return Status::OK();
+}
 
+void CFileReader::AllocateBlockScratch(const BlockPointer &ptr, CacheControl cache_control,
+                                       ScratchMemory *scratch) const {
   // If we are reading uncompressed data and plan to cache the result,
   // then we should allocate our scratch memory directly from the cache.
   // This avoids an extra memory copy in the case of an NVM cache.
-  ScratchMemory scratch;
-  if (block_uncompressor_ == nullptr && cache_control == CACHE_BLOCK) {
-    scratch.TryAllocateFromCache(cache, ptr.size());
+  if (block_uncompressor_ == nullptr && cache_control != DONT_CACHE_BLOCK) {
+    scratch->TryAllocateFromCache(BlockCache::GetSingleton(), ptr.size());
   } else {
-    scratch.AllocateFromHeap(ptr.size());
+    scratch->AllocateFromHeap(ptr.size());
   }
+}
 
-  RETURN_NOT_OK(block_->Read(ptr.offset(), ptr.size(), &block, scratch.get()));
-
+Status CFileReader::FinishBlockRead(const BlockPointer &ptr, CacheControl cache_control,
+                                    Slice block, ScratchMemory *scratch,
+                                    BlockHandle *ret) const {
   if (block.size() != ptr.size()) {
     return Status::IOError("Could not read full block length");
   }
 
+  return DecompressAndCacheBlock(ptr, cache_control, block, scratch, true, ret);
+}
+
+Status CFileReader::DecompressAndCacheBlock(const BlockPointer &ptr,
+                                            CacheControl cache_control,
+                                            Slice block, ScratchMemory *scratch,
+                                            bool cache_compressed,
+                                            BlockHandle *ret) const {
+  BlockCache* cache = BlockCache::GetSingleton();
+  BlockCacheHandle bc_handle;
+
   // Decompress the block
   if (block_uncompressor_ != nullptr) {
     // Get the size required for the uncompressed buffer
@@ -359,7 +485,7 @@ Status CFileReader::ReadBlock(const BlockPointer &ptr, CacheControl cache_contro
     // If we plan to put the uncompressed block in the cache, we should
     // decompress directly into the cache's memory (to avoid a memcpy for NVM).
     ScratchMemory decompressed_scratch;
-    if (cache_control == CACHE_BLOCK) {
+    if (cache_control != DONT_CACHE_BLOCK) {
       decompressed_scratch.TryAllocateFromCache(cache, uncompressed_size);
     } else {
       decompressed_scratch.AllocateFromHeap(uncompressed_size);
@@ -373,46 +499,53 @@ Status CFileReader::ReadBlock(const BlockPointer &ptr, CacheControl cache_contro
       return s;
     }
 
+    // Keep the compressed data too, now that it is known to be valid.
+    if (cache_compressed && cache_control != DONT_CACHE_BLOCK &&
+        cache->has_compressed_tier()) {
+      cache->InsertCompressed(block_->id(), ptr.offset(), block);
+    }
+
     // Now that we've decompressed, we don't need to keep holding onto the original
     // scratch buffer. Instead, we have to start holding onto our decompression
     // output buffer.
-    scratch.Swap(&decompressed_scratch);
+    scratch->Swap(&decompressed_scratch);
 
     // Set the result block to our decompressed data.
-    block = Slice(scratch.get(), uncompressed_size);
+    block = Slice(scratch->get(), uncompressed_size);
   } else {
     // Some of the File implementations from LevelDB attempt to be tricky
     // and just return a Slice into an mmapped region (or in-memory region).
     // But, this is hard to program against in terms of cache management, etc,
     // so we memcpy into our scratch buffer if necessary.
-    block.relocate(scratch.get());
+    block.relocate(scratch->get());
   }
 
   // It's possible that one of the TryAllocateFromCache() calls above
   // failed, in which case we don't insert it into the cache regardless
   // of what the user requested.
-  if (cache_control == CACHE_BLOCK && scratch.IsFromCache()) {
-    if (cache->Insert(block_->id(), ptr.offset(), block, &bc_handle)) {
+  if (cache_control != DONT_CACHE_BLOCK && scratch->IsFromCache()) {
+    if (cache->Insert(block_->id(), ptr.offset(), block, ptr.size(),
+                      CachePriority(cache_control), &bc_handle)) {
       *ret = BlockHandle::WithDataFromCache(&bc_handle);
     } else {
       // If we failed to insert in the cache, but we'd already read into
       // cache-managed memory, we need to ensure that we end up with a
       // heap-allocated block in the BlockHandle.
-      scratch.EnsureOnHeap();
-      block = Slice(scratch.get(), block.size());
+      scratch->EnsureOnHeap();
+      block = Slice(scratch->get(), block.size());
       *ret = BlockHandle::WithOwnedData(block);
     }
   } else {
     // If we never intended to cache the block, then the scratch space
     // should not be owned by the cache.
-    DCHECK_EQ(block.data(), scratch.get());
-    DCHECK(!scratch.IsFromCache());
+    DCHECK_EQ(block.data(), scratch->get());
+    DCHECK(!scratch->IsFromCache());
     *ret = BlockHandle::WithOwnedData(block);
   }
 
   // The cache or the BlockHandle now has ownership over the memory, so release
   // the scoped pointer.
-  ignore_result(scratch.release());
+  ignore_result(scratch->release());
 
   return Status::OK();
 }
@@ -438,11 +571,46 @@ bool CFileReader::GetMetadataEntry(const string &key, string *val) {
   return false;
 }
 
+Status CFileReader::GetBlockZoneMaps(const ZoneMapIndexPB** zone_maps) {
+  DCHECK(has_zone_maps());
+  RETURN_NOT_OK(zone_maps_once_.Init(&CFileReader::ReadZoneMaps, this));
+  *zone_maps = block_zone_maps_.get();
+  return Status::OK();
+}
+
+Status CFileReader::ReadZoneMaps() {
+  BlockHandle handle;
+  RETURN_NOT_OK(ReadBlock(BlockPointer(footer().zone_map_index_ptr()),
+                          DONT_CACHE_BLOCK, &handle));
+  gscoped_ptr<ZoneMapIndexPB> zone_maps(new ZoneMapIndexPB());
+  RETURN_NOT_OK_PREPEND(pb_util::ParseFromArray(zone_maps.get(), handle.data().data(),
+                                                handle.data().size()),
+                        Substitute("Unable to parse zone maps of CFile $0", ToString()));
+  block_zone_maps_.swap(zone_maps);
+
+  // The zone maps stay in memory, so account for them.
+  mem_consumption_.Reset(memory_footprint());
+  return Status::OK();
+}
+
 Status CFileReader::NewIterator(CFileIterator **iter, CacheControl cache_control) {
   *iter = new CFileIterator(this, cache_control);
   return Status::OK();
 }
 
+const TypeEncodingInfo *CFileReader::block_encoding_info(const BlockPointer &ptr) const {
+  DCHECK(init_once_.initted());
+  auto it = std::upper_bound(
+      block_encoding_changes_.begin(), block_encoding_changes_.end(), ptr.offset(),
+      [](uint64_t offset, const std::pair<uint64_t, const TypeEncodingInfo *> &change) {
+        return offset < change.first;
+      });
+  if (it == block_encoding_changes_.begin()) {
+    return type_encoding_info_;
+  }
+  return (--it)->second;
+}
+
 size_t CFileReader::memory_footprint() const {
   size_t size = kudu_malloc_usable_size(this);
   size += block_->memory_footprint();
@@ -460,6 +628,14 @@ size_t CFileReader::memory_footprint() const {
   if (block_uncompressor_) {
     size += kudu_malloc_usable_size(block_uncompressor_.get());
   }
+  if (dictionary_codec_) {
+    size += kudu_malloc_usable_size(dictionary_codec_.get());
+    size += dictionary_codec_->memory_footprint_excluding_this();
+  }
+  if (block_zone_maps_) {
+    size += block_zone_maps_->SpaceUsed();
+  }
+  size += block_encoding_changes_.capacity() * sizeof(block_encoding_changes_[0]);
   return size;
 }
 
@@ -516,6 +692,10 @@ CFileIterator::CFileIterator(CFileReader* reader,
     cache_control_(cache_control),
     last_prepare_idx_(-1),
     last_prepare_count_(-1) {
+  if (FLAGS_cfile_readahead_blocks > 0) {
+    readahead_.reset(new BlockReadahead(reader, cache_control, FLAGS_cfile_readahead_blocks,
+                                        FLAGS_cfile_readahead_max_bytes));
+  }
 }
 
 CFileIterator::~CFileIterator() {
@@ -708,6 +888,10 @@ Status CFileIterator::PrepareForNewSeek() {
   }
 
   seeked_ = nullptr;
+  if (readahead_) {
+    readahead_->Reset();
+  }
+  batch_blocks_.clear();
   for (PreparedBlock *pb : prepared_blocks_) {
     prepared_block_pool_.Destroy(pb);
   }
@@ -747,7 +931,28 @@ Status DecodeNullInfo(Slice *data_block, uint32_t *num_rows_in_block, Slice *nul
 Status CFileIterator::ReadCurrentDataBlock(const IndexTreeIterator &idx_iter,
                                            PreparedBlock *prep_block) {
   prep_block->dblk_ptr_ = idx_iter.GetCurrentBlockPointer();
-  RETURN_NOT_OK(reader_->ReadBlock(prep_block->dblk_ptr_, cache_control_, &prep_block->dblk_data_));
+  prep_block->pinned_data_.reset();
+  bool prefetched = false;
+  BlockPointer idx_root = &idx_iter == posidx_iter_.get() ?
+      reader_->posidx_root() : reader_->validx_root();
+  if (!batch_blocks_.empty() &&
+      batch_blocks_.front().first.offset() != prep_block->dblk_ptr_.offset()) {
+    // The iterator did not read the blocks it asked for after all.
+    batch_blocks_.clear();
+  }
+  if (!batch_blocks_.empty()) {
+    prep_block->dblk_data_ = std::move(batch_blocks_.front().second);
+    batch_blocks_.pop_front();
+    if (readahead_ && batch_blocks_.empty()) {
+      readahead_->NoteBlockRead(idx_root, idx_iter);
+    }
+  } else if (readahead_) {
+    RETURN_NOT_OK(readahead_->ReadBlock(idx_root, idx_iter, &prep_block->dblk_data_,
+                                        &prefetched));
+  } else {
+    RETURN_NOT_OK(reader_->ReadBlock(prep_block->dblk_ptr_, cache_control_,
+                                     &prep_block->dblk_data_));
+  }
 
   uint32_t num_rows_in_block = 0;
   Slice data_block = prep_block->dblk_data_.data();
@@ -758,7 +963,8 @@ Status CFileIterator::ReadCurrentDataBlock(const IndexTreeIterator &idx_iter,
   }
 
   BlockDecoder *bd;
-  RETURN_NOT_OK(reader_->type_encoding_info()->CreateBlockDecoder(&bd, data_block, this));
+  RETURN_NOT_OK(reader_->block_encoding_info(prep_block->dblk_ptr_)->CreateBlockDecoder(
+      &bd, data_block, this));
   prep_block->dblk_.reset(bd);
   RETURN_NOT_OK(prep_block->dblk_->ParseHeader());
 
@@ -771,6 +977,7 @@ Status CFileIterator::ReadCurrentDataBlock(const IndexTreeIterator &idx_iter,
 
   io_stats_.cells_read_from_disk += num_rows_in_block;
   io_stats_.data_blocks_read_from_disk++;
+  io_stats_.data_blocks_prefetched += prefetched;
   io_stats_.bytes_read_from_disk += data_block.size();
 
   prep_block->idx_in_block_ = 0;
@@ -891,6 +1098,123 @@ Status CFileIterator::FinishBatch() {
 }
 
 
+void CFileIterator::RewindIfNeeded(PreparedBlock *pb) {
+  if (pb->needs_rewind_) {
+    // Seek back to the saved position.
+    SeekToPositionInBlock(pb, pb->rewind_idx_);
+    // TODO: we could add a mark/reset like interface in BlockDecoder interface
+    // that might be more efficient (allowing the decoder to save internal state
+    // instead of having to reconstruct it)
+  }
+}
+
+Status CFileIterator::ScanRowsInBlock(PreparedBlock *pb, size_t nrows,
+                                      ColumnDataView *dst,
+                                      const SelectionVector* matching_codes,
+                                      SelectionVector* sel) {
+  DCHECK_LE(nrows, pb->num_rows_in_block_ - pb->idx_in_block_);
+  DCHECK_EQ(matching_codes == nullptr, sel == nullptr);
+
+  auto copy_values = [&](size_t* n) {
+    if (matching_codes != nullptr) {
+      return down_cast<BinaryDictBlockDecoder*>(pb->dblk_.get())->CopyNextAndEvaluateCodes(
+          n, *matching_codes, sel, dst);
+    }
+    return pb->dblk_->CopyNextValues(n, dst);
+  };
+
+  if (reader_->is_nullable()) {
+    DCHECK(dst->is_nullable());
+
+    // Fill column bitmap
+    size_t count = nrows;
+    while (count > 0) {
+      bool not_null = false;
+      size_t nblock = pb->rle_decoder_.GetNextRun(&not_null, count);
+      DCHECK_LE(nblock, count);
+      if (PREDICT_FALSE(nblock == 0)) {
+        return Status::Corruption(
+          Substitute("Unexpected EOF on NULL bitmap read. Expected at least $0 more rows",
+                     count));
+      }
+
+      size_t this_batch = nblock;
+      if (not_null) {
+        // TODO: Maybe copy all and shift later?
+        RETURN_NOT_OK(copy_values(&this_batch));
+        DCHECK_EQ(nblock, this_batch);
+      } else {
+        if (sel != nullptr) {
+          // NULLs never match a predicate evaluated on dictionary codes.
+          BitmapChangeBits(sel->mutable_bitmap(), dst->first_row_index(), nblock, false);
+        }
+#ifndef NDEBUG
+        kudu::OverwriteWithPattern(reinterpret_cast<char *>(dst->data()),
+                                   dst->stride() * nblock,
+                                   "NULLNULLNULLNULLNULL");
+#endif
+      }
+
+      // Set the ColumnBlock bitmap
+      dst->SetNullBits(this_batch, not_null);
+
+      count -= this_batch;
+      pb->idx_in_block_ += this_batch;
+      pb->needs_rewind_ = true;
+      dst->Advance(this_batch);
+    }
+  } else {
+    size_t this_batch = nrows;
+    RETURN_NOT_OK(copy_values(&this_batch));
+    pb->needs_rewind_ = true;
+    DCHECK_EQ(nrows, this_batch);
+
+    // If the column is nullable, set all bits to true
+    if (dst->is_nullable()) {
+      dst->SetNullBits(this_batch, true);
+    }
+
+    pb->idx_in_block_ += this_batch;
+    dst->Advance(this_batch);
+  }
+  return Status::OK();
+}
+
+bool CFileIterator::TrySkipRowsInBlock(PreparedBlock *pb, size_t nrows) {
+  uint32_t target_idx = pb->idx_in_block_ + nrows;
+  DCHECK_LE(target_idx, pb->num_rows_in_block_);
+
+  if (target_idx == pb->num_rows_in_block_) {
+    // Nothing more is read from this block in this pass, so the decoders are
+    // left where they are. The next scan of the batch rewinds them, and
+    // seeking backward resets the null bitmap decoder.
+    pb->idx_in_block_ = target_idx;
+    pb->needs_rewind_ = true;
+    return true;
+  }
+
+  // Not every block decoder supports seeking to the position just past its
+  // last value, so we only seek when there is at least one more value in the
+  // block to land on. Otherwise the run is decoded instead.
+  if (reader_->is_nullable()) {
+    RleDecoder<bool> probe = pb->rle_decoder_;
+    size_t target_in_nonnulls = pb->dblk_->GetCurrentIndex() + probe.Skip(nrows);
+    if (target_in_nonnulls >= pb->dblk_->Count()) {
+      return false;
+    }
+    pb->rle_decoder_ = probe;
+    pb->dblk_->SeekToPositionInBlock(target_in_nonnulls);
+  } else {
+    if (target_idx >= pb->num_rows_in_block_) {
+      return false;
+    }
+    pb->dblk_->SeekToPositionInBlock(target_idx);
+  }
+  pb->idx_in_block_ = target_idx;
+  pb->needs_rewind_ = true;
+  return true;
+}
+
 Status CFileIterator::Scan(ColumnBlock *dst) {
   CHECK(seeked_) << "not seeked";
 
@@ -901,84 +1225,313 @@ Status CFileIterator::Scan(ColumnBlock *dst) {
   DCHECK_LE(rem, dst->nrows());
 
   for (PreparedBlock *pb : prepared_blocks_) {
-    if (pb->needs_rewind_) {
-      // Seek back to the saved position.
-      SeekToPositionInBlock(pb, pb->rewind_idx_);
-      // TODO: we could add a mark/reset like interface in BlockDecoder interface
-      // that might be more efficient (allowing the decoder to save internal state
-      // instead of having to reconstruct it)
+    RewindIfNeeded(pb);
+
+    // Fetch as many as we can from the current datablock.
+    size_t nrows = std::min(rem, pb->num_rows_in_block_ - pb->idx_in_block_);
+    RETURN_NOT_OK(ScanRowsInBlock(pb, nrows, &remaining_dst));
+    rem -= nrows;
+
+    // If we didn't fetch as many as requested, then it should
+    // be because the current data block ran out.
+    if (rem > 0) {
+      DCHECK_EQ(pb->dblk_->Count(), pb->dblk_->GetCurrentIndex()) <<
+        "dblk stopped yielding values before it was empty.";
+    } else {
+      break;
     }
+  }
+
+  DCHECK_EQ(rem, 0) << "Should have fetched exactly the number of prepared rows";
+  return Status::OK();
+}
 
-    if (reader_->is_nullable()) {
-      DCHECK(dst->is_nullable());
+Status CFileIterator::ScanNullBitmap(ColumnBlock *dst) {
+  CHECK(seeked_) << "not seeked";
 
-      size_t nrows = std::min(rem, pb->num_rows_in_block_ - pb->idx_in_block_);
+  uint32_t rem = last_prepare_count_;
+  DCHECK_LE(rem, dst->nrows());
+
+  if (!dst->is_nullable()) {
+    return Status::OK();
+  }
+  if (!reader_->is_nullable()) {
+    BitmapChangeBits(dst->null_bitmap(), 0, rem, true);
+    return Status::OK();
+  }
 
-      // Fill column bitmap
+  // The prepared blocks are left untouched, so that a following Scan() of
+  // the same batch need not rewind them. Instead, the position of the batch
+  // within each block is worked out from scratch: the front block starts at
+  // the position PrepareBatch() seeked it to, and any later blocks start at
+  // their beginning.
+  size_t dst_idx = 0;
+  for (PreparedBlock *pb : prepared_blocks_) {
+    uint32_t start_idx = pb == prepared_blocks_.front() ? pb->rewind_idx_ : 0;
+    size_t nrows = std::min(rem, pb->num_rows_in_block_ - start_idx);
+
+    uint32_t num_non_null = pb->dblk_->Count();
+    if (num_non_null == 0 || num_non_null == pb->num_rows_in_block_) {
+      // The block is either all NULL or has no NULLs at all, so there is no
+      // need to look at its null bitmap.
+      BitmapChangeBits(dst->null_bitmap(), dst_idx, nrows, num_non_null != 0);
+    } else {
+      RleDecoder<bool> rle_decoder(pb->rle_bitmap.data(), pb->rle_bitmap.size(), 1);
+      rle_decoder.Skip(start_idx);
       size_t count = nrows;
+      size_t run_idx = dst_idx;
       while (count > 0) {
         bool not_null = false;
-        size_t nblock = pb->rle_decoder_.GetNextRun(&not_null, count);
-        DCHECK_LE(nblock, count);
+        size_t nblock = rle_decoder.GetNextRun(&not_null, count);
         if (PREDICT_FALSE(nblock == 0)) {
           return Status::Corruption(
             Substitute("Unexpected EOF on NULL bitmap read. Expected at least $0 more rows",
                        count));
         }
+        BitmapChangeBits(dst->null_bitmap(), run_idx, nblock, not_null);
+        count -= nblock;
+        run_idx += nblock;
+      }
+    }
+    dst_idx += nrows;
+    rem -= nrows;
 
-        size_t this_batch = nblock;
-        if (not_null) {
-          // TODO: Maybe copy all and shift later?
-          RETURN_NOT_OK(pb->dblk_->CopyNextValues(&this_batch, &remaining_dst));
-          DCHECK_EQ(nblock, this_batch);
-          pb->needs_rewind_ = true;
-        } else {
-#ifndef NDEBUG
-          kudu::OverwriteWithPattern(reinterpret_cast<char *>(remaining_dst.data()),
-                                     remaining_dst.stride() * nblock,
-                                     "NULLNULLNULLNULLNULL");
-#endif
-        }
+    if (rem == 0) {
+      break;
+    }
+  }
+
+  DCHECK_EQ(rem, 0) << "Should have fetched exactly the number of prepared rows";
+  return Status::OK();
+}
+
+Status CFileIterator::EvaluateZoneMaps(rowid_t first_ordinal, const ColumnPredicate& pred,
+                                       SelectionVector* sel) {
+  RETURN_NOT_OK(reader_->Init());
+  if (!reader_->has_zone_maps()) {
+    return Status::OK();
+  }
+  const ZoneMapIndexPB* index;
+  RETURN_NOT_OK(reader_->GetBlockZoneMaps(&index));
+  const auto& zone_maps = index->block_zone_maps();
+
+  // Find the last block which starts at or before 'first_ordinal', and go
+  // through the blocks from there until the end of the range.
+  rowid_t end_ordinal = first_ordinal + sel->nrows();
+  auto it = std::upper_bound(zone_maps.begin(), zone_maps.end(), first_ordinal,
+                             [] (rowid_t ordinal, const ZoneMapPB& zone_map) {
+                               return ordinal < zone_map.first_ordinal();
+                             });
+  if (it != zone_maps.begin()) {
+    --it;
+  }
+  for (; it != zone_maps.end() && it->first_ordinal() < end_ordinal; ++it) {
+    rowid_t start = std::max<rowid_t>(first_ordinal, it->first_ordinal());
+    rowid_t end = std::min<rowid_t>(end_ordinal, it->first_ordinal() + it->num_rows());
+    if (start >= end || ZoneMapMayMatch(*it, pred)) {
+      continue;
+    }
+    BitmapChangeBits(sel->mutable_bitmap(), start - first_ordinal, end - start, false);
+    io_stats_.rows_pruned_by_zone_map += end - start;
+  }
+  return Status::OK();
+}
+
+Status CFileIterator::MayMatchAnyRow(const ColumnPredicate& pred, bool* may_match) {
+  RETURN_NOT_OK(reader_->Init());
+  *may_match = !reader_->has_zone_maps() || ZoneMapMayMatch(reader_->file_zone_map(), pred);
+  return Status::OK();
+}
+
+Status CFileIterator::GetBatchBlocks(size_t n, vector<CFileReader::BlockRead>* reads) {
+  CHECK(!prepared_) << "Should call FinishBatch() first";
+
+  // Only the positional index tells which blocks hold which rows before they
+  // are read. Blocks which are read ahead already need not be read again.
+  if (seeked_ != posidx_iter_.get() || prepared_blocks_.empty() || !batch_blocks_.empty() ||
+      (readahead_ && readahead_->reading_ahead())) {
+    return Status::OK();
+  }
+
+  // Like PrepareBatch(), find the blocks after the last prepared one until
+  // the one which holds the row after the batch.
+  const PreparedBlock* last = prepared_blocks_.back();
+  rowid_t end_idx = last_prepare_idx_ + n;
+  if (last->last_row_idx() >= end_idx) {
+    return Status::OK();
+  }
+  gscoped_ptr<IndexTreeIterator> iter(IndexTreeIterator::Create(reader_,
+                                                                reader_->posidx_root()));
+  tmp_buf_.clear();
+  KeyEncoderTraits<UINT32, faststring>::Encode(last->last_row_idx() + 1, &tmp_buf_);
+  RETURN_NOT_OK(iter->SeekAtOrBefore(Slice(tmp_buf_)));
+  if (iter->GetCurrentBlockPointer().offset() == last->dblk_ptr_.offset()) {
+    // The last prepared block is the last block of the file.
+    return Status::OK();
+  }
+
+  faststring end_key;
+  KeyEncoderTraits<UINT32, faststring>::Encode(end_idx, &end_key);
+  while (true) {
+    reads->emplace_back(reader_, iter->GetCurrentBlockPointer(), cache_control_);
+    if (!iter->HasNext()) {
+      break;
+    }
+    RETURN_NOT_OK(iter->Next());
+    // The keys of the positional index are the ordinals of the first rows
+    // of the blocks.
+    if (iter->GetCurrentKey().compare(Slice(end_key)) > 0) {
+      break;
+    }
+  }
+  return Status::OK();
+}
+
+void CFileIterator::AddBatchBlock(const BlockPointer& ptr, BlockHandle block) {
+  batch_blocks_.emplace_back(ptr, std::move(block));
+}
+
+Status CFileIterator::ScanSelected(const SelectionVector& sel, ColumnBlock *dst) {
+  CHECK(seeked_) << "not seeked";
+  DCHECK_EQ(sel.nrows(), dst->nrows());
 
-        // Set the ColumnBlock bitmap
-        remaining_dst.SetNullBits(this_batch, not_null);
+  // Repositioning a block decoder is not free, so very short runs of
+  // unselected rows are cheaper to decode than to skip.
+  const size_t kMinRowsToSkip = 16;
 
-        rem -= this_batch;
-        count -= this_batch;
-        pb->idx_in_block_ += this_batch;
-        remaining_dst.Advance(this_batch);
+  ColumnDataView remaining_dst(dst);
+
+  uint32_t rem = last_prepare_count_;
+  DCHECK_LE(rem, dst->nrows());
+
+  for (PreparedBlock *pb : prepared_blocks_) {
+    RewindIfNeeded(pb);
+
+    // The range of rows in 'sel' which are covered by this block.
+    size_t nrows = std::min(rem, pb->num_rows_in_block_ - pb->idx_in_block_);
+    size_t block_end = remaining_dst.first_row_index() + nrows;
+
+    while (remaining_dst.first_row_index() < block_end) {
+      size_t run_start = remaining_dst.first_row_index();
+      bool selected = sel.IsRowSelected(run_start);
+      size_t run_end;
+      if (!BitmapFindFirst(sel.bitmap(), run_start, block_end, !selected, &run_end)) {
+        run_end = block_end;
       }
-    } else {
-      // Fetch as many as we can from the current datablock.
-      size_t this_batch = rem;
-      RETURN_NOT_OK(pb->dblk_->CopyNextValues(&this_batch, &remaining_dst));
-      pb->needs_rewind_ = true;
-      DCHECK_LE(this_batch, rem);
+      size_t run_len = run_end - run_start;
 
-      // If the column is nullable, set all bits to true
-      if (dst->is_nullable()) {
-        remaining_dst.SetNullBits(this_batch, true);
+      if (!selected && run_len >= kMinRowsToSkip && TrySkipRowsInBlock(pb, run_len)) {
+        if (remaining_dst.is_nullable()) {
+          remaining_dst.SetNullBits(run_len, false);
+        }
+        remaining_dst.Advance(run_len);
+      } else {
+        RETURN_NOT_OK(ScanRowsInBlock(pb, run_len, &remaining_dst));
       }
+    }
+    rem -= nrows;
 
-      rem -= this_batch;
-      pb->idx_in_block_ += this_batch;
-      remaining_dst.Advance(this_batch);
+    if (rem == 0) {
+      break;
     }
+  }
 
-    // If we didn't fetch as many as requested, then it should
-    // be because the current data block ran out.
-    if (rem > 0) {
-      DCHECK_EQ(pb->dblk_->Count(), pb->dblk_->GetCurrentIndex()) <<
-        "dblk stopped yielding values before it was empty.";
-    } else {
+  DCHECK_EQ(rem, 0) << "Should have fetched exactly the number of prepared rows";
+  return Status::OK();
+}
+
+Status CFileIterator::ScanAndEvaluate(const ColumnPredicate& pred, SelectionVector* sel,
+                                      ColumnBlock *dst, bool* evaluated) {
+  CHECK(seeked_) << "not seeked";
+  DCHECK_EQ(sel->nrows(), dst->nrows());
+
+  // Only predicates which never match NULL can be evaluated on dictionary
+  // codes, and only if every prepared block holds codes: once the dictionary
+  // of a cfile is full, the following blocks hold plain strings instead.
+  *evaluated = false;
+  if (reader_->type_encoding_info()->encoding_type() != DICT_ENCODING ||
+      (pred.predicate_type() != PredicateType::Equality &&
+       pred.predicate_type() != PredicateType::Range &&
+       pred.predicate_type() != PredicateType::InList)) {
+    return ScanSelected(*sel, dst);
+  }
+  for (PreparedBlock *pb : prepared_blocks_) {
+    if (!down_cast<BinaryDictBlockDecoder*>(pb->dblk_.get())->HasCodeWords()) {
+      return ScanSelected(*sel, dst);
+    }
+  }
+
+  const SelectionVector* matching_codes;
+  RETURN_NOT_OK(GetMatchingDictCodes(pred, &matching_codes));
+
+  ColumnDataView remaining_dst(dst);
+
+  uint32_t rem = last_prepare_count_;
+  DCHECK_LE(rem, dst->nrows());
+
+  for (PreparedBlock *pb : prepared_blocks_) {
+    RewindIfNeeded(pb);
+
+    size_t nrows = std::min(rem, pb->num_rows_in_block_ - pb->idx_in_block_);
+    RETURN_NOT_OK(ScanRowsInBlock(pb, nrows, &remaining_dst, matching_codes, sel));
+    rem -= nrows;
+
+    if (rem == 0) {
       break;
     }
   }
 
   DCHECK_EQ(rem, 0) << "Should have fetched exactly the number of prepared rows";
+  io_stats_.cells_evaluated_on_dict_codes += last_prepare_count_;
+  *evaluated = true;
+  return Status::OK();
+}
+
+Status CFileIterator::GetMatchingDictCodes(const ColumnPredicate& pred,
+                                           const SelectionVector** codes) {
+  DCHECK(dict_decoder_);
+  if (!dict_pred_ || !(*dict_pred_ == pred)) {
+    // Evaluate the predicate on all the strings of the dictionary at once,
+    // as if they were a column block.
+    size_t num_codes = dict_decoder_->Count();
+    dict_pred_codes_.reset(new SelectionVector(num_codes));
+    dict_pred_codes_->SetAllTrue();
+    if (num_codes > 0) {
+      vector<Slice> dict_strings;
+      dict_strings.reserve(num_codes);
+      for (size_t i = 0; i < num_codes; i++) {
+        dict_strings.push_back(dict_decoder_->string_at_index(i));
+      }
+      ColumnBlock dict_block(pred.column().type_info(), nullptr, dict_strings.data(),
+                             num_codes, nullptr);
+      pred.Evaluate(dict_block, dict_pred_codes_.get());
+    }
+    dict_pred_.reset(new ColumnPredicate(pred));
+  }
+  *codes = dict_pred_codes_.get();
   return Status::OK();
 }
 
+bool CFileIterator::GetPinnedCells(PinnedCells* pinned) {
+  CHECK(seeked_) << "not seeked";
+
+  // The data blocks of nullable columns leave out the NULL cells, and a batch
+  // which spans several blocks is not contiguous.
+  if (reader_->is_nullable() || prepared_blocks_.empty()) {
+    return false;
+  }
+  PreparedBlock* pb = prepared_blocks_.front();
+  if (pb->rewind_idx_ + last_prepare_count_ > pb->num_rows_in_block_ ||
+      !pb->dblk_->GetCellsInPlace(pb->rewind_idx_, last_prepare_count_, &pinned->cells)) {
+    return false;
+  }
+  if (!pb->pinned_data_) {
+    pb->pinned_data_ = std::make_shared<BlockHandle>(std::move(pb->dblk_data_));
+  }
+  pinned->pin = pb->pinned_data_;
+  return true;
+}
+
 Status CFileIterator::CopyNextValues(size_t *n, ColumnBlock *cb) {
   RETURN_NOT_OK(PrepareBatch(n));
   RETURN_NOT_OK(Scan(cb));
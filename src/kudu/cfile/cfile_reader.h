@@ -18,7 +18,10 @@
 #ifndef KUDU_CFILE_CFILE_READER_H
 #define KUDU_CFILE_CFILE_READER_H
 
+#include <deque>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "kudu/common/columnblock.h"
@@ -27,6 +30,7 @@
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/block_handle.h"
 #include "kudu/cfile/block_compression.h"
+#include "kudu/cfile/block_pointer.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/index_btree.h"
 #include "kudu/cfile/type_encodings.h"
@@ -44,15 +48,21 @@
 #include "kudu/common/key_encoder.h"
 
 namespace kudu {
+
+class ColumnPredicate;
+class SelectionVector;
+
 namespace cfile {
 
 class BlockCache;
 class BlockDecoder;
+class BlockReadahead;
 class BlockPointer;
 class CFileHeaderPB;
 class CFileFooterPB;
 class CFileIterator;
 class BinaryPlainBlockDecoder;
+class ScratchMemory;
 
 class CFileReader {
  public:
@@ -81,6 +91,9 @@ class CFileReader {
 
   enum CacheControl {
     CACHE_BLOCK,
+    // Like CACHE_BLOCK, for blocks which are costly to lose, such as index
+    // and bloom filter blocks. See BlockCache::Insert().
+    CACHE_BLOCK_HIGH_PRIORITY,
     DONT_CACHE_BLOCK
   };
 
@@ -98,6 +111,28 @@ class CFileReader {
   Status ReadBlock(const BlockPointer &ptr, CacheControl cache_control,
                    BlockHandle *ret) const;
 
+  // A read of a block of a cfile with ReadBlocks().
+  struct BlockRead {
+    BlockRead(const CFileReader* reader, const BlockPointer& ptr, CacheControl cache_control)
+        : reader(reader),
+          ptr(ptr),
+          cache_control(cache_control) {
+    }
+
+    const CFileReader* reader;
+    BlockPointer ptr;
+    CacheControl cache_control;
+
+    // Set by ReadBlocks() to the block read.
+    BlockHandle block;
+  };
+
+  // Like ReadBlock(), for each of the given blocks, which may belong to
+  // different cfiles, all stored by 'block_manager'. The blocks which are
+  // not in the block cache are read with a single BlockManager::ReadBlocks()
+  // call, so that adjacent blocks may be read with a single I/O.
+  static Status ReadBlocks(fs::BlockManager* block_manager, std::vector<BlockRead>* reads);
+
   // Return the number of rows in this cfile.
   // This is assumed to be reasonably fast (i.e does not scan
   // the data)
@@ -125,6 +160,11 @@ class CFileReader {
     return type_encoding_info_;
   }
 
+  // Returns the encoding of the data block at the given pointer. This differs
+  // from type_encoding_info() only in files written with adaptively chosen
+  // encodings.
+  const TypeEncodingInfo *block_encoding_info(const BlockPointer &ptr) const;
+
   bool is_nullable() const {
     return footer().is_type_nullable();
   }
@@ -161,6 +201,22 @@ class CFileReader {
     return BlockPointer(footer().validx_info().root_block());
   }
 
+  // Return true if the file was written with zone maps.
+  bool has_zone_maps() const { return footer().has_file_zone_map(); }
+
+  // Return the zone map covering every value in the file.
+  const ZoneMapPB& file_zone_map() const {
+    DCHECK(has_zone_maps());
+    return footer().file_zone_map();
+  }
+
+  // Set '*zone_maps' to the zone maps of the data blocks of the file, in
+  // ordinal order. They are read from the file on the first call, and kept
+  // in memory for the lifetime of the reader.
+  //
+  // Must only be called if has_zone_maps().
+  Status GetBlockZoneMaps(const ZoneMapIndexPB** zone_maps);
+
   std::string ToString() const { return block_->id().ToString(); }
 
  private:
@@ -177,6 +233,35 @@ class CFileReader {
   Status ReadAndParseHeader();
   Status ReadAndParseFooter();
 
+  // Callback used in 'zone_maps_once_' to read the block zone maps.
+  Status ReadZoneMaps();
+
+  // Sets '*found' to true and '*ret' to the block at 'ptr' if it is in the
+  // block cache, or if its compressed data is in the compressed tier of the
+  // block cache, in which case it is decompressed and inserted into the block
+  // cache according to 'cache_control'.
+  Status LookupCachedBlock(const BlockPointer &ptr, CacheControl cache_control,
+                           BlockHandle *ret, bool *found) const;
+
+  // Allocates the memory into which to read the block at 'ptr'.
+  void AllocateBlockScratch(const BlockPointer &ptr, CacheControl cache_control,
+                            ScratchMemory *scratch) const;
+
+  // Sets '*ret' to the block at 'ptr', given the data read from disk, in
+  // 'scratch': decompresses it if needed, and inserts it in the block cache,
+  // and its compressed data in the compressed tier of the block cache,
+  // according to 'cache_control'.
+  Status FinishBlockRead(const BlockPointer &ptr, CacheControl cache_control,
+                         Slice block, ScratchMemory *scratch, BlockHandle *ret) const;
+
+  // Same as FinishBlockRead(), except that the compressed data is only
+  // inserted into the compressed tier if 'cache_compressed' is true, and that
+  // 'scratch' may be empty if 'block' points to compressed data owned by
+  // someone else.
+  Status DecompressAndCacheBlock(const BlockPointer &ptr, CacheControl cache_control,
+                                 Slice block, ScratchMemory *scratch,
+                                 bool cache_compressed, BlockHandle *ret) const;
+
   // Returns the memory usage of the object including the object itself.
   size_t memory_footprint() const;
 
@@ -189,13 +274,23 @@ class CFileReader {
   gscoped_ptr<CFileHeaderPB> header_;
   gscoped_ptr<CFileFooterPB> footer_;
 
+  // The codec for files compressed with a dictionary. Must outlive
+  // 'block_uncompressor_'.
+  gscoped_ptr<CompressionCodec> dictionary_codec_;
   gscoped_ptr<CompressedBlockDecoder> block_uncompressor_;
 
   const TypeInfo *type_info_;
   const TypeEncodingInfo *type_encoding_info_;
 
+  // The offsets from which data blocks are encoded differently than
+  // 'type_encoding_info_', in increasing order, with their encodings.
+  std::vector<std::pair<uint64_t, const TypeEncodingInfo *> > block_encoding_changes_;
+
   KuduOnceDynamic init_once_;
 
+  gscoped_ptr<ZoneMapIndexPB> block_zone_maps_;
+  KuduOnceDynamic zone_maps_once_;
+
   ScopedTrackedConsumption mem_consumption_;
 };
 
@@ -245,6 +340,87 @@ class ColumnIterator {
   // calls to Scan() will re-read the same values.
   virtual Status Scan(ColumnBlock *dst) = 0;
 
+  // Like Scan(), but only the rows which are set in 'sel' are guaranteed to
+  // be copied into 'dst'. Implementations may skip decoding runs of
+  // unselected rows; the contents of those cells are undefined, except that
+  // they will be marked NULL if 'dst' is nullable.
+  //
+  // 'sel' is indexed relative to the start of the prepared batch.
+  //
+  // The default implementation copies every row.
+  virtual Status ScanSelected(const SelectionVector& sel, ColumnBlock *dst) {
+    return Scan(dst);
+  }
+
+  // Like Scan(), but only the null bitmap of 'dst' is guaranteed to be
+  // filled in. The cell data is left in an undefined state. This does
+  // nothing if 'dst' is not nullable.
+  //
+  // The default implementation copies every row.
+  virtual Status ScanNullBitmap(ColumnBlock *dst) {
+    return Scan(dst);
+  }
+
+  // Like ScanSelected(), but also evaluates 'pred' on the rows as they are
+  // scanned, clearing the bits in 'sel' of those which do not match. The
+  // cells of rows which are not selected in the end are undefined, as in
+  // ScanSelected().
+  //
+  // Sets '*evaluated' to false if the predicate could not be evaluated
+  // during the scan, in which case the caller must evaluate it on 'dst'.
+  //
+  // The default implementation never evaluates the predicate.
+  virtual Status ScanAndEvaluate(const ColumnPredicate& pred, SelectionVector* sel,
+                                 ColumnBlock *dst, bool* evaluated) {
+    *evaluated = false;
+    return ScanSelected(*sel, dst);
+  }
+
+  // Clear the bits in 'sel' of the rows which the zone maps of the underlying
+  // data show cannot match 'pred', without reading any data blocks. 'sel'
+  // covers the sel->nrows() rows starting at ordinal 'first_ordinal'.
+  //
+  // The default implementation clears nothing.
+  virtual Status EvaluateZoneMaps(rowid_t first_ordinal, const ColumnPredicate& pred,
+                                  SelectionVector* sel) {
+    return Status::OK();
+  }
+
+  // Set '*may_match' to false if the zone map of the underlying data as a
+  // whole shows that no row can match 'pred'.
+  //
+  // The default implementation always sets it to true.
+  virtual Status MayMatchAnyRow(const ColumnPredicate& pred, bool* may_match) {
+    *may_match = true;
+    return Status::OK();
+  }
+
+  // If the cells of the prepared batch are stored in the same in-memory
+  // format as they are scanned into a ColumnBlock, sets '*pinned' to them and
+  // returns true, so that they may be referenced rather than copied. They stay
+  // valid for as long as 'pinned->pin' lives, even once the batch is finished.
+  //
+  // The default implementation returns false.
+  virtual bool GetPinnedCells(PinnedCells* pinned) {
+    return false;
+  }
+
+  // Append to 'reads' the data blocks which PrepareBatch() would have to read
+  // to prepare 'n' rows, so that the caller may read the blocks of several
+  // columns at once with CFileReader::ReadBlocks(). The blocks read must then
+  // be handed back with AddBatchBlock(), in the same order, before
+  // PrepareBatch() is called.
+  //
+  // The default implementation appends nothing.
+  virtual Status GetBatchBlocks(size_t n, std::vector<CFileReader::BlockRead>* reads) {
+    return Status::OK();
+  }
+
+  // Hand back a block read as requested by GetBatchBlocks().
+  virtual void AddBatchBlock(const BlockPointer& ptr, BlockHandle block) {
+    LOG(DFATAL) << "no blocks to read";
+  }
+
   // Finish processing the current batch, advancing the iterators
   // such that the next call to PrepareBatch() will start where the previous
   // batch left off.
@@ -348,6 +524,42 @@ class CFileIterator : public ColumnIterator {
   // calls to Scan() will re-read the same values.
   Status Scan(ColumnBlock *dst) OVERRIDE;
 
+  // Copy the selected values into the prepared column block, skipping over
+  // runs of unselected rows without decoding them where possible.
+  // See ColumnIterator::ScanSelected().
+  Status ScanSelected(const SelectionVector& sel, ColumnBlock *dst) OVERRIDE;
+
+  // Fill in the null bitmap of the prepared column block without decoding
+  // any values. See ColumnIterator::ScanNullBitmap().
+  Status ScanNullBitmap(ColumnBlock *dst) OVERRIDE;
+
+  // If the prepared blocks are dictionary-coded, evaluate the predicate on
+  // the dictionary codes, copying only the strings of the matching rows.
+  // See ColumnIterator::ScanAndEvaluate().
+  Status ScanAndEvaluate(const ColumnPredicate& pred, SelectionVector* sel,
+                         ColumnBlock *dst, bool* evaluated) OVERRIDE;
+
+  // Use the block zone maps of the file, if it has them, to rule out rows.
+  // See ColumnIterator::EvaluateZoneMaps().
+  Status EvaluateZoneMaps(rowid_t first_ordinal, const ColumnPredicate& pred,
+                          SelectionVector* sel) OVERRIDE;
+
+  // Use the file zone map, if there is one, to rule out the whole file.
+  // See ColumnIterator::MayMatchAnyRow().
+  Status MayMatchAnyRow(const ColumnPredicate& pred, bool* may_match) OVERRIDE;
+
+  // Pins the data block of the prepared batch if it is plain-encoded, has no
+  // NULLs and holds the whole batch. See ColumnIterator::GetPinnedCells().
+  bool GetPinnedCells(PinnedCells* pinned) OVERRIDE;
+
+  // Use the positional index to find the data blocks which the batch needs,
+  // unless they are already being read ahead.
+  // See ColumnIterator::GetBatchBlocks().
+  Status GetBatchBlocks(size_t n, std::vector<CFileReader::BlockRead>* reads) OVERRIDE;
+
+  // See ColumnIterator::AddBatchBlock().
+  void AddBatchBlock(const BlockPointer& ptr, BlockHandle block) OVERRIDE;
+
   // Finish processing the current batch, advancing the iterators
   // such that the next call to PrepareBatch() will start where the previous
   // batch left off.
@@ -376,6 +588,10 @@ class CFileIterator : public ColumnIterator {
     BlockHandle dblk_data_;
     gscoped_ptr<BlockDecoder> dblk_;
 
+    // Once cells of the block have been pinned by GetPinnedCells(),
+    // 'dblk_data_' is moved here, so that the pins may outlive the block.
+    std::shared_ptr<BlockHandle> pinned_data_;
+
     // The rowid of the first row in this block.
     rowid_t first_row_idx() const {
       return dblk_->GetFirstRowId();
@@ -414,6 +630,31 @@ class CFileIterator : public ColumnIterator {
   // Seek the given PreparedBlock to the given index within it.
   void SeekToPositionInBlock(PreparedBlock *pb, uint32_t idx_in_block);
 
+  // Rewind the given PreparedBlock to its saved position if any values have
+  // been read from it since it was prepared.
+  void RewindIfNeeded(PreparedBlock *pb);
+
+  // Decode the next 'nrows' rows of the given PreparedBlock into 'dst',
+  // advancing both. 'nrows' must not exceed the number of rows remaining
+  // in the block.
+  //
+  // If 'matching_codes' is set, the block must hold dictionary codes, and
+  // the rows whose codes are not set in 'matching_codes' (or which are NULL)
+  // are cleared from 'sel', which is indexed like the column block under
+  // 'dst'. Only the strings of the rows left selected are copied.
+  Status ScanRowsInBlock(PreparedBlock *pb, size_t nrows, ColumnDataView *dst,
+                         const SelectionVector* matching_codes = nullptr,
+                         SelectionVector* sel = nullptr);
+
+  // Set '*codes' to the dictionary codes whose strings match 'pred', with a
+  // bit per string in the dictionary. This is worked out once per predicate.
+  Status GetMatchingDictCodes(const ColumnPredicate& pred, const SelectionVector** codes);
+
+  // Attempt to advance the given PreparedBlock by 'nrows' rows without
+  // decoding them. Returns false, leaving the block untouched, if doing so
+  // would position the block decoder past its last value.
+  bool TrySkipRowsInBlock(PreparedBlock *pb, size_t nrows);
+
   // Read the data block currently pointed to by idx_iter_
   // into the given PreparedBlock structure.
   //
@@ -438,6 +679,11 @@ class CFileIterator : public ColumnIterator {
   gscoped_ptr<BinaryPlainBlockDecoder> dict_decoder_;
   BlockHandle dict_block_handle_;
 
+  // The last predicate evaluated on the dictionary, and the codes of the
+  // strings which match it. See GetMatchingDictCodes().
+  gscoped_ptr<ColumnPredicate> dict_pred_;
+  gscoped_ptr<SelectionVector> dict_pred_codes_;
+
   // The currently in-use index iterator. This is equal to either
   // posidx_iter_.get(), validx_iter_.get(), or NULL if not seeked.
   IndexTreeIterator *seeked_;
@@ -456,6 +702,14 @@ class CFileIterator : public ColumnIterator {
   // Whether this iterator will ask the cfile to cache the blocks it requests or not.
   const CFileReader::CacheControl cache_control_;
 
+  // Reads data blocks ahead of sequential scans, or NULL if readahead is
+  // disabled.
+  gscoped_ptr<BlockReadahead> readahead_;
+
+  // The data blocks read with the blocks of other columns for the next batch,
+  // in file order. See GetBatchBlocks().
+  std::deque<std::pair<BlockPointer, BlockHandle> > batch_blocks_;
+
   // RowID of the current prepared batch, if prepared_ is true.
   // Otherwise, the RowID of the next batch that will be prepared.
   rowid_t last_prepare_idx_;
@@ -57,6 +57,11 @@ struct WriterOptions {
   // Whether the file needs a value index
   bool write_validx;
 
+  // Whether to write a zone map (min/max values and null count) for each
+  // data block, and for the file as a whole. Ignored if the
+  // --cfile_write_zone_maps flag is false.
+  bool write_zone_maps;
+
   // Column storage attributes.
   //
   // Default: all default values as specified in the constructor in
@@ -17,6 +17,7 @@
 
 #include "kudu/cfile/cfile_writer.h"
 
+#include <algorithm>
 #include <glog/logging.h>
 #include <string>
 #include <utility>
@@ -27,16 +28,21 @@
 #include "kudu/cfile/type_encodings.h"
 #include "kudu/common/key_encoder.h"
 #include "kudu/gutil/endian.h"
+#include "kudu/util/bitmap.h"
 #include "kudu/util/coding.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/hexdump.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/pb_util.h"
 
 using google::protobuf::RepeatedPtrField;
 using kudu::fs::ScopedWritableBlockCloser;
 using kudu::fs::WritableBlock;
+using std::make_pair;
+using std::pair;
 using std::string;
+using std::vector;
 
 DEFINE_int32(cfile_default_block_size, 256*1024, "The default block size to use in cfiles");
 TAG_FLAG(cfile_default_block_size, advanced);
@@ -45,6 +51,18 @@ DEFINE_string(cfile_default_compression_codec, "none",
               "Default cfile block compression codec.");
 TAG_FLAG(cfile_default_compression_codec, advanced);
 
+DEFINE_int32(cfile_compression_dictionary_size, 0,
+             "The maximum size of the dictionary which cfiles compressed with codecs "
+             "supporting dictionaries (currently zstd) are compressed with. The "
+             "dictionary is trained from the first data blocks of each file. "
+             "0 disables dictionaries.");
+TAG_FLAG(cfile_compression_dictionary_size, experimental);
+
+DEFINE_int32(cfile_compression_dictionary_training_blocks, 8,
+             "The number of data blocks at the start of each cfile to train its "
+             "compression dictionary on. See --cfile_compression_dictionary_size.");
+TAG_FLAG(cfile_compression_dictionary_training_blocks, experimental);
+
 // The default value is optimized for the case where:
 // 1. the cfile blocks are colocated with the WALs.
 // 2. The underlying hardware is a spinning disk.
@@ -57,6 +75,31 @@ DEFINE_string(cfile_do_on_finish, "close",
               "Possible values are 'close', 'flush', or 'nothing'.");
 TAG_FLAG(cfile_do_on_finish, experimental);
 
+DEFINE_bool(cfile_write_zone_maps, true,
+            "Whether to write per-block min/max zone maps in cfiles which are "
+            "configured to have them, so that scans can skip blocks and rowsets "
+            "which cannot match their predicates.");
+TAG_FLAG(cfile_write_zone_maps, advanced);
+
+DEFINE_bool(cfile_adaptive_encoding, false,
+            "Whether to pick the encoding of columns configured with AUTO_ENCODING "
+            "by trial-encoding their data with each encoding supported for their type, "
+            "instead of using the default encoding of the type.");
+TAG_FLAG(cfile_adaptive_encoding, experimental);
+
+DEFINE_double(cfile_adaptive_encoding_size_tolerance, 0.05,
+              "When picking encodings adaptively, the fraction by which an encoding "
+              "which is cheaper to decode may be larger than the smallest one and still "
+              "be picked over it. 0 always picks the smallest encoding.");
+TAG_FLAG(cfile_adaptive_encoding_size_tolerance, experimental);
+
+DEFINE_int32(cfile_adaptive_encoding_retrial_blocks, 64,
+             "When picking encodings adaptively, the number of data blocks after which "
+             "the encodings are trialed again, in case the data has changed. They are "
+             "also trialed again sooner if a data block encodes notably worse than the "
+             "trial predicted.");
+TAG_FLAG(cfile_adaptive_encoding_retrial_blocks, experimental);
+
 namespace kudu {
 namespace cfile {
 
@@ -65,10 +108,29 @@ const char kMagicString[] = "kuducfil";
 static const size_t kBlockSizeLimit = 16 * 1024 * 1024; // 16MB
 static const size_t kMinBlockSize = 512;
 
+// When picking encodings adaptively, the encodings are trialed again after a
+// data block which takes this many times more space per value than the
+// trial predicted.
+static const double kRetrialSizeRatio = 1.5;
+
 static CompressionType GetDefaultCompressionCodec() {
   return GetCompressionCodecType(FLAGS_cfile_default_compression_codec);
 }
 
+// A rough ranking of how expensive encodings are to decode, used to prefer
+// cheaper encodings among those of about the same size.
+static int RelativeDecodeCost(EncodingType encoding) {
+  switch (encoding) {
+    case PLAIN_ENCODING: return 0;
+    case RLE: return 1;
+    case DELTA_BITPACKED: return 1;
+    case BIT_SHUFFLE: return 2;
+    case DICT_ENCODING: return 2;
+    case GROUP_VARINT: return 2;
+    default: return 3;
+  }
+}
+
 ////////////////////////////////////////////////////////////
 // Options
 ////////////////////////////////////////////////////////////
@@ -76,7 +138,8 @@ WriterOptions::WriterOptions()
   : index_block_size(32*1024),
     block_restart_interval(16),
     write_posidx(false),
-    write_validx(false) {
+    write_validx(false),
+    write_zone_maps(false) {
 }
 
 
@@ -96,8 +159,16 @@ CFileWriter::CFileWriter(const WriterOptions &options,
     is_nullable_(is_nullable),
     typeinfo_(typeinfo),
     key_encoder_(nullptr),
+    adaptive_encoding_(false),
+    trialing_(false),
+    trial_rows_(0),
+    trial_bytes_(0),
+    trial_bytes_per_value_(0),
+    blocks_since_trial_(0),
+    sampling_compression_dictionary_(false),
     state_(kWriterInitialized) {
   EncodingType encoding = options_.storage_attributes.encoding;
+  adaptive_encoding_ = encoding == AUTO_ENCODING && FLAGS_cfile_adaptive_encoding;
   Status s = TypeEncodingInfo::Get(typeinfo_, encoding, &type_encoding_info_);
   if (!s.ok()) {
     // TODO: we should somehow pass some contextual info about the
@@ -108,6 +179,7 @@ CFileWriter::CFileWriter(const WriterOptions &options,
                               &type_encoding_info_);
     CHECK_OK(s);
   }
+  block_encoding_info_ = type_encoding_info_;
 
   compression_ = options_.storage_attributes.compression;
   if (compression_ == DEFAULT_COMPRESSION) {
@@ -134,6 +206,11 @@ CFileWriter::CFileWriter(const WriterOptions &options,
     validx_builder_.reset(new IndexTreeBuilder(&options_,
                                                this));
   }
+
+  if (options.write_zone_maps && FLAGS_cfile_write_zone_maps) {
+    block_zone_map_builder_.reset(new ZoneMapBuilder(typeinfo_));
+    file_zone_map_builder_.reset(new ZoneMapBuilder(typeinfo_));
+  }
 }
 
 CFileWriter::~CFileWriter() {
@@ -148,6 +225,8 @@ Status CFileWriter::Start() {
     const CompressionCodec* codec;
     RETURN_NOT_OK(GetCompressionCodec(compression_, &codec));
     block_compressor_ .reset(new CompressedBlockBuilder(codec, kBlockSizeLimit));
+    sampling_compression_dictionary_ = compression_ == ZSTD &&
+        FLAGS_cfile_compression_dictionary_size > 0;
   }
 
   CFileHeaderPB header;
@@ -169,9 +248,16 @@ Status CFileWriter::Start() {
   RETURN_NOT_OK_PREPEND(block_->Append(Slice(buf)), "Couldn't write header");
   off_ += buf.size();
 
-  BlockBuilder *bb;
-  RETURN_NOT_OK(type_encoding_info_->CreateBlockBuilder(&bb, &options_));
-  data_block_.reset(bb);
+  if (adaptive_encoding_) {
+    // The data block builder is created once the first trial picks an
+    // encoding.
+    trial_arena_.reset(new Arena(1024, options_.storage_attributes.cfile_block_size));
+    trialing_ = true;
+  } else {
+    BlockBuilder *bb;
+    RETURN_NOT_OK(type_encoding_info_->CreateBlockBuilder(&bb, &options_));
+    data_block_.reset(bb);
+  }
 
   if (is_nullable_) {
     size_t nrows = ((options_.storage_attributes.cfile_block_size + typeinfo_->size() - 1) /
@@ -197,6 +283,9 @@ Status CFileWriter::FinishAndReleaseBlock(ScopedWritableBlockCloser* closer) {
     "Bad state for Finish(): " << state_;
 
   // Write out any pending values as the last data block.
+  if (trialing_) {
+    RETURN_NOT_OK(FinishTrial());
+  }
   RETURN_NOT_OK(FinishCurDataBlock());
 
   state_ = kWriterFinished;
@@ -208,6 +297,10 @@ Status CFileWriter::FinishAndReleaseBlock(ScopedWritableBlockCloser* closer) {
   footer.set_encoding(type_encoding_info_->encoding_type());
   footer.set_num_values(value_count_);
   footer.set_compression(compression_);
+  footer.mutable_data_block_encodings()->Swap(&data_block_encodings_);
+  if (compression_dictionary_.size() > 0) {
+    footer.set_compression_dictionary(compression_dictionary_.ToString());
+  }
 
   // Write out any pending positional index blocks.
   if (options_.write_posidx) {
@@ -223,6 +316,10 @@ Status CFileWriter::FinishAndReleaseBlock(ScopedWritableBlockCloser* closer) {
     footer.mutable_validx_info()->CopyFrom(validx_info);
   }
 
+  if (block_zone_map_builder_ != nullptr) {
+    RETURN_NOT_OK_PREPEND(WriteZoneMaps(&footer), "Couldn't write zone maps");
+  }
+
   // Optionally append extra information to the end of cfile.
   // Example: dictionary block for dictionary encoding
   RETURN_NOT_OK(data_block_->AppendExtraInfo(this, &footer));
@@ -284,6 +381,10 @@ void CFileWriter::FlushMetadataToPB(RepeatedPtrField<FileMetadataPairPB> *field)
 Status CFileWriter::AppendEntries(const void *entries, size_t count) {
   DCHECK(!is_nullable_);
 
+  if (trialing_) {
+    return AppendTrialEntries(nullptr, 0, entries, count);
+  }
+
   int rem = count;
 
   const uint8_t *ptr = reinterpret_cast<const uint8_t *>(entries);
@@ -292,12 +393,18 @@ Status CFileWriter::AppendEntries(const void *entries, size_t count) {
     int n = data_block_->Add(ptr, rem);
     DCHECK_GE(n, 0);
 
+    if (block_zone_map_builder_ != nullptr) {
+      block_zone_map_builder_->AddValues(ptr, n);
+    }
     ptr += typeinfo_->size() * n;
     rem -= n;
     value_count_ += n;
 
     if (data_block_->IsBlockFull(options_.storage_attributes.cfile_block_size)) {
       RETURN_NOT_OK(FinishCurDataBlock());
+      if (trialing_) {
+        return AppendTrialEntries(nullptr, 0, ptr, rem);
+      }
     }
   }
 
@@ -310,6 +417,10 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
                                           size_t count) {
   DCHECK(is_nullable_ && bitmap != nullptr);
 
+  if (trialing_) {
+    return AppendTrialEntries(bitmap, 0, entries, count);
+  }
+
   const uint8_t *ptr = reinterpret_cast<const uint8_t *>(entries);
 
   size_t nblock;
@@ -323,17 +434,27 @@ Status CFileWriter::AppendNullableEntries(const uint8_t *bitmap,
         DCHECK_GE(n, 0);
 
         null_bitmap_builder_->AddRun(true, n);
+        if (block_zone_map_builder_ != nullptr) {
+          block_zone_map_builder_->AddValues(ptr, n);
+        }
         ptr += n * typeinfo_->size();
         value_count_ += n;
         rem -= n;
 
         if (data_block_->IsBlockFull(options_.storage_attributes.cfile_block_size)) {
           RETURN_NOT_OK(FinishCurDataBlock());
+          if (trialing_) {
+            size_t row = (ptr - reinterpret_cast<const uint8_t *>(entries)) / typeinfo_->size();
+            return AppendTrialEntries(bitmap, row, ptr, count - row);
+          }
         }
 
       } while (rem > 0);
     } else {
       null_bitmap_builder_->AddRun(false, nblock);
+      if (block_zone_map_builder_ != nullptr) {
+        block_zone_map_builder_->AddNulls(nblock);
+      }
       ptr += nblock * typeinfo_->size();
       value_count_ += nblock;
     }
@@ -361,6 +482,18 @@ Status CFileWriter::FinishCurDataBlock() {
   Slice data = data_block_->Finish(first_elem_ord);
   VLOG(2) << " actual size=" << data.size();
 
+  // The dictionary of a dictionary-encoded file is shared by all of its data
+  // blocks, and falls back to plain encoding by itself, so such files keep
+  // their encoding.
+  if (adaptive_encoding_ && type_encoding_info_->encoding_type() != DICT_ENCODING) {
+    double bytes_per_value = data_block_->Count() == 0 ? 0 :
+        static_cast<double>(data.size()) / data_block_->Count();
+    if (++blocks_since_trial_ >= FLAGS_cfile_adaptive_encoding_retrial_blocks ||
+        bytes_per_value > trial_bytes_per_value_ * kRetrialSizeRatio) {
+      trialing_ = true;
+    }
+  }
+
   uint8_t key_tmp_space[typeinfo_->size()];
 
   if (validx_builder_ != nullptr) {
@@ -384,15 +517,245 @@ Status CFileWriter::FinishCurDataBlock() {
   Status s = AppendRawBlock(v, first_elem_ord,
                             reinterpret_cast<const void *>(key_tmp_space),
                             "data block");
+  if (s.ok() && sampling_compression_dictionary_) {
+    s = SampleForCompressionDictionary(v);
+  }
 
   if (is_nullable_) {
     null_bitmap_builder_->Reset();
   }
   data_block_->Reset();
 
+  if (block_zone_map_builder_ != nullptr) {
+    DCHECK_EQ(block_zone_map_builder_->num_rows(), num_elems_in_block);
+    block_zone_map_builder_->ToPB(first_elem_ord, block_zone_maps_.add_block_zone_maps());
+    file_zone_map_builder_->Merge(*block_zone_map_builder_);
+    block_zone_map_builder_->Reset();
+  }
+
   return s;
 }
 
+Status CFileWriter::AppendTrialEntries(const uint8_t* bitmap, size_t bitmap_offset,
+                                       const void* entries, size_t count) {
+  DCHECK(trialing_);
+  const size_t size = typeinfo_->size();
+  size_t first_cell = trial_cells_.size();
+  trial_cells_.append(entries, count * size);
+
+  if (is_nullable_) {
+    trial_null_bitmap_.resize(BitmapSize(trial_rows_ + count));
+    BitmapIterator bmap_iter(bitmap, bitmap_offset + count);
+    bmap_iter.SeekTo(bitmap_offset);
+    size_t row = trial_rows_;
+    size_t nblock;
+    bool not_null = false;
+    while ((nblock = bmap_iter.Next(&not_null)) > 0) {
+      BitmapChangeBits(trial_null_bitmap_.data(), row, nblock, not_null);
+      row += nblock;
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (is_nullable_ && !BitmapTest(trial_null_bitmap_.data(), trial_rows_ + i)) {
+      continue;
+    }
+    trial_bytes_ += size;
+    if (typeinfo_->physical_type() == BINARY) {
+      // Copy the data the Slice points to, which only needs to outlive this call.
+      Slice* cell = reinterpret_cast<Slice*>(&trial_cells_[first_cell + i * size]);
+      if (!trial_arena_->RelocateSlice(*cell, cell)) {
+        return Status::RuntimeError("unable to buffer values to trial encodings on");
+      }
+      trial_bytes_ += cell->size();
+    }
+  }
+  trial_rows_ += count;
+
+  if (trial_bytes_ >= options_.storage_attributes.cfile_block_size) {
+    return FinishTrial();
+  }
+  return Status::OK();
+}
+
+Status CFileWriter::FinishTrial() {
+  DCHECK(trialing_);
+  trialing_ = false;
+
+  vector<EncodingType> encodings = TypeEncodingInfo::GetSupportedEncodings(typeinfo_);
+  if (data_block_) {
+    // Dictionary encoding can't be started partway through the file.
+    encodings.erase(std::remove(encodings.begin(), encodings.end(), DICT_ENCODING),
+                    encodings.end());
+  }
+  const TypeEncodingInfo* chosen = block_encoding_info_;
+  if (trial_rows_ > 0 || !data_block_) {
+    RETURN_NOT_OK(ChooseEncoding(encodings, &chosen, &trial_bytes_per_value_));
+  }
+  blocks_since_trial_ = 0;
+
+  if (chosen != block_encoding_info_ || !data_block_) {
+    if (!data_block_) {
+      type_encoding_info_ = chosen;
+    } else {
+      DCHECK_EQ(0, data_block_->Count());
+      DataBlockEncodingPB* change = data_block_encodings_.Add();
+      change->set_first_block_offset(off_);
+      change->set_encoding(chosen->encoding_type());
+    }
+    VLOG(1) << "Encoding data blocks from offset " << off_ << " with "
+            << EncodingType_Name(chosen->encoding_type());
+    BlockBuilder *bb;
+    RETURN_NOT_OK(chosen->CreateBlockBuilder(&bb, &options_));
+    data_block_.reset(bb);
+    block_encoding_info_ = chosen;
+  }
+
+  // Append the buffered values for real. This may finish a data block which
+  // starts another trial, so the buffers are handed over first.
+  faststring cells;
+  cells.assign_copy(trial_cells_.data(), trial_cells_.size());
+  faststring null_bitmap;
+  null_bitmap.assign_copy(trial_null_bitmap_.data(), trial_null_bitmap_.size());
+  size_t rows = trial_rows_;
+  gscoped_ptr<Arena> arena(trial_arena_.release());
+  trial_arena_.reset(new Arena(1024, options_.storage_attributes.cfile_block_size));
+  trial_cells_.clear();
+  trial_null_bitmap_.clear();
+  trial_rows_ = 0;
+  trial_bytes_ = 0;
+
+  if (is_nullable_) {
+    return AppendNullableEntries(null_bitmap.data(), cells.data(), rows);
+  }
+  return AppendEntries(cells.data(), rows);
+}
+
+Status CFileWriter::ChooseEncoding(const vector<EncodingType>& encodings,
+                                   const TypeEncodingInfo** chosen,
+                                   double* bytes_per_value) {
+  DCHECK(!encodings.empty());
+  const size_t size = typeinfo_->size();
+
+  // The block builders only take the non-null values.
+  faststring values;
+  if (is_nullable_) {
+    for (size_t i = 0; i < trial_rows_; i++) {
+      if (BitmapTest(trial_null_bitmap_.data(), i)) {
+        values.append(&trial_cells_[i * size], size);
+      }
+    }
+  } else {
+    values.assign_copy(trial_cells_.data(), trial_cells_.size());
+  }
+  size_t num_values = values.size() / size;
+
+  if (num_values == 0) {
+    // Nothing to go by, so use the default encoding.
+    *bytes_per_value = 0;
+    return TypeEncodingInfo::Get(typeinfo_, encodings[0], chosen);
+  }
+
+  vector<pair<const TypeEncodingInfo*, double> > sizes;
+  double smallest = 0;
+  for (EncodingType encoding : encodings) {
+    const TypeEncodingInfo* info;
+    RETURN_NOT_OK(TypeEncodingInfo::Get(typeinfo_, encoding, &info));
+    BlockBuilder* bb;
+    RETURN_NOT_OK(info->CreateBlockBuilder(&bb, &options_));
+    gscoped_ptr<BlockBuilder> builder(bb);
+    size_t added = 0;
+    while (added < num_values) {
+      int n = builder->Add(&values[added * size], num_values - added);
+      if (n == 0) break;
+      added += n;
+    }
+    if (added == 0) {
+      continue;
+    }
+    size_t encoded_size = builder->Finish(0).size() + builder->ExtraInfoSize();
+    double per_value = static_cast<double>(encoded_size) / added;
+    VLOG(2) << "Trial encoding " << EncodingType_Name(encoding) << ": "
+            << per_value << " bytes per value";
+    if (sizes.empty() || per_value < smallest) {
+      smallest = per_value;
+    }
+    sizes.push_back(make_pair(info, per_value));
+  }
+  if (sizes.empty()) {
+    return Status::IllegalState("no encoding could encode the values");
+  }
+
+  // Among the encodings close enough to the smallest, pick the one which is
+  // cheapest to decode, then the smallest, then the earliest.
+  const double limit = smallest * (1 + FLAGS_cfile_adaptive_encoding_size_tolerance);
+  const pair<const TypeEncodingInfo*, double>* best = nullptr;
+  for (const auto& entry : sizes) {
+    if (entry.second > limit) {
+      continue;
+    }
+    if (best == nullptr) {
+      best = &entry;
+      continue;
+    }
+    int cost = RelativeDecodeCost(entry.first->encoding_type());
+    int best_cost = RelativeDecodeCost(best->first->encoding_type());
+    if (cost < best_cost || (cost == best_cost && entry.second < best->second)) {
+      best = &entry;
+    }
+  }
+  *chosen = best->first;
+  *bytes_per_value = best->second;
+  return Status::OK();
+}
+
+Status CFileWriter::SampleForCompressionDictionary(const vector<Slice>& data_slices) {
+  size_t size = 0;
+  for (const Slice& data : data_slices) {
+    dictionary_samples_.append(data.data(), data.size());
+    size += data.size();
+  }
+  dictionary_sample_sizes_.push_back(size);
+  if (dictionary_sample_sizes_.size() <
+      static_cast<size_t>(FLAGS_cfile_compression_dictionary_training_blocks)) {
+    return Status::OK();
+  }
+
+  sampling_compression_dictionary_ = false;
+  vector<Slice> samples;
+  const uint8_t* sample = dictionary_samples_.data();
+  for (size_t sample_size : dictionary_sample_sizes_) {
+    samples.push_back(Slice(sample, sample_size));
+    sample += sample_size;
+  }
+  Status s = TrainCompressionDictionary(compression_, samples,
+                                        FLAGS_cfile_compression_dictionary_size,
+                                        &compression_dictionary_);
+  dictionary_samples_.clear();
+  dictionary_sample_sizes_.clear();
+  if (!s.ok()) {
+    // The file is still readable without a dictionary, just bigger.
+    VLOG(1) << "Not compressing " << ToString() << " with a dictionary: " << s.ToString();
+    return Status::OK();
+  }
+  RETURN_NOT_OK(CreateDictionaryCompressionCodec(compression_, compression_dictionary_,
+                                                 &dictionary_codec_));
+  block_compressor_.reset(new CompressedBlockBuilder(dictionary_codec_.get(), kBlockSizeLimit));
+  return Status::OK();
+}
+
+Status CFileWriter::WriteZoneMaps(CFileFooterPB* footer) {
+  faststring buf;
+  if (!pb_util::SerializeToString(block_zone_maps_, &buf)) {
+    return Status::Corruption("unable to serialize zone maps");
+  }
+  BlockPointer ptr;
+  RETURN_NOT_OK(AddBlock({ Slice(buf) }, &ptr, "zone map index"));
+  ptr.CopyToPB(footer->mutable_zone_map_index_ptr());
+  file_zone_map_builder_->ToPB(0, footer->mutable_file_zone_map());
+  return Status::OK();
+}
+
 Status CFileWriter::AppendRawBlock(const vector<Slice> &data_slices,
                                    size_t ordinal_pos,
                                    const void *validx_key,
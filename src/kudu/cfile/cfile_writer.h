@@ -30,6 +30,7 @@
 #include "kudu/cfile/cfile.pb.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/type_encodings.h"
+#include "kudu/cfile/zone_map.h"
 #include "kudu/common/key_encoder.h"
 #include "kudu/common/types.h"
 #include "kudu/fs/block_id.h"
@@ -174,6 +175,31 @@ class CFileWriter {
 
   Status FinishCurDataBlock();
 
+  // Buffer 'count' values, and the bits of 'bitmap' from 'bitmap_offset' on
+  // if the file is nullable, to trial encodings on. Ends the trial once a
+  // data block's worth of values has been buffered.
+  Status AppendTrialEntries(const uint8_t* bitmap, size_t bitmap_offset,
+                            const void* entries, size_t count);
+
+  // Pick the encoding for the buffered trial values, then append them to the
+  // file with it.
+  Status FinishTrial();
+
+  // Trial-encode the buffered values with each of 'encodings', and set
+  // '*chosen' to the encoding which suits them best, and '*bytes_per_value'
+  // to its encoded size per non-null value.
+  Status ChooseEncoding(const vector<EncodingType>& encodings,
+                        const TypeEncodingInfo** chosen,
+                        double* bytes_per_value);
+
+  // Keep a copy of the data block made of 'data_slices' to train the
+  // compression dictionary on, and train it once enough have been kept.
+  Status SampleForCompressionDictionary(const vector<Slice>& data_slices);
+
+  // Append the zone maps of the data blocks to the file, and fill in the
+  // zone map fields of 'footer'.
+  Status WriteZoneMaps(CFileFooterPB* footer);
+
   // Flush the current unflushed_metadata_ entries into the given protobuf
   // field, clearing the buffer.
   void FlushMetadataToPB(google::protobuf::RepeatedPtrField<FileMetadataPairPB> *field);
@@ -193,7 +219,11 @@ class CFileWriter {
   bool is_nullable_;
   CompressionType compression_;
   const TypeInfo* typeinfo_;
+
+  // The encoding of the first data block, which is recorded in the footer,
+  // and the encoding of the current data block.
   const TypeEncodingInfo* type_encoding_info_;
+  const TypeEncodingInfo* block_encoding_info_;
 
   // The key-encoder. Only set if the writer is writing an embedded
   // value index.
@@ -211,6 +241,52 @@ class CFileWriter {
   gscoped_ptr<NullBitmapBuilder> null_bitmap_builder_;
   gscoped_ptr<CompressedBlockBuilder> block_compressor_;
 
+  // Whether data blocks are being kept to train a compression dictionary on,
+  // the kept blocks, and their sizes.
+  bool sampling_compression_dictionary_;
+  faststring dictionary_samples_;
+  vector<size_t> dictionary_sample_sizes_;
+
+  // The trained compression dictionary, and the codec compressing with it.
+  // Only set once the dictionary has been trained.
+  faststring compression_dictionary_;
+  gscoped_ptr<CompressionCodec> dictionary_codec_;
+
+  // Zone maps of the current data block and of the whole file, and the
+  // zone maps of the finished data blocks. Only set if writing zone maps.
+  gscoped_ptr<ZoneMapBuilder> block_zone_map_builder_;
+  gscoped_ptr<ZoneMapBuilder> file_zone_map_builder_;
+  ZoneMapIndexPB block_zone_maps_;
+
+  // Whether the encoding is picked by trial-encoding the data, rather than
+  // configured. The trials buffer the values of a data block, then encode
+  // them with each encoding supported for the type.
+  bool adaptive_encoding_;
+
+  // Whether values are currently being buffered for a trial.
+  bool trialing_;
+
+  // The buffered values (including the cells of null values), their null
+  // bitmap if the file is nullable, and the number of rows buffered.
+  faststring trial_cells_;
+  faststring trial_null_bitmap_;
+  size_t trial_rows_;
+
+  // The approximate size of the buffered values, used to decide when a
+  // trial has buffered enough of them.
+  size_t trial_bytes_;
+
+  // Copies of the indirect data of the buffered values.
+  gscoped_ptr<Arena> trial_arena_;
+
+  // The encoded size per value of the encoding picked by the last trial, and
+  // the number of data blocks written since then.
+  double trial_bytes_per_value_;
+  int blocks_since_trial_;
+
+  // Changes of encoding after the first data block.
+  google::protobuf::RepeatedPtrField<DataBlockEncodingPB> data_block_encodings_;
+
   enum State {
     kWriterInitialized,
     kWriterWriting,
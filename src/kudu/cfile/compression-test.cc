@@ -26,13 +26,21 @@
 #include "kudu/cfile/compression_codec.h"
 #include "kudu/cfile/index_block.h"
 #include "kudu/cfile/index_btree.h"
+#include "kudu/util/random.h"
+#include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
 #include "kudu/util/status.h"
 
+DECLARE_int32(cfile_compression_dictionary_size);
+DECLARE_int32(cfile_compression_dictionary_training_blocks);
+DECLARE_int32(zstd_compression_level);
+
 namespace kudu {
 namespace cfile {
 
+using std::string;
+
 static void TestCompressionCodec(CompressionType compression) {
   const int kInputSize = 64;
 
@@ -67,6 +75,63 @@ static void TestCompressionCodec(CompressionType compression) {
   ASSERT_EQ(0, memcmp(ibuffer, ubuffer, kInputSize));
 }
 
+// Returns 'num_blocks' blocks of 'block_size' bytes of text resembling rows
+// of a table, which compress somewhat like real column data does.
+static vector<string> MakeRowLikeBlocks(int num_blocks, size_t block_size) {
+  static const char* const kWords[] = {
+    "kudu", "tablet", "server", "master", "scan", "insert", "update", "delete",
+    "row", "column", "leader", "follower", "replica", "compaction", "flush" };
+  Random rng(SeedRandom());
+  vector<string> blocks;
+  for (int i = 0; i < num_blocks; i++) {
+    string block;
+    while (block.size() < block_size) {
+      block += StringPrintf("%s-%s:%u,", kWords[rng.Uniform(arraysize(kWords))],
+                            kWords[rng.Uniform(arraysize(kWords))], rng.Uniform(100000));
+    }
+    block.resize(block_size);
+    blocks.push_back(block);
+  }
+  return blocks;
+}
+
+// Compresses and uncompresses 'blocks' with 'codec', checking the round trip,
+// and logs the compression ratio and throughput.
+static void ReportCompression(const string& name, const CompressionCodec* codec,
+                              const vector<string>& blocks) {
+  size_t uncompressed_bytes = 0;
+  size_t compressed_bytes = 0;
+  vector<faststring> compressed(blocks.size());
+  Stopwatch compress_sw;
+  compress_sw.start();
+  for (int i = 0; i < blocks.size(); i++) {
+    compressed[i].resize(codec->MaxCompressedLength(blocks[i].size()));
+    size_t n;
+    ASSERT_OK(codec->Compress(Slice(blocks[i]), compressed[i].data(), &n));
+    compressed[i].resize(n);
+    uncompressed_bytes += blocks[i].size();
+    compressed_bytes += n;
+  }
+  compress_sw.stop();
+
+  faststring uncompressed;
+  Stopwatch uncompress_sw;
+  uncompress_sw.start();
+  for (int i = 0; i < blocks.size(); i++) {
+    uncompressed.resize(blocks[i].size());
+    ASSERT_OK(codec->Uncompress(Slice(compressed[i]), uncompressed.data(), blocks[i].size()));
+    ASSERT_EQ(0, memcmp(blocks[i].data(), uncompressed.data(), blocks[i].size()));
+  }
+  uncompress_sw.stop();
+
+  double mb = static_cast<double>(uncompressed_bytes) / (1024 * 1024);
+  LOG(INFO) << StringPrintf("%-16s ratio %6.3f, compress %8.1f MB/s, uncompress %8.1f MB/s",
+                            name.c_str(),
+                            static_cast<double>(uncompressed_bytes) / compressed_bytes,
+                            mb / compress_sw.elapsed().wall_seconds(),
+                            mb / uncompress_sw.elapsed().wall_seconds());
+}
+
 class TestCompression : public CFileTestBase {
  protected:
   void TestReadWriteCompressed(CompressionType compression) {
@@ -111,6 +176,84 @@ TEST_F(TestCompression, TestZlibCompressionCodec) {
   TestCompressionCodec(ZLIB);
 }
 
+TEST_F(TestCompression, TestZstdCompressionCodec) {
+  TestCompressionCodec(ZSTD);
+  FLAGS_zstd_compression_level = 19;
+  TestCompressionCodec(ZSTD);
+}
+
+TEST_F(TestCompression, TestZstdDictionary) {
+  vector<string> blocks = MakeRowLikeBlocks(100, 4096);
+  vector<Slice> samples(blocks.begin(), blocks.end());
+  faststring dictionary;
+  ASSERT_OK(TrainCompressionDictionary(ZSTD, samples, 16 * 1024, &dictionary));
+  ASSERT_GT(dictionary.size(), 0);
+  ASSERT_LE(dictionary.size(), 16 * 1024);
+  ASSERT_TRUE(TrainCompressionDictionary(LZ4, samples, 16 * 1024, &dictionary)
+              .IsNotSupported());
+
+  gscoped_ptr<CompressionCodec> dict_codec;
+  ASSERT_OK(CreateDictionaryCompressionCodec(ZSTD, dictionary, &dict_codec));
+  const CompressionCodec* codec;
+  ASSERT_OK(GetCompressionCodec(ZSTD, &codec));
+
+  // Small blocks compress better with the dictionary than without.
+  vector<string> more_blocks = MakeRowLikeBlocks(1, 4096);
+  const string& block = more_blocks[0];
+  faststring with_dict;
+  with_dict.resize(dict_codec->MaxCompressedLength(block.size()));
+  size_t with_dict_size;
+  ASSERT_OK(dict_codec->Compress(Slice(block), with_dict.data(), &with_dict_size));
+  faststring without_dict;
+  without_dict.resize(codec->MaxCompressedLength(block.size()));
+  size_t without_dict_size;
+  ASSERT_OK(codec->Compress(Slice(block), without_dict.data(), &without_dict_size));
+  ASSERT_LT(with_dict_size, without_dict_size);
+
+  // The dictionary codec uncompresses blocks compressed with and without
+  // the dictionary.
+  faststring out;
+  out.resize(block.size());
+  ASSERT_OK(dict_codec->Uncompress(Slice(with_dict.data(), with_dict_size),
+                                   out.data(), block.size()));
+  ASSERT_EQ(block, out.ToString());
+  ASSERT_OK(dict_codec->Uncompress(Slice(without_dict.data(), without_dict_size),
+                                   out.data(), block.size()));
+  ASSERT_EQ(block, out.ToString());
+}
+
+// Reports the compression ratio and throughput of each codec on blocks of
+// the default cfile block size, and of zstd with a dictionary on small blocks.
+TEST_F(TestCompression, TestCompressionRatioAndThroughput) {
+  const int kNumBlocks = AllowSlowTests() ? 1000 : 20;
+  for (size_t block_size : { 256 * 1024, 32 * 1024, 4 * 1024 }) {
+    SCOPED_TRACE(block_size);
+    LOG(INFO) << "Block size " << block_size << ":";
+    vector<string> blocks = MakeRowLikeBlocks(kNumBlocks * (256 * 1024 / block_size),
+                                              block_size);
+    for (CompressionType compression : { SNAPPY, LZ4, ZLIB, ZSTD }) {
+      const CompressionCodec* codec;
+      ASSERT_OK(GetCompressionCodec(compression, &codec));
+      NO_FATALS(ReportCompression(CompressionType_Name(compression), codec, blocks));
+    }
+    for (int level : { 1, 9, 19 }) {
+      FLAGS_zstd_compression_level = level;
+      const CompressionCodec* codec;
+      ASSERT_OK(GetCompressionCodec(ZSTD, &codec));
+      NO_FATALS(ReportCompression(StringPrintf("ZSTD level %d", level), codec, blocks));
+    }
+    FLAGS_zstd_compression_level = 3;
+
+    // Train on the first blocks, as the cfile writer does.
+    vector<Slice> samples(blocks.begin(), blocks.begin() + std::min<size_t>(blocks.size(), 64));
+    faststring dictionary;
+    ASSERT_OK(TrainCompressionDictionary(ZSTD, samples, 32 * 1024, &dictionary));
+    gscoped_ptr<CompressionCodec> dict_codec;
+    ASSERT_OK(CreateDictionaryCompressionCodec(ZSTD, dictionary, &dict_codec));
+    NO_FATALS(ReportCompression("ZSTD dictionary", dict_codec.get(), blocks));
+  }
+}
+
 TEST_F(TestCompression, TestCFileNoCompressionReadWrite) {
   TestReadWriteCompressed(NO_COMPRESSION);
 }
@@ -127,5 +270,30 @@ TEST_F(TestCompression, TestCFileZlibReadWrite) {
   TestReadWriteCompressed(ZLIB);
 }
 
+TEST_F(TestCompression, TestCFileZstdReadWrite) {
+  TestReadWriteCompressed(ZSTD);
+}
+
+TEST_F(TestCompression, TestCFileZstdDictionaryReadWrite) {
+  FLAGS_cfile_compression_dictionary_size = 8 * 1024;
+  FLAGS_cfile_compression_dictionary_training_blocks = 16;
+  const size_t nrows = 100000;
+  BlockId block_id;
+  StringDataGenerator<false> string_gen("hello %04d");
+  WriteTestFile(&string_gen, PLAIN_ENCODING, ZSTD, nrows, SMALL_BLOCKSIZE, &block_id);
+
+  {
+    gscoped_ptr<fs::ReadableBlock> source;
+    ASSERT_OK(fs_manager_->OpenBlock(block_id, &source));
+    gscoped_ptr<CFileReader> reader;
+    ASSERT_OK(CFileReader::Open(std::move(source), ReaderOptions(), &reader));
+    ASSERT_TRUE(reader->footer().has_compression_dictionary());
+  }
+
+  size_t rdrows;
+  TimeReadFile(fs_manager_.get(), block_id, &rdrows);
+  ASSERT_EQ(nrows, rdrows);
+}
+
 } // namespace cfile
 } // namespace kudu
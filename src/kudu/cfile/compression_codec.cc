@@ -20,17 +20,45 @@
 #include <snappy.h>
 #include <zlib.h>
 #include <lz4.h>
+#define ZSTD_STATIC_LINKING_ONLY // for ZSTD_getDictID_fromFrame()
+#include <zstd.h>
+#include <zdict.h>
+#include <gflags/gflags.h>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "kudu/cfile/compression_codec.h"
 #include "kudu/gutil/singleton.h"
 #include "kudu/gutil/stringprintf.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/flag_tags.h"
+
+DEFINE_int32(zstd_compression_level, 3,
+             "The compression level of data compressed with zstd, from 1 to 22. "
+             "Higher levels compress better, but more slowly. The speed of "
+             "decompression hardly depends on the level.");
+TAG_FLAG(zstd_compression_level, advanced);
+TAG_FLAG(zstd_compression_level, runtime);
+
+static bool ValidateZstdCompressionLevel(const char* flagname, int32_t value) {
+  if (value >= 1 && value <= ZSTD_maxCLevel()) {
+    return true;
+  }
+  LOG(ERROR) << strings::Substitute("$0 must be between 1 and $1, value $2 is invalid",
+                                    flagname, ZSTD_maxCLevel(), value);
+  return false;
+}
+static bool dummy = google::RegisterFlagValidator(
+    &FLAGS_zstd_compression_level, &ValidateZstdCompressionLevel);
 
 namespace kudu {
 namespace cfile {
 
+using std::unique_ptr;
 using std::vector;
+using strings::Substitute;
 
 CompressionCodec::CompressionCodec() {
 }
@@ -225,6 +253,145 @@ class ZlibCodec : public CompressionCodec {
   }
 };
 
+// Zstandard. The compression level is read for every call, so it may be
+// changed at runtime.
+class ZstdCodec : public CompressionCodec {
+ public:
+  static ZstdCodec *GetSingleton() {
+    return Singleton<ZstdCodec>::get();
+  }
+
+  Status Compress(const Slice& input,
+                  uint8_t *compressed, size_t *compressed_length) const OVERRIDE {
+    size_t n = ZSTD_compress(compressed, MaxCompressedLength(input.size()),
+                             input.data(), input.size(), FLAGS_zstd_compression_level);
+    return CheckCompressResult(n, compressed_length);
+  }
+
+  Status Compress(const vector<Slice>& input_slices,
+                  uint8_t *compressed, size_t *compressed_length) const OVERRIDE {
+    if (input_slices.size() == 1) {
+      return Compress(input_slices[0], compressed, compressed_length);
+    }
+
+    SlicesSource source(input_slices);
+    faststring buffer;
+    source.Dump(&buffer);
+    return Compress(Slice(buffer.data(), buffer.size()), compressed, compressed_length);
+  }
+
+  Status Uncompress(const Slice& compressed,
+                    uint8_t *uncompressed,
+                    size_t uncompressed_length) const OVERRIDE {
+    size_t n = ZSTD_decompress(uncompressed, uncompressed_length,
+                               compressed.data(), compressed.size());
+    return CheckUncompressResult(n, uncompressed_length);
+  }
+
+  size_t MaxCompressedLength(size_t source_bytes) const OVERRIDE {
+    return ZSTD_compressBound(source_bytes);
+  }
+
+ protected:
+  static Status CheckCompressResult(size_t n, size_t *compressed_length) {
+    if (ZSTD_isError(n)) {
+      return Status::IOError("unable to compress the buffer", ZSTD_getErrorName(n));
+    }
+    *compressed_length = n;
+    return Status::OK();
+  }
+
+  static Status CheckUncompressResult(size_t n, size_t uncompressed_length) {
+    if (ZSTD_isError(n)) {
+      return Status::Corruption("unable to uncompress the buffer", ZSTD_getErrorName(n));
+    }
+    if (n != uncompressed_length) {
+      return Status::Corruption(
+          Substitute("uncompressed size $0 does not match the expected size $1",
+                     n, uncompressed_length));
+    }
+    return Status::OK();
+  }
+};
+
+// Zstandard with a dictionary. The dictionary is digested for compression
+// along with the compression level, so the level is fixed when the codec is
+// created. Since readers only uncompress, that digest is only made once the
+// codec first compresses.
+class ZstdDictionaryCodec : public ZstdCodec {
+ public:
+  ZstdDictionaryCodec(const Slice& dictionary, int level)
+      : dictionary_(dictionary.ToString()),
+        level_(level),
+        cdict_(nullptr),
+        ddict_(ZSTD_createDDict(dictionary_.data(), dictionary_.size())) {
+  }
+
+  ~ZstdDictionaryCodec() {
+    ZSTD_freeCDict(cdict_);
+    ZSTD_freeDDict(ddict_);
+  }
+
+  Status Init() {
+    if (ddict_ == nullptr) {
+      return Status::Corruption("invalid zstd dictionary");
+    }
+    return Status::OK();
+  }
+
+  Status Compress(const Slice& input,
+                  uint8_t *compressed, size_t *compressed_length) const OVERRIDE {
+    std::call_once(cdict_once_, [this]() {
+        cdict_ = ZSTD_createCDict(dictionary_.data(), dictionary_.size(), level_);
+      });
+    if (cdict_ == nullptr) {
+      return Status::IOError("unable to digest the zstd dictionary");
+    }
+    unique_ptr<ZSTD_CCtx, size_t(*)(ZSTD_CCtx*)> cctx(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+    size_t n = ZSTD_compress_usingCDict(cctx.get(), compressed,
+                                        MaxCompressedLength(input.size()),
+                                        input.data(), input.size(), cdict_);
+    return CheckCompressResult(n, compressed_length);
+  }
+
+  Status Compress(const vector<Slice>& input_slices,
+                  uint8_t *compressed, size_t *compressed_length) const OVERRIDE {
+    if (input_slices.size() == 1) {
+      return Compress(input_slices[0], compressed, compressed_length);
+    }
+
+    SlicesSource source(input_slices);
+    faststring buffer;
+    source.Dump(&buffer);
+    return Compress(Slice(buffer.data(), buffer.size()), compressed, compressed_length);
+  }
+
+  Status Uncompress(const Slice& compressed,
+                    uint8_t *uncompressed,
+                    size_t uncompressed_length) const OVERRIDE {
+    // Blocks written before the dictionary was trained don't use it.
+    if (ZSTD_getDictID_fromFrame(compressed.data(), compressed.size()) == 0) {
+      return ZstdCodec::Uncompress(compressed, uncompressed, uncompressed_length);
+    }
+    unique_ptr<ZSTD_DCtx, size_t(*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+    size_t n = ZSTD_decompress_usingDDict(dctx.get(), uncompressed, uncompressed_length,
+                                          compressed.data(), compressed.size(), ddict_);
+    return CheckUncompressResult(n, uncompressed_length);
+  }
+
+  size_t memory_footprint_excluding_this() const OVERRIDE {
+    return dictionary_.capacity() + ZSTD_sizeof_DDict(ddict_) +
+        (cdict_ == nullptr ? 0 : ZSTD_sizeof_CDict(cdict_));
+  }
+
+ private:
+  const std::string dictionary_;
+  const int level_;
+  mutable std::once_flag cdict_once_;
+  mutable ZSTD_CDict* cdict_;
+  ZSTD_DDict* ddict_;
+};
+
 Status GetCompressionCodec(CompressionType compression,
                            const CompressionCodec** codec) {
   switch (compression) {
@@ -240,6 +407,9 @@ Status GetCompressionCodec(CompressionType compression,
     case ZLIB:
       *codec = ZlibCodec::GetSingleton();
       break;
+    case ZSTD:
+      *codec = ZstdCodec::GetSingleton();
+      break;
     default:
       return Status::NotFound("bad compression type");
   }
@@ -253,6 +423,8 @@ CompressionType GetCompressionCodecType(const std::string& name) {
     return LZ4;
   if (name.compare("zlib") == 0)
     return ZLIB;
+  if (name.compare("zstd") == 0)
+    return ZSTD;
   if (name.compare("none") == 0)
     return NO_COMPRESSION;
 
@@ -261,5 +433,47 @@ CompressionType GetCompressionCodecType(const std::string& name) {
   return NO_COMPRESSION;
 }
 
+Status TrainCompressionDictionary(CompressionType compression,
+                                  const vector<Slice>& samples,
+                                  size_t max_size,
+                                  faststring* dictionary) {
+  if (compression != ZSTD) {
+    return Status::NotSupported("compression codec does not support dictionaries",
+                                CompressionType_Name(compression));
+  }
+
+  faststring buffer;
+  vector<size_t> sizes;
+  sizes.reserve(samples.size());
+  for (const Slice& sample : samples) {
+    buffer.append(sample.data(), sample.size());
+    sizes.push_back(sample.size());
+  }
+  dictionary->resize(max_size);
+  size_t n = ZDICT_trainFromBuffer(dictionary->data(), max_size, buffer.data(),
+                                   sizes.data(), sizes.size());
+  if (ZDICT_isError(n)) {
+    dictionary->clear();
+    return Status::RuntimeError("unable to train a compression dictionary",
+                                ZDICT_getErrorName(n));
+  }
+  dictionary->resize(n);
+  return Status::OK();
+}
+
+Status CreateDictionaryCompressionCodec(CompressionType compression,
+                                        const Slice& dictionary,
+                                        gscoped_ptr<CompressionCodec>* codec) {
+  if (compression != ZSTD) {
+    return Status::NotSupported("compression codec does not support dictionaries",
+                                CompressionType_Name(compression));
+  }
+  gscoped_ptr<ZstdDictionaryCodec> zstd(
+      new ZstdDictionaryCodec(dictionary, FLAGS_zstd_compression_level));
+  RETURN_NOT_OK(zstd->Init());
+  codec->reset(zstd.release());
+  return Status::OK();
+}
+
 } // namespace cfile
 } // namespace kudu
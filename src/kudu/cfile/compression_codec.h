@@ -20,8 +20,10 @@
 #include <string>
 #include <vector>
 
-#include "kudu/cfile/cfile.pb.h"
+#include "kudu/common/common.pb.h"
+#include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/macros.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
@@ -56,6 +58,11 @@ class CompressionCodec {
   // Returns the maximal size of the compressed representation of
   // input data that is "source_bytes" bytes in length.
   virtual size_t MaxCompressedLength(size_t source_bytes) const = 0;
+
+  // Returns the memory held by the codec, excluding the object itself.
+  virtual size_t memory_footprint_excluding_this() const {
+    return 0;
+  }
  private:
   DISALLOW_COPY_AND_ASSIGN(CompressionCodec);
 };
@@ -69,6 +76,28 @@ Status GetCompressionCodec(CompressionType compression,
 // Returns the compression codec type given the name
 CompressionType GetCompressionCodecType(const std::string& name);
 
+// Trains a dictionary of at most 'max_size' bytes for the specified codec
+// type from 'samples' of the data to be compressed, so that small blocks of
+// similar data compress better with CreateDictionaryCompressionCodec().
+//
+// Returns NotSupported if the codec does not support dictionaries, and
+// another non-OK status if no dictionary could be trained, e.g. if there
+// are too few samples.
+Status TrainCompressionDictionary(CompressionType compression,
+                                  const std::vector<Slice>& samples,
+                                  size_t max_size,
+                                  faststring* dictionary);
+
+// Creates a codec for the specified type which compresses with the given
+// dictionary, as trained by TrainCompressionDictionary(). The codec also
+// uncompresses data which was compressed without the dictionary.
+//
+// Unlike the codecs returned by GetCompressionCodec(), the returned codec is
+// owned by the caller. The dictionary is copied.
+Status CreateDictionaryCompressionCodec(CompressionType compression,
+                                        const Slice& dictionary,
+                                        gscoped_ptr<CompressionCodec>* codec);
+
 } // namespace cfile
 } // namespace kudu
 #endif
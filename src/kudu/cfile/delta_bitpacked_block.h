@@ -0,0 +1,408 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CFILE_DELTA_BITPACKED_BLOCK_H
+#define KUDU_CFILE_DELTA_BITPACKED_BLOCK_H
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+#include "kudu/cfile/bitpacking.h"
+#include "kudu/cfile/block_encodings.h"
+#include "kudu/cfile/cfile_util.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/gutil/bits.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/coding-inl.h"
+#include "kudu/util/faststring.h"
+
+namespace kudu {
+namespace cfile {
+
+// Delta encoding with bit-packing, for 64-bit integer types (including
+// timestamps). This suits columns whose adjacent values are close together,
+// such as sorted keys, auto-incrementing IDs and event times: a column of
+// consecutive IDs takes no space beyond its miniblock headers.
+//
+// The values of a block are split into miniblocks of bitpacking::kBatchSize
+// values. Each miniblock stores the first of its values and the minimum of
+// the deltas between its adjacent values; every delta is then encoded as its
+// difference from that minimum, bit-packed with the fewest bits which fit the
+// largest of them. Arithmetic wraps around, so any sequence of values can be
+// encoded, at worst with 64 bits per value.
+//
+// Since each miniblock can be decoded on its own, seeking to a position only
+// decodes the miniblock containing it, and seeking to a value in a sorted
+// block binary searches the first values of the miniblocks before decoding
+// a single one of them.
+//
+// Header includes:
+// 1. ordinal of the first element within the block (uint32_t, little endian).
+// 2. number of elements within the block (uint32_t, little endian).
+// followed, for each miniblock, by:
+// 3. the first value of the miniblock (uint64_t, little endian).
+// 4. the minimum delta within the miniblock (uint64_t, little endian).
+// 5. the bit width of the packed deltas (uint8_t).
+// followed by the packed deltas of each miniblock, and finally by
+// bitpacking::kUnpackPadding bytes of padding.
+//
+// The packed deltas of a miniblock always take up a full batch of
+// bitpacking::kBatchSize values, the first of which is zero; the last
+// miniblock is padded with zero deltas.
+template<DataType Type>
+class DeltaBitPackedBlockBuilder : public BlockBuilder {
+ public:
+  explicit DeltaBitPackedBlockBuilder(const WriterOptions* options)
+      : options_(options) {
+    Reset();
+  }
+
+  void Reset() OVERRIDE {
+    values_.clear();
+    packed_size_ = 0;
+    last_bit_width_ = bitpacking::kMaxBitWidth;
+    buffer_.clear();
+  }
+
+  bool IsBlockFull(size_t limit) const OVERRIDE {
+    return EstimateEncodedSize() > limit;
+  }
+
+  int Add(const uint8_t* vals_void, size_t count) OVERRIDE {
+    const CppType* vals = reinterpret_cast<const CppType*>(vals_void);
+    int added = 0;
+    // If the current block is full, stop adding more items.
+    while (!IsBlockFull(options_->storage_attributes.cfile_block_size) && added < count) {
+      values_.push_back(static_cast<uint64_t>(vals[added]));
+      added++;
+      if (values_.size() % bitpacking::kBatchSize == 0) {
+        // Keep track of the size of the finished miniblock.
+        uint64_t min_delta;
+        last_bit_width_ = ComputeBitWidth(values_.size() - bitpacking::kBatchSize,
+                                          bitpacking::kBatchSize, &min_delta);
+        packed_size_ += kMiniblockHeaderSize + bitpacking::PackedBatchSize(last_bit_width_);
+      }
+    }
+    return added;
+  }
+
+  size_t Count() const OVERRIDE {
+    return values_.size();
+  }
+
+  Status GetFirstKey(void* key) const OVERRIDE {
+    if (values_.empty()) {
+      return Status::NotFound("no keys in data block");
+    }
+    *reinterpret_cast<CppType*>(key) = static_cast<CppType>(values_[0]);
+    return Status::OK();
+  }
+
+  Slice Finish(rowid_t ordinal_pos) OVERRIDE {
+    const size_t count = values_.size();
+    const size_t num_miniblocks = NumMiniblocks(count);
+    buffer_.resize(kHeaderSize + num_miniblocks * kMiniblockHeaderSize);
+    InlineEncodeFixed32(&buffer_[0], ordinal_pos);
+    InlineEncodeFixed32(&buffer_[4], count);
+
+    uint64_t deltas[bitpacking::kBatchSize];
+    for (size_t mb = 0; mb < num_miniblocks; mb++) {
+      const size_t start = mb * bitpacking::kBatchSize;
+      const size_t n = std::min<size_t>(bitpacking::kBatchSize, count - start);
+      uint64_t min_delta;
+      int bit_width = ComputeBitWidth(start, n, &min_delta);
+
+      uint8_t* mb_header = &buffer_[kHeaderSize + mb * kMiniblockHeaderSize];
+      InlineEncodeFixed64(mb_header, values_[start]);
+      InlineEncodeFixed64(mb_header + 8, min_delta);
+      mb_header[16] = bit_width;
+
+      deltas[0] = 0;
+      for (size_t i = 1; i < n; i++) {
+        deltas[i] = values_[start + i] - values_[start + i - 1] - min_delta;
+      }
+      std::fill(deltas + n, deltas + bitpacking::kBatchSize, 0);
+
+      size_t offset = buffer_.size();
+      buffer_.resize(offset + bitpacking::PackedBatchSize(bit_width));
+      bitpacking::PackBatch(deltas, bit_width, &buffer_[offset]);
+    }
+    size_t size = buffer_.size();
+    buffer_.resize(size + bitpacking::kUnpackPadding);
+    memset(&buffer_[size], 0, bitpacking::kUnpackPadding);
+    return Slice(buffer_.data(), buffer_.size());
+  }
+
+ private:
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+  static_assert(sizeof(CppType) == sizeof(uint64_t),
+                "delta bit-packing only supports 64-bit types");
+
+  static const size_t kHeaderSize = sizeof(uint32_t) * 2;
+  static const size_t kMiniblockHeaderSize = sizeof(uint64_t) * 2 + 1;
+
+  static size_t NumMiniblocks(size_t count) {
+    return (count + bitpacking::kBatchSize - 1) / bitpacking::kBatchSize;
+  }
+
+  // Returns the bit width needed to pack the deltas between the 'n' values
+  // starting at 'start', setting '*min_delta' to the smallest of the deltas.
+  int ComputeBitWidth(size_t start, size_t n, uint64_t* min_delta) const {
+    // The deltas are compared as signed, so that descending runs of values
+    // are packed as tightly as ascending ones.
+    int64_t min = 0;
+    for (size_t i = 1; i < n; i++) {
+      int64_t delta = values_[start + i] - values_[start + i - 1];
+      min = (i == 1) ? delta : std::min(min, delta);
+    }
+    uint64_t max_packed = 0;
+    for (size_t i = 1; i < n; i++) {
+      uint64_t delta = values_[start + i] - values_[start + i - 1];
+      max_packed = std::max(max_packed, delta - static_cast<uint64_t>(min));
+    }
+    *min_delta = static_cast<uint64_t>(min);
+    return max_packed == 0 ? 0 : Bits::Log2Floor64(max_packed) + 1;
+  }
+
+  size_t EstimateEncodedSize() const {
+    // The miniblock in progress is assumed to pack as well as the last
+    // finished one.
+    size_t pending = values_.size() % bitpacking::kBatchSize;
+    return kHeaderSize + packed_size_ +
+        kMiniblockHeaderSize + pending * last_bit_width_ / 8 +
+        bitpacking::kUnpackPadding;
+  }
+
+  // The values added so far.
+  std::vector<uint64_t> values_;
+
+  // The encoded size of the finished miniblocks, and the bit width of the
+  // last of them.
+  size_t packed_size_;
+  int last_bit_width_;
+
+  faststring buffer_;
+  const WriterOptions* options_;
+};
+
+template<DataType Type>
+class DeltaBitPackedBlockDecoder : public BlockDecoder {
+ public:
+  explicit DeltaBitPackedBlockDecoder(Slice slice)
+      : data_(std::move(slice)),
+        parsed_(false),
+        ordinal_pos_base_(0),
+        num_elems_(0),
+        cur_idx_(0),
+        decoded_miniblock_(-1) {
+  }
+
+  Status ParseHeader() OVERRIDE {
+    CHECK(!parsed_);
+    if (data_.size() < kHeaderSize) {
+      return Status::Corruption(
+          strings::Substitute("not enough bytes for header: delta bit-packed block "
+                              "size ($0) less than expected header length ($1)",
+                              data_.size(), kHeaderSize));
+    }
+    ordinal_pos_base_ = DecodeFixed32(&data_[0]);
+    num_elems_ = DecodeFixed32(&data_[4]);
+
+    size_t num_miniblocks =
+        (num_elems_ + bitpacking::kBatchSize - 1) / bitpacking::kBatchSize;
+    size_t offset = kHeaderSize + num_miniblocks * kMiniblockHeaderSize;
+    if (data_.size() < offset) {
+      return Status::Corruption(
+          strings::Substitute("not enough bytes for $0 miniblock headers: block size $1",
+                              num_miniblocks, data_.size()));
+    }
+    packed_offsets_.resize(num_miniblocks);
+    for (size_t mb = 0; mb < num_miniblocks; mb++) {
+      int bit_width = MiniblockHeader(mb)[16];
+      if (bit_width > bitpacking::kMaxBitWidth) {
+        return Status::Corruption(strings::Substitute("invalid bit width: $0", bit_width));
+      }
+      packed_offsets_[mb] = offset;
+      offset += bitpacking::PackedBatchSize(bit_width);
+    }
+    if (data_.size() != offset + bitpacking::kUnpackPadding) {
+      return Status::Corruption(
+          strings::Substitute("delta bit-packed block size $0 does not match "
+                              "expected size $1",
+                              data_.size(), offset + bitpacking::kUnpackPadding));
+    }
+
+    parsed_ = true;
+    return Status::OK();
+  }
+
+  void SeekToPositionInBlock(uint pos) OVERRIDE {
+    CHECK(parsed_) << "Must call ParseHeader()";
+    DCHECK_LE(pos, num_elems_);
+    cur_idx_ = pos;
+  }
+
+  // Since only the first values of the miniblocks are available without
+  // decoding them, this requires the values of the block to be sorted, which
+  // is the case for key columns.
+  Status SeekAtOrAfterValue(const void* value_void, bool* exact) OVERRIDE {
+    CHECK(parsed_) << "Must call ParseHeader()";
+    CppType target = *reinterpret_cast<const CppType*>(value_void);
+    *exact = false;
+    if (PREDICT_FALSE(num_elems_ == 0)) {
+      return Status::NotFound("after last key in block");
+    }
+
+    // Find the last miniblock starting before the target; the target must
+    // be within it, or be the first value of the next one.
+    int32_t left = 0;
+    int32_t right = packed_offsets_.size();
+    while (left != right) {
+      int32_t mid = (left + right) / 2;
+      if (MiniblockFirstValue(mid) < target) {
+        left = mid + 1;
+      } else {
+        right = mid;
+      }
+    }
+    if (left == 0) {
+      cur_idx_ = 0;
+      *exact = MiniblockFirstValue(0) == target;
+      return Status::OK();
+    }
+    int miniblock = left - 1;
+
+    DecodeMiniblock(miniblock);
+    const CppType* begin = reinterpret_cast<const CppType*>(decoded_);
+    const CppType* end = begin + MiniblockCount(miniblock);
+    const CppType* it = std::lower_bound(begin, end, target);
+    if (it != end) {
+      cur_idx_ = miniblock * bitpacking::kBatchSize + (it - begin);
+      *exact = *it == target;
+      return Status::OK();
+    }
+    if (miniblock + 1 == static_cast<int>(packed_offsets_.size())) {
+      cur_idx_ = num_elems_;
+      return Status::NotFound("after last key in block");
+    }
+    cur_idx_ = (miniblock + 1) * bitpacking::kBatchSize;
+    *exact = MiniblockFirstValue(miniblock + 1) == target;
+    return Status::OK();
+  }
+
+  Status CopyNextValues(size_t* n, ColumnDataView* dst) OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_EQ(dst->stride(), sizeof(CppType));
+    if (PREDICT_FALSE(*n == 0 || cur_idx_ >= num_elems_)) {
+      *n = 0;
+      return Status::OK();
+    }
+
+    size_t max_fetch = std::min(*n, static_cast<size_t>(num_elems_ - cur_idx_));
+    uint8_t* out = dst->data();
+    size_t remaining = max_fetch;
+    while (remaining > 0) {
+      int miniblock = cur_idx_ / bitpacking::kBatchSize;
+      size_t idx_in_miniblock = cur_idx_ % bitpacking::kBatchSize;
+      DecodeMiniblock(miniblock);
+      size_t to_copy = std::min(remaining, MiniblockCount(miniblock) - idx_in_miniblock);
+      memcpy(out, &decoded_[idx_in_miniblock], to_copy * sizeof(CppType));
+      out += to_copy * sizeof(CppType);
+      cur_idx_ += to_copy;
+      remaining -= to_copy;
+    }
+
+    *n = max_fetch;
+    return Status::OK();
+  }
+
+  size_t GetCurrentIndex() const OVERRIDE {
+    DCHECK(parsed_) << "must parse header first";
+    return cur_idx_;
+  }
+
+  rowid_t GetFirstRowId() const OVERRIDE {
+    return ordinal_pos_base_;
+  }
+
+  size_t Count() const OVERRIDE {
+    return num_elems_;
+  }
+
+  bool HasNext() const OVERRIDE {
+    return cur_idx_ < num_elems_;
+  }
+
+ private:
+  typedef typename TypeTraits<Type>::cpp_type CppType;
+  static_assert(sizeof(CppType) == sizeof(uint64_t),
+                "delta bit-packing only supports 64-bit types");
+
+  static const size_t kHeaderSize = sizeof(uint32_t) * 2;
+  static const size_t kMiniblockHeaderSize = sizeof(uint64_t) * 2 + 1;
+
+  const uint8_t* MiniblockHeader(int miniblock) const {
+    return &data_[kHeaderSize + miniblock * kMiniblockHeaderSize];
+  }
+
+  CppType MiniblockFirstValue(int miniblock) const {
+    return static_cast<CppType>(DecodeFixed64(MiniblockHeader(miniblock)));
+  }
+
+  size_t MiniblockCount(int miniblock) const {
+    return std::min<size_t>(bitpacking::kBatchSize,
+                            num_elems_ - miniblock * bitpacking::kBatchSize);
+  }
+
+  // Decode the given miniblock into 'decoded_', unless it already is.
+  void DecodeMiniblock(int miniblock) {
+    if (decoded_miniblock_ == miniblock) {
+      return;
+    }
+    const uint8_t* header = MiniblockHeader(miniblock);
+    const uint64_t min_delta = DecodeFixed64(header + 8);
+    bitpacking::GetUnpacker(header[16])(&data_[packed_offsets_[miniblock]], decoded_);
+
+    decoded_[0] = DecodeFixed64(header);
+    size_t count = MiniblockCount(miniblock);
+    for (size_t i = 1; i < count; i++) {
+      decoded_[i] += decoded_[i - 1] + min_delta;
+    }
+    decoded_miniblock_ = miniblock;
+  }
+
+  Slice data_;
+  bool parsed_;
+
+  rowid_t ordinal_pos_base_;
+  uint32_t num_elems_;
+
+  // The offset within 'data_' of the packed deltas of each miniblock.
+  std::vector<uint32_t> packed_offsets_;
+
+  size_t cur_idx_;
+
+  // The values of the most recently decoded miniblock, or -1 if none has
+  // been decoded yet.
+  int decoded_miniblock_;
+  uint64_t decoded_[bitpacking::kBatchSize];
+};
+
+} // namespace cfile
+} // namespace kudu
+#endif
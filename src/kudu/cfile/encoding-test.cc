@@ -25,6 +25,7 @@
 #include "kudu/cfile/block_encodings.h"
 #include "kudu/cfile/bshuf_block.h"
 #include "kudu/cfile/cfile_writer.h"
+#include "kudu/cfile/delta_bitpacked_block.h"
 #include "kudu/cfile/gvint_block.h"
 #include "kudu/cfile/plain_bitmap_block.h"
 #include "kudu/cfile/plain_block.h"
@@ -678,6 +679,86 @@ TEST_F(TestEncoding, TestRleIntBlockEncoder) {
   ASSERT_EQ(14UL, s.size());
 }
 
+TEST_F(TestEncoding, TestDeltaBitPackedBlockRoundTrip) {
+  gscoped_ptr<WriterOptions> opts(NewWriterOptions());
+  {
+    DeltaBitPackedBlockBuilder<INT64> ibb(opts.get());
+    TestIntBlockRoundTrip<DeltaBitPackedBlockBuilder<INT64>,
+                          DeltaBitPackedBlockDecoder<INT64>, INT64>(&ibb);
+  }
+  {
+    DeltaBitPackedBlockBuilder<UINT64> ibb(opts.get());
+    TestIntBlockRoundTrip<DeltaBitPackedBlockBuilder<UINT64>,
+                          DeltaBitPackedBlockDecoder<UINT64>, UINT64>(&ibb);
+  }
+
+  // Timestamps a few milliseconds apart.
+  const uint32_t kSize = 10000;
+  gscoped_ptr<int64_t[]> timestamps(new int64_t[kSize]);
+  timestamps[0] = 1457000000000000L;
+  for (int i = 1; i < kSize; i++) {
+    timestamps[i] = timestamps[i - 1] + random() % 5000;
+  }
+  TestEncodeDecodeTemplateBlockEncoder<INT64, DeltaBitPackedBlockBuilder<INT64>,
+                                       DeltaBitPackedBlockDecoder<INT64> >(timestamps.get(), kSize);
+
+  // Deltas which overflow.
+  gscoped_ptr<int64_t[]> extremes(new int64_t[kSize]);
+  for (int i = 0; i < kSize; i++) {
+    extremes[i] = (i % 2 == 0) ? std::numeric_limits<int64_t>::min()
+                               : std::numeric_limits<int64_t>::max();
+  }
+  TestEncodeDecodeTemplateBlockEncoder<INT64, DeltaBitPackedBlockBuilder<INT64>,
+                                       DeltaBitPackedBlockDecoder<INT64> >(extremes.get(), kSize);
+}
+
+TEST_F(TestEncoding, TestDeltaBitPackedBlockSize) {
+  gscoped_ptr<WriterOptions> opts(NewWriterOptions());
+  DeltaBitPackedBlockBuilder<INT64> ibb(opts.get());
+
+  // Consecutive values pack to zero bits, leaving only the block header
+  // (8 bytes), the miniblock headers (17 bytes each) and the padding.
+  const int kCount = 10000;
+  gscoped_ptr<int64_t[]> ints(new int64_t[kCount]);
+  for (int i = 0; i < kCount; i++) {
+    ints[i] = 1000000 + i;
+  }
+  ASSERT_EQ(kCount, ibb.Add(reinterpret_cast<const uint8_t *>(ints.get()), kCount));
+  Slice s = ibb.Finish(12345);
+  const int kNumMiniblocks = (kCount + 127) / 128;
+  ASSERT_EQ(8 + kNumMiniblocks * 17 + 8, s.size());
+
+  // Small deltas take a few bits each.
+  ibb.Reset();
+  for (int i = 1; i < kCount; i++) {
+    ints[i] = ints[i - 1] + random() % 16;
+  }
+  ASSERT_EQ(kCount, ibb.Add(reinterpret_cast<const uint8_t *>(ints.get()), kCount));
+  s = ibb.Finish(12345);
+  LOG(INFO) << "Delta bit-packed size for 10k ints with small deltas: " << s.size();
+  ASSERT_LE(s.size(), 8 + kNumMiniblocks * (17 + 128 * 4 / 8) + 8);
+
+  TestEmptyBlockEncodeDecode<DeltaBitPackedBlockBuilder<INT64>,
+                             DeltaBitPackedBlockDecoder<INT64> >();
+}
+
+TEST_F(TestEncoding, TestDeltaBitPackedBlockSeek) {
+  gscoped_ptr<WriterOptions> opts(NewWriterOptions());
+  for (int num_ints : { 1, 2, 15, 127, 128, 129, 1000, 10000 }) {
+    SCOPED_TRACE(num_ints);
+    {
+      DeltaBitPackedBlockBuilder<INT64> ibb(opts.get());
+      DoSeekTest<DeltaBitPackedBlockBuilder<INT64>, DeltaBitPackedBlockDecoder<INT64>, INT64>(
+          &ibb, num_ints, 1000, true);
+    }
+    {
+      DeltaBitPackedBlockBuilder<UINT64> ibb(opts.get());
+      DoSeekTest<DeltaBitPackedBlockBuilder<UINT64>, DeltaBitPackedBlockDecoder<UINT64>, UINT64>(
+          &ibb, num_ints, 1000, true);
+    }
+  }
+}
+
 TEST_F(TestEncoding, TestPlainBitMapRoundTrip) {
   TestBoolBlockRoundTrip<PlainBitMapBlockBuilder, PlainBitMapBlockDecoder>();
 }
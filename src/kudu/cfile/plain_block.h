@@ -217,6 +217,13 @@ class PlainBlockDecoder : public BlockDecoder {
     return ordinal_pos_base_;
   }
 
+  virtual bool GetCellsInPlace(size_t pos, size_t n, Slice *cells) const OVERRIDE {
+    DCHECK(parsed_);
+    DCHECK_LE(pos + n, num_elems_);
+    *cells = Slice(&data_[kPlainBlockHeaderSize + pos * size_of_type], n * size_of_type);
+    return true;
+  }
+
  private:
 
   Slice data_;
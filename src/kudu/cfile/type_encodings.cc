@@ -19,10 +19,12 @@
 #include <unordered_map>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include <glog/logging.h>
 
 #include "kudu/cfile/bshuf_block.h"
+#include "kudu/cfile/delta_bitpacked_block.h"
 #include "kudu/cfile/gvint_block.h"
 #include "kudu/cfile/plain_bitmap_block.h"
 #include "kudu/cfile/plain_block.h"
@@ -38,6 +40,7 @@ namespace cfile {
 
 using std::unordered_map;
 using std::shared_ptr;
+using std::vector;
 
 
 template<DataType Type, EncodingType Encoding>
@@ -85,6 +88,22 @@ struct DataTypeEncodingTraits<Type, BIT_SHUFFLE> {
   }
 };
 
+// Generic partial specialization for the 64-bit integer types.
+template<DataType Type>
+struct DataTypeEncodingTraits<Type, DELTA_BITPACKED> {
+
+  static Status CreateBlockBuilder(BlockBuilder **bb, const WriterOptions *options) {
+    *bb = new DeltaBitPackedBlockBuilder<Type>(options);
+    return Status::OK();
+  }
+
+  static Status CreateBlockDecoder(BlockDecoder **bd, const Slice &slice,
+                                   CFileIterator *iter) {
+    *bd = new DeltaBitPackedBlockDecoder<Type>(slice);
+    return Status::OK();
+  }
+};
+
 // Template specialization for plain encoded string as they require a
 // specific encoder/decoder.
 template<>
@@ -250,6 +269,10 @@ class TypeEncodingResolver {
     return default_mapping_[t];
   }
 
+  const vector<EncodingType>& GetSupportedEncodings(DataType t) {
+    return supported_encodings_[t];
+  }
+
   // Add the encoding mappings
   // the first encoder/decoder to be
   // added to the mapping becomes the default
@@ -280,8 +303,10 @@ class TypeEncodingResolver {
     AddMapping<INT32, BIT_SHUFFLE>();
     AddMapping<UINT64, PLAIN_ENCODING>();
     AddMapping<UINT64, BIT_SHUFFLE>();
+    AddMapping<UINT64, DELTA_BITPACKED>();
     AddMapping<INT64, PLAIN_ENCODING>();
     AddMapping<INT64, BIT_SHUFFLE>();
+    AddMapping<INT64, DELTA_BITPACKED>();
     AddMapping<FLOAT, PLAIN_ENCODING>();
     AddMapping<FLOAT, BIT_SHUFFLE>();
     AddMapping<DOUBLE, PLAIN_ENCODING>();
@@ -298,6 +323,7 @@ class TypeEncodingResolver {
     pair<DataType, EncodingType> encoding_for_type = make_pair(type, encoding);
     if (mapping_.find(encoding_for_type) == mapping_.end()) {
       default_mapping_.insert(make_pair(type, encoding));
+      supported_encodings_[type].push_back(encoding);
     }
     mapping_.insert(
         make_pair(make_pair(type, encoding),
@@ -310,6 +336,8 @@ class TypeEncodingResolver {
 
   unordered_map<DataType, EncodingType, std::hash<size_t> > default_mapping_;
 
+  unordered_map<DataType, vector<EncodingType>, std::hash<size_t> > supported_encodings_;
+
   friend class Singleton<TypeEncodingResolver>;
   DISALLOW_COPY_AND_ASSIGN(TypeEncodingResolver);
 };
@@ -326,6 +354,11 @@ const EncodingType TypeEncodingInfo::GetDefaultEncoding(const TypeInfo* typeinfo
   return Singleton<TypeEncodingResolver>::get()->GetDefaultEncoding(typeinfo->physical_type());
 }
 
+vector<EncodingType> TypeEncodingInfo::GetSupportedEncodings(const TypeInfo* typeinfo) {
+  return Singleton<TypeEncodingResolver>::get()->GetSupportedEncodings(
+      typeinfo->physical_type());
+}
+
 }  // namespace cfile
 }  // namespace kudu
 
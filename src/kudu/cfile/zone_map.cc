@@ -0,0 +1,230 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/cfile/zone_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glog/logging.h>
+#include <string.h>
+
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/types.h"
+#include "kudu/util/slice.h"
+
+namespace kudu {
+namespace cfile {
+
+// Binary values longer than this are truncated when stored as the min value
+// of a zone map, and not stored at all as the max value, so that a few long
+// values don't bloat the zone maps.
+static const size_t kMaxBinaryValueLength = 64;
+
+// The largest fixed-size cell of any type.
+static const size_t kMaxCellSize = 16;
+
+ZoneMapBuilder::ZoneMapBuilder(const TypeInfo* typeinfo)
+    : typeinfo_(typeinfo),
+      is_binary_(typeinfo->physical_type() == BINARY),
+      is_floating_point_(typeinfo->physical_type() == FLOAT ||
+                         typeinfo->physical_type() == DOUBLE) {
+  DCHECK_LE(typeinfo_->size(), kMaxCellSize);
+  min_cell_.resize(typeinfo_->size());
+  max_cell_.resize(typeinfo_->size());
+  Reset();
+}
+
+void ZoneMapBuilder::AddValues(const void* values, size_t count) {
+  const uint8_t* cell = reinterpret_cast<const uint8_t*>(values);
+  size_t size = typeinfo_->size();
+  for (size_t i = 0; i < count; i++, cell += size) {
+    if (is_floating_point_ && IsNaN(cell)) {
+      has_nan_ = true;
+      continue;
+    }
+    if (!has_values_ || typeinfo_->Compare(cell, min_cell_.data()) < 0) {
+      CopyCell(cell, &min_cell_, &min_data_);
+    }
+    if (!has_values_ || typeinfo_->Compare(cell, max_cell_.data()) > 0) {
+      CopyCell(cell, &max_cell_, &max_data_);
+    }
+    has_values_ = true;
+  }
+  num_rows_ += count;
+}
+
+void ZoneMapBuilder::AddNulls(size_t count) {
+  num_rows_ += count;
+  null_count_ += count;
+}
+
+void ZoneMapBuilder::Merge(const ZoneMapBuilder& other) {
+  DCHECK_EQ(typeinfo_, other.typeinfo_);
+  if (other.has_values_) {
+    if (!has_values_ || typeinfo_->Compare(other.min_cell_.data(), min_cell_.data()) < 0) {
+      CopyCell(other.min_cell_.data(), &min_cell_, &min_data_);
+    }
+    if (!has_values_ || typeinfo_->Compare(other.max_cell_.data(), max_cell_.data()) > 0) {
+      CopyCell(other.max_cell_.data(), &max_cell_, &max_data_);
+    }
+    has_values_ = true;
+  }
+  num_rows_ += other.num_rows_;
+  null_count_ += other.null_count_;
+  has_nan_ |= other.has_nan_;
+}
+
+void ZoneMapBuilder::ToPB(rowid_t first_ordinal, ZoneMapPB* pb) const {
+  pb->Clear();
+  pb->set_first_ordinal(first_ordinal);
+  pb->set_num_rows(num_rows_);
+  if (null_count_ > 0) {
+    pb->set_null_count(null_count_);
+  }
+  if (has_nan_) {
+    pb->set_has_nan(true);
+  }
+  if (!has_values_) {
+    return;
+  }
+
+  if (is_binary_) {
+    const Slice* min = reinterpret_cast<const Slice*>(min_cell_.data());
+    const Slice* max = reinterpret_cast<const Slice*>(max_cell_.data());
+    // A prefix of the min value is still a lower bound, but a prefix of the
+    // max value is not an upper bound.
+    pb->set_min_value(min->data(), std::min(min->size(), kMaxBinaryValueLength));
+    if (max->size() <= kMaxBinaryValueLength) {
+      pb->set_max_value(max->data(), max->size());
+    }
+  } else {
+    pb->set_min_value(min_cell_.data(), min_cell_.size());
+    pb->set_max_value(max_cell_.data(), max_cell_.size());
+  }
+}
+
+void ZoneMapBuilder::Reset() {
+  num_rows_ = 0;
+  null_count_ = 0;
+  has_nan_ = false;
+  has_values_ = false;
+}
+
+bool ZoneMapBuilder::IsNaN(const void* cell) const {
+  if (typeinfo_->physical_type() == FLOAT) {
+    return std::isnan(*reinterpret_cast<const float*>(cell));
+  }
+  return std::isnan(*reinterpret_cast<const double*>(cell));
+}
+
+void ZoneMapBuilder::CopyCell(const void* src, faststring* cell, faststring* indirect_data) {
+  if (is_binary_) {
+    const Slice* value = reinterpret_cast<const Slice*>(src);
+    indirect_data->assign_copy(value->data(), value->size());
+    Slice copy(indirect_data->data(), indirect_data->size());
+    memcpy(cell->data(), &copy, sizeof(copy));
+  } else {
+    memcpy(cell->data(), src, cell->size());
+  }
+}
+
+namespace {
+
+// A min or max value of a zone map, decoded back into a cell of the column's
+// type.
+class ZoneMapBound {
+ public:
+  ZoneMapBound(const TypeInfo* typeinfo, bool present, const std::string& value)
+      : present_(present) {
+    if (!present_) {
+      return;
+    }
+    if (typeinfo->physical_type() == BINARY) {
+      Slice s(value);
+      memcpy(cell_, &s, sizeof(s));
+    } else if (PREDICT_TRUE(value.size() == typeinfo->size())) {
+      // Copy the value out so that the cell is suitably aligned.
+      memcpy(cell_, value.data(), value.size());
+    } else {
+      present_ = false;
+    }
+  }
+
+  bool present() const { return present_; }
+  const void* cell() const { return cell_; }
+
+ private:
+  bool present_;
+  uint64_t cell_[kMaxCellSize / sizeof(uint64_t)];
+};
+
+} // anonymous namespace
+
+bool ZoneMapMayMatch(const ZoneMapPB& zone_map, const ColumnPredicate& pred) {
+  int64_t num_values = zone_map.num_rows() - zone_map.null_count();
+  switch (pred.predicate_type()) {
+    case PredicateType::None: return false;
+    case PredicateType::IsNull: return zone_map.null_count() > 0;
+    case PredicateType::IsNotNull: return num_values > 0;
+    case PredicateType::Equality:
+    case PredicateType::Range:
+    case PredicateType::InList: break;
+  }
+
+  // The remaining predicates never match null values.
+  if (num_values == 0) {
+    return false;
+  }
+
+  // Under TypeInfo::Compare(), NaN is neither less nor greater than any
+  // value, so it satisfies equalities and open-ended ranges alike.
+  if (zone_map.has_nan()) {
+    return true;
+  }
+
+  const TypeInfo* typeinfo = pred.column().type_info();
+  ZoneMapBound min(typeinfo, zone_map.has_min_value(), zone_map.min_value());
+  ZoneMapBound max(typeinfo, zone_map.has_max_value(), zone_map.max_value());
+  auto within_bounds = [&] (const void* value) {
+    return (!min.present() || typeinfo->Compare(value, min.cell()) >= 0) &&
+           (!max.present() || typeinfo->Compare(value, max.cell()) <= 0);
+  };
+
+  switch (pred.predicate_type()) {
+    case PredicateType::Equality:
+      return within_bounds(pred.raw_lower());
+    case PredicateType::Range:
+      // The lower bound is inclusive, and the upper bound exclusive.
+      if (pred.raw_lower() != nullptr && max.present() &&
+          typeinfo->Compare(pred.raw_lower(), max.cell()) > 0) {
+        return false;
+      }
+      if (pred.raw_upper() != nullptr && min.present() &&
+          typeinfo->Compare(pred.raw_upper(), min.cell()) <= 0) {
+        return false;
+      }
+      return true;
+    case PredicateType::InList:
+      return std::any_of(pred.raw_values().begin(), pred.raw_values().end(), within_bounds);
+    default:
+      LOG(FATAL) << "unexpected predicate type: " << pred.ToString();
+  }
+  return true;
+}
+
+} // namespace cfile
+} // namespace kudu
@@ -0,0 +1,103 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CFILE_ZONE_MAP_H
+#define KUDU_CFILE_ZONE_MAP_H
+
+#include <stddef.h>
+
+#include "kudu/cfile/cfile.pb.h"
+#include "kudu/common/rowid.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/faststring.h"
+
+namespace kudu {
+
+class ColumnPredicate;
+class TypeInfo;
+
+namespace cfile {
+
+// Accumulates the zone map (the min and max values and the null count) of a
+// range of rows of a CFile as the rows are appended.
+class ZoneMapBuilder {
+ public:
+  explicit ZoneMapBuilder(const TypeInfo* typeinfo);
+
+  // Add 'count' non-null values, laid out contiguously as cells of the
+  // builder's type starting at 'values'.
+  void AddValues(const void* values, size_t count);
+
+  // Add 'count' null values.
+  void AddNulls(size_t count);
+
+  // Add the rows accumulated by 'other', which must be of the same type.
+  void Merge(const ZoneMapBuilder& other);
+
+  // Fill in 'pb' with the zone map of the rows added since the last Reset().
+  // 'first_ordinal' is the ordinal of the first of those rows.
+  void ToPB(rowid_t first_ordinal, ZoneMapPB* pb) const;
+
+  void Reset();
+
+  // The number of rows added since the last Reset().
+  size_t num_rows() const {
+    return num_rows_;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ZoneMapBuilder);
+
+  // Returns true if the cell at 'cell' of the builder's floating point type
+  // is NaN.
+  bool IsNaN(const void* cell) const;
+
+  // Copy the cell at 'src' into 'cell', copying any indirect data into
+  // 'indirect_data'.
+  void CopyCell(const void* src, faststring* cell, faststring* indirect_data);
+
+  const TypeInfo* typeinfo_;
+  const bool is_binary_;
+  const bool is_floating_point_;
+
+  size_t num_rows_;
+  size_t null_count_;
+
+  // Whether any of the values added is NaN.
+  bool has_nan_;
+
+  // Whether any non-null values have been added, i.e. whether min_cell_ and
+  // max_cell_ are valid.
+  bool has_values_;
+
+  // The cells of the min and max values. For binary types, the cells are
+  // Slices pointing into the corresponding *_data_ buffers.
+  faststring min_cell_;
+  faststring max_cell_;
+  faststring min_data_;
+  faststring max_data_;
+};
+
+// Returns false if 'zone_map' shows that 'pred' matches none of the rows it
+// covers. Returns true if some of them may match.
+//
+// The zone map must belong to a CFile of the predicate column's type.
+bool ZoneMapMayMatch(const ZoneMapPB& zone_map, const ColumnPredicate& pred);
+
+} // namespace cfile
+} // namespace kudu
+
+#endif
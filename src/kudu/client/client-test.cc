@@ -69,9 +69,12 @@ DECLARE_int32(scanner_gc_check_interval_us);
 DECLARE_int32(scanner_inject_latency_on_each_batch_ms);
 DECLARE_int32(scanner_max_batch_size_bytes);
 DECLARE_int32(scanner_ttl_ms);
+DECLARE_string(scanner_sidecar_compression_codecs);
 DEFINE_int32(test_scan_num_rows, 1000, "Number of rows to insert and scan");
 
 METRIC_DECLARE_counter(rpcs_queue_overflow);
+METRIC_DECLARE_counter(scanner_sidecar_bytes_before_compression);
+METRIC_DECLARE_counter(scanner_sidecar_bytes_saved_by_compression);
 
 using std::string;
 using std::set;
@@ -736,6 +739,135 @@ TEST_F(ClientTest, TestScanEmptyProjection) {
   }
 }
 
+// Test a scan which returns its rows in the columnar layout.
+TEST_F(ClientTest, TestScanColumnarLayout) {
+  // Flush half of the rows, so that both flushed and in-memory rows are
+  // scanned: the cells of flushed columns may be sent in several sidecars.
+  int half = FLAGS_test_scan_num_rows / 2;
+  ASSERT_NO_FATAL_FAILURE(InsertTestRows(client_table_.get(), half));
+  for (int i = 0; i < cluster_->num_tablet_servers(); i++) {
+    vector<scoped_refptr<TabletPeer>> tablet_peers;
+    cluster_->mini_tablet_server(i)->server()->tablet_manager()->GetTabletPeers(&tablet_peers);
+    for (const scoped_refptr<TabletPeer>& tablet_peer : tablet_peers) {
+      ASSERT_OK(tablet_peer->tablet()->Flush());
+    }
+  }
+  ASSERT_NO_FATAL_FAILURE(InsertTestRows(client_table_.get(),
+                                         FLAGS_test_scan_num_rows - half, half));
+  KuduScanner scanner(client_table_.get());
+  ASSERT_OK(scanner.SetProjectedColumns({ "string_val", "key" }));
+  ASSERT_OK(scanner.SetRowFormatFlags(KuduScanner::COLUMNAR_LAYOUT));
+  ASSERT_OK(scanner.Open());
+  ASSERT_TRUE(scanner.SetRowFormatFlags(KuduScanner::NO_FLAGS).IsIllegalState());
+
+  // The row-wise batch may not be used with the columnar layout.
+  KuduScanBatch rowwise_batch;
+  ASSERT_TRUE(scanner.NextBatch(&rowwise_batch).IsIllegalState());
+
+  KuduColumnarScanBatch batch;
+  vector<bool> seen(FLAGS_test_scan_num_rows);
+  int count = 0;
+  while (scanner.HasMoreRows()) {
+    ASSERT_OK(scanner.NextBatch(&batch));
+    int num_rows = batch.NumRows();
+
+    Slice offsets, strings, non_null_bitmap, keys;
+    ASSERT_OK(batch.GetVariableLengthColumn(0, &offsets, &strings));
+    ASSERT_OK(batch.GetNonNullBitmapForColumn(0, &non_null_bitmap));
+    ASSERT_OK(batch.GetFixedLengthColumn(1, &keys));
+    ASSERT_EQ((num_rows + 1) * sizeof(uint32_t), offsets.size());
+    ASSERT_EQ(num_rows * sizeof(int32_t), keys.size());
+
+    // Access which does not match the type of the column fails.
+    Slice unused;
+    ASSERT_TRUE(batch.GetFixedLengthColumn(0, &unused).IsInvalidArgument());
+    ASSERT_TRUE(batch.GetNonNullBitmapForColumn(1, &unused).IsInvalidArgument());
+    ASSERT_TRUE(batch.GetFixedLengthColumn(2, &unused).IsInvalidArgument());
+
+    const uint32_t* offsets_data = reinterpret_cast<const uint32_t*>(offsets.data());
+    const int32_t* keys_data = reinterpret_cast<const int32_t*>(keys.data());
+    for (int i = 0; i < num_rows; i++) {
+      int32_t key = keys_data[i];
+      ASSERT_GE(key, 0);
+      ASSERT_LT(key, FLAGS_test_scan_num_rows);
+      ASSERT_FALSE(seen[key]);
+      seen[key] = true;
+      ASSERT_TRUE(BitmapTest(non_null_bitmap.data(), i));
+      Slice val(strings.data() + offsets_data[i], offsets_data[i + 1] - offsets_data[i]);
+      ASSERT_EQ(StringPrintf("hello %d", key), val.ToString());
+    }
+    count += num_rows;
+  }
+  ASSERT_EQ(FLAGS_test_scan_num_rows, count);
+}
+
+// Scans all the rows of 'table' asking for responses compressed with
+// 'compression', and checks them.
+static void ScanWithResponseCompression(KuduTable* table,
+                                        KuduColumnStorageAttributes::CompressionType compression,
+                                        int expected_rows) {
+  KuduScanner scanner(table);
+  ASSERT_OK(scanner.SetProjectedColumns({ "key", "string_val" }));
+  ASSERT_OK(scanner.SetResponseCompression(compression));
+  ASSERT_OK(scanner.Open());
+  ASSERT_TRUE(scanner.SetResponseCompression(compression).IsIllegalState());
+
+  KuduScanBatch batch;
+  vector<bool> seen(expected_rows);
+  int count = 0;
+  while (scanner.HasMoreRows()) {
+    ASSERT_OK(scanner.NextBatch(&batch));
+    for (int i = 0; i < batch.NumRows(); i++) {
+      KuduScanBatch::RowPtr row = batch.Row(i);
+      int32_t key;
+      Slice val;
+      ASSERT_OK(row.GetInt32(0, &key));
+      ASSERT_OK(row.GetString(1, &val));
+      ASSERT_GE(key, 0);
+      ASSERT_LT(key, expected_rows);
+      ASSERT_FALSE(seen[key]);
+      seen[key] = true;
+      ASSERT_EQ(StringPrintf("hello %d", key), val.ToString());
+    }
+    count += batch.NumRows();
+  }
+  ASSERT_EQ(expected_rows, count);
+}
+
+TEST_F(ClientTest, TestScanWithResponseCompression) {
+  ASSERT_NO_FATAL_FAILURE(InsertTestRows(client_table_.get(),
+                                         FLAGS_test_scan_num_rows));
+  scoped_refptr<MetricEntity> entity =
+      cluster_->mini_tablet_server(0)->server()->metric_entity();
+  scoped_refptr<Counter> bytes_before =
+      METRIC_scanner_sidecar_bytes_before_compression.Instantiate(entity);
+  scoped_refptr<Counter> bytes_saved =
+      METRIC_scanner_sidecar_bytes_saved_by_compression.Instantiate(entity);
+
+  KuduScanner scanner(client_table_.get());
+  ASSERT_TRUE(scanner.SetResponseCompression(
+      KuduColumnStorageAttributes::DEFAULT_COMPRESSION).IsInvalidArgument());
+
+  for (auto compression : { KuduColumnStorageAttributes::LZ4,
+                            KuduColumnStorageAttributes::SNAPPY }) {
+    SCOPED_TRACE(compression);
+    int64_t before = bytes_before->value();
+    int64_t saved = bytes_saved->value();
+    NO_FATALS(ScanWithResponseCompression(client_table_.get(), compression,
+                                          FLAGS_test_scan_num_rows));
+    ASSERT_GT(bytes_before->value(), before);
+    ASSERT_GT(bytes_saved->value(), saved);
+  }
+
+  // A codec which the tablet server is not configured to use is ignored,
+  // and the rows are returned uncompressed.
+  FLAGS_scanner_sidecar_compression_codecs = "snappy";
+  int64_t before = bytes_before->value();
+  NO_FATALS(ScanWithResponseCompression(client_table_.get(), KuduColumnStorageAttributes::LZ4,
+                                        FLAGS_test_scan_num_rows));
+  ASSERT_EQ(before, bytes_before->value());
+}
+
 TEST_F(ClientTest, TestProjectInvalidColumn) {
   KuduScanner scanner(client_table_.get());
   Status s = scanner.SetProjectedColumns({ "column-doesnt-exist" });
@@ -823,6 +955,184 @@ TEST_F(ClientTest, TestScanPredicateNonKeyColNotProjected) {
   ASSERT_EQ(nrows, 6);
 }
 
+// Test a scan with IN list predicates on a key and a non-key column.
+TEST_F(ClientTest, TestScanInListPredicate) {
+  ASSERT_NO_FATAL_FAILURE(InsertTestRows(client_table_.get(),
+                                         FLAGS_test_scan_num_rows));
+  KuduScanner scanner(client_table_.get());
+  vector<KuduValue*> keys = { KuduValue::FromInt(11), KuduValue::FromInt(3),
+                              KuduValue::FromInt(7) };
+  ASSERT_OK(scanner.AddConjunctPredicate(client_table_->NewInListPredicate("key", &keys)));
+  ASSERT_TRUE(keys.empty());
+  vector<KuduValue*> int_vals = { KuduValue::FromInt(14), KuduValue::FromInt(22),
+                                  KuduValue::FromInt(40) };
+  ASSERT_OK(scanner.AddConjunctPredicate(
+                client_table_->NewInListPredicate("int_val", &int_vals)));
+
+  vector<int32_t> found_keys;
+  ASSERT_OK(scanner.Open());
+  KuduScanBatch batch;
+  while (scanner.HasMoreRows()) {
+    ASSERT_OK(scanner.NextBatch(&batch));
+    for (const KuduScanBatch::RowPtr& row : batch) {
+      int32_t key;
+      ASSERT_OK(row.GetInt32(0, &key));
+      found_keys.push_back(key);
+    }
+  }
+  std::sort(found_keys.begin(), found_keys.end());
+  ASSERT_EQ((vector<int32_t>{ 7, 11 }), found_keys);
+
+  // An IN list predicate on a column that does not exist.
+  vector<KuduValue*> bad_vals = { KuduValue::FromInt(1) };
+  KuduScanner bad_scanner(client_table_.get());
+  Status s = bad_scanner.AddConjunctPredicate(
+      client_table_->NewInListPredicate("this-does-not-exist", &bad_vals));
+  EXPECT_EQ("Not found: column not found: this-does-not-exist", s.ToString());
+
+  // An IN list predicate with a value of the wrong type.
+  bad_vals = { KuduValue::FromInt(1), KuduValue::CopyString("x") };
+  s = bad_scanner.AddConjunctPredicate(client_table_->NewInListPredicate("int_val", &bad_vals));
+  EXPECT_EQ("Invalid argument: non-int value for int column int_val", s.ToString());
+}
+
+TEST_F(ClientTest, TestScanNullPredicates) {
+  // Every third row has a NULL string_val.
+  const int kNumRows = 100;
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::MANUAL_FLUSH));
+  session->SetTimeoutMillis(10000);
+  for (int i = 0; i < kNumRows; i++) {
+    gscoped_ptr<KuduInsert> insert(BuildTestRow(client_table_.get(), i));
+    if (i % 3 == 0) {
+      ASSERT_OK(insert->mutable_row()->SetNull("string_val"));
+    }
+    ASSERT_OK(session->Apply(insert.release()));
+  }
+  FlushSessionOrDie(session);
+
+  for (bool is_null : { true, false }) {
+    SCOPED_TRACE(is_null ? "IS NULL" : "IS NOT NULL");
+    KuduScanner scanner(client_table_.get());
+    ASSERT_OK(scanner.AddConjunctPredicate(
+                  is_null ? client_table_->NewIsNullPredicate("string_val")
+                          : client_table_->NewIsNotNullPredicate("string_val")));
+    ASSERT_OK(scanner.Open());
+    int count = 0;
+    KuduScanBatch batch;
+    while (scanner.HasMoreRows()) {
+      ASSERT_OK(scanner.NextBatch(&batch));
+      for (const KuduScanBatch::RowPtr& row : batch) {
+        int32_t key;
+        ASSERT_OK(row.GetInt32(0, &key));
+        ASSERT_EQ(is_null, key % 3 == 0) << "key " << key;
+        count++;
+      }
+    }
+    ASSERT_EQ(is_null ? 34 : 66, count);
+  }
+
+  // IS NULL on a column which is not nullable matches nothing.
+  KuduScanner scanner(client_table_.get());
+  ASSERT_OK(scanner.AddConjunctPredicate(client_table_->NewIsNullPredicate("int_val")));
+  vector<string> rows;
+  ScanToStrings(&scanner, &rows);
+  ASSERT_TRUE(rows.empty());
+
+  KuduScanner bad_scanner(client_table_.get());
+  Status s = bad_scanner.AddConjunctPredicate(
+      client_table_->NewIsNotNullPredicate("this-does-not-exist"));
+  EXPECT_EQ("Not found: column not found: this-does-not-exist", s.ToString());
+}
+
+TEST_F(ClientTest, TestScanAggregates) {
+  // Every third row has a NULL string_val.
+  const int kNumRows = 100;
+  shared_ptr<KuduSession> session = client_->NewSession();
+  ASSERT_OK(session->SetFlushMode(KuduSession::MANUAL_FLUSH));
+  session->SetTimeoutMillis(10000);
+  for (int i = 0; i < kNumRows; i++) {
+    gscoped_ptr<KuduInsert> insert(BuildTestRow(client_table_.get(), i));
+    if (i % 3 == 0) {
+      ASSERT_OK(insert->mutable_row()->SetNull("string_val"));
+    }
+    ASSERT_OK(session->Apply(insert.release()));
+  }
+  FlushSessionOrDie(session);
+
+  {
+    KuduScanner scanner(client_table_.get());
+    ASSERT_OK(scanner.AddAggregate(KuduScanner::COUNT, ""));
+    ASSERT_OK(scanner.AddAggregate(KuduScanner::COUNT, "string_val"));
+    ASSERT_OK(scanner.AddAggregate(KuduScanner::SUM, "int_val"));
+    ASSERT_OK(scanner.AddAggregate(KuduScanner::MIN, "key"));
+    ASSERT_OK(scanner.AddAggregate(KuduScanner::MAX, "string_val"));
+    ASSERT_OK(scanner.Open());
+    KuduScanBatch batch;
+    while (scanner.HasMoreRows()) {
+      ASSERT_OK(scanner.NextBatch(&batch));
+      ASSERT_EQ(0, batch.NumRows());
+    }
+
+    KuduScanBatch::RowPtr result;
+    ASSERT_OK(scanner.GetAggregateResult(&result));
+    int64_t count;
+    ASSERT_OK(result.GetInt64("COUNT(*)", &count));
+    ASSERT_EQ(kNumRows, count);
+    ASSERT_OK(result.GetInt64("COUNT(string_val)", &count));
+    ASSERT_EQ(66, count);
+    int64_t sum;
+    ASSERT_OK(result.GetInt64("SUM(int_val)", &sum));
+    ASSERT_EQ(9900, sum);
+    int32_t min_key;
+    ASSERT_OK(result.GetInt32("MIN(key)", &min_key));
+    ASSERT_EQ(0, min_key);
+    Slice max_string;
+    ASSERT_OK(result.GetString("MAX(string_val)", &max_string));
+    ASSERT_EQ("hello 98", max_string.ToString());
+  }
+
+  // Aggregates are computed over the rows which pass the predicates, and are
+  // NULL if no values pass them.
+  {
+    KuduScanner scanner(client_table_.get());
+    ASSERT_OK(scanner.AddConjunctPredicate(client_table_->NewComparisonPredicate(
+        "key", KuduPredicate::GREATER_EQUAL, KuduValue::FromInt(kNumRows))));
+    ASSERT_OK(scanner.AddAggregate(KuduScanner::COUNT, ""));
+    ASSERT_OK(scanner.AddAggregate(KuduScanner::MAX, "int_val"));
+    ASSERT_OK(scanner.Open());
+    KuduScanBatch batch;
+    while (scanner.HasMoreRows()) {
+      ASSERT_OK(scanner.NextBatch(&batch));
+    }
+    KuduScanBatch::RowPtr result;
+    ASSERT_OK(scanner.GetAggregateResult(&result));
+    int64_t count;
+    ASSERT_OK(result.GetInt64(0, &count));
+    ASSERT_EQ(0, count);
+    ASSERT_TRUE(result.IsNull(1));
+  }
+
+  // Invalid aggregates.
+  {
+    KuduScanner scanner(client_table_.get());
+    Status s = scanner.AddAggregate(KuduScanner::SUM, "");
+    ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+    s = scanner.AddAggregate(KuduScanner::MIN, "this-does-not-exist");
+    ASSERT_TRUE(s.IsNotFound()) << s.ToString();
+    ASSERT_OK(scanner.AddAggregate(KuduScanner::SUM, "string_val"));
+    s = scanner.Open();
+    ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  }
+  {
+    KuduScanner scanner(client_table_.get());
+    ASSERT_OK(scanner.AddAggregate(KuduScanner::COUNT, ""));
+    ASSERT_OK(scanner.SetFaultTolerant());
+    Status s = scanner.Open();
+    ASSERT_TRUE(s.IsNotSupported()) << s.ToString();
+  }
+}
+
 // Test adding various sorts of invalid binary predicates.
 TEST_F(ClientTest, TestInvalidPredicates) {
   KuduScanner scanner(client_table_.get());
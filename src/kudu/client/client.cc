@@ -45,6 +45,7 @@
 #include "kudu/common/row_operations.h"
 #include "kudu/common/wire_protocol.h"
 #include "kudu/gutil/map-util.h"
+#include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/master/master.h" // TODO: remove this include - just needed for default port
 #include "kudu/master/master.pb.h"
@@ -94,6 +95,10 @@ MAKE_ENUM_LIMITS(kudu::client::KuduScanner::OrderMode,
                  kudu::client::KuduScanner::UNORDERED,
                  kudu::client::KuduScanner::ORDERED);
 
+MAKE_ENUM_LIMITS(kudu::client::KuduScanner::AggregateFunction,
+                 kudu::client::KuduScanner::COUNT,
+                 kudu::client::KuduScanner::MAX);
+
 namespace kudu {
 namespace client {
 
@@ -588,6 +593,45 @@ KuduPredicate* KuduTable::NewComparisonPredicate(const Slice& col_name,
   return new KuduPredicate(new ComparisonPredicateData(s->column(col_idx), op, value));
 }
 
+KuduPredicate* KuduTable::NewInListPredicate(const Slice& col_name,
+                                             vector<KuduValue*>* values) {
+  StringPiece name_sp(reinterpret_cast<const char*>(col_name.data()), col_name.size());
+  const Schema* s = data_->schema_.schema_;
+  int col_idx = s->find_column(name_sp);
+  if (col_idx == Schema::kColumnNotFound) {
+    // As in NewComparisonPredicate(), we always take ownership of 'values'.
+    STLDeleteElements(values);
+    return new KuduPredicate(new ErrorPredicateData(
+                                 Status::NotFound("column not found", col_name)));
+  }
+
+  return new KuduPredicate(new InListPredicateData(s->column(col_idx), values));
+}
+
+KuduPredicate* KuduTable::NewIsNotNullPredicate(const Slice& col_name) {
+  StringPiece name_sp(reinterpret_cast<const char*>(col_name.data()), col_name.size());
+  const Schema* s = data_->schema_.schema_;
+  int col_idx = s->find_column(name_sp);
+  if (col_idx == Schema::kColumnNotFound) {
+    return new KuduPredicate(new ErrorPredicateData(
+                                 Status::NotFound("column not found", col_name)));
+  }
+
+  return new KuduPredicate(new IsNotNullPredicateData(s->column(col_idx)));
+}
+
+KuduPredicate* KuduTable::NewIsNullPredicate(const Slice& col_name) {
+  StringPiece name_sp(reinterpret_cast<const char*>(col_name.data()), col_name.size());
+  const Schema* s = data_->schema_.schema_;
+  int col_idx = s->find_column(name_sp);
+  if (col_idx == Schema::kColumnNotFound) {
+    return new KuduPredicate(new ErrorPredicateData(
+                                 Status::NotFound("column not found", col_name)));
+  }
+
+  return new KuduPredicate(new IsNullPredicateData(s->column(col_idx)));
+}
+
 ////////////////////////////////////////////////////////////
 // Error
 ////////////////////////////////////////////////////////////
@@ -826,6 +870,9 @@ Status KuduTableAlterer::Alter() {
 // KuduScanner
 ////////////////////////////////////////////////////////////
 
+const uint64_t KuduScanner::NO_FLAGS = 0;
+const uint64_t KuduScanner::COLUMNAR_LAYOUT = 1 << 0;
+
 KuduScanner::KuduScanner(KuduTable* table)
   : data_(new KuduScanner::Data(table)) {
 }
@@ -961,6 +1008,37 @@ Status KuduScanner::AddConjunctPredicate(KuduPredicate* pred) {
   return pred->data_->AddToScanSpec(&data_->spec_);
 }
 
+Status KuduScanner::AddAggregate(AggregateFunction function, const string& column_name) {
+  if (data_->open_) {
+    return Status::IllegalState("Aggregates must be added before Open()");
+  }
+  if (!tight_enum_test<AggregateFunction>(function)) {
+    return Status::InvalidArgument("Bad aggregate function");
+  }
+
+  int col_idx = -1;
+  if (!column_name.empty()) {
+    col_idx = data_->table_->schema().schema_->find_column(column_name);
+    if (col_idx == Schema::kColumnNotFound) {
+      return Status::NotFound(strings::Substitute("Column: \"$0\" was not found in the "
+          "table schema.", column_name));
+    }
+  } else if (function != COUNT) {
+    return Status::InvalidArgument("Only COUNT may be computed without a column");
+  }
+
+  AggregatePB::Function pb_function;
+  switch (function) {
+    case COUNT: pb_function = AggregatePB::COUNT; break;
+    case SUM: pb_function = AggregatePB::SUM; break;
+    case MIN: pb_function = AggregatePB::MIN; break;
+    case MAX: pb_function = AggregatePB::MAX; break;
+    default: LOG(FATAL) << "Unexpected aggregate function";
+  }
+  data_->aggregates_.emplace_back(pb_function, col_idx);
+  return Status::OK();
+}
+
 Status KuduScanner::AddLowerBound(const KuduPartialRow& key) {
   gscoped_ptr<string> enc(new string());
   RETURN_NOT_OK(key.EncodeRowKey(enc.get()));
@@ -1015,6 +1093,29 @@ Status KuduScanner::SetCacheBlocks(bool cache_blocks) {
   return Status::OK();
 }
 
+Status KuduScanner::SetRowFormatFlags(uint64_t flags) {
+  if (data_->open_) {
+    return Status::IllegalState("Row format flags must be set before Open()");
+  }
+  if (flags & ~COLUMNAR_LAYOUT) {
+    return Status::InvalidArgument(strings::Substitute("Invalid row format flags: $0", flags));
+  }
+  data_->row_format_flags_ = flags;
+  return Status::OK();
+}
+
+Status KuduScanner::SetResponseCompression(
+    KuduColumnStorageAttributes::CompressionType compression) {
+  if (data_->open_) {
+    return Status::IllegalState("Response compression must be set before Open()");
+  }
+  if (compression == KuduColumnStorageAttributes::DEFAULT_COMPRESSION) {
+    return Status::InvalidArgument("Response compression must name a codec");
+  }
+  data_->response_compression_ = ToInternalCompressionType(compression);
+  return Status::OK();
+}
+
 KuduSchema KuduScanner::GetProjectionSchema() const {
   return data_->client_projection_;
 }
@@ -1051,6 +1152,14 @@ Status KuduScanner::Open() {
   CHECK(!data_->open_) << "Scanner already open";
   CHECK(data_->projection_ != nullptr) << "No projection provided";
 
+  if (!data_->aggregates_.empty()) {
+    if (data_->is_fault_tolerant_) {
+      // Partial results cannot be taken back if a scan is resumed elsewhere.
+      return Status::NotSupported("Aggregates are not supported in fault-tolerant scans");
+    }
+    RETURN_NOT_OK(data_->SetupAggregates());
+  }
+
   // Find the first tablet.
   data_->spec_encoder_.EncodeRangePredicates(&data_->spec_, false);
 
@@ -1066,7 +1175,8 @@ Status KuduScanner::Open() {
   if (!is_simple_range_partitioned &&
       (data_->spec_.lower_bound_key() != nullptr ||
        data_->spec_.exclusive_upper_bound_key() != nullptr ||
-       !data_->spec_.predicates().empty())) {
+       !data_->spec_.predicates().empty() ||
+       !data_->spec_.column_predicates().empty())) {
     KLOG_FIRST_N(WARNING, 1) << "Starting full table scan. In the future this scan may be "
                                 "automatically optimized with partition pruning.";
   }
@@ -1145,7 +1255,23 @@ Status KuduScanner::NextBatch(vector<KuduRowResult>* rows) {
   return Status::OK();
 }
 
-Status KuduScanner::NextBatch(KuduScanBatch* result) {
+Status KuduScanner::NextBatch(KuduScanBatch* batch) {
+  if (PREDICT_FALSE(data_->row_format_flags_ & COLUMNAR_LAYOUT)) {
+    return Status::IllegalState(
+        "Scans with the columnar layout must use NextBatch(KuduColumnarScanBatch*)");
+  }
+  return NextBatchInternal(batch->data_);
+}
+
+Status KuduScanner::NextBatch(KuduColumnarScanBatch* batch) {
+  if (PREDICT_FALSE(!(data_->row_format_flags_ & COLUMNAR_LAYOUT))) {
+    return Status::IllegalState(
+        "Scans without the columnar layout must use NextBatch(KuduScanBatch*)");
+  }
+  return NextBatchInternal(batch->data_);
+}
+
+Status KuduScanner::NextBatchInternal(internal::ScanBatchDataInterface* batch) {
   // TODO: do some double-buffering here -- when we return this batch
   // we should already have fired off the RPC for the next batch, but
   // need to do some swapping of the response objects around to avoid
@@ -1153,16 +1279,16 @@ Status KuduScanner::NextBatch(KuduScanBatch* result) {
   CHECK(data_->open_);
   CHECK(data_->proxy_);
 
-  result->data_->Clear();
+  batch->Clear();
 
   if (data_->data_in_open_) {
     // We have data from a previous scan.
     VLOG(1) << "Extracting data from scan " << ToString();
     data_->data_in_open_ = false;
-    return result->data_->Reset(&data_->controller_,
-                                data_->projection_,
-                                &data_->client_projection_,
-                                make_gscoped_ptr(data_->last_response_.release_data()));
+    return batch->Reset(&data_->controller_,
+                        data_->projection_,
+                        &data_->client_projection_,
+                        &data_->last_response_);
   } else if (data_->last_response_.has_more_results()) {
     // More data is available in this tablet.
     VLOG(1) << "Continuing scan " << ToString();
@@ -1201,10 +1327,14 @@ Status KuduScanner::NextBatch(KuduScanBatch* result) {
         data_->last_primary_key_ = data_->last_response_.last_primary_key();
       }
       data_->scan_attempts_ = 0;
-      return result->data_->Reset(&data_->controller_,
-                                  data_->projection_,
-                                  &data_->client_projection_,
-                                  make_gscoped_ptr(data_->last_response_.release_data()));
+      if (!data_->aggregators_.empty()) {
+        // Scans with aggregates return partial results rather than rows.
+        return data_->MergeAggregateResults();
+      }
+      return batch->Reset(&data_->controller_,
+                          data_->projection_,
+                          &data_->client_projection_,
+                          &data_->last_response_);
     }
 
     data_->scan_attempts_++;
@@ -1241,6 +1371,25 @@ Status KuduScanner::NextBatch(KuduScanBatch* result) {
   }
 }
 
+Status KuduScanner::GetAggregateResult(KuduScanBatch::RowPtr* row) {
+  if (data_->aggregators_.empty()) {
+    return Status::IllegalState("No aggregates were added before Open()");
+  }
+  ContiguousRow result(&data_->aggregate_result_schema_, data_->aggregate_result_row_.data());
+  for (int i = 0; i < data_->aggregators_.size(); i++) {
+    const Aggregator& aggregator = *data_->aggregators_[i];
+    if (data_->aggregate_result_schema_.column(i).is_nullable()) {
+      result.set_null(i, aggregator.result_is_null());
+    }
+    if (!aggregator.result_is_null()) {
+      memcpy(result.mutable_cell_ptr(i), aggregator.result(), aggregator.result_type()->size());
+    }
+  }
+  *row = KuduScanBatch::RowPtr(&data_->aggregate_result_schema_,
+                               data_->aggregate_result_row_.data());
+  return Status::OK();
+}
+
 Status KuduScanner::GetCurrentServer(KuduTabletServer** server) {
   CHECK(data_->open_);
   internal::RemoteTabletServer* rts = data_->ts_;
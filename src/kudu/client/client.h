@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 
+#include "kudu/client/columnar_scan_batch.h"
 #include "kudu/client/row_result.h"
 #include "kudu/client/scan_batch.h"
 #include "kudu/client/scan_predicate.h"
@@ -70,6 +71,7 @@ class LookupRpc;
 class MetaCache;
 class RemoteTablet;
 class RemoteTabletServer;
+class ScanBatchDataInterface;
 class WriteRpc;
 } // namespace internal
 
@@ -431,6 +433,44 @@ class KUDU_EXPORT KuduTable : public sp::enable_shared_from_this<KuduTable> {
                                         KuduPredicate::ComparisonOp op,
                                         KuduValue* value);
 
+  // Create a new IN list predicate which can be used for scanners on this
+  // table. The predicate matches rows whose value for the column is equal to
+  // any of the values in the list.
+  //
+  // The type of each value must correspond to the type of the column, as
+  // with NewComparisonPredicate(). The list may be empty, in which case the
+  // predicate matches no rows.
+  //
+  // The caller owns the result until it is passed into KuduScanner::AddConjunctPredicate().
+  // The returned predicate takes ownership of the values, which are moved out
+  // of 'values', leaving it empty.
+  //
+  // In the case of an error (e.g. an invalid column name), a non-NULL value
+  // is still returned. The error will be returned when attempting to add this
+  // predicate to a KuduScanner.
+  KuduPredicate* NewInListPredicate(const Slice& col_name,
+                                    std::vector<KuduValue*>* values);
+
+  // Create a new predicate which matches rows whose value for the column is
+  // not NULL.
+  //
+  // The caller owns the result until it is passed into KuduScanner::AddConjunctPredicate().
+  //
+  // In the case of an error (e.g. an invalid column name), a non-NULL value
+  // is still returned. The error will be returned when attempting to add this
+  // predicate to a KuduScanner.
+  KuduPredicate* NewIsNotNullPredicate(const Slice& col_name);
+
+  // Create a new predicate which matches rows whose value for the column is
+  // NULL. On a column which is not nullable, the predicate matches no rows.
+  //
+  // The caller owns the result until it is passed into KuduScanner::AddConjunctPredicate().
+  //
+  // In the case of an error (e.g. an invalid column name), a non-NULL value
+  // is still returned. The error will be returned when attempting to add this
+  // predicate to a KuduScanner.
+  KuduPredicate* NewIsNullPredicate(const Slice& col_name);
+
   KuduClient* client() const;
 
   const PartitionSchema& partition_schema() const;
@@ -867,6 +907,27 @@ class KUDU_EXPORT KuduScanner {
     ORDERED
   };
 
+  // Aggregate functions which a scan may compute. See AddAggregate().
+  enum AggregateFunction {
+    // The number of rows, or the number of non-null values of a column.
+    COUNT,
+    // The sum of the non-null values of a numeric column.
+    SUM,
+    // The smallest non-null value of a column.
+    MIN,
+    // The largest non-null value of a column.
+    MAX
+  };
+
+  // Flags which select the layout in which rows are returned. See
+  // SetRowFormatFlags().
+  //
+  // With no flags, rows are returned row by row, in KuduScanBatch.
+  static const uint64_t NO_FLAGS;
+  // Rows are returned column by column, in KuduColumnarScanBatch. This
+  // spares the tablet server and the client from transposing the rows.
+  static const uint64_t COLUMNAR_LAYOUT;
+
   // Default scanner timeout.
   // This is set to 3x the default RPC timeout (see KuduClientBuilder::default_rpc_timeout()).
   enum { kScanTimeoutMillis = 15000 };
@@ -898,6 +959,20 @@ class KUDU_EXPORT KuduScanner {
   // The Scanner takes ownership of 'pred', even if a bad Status is returned.
   Status AddConjunctPredicate(KuduPredicate* pred) WARN_UNUSED_RESULT;
 
+  // Add an aggregate to compute over the rows which pass the predicates.
+  //
+  // If any aggregates are added, the rows are aggregated by the tablet servers
+  // instead of being returned: NextBatch() returns empty batches, and once
+  // HasMoreRows() returns false, GetAggregateResult() returns the results. The
+  // projection is ignored.
+  //
+  // 'column_name' is the column to aggregate. It may be empty for COUNT, to
+  // count the rows rather than the non-null values of a column.
+  //
+  // Aggregates are not supported in fault-tolerant scans.
+  Status AddAggregate(AggregateFunction function,
+                      const std::string& column_name) WARN_UNUSED_RESULT;
+
   // Add a lower bound (inclusive) primary key for the scan.
   // If any bound is already added, this bound is intersected with that one.
   //
@@ -940,6 +1015,24 @@ class KUDU_EXPORT KuduScanner {
   // in memory and made available for future scans. Default is true.
   Status SetCacheBlocks(bool cache_blocks);
 
+  // Set the layout in which rows are returned, a bitfield of the row format
+  // flags above. Must be called before Open(). Default is NO_FLAGS.
+  //
+  // With COLUMNAR_LAYOUT, batches must be fetched with
+  // NextBatch(KuduColumnarScanBatch*). If a tablet server does not support the
+  // columnar layout, NextBatch() returns NotSupported.
+  Status SetRowFormatFlags(uint64_t flags) WARN_UNUSED_RESULT;
+
+  // Ask the tablet servers to compress the rows they return with the given
+  // codec, which may be SNAPPY, LZ4, ZLIB or ZSTD. This trades CPU time on
+  // both ends for network bandwidth. Must be called before Open(). Default
+  // is NO_COMPRESSION.
+  //
+  // A tablet server which does not support, or is not configured to use,
+  // the codec returns the rows uncompressed.
+  Status SetResponseCompression(KuduColumnStorageAttributes::CompressionType compression)
+      WARN_UNUSED_RESULT;
+
   // Begin scanning.
   Status Open();
 
@@ -989,6 +1082,21 @@ class KUDU_EXPORT KuduScanner {
   // obtained from the batch.
   Status NextBatch(KuduScanBatch* batch);
 
+  // Same as above, for scans set up with the COLUMNAR_LAYOUT row format flag.
+  // Any data previously fetched into 'batch' is invalidated.
+  Status NextBatch(KuduColumnarScanBatch* batch);
+
+  // Sets 'row' to the results of the aggregates over the rows scanned so far,
+  // with a column per aggregate, in the order in which they were added. Each
+  // column is named after its aggregate, e.g. "SUM(col)" or "COUNT(*)".
+  //
+  // A COUNT is an INT64. A SUM is an INT64 for integer columns and a DOUBLE for
+  // floating-point columns. A MIN or MAX has the type of the column. Results
+  // other than COUNTs are NULL if there were no non-null values to aggregate.
+  //
+  // The row is valid until the next call to this method or to NextBatch().
+  Status GetAggregateResult(KuduScanBatch::RowPtr* row) WARN_UNUSED_RESULT;
+
   // Get the KuduTabletServer that is currently handling the scan.
   // More concretely, this is the server that handled the most recent Open or NextBatch
   // RPC made by the server.
@@ -1041,6 +1149,9 @@ class KUDU_EXPORT KuduScanner {
  private:
   class KUDU_NO_EXPORT Data;
 
+  // Fetches the next batch of results into 'batch', whichever its layout.
+  Status NextBatchInternal(internal::ScanBatchDataInterface* batch);
+
   FRIEND_TEST(ClientTest, TestScanCloseProxy);
   FRIEND_TEST(ClientTest, TestScanFaultTolerance);
   FRIEND_TEST(ClientTest, TestScanNoBlockCaching);
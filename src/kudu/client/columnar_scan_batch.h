@@ -0,0 +1,87 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CLIENT_COLUMNAR_SCAN_BATCH_H
+#define KUDU_CLIENT_COLUMNAR_SCAN_BATCH_H
+
+#ifdef KUDU_HEADERS_NO_STUBS
+#include "kudu/gutil/macros.h"
+#include "kudu/gutil/port.h"
+#else
+#include "kudu/client/stubs.h"
+#endif
+
+#include "kudu/util/kudu_export.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+namespace client {
+
+// A batch of zero or more rows returned from a KuduScanner which was set up
+// with the KuduScanner::COLUMNAR_LAYOUT row format flag.
+//
+// Rather than row by row, the rows are stored column by column, in the
+// layout in which the tablet server materializes them. This spares readers
+// which process a column at a time, such as analytic engines, from
+// transposing the rows back into columns.
+//
+// The columns are those of the scanner's projection, in the same order. The
+// data is only valid for as long as the batch, and until the batch is passed
+// to KuduScanner::NextBatch() again.
+class KUDU_EXPORT KuduColumnarScanBatch {
+ public:
+  KuduColumnarScanBatch();
+  ~KuduColumnarScanBatch();
+
+  // Return the number of rows in this batch.
+  int NumRows() const;
+
+  // Sets 'data' to the cells of the fixed-length column at 'idx' in the
+  // projection: NumRows() values, in the same in-memory format as a single
+  // cell of a KuduPartialRow. For example, the data of an INT32 column is an
+  // array of int32_t. The contents of NULL cells are undefined.
+  //
+  // Returns InvalidArgument if the column is a STRING or BINARY column.
+  Status GetFixedLengthColumn(int idx, Slice* data) const WARN_UNUSED_RESULT;
+
+  // Sets 'offsets' and 'data' to the values of the STRING or BINARY column at
+  // 'idx' in the projection. 'offsets' holds NumRows() + 1 uint32_t offsets
+  // into 'data': the value of row 'i' spans from offsets[i] to offsets[i + 1].
+  // NULL values are empty.
+  //
+  // Returns InvalidArgument if the column is not a STRING or BINARY column.
+  Status GetVariableLengthColumn(int idx, Slice* offsets, Slice* data) const WARN_UNUSED_RESULT;
+
+  // Sets 'non_null_bitmap' to the non-null bitmap of the nullable column at
+  // 'idx' in the projection: bit 'i' (the bit (i % 8) of byte (i / 8)) is set
+  // if row 'i' is not NULL.
+  //
+  // Returns InvalidArgument if the column is not nullable.
+  Status GetNonNullBitmapForColumn(int idx, Slice* non_null_bitmap) const WARN_UNUSED_RESULT;
+
+ private:
+  class KUDU_NO_EXPORT Data;
+  friend class KuduScanner;
+
+  Data* data_;
+  DISALLOW_COPY_AND_ASSIGN(KuduColumnarScanBatch);
+};
+
+} // namespace client
+} // namespace kudu
+
+#endif
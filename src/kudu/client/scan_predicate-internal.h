@@ -17,6 +17,8 @@
 #ifndef KUDU_CLIENT_SCAN_PREDICATE_INTERNAL_H
 #define KUDU_CLIENT_SCAN_PREDICATE_INTERNAL_H
 
+#include <vector>
+
 #include "kudu/client/value.h"
 #include "kudu/client/value-internal.h"
 #include "kudu/common/scan_spec.h"
@@ -89,6 +91,65 @@ class ComparisonPredicateData : public KuduPredicate::Data {
   ColumnRangePredicate* pred_;
 };
 
+// A predicate which matches column values equal to any of a list of
+// constants.
+class InListPredicateData : public KuduPredicate::Data {
+ public:
+  // Takes ownership of the values, which are moved out of 'values'.
+  InListPredicateData(ColumnSchema col, std::vector<KuduValue*>* values);
+  virtual ~InListPredicateData();
+
+  virtual Status AddToScanSpec(ScanSpec* spec) OVERRIDE;
+
+  virtual InListPredicateData* Clone() const OVERRIDE;
+
+ private:
+  ColumnSchema col_;
+
+  // Owned.
+  std::vector<KuduValue*> vals_;
+};
+
+// A predicate which matches rows whose value for the column is not NULL.
+class IsNotNullPredicateData : public KuduPredicate::Data {
+ public:
+  explicit IsNotNullPredicateData(ColumnSchema col)
+      : col_(std::move(col)) {
+  }
+
+  virtual Status AddToScanSpec(ScanSpec* spec) OVERRIDE {
+    spec->AddPredicate(ColumnPredicate::IsNotNull(col_));
+    return Status::OK();
+  }
+
+  virtual IsNotNullPredicateData* Clone() const OVERRIDE {
+    return new IsNotNullPredicateData(col_);
+  }
+
+ private:
+  ColumnSchema col_;
+};
+
+// A predicate which matches rows whose value for the column is NULL.
+class IsNullPredicateData : public KuduPredicate::Data {
+ public:
+  explicit IsNullPredicateData(ColumnSchema col)
+      : col_(std::move(col)) {
+  }
+
+  virtual Status AddToScanSpec(ScanSpec* spec) OVERRIDE {
+    spec->AddPredicate(ColumnPredicate::IsNull(col_));
+    return Status::OK();
+  }
+
+  virtual IsNullPredicateData* Clone() const OVERRIDE {
+    return new IsNullPredicateData(col_);
+  }
+
+ private:
+  ColumnSchema col_;
+};
+
 } // namespace client
 } // namespace kudu
 #endif /* KUDU_CLIENT_SCAN_PREDICATE_INTERNAL_H */
@@ -23,8 +23,10 @@
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/scan_predicate.h"
 
+#include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
 
+using std::vector;
 using strings::Substitute;
 
 namespace kudu {
@@ -87,5 +89,39 @@ Status ComparisonPredicateData::AddToScanSpec(ScanSpec* spec) {
   return Status::OK();
 }
 
+InListPredicateData::InListPredicateData(ColumnSchema col,
+                                         vector<KuduValue*>* values)
+    : col_(std::move(col)) {
+  vals_.swap(*values);
+}
+
+InListPredicateData::~InListPredicateData() {
+  STLDeleteElements(&vals_);
+}
+
+Status InListPredicateData::AddToScanSpec(ScanSpec* spec) {
+  vector<const void*> vals_list;
+  vals_list.reserve(vals_.size());
+  for (KuduValue* value : vals_) {
+    void* val_void;
+    RETURN_NOT_OK(value->data_->CheckTypeAndGetPointer(col_.name(),
+                                                       col_.type_info()->physical_type(),
+                                                       &val_void));
+    vals_list.push_back(val_void);
+  }
+
+  spec->AddPredicate(ColumnPredicate::InList(col_, &vals_list));
+  return Status::OK();
+}
+
+InListPredicateData* InListPredicateData::Clone() const {
+  vector<KuduValue*> values;
+  values.reserve(vals_.size());
+  for (KuduValue* value : vals_) {
+    values.push_back(value->Clone());
+  }
+  return new InListPredicateData(col_, &values);
+}
+
 } // namespace client
 } // namespace kudu
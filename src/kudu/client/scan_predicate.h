@@ -51,6 +51,7 @@ class KUDU_EXPORT KuduPredicate {
   friend class KuduTable;
   friend class ComparisonPredicateData;
   friend class ErrorPredicateData;
+  friend class InListPredicateData;
 
   explicit KuduPredicate(Data* d);
 
@@ -27,19 +27,24 @@
 #include "kudu/client/meta_cache.h"
 #include "kudu/client/row_result.h"
 #include "kudu/client/table-internal.h"
+#include "kudu/cfile/compression_codec.h"
+#include "kudu/common/schema.h"
 #include "kudu/common/wire_protocol.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/transfer.h"
 #include "kudu/util/hexdump.h"
 
 using std::set;
 using std::string;
+using std::unique_ptr;
 
 namespace kudu {
 
 using rpc::RpcController;
 using strings::Substitute;
 using strings::SubstituteAndAppend;
+using tserver::ColumnPredicatePB;
 using tserver::ColumnRangePredicatePB;
 using tserver::NewScanRequestPB;
 using tserver::ScanResponsePB;
@@ -59,6 +64,8 @@ KuduScanner::Data::Data(KuduTable* table)
     read_mode_(READ_LATEST),
     is_fault_tolerant_(false),
     snapshot_timestamp_(kNoTimestamp),
+    row_format_flags_(KuduScanner::NO_FLAGS),
+    response_compression_(NO_COMPRESSION),
     table_(DCHECK_NOTNULL(table)),
     arena_(1024, 1024*1024),
     spec_encoder_(table->schema().schema_, &arena_),
@@ -237,6 +244,16 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
   }
 
   scan->set_cache_blocks(spec_.cache_blocks());
+  if (row_format_flags_ & KuduScanner::COLUMNAR_LAYOUT) {
+    // Let the tablet server send cached cells without copying them.
+    scan->set_row_format_flags(row_format_flags_ | tserver::COLUMNAR_DATA_CHUNKS);
+  } else {
+    scan->set_row_format_flags(row_format_flags_);
+  }
+  scan->clear_accepted_sidecar_compression();
+  if (response_compression_ != NO_COMPRESSION) {
+    scan->add_accepted_sidecar_compression(response_compression_);
+  }
 
   if (snapshot_timestamp_ != kNoTimestamp) {
     if (PREDICT_FALSE(read_mode_ != READ_AT_SNAPSHOT)) {
@@ -263,6 +280,45 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
     }
     ColumnSchemaToPB(col, pb->mutable_column());
   }
+  scan->clear_column_predicates();
+  for (const ColumnPredicate& pred : spec_.column_predicates()) {
+    ColumnPredicatePB* pb = scan->add_column_predicates();
+    ColumnSchemaToPB(pred.column(), pb->mutable_column());
+    switch (pred.predicate_type()) {
+      case PredicateType::InList: {
+        ColumnPredicatePB::InList* in_list = pb->mutable_in_list();
+        for (const void* value : pred.raw_values()) {
+          CopyPredicateBound(pred.column(), value, in_list->add_values());
+        }
+        break;
+      }
+      case PredicateType::Equality: {
+        // An IN list may have been simplified into an equality.
+        CopyPredicateBound(pred.column(), pred.raw_lower(),
+                           pb->mutable_in_list()->add_values());
+        break;
+      }
+      case PredicateType::None: {
+        // An IN list which matches nothing is sent as an empty IN list.
+        pb->mutable_in_list();
+        break;
+      }
+      case PredicateType::IsNotNull: {
+        pb->mutable_is_not_null();
+        break;
+      }
+      case PredicateType::IsNull: {
+        pb->mutable_is_null();
+        break;
+      }
+      default:
+        LOG(FATAL) << "unexpected predicate type: " << pred.ToString();
+    }
+  }
+  scan->clear_aggregates();
+  for (const AggregatePB& aggregate_pb : aggregate_pbs_) {
+    scan->add_aggregates()->CopyFrom(aggregate_pb);
+  }
 
   if (spec_.lower_bound_key()) {
     scan->mutable_start_primary_key()->assign(
@@ -354,17 +410,25 @@ Status KuduScanner::Data::OpenTablet(const string& partition_key,
                                candidates, blacklist));
   }
 
+  bool sent_column_predicates = next_req_.new_scan_request().column_predicates_size() > 0;
   next_req_.clear_new_scan_request();
-  data_in_open_ = last_response_.has_data();
+  data_in_open_ = last_response_.has_data() || last_response_.has_columnar_data();
   if (last_response_.has_more_results()) {
     next_req_.set_scanner_id(last_response_.scanner_id());
     VLOG(1) << "Opened tablet " << remote_->tablet_id()
             << ", scanner ID " << last_response_.scanner_id();
-  } else if (last_response_.has_data()) {
+  } else if (data_in_open_) {
     VLOG(1) << "Opened tablet " << remote_->tablet_id() << ", no scanner ID assigned";
   } else {
     VLOG(1) << "Opened tablet " << remote_->tablet_id() << " (no rows), no scanner ID assigned";
   }
+  if (PREDICT_FALSE(sent_column_predicates && !last_response_.column_predicates_enforced())) {
+    // Tablet servers which predate column predicates ignore them, and return
+    // the rows they would have filtered out.
+    return Status::NotSupported("Tablet server does not support column predicates",
+                                remote_->tablet_id());
+  }
+  RETURN_NOT_OK(MergeAggregateResults());
 
   // If present in the response, set the snapshot timestamp and the encoded last
   // primary key.  This is used when retrying the scan elsewhere.  The last
@@ -461,8 +525,150 @@ void KuduScanner::Data::SetProjectionSchema(const Schema* schema) {
   client_projection_ = KuduSchema(*schema);
 }
 
+Status KuduScanner::Data::SetupAggregates() {
+  // Project each aggregated column once. A scan which only counts rows
+  // projects no columns at all.
+  const Schema* table_schema = table_->schema().schema_;
+  vector<int> col_indexes;
+  for (const auto& aggregate : aggregates_) {
+    if (aggregate.second != -1 &&
+        std::find(col_indexes.begin(), col_indexes.end(), aggregate.second) == col_indexes.end()) {
+      col_indexes.push_back(aggregate.second);
+    }
+  }
+  vector<ColumnSchema> cols;
+  cols.reserve(col_indexes.size());
+  for (int col_idx : col_indexes) {
+    cols.push_back(table_schema->column(col_idx));
+  }
+  gscoped_ptr<Schema> projection(new Schema());
+  RETURN_NOT_OK(projection->Reset(cols, 0));
+  SetProjectionSchema(pool_.Add(projection.release()));
+
+  aggregate_pbs_.clear();
+  aggregators_.clear();
+  vector<ColumnSchema> result_cols;
+  for (const auto& aggregate : aggregates_) {
+    AggregatePB pb;
+    pb.set_function(aggregate.first);
+    if (aggregate.second != -1) {
+      pb.set_column_idx(std::find(col_indexes.begin(), col_indexes.end(), aggregate.second) -
+                        col_indexes.begin());
+    }
+    gscoped_ptr<Aggregator> aggregator;
+    RETURN_NOT_OK(Aggregator::Create(pb, *projection_, &aggregator));
+    result_cols.emplace_back(aggregator->name(), aggregator->result_type()->type(),
+                             aggregate.first != AggregatePB::COUNT);
+    aggregate_pbs_.push_back(pb);
+    aggregators_.emplace_back(aggregator.release());
+  }
+  RETURN_NOT_OK(aggregate_result_schema_.Reset(result_cols, 0));
+  aggregate_result_row_.resize(
+      KuduScanBatch::Data::CalculateProjectedRowSize(aggregate_result_schema_));
+  return Status::OK();
+}
+
+Status KuduScanner::Data::MergeAggregateResults() {
+  if (last_response_.aggregate_results_size() == 0) {
+    if (PREDICT_FALSE(!aggregators_.empty() &&
+                      (last_response_.has_data() || last_response_.has_columnar_data()))) {
+      // Tablet servers which predate aggregates ignore them, and return the
+      // rows instead.
+      return Status::NotSupported("Tablet server does not support aggregates");
+    }
+    // A response which scanned no rows may carry no partial results.
+    return Status::OK();
+  }
+  if (PREDICT_FALSE(last_response_.aggregate_results_size() != aggregators_.size())) {
+    return Status::Corruption(Substitute("Server sent $0 aggregate results, expected $1",
+                                         last_response_.aggregate_results_size(),
+                                         aggregators_.size()));
+  }
+  for (int i = 0; i < aggregators_.size(); i++) {
+    RETURN_NOT_OK(aggregators_[i]->Merge(last_response_.aggregate_results(i)));
+  }
+  return Status::OK();
+}
+
 
 
+////////////////////////////////////////////////////////////
+// ScanSidecars
+////////////////////////////////////////////////////////////
+
+namespace internal {
+
+ScanSidecars::ScanSidecars() {}
+
+ScanSidecars::~ScanSidecars() {}
+
+Status ScanSidecars::Reset(RpcController* controller, const ScanResponsePB& response) {
+  CHECK(controller->finished());
+  controller_.Swap(controller);
+  uncompressed_.clear();
+  if (!response.has_sidecar_compression() ||
+      response.sidecar_compression() == NO_COMPRESSION) {
+    return Status::OK();
+  }
+
+  const cfile::CompressionCodec* codec;
+  Status s = cfile::GetCompressionCodec(response.sidecar_compression(), &codec);
+  if (PREDICT_FALSE(!s.ok() || codec == nullptr)) {
+    return Status::Corruption("Server sent invalid response: unknown sidecar compression",
+                              CompressionType_Name(response.sidecar_compression()));
+  }
+  // There is at most one size per sidecar.
+  int num_sizes = response.uncompressed_sidecar_sizes_size();
+  Slice unused;
+  if (PREDICT_FALSE(num_sizes > 0 && !controller_.GetSidecar(num_sizes - 1, &unused).ok())) {
+    return Status::Corruption(Substitute("Server sent invalid response: $0 uncompressed "
+                                         "sidecar sizes for fewer sidecars", num_sizes));
+  }
+  uncompressed_.resize(num_sizes);
+  for (int i = 0; i < num_sizes; i++) {
+    int64_t size = response.uncompressed_sidecar_sizes(i);
+    // An uncompressed sidecar would have had to fit in a message.
+    if (PREDICT_FALSE(size < 0 || size > FLAGS_rpc_max_message_size)) {
+      return Status::Corruption(Substitute("Server sent invalid response: uncompressed "
+                                           "size $0 of sidecar $1 out of range", size, i));
+    }
+    if (size == 0) {
+      // The sidecar did not shrink, and was sent uncompressed.
+      continue;
+    }
+    Slice compressed;
+    s = controller_.GetSidecar(i, &compressed);
+    if (PREDICT_FALSE(!s.ok())) {
+      return Status::Corruption("Server sent invalid response: compressed sidecar "
+                                "index corrupt", s.ToString());
+    }
+    unique_ptr<faststring> buf(new faststring(size));
+    buf->resize(size);
+    s = codec->Uncompress(compressed, buf->data(), size);
+    if (PREDICT_FALSE(!s.ok())) {
+      return Status::Corruption(Substitute("Server sent invalid response: unable to "
+                                           "uncompress sidecar $0", i), s.ToString());
+    }
+    uncompressed_[i] = std::move(buf);
+  }
+  return Status::OK();
+}
+
+Status ScanSidecars::Get(int idx, Slice* sidecar) const {
+  if (idx >= 0 && idx < uncompressed_.size() && uncompressed_[idx]) {
+    *sidecar = Slice(*uncompressed_[idx]);
+    return Status::OK();
+  }
+  return controller_.GetSidecar(idx, sidecar);
+}
+
+void ScanSidecars::Clear() {
+  uncompressed_.clear();
+  controller_.Reset();
+}
+
+} // namespace internal
+
 ////////////////////////////////////////////////////////////
 // KuduScanBatch
 ////////////////////////////////////////////////////////////
@@ -479,18 +685,20 @@ size_t KuduScanBatch::Data::CalculateProjectedRowSize(const Schema& proj) {
 Status KuduScanBatch::Data::Reset(RpcController* controller,
                                   const Schema* projection,
                                   const KuduSchema* client_projection,
-                                  gscoped_ptr<RowwiseRowBlockPB> data) {
-  CHECK(controller->finished());
-  controller_.Swap(controller);
+                                  ScanResponsePB* response) {
+  if (PREDICT_FALSE(response->has_columnar_data())) {
+    return Status::Corruption("Server sent invalid response: unexpected columnar data");
+  }
+  RETURN_NOT_OK(sidecars_.Reset(controller, *response));
   projection_ = projection;
   client_projection_ = client_projection;
-  resp_data_.Swap(data.get());
+  resp_data_.Swap(response->mutable_data());
 
   // First, rewrite the relative addresses into absolute ones.
   if (PREDICT_FALSE(!resp_data_.has_rows_sidecar())) {
     return Status::Corruption("Server sent invalid response: no row data");
   } else {
-    Status s = controller_.GetSidecar(resp_data_.rows_sidecar(), &direct_data_);
+    Status s = sidecars_.Get(resp_data_.rows_sidecar(), &direct_data_);
     if (!s.ok()) {
       return Status::Corruption("Server sent invalid response: row data "
                                 "sidecar index corrupt", s.ToString());
@@ -498,8 +706,7 @@ Status KuduScanBatch::Data::Reset(RpcController* controller,
   }
 
   if (resp_data_.has_indirect_data_sidecar()) {
-    Status s = controller_.GetSidecar(resp_data_.indirect_data_sidecar(),
-                                      &indirect_data_);
+    Status s = sidecars_.Get(resp_data_.indirect_data_sidecar(), &indirect_data_);
     if (!s.ok()) {
       return Status::Corruption("Server sent invalid response: indirect data "
                                 "sidecar index corrupt", s.ToString());
@@ -538,7 +745,141 @@ void KuduScanBatch::Data::ExtractRows(vector<KuduScanBatch::RowPtr>* rows) {
 
 void KuduScanBatch::Data::Clear() {
   resp_data_.Clear();
-  controller_.Reset();
+  sidecars_.Clear();
+}
+
+////////////////////////////////////////////////////////////
+// KuduColumnarScanBatch
+////////////////////////////////////////////////////////////
+
+KuduColumnarScanBatch::Data::Data() : projection_(NULL) {}
+
+KuduColumnarScanBatch::Data::~Data() {}
+
+namespace {
+
+// The offset at which the first value of a variable-length column starts,
+// for batches without any columnar data.
+const uint32_t kFirstVarlenOffset = 0;
+
+// Looks up sidecar 'idx' of 'sidecars'.
+Status GetColumnarSidecar(const internal::ScanSidecars& sidecars, int idx, const char* what,
+                          const ColumnSchema& col, Slice* sidecar) {
+  Status s = sidecars.Get(idx, sidecar);
+  if (PREDICT_FALSE(!s.ok())) {
+    return Status::Corruption(Substitute("Server sent invalid response: $0 sidecar index "
+                                         "of column $1 corrupt", what, col.name()),
+                              s.ToString());
+  }
+  return Status::OK();
+}
+
+} // anonymous namespace
+
+Status KuduColumnarScanBatch::Data::Reset(RpcController* controller,
+                                          const Schema* projection,
+                                          const KuduSchema* /* client_projection */,
+                                          ScanResponsePB* response) {
+  RETURN_NOT_OK(sidecars_.Reset(controller, *response));
+  projection_ = projection;
+  columns_.clear();
+  columns_.resize(projection_->num_columns());
+
+  if (PREDICT_FALSE(response->has_data())) {
+    // Tablet servers which predate the columnar layout ignore the row format
+    // flags, and return the rows row by row.
+    return Status::NotSupported("Tablet server does not support the columnar layout");
+  }
+  if (!response->has_columnar_data()) {
+    // No rows.
+    resp_data_.Clear();
+    for (int i = 0; i < projection_->num_columns(); i++) {
+      if (projection_->column(i).type_info()->physical_type() == BINARY) {
+        columns_[i].data = Slice(reinterpret_cast<const uint8_t*>(&kFirstVarlenOffset),
+                                 sizeof(kFirstVarlenOffset));
+      }
+    }
+    return Status::OK();
+  }
+  resp_data_.Swap(response->mutable_columnar_data());
+
+  if (PREDICT_FALSE(resp_data_.columns_size() != projection_->num_columns())) {
+    return Status::Corruption(Substitute(
+        "Server sent invalid response: $0 columns, expected $1",
+        resp_data_.columns_size(), projection_->num_columns()));
+  }
+  int64_t num_rows = resp_data_.num_rows();
+  for (int i = 0; i < projection_->num_columns(); i++) {
+    const ColumnSchema& col = projection_->column(i);
+    const ColumnarRowBlockPB::Column& col_pb = resp_data_.columns(i);
+    Column* dst = &columns_[i];
+
+    if (col_pb.data_chunk_sidecars_size() > 0) {
+      // The cells are split across several sidecars: join them.
+      dst->joined_data.reset(new faststring());
+      for (int idx : col_pb.data_chunk_sidecars()) {
+        Slice chunk;
+        RETURN_NOT_OK(GetColumnarSidecar(sidecars_, idx, "data chunk", col, &chunk));
+        dst->joined_data->append(chunk.data(), chunk.size());
+      }
+      dst->data = Slice(*dst->joined_data);
+    } else {
+      RETURN_NOT_OK(GetColumnarSidecar(sidecars_, col_pb.data_sidecar(), "data", col,
+                                       &dst->data));
+    }
+    if (col.type_info()->physical_type() == BINARY) {
+      RETURN_NOT_OK(GetColumnarSidecar(sidecars_, col_pb.varlen_data_sidecar(),
+                                       "varlen data", col, &dst->varlen_data));
+      if (PREDICT_FALSE(dst->data.size() != (num_rows + 1) * sizeof(uint32_t))) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: $0 bytes of offsets for column $1 of $2 rows",
+            dst->data.size(), col.name(), num_rows));
+      }
+      // Check that the values lie within the varlen data, so that callers may
+      // trust the offsets.
+      const uint32_t* offsets = reinterpret_cast<const uint32_t*>(dst->data.data());
+      uint32_t prev = 0;
+      for (int64_t row = 0; row <= num_rows; row++) {
+        if (PREDICT_FALSE(offsets[row] < prev)) {
+          return Status::Corruption(Substitute(
+              "Server sent invalid response: decreasing offset for column $0", col.name()));
+        }
+        prev = offsets[row];
+      }
+      if (PREDICT_FALSE(offsets[0] != 0 || prev != dst->varlen_data.size())) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: offsets for column $0 do not span its "
+            "$1 bytes of varlen data", col.name(), dst->varlen_data.size()));
+      }
+    } else if (PREDICT_FALSE(dst->data.size() != num_rows * col.type_info()->size())) {
+      return Status::Corruption(Substitute(
+          "Server sent invalid response: $0 bytes of data for column $1 of $2 rows",
+          dst->data.size(), col.name(), num_rows));
+    }
+    if (col.is_nullable()) {
+      RETURN_NOT_OK(GetColumnarSidecar(sidecars_, col_pb.non_null_bitmap_sidecar(),
+                                       "non-null bitmap", col, &dst->non_null_bitmap));
+      if (PREDICT_FALSE(dst->non_null_bitmap.size() < BitmapSize(num_rows))) {
+        return Status::Corruption(Substitute(
+            "Server sent invalid response: $0 bytes of non-null bitmap for column $1 "
+            "of $2 rows", dst->non_null_bitmap.size(), col.name(), num_rows));
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status KuduColumnarScanBatch::Data::CheckColumnIndex(int idx) const {
+  if (PREDICT_FALSE(idx < 0 || idx >= columns_.size())) {
+    return Status::InvalidArgument(Substitute("Invalid column index: $0", idx));
+  }
+  return Status::OK();
+}
+
+void KuduColumnarScanBatch::Data::Clear() {
+  resp_data_.Clear();
+  columns_.clear();
+  sidecars_.Clear();
 }
 
 } // namespace client
@@ -17,21 +17,75 @@
 #ifndef KUDU_CLIENT_SCANNER_INTERNAL_H
 #define KUDU_CLIENT_SCANNER_INTERNAL_H
 
+#include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "kudu/gutil/macros.h"
 #include "kudu/client/client.h"
 #include "kudu/client/row_result.h"
+#include "kudu/common/aggregate.h"
+#include "kudu/common/common.pb.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/common/predicate_encoder.h"
 #include "kudu/tserver/tserver_service.proxy.h"
+#include "kudu/util/faststring.h"
 
 namespace kudu {
 
 namespace client {
 
+namespace internal {
+
+// The storage of a batch of rows returned by a scan, in one of the layouts
+// which a scanner may request. See KuduScanner::SetRowFormatFlags().
+class ScanBatchDataInterface {
+ public:
+  virtual ~ScanBatchDataInterface() {}
+
+  // Takes the rows from 'response', which was received by the RPC of
+  // 'controller'.
+  virtual Status Reset(rpc::RpcController* controller,
+                       const Schema* projection,
+                       const KuduSchema* client_projection,
+                       tserver::ScanResponsePB* response) = 0;
+
+  // Drops the rows of the previous batch.
+  virtual void Clear() = 0;
+};
+
+// The sidecars of a scan response, uncompressed if the tablet server
+// compressed them. See KuduScanner::SetResponseCompression().
+class ScanSidecars {
+ public:
+  ScanSidecars();
+  ~ScanSidecars();
+
+  // Takes the sidecars of 'response', which was received by the RPC of
+  // 'controller', and uncompresses those which were compressed.
+  Status Reset(rpc::RpcController* controller, const tserver::ScanResponsePB& response);
+
+  // Sets 'sidecar' to the uncompressed contents of sidecar 'idx'. The slice
+  // is valid until the next call to Reset() or Clear().
+  Status Get(int idx, Slice* sidecar) const;
+
+  void Clear();
+
+ private:
+  // Holding on to the controller ensures we hold on to the sidecars.
+  rpc::RpcController controller_;
+
+  // The uncompressed contents of each sidecar, indexed by sidecar, or NULL
+  // if the sidecar was not compressed.
+  std::vector<std::unique_ptr<faststring>> uncompressed_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanSidecars);
+};
+
+} // namespace internal
+
 class KuduScanner::Data {
  public:
   explicit Data(KuduTable* table);
@@ -97,6 +151,15 @@ class KuduScanner::Data {
   // Sets the projection schema.
   void SetProjectionSchema(const Schema* schema);
 
+  // Sets up the aggregates added with AddAggregate(): projects the aggregated
+  // columns, and creates the aggregators which combine the partial results
+  // sent by the tablet servers.
+  Status SetupAggregates();
+
+  // Combines the partial results of the aggregates in 'last_response_' into
+  // 'aggregators_'.
+  Status MergeAggregateResults();
+
   bool open_;
   bool data_in_open_;
   bool has_batch_size_bytes_;
@@ -107,6 +170,12 @@ class KuduScanner::Data {
   bool is_fault_tolerant_;
   int64_t snapshot_timestamp_;
 
+  // See KuduScanner::SetRowFormatFlags().
+  uint64_t row_format_flags_;
+
+  // See KuduScanner::SetResponseCompression().
+  CompressionType response_compression_;
+
   // The encoded last primary key from the most recent tablet scan response.
   std::string last_primary_key_;
 
@@ -158,6 +227,19 @@ class KuduScanner::Data {
   // actual storage for the batch that is returned.
   KuduScanBatch batch_for_old_api_;
 
+  // The aggregates added with AddAggregate(), as the function and the index of
+  // the aggregated column in the table schema (-1 for a COUNT of the rows).
+  std::vector<std::pair<AggregatePB::Function, int>> aggregates_;
+
+  // The aggregates sent to the tablet servers, and the aggregators combining
+  // their partial results. Set up by SetupAggregates().
+  std::vector<AggregatePB> aggregate_pbs_;
+  std::vector<std::unique_ptr<Aggregator>> aggregators_;
+
+  // The schema of the row returned by GetAggregateResult(), and its storage.
+  Schema aggregate_result_schema_;
+  faststring aggregate_result_row_;
+
   // The latest error experienced by this scan that provoked a retry. If the
   // scan times out, this error will be incorporated into the status that is
   // passed back to the client.
@@ -168,15 +250,15 @@ class KuduScanner::Data {
   DISALLOW_COPY_AND_ASSIGN(Data);
 };
 
-class KuduScanBatch::Data {
+class KuduScanBatch::Data : public internal::ScanBatchDataInterface {
  public:
   Data();
   ~Data();
 
-  Status Reset(rpc::RpcController* controller,
-               const Schema* projection,
-               const KuduSchema* client_projection,
-               gscoped_ptr<RowwiseRowBlockPB> resp_data);
+  virtual Status Reset(rpc::RpcController* controller,
+                       const Schema* projection,
+                       const KuduSchema* client_projection,
+                       tserver::ScanResponsePB* response) OVERRIDE;
 
   int num_rows() const {
     return resp_data_.num_rows();
@@ -191,15 +273,14 @@ class KuduScanBatch::Data {
 
   void ExtractRows(vector<KuduScanBatch::RowPtr>* rows);
 
-  void Clear();
+  virtual void Clear() OVERRIDE;
 
   // Returns the size of a row for the given projection 'proj'.
   static size_t CalculateProjectedRowSize(const Schema& proj);
 
-  // The RPC controller for the RPC which returned this batch.
-  // Holding on to the controller ensures we hold on to the indirect data
-  // which contains the rows.
-  rpc::RpcController controller_;
+  // The sidecars of the RPC which returned this batch, which contain the
+  // rows.
+  internal::ScanSidecars sidecars_;
 
   // The PB which contains the "direct data" slice.
   RowwiseRowBlockPB resp_data_;
@@ -217,6 +298,48 @@ class KuduScanBatch::Data {
   size_t projected_row_size_;
 };
 
+class KuduColumnarScanBatch::Data : public internal::ScanBatchDataInterface {
+ public:
+  Data();
+  ~Data();
+
+  virtual Status Reset(rpc::RpcController* controller,
+                       const Schema* projection,
+                       const KuduSchema* client_projection,
+                       tserver::ScanResponsePB* response) OVERRIDE;
+
+  virtual void Clear() OVERRIDE;
+
+  int num_rows() const {
+    return resp_data_.num_rows();
+  }
+
+  // Returns a bad Status if 'idx' is not a column of the projection.
+  Status CheckColumnIndex(int idx) const;
+
+  // The sidecars of the RPC which returned this batch, which contain the
+  // columns.
+  internal::ScanSidecars sidecars_;
+
+  // The PB which references the sidecars.
+  ColumnarRowBlockPB resp_data_;
+
+  // The projection being scanned.
+  const Schema* projection_;
+
+  // Slices into the sidecars of each column of the projection, whose lifetime
+  // is ensured by the members above. See ColumnarRowBlockPB for their format.
+  struct Column {
+    Slice data;
+    Slice varlen_data;
+    Slice non_null_bitmap;
+
+    // The cells of 'data', if they were split across several sidecars.
+    std::unique_ptr<faststring> joined_data;
+  };
+  std::vector<Column> columns_;
+};
+
 } // namespace client
 } // namespace kudu
 
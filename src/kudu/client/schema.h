@@ -58,7 +58,8 @@ class KUDU_EXPORT KuduColumnStorageAttributes {
     GROUP_VARINT = 3,
     RLE = 4,
     DICT_ENCODING = 5,
-    BIT_SHUFFLE = 6
+    BIT_SHUFFLE = 6,
+    DELTA_BITPACKED = 7
   };
 
   enum CompressionType {
@@ -67,6 +68,7 @@ class KUDU_EXPORT KuduColumnStorageAttributes {
     SNAPPY = 2,
     LZ4 = 3,
     ZLIB = 4,
+    ZSTD = 5,
   };
 
 
@@ -18,6 +18,10 @@
 #ifndef KUDU_CODEGEN_CODE_GENERATOR_H
 #define KUDU_CODEGEN_CODE_GENERATOR_H
 
+#include <vector>
+
+#include "kudu/codegen/predicate_evaluator.h"
+#include "kudu/codegen/row_comparator.h"
 #include "kudu/codegen/row_projector.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/macros.h"
@@ -30,10 +34,13 @@ class LLVMContext;
 
 namespace kudu {
 
+class ColumnPredicate;
 class Schema;
 
 namespace codegen {
 
+class PredicateEvaluatorFunctions;
+class RowComparatorFunctions;
 class RowProjectorFunctions;
 
 // CodeGenerator is a top-level class that manages a per-module
@@ -71,6 +78,18 @@ class CodeGenerator {
   Status CompileRowProjector(const Schema& base, const Schema& proj,
                              scoped_refptr<RowProjectorFunctions>* out);
 
+  // Attempts to initialize row comparator functions by compiling code
+  // for the parameter schema. Writes to 'out' upon success.
+  Status CompileRowComparator(const Schema& schema,
+                              scoped_refptr<RowComparatorFunctions>* out);
+
+  // Attempts to initialize predicate evaluator functions by compiling code
+  // for the parameter predicates over rows of the parameter schema. Writes
+  // to 'out' upon success.
+  Status CompilePredicateEvaluator(const Schema& schema,
+                                   const std::vector<ColumnPredicate>& predicates,
+                                   scoped_refptr<PredicateEvaluatorFunctions>* out);
+
  private:
   static void GlobalInit();
 
@@ -22,7 +22,10 @@
 #include <gmock/gmock.h>
 
 #include "kudu/codegen/code_generator.h"
+#include "kudu/codegen/predicate_evaluator.h"
+#include "kudu/codegen/row_comparator.h"
 #include "kudu/codegen/row_projector.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/row.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
@@ -93,6 +96,8 @@ class CodegenTest : public KuduTest {
  protected:
   Schema base_;
   Schema defaults_;
+  codegen::CodeGenerator generator_;
+  Random random_;
 
   // Compares the projection-for-read and projection-for-write results
   // of the codegen projection and the non-codegen projection
@@ -134,8 +139,6 @@ class CodegenTest : public KuduTest {
   typedef const void* DefaultValueType;
   static const DefaultValueType kI32R, kI32W, kStrR, kStrW;
 
-  codegen::CodeGenerator generator_;
-  Random random_;
   gscoped_ptr<ConstContiguousRow> test_rows_[kNumTestRows];
   Arena projections_arena_;
   gscoped_ptr<Arena> test_rows_arena_;
@@ -342,6 +345,176 @@ TEST_F(CodegenTest, TestFullSchemaWithDefaults) {
   TestProjection<false>(&full_write);
 }
 
+// Test that the codegenned row comparator compares and copies rows in the
+// same way as Schema::Compare() and CopyRow().
+TEST_F(CodegenTest, TestRowComparator) {
+  // The first key column has few distinct values, so that the second one
+  // often decides the comparison.
+  Schema schema({ ColumnSchema("k1", STRING),
+                  ColumnSchema("k2", INT32),
+                  ColumnSchema("v1", INT64, true),
+                  ColumnSchema("v2", STRING, true) }, 2);
+  scoped_refptr<codegen::RowComparatorFunctions> functions;
+  ASSERT_OK(generator_.CompileRowComparator(schema, &functions));
+  codegen::RowComparator comparator(&schema, functions);
+
+  const int kNumRows = 50;
+  const Slice kKeys[] = { "a", "ab", "b" };
+  Arena arena(1024, 1024 * 1024);
+  RowBlock block(schema, kNumRows, &arena);
+  for (int i = 0; i < kNumRows; i++) {
+    RowBlockRow row = block.row(i);
+    Slice k1 = kKeys[random_.Uniform(arraysize(kKeys))];
+    int32_t k2 = static_cast<int32_t>(random_.Uniform(5)) - 2;
+    int64_t v1 = random_.Next64();
+    Slice v2 = kKeys[i % arraysize(kKeys)];
+    memcpy(row.mutable_cell_ptr(0), &k1, sizeof(k1));
+    memcpy(row.mutable_cell_ptr(1), &k2, sizeof(k2));
+    row.cell(2).set_null(i % 4 == 0);
+    memcpy(row.mutable_cell_ptr(2), &v1, sizeof(v1));
+    row.cell(3).set_null(i % 5 == 0);
+    memcpy(row.mutable_cell_ptr(3), &v2, sizeof(v2));
+  }
+
+  for (int i = 0; i < kNumRows; i++) {
+    for (int j = 0; j < kNumRows; j++) {
+      int expected = schema.Compare(block.row(i), block.row(j));
+      int actual = comparator.Compare(block.row(i), block.row(j));
+      ASSERT_EQ(expected < 0, actual < 0) << schema.DebugRow(block.row(i))
+                                          << " vs " << schema.DebugRow(block.row(j));
+      ASSERT_EQ(expected > 0, actual > 0) << schema.DebugRow(block.row(i))
+                                          << " vs " << schema.DebugRow(block.row(j));
+    }
+  }
+
+  RowBlock with(schema, kNumRows, &arena);
+  RowBlock without(schema, kNumRows, &arena);
+  for (int i = 0; i < kNumRows; i++) {
+    RowBlockRow dst_with = with.row(i);
+    RowBlockRow dst_without = without.row(i);
+    ASSERT_OK(comparator.Copy(block.row(i), &dst_with, &arena));
+    ASSERT_OK(CopyRow(block.row(i), &dst_without, &arena));
+    ASSERT_EQ(schema.DebugRow(dst_without), schema.DebugRow(dst_with));
+  }
+}
+
+// Test that schemas with key types which have no generated comparison are
+// rejected, so that callers fall back to the interpreted comparator.
+TEST_F(CodegenTest, TestRowComparatorUnsupportedKey) {
+  Schema schema({ ColumnSchema("key", DOUBLE) }, 1);
+  scoped_refptr<codegen::RowComparatorFunctions> functions;
+  Status s = generator_.CompileRowComparator(schema, &functions);
+  ASSERT_TRUE(s.IsNotSupported()) << s.ToString();
+}
+
+// Test that the generated evaluation of conjunctions of predicates selects
+// the same rows as evaluating the predicates one at a time.
+TEST_F(CodegenTest, TestPredicateEvaluator) {
+  Schema schema({ ColumnSchema("key", INT32),
+                  ColumnSchema("i64", INT64, true),
+                  ColumnSchema("str", STRING, true),
+                  ColumnSchema("dbl", DOUBLE) }, 1);
+  const int kNumRows = 200;
+  const Slice kStrings[] = { "", "a", "ab", "b", "bb", "c" };
+  Arena arena(1024, 1024 * 1024);
+  RowBlock block(schema, kNumRows, &arena);
+  for (int i = 0; i < kNumRows; i++) {
+    RowBlockRow row = block.row(i);
+    int32_t key = i;
+    int64_t i64 = static_cast<int64_t>(random_.Uniform(20)) - 10;
+    Slice str = kStrings[random_.Uniform(arraysize(kStrings))];
+    double dbl = random_.NextDoubleFraction();
+    memcpy(row.mutable_cell_ptr(0), &key, sizeof(key));
+    row.cell(1).set_null(i % 7 == 0);
+    memcpy(row.mutable_cell_ptr(1), &i64, sizeof(i64));
+    row.cell(2).set_null(i % 5 == 0);
+    memcpy(row.mutable_cell_ptr(2), &str, sizeof(str));
+    memcpy(row.mutable_cell_ptr(3), &dbl, sizeof(dbl));
+  }
+
+  int32_t key_lower = 20;
+  int32_t key_upper = 150;
+  int64_t i64_value = 3;
+  int64_t i64_lower = -4;
+  Slice str_lower = "a";
+  Slice str_upper = "bb";
+  double dbl_upper = 0.5;
+  vector<const void*> str_values = { &kStrings[1], &kStrings[4], &kStrings[5] };
+  vector<const void*> i64_values = { &i64_value, &i64_lower };
+
+  vector<vector<ColumnPredicate>> conjunctions = {
+    { ColumnPredicate::Range(schema.column(0), &key_lower, &key_upper) },
+    { ColumnPredicate::Range(schema.column(0), &key_lower, nullptr),
+      ColumnPredicate::Equality(schema.column(1), &i64_value) },
+    { ColumnPredicate::Range(schema.column(1), &i64_lower, nullptr),
+      ColumnPredicate::Range(schema.column(2), &str_lower, &str_upper),
+      ColumnPredicate::Range(schema.column(3), nullptr, &dbl_upper) },
+    { ColumnPredicate::InList(schema.column(2), &str_values),
+      ColumnPredicate::InList(schema.column(1), &i64_values) },
+    { ColumnPredicate::IsNull(schema.column(2)),
+      ColumnPredicate::IsNotNull(schema.column(1)) },
+    { ColumnPredicate::IsNotNull(schema.column(0)) },
+    { ColumnPredicate::IsNull(schema.column(0)) },
+  };
+
+  for (const vector<ColumnPredicate>& predicates : conjunctions) {
+    scoped_refptr<codegen::PredicateEvaluatorFunctions> functions;
+    ASSERT_OK(generator_.CompilePredicateEvaluator(schema, predicates, &functions));
+    codegen::PredicateEvaluator evaluator(&schema, predicates, functions);
+    SCOPED_TRACE(evaluator);
+
+    // Start from a selection with some rows already filtered out, as a
+    // scan of rows with concurrent inserts would.
+    SelectionVector expected(kNumRows);
+    SelectionVector actual(kNumRows);
+    expected.SetAllTrue();
+    actual.SetAllTrue();
+    for (int i = 0; i < kNumRows; i += 11) {
+      expected.SetRowUnselected(i);
+      actual.SetRowUnselected(i);
+    }
+
+    for (const ColumnPredicate& pred : predicates) {
+      pred.Evaluate(block.column_block(schema.find_column(pred.column().name())), &expected);
+    }
+    evaluator.Evaluate(block, &actual);
+
+    for (int i = 0; i < kNumRows; i++) {
+      ASSERT_EQ(expected.IsRowSelected(i), actual.IsRowSelected(i))
+          << schema.DebugRow(block.row(i));
+    }
+  }
+}
+
+// Test that predicates of the same shape share a key, whatever their
+// values, so that they share compiled code, and that predicates of
+// different shapes don't.
+TEST_F(CodegenTest, TestPredicateEvaluatorKey) {
+  Schema schema({ ColumnSchema("key", INT32),
+                  ColumnSchema("val", INT32, true) }, 1);
+  int32_t values[] = { 1, 10, 3, 50 };
+  faststring range, other_range, lower_only, on_val;
+  ASSERT_OK(codegen::PredicateEvaluatorFunctions::EncodeKey(
+      schema, { ColumnPredicate::Range(schema.column(0), &values[0], &values[1]) }, &range));
+  ASSERT_OK(codegen::PredicateEvaluatorFunctions::EncodeKey(
+      schema, { ColumnPredicate::Range(schema.column(0), &values[2], &values[3]) },
+      &other_range));
+  ASSERT_OK(codegen::PredicateEvaluatorFunctions::EncodeKey(
+      schema, { ColumnPredicate::Range(schema.column(0), &values[0], nullptr) }, &lower_only));
+  ASSERT_OK(codegen::PredicateEvaluatorFunctions::EncodeKey(
+      schema, { ColumnPredicate::Range(schema.column(1), &values[0], &values[1]) }, &on_val));
+  ASSERT_EQ(range.ToString(), other_range.ToString());
+  ASSERT_NE(range.ToString(), lower_only.ToString());
+  ASSERT_NE(range.ToString(), on_val.ToString());
+
+  // Predicates on columns missing from the schema are rejected.
+  Schema other({ ColumnSchema("other", INT32) }, 1);
+  faststring unused;
+  Status s = codegen::PredicateEvaluatorFunctions::EncodeKey(
+      other, { ColumnPredicate::Range(schema.column(0), &values[0], &values[1]) }, &unused);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+}
+
 // Test the codegen_dump_mc flag works properly.
 TEST_F(CodegenTest, TestDumpMC) {
   FLAGS_codegen_dump_mc = true;
@@ -23,11 +23,16 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "kudu/codegen/code_cache.h"
 #include "kudu/codegen/code_generator.h"
 #include "kudu/codegen/jit_wrapper.h"
+#include "kudu/codegen/predicate_evaluator.h"
+#include "kudu/codegen/row_comparator.h"
 #include "kudu/codegen/row_projector.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/schema.h"
 #include "kudu/gutil/casts.h"
 #include "kudu/gutil/gscoped_ptr.h"
@@ -43,6 +48,8 @@
 #include "kudu/util/threadpool.h"
 
 using std::shared_ptr;
+using std::string;
+using std::vector;
 
 DEFINE_bool(codegen_time_compilation, false, "Whether to print time that each code "
             "generation request took.");
@@ -63,58 +70,159 @@ namespace codegen {
 
 namespace {
 
-// A CompilationTask is a ThreadPool's Runnable which, given a
-// pair of schemas and a cache to refer to, will generate code pertaining
-// to the two schemas and store it in the cache when run.
+// A CompilationTask is a ThreadPool's Runnable which, given a cache to
+// refer to, will generate code for some schemas and store it in the cache
+// when run. Subclasses define what is compiled.
 class CompilationTask : public Runnable {
  public:
   // Requires that the cache and generator are valid for the lifetime
   // of this object.
-  CompilationTask(const Schema& base, const Schema& proj, CodeCache* cache,
-                  CodeGenerator* generator)
-    : base_(base),
-      proj_(proj),
-      cache_(cache),
+  CompilationTask(CodeCache* cache, CodeGenerator* generator)
+    : cache_(cache),
       generator_(generator) {}
 
   // Can only be run once.
   void Run() override {
     // We need to fail softly because the user could have just given
-    // a malformed projection schema pair, but could be long gone by
-    // now so there's nowhere to return the status to.
-    WARN_NOT_OK(RunWithStatus(),
-                "Failed compilation of row projector from base schema " +
-                base_.ToString() + " to projection schema " +
-                proj_.ToString());
+    // malformed schemas, but could be long gone by now so there's
+    // nowhere to return the status to.
+    WARN_NOT_OK(RunWithStatus(), "Failed compilation of " + ToString());
   }
 
+ protected:
+  // Writes the code cache key of the code to 'key'.
+  virtual Status EncodeKey(faststring* key) = 0;
+
+  // Generates the code.
+  virtual Status Compile(CodeGenerator* generator, scoped_refptr<JITWrapper>* out) = 0;
+
+  // Describes the code being compiled, for logging.
+  virtual string ToString() const = 0;
+
  private:
   Status RunWithStatus() {
     faststring key;
-    RETURN_NOT_OK(RowProjectorFunctions::EncodeKey(base_, proj_, &key));
+    RETURN_NOT_OK(EncodeKey(&key));
 
     // Check again to make sure we didn't compile it already.
-    // This can occur if we request the same schema pair while the
+    // This can occur if we request the same schemas while the
     // first one's compiling.
     if (cache_->Lookup(key)) return Status::OK();
 
-    scoped_refptr<RowProjectorFunctions> functions;
-    LOG_TIMING_IF(INFO, FLAGS_codegen_time_compilation, "code-generating row projector") {
-      RETURN_NOT_OK(generator_->CompileRowProjector(base_, proj_, &functions));
+    scoped_refptr<JITWrapper> wrapper;
+    LOG_TIMING_IF(INFO, FLAGS_codegen_time_compilation, "code-generating " + ToString()) {
+      RETURN_NOT_OK(Compile(generator_, &wrapper));
     }
 
-    RETURN_NOT_OK(cache_->AddEntry(functions));
+    RETURN_NOT_OK(cache_->AddEntry(wrapper));
     return Status::OK();
   }
 
-  Schema base_;
-  Schema proj_;
   CodeCache* const cache_;
   CodeGenerator* const generator_;
 
   DISALLOW_COPY_AND_ASSIGN(CompilationTask);
 };
 
+// Compiles a row projector for a pair of schemas.
+class RowProjectorCompilationTask : public CompilationTask {
+ public:
+  RowProjectorCompilationTask(const Schema& base, const Schema& proj, CodeCache* cache,
+                              CodeGenerator* generator)
+    : CompilationTask(cache, generator),
+      base_(base),
+      proj_(proj) {}
+
+ protected:
+  Status EncodeKey(faststring* key) override {
+    return RowProjectorFunctions::EncodeKey(base_, proj_, key);
+  }
+
+  Status Compile(CodeGenerator* generator, scoped_refptr<JITWrapper>* out) override {
+    scoped_refptr<RowProjectorFunctions> functions;
+    RETURN_NOT_OK(generator->CompileRowProjector(base_, proj_, &functions));
+    *out = functions;
+    return Status::OK();
+  }
+
+  string ToString() const override {
+    return "row projector from base schema " + base_.ToString() +
+        " to projection schema " + proj_.ToString();
+  }
+
+ private:
+  Schema base_;
+  Schema proj_;
+};
+
+// Compiles a row comparator for a schema.
+class RowComparatorCompilationTask : public CompilationTask {
+ public:
+  RowComparatorCompilationTask(const Schema& schema, CodeCache* cache,
+                               CodeGenerator* generator)
+    : CompilationTask(cache, generator),
+      schema_(schema) {}
+
+ protected:
+  Status EncodeKey(faststring* key) override {
+    return RowComparatorFunctions::EncodeKey(schema_, key);
+  }
+
+  Status Compile(CodeGenerator* generator, scoped_refptr<JITWrapper>* out) override {
+    scoped_refptr<RowComparatorFunctions> functions;
+    RETURN_NOT_OK(generator->CompileRowComparator(schema_, &functions));
+    *out = functions;
+    return Status::OK();
+  }
+
+  string ToString() const override {
+    return "row comparator for schema " + schema_.ToString();
+  }
+
+ private:
+  Schema schema_;
+};
+
+// Compiles a predicate evaluator for a conjunction of predicates.
+//
+// The task may outlive the scan which requested it, and with it the values
+// of the predicates, so only the shape of the predicates (which is all the
+// generated code depends on) may be looked at.
+class PredicateEvaluatorCompilationTask : public CompilationTask {
+ public:
+  PredicateEvaluatorCompilationTask(const Schema& schema, vector<ColumnPredicate> predicates,
+                                    CodeCache* cache, CodeGenerator* generator)
+    : CompilationTask(cache, generator),
+      schema_(schema),
+      predicates_(std::move(predicates)) {}
+
+ protected:
+  Status EncodeKey(faststring* key) override {
+    return PredicateEvaluatorFunctions::EncodeKey(schema_, predicates_, key);
+  }
+
+  Status Compile(CodeGenerator* generator, scoped_refptr<JITWrapper>* out) override {
+    scoped_refptr<PredicateEvaluatorFunctions> functions;
+    RETURN_NOT_OK(generator->CompilePredicateEvaluator(schema_, predicates_, &functions));
+    *out = functions;
+    return Status::OK();
+  }
+
+  string ToString() const override {
+    string columns;
+    for (const ColumnPredicate& pred : predicates_) {
+      if (!columns.empty()) columns += ", ";
+      columns += pred.column().name();
+    }
+    return "predicate evaluator on columns [" + columns + "] of schema " +
+        schema_.ToString();
+  }
+
+ private:
+  Schema schema_;
+  vector<ColumnPredicate> predicates_;
+};
+
 } // anonymous namespace
 
 CompilationManager::CompilationManager()
@@ -180,7 +288,7 @@ bool CompilationManager::RequestRowProjector(const Schema* base_schema,
   // If not cached, add a request to compilation pool
   if (!cached) {
     shared_ptr<Runnable> task(
-      new CompilationTask(*base_schema, *projection, &cache_, &generator_));
+      new RowProjectorCompilationTask(*base_schema, *projection, &cache_, &generator_));
     WARN_NOT_OK(pool_->Submit(task),
                 "RowProjector compilation request failed");
     return false;
@@ -192,5 +300,74 @@ bool CompilationManager::RequestRowProjector(const Schema* base_schema,
   return true;
 }
 
+bool CompilationManager::RequestRowComparator(const Schema* schema,
+                                              gscoped_ptr<RowComparator>* out) {
+  // Schemas whose key types have no generated comparison are never
+  // compiled, so don't bother queueing them (or counting them as queries).
+  for (size_t col_idx = 0; col_idx < schema->num_key_columns(); col_idx++) {
+    if (!RowComparatorFunctions::SupportsKeyType(
+            schema->column(col_idx).type_info()->physical_type())) {
+      return false;
+    }
+  }
+
+  faststring key;
+  Status s = RowComparatorFunctions::EncodeKey(*schema, &key);
+  WARN_NOT_OK(s, "RowComparator compilation request failed");
+  if (!s.ok()) return false;
+  query_counter_.Increment();
+
+  scoped_refptr<RowComparatorFunctions> cached(
+    down_cast<RowComparatorFunctions*>(cache_.Lookup(key).get()));
+
+  // If not cached, add a request to compilation pool
+  if (!cached) {
+    shared_ptr<Runnable> task(
+      new RowComparatorCompilationTask(*schema, &cache_, &generator_));
+    WARN_NOT_OK(pool_->Submit(task),
+                "RowComparator compilation request failed");
+    return false;
+  }
+
+  hit_counter_.Increment();
+
+  out->reset(new RowComparator(schema, cached));
+  return true;
+}
+
+bool CompilationManager::RequestPredicateEvaluator(const Schema* schema,
+                                                   const vector<ColumnPredicate>& predicates,
+                                                   gscoped_ptr<PredicateEvaluator>* out) {
+  for (const ColumnPredicate& pred : predicates) {
+    if (!PredicateEvaluatorFunctions::SupportsType(
+            pred.column().type_info()->physical_type())) {
+      return false;
+    }
+  }
+
+  faststring key;
+  Status s = PredicateEvaluatorFunctions::EncodeKey(*schema, predicates, &key);
+  WARN_NOT_OK(s, "PredicateEvaluator compilation request failed");
+  if (!s.ok()) return false;
+  query_counter_.Increment();
+
+  scoped_refptr<PredicateEvaluatorFunctions> cached(
+    down_cast<PredicateEvaluatorFunctions*>(cache_.Lookup(key).get()));
+
+  // If not cached, add a request to compilation pool
+  if (!cached) {
+    shared_ptr<Runnable> task(
+      new PredicateEvaluatorCompilationTask(*schema, predicates, &cache_, &generator_));
+    WARN_NOT_OK(pool_->Submit(task),
+                "PredicateEvaluator compilation request failed");
+    return false;
+  }
+
+  hit_counter_.Increment();
+
+  out->reset(new PredicateEvaluator(schema, predicates, cached));
+  return true;
+}
+
 } // namespace codegen
 } // namespace kudu
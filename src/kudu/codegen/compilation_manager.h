@@ -18,6 +18,8 @@
 #ifndef KUDU_CODEGEN_COMPILATION_MANAGER_H
 #define KUDU_CODEGEN_COMPILATION_MANAGER_H
 
+#include <vector>
+
 #include "kudu/codegen/code_generator.h"
 #include "kudu/codegen/code_cache.h"
 #include "kudu/gutil/gscoped_ptr.h"
@@ -28,6 +30,7 @@
 
 namespace kudu {
 
+class ColumnPredicate;
 class Counter;
 class MetricEntity;
 class MetricRegistry;
@@ -35,6 +38,8 @@ class ThreadPool;
 
 namespace codegen {
 
+class PredicateEvaluator;
+class RowComparator;
 class RowProjector;
 
 // The compilation manager is a top-level class which manages the actual
@@ -76,6 +81,28 @@ class CompilationManager {
                            const Schema* projection,
                            gscoped_ptr<RowProjector>* out);
 
+  // Same as RequestRowProjector(), but for a codegenned row comparator for
+  // the given schema. Returns false without enqueueing anything if the
+  // schema has a key column of a type which cannot be compiled, in which
+  // case callers should use the interpreted kudu::RowComparator.
+  bool RequestRowComparator(const Schema* schema,
+                            gscoped_ptr<RowComparator>* out);
+
+  // Same as RequestRowProjector(), but for a codegenned evaluator of the
+  // conjunction of 'predicates' over rows of the given schema. The compiled
+  // code depends only on the columns and kinds of the predicates, so it is
+  // shared by scans which filter on the same columns with different values.
+  // Returns false without enqueueing anything if any of the predicates is on
+  // a column of a type which cannot be compiled (see
+  // PredicateEvaluatorFunctions::SupportsType()), in which case callers
+  // should evaluate the predicates with ColumnPredicate::Evaluate().
+  //
+  // The evaluator written to 'out' refers to the data of 'predicates', which
+  // must outlive it.
+  bool RequestPredicateEvaluator(const Schema* schema,
+                                 const std::vector<ColumnPredicate>& predicates,
+                                 gscoped_ptr<PredicateEvaluator>* out);
+
   // Waits for all asynchronous compilation tasks to finish.
   void Wait();
 
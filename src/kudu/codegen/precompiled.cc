@@ -85,6 +85,85 @@ IR_ALWAYS_INLINE static bool BasicCopyCell(
   return true;
 }
 
+// Returns a pointer to the cell of column 'col' of 'row', given the size of
+// the column's type.
+IR_ALWAYS_INLINE static uint8_t* RowBlockCellPtr(
+    uint64_t size, const RowBlockRow* row, uint64_t col) {
+  return row->row_block()->column_data_base_ptr(col) + row->row_index() * size;
+}
+
+// Three-way comparison of two values, like TypeInfo::Compare().
+template<class T>
+IR_ALWAYS_INLINE static int CompareValues(const T& lhs, const T& rhs) {
+  return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+}
+
+template<>
+IR_ALWAYS_INLINE int CompareValues<Slice>(const Slice& lhs, const Slice& rhs) {
+  return lhs.compare(rhs);
+}
+
+// Three-way comparison of two cells of type T.
+template<class T>
+IR_ALWAYS_INLINE static int CompareRowBlockCells(
+    const RowBlockRow* lhs, const RowBlockRow* rhs, uint64_t col) {
+  return CompareValues(*reinterpret_cast<const T*>(RowBlockCellPtr(sizeof(T), lhs, col)),
+                       *reinterpret_cast<const T*>(RowBlockCellPtr(sizeof(T), rhs, col)));
+}
+
+// Returns the cell of column 'col' of row 'row' of 'block', or NULL if the
+// column is nullable and the cell is null.
+template<class T>
+IR_ALWAYS_INLINE static const T* RowBlockValue(
+    const RowBlock* block, uint64_t col, uint64_t row, bool nullable) {
+  if (nullable && !BitmapTest(block->column_null_bitmap_ptr(col), row)) {
+    return nullptr;
+  }
+  return reinterpret_cast<const T*>(block->column_data_base_ptr(col)) + row;
+}
+
+// The evaluation of Range, Equality and InList predicates on a cell of type
+// T, as in ColumnPredicate. Null cells never match.
+template<class T>
+IR_ALWAYS_INLINE static bool EvaluateRange(
+    const RowBlock* block, uint64_t col, uint64_t row, bool nullable,
+    const void* lower, bool has_lower, const void* upper, bool has_upper) {
+  const T* value = RowBlockValue<T>(block, col, row, nullable);
+  if (value == nullptr) return false;
+  if (has_lower && CompareValues(*value, *reinterpret_cast<const T*>(lower)) < 0) {
+    return false;
+  }
+  return !has_upper || CompareValues(*value, *reinterpret_cast<const T*>(upper)) < 0;
+}
+
+template<class T>
+IR_ALWAYS_INLINE static bool EvaluateEquality(
+    const RowBlock* block, uint64_t col, uint64_t row, bool nullable,
+    const void* target) {
+  const T* value = RowBlockValue<T>(block, col, row, nullable);
+  return value != nullptr && CompareValues(*value, *reinterpret_cast<const T*>(target)) == 0;
+}
+
+template<class T>
+IR_ALWAYS_INLINE static bool EvaluateInList(
+    const RowBlock* block, uint64_t col, uint64_t row, bool nullable,
+    const void* const* begin, const void* const* end) {
+  const T* value = RowBlockValue<T>(block, col, row, nullable);
+  if (value == nullptr) return false;
+  // The values of an InList predicate are sorted and distinct.
+  while (begin < end) {
+    const void* const* mid = begin + (end - begin) / 2;
+    int cmp = CompareValues(*value, *reinterpret_cast<const T*>(*mid));
+    if (cmp == 0) return true;
+    if (cmp < 0) {
+      end = mid;
+    } else {
+      begin = mid + 1;
+    }
+  }
+  return false;
+}
+
 extern "C" {
 
 // Preface all used functions with _Precompiled to avoid the possibility
@@ -160,5 +239,129 @@ IR_ALWAYS_INLINE void _PrecompiledCopyCellToRowBlockSetNull(
   dst->cell(col).set_null(is_null);
 }
 
+// declare i1 @_PrecompiledCopyRowBlockCell(
+//   i64 size, RowBlockRow* src, RowBlockRow* dst, i64 col, i1 is_string,
+//   Arena* arena)
+//
+//   Performs the same function as _PrecompiledCopyCellToRowBlock, but the
+//   cell is copied from column 'col' of the row 'src' of another RowBlock
+//   with the same column types.
+IR_ALWAYS_INLINE bool _PrecompiledCopyRowBlockCell(
+    uint64_t size, RowBlockRow* src, RowBlockRow* dst,
+    uint64_t col, bool is_string, Arena* arena) {
+  return _PrecompiledCopyCellToRowBlock(size, RowBlockCellPtr(size, src, col),
+                                        dst, col, is_string, arena);
+}
+
+// declare i1 @_PrecompiledCopyRowBlockCellNullable(
+//   i64 size, RowBlockRow* src, RowBlockRow* dst, i64 col, i1 is_string,
+//   Arena* arena)
+//
+//   Performs the same function as _PrecompiledCopyRowBlockCell but for
+//   nullable columns. Unlike the bitmap of a contiguous row, the null bitmap
+//   of a RowBlock column has a bit set for each cell which is not null.
+IR_ALWAYS_INLINE bool _PrecompiledCopyRowBlockCellNullable(
+    uint64_t size, RowBlockRow* src, RowBlockRow* dst,
+    uint64_t col, bool is_string, Arena* arena) {
+  bool is_null = !BitmapTest(src->row_block()->column_null_bitmap_ptr(col),
+                             src->row_index());
+  dst->cell(col).set_null(is_null);
+  if (is_null) return true;
+  return _PrecompiledCopyRowBlockCell(size, src, dst, col, is_string, arena);
+}
+
+// declare i32 @_PrecompiledCompare<Type>Cells(
+//   RowBlockRow* lhs, RowBlockRow* rhs, i64 col)
+//
+//   Compares the non-null cells of column 'col' of the rows 'lhs' and 'rhs',
+//   which are of the given physical type. Returns a negative number, zero or
+//   a positive number if the cell of 'lhs' sorts before, the same as or
+//   after the cell of 'rhs', like TypeInfo::Compare().
+#define DEFINE_PRECOMPILED_COMPARE_CELLS(type_name, cpp_type)             \
+  IR_ALWAYS_INLINE int _PrecompiledCompare##type_name##Cells(             \
+      const RowBlockRow* lhs, const RowBlockRow* rhs, uint64_t col) {     \
+    return CompareRowBlockCells<cpp_type>(lhs, rhs, col);                 \
+  }
+
+DEFINE_PRECOMPILED_COMPARE_CELLS(Int8, int8_t)
+DEFINE_PRECOMPILED_COMPARE_CELLS(Int16, int16_t)
+DEFINE_PRECOMPILED_COMPARE_CELLS(Int32, int32_t)
+DEFINE_PRECOMPILED_COMPARE_CELLS(Int64, int64_t)
+DEFINE_PRECOMPILED_COMPARE_CELLS(Uint8, uint8_t)
+DEFINE_PRECOMPILED_COMPARE_CELLS(Uint16, uint16_t)
+DEFINE_PRECOMPILED_COMPARE_CELLS(Uint32, uint32_t)
+DEFINE_PRECOMPILED_COMPARE_CELLS(Uint64, uint64_t)
+DEFINE_PRECOMPILED_COMPARE_CELLS(Binary, Slice)
+
+#undef DEFINE_PRECOMPILED_COMPARE_CELLS
+
+// declare i1 @_PrecompiledRowIsSelected(i8* sel, i64 row)
+//
+//   Returns whether the bit of 'row' is set in the selection bitmap 'sel'.
+IR_ALWAYS_INLINE bool _PrecompiledRowIsSelected(const uint8_t* sel, uint64_t row) {
+  return BitmapTest(sel, row);
+}
+
+// declare void @_PrecompiledSetRowUnselected(i8* sel, i64 row)
+//
+//   Clears the bit of 'row' in the selection bitmap 'sel'.
+IR_ALWAYS_INLINE void _PrecompiledSetRowUnselected(uint8_t* sel, uint64_t row) {
+  BitmapClear(sel, row);
+}
+
+// declare i1 @_PrecompiledRowBlockCellIsNull(RowBlock* block, i64 col, i64 row)
+//
+//   Returns whether the cell of column 'col' of row 'row' of 'block' is
+//   null. The column must be nullable.
+IR_ALWAYS_INLINE bool _PrecompiledRowBlockCellIsNull(
+    const RowBlock* block, uint64_t col, uint64_t row) {
+  return !BitmapTest(block->column_null_bitmap_ptr(col), row);
+}
+
+// declare i1 @_PrecompiledEvaluate<Type>Range(
+//   RowBlock* block, i64 col, i64 row, i1 nullable,
+//   i8* lower, i1 has_lower, i8* upper, i1 has_upper)
+// declare i1 @_PrecompiledEvaluate<Type>Equality(
+//   RowBlock* block, i64 col, i64 row, i1 nullable, i8* value)
+// declare i1 @_PrecompiledEvaluate<Type>InList(
+//   RowBlock* block, i64 col, i64 row, i1 nullable, i8** begin, i8** end)
+//
+//   Evaluate a Range, Equality or InList ColumnPredicate on the cell of
+//   column 'col' of row 'row' of 'block', which is of the given physical
+//   type. The bounds and values point to values of that type. The InList
+//   values in [begin, end) must be sorted. Null cells never match.
+#define DEFINE_PRECOMPILED_EVALUATE(type_name, cpp_type)                        \
+  IR_ALWAYS_INLINE bool _PrecompiledEvaluate##type_name##Range(                 \
+      const RowBlock* block, uint64_t col, uint64_t row, bool nullable,         \
+      const void* lower, bool has_lower, const void* upper, bool has_upper) {   \
+    return EvaluateRange<cpp_type>(block, col, row, nullable,                   \
+                                   lower, has_lower, upper, has_upper);         \
+  }                                                                             \
+  IR_ALWAYS_INLINE bool _PrecompiledEvaluate##type_name##Equality(              \
+      const RowBlock* block, uint64_t col, uint64_t row, bool nullable,         \
+      const void* value) {                                                      \
+    return EvaluateEquality<cpp_type>(block, col, row, nullable, value);        \
+  }                                                                             \
+  IR_ALWAYS_INLINE bool _PrecompiledEvaluate##type_name##InList(                \
+      const RowBlock* block, uint64_t col, uint64_t row, bool nullable,         \
+      const void* const* begin, const void* const* end) {                       \
+    return EvaluateInList<cpp_type>(block, col, row, nullable, begin, end);     \
+  }
+
+DEFINE_PRECOMPILED_EVALUATE(Bool, bool)
+DEFINE_PRECOMPILED_EVALUATE(Int8, int8_t)
+DEFINE_PRECOMPILED_EVALUATE(Int16, int16_t)
+DEFINE_PRECOMPILED_EVALUATE(Int32, int32_t)
+DEFINE_PRECOMPILED_EVALUATE(Int64, int64_t)
+DEFINE_PRECOMPILED_EVALUATE(Uint8, uint8_t)
+DEFINE_PRECOMPILED_EVALUATE(Uint16, uint16_t)
+DEFINE_PRECOMPILED_EVALUATE(Uint32, uint32_t)
+DEFINE_PRECOMPILED_EVALUATE(Uint64, uint64_t)
+DEFINE_PRECOMPILED_EVALUATE(Float, float)
+DEFINE_PRECOMPILED_EVALUATE(Double, double)
+DEFINE_PRECOMPILED_EVALUATE(Binary, Slice)
+
+#undef DEFINE_PRECOMPILED_EVALUATE
+
 } // extern "C"
 } // namespace kudu
@@ -0,0 +1,439 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/codegen/predicate_evaluator.h"
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/IR/Argument.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+
+#include "kudu/codegen/jit_wrapper.h"
+#include "kudu/codegen/module_builder.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/strcat.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/status.h"
+
+namespace llvm {
+class LLVMContext;
+} // namespace llvm
+
+using llvm::Argument;
+using llvm::BasicBlock;
+using llvm::Function;
+using llvm::FunctionType;
+using llvm::LLVMContext;
+using llvm::PHINode;
+using llvm::PointerType;
+using llvm::Type;
+using llvm::Value;
+using std::ostream;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+DECLARE_bool(codegen_dump_functions);
+
+namespace kudu {
+namespace codegen {
+
+namespace {
+
+// Writes the name of the type as used by the precompiled
+// _PrecompiledEvaluate<Type><Predicate> functions (see precompiled.cc)
+// to 'name', or returns Status::NotSupported() if there are no such
+// functions for the type.
+Status GetPrecompiledTypeName(DataType physical_type, const char** name) {
+  switch (physical_type) {
+    case BOOL: *name = "Bool"; break;
+    case INT8: *name = "Int8"; break;
+    case INT16: *name = "Int16"; break;
+    case INT32: *name = "Int32"; break;
+    case INT64: *name = "Int64"; break;
+    case UINT8: *name = "Uint8"; break;
+    case UINT16: *name = "Uint16"; break;
+    case UINT32: *name = "Uint32"; break;
+    case UINT64: *name = "Uint64"; break;
+    case FLOAT: *name = "Float"; break;
+    case DOUBLE: *name = "Double"; break;
+    case BINARY: *name = "Binary"; break;
+    default:
+      return Status::NotSupported("no generated predicate evaluation for type",
+                                  GetTypeInfo(physical_type)->name());
+  }
+  return Status::OK();
+}
+
+// Returns the index in 'schema' of the column of 'pred'.
+Status FindPredicateColumn(const Schema& schema, const ColumnPredicate& pred,
+                           size_t* col_idx) {
+  int idx = schema.find_column(pred.column().name());
+  if (idx == Schema::kColumnNotFound) {
+    return Status::InvalidArgument("predicate on a column missing from the schema",
+                                   pred.ToString());
+  }
+  if (!schema.column(idx).EqualsType(pred.column())) {
+    return Status::InvalidArgument("predicate on a column of a different type",
+                                   pred.ToString());
+  }
+  *col_idx = idx;
+  return Status::OK();
+}
+
+// Generates an evaluation function of the form:
+// void(RowBlock* block, i8* sel, i64 nrows, i8** args)
+// See PredicateEvaluatorFunctions::EvaluateFunction.
+//
+// Requires that every predicate is on a column of 'schema'.
+Function* MakeEvaluate(const string& name, ModuleBuilder* mbuilder,
+                       const Schema& schema, const vector<ColumnPredicate>& predicates) {
+  ModuleBuilder::LLVMBuilder* builder = mbuilder->builder();
+  LLVMContext& context = builder->getContext();
+
+  Type* i8_ptr = Type::getInt8PtrTy(context);
+  vector<Type*> argtypes = { PointerType::getUnqual(mbuilder->GetType("class.kudu::RowBlock")),
+                             i8_ptr,
+                             Type::getInt64Ty(context),
+                             PointerType::getUnqual(i8_ptr) };
+  FunctionType* fty = FunctionType::get(Type::getVoidTy(context), argtypes, false);
+  Function* f = mbuilder->Create(fty, name);
+
+  Function::arg_iterator it = f->arg_begin();
+  Argument* block = &*it++;
+  Argument* sel = &*it++;
+  Argument* nrows = &*it++;
+  Argument* args = &*it++;
+  DCHECK(it == f->arg_end());
+  block->setName("block");
+  sel->setName("sel");
+  nrows->setName("nrows");
+  args->setName("args");
+
+  // Evaluate function in IR (note: values in angle brackets are constants
+  // whose values are determined at JIT time):
+  //
+  // define void @name(RowBlock* %block, i8* %sel, i64 %nrows, i8** %args)
+  // entry:
+  //   <for each predicate argument k>
+  //     %arg<k> = load i8** (getelementptr i8** %args, i64 <k>)
+  //   br label %loop
+  // loop:
+  //   %row = phi i64 [ 0, %entry ], [ %next_row, %next ]
+  //   %done = icmp uge i64 %row, %nrows
+  //   br i1 %done, label %exit, label %check
+  // check:
+  //   %selected = call i1 @_PrecompiledRowIsSelected(i8* %sel, i64 %row)
+  //   br i1 %selected, label %pred0, label %next
+  // <for each predicate i>
+  //   pred<i>:
+  //     %match<i> = call i1 @_PrecompiledEvaluate<Type><Predicate>(
+  //       RowBlock* %block, i64 <column index>, i64 %row, i1 <nullable>,
+  //       <the predicate's arguments and flags>)*
+  //     br i1 %match<i>, label %pred<i+1>**, label %unselect
+  // <end implicit for each>
+  // unselect:
+  //   call void @_PrecompiledSetRowUnselected(i8* %sel, i64 %row)
+  //   br label %next
+  // next:
+  //   %next_row = add i64 %row, 1
+  //   br label %loop
+  // exit:
+  //   ret void
+  //
+  // *IS NULL and IS NOT NULL predicates call @_PrecompiledRowBlockCellIsNull
+  // instead, and None predicates never match.
+  // **The last predicate branches to %next.
+  //
+  // The precompiled functions are inlined, and their constant flags folded,
+  // so the result is a single loop with the tests of all the predicates.
+  BasicBlock* entry = BasicBlock::Create(context, "entry", f);
+  BasicBlock* loop = BasicBlock::Create(context, "loop", f);
+  BasicBlock* check = BasicBlock::Create(context, "check", f);
+  BasicBlock* unselect = BasicBlock::Create(context, "unselect", f);
+  BasicBlock* next = BasicBlock::Create(context, "next", f);
+  BasicBlock* exit = BasicBlock::Create(context, "exit", f);
+
+  // Load the arguments of the predicates once, outside of the loop.
+  builder->SetInsertPoint(entry);
+  vector<Value*> pred_args;
+  for (const ColumnPredicate& pred : predicates) {
+    int num_args = 0;
+    switch (pred.predicate_type()) {
+      case PredicateType::Range:
+      case PredicateType::InList: num_args = 2; break;
+      case PredicateType::Equality: num_args = 1; break;
+      default: break;
+    }
+    for (int i = 0; i < num_args; i++) {
+      Value* arg = builder->CreateLoad(builder->CreateConstGEP1_64(args, pred_args.size()));
+      arg->setName(StrCat("arg", pred_args.size()));
+      pred_args.push_back(arg);
+    }
+  }
+  builder->CreateBr(loop);
+
+  builder->SetInsertPoint(loop);
+  PHINode* row = builder->CreatePHI(Type::getInt64Ty(context), 2, "row");
+  row->addIncoming(builder->getInt64(0), entry);
+  Value* done = builder->CreateICmpUGE(row, nrows, "done");
+  builder->CreateCondBr(done, exit, check);
+
+  builder->SetInsertPoint(check);
+  Value* selected = builder->CreateCall(mbuilder->GetFunction("_PrecompiledRowIsSelected"),
+                                        vector<Value*>{ sel, row });
+  selected->setName("selected");
+  BasicBlock* first_pred = predicates.empty() ? next :
+      BasicBlock::Create(context, "pred0", f, unselect);
+  builder->CreateCondBr(selected, first_pred, next);
+
+  size_t arg_idx = 0;
+  BasicBlock* cur_pred = first_pred;
+  for (size_t i = 0; i < predicates.size(); i++) {
+    const ColumnPredicate& pred = predicates[i];
+    size_t col_idx;
+    CHECK_OK(FindPredicateColumn(schema, pred, &col_idx));
+    const ColumnSchema& col = schema.column(col_idx);
+    const char* type_name;
+    CHECK_OK(GetPrecompiledTypeName(col.type_info()->physical_type(), &type_name));
+
+    builder->SetInsertPoint(cur_pred);
+    Value* col_value = builder->getInt64(col_idx);
+    Value* nullable = builder->getInt1(col.is_nullable());
+    Value* match;
+    switch (pred.predicate_type()) {
+      case PredicateType::Range: {
+        vector<Value*> call_args = { block, col_value, row, nullable,
+                                     pred_args[arg_idx],
+                                     builder->getInt1(pred.raw_lower() != nullptr),
+                                     pred_args[arg_idx + 1],
+                                     builder->getInt1(pred.raw_upper() != nullptr) };
+        arg_idx += 2;
+        match = builder->CreateCall(
+            mbuilder->GetFunction(StrCat("_PrecompiledEvaluate", type_name, "Range")), call_args);
+        break;
+      }
+      case PredicateType::Equality: {
+        vector<Value*> call_args = { block, col_value, row, nullable, pred_args[arg_idx] };
+        arg_idx += 1;
+        match = builder->CreateCall(
+            mbuilder->GetFunction(StrCat("_PrecompiledEvaluate", type_name, "Equality")),
+            call_args);
+        break;
+      }
+      case PredicateType::InList: {
+        Type* i8_ptr_ptr = PointerType::getUnqual(i8_ptr);
+        vector<Value*> call_args = {
+          block, col_value, row, nullable,
+          builder->CreateBitCast(pred_args[arg_idx], i8_ptr_ptr),
+          builder->CreateBitCast(pred_args[arg_idx + 1], i8_ptr_ptr) };
+        arg_idx += 2;
+        match = builder->CreateCall(
+            mbuilder->GetFunction(StrCat("_PrecompiledEvaluate", type_name, "InList")),
+            call_args);
+        break;
+      }
+      case PredicateType::IsNull:
+      case PredicateType::IsNotNull: {
+        if (!col.is_nullable()) {
+          // A non-nullable cell is never null.
+          match = builder->getInt1(pred.predicate_type() == PredicateType::IsNotNull);
+          break;
+        }
+        match = builder->CreateCall(mbuilder->GetFunction("_PrecompiledRowBlockCellIsNull"),
+                                    vector<Value*>{ block, col_value, row });
+        if (pred.predicate_type() == PredicateType::IsNotNull) {
+          match = builder->CreateNot(match);
+        }
+        break;
+      }
+      case PredicateType::None:
+        match = builder->getInt1(false);
+        break;
+    }
+    match->setName(StrCat("match", i));
+
+    BasicBlock* next_pred = i + 1 == predicates.size() ? next :
+        BasicBlock::Create(context, StrCat("pred", i + 1), f, unselect);
+    builder->CreateCondBr(match, next_pred, unselect);
+    cur_pred = next_pred;
+  }
+
+  builder->SetInsertPoint(unselect);
+  builder->CreateCall(mbuilder->GetFunction("_PrecompiledSetRowUnselected"),
+                      vector<Value*>{ sel, row });
+  builder->CreateBr(next);
+
+  builder->SetInsertPoint(next);
+  Value* next_row = builder->CreateAdd(row, builder->getInt64(1), "next_row");
+  row->addIncoming(next_row, next);
+  builder->CreateBr(loop);
+
+  builder->SetInsertPoint(exit);
+  builder->CreateRetVoid();
+
+  if (FLAGS_codegen_dump_functions) {
+    LOG(INFO) << "Dumping predicate evaluation:";
+    f->dump();
+  }
+
+  return f;
+}
+
+} // anonymous namespace
+
+bool PredicateEvaluatorFunctions::SupportsType(DataType physical_type) {
+  const char* unused;
+  return GetPrecompiledTypeName(physical_type, &unused).ok();
+}
+
+PredicateEvaluatorFunctions::PredicateEvaluatorFunctions(string key,
+                                                         EvaluateFunction evaluate_f,
+                                                         unique_ptr<JITCodeOwner> owner)
+  : JITWrapper(std::move(owner)),
+    key_(std::move(key)),
+    evaluate_f_(evaluate_f) {
+  CHECK(evaluate_f != nullptr)
+    << "Promise to compile evaluate function not fulfilled by ModuleBuilder";
+}
+
+Status PredicateEvaluatorFunctions::Create(const Schema& schema,
+                                           const vector<ColumnPredicate>& predicates,
+                                           scoped_refptr<PredicateEvaluatorFunctions>* out,
+                                           llvm::TargetMachine** tm) {
+  // Validates the columns and types of the predicates, too.
+  faststring key;
+  RETURN_NOT_OK(EncodeKey(schema, predicates, &key));
+
+  ModuleBuilder builder;
+  RETURN_NOT_OK(builder.Init());
+
+  Function* evaluate = MakeEvaluate("PredEvaluate", &builder, schema, predicates);
+
+  EvaluateFunction evaluate_f;
+  builder.AddJITPromise(evaluate, &evaluate_f);
+
+  unique_ptr<JITCodeOwner> owner;
+  RETURN_NOT_OK(builder.Compile(&owner));
+
+  if (tm) {
+    *tm = builder.GetTargetMachine();
+  }
+  out->reset(new PredicateEvaluatorFunctions(key.ToString(), evaluate_f, std::move(owner)));
+  return Status::OK();
+}
+
+namespace {
+// Convenience method which appends to a faststring
+template<typename T>
+void AddNext(faststring* fs, const T& val) {
+  fs->append(&val, sizeof(T));
+}
+} // anonymous namespace
+
+// Generates the key for a conjunction of predicates, in the same spirit as
+// RowProjectorFunctions::EncodeKey(). The generated code depends on the
+// columns the predicates are on and on the kinds of the predicates, but
+// not on their values, so the key is encoded as follows, in sequence.
+//
+// (1 byte) unique type identifier for PredicateEvaluatorFunctions
+// (8 bytes) number, as unsigned long, of predicates
+// (19 bytes each) predicates, in order
+//   8 bytes for the column index
+//   4 bytes for the column's physical type enum
+//   1 byte for the column's nullability
+//   4 bytes for the predicate type enum
+//   1 byte each for whether there is a lower bound and an upper bound
+//
+// Writes to 'out' upon success.
+Status PredicateEvaluatorFunctions::EncodeKey(const Schema& schema,
+                                              const vector<ColumnPredicate>& predicates,
+                                              faststring* out) {
+  AddNext(out, JITWrapper::PREDICATE_EVALUATOR);
+  AddNext(out, predicates.size());
+  for (const ColumnPredicate& pred : predicates) {
+    size_t col_idx;
+    RETURN_NOT_OK(FindPredicateColumn(schema, pred, &col_idx));
+    const ColumnSchema& col = schema.column(col_idx);
+    const char* unused;
+    RETURN_NOT_OK(GetPrecompiledTypeName(col.type_info()->physical_type(), &unused));
+    AddNext(out, col_idx);
+    AddNext(out, col.type_info()->physical_type());
+    AddNext(out, col.is_nullable());
+    AddNext(out, pred.predicate_type());
+    bool is_range = pred.predicate_type() == PredicateType::Range;
+    AddNext(out, is_range && pred.raw_lower() != nullptr);
+    AddNext(out, is_range && pred.raw_upper() != nullptr);
+  }
+  return Status::OK();
+}
+
+PredicateEvaluator::PredicateEvaluator(
+    const Schema* schema, vector<ColumnPredicate> predicates,
+    const scoped_refptr<PredicateEvaluatorFunctions>& functions)
+  : schema_(schema),
+    predicates_(std::move(predicates)),
+    functions_(functions) {
+  for (const ColumnPredicate& pred : predicates_) {
+    switch (pred.predicate_type()) {
+      case PredicateType::Range:
+        args_.push_back(pred.raw_lower());
+        args_.push_back(pred.raw_upper());
+        break;
+      case PredicateType::Equality:
+        args_.push_back(pred.raw_lower());
+        break;
+      case PredicateType::InList: {
+        const vector<const void*>& values = pred.raw_values();
+        args_.push_back(values.data());
+        args_.push_back(values.data() + values.size());
+        break;
+      }
+      default:
+        break;
+    }
+  }
+#ifndef NDEBUG
+  faststring key, compiled_key;
+  CHECK_OK(PredicateEvaluatorFunctions::EncodeKey(*schema_, predicates_, &key));
+  CHECK_OK(functions_->EncodeOwnKey(&compiled_key));
+  CHECK(key.ToString() == compiled_key.ToString())
+    << "Codegenned predicate evaluator's predicates incompatible with its functions";
+#endif
+}
+
+ostream& operator<<(ostream& o, const PredicateEvaluator& pe) {
+  o << "Predicate Evaluator of";
+  for (const ColumnPredicate& pred : pe.predicates()) {
+    o << " " << pred.ToString();
+  }
+  return o;
+}
+
+} // namespace codegen
+} // namespace kudu
@@ -0,0 +1,131 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CODEGEN_PREDICATE_EVALUATOR_H
+#define KUDU_CODEGEN_PREDICATE_EVALUATOR_H
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kudu/codegen/jit_wrapper.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/status.h"
+
+namespace llvm {
+class TargetMachine;
+} // namespace llvm
+
+namespace kudu {
+namespace codegen {
+
+// A single function which evaluates a conjunction of ColumnPredicates on the
+// rows of a RowBlock in one pass, specialized for the types of the columns
+// and the types of the predicates.
+//
+// The code depends only on the "shape" of the predicates, not on their
+// values, which are passed in when the function is called. Scans which
+// repeat the same kind of filter with different literals thus share the
+// compiled code.
+class PredicateEvaluatorFunctions : public JITWrapper {
+ public:
+  // Compiles the evaluation function for the given predicates over rows of
+  // the given schema, in the order given. Every predicate must be on a
+  // column of 'schema'.
+  // Writes the llvm::TargetMachine* used to 'tm' (if not NULL)
+  // and the functions to 'out' upon success.
+  static Status Create(const Schema& schema,
+                       const std::vector<ColumnPredicate>& predicates,
+                       scoped_refptr<PredicateEvaluatorFunctions>* out,
+                       llvm::TargetMachine** tm = NULL);
+
+  // Clears the bits in 'sel' of the rows among the first 'nrows' rows of
+  // 'block' which do not match all the predicates. Rows whose bits are
+  // already clear are skipped. 'args' holds the values of the predicates,
+  // as built by PredicateEvaluator.
+  typedef void(*EvaluateFunction)(const RowBlock* block, uint8_t* sel, uint64_t nrows,
+                                  const void* const* args);
+  EvaluateFunction evaluate() const { return evaluate_f_; }
+
+  virtual Status EncodeOwnKey(faststring* out) OVERRIDE {
+    out->append(key_);
+    return Status::OK();
+  }
+
+  // Returns an error if any predicate is not on a column of 'schema', or
+  // is on a column of a type which is not supported.
+  static Status EncodeKey(const Schema& schema,
+                          const std::vector<ColumnPredicate>& predicates,
+                          faststring* out);
+
+  // Returns true if predicates on columns of the given physical type
+  // can be compiled.
+  static bool SupportsType(DataType physical_type);
+
+ private:
+  PredicateEvaluatorFunctions(std::string key, EvaluateFunction evaluate_f,
+                              std::unique_ptr<JITCodeOwner> owner);
+
+  // The predicates themselves may point to data which does not outlive
+  // the scan they came from, so only their encoded key is kept.
+  const std::string key_;
+  const EvaluateFunction evaluate_f_;
+};
+
+// Evaluates a conjunction of ColumnPredicates on RowBlocks with a
+// PredicateEvaluatorFunctions.
+class PredicateEvaluator {
+ public:
+  // Requires that 'schema' remain valid for the lifetime of this object,
+  // and that the data of the predicates does too. Also requires that the
+  // predicates have the same shape as the ones used to create 'functions'.
+  PredicateEvaluator(const Schema* schema, std::vector<ColumnPredicate> predicates,
+                     const scoped_refptr<PredicateEvaluatorFunctions>& functions);
+
+  // Evaluates the predicates on every selected row of 'block', which must
+  // have the schema of this evaluator, clearing the bits of the rows which
+  // do not match all of them in 'sel'.
+  //
+  // This is equivalent to calling ColumnPredicate::Evaluate() with each of
+  // the predicates on the column blocks of 'block'.
+  void Evaluate(const RowBlock& block, SelectionVector* sel) const {
+    DCHECK_EQ(block.nrows(), sel->nrows());
+    functions_->evaluate()(&block, sel->mutable_bitmap(), block.nrows(), args_.data());
+  }
+
+  const std::vector<ColumnPredicate>& predicates() const { return predicates_; }
+
+ private:
+  const Schema* const schema_;
+  const std::vector<ColumnPredicate> predicates_;
+  // The values of 'predicates_' passed to the evaluation function. See
+  // PredicateEvaluatorFunctions::Create() for the layout.
+  std::vector<const void*> args_;
+  scoped_refptr<PredicateEvaluatorFunctions> functions_;
+
+  DISALLOW_COPY_AND_ASSIGN(PredicateEvaluator);
+};
+
+extern std::ostream& operator<<(std::ostream& o, const PredicateEvaluator& pe);
+
+} // namespace codegen
+} // namespace kudu
+
+#endif
@@ -0,0 +1,339 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/codegen/row_comparator.h"
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/IR/Argument.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Type.h>
+
+#include "kudu/codegen/jit_wrapper.h"
+#include "kudu/codegen/module_builder.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/gutil/strings/strcat.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/status.h"
+
+namespace llvm {
+class LLVMContext;
+} // namespace llvm
+
+using llvm::Argument;
+using llvm::BasicBlock;
+using llvm::ConstantInt;
+using llvm::Function;
+using llvm::FunctionType;
+using llvm::LLVMContext;
+using llvm::PointerType;
+using llvm::Type;
+using llvm::Value;
+using std::ostream;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+DECLARE_bool(codegen_dump_functions);
+
+namespace kudu {
+namespace codegen {
+
+namespace {
+
+// Returns the name of the precompiled function which compares two cells of
+// the given physical type (see precompiled.cc), or NotSupported if there is
+// none.
+Status GetCompareCellsFunctionName(DataType physical_type, string* name) {
+  const char* type_name;
+  switch (physical_type) {
+    case INT8: type_name = "Int8"; break;
+    case INT16: type_name = "Int16"; break;
+    case INT32: type_name = "Int32"; break;
+    case INT64: type_name = "Int64"; break;
+    case UINT8: type_name = "Uint8"; break;
+    case UINT16: type_name = "Uint16"; break;
+    case UINT32: type_name = "Uint32"; break;
+    case UINT64: type_name = "Uint64"; break;
+    case BINARY: type_name = "Binary"; break;
+    default:
+      return Status::NotSupported("no generated comparison for key column type",
+                                  GetTypeInfo(physical_type)->name());
+  }
+  *name = StrCat("_PrecompiledCompare", type_name, "Cells");
+  return Status::OK();
+}
+
+// Generates a key comparison function of the form:
+// int(RowBlockRow* lhs, RowBlockRow* rhs)
+// which returns the same as Schema::Compare() on the two rows.
+//
+// Requires that every key column has a supported type (see
+// GetCompareCellsFunctionName()).
+Function* MakeCompare(const string& name, ModuleBuilder* mbuilder,
+                      const Schema& schema) {
+  ModuleBuilder::LLVMBuilder* builder = mbuilder->builder();
+  LLVMContext& context = builder->getContext();
+
+  Type* rbrow_type = PointerType::getUnqual(mbuilder->GetType("class.kudu::RowBlockRow"));
+  vector<Type*> argtypes = { rbrow_type, rbrow_type };
+  FunctionType* fty = FunctionType::get(Type::getInt32Ty(context), argtypes, false);
+  Function* f = mbuilder->Create(fty, name);
+
+  Function::arg_iterator it = f->arg_begin();
+  Argument* lhs = &*it++;
+  Argument* rhs = &*it++;
+  DCHECK(it == f->arg_end());
+  lhs->setName("lhs");
+  rhs->setName("rhs");
+
+  // Compare row function in IR:
+  //
+  // define i32 @name(RowBlockRow* %lhs, RowBlockRow* %rhs)
+  // entry:
+  //   <for each key column but the last>
+  //     %cmp = call i32 @_PrecompiledCompare<Type>Cells(
+  //       RowBlockRow* %lhs, RowBlockRow* %rhs, i64 <column index>)
+  //     %ne = icmp ne i32 %cmp, 0
+  //     br i1 %ne, label %ret, label %next
+  //   ret:
+  //     ret i32 %cmp
+  //   next:
+  //   <end implicit for each>
+  //   %cmp = call i32 @_PrecompiledCompare<Type>Cells(<last key column>)
+  //   ret i32 %cmp
+  //
+  // Key columns are never nullable, so there is no null handling.
+  builder->SetInsertPoint(BasicBlock::Create(context, "entry", f));
+  size_t num_keys = schema.num_key_columns();
+  for (size_t col_idx = 0; col_idx < num_keys; col_idx++) {
+    string fname;
+    CHECK_OK(GetCompareCellsFunctionName(
+        schema.column(col_idx).type_info()->physical_type(), &fname));
+    vector<Value*> args = { lhs, rhs, builder->getInt64(col_idx) };
+    Value* cmp = builder->CreateCall(mbuilder->GetFunction(fname), args);
+    cmp->setName(StrCat("cmp", col_idx));
+    if (col_idx == num_keys - 1) {
+      builder->CreateRet(cmp);
+      break;
+    }
+    BasicBlock* ret = BasicBlock::Create(context, StrCat("ret", col_idx), f);
+    BasicBlock* next = BasicBlock::Create(context, StrCat("key", col_idx + 1), f);
+    Value* ne = builder->CreateICmpNE(cmp, builder->getInt32(0));
+    builder->CreateCondBr(ne, ret, next);
+    builder->SetInsertPoint(ret);
+    builder->CreateRet(cmp);
+    builder->SetInsertPoint(next);
+  }
+
+  if (FLAGS_codegen_dump_functions) {
+    LOG(INFO) << "Dumping row comparison:";
+    f->dump();
+  }
+
+  return f;
+}
+
+// Generates a row copy function of the form:
+// bool(RowBlockRow* src, RowBlockRow* dst, Arena* arena)
+// which copies every cell of 'src' into 'dst', like CopyRow(). Returns false
+// if the relocation of a string into 'arena' fails.
+Function* MakeCopy(const string& name, ModuleBuilder* mbuilder,
+                   const Schema& schema) {
+  ModuleBuilder::LLVMBuilder* builder = mbuilder->builder();
+  LLVMContext& context = builder->getContext();
+
+  Type* rbrow_type = PointerType::getUnqual(mbuilder->GetType("class.kudu::RowBlockRow"));
+  vector<Type*> argtypes = { rbrow_type, rbrow_type,
+                             PointerType::getUnqual(mbuilder->GetType("class.kudu::Arena")) };
+  FunctionType* fty = FunctionType::get(Type::getInt1Ty(context), argtypes, false);
+  Function* f = mbuilder->Create(fty, name);
+
+  Function::arg_iterator it = f->arg_begin();
+  Argument* src = &*it++;
+  Argument* dst = &*it++;
+  Argument* arena = &*it++;
+  DCHECK(it == f->arg_end());
+  src->setName("src");
+  dst->setName("dst");
+  arena->setName("arena");
+
+  // The source and destination rows are always in different blocks.
+  // Note that these arguments are 1-based indexes.
+  f->setDoesNotAlias(1);
+  f->setDoesNotAlias(2);
+  f->setDoesNotAlias(3);
+
+  // Copy row function in IR:
+  //
+  // define i1 @name(RowBlockRow* noalias %src, RowBlockRow* noalias %dst,
+  //                 Arena* noalias %arena)
+  // entry:
+  //   <for each column>
+  //     %result = call i1 @_PrecompiledCopyRowBlockCell(
+  //       i64 <type size>, RowBlockRow* %src, RowBlockRow* %dst,
+  //       i64 <column index>, i1 <is binary>, Arena* %arena)*
+  //     %success = and %success, %result
+  //   <end implicit for each>
+  //   ret i1 %success
+  //
+  // *If the column is nullable, @_PrecompiledCopyRowBlockCellNullable is
+  // called instead, with the same arguments.
+  Function* copy_cell_not_null = mbuilder->GetFunction("_PrecompiledCopyRowBlockCell");
+  Function* copy_cell_nullable = mbuilder->GetFunction("_PrecompiledCopyRowBlockCellNullable");
+
+  builder->SetInsertPoint(BasicBlock::Create(context, "entry", f));
+  Value* success = builder->getInt1(true);
+  for (size_t col_idx = 0; col_idx < schema.num_columns(); col_idx++) {
+    const ColumnSchema& col = schema.column(col_idx);
+    ConstantInt* is_binary = builder->getInt1(col.type_info()->physical_type() == BINARY);
+    vector<Value*> args = { builder->getInt64(col.type_info()->size()), src, dst,
+                            builder->getInt64(col_idx), is_binary, arena };
+    Value* result = builder->CreateCall(
+        col.is_nullable() ? copy_cell_nullable : copy_cell_not_null, args);
+    result->setName(StrCat("result", col_idx));
+    success = builder->CreateAnd(success, result);
+    success->setName(StrCat("success", col_idx));
+  }
+  builder->CreateRet(success);
+
+  if (FLAGS_codegen_dump_functions) {
+    LOG(INFO) << "Dumping row copy:";
+    f->dump();
+  }
+
+  return f;
+}
+
+} // anonymous namespace
+
+RowComparatorFunctions::RowComparatorFunctions(const Schema& schema,
+                                               CompareFunction compare_f,
+                                               CopyFunction copy_f,
+                                               unique_ptr<JITCodeOwner> owner)
+  : JITWrapper(std::move(owner)),
+    schema_(schema),
+    compare_f_(compare_f),
+    copy_f_(copy_f) {
+  CHECK(compare_f != nullptr)
+    << "Promise to compile compare function not fulfilled by ModuleBuilder";
+  CHECK(copy_f != nullptr)
+    << "Promise to compile copy function not fulfilled by ModuleBuilder";
+}
+
+bool RowComparatorFunctions::SupportsKeyType(DataType physical_type) {
+  string unused;
+  return GetCompareCellsFunctionName(physical_type, &unused).ok();
+}
+
+Status RowComparatorFunctions::Create(const Schema& schema,
+                                      scoped_refptr<RowComparatorFunctions>* out,
+                                      llvm::TargetMachine** tm) {
+  if (schema.num_key_columns() == 0) {
+    return Status::InvalidArgument("schema has no key columns", schema.ToString());
+  }
+  for (size_t col_idx = 0; col_idx < schema.num_key_columns(); col_idx++) {
+    string unused;
+    RETURN_NOT_OK(GetCompareCellsFunctionName(
+        schema.column(col_idx).type_info()->physical_type(), &unused));
+  }
+
+  ModuleBuilder builder;
+  RETURN_NOT_OK(builder.Init());
+
+  Function* compare = MakeCompare("RowCompare", &builder, schema);
+  Function* copy = MakeCopy("RowCopy", &builder, schema);
+
+  CompareFunction compare_f;
+  CopyFunction copy_f;
+  builder.AddJITPromise(compare, &compare_f);
+  builder.AddJITPromise(copy, &copy_f);
+
+  unique_ptr<JITCodeOwner> owner;
+  RETURN_NOT_OK(builder.Compile(&owner));
+
+  if (tm) {
+    *tm = builder.GetTargetMachine();
+  }
+  out->reset(new RowComparatorFunctions(schema, compare_f, copy_f, std::move(owner)));
+  return Status::OK();
+}
+
+namespace {
+// Convenience method which appends to a faststring
+template<typename T>
+void AddNext(faststring* fs, const T& val) {
+  fs->append(&val, sizeof(T));
+}
+} // anonymous namespace
+
+// Generates the key for a schema, in the same spirit as
+// RowProjectorFunctions::EncodeKey(). The generated code only depends on the
+// types and nullability of the columns and on which of them are keys, so
+// the key is encoded as follows, in sequence.
+//
+// (1 byte) unique type identifier for RowComparatorFunctions
+// (8 bytes) number, as unsigned long, of columns
+// (8 bytes) number, as unsigned long, of key columns
+// (5 bytes each) column types, in order
+//   4 bytes for enum type
+//   1 byte for nullability
+//
+// Writes to 'out' upon success.
+Status RowComparatorFunctions::EncodeKey(const Schema& schema, faststring* out) {
+  AddNext(out, JITWrapper::ROW_COMPARATOR);
+  AddNext(out, schema.num_columns());
+  AddNext(out, schema.num_key_columns());
+  for (const ColumnSchema& col : schema.columns()) {
+    AddNext(out, col.type_info()->physical_type());
+    AddNext(out, col.is_nullable());
+  }
+  return Status::OK();
+}
+
+RowComparator::RowComparator(const Schema* schema,
+                             const scoped_refptr<RowComparatorFunctions>& functions)
+  : kudu::RowComparator(schema),
+    functions_(functions) {
+#ifndef NDEBUG
+  const Schema& compiled = functions_->schema();
+  CHECK_EQ(schema->num_key_columns(), compiled.num_key_columns());
+  CHECK_EQ(schema->num_columns(), compiled.num_columns());
+  for (size_t col_idx = 0; col_idx < schema->num_columns(); col_idx++) {
+    CHECK(schema->column(col_idx).EqualsType(compiled.column(col_idx)))
+      << "Codegenned row comparator's schema incompatible with its functions' schema:"
+      << "\n  comparator schema = " << schema->ToString()
+      << "\n  functions schema = " << compiled.ToString();
+  }
+#endif
+}
+
+ostream& operator<<(ostream& o, const RowComparator& rc) {
+  o << "Row Comparator with schema " << rc.schema()->ToString();
+  return o;
+}
+
+} // namespace codegen
+} // namespace kudu
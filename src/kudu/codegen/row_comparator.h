@@ -0,0 +1,113 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_CODEGEN_ROW_COMPARATOR_H
+#define KUDU_CODEGEN_ROW_COMPARATOR_H
+
+#include <iosfwd>
+#include <memory>
+
+#include "kudu/codegen/jit_wrapper.h"
+#include "kudu/common/row_comparator.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/ref_counted.h"
+#include "kudu/util/status.h"
+
+namespace llvm {
+class TargetMachine;
+} // namespace llvm
+
+namespace kudu {
+
+class Arena;
+
+namespace codegen {
+
+class RowComparatorFunctions : public JITWrapper {
+ public:
+  // Compiles the key comparison and row copy functions for the given
+  // schema. Returns Status::NotSupported if the schema has a key column of a
+  // type which the generated comparison does not handle.
+  // Writes the llvm::TargetMachine* used to 'tm' (if not NULL)
+  // and the functions to 'out' upon success.
+  static Status Create(const Schema& schema,
+                       scoped_refptr<RowComparatorFunctions>* out,
+                       llvm::TargetMachine** tm = NULL);
+
+  // Returns true if key columns of the given physical type can be compared
+  // by generated code.
+  static bool SupportsKeyType(DataType physical_type);
+
+  const Schema& schema() { return schema_; }
+
+  typedef int(*CompareFunction)(const RowBlockRow*, const RowBlockRow*);
+  typedef bool(*CopyFunction)(const RowBlockRow*, RowBlockRow*, Arena*);
+  CompareFunction compare() const { return compare_f_; }
+  CopyFunction copy() const { return copy_f_; }
+
+  virtual Status EncodeOwnKey(faststring* out) OVERRIDE {
+    return EncodeKey(schema_, out);
+  }
+
+  static Status EncodeKey(const Schema& schema, faststring* out);
+
+ private:
+  RowComparatorFunctions(const Schema& schema, CompareFunction compare_f,
+                         CopyFunction copy_f, std::unique_ptr<JITCodeOwner> owner);
+
+  const Schema schema_;
+  const CompareFunction compare_f_;
+  const CopyFunction copy_f_;
+};
+
+// A kudu::RowComparator which compares and copies rows with code generated
+// for the types of its schema.
+class RowComparator : public kudu::RowComparator {
+ public:
+  // Requires that 'schema' remain valid for the lifetime of this object.
+  // Also requires that its column types match the schema used to create
+  // 'functions'.
+  RowComparator(const Schema* schema,
+                const scoped_refptr<RowComparatorFunctions>& functions);
+
+  virtual int Compare(const RowBlockRow& lhs, const RowBlockRow& rhs) const OVERRIDE {
+    DCHECK_EQ(schema()->num_key_columns(), lhs.schema()->num_key_columns());
+    return functions_->compare()(&lhs, &rhs);
+  }
+
+  virtual Status Copy(const RowBlockRow& src, RowBlockRow* dst,
+                      Arena* dst_arena) const OVERRIDE {
+    DCHECK_SCHEMA_EQ(*src.schema(), *dst->schema());
+    if (PREDICT_TRUE(functions_->copy()(&src, dst, dst_arena))) {
+      return Status::OK();
+    }
+    return Status::IOError("out of memory copying slice during row copy. "
+                           "Source row: ", src.schema()->DebugRow(src));
+  }
+
+ private:
+  scoped_refptr<RowComparatorFunctions> functions_;
+
+  DISALLOW_COPY_AND_ASSIGN(RowComparator);
+};
+
+extern std::ostream& operator<<(std::ostream& o, const RowComparator& rc);
+
+} // namespace codegen
+} // namespace kudu
+
+#endif
@@ -0,0 +1,252 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/common/aggregate.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/util/memory/arena.h"
+#include "kudu/util/random.h"
+#include "kudu/util/test_macros.h"
+#include "kudu/util/test_util.h"
+
+using std::string;
+using std::vector;
+
+namespace kudu {
+
+class TestAggregate : public KuduTest {
+ public:
+  TestAggregate()
+    : schema_({ ColumnSchema("key", INT32),
+                ColumnSchema("i64", INT64, true),
+                ColumnSchema("str", STRING, true),
+                ColumnSchema("dbl", DOUBLE) }, 1),
+      arena_(1024, 1024 * 1024),
+      random_(SeedRandom()) {
+  }
+
+ protected:
+  static AggregatePB MakeAggregate(AggregatePB::Function function, int col_idx) {
+    AggregatePB pb;
+    pb.set_function(function);
+    if (col_idx != -1) {
+      pb.set_column_idx(col_idx);
+    }
+    return pb;
+  }
+
+  // Fills 'block' with random rows, some of them NULL or unselected.
+  void FillBlock(RowBlock* block) {
+    const Slice kStrings[] = { "", "a", "ab", "b", "bb", "c" };
+    for (size_t i = 0; i < block->nrows(); i++) {
+      RowBlockRow row = block->row(i);
+      int32_t key = random_.Next32();
+      int64_t i64 = static_cast<int64_t>(random_.Next64());
+      Slice str = kStrings[random_.Uniform(arraysize(kStrings))];
+      double dbl = random_.NextDoubleFraction();
+      memcpy(row.mutable_cell_ptr(0), &key, sizeof(key));
+      row.cell(1).set_null(random_.OneIn(4));
+      memcpy(row.mutable_cell_ptr(1), &i64, sizeof(i64));
+      row.cell(2).set_null(random_.OneIn(5));
+      memcpy(row.mutable_cell_ptr(2), &str, sizeof(str));
+      memcpy(row.mutable_cell_ptr(3), &dbl, sizeof(dbl));
+    }
+    block->selection_vector()->SetAllTrue();
+    for (size_t i = 0; i < block->nrows(); i += 3) {
+      block->selection_vector()->SetRowUnselected(i);
+    }
+  }
+
+  const Schema schema_;
+  Arena arena_;
+  Random random_;
+};
+
+// Test each function against a simple evaluation over the same rows.
+TEST_F(TestAggregate, TestAggregateBlock) {
+  const int kNumRows = 1000;
+  RowBlock block(schema_, kNumRows, &arena_);
+  FillBlock(&block);
+
+  int64_t num_rows = 0;
+  int64_t num_i64 = 0;
+  uint64_t i64_sum = 0;
+  double dbl_sum = 0;
+  int32_t key_max = 0;
+  int64_t i64_min = 0;
+  Slice str_min, str_max;
+  bool has_str = false;
+  for (int i = 0; i < kNumRows; i++) {
+    if (!block.selection_vector()->IsRowSelected(i)) continue;
+    RowBlockRow row = block.row(i);
+    num_rows++;
+    int32_t key = *schema_.ExtractColumnFromRow<INT32>(row, 0);
+    key_max = num_rows == 1 ? key : std::max(key, key_max);
+    if (!row.is_null(1)) {
+      int64_t i64 = *schema_.ExtractColumnFromRow<INT64>(row, 1);
+      i64_min = num_i64 == 0 ? i64 : std::min(i64, i64_min);
+      i64_sum += static_cast<uint64_t>(i64);
+      num_i64++;
+    }
+    if (!row.is_null(2)) {
+      Slice str = *schema_.ExtractColumnFromRow<STRING>(row, 2);
+      if (!has_str || str.compare(str_min) < 0) str_min = str;
+      if (!has_str || str.compare(str_max) > 0) str_max = str;
+      has_str = true;
+    }
+    dbl_sum += *schema_.ExtractColumnFromRow<DOUBLE>(row, 3);
+  }
+
+  gscoped_ptr<Aggregator> agg;
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::COUNT, -1), schema_, &agg));
+  agg->Add(block);
+  ASSERT_EQ("COUNT(*)", agg->name());
+  ASSERT_EQ(num_rows, *reinterpret_cast<const int64_t*>(agg->result()));
+
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::COUNT, 1), schema_, &agg));
+  agg->Add(block);
+  ASSERT_EQ(num_i64, *reinterpret_cast<const int64_t*>(agg->result()));
+
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::SUM, 1), schema_, &agg));
+  agg->Add(block);
+  ASSERT_EQ("SUM(i64)", agg->name());
+  ASSERT_EQ(INT64, agg->result_type()->type());
+  ASSERT_EQ(static_cast<int64_t>(i64_sum), *reinterpret_cast<const int64_t*>(agg->result()));
+
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::SUM, 3), schema_, &agg));
+  agg->Add(block);
+  ASSERT_EQ(DOUBLE, agg->result_type()->type());
+  ASSERT_DOUBLE_EQ(dbl_sum, *reinterpret_cast<const double*>(agg->result()));
+
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::MAX, 0), schema_, &agg));
+  agg->Add(block);
+  ASSERT_EQ(key_max, *reinterpret_cast<const int32_t*>(agg->result()));
+
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::MIN, 1), schema_, &agg));
+  agg->Add(block);
+  ASSERT_EQ(i64_min, *reinterpret_cast<const int64_t*>(agg->result()));
+
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::MIN, 2), schema_, &agg));
+  agg->Add(block);
+  ASSERT_EQ(STRING, agg->result_type()->type());
+  ASSERT_EQ(str_min, *reinterpret_cast<const Slice*>(agg->result()));
+
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::MAX, 2), schema_, &agg));
+  agg->Add(block);
+  ASSERT_EQ(str_max, *reinterpret_cast<const Slice*>(agg->result()));
+}
+
+// Test that combining the partial results over parts of the rows gives the
+// same result as aggregating all the rows at once.
+TEST_F(TestAggregate, TestMergePartialResults) {
+  const int kNumBlocks = 5;
+  const int kRowsPerBlock = 100;
+  vector<AggregatePB> pbs = {
+    MakeAggregate(AggregatePB::COUNT, -1),
+    MakeAggregate(AggregatePB::COUNT, 2),
+    MakeAggregate(AggregatePB::SUM, 1),
+    MakeAggregate(AggregatePB::SUM, 3),
+    MakeAggregate(AggregatePB::MIN, 1),
+    MakeAggregate(AggregatePB::MAX, 3),
+    MakeAggregate(AggregatePB::MIN, 2),
+    MakeAggregate(AggregatePB::MAX, 2),
+  };
+
+  vector<gscoped_ptr<RowBlock>> blocks;
+  for (int i = 0; i < kNumBlocks; i++) {
+    blocks.emplace_back(new RowBlock(schema_, kRowsPerBlock, &arena_));
+    FillBlock(blocks.back().get());
+  }
+
+  for (const AggregatePB& pb : pbs) {
+    SCOPED_TRACE(pb.ShortDebugString());
+    gscoped_ptr<Aggregator> whole, partial, combined;
+    ASSERT_OK(Aggregator::Create(pb, schema_, &whole));
+    ASSERT_OK(Aggregator::Create(pb, schema_, &partial));
+    ASSERT_OK(Aggregator::Create(pb, schema_, &combined));
+    for (const gscoped_ptr<RowBlock>& block : blocks) {
+      whole->Add(*block);
+      partial->Reset();
+      partial->Add(*block);
+      AggregateResultPB result_pb;
+      partial->ToPB(&result_pb);
+      ASSERT_OK(combined->Merge(result_pb));
+    }
+    ASSERT_FALSE(combined->result_is_null());
+    if (pb.function() == AggregatePB::SUM && whole->result_type()->type() == DOUBLE) {
+      // The values are added up in a different order.
+      ASSERT_NEAR(*reinterpret_cast<const double*>(whole->result()),
+                  *reinterpret_cast<const double*>(combined->result()), 1e-6);
+    } else {
+      ASSERT_EQ(0, whole->result_type()->Compare(whole->result(), combined->result()))
+          << whole->result_type()->name();
+    }
+  }
+}
+
+// Test the results of aggregates over no values.
+TEST_F(TestAggregate, TestNoValues) {
+  RowBlock block(schema_, 10, &arena_);
+  FillBlock(&block);
+  block.selection_vector()->SetAllFalse();
+
+  gscoped_ptr<Aggregator> agg;
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::COUNT, 2), schema_, &agg));
+  agg->Add(block);
+  ASSERT_FALSE(agg->result_is_null());
+  ASSERT_EQ(0, *reinterpret_cast<const int64_t*>(agg->result()));
+
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::SUM, 1), schema_, &agg));
+  agg->Add(block);
+  ASSERT_TRUE(agg->result_is_null());
+
+  // Partial results over no values don't affect the combined result.
+  AggregateResultPB empty;
+  agg->ToPB(&empty);
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::MIN, 2), schema_, &agg));
+  ASSERT_OK(agg->Merge(empty));
+  ASSERT_TRUE(agg->result_is_null());
+}
+
+TEST_F(TestAggregate, TestInvalidAggregates) {
+  gscoped_ptr<Aggregator> agg;
+  Status s = Aggregator::Create(MakeAggregate(AggregatePB::SUM, 2), schema_, &agg);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  s = Aggregator::Create(MakeAggregate(AggregatePB::MIN, -1), schema_, &agg);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  s = Aggregator::Create(MakeAggregate(AggregatePB::MAX, 4), schema_, &agg);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+  s = Aggregator::Create(MakeAggregate(AggregatePB::UNKNOWN_FUNCTION, 0), schema_, &agg);
+  ASSERT_TRUE(s.IsInvalidArgument()) << s.ToString();
+
+  // A malformed partial result is rejected.
+  ASSERT_OK(Aggregator::Create(MakeAggregate(AggregatePB::MAX, 1), schema_, &agg));
+  AggregateResultPB result_pb;
+  result_pb.set_count(1);
+  result_pb.set_value("abc");
+  s = agg->Merge(result_pb);
+  ASSERT_TRUE(s.IsCorruption()) << s.ToString();
+}
+
+} // namespace kudu
@@ -0,0 +1,330 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/common/aggregate.h"
+
+#include <glog/logging.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+
+using std::string;
+using strings::Substitute;
+
+namespace kudu {
+
+namespace {
+
+// Returns true if SUM applies to columns of the given physical type.
+bool IsSummable(DataType physical_type) {
+  switch (physical_type) {
+    case INT8:
+    case INT16:
+    case INT32:
+    case INT64:
+    case UINT8:
+    case UINT16:
+    case UINT32:
+    case UINT64:
+    case FLOAT:
+    case DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Integer sums wrap around on overflow, so they are computed as unsigned
+// integers, for which overflow is defined.
+int64_t WrappingAdd(int64_t a, int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+}
+
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value>::type
+AddToSum(T value, int64_t* int_sum, double* /* double_sum */) {
+  *int_sum = WrappingAdd(*int_sum, static_cast<int64_t>(value));
+}
+
+template<typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type
+AddToSum(T value, int64_t* /* int_sum */, double* double_sum) {
+  *double_sum += value;
+}
+
+template<typename T>
+typename std::enable_if<!std::is_arithmetic<T>::value>::type
+AddToSum(const T& /* value */, int64_t* /* int_sum */, double* /* double_sum */) {
+  LOG(DFATAL) << "SUM of a non-numeric column";
+}
+
+template<typename T>
+bool Less(const T& a, const T& b) {
+  return a < b;
+}
+
+template<>
+bool Less(const Slice& a, const Slice& b) {
+  return a.compare(b) < 0;
+}
+
+} // anonymous namespace
+
+Aggregator::Aggregator(AggregatePB::Function function, int col_idx, const TypeInfo* col_type,
+                       const TypeInfo* result_type, string name)
+  : function_(function),
+    col_idx_(col_idx),
+    col_type_(col_type),
+    result_type_(result_type),
+    name_(std::move(name)) {
+  Reset();
+}
+
+Status Aggregator::Create(const AggregatePB& pb, const Schema& projection,
+                          gscoped_ptr<Aggregator>* out) {
+  if (!pb.has_column_idx()) {
+    if (pb.function() != AggregatePB::COUNT) {
+      return Status::InvalidArgument("Only COUNT may aggregate rows rather than a column",
+                                     pb.ShortDebugString());
+    }
+    out->reset(new Aggregator(AggregatePB::COUNT, -1, nullptr, GetTypeInfo(INT64),
+                              "COUNT(*)"));
+    return Status::OK();
+  }
+
+  if (pb.column_idx() >= projection.num_columns()) {
+    return Status::InvalidArgument(
+        Substitute("Aggregated column index $0 is out of range for projection $1",
+                   pb.column_idx(), projection.ToString()));
+  }
+  const ColumnSchema& col = projection.column(pb.column_idx());
+  const TypeInfo* result_type;
+  switch (pb.function()) {
+    case AggregatePB::COUNT:
+      result_type = GetTypeInfo(INT64);
+      break;
+    case AggregatePB::SUM: {
+      DataType physical_type = col.type_info()->physical_type();
+      if (!IsSummable(physical_type)) {
+        return Status::InvalidArgument(
+            Substitute("Cannot compute the SUM of column $0", col.ToString()));
+      }
+      result_type = GetTypeInfo(physical_type == FLOAT || physical_type == DOUBLE ?
+                                DOUBLE : INT64);
+      break;
+    }
+    case AggregatePB::MIN:
+    case AggregatePB::MAX:
+      result_type = col.type_info();
+      break;
+    default:
+      return Status::InvalidArgument("Unknown aggregate function", pb.ShortDebugString());
+  }
+  out->reset(new Aggregator(pb.function(), pb.column_idx(), col.type_info(), result_type,
+                            Substitute("$0($1)", AggregatePB::Function_Name(pb.function()),
+                                       col.name())));
+  return Status::OK();
+}
+
+void Aggregator::Add(const RowBlock& block) {
+  const SelectionVector& sel = *block.selection_vector();
+  if (col_idx_ == -1) {
+    count_ += sel.CountSelected();
+    return;
+  }
+
+  ColumnBlock col_block = block.column_block(col_idx_);
+  switch (col_type_->physical_type()) {
+    case BOOL: AddColumnBlock<BOOL>(col_block, sel); break;
+    case INT8: AddColumnBlock<INT8>(col_block, sel); break;
+    case INT16: AddColumnBlock<INT16>(col_block, sel); break;
+    case INT32: AddColumnBlock<INT32>(col_block, sel); break;
+    case INT64: AddColumnBlock<INT64>(col_block, sel); break;
+    case UINT8: AddColumnBlock<UINT8>(col_block, sel); break;
+    case UINT16: AddColumnBlock<UINT16>(col_block, sel); break;
+    case UINT32: AddColumnBlock<UINT32>(col_block, sel); break;
+    case UINT64: AddColumnBlock<UINT64>(col_block, sel); break;
+    case FLOAT: AddColumnBlock<FLOAT>(col_block, sel); break;
+    case DOUBLE: AddColumnBlock<DOUBLE>(col_block, sel); break;
+    case BINARY: AddColumnBlock<BINARY>(col_block, sel); break;
+    default: LOG(FATAL) << "unknown physical type: " << col_type_->physical_type();
+  }
+}
+
+template<DataType PhysicalType>
+void Aggregator::AddColumnBlock(const ColumnBlock& block, const SelectionVector& sel) {
+  typedef typename DataTypeTraits<PhysicalType>::cpp_type cpp_type;
+  const cpp_type* values = reinterpret_cast<const cpp_type*>(block.data());
+
+  // The MIN or MAX of this block is found first, so that binary values are
+  // copied at most once per block.
+  const cpp_type* best = nullptr;
+  for (size_t i = 0; i < block.nrows(); i++) {
+    if (!sel.IsRowSelected(i) || (block.is_nullable() && block.is_null(i))) {
+      continue;
+    }
+    switch (function_) {
+      case AggregatePB::SUM:
+        AddToSum(values[i], &int_sum_, &double_sum_);
+        break;
+      case AggregatePB::MIN:
+        if (best == nullptr || Less(values[i], *best)) best = &values[i];
+        break;
+      case AggregatePB::MAX:
+        if (best == nullptr || Less(*best, values[i])) best = &values[i];
+        break;
+      default:
+        break;
+    }
+    count_++;
+  }
+  if (best != nullptr) {
+    UpdateMinMax(best);
+  }
+}
+
+void Aggregator::UpdateMinMax(const void* value) {
+  if (has_value_) {
+    const void* current = col_type_->physical_type() == BINARY ?
+        static_cast<const void*>(&value_slice_) : &value_;
+    int cmp = col_type_->Compare(value, current);
+    if ((function_ == AggregatePB::MIN && cmp >= 0) ||
+        (function_ == AggregatePB::MAX && cmp <= 0)) {
+      return;
+    }
+  }
+  if (col_type_->physical_type() == BINARY) {
+    const Slice* slice = reinterpret_cast<const Slice*>(value);
+    value_data_.assign(reinterpret_cast<const char*>(slice->data()), slice->size());
+    value_slice_ = Slice(value_data_);
+  } else {
+    memcpy(&value_, value, col_type_->size());
+  }
+  has_value_ = true;
+}
+
+Status Aggregator::Merge(const AggregateResultPB& partial) {
+  if (partial.count() < 0) {
+    return Status::Corruption("Negative count in partial aggregate result",
+                              partial.ShortDebugString());
+  }
+  if (partial.count() == 0) {
+    return Status::OK();
+  }
+
+  switch (function_) {
+    case AggregatePB::SUM:
+      if (result_type_->physical_type() == INT64) {
+        if (!partial.has_int_sum()) {
+          return Status::Corruption("Missing integer sum in partial aggregate result",
+                                    partial.ShortDebugString());
+        }
+        int_sum_ = WrappingAdd(int_sum_, partial.int_sum());
+      } else {
+        if (!partial.has_double_sum()) {
+          return Status::Corruption("Missing double sum in partial aggregate result",
+                                    partial.ShortDebugString());
+        }
+        double_sum_ += partial.double_sum();
+      }
+      break;
+    case AggregatePB::MIN:
+    case AggregatePB::MAX: {
+      if (!partial.has_value()) {
+        return Status::Corruption("Missing value in partial aggregate result",
+                                  partial.ShortDebugString());
+      }
+      if (col_type_->physical_type() == BINARY) {
+        Slice value(partial.value());
+        UpdateMinMax(&value);
+      } else {
+        if (partial.value().size() != col_type_->size()) {
+          return Status::Corruption(
+              Substitute("Expected a value of $0 bytes in partial aggregate result, got $1",
+                         col_type_->size(), partial.value().size()));
+        }
+        uint64_t value;
+        memcpy(&value, partial.value().data(), col_type_->size());
+        UpdateMinMax(&value);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  count_ += partial.count();
+  return Status::OK();
+}
+
+void Aggregator::ToPB(AggregateResultPB* pb) const {
+  pb->Clear();
+  pb->set_count(count_);
+  if (count_ == 0) {
+    return;
+  }
+  switch (function_) {
+    case AggregatePB::SUM:
+      if (result_type_->physical_type() == INT64) {
+        pb->set_int_sum(int_sum_);
+      } else {
+        pb->set_double_sum(double_sum_);
+      }
+      break;
+    case AggregatePB::MIN:
+    case AggregatePB::MAX:
+      if (col_type_->physical_type() == BINARY) {
+        pb->set_value(value_data_);
+      } else {
+        pb->set_value(&value_, col_type_->size());
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void Aggregator::Reset() {
+  count_ = 0;
+  int_sum_ = 0;
+  double_sum_ = 0;
+  value_ = 0;
+  has_value_ = false;
+  value_data_.clear();
+  value_slice_ = Slice();
+}
+
+const void* Aggregator::result() const {
+  DCHECK(!result_is_null());
+  switch (function_) {
+    case AggregatePB::COUNT:
+      return &count_;
+    case AggregatePB::SUM:
+      return result_type_->physical_type() == INT64 ?
+          static_cast<const void*>(&int_sum_) : &double_sum_;
+    default:
+      return col_type_->physical_type() == BINARY ?
+          static_cast<const void*>(&value_slice_) : &value_;
+  }
+}
+
+} // namespace kudu
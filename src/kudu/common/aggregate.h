@@ -0,0 +1,129 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_COMMON_AGGREGATE_H
+#define KUDU_COMMON_AGGREGATE_H
+
+#include <string>
+
+#include "kudu/common/common.pb.h"
+#include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/slice.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class ColumnBlock;
+class RowBlock;
+class Schema;
+class SelectionVector;
+class TypeInfo;
+
+// Computes an aggregate function (see AggregatePB) over the selected rows of
+// RowBlocks, or combines partial results of the function computed elsewhere.
+//
+// Tablet servers use an Aggregator per aggregate of a scan to compute the
+// partial results over the rows of each scan response. Clients use one per
+// aggregate to combine the partial results of all the responses.
+//
+// This class is not thread-safe.
+class Aggregator {
+ public:
+  // Creates an aggregator for 'pb' over rows of 'projection'.
+  //
+  // Returns InvalidArgument if the function is unknown, if the column is not
+  // in the projection, or if the function does not apply to the type of the
+  // column (for example, the SUM of a string column).
+  static Status Create(const AggregatePB& pb, const Schema& projection,
+                       gscoped_ptr<Aggregator>* out);
+
+  // Aggregates the selected rows of 'block', which must have the projection
+  // schema.
+  void Add(const RowBlock& block);
+
+  // Combines a partial result, written by ToPB() of an aggregator for the
+  // same function over the same type of column, into this one.
+  //
+  // Returns Corruption if the partial result is malformed.
+  Status Merge(const AggregateResultPB& partial);
+
+  // Writes the result so far to 'pb', as a partial result.
+  void ToPB(AggregateResultPB* pb) const;
+
+  // Forgets all the aggregated rows.
+  void Reset();
+
+  // Returns the type of the result: INT64 for a COUNT or for the SUM of an
+  // integer column, DOUBLE for the SUM of a floating-point column, and the
+  // type of the column for a MIN or MAX.
+  const TypeInfo* result_type() const { return result_type_; }
+
+  // Returns true if the result is NULL, i.e. if the function is not a COUNT
+  // and no non-null values have been aggregated.
+  bool result_is_null() const {
+    return function_ != AggregatePB::COUNT && count_ == 0;
+  }
+
+  // Returns a pointer to the result, a value of result_type() (or a Slice,
+  // for binary types). Requires that the result is not NULL.
+  //
+  // The pointer is valid until the aggregator is next modified.
+  const void* result() const;
+
+  // Returns the name of the aggregate, e.g. "SUM(col)" or "COUNT(*)".
+  const std::string& name() const { return name_; }
+
+ private:
+  Aggregator(AggregatePB::Function function, int col_idx, const TypeInfo* col_type,
+             const TypeInfo* result_type, std::string name);
+
+  template<DataType PhysicalType>
+  void AddColumnBlock(const ColumnBlock& block, const SelectionVector& sel);
+
+  // Replaces the MIN or MAX so far with 'value', if there is none yet or if
+  // 'value' is smaller (for MIN) or larger (for MAX).
+  void UpdateMinMax(const void* value);
+
+  const AggregatePB::Function function_;
+
+  // The index of the aggregated column in the projection, or -1 for a
+  // COUNT of the rows.
+  const int col_idx_;
+  const TypeInfo* const col_type_;
+  const TypeInfo* const result_type_;
+  const std::string name_;
+
+  // The number of rows (for a COUNT of the rows) or the number of non-null
+  // values aggregated.
+  int64_t count_;
+
+  int64_t int_sum_;
+  double double_sum_;
+
+  // The MIN or MAX so far, if 'has_value_' is set. Values of fixed-size
+  // types are stored in 'value_', and binary values in 'value_data_', with
+  // 'value_slice_' pointing to them.
+  bool has_value_;
+  uint64_t value_;
+  std::string value_data_;
+  Slice value_slice_;
+
+  DISALLOW_COPY_AND_ASSIGN(Aggregator);
+};
+
+} // namespace kudu
+#endif
@@ -0,0 +1,119 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Benchmarks of column predicate evaluation, comparing the typed and
+// vectorized evaluation against the generic evaluation which compares each
+// cell through the column's TypeInfo.
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/random.h"
+#include "kudu/util/stopwatch.h"
+#include "kudu/util/test_util.h"
+
+DECLARE_bool(column_predicate_typed_evaluation);
+
+DEFINE_int32(column_predicate_bench_iterations, 0,
+             "Number of times to evaluate each predicate over the block. "
+             "If 0, picks a number based on whether slow tests are allowed.");
+
+using strings::Substitute;
+
+namespace kudu {
+
+class ColumnPredicateBench : public KuduTest {
+ public:
+  ColumnPredicateBench()
+      : rng_(SeedRandom()) {
+  }
+
+ protected:
+  // Evaluate a range predicate selecting about half of the rows, and an
+  // equality predicate, over a block of random values of the given type.
+  template <DataType Type>
+  void BenchmarkType(bool nullable) {
+    typedef typename TypeTraits<Type>::cpp_type CppType;
+    const size_t kNumRows = 1024;
+    const int kIterations = FLAGS_column_predicate_bench_iterations > 0 ?
+        FLAGS_column_predicate_bench_iterations : (AllowSlowTests() ? 100000 : 1000);
+
+    ScopedColumnBlock<Type> scoped_block(kNumRows);
+    for (size_t i = 0; i < kNumRows; i++) {
+      scoped_block[i] = static_cast<CppType>(rng_.Uniform(1000));
+      scoped_block.SetCellIsNull(i, rng_.OneIn(10));
+    }
+    ColumnBlock block(scoped_block.type_info(),
+                      nullable ? scoped_block.null_bitmap() : nullptr,
+                      scoped_block.data(), kNumRows, nullptr);
+
+    CppType lower = 250;
+    CppType upper = 750;
+    ColumnSchema column("c", Type, nullable);
+    ColumnPredicate range = ColumnPredicate::Range(column, &lower, &upper);
+    ColumnPredicate equality = ColumnPredicate::Equality(column, &lower);
+
+    for (const ColumnPredicate* pred : { &range, &equality }) {
+      for (bool typed : { false, true }) {
+        FLAGS_column_predicate_typed_evaluation = typed;
+        SelectionVector sel(kNumRows);
+        size_t selected = 0;
+        LOG_TIMING(INFO, Substitute("$0 $1 evaluation of $2 ($3 rows x $4)",
+                                    nullable ? "nullable" : "non-nullable",
+                                    typed ? "typed" : "generic",
+                                    pred->ToString(), kNumRows, kIterations)) {
+          for (int i = 0; i < kIterations; i++) {
+            sel.SetAllTrue();
+            pred->Evaluate(block, &sel);
+            selected += sel.CountSelected();
+          }
+        }
+        // Print the count so the evaluation isn't optimized away.
+        LOG(INFO) << "Selected " << selected << " rows";
+      }
+    }
+  }
+
+  template <DataType Type>
+  void BenchmarkType() {
+    NO_FATALS(BenchmarkType<Type>(false));
+    NO_FATALS(BenchmarkType<Type>(true));
+  }
+
+  google::FlagSaver saver_;
+  Random rng_;
+};
+
+TEST_F(ColumnPredicateBench, Int8) { BenchmarkType<INT8>(); }
+TEST_F(ColumnPredicateBench, Int16) { BenchmarkType<INT16>(); }
+TEST_F(ColumnPredicateBench, Int32) { BenchmarkType<INT32>(); }
+TEST_F(ColumnPredicateBench, Int64) { BenchmarkType<INT64>(); }
+TEST_F(ColumnPredicateBench, UInt32) { BenchmarkType<UINT32>(); }
+TEST_F(ColumnPredicateBench, UInt64) { BenchmarkType<UINT64>(); }
+TEST_F(ColumnPredicateBench, Float) { BenchmarkType<FLOAT>(); }
+TEST_F(ColumnPredicateBench, Double) { BenchmarkType<DOUBLE>(); }
+TEST_F(ColumnPredicateBench, Timestamp) { BenchmarkType<TIMESTAMP>(); }
+
+} // namespace kudu
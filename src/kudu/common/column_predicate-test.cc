@@ -17,14 +17,22 @@
 
 #include "kudu/common/column_predicate.h"
 
+#include <algorithm>
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <limits>
 #include <vector>
 
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
+#include "kudu/util/random.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(column_predicate_typed_evaluation);
+
 namespace kudu {
 
 class TestColumnPredicate : public KuduTest {
@@ -54,6 +62,83 @@ class TestColumnPredicate : public KuduTest {
     ASSERT_EQ(b_base.predicate_type(), type);
   }
 
+  // Test that evaluating the predicate with the typed (and possibly vectorized)
+  // evaluation gives the same result as the generic evaluation.
+  void TestEvaluate(const ColumnPredicate& predicate,
+                    const ColumnBlock& block,
+                    const SelectionVector& initial) {
+    google::FlagSaver saver;
+    SelectionVector expected(block.nrows());
+    SelectionVector actual(block.nrows());
+    memcpy(expected.mutable_bitmap(), initial.bitmap(), BitmapSize(block.nrows()));
+    memcpy(actual.mutable_bitmap(), initial.bitmap(), BitmapSize(block.nrows()));
+
+    FLAGS_column_predicate_typed_evaluation = false;
+    predicate.Evaluate(block, &expected);
+    FLAGS_column_predicate_typed_evaluation = true;
+    predicate.Evaluate(block, &actual);
+
+    for (size_t i = 0; i < block.nrows(); i++) {
+      ASSERT_EQ(expected.IsRowSelected(i), actual.IsRowSelected(i))
+          << "row " << i << " of " << block.nrows() << ": " << predicate.ToString();
+    }
+  }
+
+  // Evaluate predicates over every combination of the given values against
+  // column blocks filled with those values, with and without NULLs, and check
+  // the typed and generic evaluation agree.
+  template <DataType Type>
+  void TestEvaluateCombinations(const vector<typename TypeTraits<Type>::cpp_type>& values) {
+    typedef typename TypeTraits<Type>::cpp_type CppType;
+    Random rng(SeedRandom());
+
+    // Use a row count which isn't a multiple of 8 so that some rows fall
+    // outside of the vectorized kernels.
+    const size_t kNumRows = 203;
+    ScopedColumnBlock<Type> nullable_block(kNumRows);
+    for (size_t i = 0; i < kNumRows; i++) {
+      nullable_block[i] = values[rng.Uniform(values.size())];
+      nullable_block.SetCellIsNull(i, rng.OneIn(5));
+    }
+    ColumnBlock non_null_block(nullable_block.type_info(), nullptr,
+                               nullable_block.data(), kNumRows, nullptr);
+
+    // Start with a random selection, including some entirely unselected bytes.
+    SelectionVector initial(kNumRows);
+    for (size_t i = 0; i < kNumRows; i++) {
+      if ((i / 8) % 3 == 0 || rng.OneIn(4)) {
+        initial.SetRowUnselected(i);
+      } else {
+        initial.SetRowSelected(i);
+      }
+    }
+
+    // The predicates point into the values, so copy them somewhere addressable
+    // (vector<bool> is not).
+    gscoped_array<CppType> bounds(new CppType[values.size()]);
+    std::copy(values.begin(), values.end(), bounds.get());
+
+    ColumnSchema column("c", Type, true);
+    vector<ColumnPredicate> predicates;
+    for (size_t i = 0; i < values.size(); i++) {
+      predicates.push_back(ColumnPredicate::Equality(column, &bounds[i]));
+      predicates.push_back(ColumnPredicate::Range(column, &bounds[i], nullptr));
+      predicates.push_back(ColumnPredicate::Range(column, nullptr, &bounds[i]));
+      for (size_t j = 0; j < values.size(); j++) {
+        predicates.push_back(ColumnPredicate::Range(column, &bounds[i], &bounds[j]));
+      }
+      vector<const void*> in_list = { &bounds[i],
+                                      &bounds[(i + 2) % values.size()],
+                                      &bounds[(i + 3) % values.size()] };
+      predicates.push_back(ColumnPredicate::InList(column, &in_list));
+    }
+
+    for (const ColumnPredicate& predicate : predicates) {
+      NO_FATALS(TestEvaluate(predicate, nullable_block, initial));
+      NO_FATALS(TestEvaluate(predicate, non_null_block, initial));
+    }
+  }
+
   template <typename T>
   void TestMergeCombinations(const ColumnSchema& column, vector<T> values) {
     // Range + Range
@@ -275,4 +360,196 @@ TEST_F(TestColumnPredicate, TestInclusiveRange) {
   }
 }
 
+// Test that IN list predicates are normalized on construction, and merge
+// correctly with other predicate types.
+TEST_F(TestColumnPredicate, TestInList) {
+  ColumnSchema column("c", INT32);
+  vector<int32_t> values = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  auto in_list = [&] (std::initializer_list<int> indexes) {
+    vector<const void*> vals;
+    for (int i : indexes) {
+      vals.push_back(&values[i]);
+    }
+    return ColumnPredicate::InList(column, &vals);
+  };
+
+  // Construction.
+  ASSERT_EQ(PredicateType::None, in_list({}).predicate_type());
+  ASSERT_EQ(ColumnPredicate::Equality(column, &values[3]), in_list({ 3, 3 }));
+  ASSERT_EQ(in_list({ 1, 3, 5 }), in_list({ 5, 1, 3, 1 }));
+  ASSERT_EQ("`c` IN (1, 3, 5)", in_list({ 5, 3, 1 }).ToString());
+
+  // InList + Range.
+  TestMerge(in_list({ 1, 3, 5 }),
+            ColumnPredicate::Range(column, &values[2], &values[6]),
+            in_list({ 3, 5 }),
+            PredicateType::InList);
+  TestMerge(in_list({ 1, 3, 5 }),
+            ColumnPredicate::Range(column, &values[3], nullptr),
+            in_list({ 3, 5 }),
+            PredicateType::InList);
+  TestMerge(in_list({ 1, 3, 5 }),
+            ColumnPredicate::Range(column, &values[2], &values[4]),
+            ColumnPredicate::Equality(column, &values[3]),
+            PredicateType::Equality);
+  TestMerge(in_list({ 1, 3, 5 }),
+            ColumnPredicate::Range(column, &values[6], &values[8]),
+            in_list({}),
+            PredicateType::None);
+
+  // InList + Equality.
+  TestMerge(in_list({ 1, 3, 5 }),
+            ColumnPredicate::Equality(column, &values[3]),
+            ColumnPredicate::Equality(column, &values[3]),
+            PredicateType::Equality);
+  TestMerge(in_list({ 1, 3, 5 }),
+            ColumnPredicate::Equality(column, &values[4]),
+            in_list({}),
+            PredicateType::None);
+
+  // InList + InList.
+  TestMerge(in_list({ 1, 3, 5, 7 }),
+            in_list({ 0, 3, 5, 9 }),
+            in_list({ 3, 5 }),
+            PredicateType::InList);
+  TestMerge(in_list({ 1, 3 }),
+            in_list({ 3, 7 }),
+            ColumnPredicate::Equality(column, &values[3]),
+            PredicateType::Equality);
+  TestMerge(in_list({ 1, 3 }),
+            in_list({ 5, 7 }),
+            in_list({}),
+            PredicateType::None);
+
+  // Evaluation.
+  ScopedColumnBlock<INT32> block(10);
+  for (int i = 0; i < 10; i++) {
+    block[i] = i;
+    block.SetCellIsNull(i, i == 5);
+  }
+  SelectionVector sel(10);
+  sel.SetAllTrue();
+  in_list({ 1, 3, 5, 7 }).Evaluate(block, &sel);
+  ASSERT_EQ(3, sel.CountSelected());
+  ASSERT_TRUE(sel.IsRowSelected(1));
+  ASSERT_TRUE(sel.IsRowSelected(3));
+  ASSERT_TRUE(sel.IsRowSelected(7));
+}
+
+TEST_F(TestColumnPredicate, TestNullPredicates) {
+  ColumnSchema nullable_column("c", INT32, true);
+  ColumnSchema column("c", INT32);
+  vector<int32_t> values = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  vector<const void*> no_values;
+  ColumnPredicate none = ColumnPredicate::InList(nullable_column, &no_values);
+
+  // Construction.
+  ASSERT_EQ(PredicateType::IsNull, ColumnPredicate::IsNull(nullable_column).predicate_type());
+  ASSERT_EQ(PredicateType::None, ColumnPredicate::IsNull(column).predicate_type());
+  ASSERT_EQ(PredicateType::IsNotNull, ColumnPredicate::IsNotNull(column).predicate_type());
+  ASSERT_EQ("`c` IS NULL", ColumnPredicate::IsNull(nullable_column).ToString());
+  ASSERT_EQ("`c` IS NOT NULL", ColumnPredicate::IsNotNull(nullable_column).ToString());
+
+  // IsNotNull + other predicates.
+  TestMerge(ColumnPredicate::IsNotNull(nullable_column),
+            ColumnPredicate::IsNotNull(nullable_column),
+            ColumnPredicate::IsNotNull(nullable_column),
+            PredicateType::IsNotNull);
+  TestMerge(ColumnPredicate::IsNotNull(nullable_column),
+            ColumnPredicate::Range(nullable_column, &values[1], &values[5]),
+            ColumnPredicate::Range(nullable_column, &values[1], &values[5]),
+            PredicateType::Range);
+  TestMerge(ColumnPredicate::IsNotNull(nullable_column),
+            ColumnPredicate::Equality(nullable_column, &values[3]),
+            ColumnPredicate::Equality(nullable_column, &values[3]),
+            PredicateType::Equality);
+  vector<const void*> in_list = { &values[1], &values[3] };
+  ColumnPredicate in_list_pred = ColumnPredicate::InList(nullable_column, &in_list);
+  TestMerge(ColumnPredicate::IsNotNull(nullable_column),
+            in_list_pred,
+            in_list_pred,
+            PredicateType::InList);
+  TestMerge(ColumnPredicate::IsNotNull(nullable_column),
+            none,
+            none,
+            PredicateType::None);
+
+  // IsNull + other predicates.
+  TestMerge(ColumnPredicate::IsNull(nullable_column),
+            ColumnPredicate::IsNull(nullable_column),
+            ColumnPredicate::IsNull(nullable_column),
+            PredicateType::IsNull);
+  TestMerge(ColumnPredicate::IsNull(nullable_column),
+            ColumnPredicate::IsNotNull(nullable_column),
+            none,
+            PredicateType::None);
+  TestMerge(ColumnPredicate::IsNull(nullable_column),
+            ColumnPredicate::Range(nullable_column, &values[1], &values[5]),
+            none,
+            PredicateType::None);
+  TestMerge(ColumnPredicate::IsNull(nullable_column),
+            ColumnPredicate::Equality(nullable_column, &values[3]),
+            none,
+            PredicateType::None);
+  TestMerge(ColumnPredicate::IsNull(nullable_column),
+            in_list_pred,
+            none,
+            PredicateType::None);
+
+  // Evaluation. Use a row count which isn't a multiple of 64 so that the
+  // trailing bytes of the bitmap are exercised.
+  const size_t kNumRows = 203;
+  Random rng(SeedRandom());
+  ScopedColumnBlock<INT32> block(kNumRows);
+  SelectionVector initial(kNumRows);
+  for (size_t i = 0; i < kNumRows; i++) {
+    block[i] = i;
+    block.SetCellIsNull(i, rng.OneIn(3));
+    if (rng.OneIn(4)) {
+      initial.SetRowUnselected(i);
+    } else {
+      initial.SetRowSelected(i);
+    }
+  }
+  ColumnBlock non_null_block(block.type_info(), nullptr, block.data(), kNumRows, nullptr);
+
+  for (bool is_null : { true, false }) {
+    ColumnPredicate pred = is_null ? ColumnPredicate::IsNull(nullable_column)
+                                   : ColumnPredicate::IsNotNull(nullable_column);
+    ASSERT_TRUE(pred.EvaluatesOnNullBitmap());
+
+    SelectionVector sel(kNumRows);
+    memcpy(sel.mutable_bitmap(), initial.bitmap(), BitmapSize(kNumRows));
+    pred.Evaluate(block, &sel);
+    for (size_t i = 0; i < kNumRows; i++) {
+      ASSERT_EQ(initial.IsRowSelected(i) && block.is_null(i) == is_null, sel.IsRowSelected(i))
+          << "row " << i << ": " << pred.ToString();
+    }
+
+    // None of the rows of a block without a null bitmap are null.
+    memcpy(sel.mutable_bitmap(), initial.bitmap(), BitmapSize(kNumRows));
+    pred.Evaluate(non_null_block, &sel);
+    ASSERT_EQ(is_null ? 0 : initial.CountSelected(), sel.CountSelected());
+  }
+}
+
+// Test that the type-specialized predicate evaluation matches the generic
+// evaluation for every type.
+TEST_F(TestColumnPredicate, TestEvaluate) {
+  NO_FATALS(TestEvaluateCombinations<INT8>({ INT8_MIN, -1, 0, 1, 7, INT8_MAX }));
+  NO_FATALS(TestEvaluateCombinations<INT16>({ INT16_MIN, -1, 0, 1, 7, INT16_MAX }));
+  NO_FATALS(TestEvaluateCombinations<INT32>({ INT32_MIN, -1, 0, 1, 7, INT32_MAX }));
+  NO_FATALS(TestEvaluateCombinations<INT64>({ INT64_MIN, -1, 0, 1, 7, INT64_MAX }));
+  NO_FATALS(TestEvaluateCombinations<UINT32>({ 0, 1, 7, INT32_MAX, 1U << 31, UINT32_MAX }));
+  NO_FATALS(TestEvaluateCombinations<UINT64>({ 0, 1, 7, INT64_MAX, 1ULL << 63, UINT64_MAX }));
+  NO_FATALS(TestEvaluateCombinations<TIMESTAMP>({ INT64_MIN, -1000, 0, 1, 1000, INT64_MAX }));
+  NO_FATALS(TestEvaluateCombinations<BOOL>({ false, true }));
+  NO_FATALS(TestEvaluateCombinations<FLOAT>({ -std::numeric_limits<float>::infinity(),
+                                              -1.5, 0, 1.5, 2.5,
+                                              std::numeric_limits<float>::quiet_NaN() }));
+  NO_FATALS(TestEvaluateCombinations<DOUBLE>({ -std::numeric_limits<double>::infinity(),
+                                               -1.5, 0, 1.5, 2.5,
+                                               std::numeric_limits<double>::quiet_NaN() }));
+}
+
 } // namespace kudu
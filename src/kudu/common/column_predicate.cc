@@ -17,18 +17,34 @@
 
 #include "kudu/common/column_predicate.h"
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
+#include <gflags/gflags.h>
+
+#include "kudu/common/column_predicate_kernels.h"
 #include "kudu/common/row_key-util.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/types.h"
+#include "kudu/util/flag_tags.h"
 #include "kudu/util/memory/arena.h"
 
+DEFINE_bool(column_predicate_typed_evaluation, true,
+            "Whether to evaluate column predicates using comparisons specialized "
+            "for the column type, vectorized where the type allows. Turning this off "
+            "falls back to comparing each cell through the column's TypeInfo.");
+TAG_FLAG(column_predicate_typed_evaluation, hidden);
+
 using std::move;
+using std::vector;
 
 namespace kudu {
 
+using predicate_kernels::BoundType;
+using predicate_kernels::EvaluateVectorized;
+
 ColumnPredicate::ColumnPredicate(PredicateType predicate_type,
                                  ColumnSchema column,
                                  const void* lower,
@@ -78,6 +94,38 @@ boost::optional<ColumnPredicate> ColumnPredicate::InclusiveRange(ColumnSchema co
   return ColumnPredicate::Range(move(column), lower, upper);
 }
 
+ColumnPredicate ColumnPredicate::InList(ColumnSchema column, vector<const void*>* values) {
+  CHECK(values != nullptr);
+  ColumnPredicate pred(PredicateType::InList, move(column), nullptr, nullptr);
+
+  // Sort and remove duplicates, so that the values can be binary searched and
+  // merged with other lists.
+  const TypeInfo* type_info = pred.column_.type_info();
+  std::sort(values->begin(), values->end(), [type_info] (const void* a, const void* b) {
+      return type_info->Compare(a, b) < 0;
+  });
+  values->erase(std::unique(values->begin(), values->end(),
+                            [type_info] (const void* a, const void* b) {
+                              return type_info->Compare(a, b) == 0;
+                            }),
+                values->end());
+  pred.values_.swap(*values);
+  values->clear();
+
+  pred.Simplify();
+  return pred;
+}
+
+ColumnPredicate ColumnPredicate::IsNotNull(ColumnSchema column) {
+  return ColumnPredicate(PredicateType::IsNotNull, move(column), nullptr, nullptr);
+}
+
+ColumnPredicate ColumnPredicate::IsNull(ColumnSchema column) {
+  ColumnPredicate pred(PredicateType::IsNull, move(column), nullptr, nullptr);
+  pred.Simplify();
+  return pred;
+}
+
 ColumnPredicate ColumnPredicate::None(ColumnSchema column) {
   return ColumnPredicate(PredicateType::None, move(column), nullptr, nullptr);
 }
@@ -86,6 +134,7 @@ void ColumnPredicate::SetToNone() {
   predicate_type_ = PredicateType::None;
   lower_ = nullptr;
   upper_ = nullptr;
+  values_.clear();
 }
 
 void ColumnPredicate::Simplify() {
@@ -105,6 +154,26 @@ void ColumnPredicate::Simplify() {
       }
       return;
     };
+    case PredicateType::InList: {
+      if (values_.empty()) {
+        // An empty IN list matches no values.
+        SetToNone();
+      } else if (values_.size() == 1) {
+        // A single value IN list is an equality predicate.
+        predicate_type_ = PredicateType::Equality;
+        lower_ = values_[0];
+        values_.clear();
+      }
+      return;
+    };
+    case PredicateType::IsNotNull: return;
+    case PredicateType::IsNull: {
+      if (!column_.is_nullable()) {
+        // A non-nullable column has no null values.
+        SetToNone();
+      }
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -121,6 +190,18 @@ void ColumnPredicate::Merge(const ColumnPredicate& other) {
       MergeIntoEquality(other);
       return;
     };
+    case PredicateType::InList: {
+      MergeIntoInList(other);
+      return;
+    };
+    case PredicateType::IsNotNull: {
+      MergeIntoIsNotNull(other);
+      return;
+    };
+    case PredicateType::IsNull: {
+      MergeIntoIsNull(other);
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -163,6 +244,29 @@ void ColumnPredicate::MergeIntoRange(const ColumnPredicate& other) {
       }
       return;
     };
+
+    case PredicateType::InList: {
+      // Retain the values of the list which fall in this range.
+      vector<const void*> values;
+      for (const void* value : other.values_) {
+        if (RangeContains(value)) {
+          values.push_back(value);
+        }
+      }
+      predicate_type_ = PredicateType::InList;
+      lower_ = nullptr;
+      upper_ = nullptr;
+      values_.swap(values);
+      Simplify();
+      return;
+    };
+
+    // A range only matches non-null values.
+    case PredicateType::IsNotNull: return;
+    case PredicateType::IsNull: {
+      SetToNone();
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -189,15 +293,126 @@ void ColumnPredicate::MergeIntoEquality(const ColumnPredicate& other) {
       }
       return;
     };
+    case PredicateType::InList: {
+      if (!other.InListContains(lower_)) {
+        SetToNone();
+      }
+      return;
+    };
+    case PredicateType::IsNotNull: return;
+    case PredicateType::IsNull: {
+      SetToNone();
+      return;
+    };
+  }
+  LOG(FATAL) << "unknown predicate type";
+}
+
+void ColumnPredicate::MergeIntoInList(const ColumnPredicate& other) {
+  CHECK(predicate_type_ == PredicateType::InList);
+
+  switch (other.predicate_type()) {
+    case PredicateType::None: {
+      SetToNone();
+      return;
+    };
+    case PredicateType::Range: {
+      values_.erase(std::remove_if(values_.begin(), values_.end(),
+                                   [&other] (const void* value) {
+                                     return !other.RangeContains(value);
+                                   }),
+                    values_.end());
+      Simplify();
+      return;
+    };
+    case PredicateType::Equality: {
+      if (InListContains(other.lower_)) {
+        predicate_type_ = PredicateType::Equality;
+        lower_ = other.lower_;
+        values_.clear();
+      } else {
+        SetToNone();
+      }
+      return;
+    };
+    case PredicateType::InList: {
+      // Both lists are sorted, so take the intersection in a single pass.
+      const TypeInfo* type_info = column_.type_info();
+      vector<const void*> values;
+      std::set_intersection(values_.begin(), values_.end(),
+                            other.values_.begin(), other.values_.end(),
+                            std::back_inserter(values),
+                            [type_info] (const void* a, const void* b) {
+                              return type_info->Compare(a, b) < 0;
+                            });
+      values_.swap(values);
+      Simplify();
+      return;
+    };
+    case PredicateType::IsNotNull: return;
+    case PredicateType::IsNull: {
+      SetToNone();
+      return;
+    };
+  }
+  LOG(FATAL) << "unknown predicate type";
+}
+
+void ColumnPredicate::MergeIntoIsNotNull(const ColumnPredicate& other) {
+  CHECK(predicate_type_ == PredicateType::IsNotNull);
+
+  switch (other.predicate_type()) {
+    // Range, Equality and InList predicates only match non-null values, so
+    // they subsume this predicate.
+    case PredicateType::None:
+    case PredicateType::Range:
+    case PredicateType::Equality:
+    case PredicateType::InList: {
+      predicate_type_ = other.predicate_type_;
+      lower_ = other.lower_;
+      upper_ = other.upper_;
+      values_ = other.values_;
+      return;
+    };
+    case PredicateType::IsNotNull: return;
+    case PredicateType::IsNull: {
+      SetToNone();
+      return;
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
 
+void ColumnPredicate::MergeIntoIsNull(const ColumnPredicate& other) {
+  CHECK(predicate_type_ == PredicateType::IsNull);
+
+  // Every other type of predicate only matches non-null values.
+  if (other.predicate_type() != PredicateType::IsNull) {
+    SetToNone();
+  }
+}
+
+bool ColumnPredicate::InListContains(const void* value) const {
+  DCHECK(predicate_type_ == PredicateType::InList);
+  const TypeInfo* type_info = column_.type_info();
+  return std::binary_search(values_.begin(), values_.end(), value,
+                            [type_info] (const void* a, const void* b) {
+                              return type_info->Compare(a, b) < 0;
+                            });
+}
+
+bool ColumnPredicate::RangeContains(const void* value) const {
+  DCHECK(predicate_type_ == PredicateType::Range);
+  return (lower_ == nullptr || column_.type_info()->Compare(value, lower_) >= 0) &&
+         (upper_ == nullptr || column_.type_info()->Compare(value, upper_) < 0);
+}
+
 namespace {
+// Applies the predicate 'p' to the rows of 'block' starting at 'start_row'.
 template <typename P>
-void ApplyPredicate(const ColumnBlock& block, SelectionVector* sel, P p) {
+void ApplyPredicate(const ColumnBlock& block, size_t start_row, SelectionVector* sel, P p) {
   if (block.is_nullable()) {
-    for (size_t i = 0; i < block.nrows(); i++) {
+    for (size_t i = start_row; i < block.nrows(); i++) {
       if (!sel->IsRowSelected(i)) continue;
       const void *cell = block.nullable_cell_ptr(i);
       if (cell == nullptr || !p(cell)) {
@@ -205,7 +420,7 @@ void ApplyPredicate(const ColumnBlock& block, SelectionVector* sel, P p) {
       }
     }
   } else {
-    for (size_t i = 0; i < block.nrows(); i++) {
+    for (size_t i = start_row; i < block.nrows(); i++) {
       if (!sel->IsRowSelected(i)) continue;
       const void *cell = block.cell_ptr(i);
       if (!p(cell)) {
@@ -214,40 +429,145 @@ void ApplyPredicate(const ColumnBlock& block, SelectionVector* sel, P p) {
     }
   }
 }
+
+// ANDs the first 'nrows' bits of 'bitmap' (or of its complement, if 'negate'
+// is true) into the selection vector, a word at a time.
+void ApplyNullBitmap(const uint8_t* bitmap, size_t nrows, bool negate, SelectionVector* sel) {
+  uint8_t* sel_bitmap = sel->mutable_bitmap();
+  size_t nbytes = BitmapSize(nrows);
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= nbytes; i += sizeof(uint64_t)) {
+    uint64_t sel_word;
+    uint64_t null_word;
+    memcpy(&sel_word, sel_bitmap + i, sizeof(uint64_t));
+    memcpy(&null_word, bitmap + i, sizeof(uint64_t));
+    sel_word &= negate ? ~null_word : null_word;
+    memcpy(sel_bitmap + i, &sel_word, sizeof(uint64_t));
+  }
+  for (; i < nbytes; i++) {
+    sel_bitmap[i] &= negate ? ~bitmap[i] : bitmap[i];
+  }
+  // Don't leave bits set beyond the end of the block.
+  if (nrows % 8 != 0) {
+    sel_bitmap[nbytes - 1] &= (1 << (nrows % 8)) - 1;
+  }
+}
 } // anonymous namespace
 
+template <DataType PhysicalType>
+void ColumnPredicate::EvaluateForPhysicalType(const ColumnBlock& block,
+                                              SelectionVector* sel) const {
+  typedef DataTypeTraits<PhysicalType> traits;
+
+  // The bulk of the block is evaluated by a vectorized kernel, if there is one
+  // for the type. The remaining rows (or all of them, if there is no kernel)
+  // are evaluated one at a time.
+  switch (predicate_type()) {
+    case PredicateType::Range: {
+      if (lower_ == nullptr) {
+        size_t start_row = EvaluateVectorized(block, BoundType::kUpper, nullptr, upper_, sel);
+        ApplyPredicate(block, start_row, sel, [this] (const void* cell) {
+            return traits::Compare(cell, this->upper_) < 0;
+        });
+      } else if (upper_ == nullptr) {
+        size_t start_row = EvaluateVectorized(block, BoundType::kLower, lower_, nullptr, sel);
+        ApplyPredicate(block, start_row, sel, [this] (const void* cell) {
+            return traits::Compare(cell, this->lower_) >= 0;
+        });
+      } else {
+        size_t start_row = EvaluateVectorized(block, BoundType::kBetween, lower_, upper_, sel);
+        ApplyPredicate(block, start_row, sel, [this] (const void* cell) {
+            return traits::Compare(cell, this->upper_) < 0 &&
+                   traits::Compare(cell, this->lower_) >= 0;
+        });
+      }
+      return;
+    };
+    case PredicateType::Equality: {
+      size_t start_row = EvaluateVectorized(block, BoundType::kBetweenInclusive,
+                                            lower_, lower_, sel);
+      ApplyPredicate(block, start_row, sel, [this] (const void* cell) {
+          return traits::Compare(cell, this->lower_) == 0;
+      });
+      return;
+    };
+    case PredicateType::InList: {
+      ApplyPredicate(block, 0, sel, [this] (const void* cell) {
+          return std::binary_search(values_.begin(), values_.end(), cell,
+                                    [] (const void* a, const void* b) {
+                                      return traits::Compare(a, b) < 0;
+                                    });
+      });
+      return;
+    };
+    case PredicateType::None:
+    case PredicateType::IsNotNull:
+    case PredicateType::IsNull: break;
+  }
+  LOG(FATAL) << "unexpected predicate type";
+}
+
 void ColumnPredicate::Evaluate(const ColumnBlock& block, SelectionVector *sel) const {
   CHECK_NOTNULL(sel);
 
-  // The type-specific predicate is provided as a function template to
-  // ApplyPredicate in the hope that they are inlined.
-  //
-  // TODO: In the future we can improve this by also providing the type info as a
-  // template, so that the type-specific data comparisons can be inlined.
-  //
-  // Going a step further we could do runtime codegen to inline the
-  // lower/upper/equality bounds.
+  // Equality predicates on all of the primary key columns are checked against
+  // the rowset bloom filters before any blocks are read (see
+  // CFileSet::Iterator::Init()), so there is no bloom filter to consult here.
 
-  // TODO: equality predicates should use the bloomfilter if it's available.
+  // Null predicates are decided by the null bitmap alone. The null bitmap has
+  // a set bit for each non-null cell.
+  if (predicate_type() == PredicateType::IsNotNull) {
+    if (block.is_nullable()) {
+      ApplyNullBitmap(block.null_bitmap(), block.nrows(), false, sel);
+    }
+    return;
+  }
+  if (predicate_type() == PredicateType::IsNull) {
+    if (block.is_nullable()) {
+      ApplyNullBitmap(block.null_bitmap(), block.nrows(), true, sel);
+    } else {
+      BitmapChangeBits(sel->mutable_bitmap(), 0, block.nrows(), false);
+    }
+    return;
+  }
+
+  if (predicate_type() != PredicateType::None && FLAGS_column_predicate_typed_evaluation) {
+    switch (column_.type_info()->physical_type()) {
+      case UINT8: EvaluateForPhysicalType<UINT8>(block, sel); return;
+      case INT8: EvaluateForPhysicalType<INT8>(block, sel); return;
+      case UINT16: EvaluateForPhysicalType<UINT16>(block, sel); return;
+      case INT16: EvaluateForPhysicalType<INT16>(block, sel); return;
+      case UINT32: EvaluateForPhysicalType<UINT32>(block, sel); return;
+      case INT32: EvaluateForPhysicalType<INT32>(block, sel); return;
+      case UINT64: EvaluateForPhysicalType<UINT64>(block, sel); return;
+      case INT64: EvaluateForPhysicalType<INT64>(block, sel); return;
+      case FLOAT: EvaluateForPhysicalType<FLOAT>(block, sel); return;
+      case DOUBLE: EvaluateForPhysicalType<DOUBLE>(block, sel); return;
+      case BOOL: EvaluateForPhysicalType<BOOL>(block, sel); return;
+      case BINARY: EvaluateForPhysicalType<BINARY>(block, sel); return;
+      default: break;
+    }
+  }
 
+  // Generic evaluation, which compares each cell through the column's TypeInfo.
   switch (predicate_type()) {
     case PredicateType::None: {
-      ApplyPredicate(block, sel, [] (const void*) {
+      ApplyPredicate(block, 0, sel, [] (const void*) {
           return false;
       });
       return;
     };
     case PredicateType::Range: {
       if (lower_ == nullptr) {
-        ApplyPredicate(block, sel, [this] (const void* cell) {
+        ApplyPredicate(block, 0, sel, [this] (const void* cell) {
             return column_.type_info()->Compare(cell, this->upper_) < 0;
         });
       } else if (upper_ == nullptr) {
-        ApplyPredicate(block, sel, [this] (const void* cell) {
+        ApplyPredicate(block, 0, sel, [this] (const void* cell) {
             return column_.type_info()->Compare(cell, this->lower_) >= 0;
         });
       } else {
-        ApplyPredicate(block, sel, [this] (const void* cell) {
+        ApplyPredicate(block, 0, sel, [this] (const void* cell) {
             return column_.type_info()->Compare(cell, this->upper_) < 0 &&
                    column_.type_info()->Compare(cell, this->lower_) >= 0;
         });
@@ -255,11 +575,19 @@ void ColumnPredicate::Evaluate(const ColumnBlock& block, SelectionVector *sel) c
       return;
     };
     case PredicateType::Equality: {
-        ApplyPredicate(block, sel, [this] (const void* cell) {
+        ApplyPredicate(block, 0, sel, [this] (const void* cell) {
             return column_.type_info()->Compare(cell, this->lower_) == 0;
         });
         return;
     };
+    case PredicateType::InList: {
+      ApplyPredicate(block, 0, sel, [this] (const void* cell) {
+          return this->InListContains(cell);
+      });
+      return;
+    };
+    case PredicateType::IsNotNull:
+    case PredicateType::IsNull: break;
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -282,6 +610,25 @@ string ColumnPredicate::ToString() const {
     case PredicateType::Equality: {
       return strings::Substitute("`$0` = $1", column_.name(), column_.Stringify(lower_));
     };
+    case PredicateType::InList: {
+      string ss = strings::Substitute("`$0` IN (", column_.name());
+      bool is_first = true;
+      for (const void* value : values_) {
+        if (!is_first) {
+          ss.append(", ");
+        }
+        is_first = false;
+        ss.append(column_.Stringify(value));
+      }
+      ss.append(")");
+      return ss;
+    };
+    case PredicateType::IsNotNull: {
+      return strings::Substitute("`$0` IS NOT NULL", column_.name());
+    };
+    case PredicateType::IsNull: {
+      return strings::Substitute("`$0` IS NULL", column_.name());
+    };
   }
   LOG(FATAL) << "unknown predicate type";
 }
@@ -299,6 +646,16 @@ bool ColumnPredicate::operator==(const ColumnPredicate& other) const {
            (upper_ == other.upper_ ||
             (upper_ != nullptr && other.upper_ != nullptr &&
              column_.type_info()->Compare(upper_, other.upper_) == 0));
+  } else if (predicate_type_ == PredicateType::InList) {
+    if (values_.size() != other.values_.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < values_.size(); i++) {
+      if (column_.type_info()->Compare(values_[i], other.values_[i]) != 0) {
+        return false;
+      }
+    }
+    return true;
   } else {
     return true;
   }
@@ -308,8 +665,11 @@ namespace {
 int SelectivityRank(const ColumnPredicate& predicate) {
   switch (predicate.predicate_type()) {
     case PredicateType::None: return 0;
-    case PredicateType::Equality: return 1;
-    case PredicateType::Range: return 2;
+    case PredicateType::IsNull: return 1;
+    case PredicateType::Equality: return 2;
+    case PredicateType::InList: return 3;
+    case PredicateType::Range: return 4;
+    case PredicateType::IsNotNull: return 5;
   }
   LOG(FATAL) << "unknown predicate type";
 }
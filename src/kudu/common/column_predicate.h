@@ -19,6 +19,7 @@
 
 #include <boost/optional.hpp>
 #include <string>
+#include <vector>
 
 #include "kudu/common/row_key-util.h"
 #include "kudu/common/schema.h"
@@ -42,6 +43,16 @@ enum class PredicateType {
   // A predicate which evaluates to true if the column value falls within a
   // range.
   Range,
+
+  // A predicate which evaluates to true if the column value equals any of a
+  // list of known values.
+  InList,
+
+  // A predicate which evaluates to true if the column value is not null.
+  IsNotNull,
+
+  // A predicate which evaluates to true if the column value is null.
+  IsNull,
 };
 
 // A predicate which can be evaluated over a block of column values.
@@ -91,6 +102,25 @@ class ColumnPredicate {
                                                          const void* upper,
                                                          Arena* arena);
 
+  // Creates a new IN list predicate on the column and values.
+  //
+  // The values are not copied, and must outlive the returned predicate. The
+  // pointers to the values are moved out of 'values', which is left empty.
+  //
+  // The values do not need to be sorted or unique. The predicate will be
+  // simplified into an Equality or None predicate type if there is at most one
+  // distinct value.
+  static ColumnPredicate InList(ColumnSchema column, std::vector<const void*>* values);
+
+  // Creates a new IS NOT NULL predicate for the column.
+  static ColumnPredicate IsNotNull(ColumnSchema column);
+
+  // Creates a new IS NULL predicate for the column.
+  //
+  // The predicate will be simplified into a None predicate if the column is
+  // not nullable.
+  static ColumnPredicate IsNull(ColumnSchema column);
+
   // Returns the type of this predicate.
   PredicateType predicate_type() const {
     return predicate_type_;
@@ -120,8 +150,18 @@ class ColumnPredicate {
   //
   // NOTE: the evaluation result is stored into '*sel' which may or may not be the
   // same vector as block->selection_vector().
+  //
+  // IsNull and IsNotNull predicates only look at the block's null bitmap, so
+  // the cell data of the block need not be materialized for them.
   void Evaluate(const ColumnBlock& block, SelectionVector* sel) const;
 
+  // Returns true if this predicate can be evaluated on the null bitmap of a
+  // column block alone, without looking at the cell data.
+  bool EvaluatesOnNullBitmap() const {
+    return predicate_type_ == PredicateType::IsNull ||
+           predicate_type_ == PredicateType::IsNotNull;
+  }
+
   // Print the predicate for debugging.
   std::string ToString() const;
 
@@ -141,6 +181,11 @@ class ColumnPredicate {
     return upper_;
   }
 
+  // Returns the sorted, distinct values if this is an InList predicate.
+  const std::vector<const void*>& raw_values() const {
+    return values_;
+  }
+
   // Returns the column schema of the column on which this predicate applies.
   const ColumnSchema& column() const {
     return column_;
@@ -171,6 +216,26 @@ class ColumnPredicate {
   // Merge another predicate into this Equality predicate.
   void MergeIntoEquality(const ColumnPredicate& other);
 
+  // Merge another predicate into this InList predicate.
+  void MergeIntoInList(const ColumnPredicate& other);
+
+  // Merge another predicate into this IsNotNull predicate.
+  void MergeIntoIsNotNull(const ColumnPredicate& other);
+
+  // Merge another predicate into this IsNull predicate.
+  void MergeIntoIsNull(const ColumnPredicate& other);
+
+  // Returns true if the value is one of the values of this InList predicate.
+  bool InListContains(const void* value) const;
+
+  // Returns true if the value is contained in this Range predicate.
+  bool RangeContains(const void* value) const;
+
+  // Evaluate this Range, Equality or InList predicate on a column block of the
+  // given physical type. Comparisons are inlined, and vectorized where possible.
+  template <DataType PhysicalType>
+  void EvaluateForPhysicalType(const ColumnBlock& block, SelectionVector* sel) const;
+
   // The type of this predicate.
   PredicateType predicate_type_;
 
@@ -183,6 +248,9 @@ class ColumnPredicate {
 
   // The exclusive upper bound value if this is a Range predicate.
   const void* upper_;
+
+  // The sorted, distinct values if this is an InList predicate.
+  std::vector<const void*> values_;
 };
 
 // Compares predicates according to selectivity. Predicates that match fewer
@@ -0,0 +1,113 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Instruction set independent parts of the vectorized predicate kernels.
+//
+// This is included by each of the translation units which implement kernels
+// for a given instruction set. Each of them defines 'Traits' classes wrapping
+// the vector intrinsics for a physical type, with the following members:
+//
+//   typedef <...> CppType;  // The C++ type of a cell.
+//   typedef <...> Vec;      // A vector of cells.
+//   static const int kLanes;  // The number of cells in a Vec. Must divide 8.
+//
+//   static Vec Load(const CppType* cells);  // Unaligned load.
+//   static Vec Set1(CppType value);         // Broadcast.
+//   static Vec Less(Vec a, Vec b);          // Lanes set where a < b.
+//   static Vec NotLess(Vec a, Vec b);       // Lanes set where !(a < b).
+//   static Vec And(Vec a, Vec b);
+//   static int MoveMask(Vec mask);          // One bit per lane.
+//
+// Since the instantiations of the templates below depend on the Traits type,
+// the code generated for one instruction set is never shared with another.
+
+#pragma once
+
+#include "kudu/common/column_predicate_kernels.h"
+
+namespace kudu {
+namespace predicate_kernels {
+namespace internal {
+
+template <typename Traits, BoundType kBound>
+void EvaluateBytes(const void* cells, size_t nbytes,
+                   const void* lower, const void* upper,
+                   const uint8_t* non_null, uint8_t* sel) {
+  typedef typename Traits::CppType CppType;
+  typedef typename Traits::Vec Vec;
+
+  const bool uses_lower = kBound == BoundType::kLower ||
+                          kBound == BoundType::kBetween ||
+                          kBound == BoundType::kBetweenInclusive;
+  const bool uses_upper = kBound != BoundType::kLower;
+
+  const Vec lo = Traits::Set1(uses_lower ? *reinterpret_cast<const CppType*>(lower)
+                                         : CppType());
+  const Vec hi = Traits::Set1(uses_upper ? *reinterpret_cast<const CppType*>(upper)
+                                         : CppType());
+
+  const CppType* data = reinterpret_cast<const CppType*>(cells);
+  for (size_t i = 0; i < nbytes; i++, data += 8) {
+    if (sel[i] == 0) continue;
+
+    int matches = 0;
+    for (int lane = 0; lane < 8; lane += Traits::kLanes) {
+      Vec v = Traits::Load(data + lane);
+      Vec mask;
+      switch (kBound) {
+        case BoundType::kLower:
+          mask = Traits::NotLess(v, lo);
+          break;
+        case BoundType::kUpper:
+          mask = Traits::Less(v, hi);
+          break;
+        case BoundType::kUpperInclusive:
+          mask = Traits::NotLess(hi, v);
+          break;
+        case BoundType::kBetween:
+          mask = Traits::And(Traits::NotLess(v, lo), Traits::Less(v, hi));
+          break;
+        case BoundType::kBetweenInclusive:
+          mask = Traits::And(Traits::NotLess(v, lo), Traits::NotLess(hi, v));
+          break;
+      }
+      matches |= Traits::MoveMask(mask) << lane;
+    }
+
+    if (non_null != nullptr) {
+      matches &= non_null[i];
+    }
+    sel[i] &= matches;
+  }
+}
+
+template <typename Traits>
+Kernel GetKernelForTraits(BoundType bound) {
+  switch (bound) {
+    case BoundType::kLower: return &EvaluateBytes<Traits, BoundType::kLower>;
+    case BoundType::kUpper: return &EvaluateBytes<Traits, BoundType::kUpper>;
+    case BoundType::kUpperInclusive: return &EvaluateBytes<Traits, BoundType::kUpperInclusive>;
+    case BoundType::kBetween: return &EvaluateBytes<Traits, BoundType::kBetween>;
+    case BoundType::kBetweenInclusive:
+      return &EvaluateBytes<Traits, BoundType::kBetweenInclusive>;
+  }
+  return nullptr;
+}
+
+} // namespace internal
+} // namespace predicate_kernels
+} // namespace kudu
@@ -0,0 +1,185 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kudu/common/column_predicate_kernels.h"
+
+#include <nmmintrin.h>
+
+#include <glog/logging.h>
+
+#include "kudu/common/column_predicate_kernels-inl.h"
+#include "kudu/common/columnblock.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/types.h"
+#include "kudu/gutil/cpu.h"
+
+namespace kudu {
+namespace predicate_kernels {
+
+namespace internal {
+namespace {
+
+struct Int32Traits {
+  typedef int32_t CppType;
+  typedef __m128i Vec;
+  static const int kLanes = 4;
+
+  static Vec Load(const CppType* cells) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells));
+  }
+  static Vec Set1(CppType value) { return _mm_set1_epi32(value); }
+  static Vec Less(Vec a, Vec b) { return _mm_cmplt_epi32(a, b); }
+  static Vec NotLess(Vec a, Vec b) {
+    return _mm_xor_si128(Less(a, b), _mm_set1_epi32(-1));
+  }
+  static Vec And(Vec a, Vec b) { return _mm_and_si128(a, b); }
+  static int MoveMask(Vec mask) { return _mm_movemask_ps(_mm_castsi128_ps(mask)); }
+};
+
+struct Int64Traits {
+  typedef int64_t CppType;
+  typedef __m128i Vec;
+  static const int kLanes = 2;
+
+  static Vec Load(const CppType* cells) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells));
+  }
+  static Vec Set1(CppType value) { return _mm_set1_epi64x(value); }
+  static Vec Less(Vec a, Vec b) { return _mm_cmpgt_epi64(b, a); }
+  static Vec NotLess(Vec a, Vec b) {
+    return _mm_xor_si128(Less(a, b), _mm_set1_epi32(-1));
+  }
+  static Vec And(Vec a, Vec b) { return _mm_and_si128(a, b); }
+  static int MoveMask(Vec mask) { return _mm_movemask_pd(_mm_castsi128_pd(mask)); }
+};
+
+// SSE has no unsigned integer comparisons, so unsigned values are compared
+// as signed after flipping their sign bits.
+struct UInt32Traits : public Int32Traits {
+  typedef uint32_t CppType;
+
+  static Vec Load(const CppType* cells) {
+    return _mm_xor_si128(Int32Traits::Load(reinterpret_cast<const int32_t*>(cells)),
+                         _mm_set1_epi32(INT32_MIN));
+  }
+  static Vec Set1(CppType value) { return _mm_set1_epi32(value ^ 0x80000000U); }
+};
+
+struct UInt64Traits : public Int64Traits {
+  typedef uint64_t CppType;
+
+  static Vec Load(const CppType* cells) {
+    return _mm_xor_si128(Int64Traits::Load(reinterpret_cast<const int64_t*>(cells)),
+                         _mm_set1_epi64x(INT64_MIN));
+  }
+  static Vec Set1(CppType value) { return _mm_set1_epi64x(value ^ 0x8000000000000000ULL); }
+};
+
+// The floating point comparisons are chosen so that NaN compares the same
+// way as it does in TypeInfo::Compare(): neither less than nor greater than
+// any other value.
+struct FloatTraits {
+  typedef float CppType;
+  typedef __m128 Vec;
+  static const int kLanes = 4;
+
+  static Vec Load(const CppType* cells) { return _mm_loadu_ps(cells); }
+  static Vec Set1(CppType value) { return _mm_set1_ps(value); }
+  static Vec Less(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+  static Vec NotLess(Vec a, Vec b) { return _mm_cmpnlt_ps(a, b); }
+  static Vec And(Vec a, Vec b) { return _mm_and_ps(a, b); }
+  static int MoveMask(Vec mask) { return _mm_movemask_ps(mask); }
+};
+
+struct DoubleTraits {
+  typedef double CppType;
+  typedef __m128d Vec;
+  static const int kLanes = 2;
+
+  static Vec Load(const CppType* cells) { return _mm_loadu_pd(cells); }
+  static Vec Set1(CppType value) { return _mm_set1_pd(value); }
+  static Vec Less(Vec a, Vec b) { return _mm_cmplt_pd(a, b); }
+  static Vec NotLess(Vec a, Vec b) { return _mm_cmpnlt_pd(a, b); }
+  static Vec And(Vec a, Vec b) { return _mm_and_pd(a, b); }
+  static int MoveMask(Vec mask) { return _mm_movemask_pd(mask); }
+};
+
+} // anonymous namespace
+
+Kernel GetSse42Kernel(CellType type, BoundType bound) {
+  switch (type) {
+    case CellType::kInt32: return GetKernelForTraits<Int32Traits>(bound);
+    case CellType::kUInt32: return GetKernelForTraits<UInt32Traits>(bound);
+    case CellType::kInt64: return GetKernelForTraits<Int64Traits>(bound);
+    case CellType::kUInt64: return GetKernelForTraits<UInt64Traits>(bound);
+    case CellType::kFloat: return GetKernelForTraits<FloatTraits>(bound);
+    case CellType::kDouble: return GetKernelForTraits<DoubleTraits>(bound);
+  }
+  return nullptr;
+}
+
+} // namespace internal
+
+namespace {
+
+bool GetCellType(DataType physical_type, internal::CellType* type) {
+  switch (physical_type) {
+    case INT32: *type = internal::CellType::kInt32; return true;
+    case UINT32: *type = internal::CellType::kUInt32; return true;
+    case INT64: *type = internal::CellType::kInt64; return true;
+    case UINT64: *type = internal::CellType::kUInt64; return true;
+    case FLOAT: *type = internal::CellType::kFloat; return true;
+    case DOUBLE: *type = internal::CellType::kDouble; return true;
+    default: return false;
+  }
+}
+
+bool CpuHasAvx2() {
+  static const bool has_avx2 = base::CPU().has_avx2();
+  return has_avx2;
+}
+
+} // anonymous namespace
+
+Kernel GetKernel(const TypeInfo* type, BoundType bound) {
+  internal::CellType cell_type;
+  if (!GetCellType(type->physical_type(), &cell_type)) {
+    return nullptr;
+  }
+  if (CpuHasAvx2()) {
+    return internal::GetAvx2Kernel(cell_type, bound);
+  }
+  return internal::GetSse42Kernel(cell_type, bound);
+}
+
+size_t EvaluateVectorized(const ColumnBlock& block, BoundType bound,
+                          const void* lower, const void* upper,
+                          SelectionVector* sel) {
+  DCHECK_LE(block.nrows(), sel->nrows());
+  Kernel kernel = GetKernel(block.type_info(), bound);
+  if (kernel == nullptr) {
+    return 0;
+  }
+  size_t nbytes = block.nrows() / 8;
+  kernel(block.data(), nbytes, lower, upper,
+         block.is_nullable() ? block.null_bitmap() : nullptr,
+         sel->mutable_bitmap());
+  return nbytes * 8;
+}
+
+} // namespace predicate_kernels
+} // namespace kudu
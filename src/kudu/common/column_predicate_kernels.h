@@ -0,0 +1,110 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Note: this header is included by translation units compiled with extra
+// instruction set flags (see column_predicate_kernels_avx2.cc), so it must not
+// pull in anything with inline functions of its own.
+
+namespace kudu {
+
+class ColumnBlock;
+class SelectionVector;
+class TypeInfo;
+
+namespace predicate_kernels {
+
+// The comparison performed by a predicate kernel. Lower bounds are always
+// inclusive.
+enum class BoundType {
+  // lower <= value
+  kLower,
+
+  // value < upper
+  kUpper,
+
+  // value <= upper
+  kUpperInclusive,
+
+  // lower <= value < upper
+  kBetween,
+
+  // lower <= value <= upper
+  //
+  // Equality predicates are evaluated as an inclusive range over a single value.
+  kBetweenInclusive,
+};
+
+// A vectorized predicate kernel.
+//
+// Evaluates the comparison against the first 'nbytes * 8' cells in 'cells',
+// ANDing the result into the selection bitmap 'sel'. If 'non_null' is not
+// NULL, cells whose bit is unset in it are also deselected. Bytes of 'sel'
+// which are entirely unselected are skipped.
+//
+// 'lower' and 'upper' point to the bound values, and may be NULL if the bound
+// type does not use them.
+//
+// The comparisons match those of TypeInfo::Compare(), including for NaN
+// floating point values.
+typedef void (*Kernel)(const void* cells, size_t nbytes,
+                       const void* lower, const void* upper,
+                       const uint8_t* non_null, uint8_t* sel);
+
+// Returns the fastest kernel supported by the CPU for the given type and bound
+// type, or NULL if there is no vectorized kernel for the type.
+//
+// Kernels exist for the types whose physical type is one of the 32 or 64-bit
+// integer types, FLOAT or DOUBLE.
+Kernel GetKernel(const TypeInfo* type, BoundType bound);
+
+// Evaluates the comparison against as many of the leading rows of 'block' as
+// possible using a vectorized kernel, ANDing the result into 'sel'. NULL cells
+// are deselected.
+//
+// Returns the number of rows evaluated, which is always a multiple of 8.
+// The caller is responsible for evaluating the remaining rows. If no kernel is
+// available for the column's type, returns 0.
+size_t EvaluateVectorized(const ColumnBlock& block, BoundType bound,
+                          const void* lower, const void* upper,
+                          SelectionVector* sel);
+
+namespace internal {
+
+// The cell types which have kernels.
+enum class CellType {
+  kInt32,
+  kUInt32,
+  kInt64,
+  kUInt64,
+  kFloat,
+  kDouble,
+};
+
+// Kernels compiled for SSE4.2, which Kudu requires.
+Kernel GetSse42Kernel(CellType type, BoundType bound);
+
+// Kernels compiled for AVX2. These must only be used if the CPU supports AVX2.
+Kernel GetAvx2Kernel(CellType type, BoundType bound);
+
+} // namespace internal
+} // namespace predicate_kernels
+} // namespace kudu
@@ -0,0 +1,136 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// AVX2 versions of the predicate kernels.
+//
+// This file is compiled with -mavx2, so any inline function it instantiates
+// may contain AVX2 instructions. If such a function were also used by other
+// translation units, the linker could pick this copy and crash CPUs without
+// AVX2. To avoid that, only the intrinsics and the templates in
+// column_predicate_kernels-inl.h (instantiated with types local to this file)
+// may be used here.
+
+#include <immintrin.h>
+
+#include "kudu/common/column_predicate_kernels-inl.h"
+
+namespace kudu {
+namespace predicate_kernels {
+namespace internal {
+namespace {
+
+struct Int32Traits {
+  typedef int32_t CppType;
+  typedef __m256i Vec;
+  static const int kLanes = 8;
+
+  static Vec Load(const CppType* cells) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells));
+  }
+  static Vec Set1(CppType value) { return _mm256_set1_epi32(value); }
+  static Vec Less(Vec a, Vec b) { return _mm256_cmpgt_epi32(b, a); }
+  static Vec NotLess(Vec a, Vec b) {
+    return _mm256_xor_si256(Less(a, b), _mm256_set1_epi32(-1));
+  }
+  static Vec And(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+  static int MoveMask(Vec mask) { return _mm256_movemask_ps(_mm256_castsi256_ps(mask)); }
+};
+
+struct Int64Traits {
+  typedef int64_t CppType;
+  typedef __m256i Vec;
+  static const int kLanes = 4;
+
+  static Vec Load(const CppType* cells) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells));
+  }
+  static Vec Set1(CppType value) { return _mm256_set1_epi64x(value); }
+  static Vec Less(Vec a, Vec b) { return _mm256_cmpgt_epi64(b, a); }
+  static Vec NotLess(Vec a, Vec b) {
+    return _mm256_xor_si256(Less(a, b), _mm256_set1_epi32(-1));
+  }
+  static Vec And(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+  static int MoveMask(Vec mask) { return _mm256_movemask_pd(_mm256_castsi256_pd(mask)); }
+};
+
+struct UInt32Traits : public Int32Traits {
+  typedef uint32_t CppType;
+
+  static Vec Load(const CppType* cells) {
+    return _mm256_xor_si256(Int32Traits::Load(reinterpret_cast<const int32_t*>(cells)),
+                            _mm256_set1_epi32(INT32_MIN));
+  }
+  static Vec Set1(CppType value) { return _mm256_set1_epi32(value ^ 0x80000000U); }
+};
+
+struct UInt64Traits : public Int64Traits {
+  typedef uint64_t CppType;
+
+  static Vec Load(const CppType* cells) {
+    return _mm256_xor_si256(Int64Traits::Load(reinterpret_cast<const int64_t*>(cells)),
+                            _mm256_set1_epi64x(INT64_MIN));
+  }
+  static Vec Set1(CppType value) {
+    return _mm256_set1_epi64x(value ^ 0x8000000000000000ULL);
+  }
+};
+
+// _CMP_LT_OQ is false for NaN while _CMP_NLT_UQ is true, matching the
+// semantics of TypeInfo::Compare().
+struct FloatTraits {
+  typedef float CppType;
+  typedef __m256 Vec;
+  static const int kLanes = 8;
+
+  static Vec Load(const CppType* cells) { return _mm256_loadu_ps(cells); }
+  static Vec Set1(CppType value) { return _mm256_set1_ps(value); }
+  static Vec Less(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static Vec NotLess(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_NLT_UQ); }
+  static Vec And(Vec a, Vec b) { return _mm256_and_ps(a, b); }
+  static int MoveMask(Vec mask) { return _mm256_movemask_ps(mask); }
+};
+
+struct DoubleTraits {
+  typedef double CppType;
+  typedef __m256d Vec;
+  static const int kLanes = 4;
+
+  static Vec Load(const CppType* cells) { return _mm256_loadu_pd(cells); }
+  static Vec Set1(CppType value) { return _mm256_set1_pd(value); }
+  static Vec Less(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+  static Vec NotLess(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_NLT_UQ); }
+  static Vec And(Vec a, Vec b) { return _mm256_and_pd(a, b); }
+  static int MoveMask(Vec mask) { return _mm256_movemask_pd(mask); }
+};
+
+} // anonymous namespace
+
+Kernel GetAvx2Kernel(CellType type, BoundType bound) {
+  switch (type) {
+    case CellType::kInt32: return GetKernelForTraits<Int32Traits>(bound);
+    case CellType::kUInt32: return GetKernelForTraits<UInt32Traits>(bound);
+    case CellType::kInt64: return GetKernelForTraits<Int64Traits>(bound);
+    case CellType::kUInt64: return GetKernelForTraits<UInt64Traits>(bound);
+    case CellType::kFloat: return GetKernelForTraits<FloatTraits>(bound);
+    case CellType::kDouble: return GetKernelForTraits<DoubleTraits>(bound);
+  }
+  return nullptr;
+}
+
+} // namespace internal
+} // namespace predicate_kernels
+} // namespace kudu
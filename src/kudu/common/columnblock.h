@@ -17,6 +17,8 @@
 #ifndef KUDU_COMMON_COLUMNBLOCK_H
 #define KUDU_COMMON_COLUMNBLOCK_H
 
+#include <memory>
+
 #include "kudu/common/types.h"
 #include "kudu/common/row.h"
 #include "kudu/gutil/gscoped_ptr.h"
@@ -184,6 +186,10 @@ class ColumnDataView {
 
   Arena *arena() { return column_block_->arena(); }
 
+  bool is_nullable() const {
+    return column_block_->is_nullable();
+  }
+
   size_t nrows() const {
     return column_block_->nrows() - row_offset_;
   }
@@ -201,6 +207,15 @@ class ColumnDataView {
   size_t row_offset_;
 };
 
+// Cells of a column block as they are stored elsewhere, e.g. in a cached data
+// block, in the same in-memory format as the column block. 'pin' keeps them
+// valid for as long as it lives, so that they may be referenced, e.g. by an
+// RPC sidecar, rather than copied.
+struct PinnedCells {
+  Slice cells;
+  std::shared_ptr<const void> pin;
+};
+
 // Utility class which allocates temporary storage for a
 // dense block of column data, freeing it when it goes
 // out of scope.
@@ -26,6 +26,7 @@
 #include "kudu/common/schema.h"
 #include "kudu/gutil/casts.h"
 #include "kudu/gutil/mathlimits.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
 #include "kudu/util/test_util.h"
@@ -132,23 +133,25 @@ class TestIntRangePredicate {
   ColumnRangePredicate pred_;
 };
 
-void TestMerge(const TestIntRangePredicate &predicate) {
+void TestMerge(const TestIntRangePredicate &predicate,
+               int num_lists = FLAGS_num_lists,
+               int num_rows = FLAGS_num_rows) {
   vector<shared_ptr<RowwiseIterator> > to_merge;
   vector<uint32_t> ints;
   vector<uint32_t> all_ints;
-  all_ints.reserve(FLAGS_num_rows * FLAGS_num_lists);
+  all_ints.reserve(num_rows * num_lists);
 
   // Setup predicate exclusion
   ScanSpec spec;
   spec.AddPredicate(predicate.pred_);
   LOG(INFO) << "Predicate: " << predicate.pred_.ToString();
 
-  for (int i = 0; i < FLAGS_num_lists; i++) {
+  for (int i = 0; i < num_lists; i++) {
     ints.clear();
-    ints.reserve(FLAGS_num_rows);
+    ints.reserve(num_rows);
 
     uint32_t entry = 0;
-    for (int j = 0; j < FLAGS_num_rows; j++) {
+    for (int j = 0; j < num_rows; j++) {
       entry += rand() % 5;
       ints.push_back(entry);
       // Evaluate the predicate before pushing to all_ints
@@ -172,7 +175,7 @@ void TestMerge(const TestIntRangePredicate &predicate) {
   }
 
   for (int trial = 0; trial < FLAGS_num_iters; trial++) {
-    LOG_TIMING(INFO, "Iterate merged lists") {
+    LOG_TIMING(INFO, strings::Substitute("Iterate $0 merged lists", num_lists)) {
       MergeIterator merger(kIntSchema, to_merge);
       ASSERT_OK(merger.Init(&spec));
 
@@ -194,6 +197,7 @@ void TestMerge(const TestIntRangePredicate &predicate) {
           total_idx++;
         }
       }
+      ASSERT_EQ(all_ints.size(), total_idx);
     }
   }
 }
@@ -209,6 +213,24 @@ TEST(TestMergeIterator, TestPredicate) {
   TestMerge(predicate);
 }
 
+// Test a predicate which filters out every row of the first few blocks of
+// each input. Those blocks must not be mistaken for the end of the input.
+TEST(TestMergeIterator, TestPredicateFiltersWholeBlocks) {
+  TestIntRangePredicate predicate(8000, MathLimits<uint32_t>::kMax);
+  TestMerge(predicate, 3, 5000);
+}
+
+// Benchmark the merge with the number of inputs ranging from a handful to as
+// many as an ordered scan over a tablet with a large number of rowsets might
+// see. The total number of rows is kept the same.
+TEST(TestMergeIterator, BenchmarkManyInputs) {
+  const int kTotalRows = AllowSlowTests() ? 1000000 : 100000;
+  TestIntRangePredicate predicate(0, MathLimits<uint32_t>::kMax);
+  for (int num_lists : { 2, 10, 100, 1000 }) {
+    NO_FATALS(TestMerge(predicate, num_lists, kTotalRows / num_lists));
+  }
+}
+
 // Test that the MaterializingIterator properly evaluates predicates when they apply
 // to single columns.
 TEST(TestMaterializingIterator, TestMaterializingPredicatePushdown) {
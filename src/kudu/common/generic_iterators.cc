@@ -24,6 +24,7 @@
 #include "kudu/common/generic_iterators.h"
 #include "kudu/common/row.h"
 #include "kudu/common/rowblock.h"
+#include "kudu/gutil/endian.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/util/flag_tags.h"
 #include "kudu/util/memory/arena.h"
@@ -35,6 +36,16 @@ DEFINE_bool(materializing_iterator_do_pushdown, true,
             "Should MaterializingIterator do predicate pushdown");
 TAG_FLAG(materializing_iterator_do_pushdown, hidden);
 
+DEFINE_bool(materializing_iterator_decode_selected_only, true,
+            "Should MaterializingIterator skip decoding rows which have already been "
+            "filtered out by predicates on previously materialized columns");
+TAG_FLAG(materializing_iterator_decode_selected_only, hidden);
+
+DEFINE_bool(materializing_iterator_use_zone_maps, true,
+            "Should MaterializingIterator use the zone maps of the underlying data "
+            "to skip blocks of rows which cannot match the predicates");
+TAG_FLAG(materializing_iterator_use_zone_maps, hidden);
+
 namespace kudu {
 
 ////////////////////////////////////////////////////////////
@@ -44,16 +55,51 @@ namespace kudu {
 // TODO: size by bytes, not # rows
 static const int kMergeRowBuffer = 1000;
 
+// Returns a prefix of the given key cell which sorts the same way as the
+// cell itself: if the prefix of 'a' is less than the prefix of 'b', then 'a'
+// sorts before 'b'. Equal prefixes say nothing about the order of the cells.
+//
+// Types without a cheap order-preserving encoding get a constant prefix, so
+// that rows are always ordered by a full comparison.
+static uint64_t EncodeKeyPrefix(DataType physical_type, const void* cell) {
+  // Flipping the sign bit of a signed integer makes its two's complement
+  // representation sort as an unsigned integer.
+  const uint64_t kSignBit = 1ULL << 63;
+  switch (physical_type) {
+    case BOOL:
+    case UINT8: return *reinterpret_cast<const uint8_t*>(cell);
+    case UINT16: return *reinterpret_cast<const uint16_t*>(cell);
+    case UINT32: return *reinterpret_cast<const uint32_t*>(cell);
+    case UINT64: return *reinterpret_cast<const uint64_t*>(cell);
+    case INT8: return static_cast<int64_t>(*reinterpret_cast<const int8_t*>(cell)) ^ kSignBit;
+    case INT16: return static_cast<int64_t>(*reinterpret_cast<const int16_t*>(cell)) ^ kSignBit;
+    case INT32: return static_cast<int64_t>(*reinterpret_cast<const int32_t*>(cell)) ^ kSignBit;
+    case INT64: return *reinterpret_cast<const int64_t*>(cell) ^ kSignBit;
+    case BINARY: {
+      // The first 8 bytes in big-endian order, zero-padded. Padding makes
+      // "a" and "a\0" share a prefix, which the full comparison resolves.
+      const Slice* slice = reinterpret_cast<const Slice*>(cell);
+      uint64_t prefix = 0;
+      memcpy(&prefix, slice->data(), std::min<size_t>(slice->size(), sizeof(prefix)));
+      return BigEndian::ToHost64(prefix);
+    }
+    default: return 0;
+  }
+}
+
 // MergeIterState wraps a RowwiseIterator for use by the MergeIterator.
 // Importantly, it also filters out unselected rows from the wrapped RowwiseIterator,
 // such that all returned rows are valid.
 class MergeIterState {
  public:
-  explicit MergeIterState(const shared_ptr<RowwiseIterator> &iter) :
+  MergeIterState(const shared_ptr<RowwiseIterator> &iter, size_t index) :
     iter_(iter),
+    index_(index),
     arena_(1024, 256*1024),
     read_block_(iter->schema(), kMergeRowBuffer, &arena_),
+    key_type_(iter->schema().column(0).type_info()->physical_type()),
     next_row_idx_(0),
+    next_key_prefix_(0),
     num_advanced_(0),
     num_valid_(0)
   {}
@@ -63,6 +109,19 @@ class MergeIterState {
     return next_row_;
   }
 
+  // The encoded prefix of the first key column of next_row().
+  // See EncodeKeyPrefix().
+  uint64_t next_key_prefix() const {
+    DCHECK_LT(num_advanced_, num_valid_);
+    return next_key_prefix_;
+  }
+
+  // The position of the wrapped iterator among the inputs of the merge, used
+  // to order rows with equal keys deterministically.
+  size_t index() const {
+    return index_;
+  }
+
   Status Advance() {
     num_advanced_++;
     if (IsBlockExhausted()) {
@@ -70,14 +129,7 @@ class MergeIterState {
       return PullNextBlock();
     } else {
       // Seek to the next selected row.
-      SelectionVector *selection = read_block_.selection_vector();
-      for (++next_row_idx_; next_row_idx_ < read_block_.nrows(); next_row_idx_++) {
-        if (selection->IsRowSelected(next_row_idx_)) {
-          next_row_.Reset(&read_block_, next_row_idx_);
-          break;
-        }
-      }
-      DCHECK_NE(next_row_idx_, read_block_.nrows()+1) << "No selected rows found!";
+      SeekToSelectedRow(next_row_idx_ + 1);
       return Status::OK();
     }
   }
@@ -94,29 +146,26 @@ class MergeIterState {
     CHECK_EQ(num_advanced_, num_valid_)
       << "should not pull next block until current block is exhausted";
 
-    if (!iter_->HasNext()) {
-      // Fully exhausted
-      num_advanced_ = 0;
-      num_valid_ = 0;
-      return Status::OK();
-    }
-
-    RETURN_NOT_OK(iter_->NextBlock(&read_block_));
+    // Predicates may filter out every row of a block, so keep reading until
+    // a block has a selected row. Stopping at such a block would make this
+    // iterator look fully exhausted and silently drop the rest of its rows.
     num_advanced_ = 0;
-    // Honor the selection vector of the read_block_, since not all rows are necessarily selected.
-    SelectionVector *selection = read_block_.selection_vector();
-    DCHECK_EQ(selection->nrows(), read_block_.nrows());
-    DCHECK_LE(selection->CountSelected(), read_block_.nrows());
-    num_valid_ = selection->CountSelected();
-    VLOG(2) << selection->CountSelected() << "/" << read_block_.nrows() << " rows selected";
-    // Seek next_row_ to the first selected row.
-    for (next_row_idx_ = 0; next_row_idx_ < read_block_.nrows(); next_row_idx_++) {
-      if (selection->IsRowSelected(next_row_idx_)) {
-        next_row_.Reset(&read_block_, next_row_idx_);
-        break;
+    num_valid_ = 0;
+    while (num_valid_ == 0) {
+      if (!iter_->HasNext()) {
+        // Fully exhausted
+        return Status::OK();
       }
+
+      RETURN_NOT_OK(iter_->NextBlock(&read_block_));
+      // Honor the selection vector of the read_block_, since not all rows are necessarily selected.
+      SelectionVector *selection = read_block_.selection_vector();
+      DCHECK_EQ(selection->nrows(), read_block_.nrows());
+      num_valid_ = selection->CountSelected();
+      VLOG(2) << num_valid_ << "/" << read_block_.nrows() << " rows selected";
     }
-    DCHECK_NE(next_row_idx_, read_block_.nrows()+1) << "No selected rows found!";
+    // Seek next_row_ to the first selected row.
+    SeekToSelectedRow(0);
     return Status::OK();
   }
 
@@ -128,13 +177,33 @@ class MergeIterState {
     return iter_;
   }
 
+ private:
+  // Point next_row_ at the first selected row of read_block_ at or after
+  // 'idx', and encode its key prefix.
+  void SeekToSelectedRow(size_t idx) {
+    SelectionVector *selection = read_block_.selection_vector();
+    for (next_row_idx_ = idx; next_row_idx_ < read_block_.nrows(); next_row_idx_++) {
+      if (selection->IsRowSelected(next_row_idx_)) {
+        next_row_.Reset(&read_block_, next_row_idx_);
+        next_key_prefix_ = EncodeKeyPrefix(key_type_, next_row_.cell_ptr(0));
+        return;
+      }
+    }
+    LOG(DFATAL) << "No selected rows found!";
+  }
+
   shared_ptr<RowwiseIterator> iter_;
+  const size_t index_;
   Arena arena_;
   RowBlock read_block_;
+  // The physical type of the first key column.
+  const DataType key_type_;
   // The row currently pointed to by the iterator.
   RowBlockRow next_row_;
   // Row index of next_row_ in read_block_.
   size_t next_row_idx_;
+  // The encoded prefix of the first key column of next_row_.
+  uint64_t next_key_prefix_;
   // Number of rows we've advanced past in the current RowBlock.
   size_t num_advanced_;
   // Number of valid (selected) rows in the current RowBlock.
@@ -144,9 +213,14 @@ class MergeIterState {
 
 MergeIterator::MergeIterator(
   const Schema &schema,
-  const vector<shared_ptr<RowwiseIterator> > &iters)
+  const vector<shared_ptr<RowwiseIterator> > &iters,
+  gscoped_ptr<RowComparator> comparator)
   : schema_(schema),
+    comparator_(std::move(comparator)),
     initted_(false) {
+  if (!comparator_) {
+    comparator_.reset(new RowComparator(&schema_));
+  }
   CHECK_GT(iters.size(), 0);
   CHECK_GT(schema.num_key_columns(), 0);
   orig_iters_.assign(iters.begin(), iters.end());
@@ -158,20 +232,17 @@ Status MergeIterator::Init(ScanSpec *spec) {
 
   RETURN_NOT_OK(InitSubIterators(spec));
 
+  // Only iterators which have rows go into the heap. Otherwise, HasNext()
+  // won't properly return false if we were passed only empty iterators.
   for (shared_ptr<MergeIterState> &state : iters_) {
     RETURN_NOT_OK(state->PullNextBlock());
-  }
-
-  // Before we copy any rows, clean up any iterators which were empty
-  // to start with. Otherwise, HasNext() won't properly return false
-  // if we were passed only empty iterators.
-  for (size_t i = 0; i < iters_.size(); i++) {
-    if (PREDICT_FALSE(iters_[i]->IsFullyExhausted())) {
-      iters_.erase(iters_.begin() + i);
-      i--;
-      continue;
+    if (PREDICT_TRUE(!state->IsFullyExhausted())) {
+      heap_.push_back(state.get());
     }
   }
+  for (ssize_t i = static_cast<ssize_t>(heap_.size()) / 2 - 1; i >= 0; i--) {
+    SiftDown(i);
+  }
 
   initted_ = true;
   return Status::OK();
@@ -179,7 +250,7 @@ Status MergeIterator::Init(ScanSpec *spec) {
 
 bool MergeIterator::HasNext() const {
   CHECK(initted_);
-  return !iters_.empty();
+  return !heap_.empty();
 }
 
 Status MergeIterator::InitSubIterators(ScanSpec *spec) {
@@ -187,13 +258,14 @@ Status MergeIterator::InitSubIterators(ScanSpec *spec) {
   for (shared_ptr<RowwiseIterator> &iter : orig_iters_) {
     ScanSpec *spec_copy = spec != nullptr ? scan_spec_copies_.Construct(*spec) : nullptr;
     RETURN_NOT_OK(PredicateEvaluatingIterator::InitAndMaybeWrap(&iter, spec_copy));
-    iters_.push_back(shared_ptr<MergeIterState>(new MergeIterState(iter)));
+    iters_.push_back(shared_ptr<MergeIterState>(new MergeIterState(iter, iters_.size())));
   }
 
   // Since we handle predicates in all the wrapped iterators, we can clear
   // them here.
   if (spec != nullptr) {
     spec->mutable_predicates()->clear();
+    spec->mutable_column_predicates()->clear();
   }
   return Status::OK();
 }
@@ -216,49 +288,66 @@ void MergeIterator::PrepareBatch(RowBlock* dst) {
   // We can always provide at least as many rows as are remaining
   // in the currently queued up blocks.
   size_t available = 0;
-  for (shared_ptr<MergeIterState> &iter : iters_) {
-    available += iter->remaining_in_block();
+  for (const MergeIterState* state : heap_) {
+    available += state->remaining_in_block();
   }
 
   dst->Resize(std::min(dst->row_capacity(), available));
 }
 
-// TODO: this is an obvious spot to add codegen - there's a ton of branching
-// and such around the comparisons. A simple experiment indicated there's some
-// 2x to be gained.
+bool MergeIterator::RowLess(MergeIterState* a, MergeIterState* b) const {
+  // Most of the time the key prefixes differ, which saves a full comparison
+  // of the rows.
+  if (a->next_key_prefix() != b->next_key_prefix()) {
+    return a->next_key_prefix() < b->next_key_prefix();
+  }
+  int cmp = comparator_->Compare(a->next_row(), b->next_row());
+  if (cmp != 0) {
+    return cmp < 0;
+  }
+  return a->index() < b->index();
+}
+
+void MergeIterator::SiftDown(size_t idx) {
+  MergeIterState* state = heap_[idx];
+  size_t size = heap_.size();
+  while (true) {
+    size_t child = 2 * idx + 1;
+    if (child >= size) break;
+    if (child + 1 < size && RowLess(heap_[child + 1], heap_[child])) {
+      child++;
+    }
+    if (!RowLess(heap_[child], state)) break;
+    heap_[idx] = heap_[child];
+    idx = child;
+  }
+  heap_[idx] = state;
+}
+
 Status MergeIterator::MaterializeBlock(RowBlock *dst) {
   // Initialize the selection vector.
   // MergeIterState only returns selected rows.
   dst->selection_vector()->SetAllTrue();
   for (size_t dst_row_idx = 0; dst_row_idx < dst->nrows(); dst_row_idx++) {
-    RowBlockRow dst_row = dst->row(dst_row_idx);
-
-    // Find the sub-iterator which is currently smallest
-    MergeIterState *smallest = nullptr;
-    ssize_t smallest_idx = -1;
-
-    // Typically the number of iters_ is not that large, so using a priority
-    // queue is not worth it
-    for (size_t i = 0; i < iters_.size(); i++) {
-      shared_ptr<MergeIterState> &state = iters_[i];
-
-      if (smallest == nullptr ||
-          schema_.Compare(state->next_row(), smallest->next_row()) < 0) {
-        smallest = state.get();
-        smallest_idx = i;
-      }
-    }
-
     // If no iterators had any row left, then we're done iterating.
-    if (PREDICT_FALSE(smallest == nullptr)) break;
+    if (PREDICT_FALSE(heap_.empty())) break;
 
-    // Otherwise, copy the row from the smallest one, and advance it
-    RETURN_NOT_OK(CopyRow(smallest->next_row(), &dst_row, dst->arena()));
+    // The sub-iterator which is currently smallest is at the top of the heap.
+    // Copy the row from it, and advance it.
+    MergeIterState* smallest = heap_.front();
+    RowBlockRow dst_row = dst->row(dst_row_idx);
+    RETURN_NOT_OK(comparator_->Copy(smallest->next_row(), &dst_row, dst->arena()));
     RETURN_NOT_OK(smallest->Advance());
 
     if (smallest->IsFullyExhausted()) {
-      iters_.erase(iters_.begin() + smallest_idx);
+      heap_.front() = heap_.back();
+      heap_.pop_back();
+      if (heap_.empty()) continue;
     }
+    // Either the top iterator moved on to a larger row or it was replaced;
+    // restore the heap order. When one input supplies a run of rows, this
+    // costs only the two comparisons with the children of the root.
+    SiftDown(0);
   }
 
   return Status::OK();
@@ -347,6 +436,7 @@ Status UnionIterator::InitSubIterators(ScanSpec *spec) {
   // them here.
   if (spec != nullptr) {
     spec->mutable_predicates()->clear();
+    spec->mutable_column_predicates()->clear();
   }
   return Status::OK();
 }
@@ -427,7 +517,10 @@ void UnionIterator::GetIteratorStats(std::vector<IteratorStats>* stats) const {
 
 MaterializingIterator::MaterializingIterator(shared_ptr<ColumnwiseIterator> iter)
     : iter_(std::move(iter)),
-      disallow_pushdown_for_tests_(!FLAGS_materializing_iterator_do_pushdown) {
+      arena_(256, 4096),
+      disallow_pushdown_for_tests_(!FLAGS_materializing_iterator_do_pushdown),
+      decode_selected_only_(FLAGS_materializing_iterator_decode_selected_only),
+      use_zone_maps_(FLAGS_materializing_iterator_use_zone_maps) {
 }
 
 Status MaterializingIterator::Init(ScanSpec *spec) {
@@ -445,31 +538,54 @@ Status MaterializingIterator::Init(ScanSpec *spec) {
       }
 
       VLOG(1) << "Pushing down predicate " << pred.ToString();
-      preds_by_column_.insert(std::make_pair(idx, pred));
+      boost::optional<ColumnPredicate> col_pred = pred.ToColumnPredicate(&arena_);
+      if (col_pred) {
+        AddColumnPredicate(idx, std::move(*col_pred));
+      } else {
+        preds_by_column_.insert(std::make_pair(idx, pred));
+      }
 
       // Since we'll evaluate this predicate ourselves, remove it from the scan spec
       // so higher layers don't repeat our work.
       iter = preds->erase(iter);
     }
+
+    for (ColumnPredicate& pred : *spec->mutable_column_predicates()) {
+      const string& col_name = pred.column().name();
+      int idx = schema().find_column(col_name);
+      if (idx == -1) {
+        return Status::InvalidArgument("No such column", col_name);
+      }
+      VLOG(1) << "Pushing down predicate " << pred.ToString();
+      AddColumnPredicate(idx, std::move(pred));
+    }
+    spec->mutable_column_predicates()->clear();
   }
 
   // Determine a materialization order such that columns with predicates
-  // are materialized first.
+  // are materialized first. Columns with IS NULL or IS NOT NULL predicates
+  // go before the rest, since those can be evaluated without decoding any
+  // values.
   //
   // TODO: we can be a little smarter about this, by trying to estimate
   // predicate selectivity, involve the materialization cost of types, etc.
-  vector<size_t> with_preds, without_preds;
+  vector<size_t> with_null_preds, with_preds, without_preds;
 
   for (size_t i = 0; i < schema().num_columns(); i++) {
-    int num_preds = preds_by_column_.count(i);
-    if (num_preds > 0) {
+    auto col_pred = column_preds_by_column_.find(i);
+    if (col_pred != column_preds_by_column_.end() &&
+        col_pred->second.EvaluatesOnNullBitmap()) {
+      with_null_preds.push_back(i);
+    } else if (preds_by_column_.count(i) > 0 || col_pred != column_preds_by_column_.end()) {
       with_preds.push_back(i);
     } else {
       without_preds.push_back(i);
     }
   }
 
-  materialization_order_.swap(with_preds);
+  materialization_order_.swap(with_null_preds);
+  materialization_order_.insert(materialization_order_.end(),
+                                with_preds.begin(), with_preds.end());
   materialization_order_.insert(materialization_order_.end(),
                                 without_preds.begin(), without_preds.end());
   DCHECK_EQ(materialization_order_.size(), schema().num_columns());
@@ -477,6 +593,15 @@ Status MaterializingIterator::Init(ScanSpec *spec) {
   return Status::OK();
 }
 
+void MaterializingIterator::AddColumnPredicate(size_t col_idx, ColumnPredicate pred) {
+  auto existing = column_preds_by_column_.find(col_idx);
+  if (existing == column_preds_by_column_.end()) {
+    column_preds_by_column_.insert(std::make_pair(col_idx, std::move(pred)));
+  } else {
+    existing->second.Merge(pred);
+  }
+}
+
 bool MaterializingIterator::HasNext() const {
   return iter_->HasNext();
 }
@@ -502,10 +627,70 @@ Status MaterializingIterator::MaterializeBlock(RowBlock *dst) {
 
   bool short_circuit = false;
 
+  // Set once a predicate has been evaluated, at which point the selection
+  // vector may have filtered out rows which subsequent columns need not decode.
+  bool evaluated_predicate = false;
+
+  // Rule out rows using the zone maps of the underlying data first. If none
+  // are left, no column needs to be read at all.
+  if (use_zone_maps_ && !column_preds_by_column_.empty()) {
+    for (const auto& entry : column_preds_by_column_) {
+      RETURN_NOT_OK(iter_->EvaluateZoneMaps(entry.first, entry.second,
+                                            dst->selection_vector()));
+      if (!dst->selection_vector()->AnySelected()) {
+        return Status::OK();
+      }
+    }
+    evaluated_predicate = true;
+  }
+
   for (size_t col_idx : materialization_order_) {
-    // Materialize the column itself into the row block.
     ColumnBlock dst_col(dst->column_block(col_idx));
-    RETURN_NOT_OK(iter_->MaterializeColumn(col_idx, &dst_col));
+    auto col_pred = column_preds_by_column_.find(col_idx);
+    bool col_pred_evaluated = false;
+
+    // An IS NULL or IS NOT NULL predicate only needs the null bitmap of the
+    // column, so evaluate it before decoding any values. Blocks whose rows
+    // are all filtered out by it then need not be decoded at all.
+    if (col_pred != column_preds_by_column_.end() &&
+        col_pred->second.EvaluatesOnNullBitmap() &&
+        decode_selected_only_) {
+      RETURN_NOT_OK(iter_->MaterializeColumnNullBitmap(col_idx, &dst_col));
+      col_pred->second.Evaluate(dst_col, dst->selection_vector());
+      col_pred_evaluated = true;
+      evaluated_predicate = true;
+      if (!dst->selection_vector()->AnySelected()) {
+        break;
+      }
+    }
+
+    // Materialize the column itself into the row block. If the column has a
+    // predicate, the underlying iterator may evaluate it on the encoded data
+    // as it goes, so that the rows it filters out are never copied.
+    if (col_pred != column_preds_by_column_.end() && !col_pred_evaluated &&
+        decode_selected_only_) {
+      RETURN_NOT_OK(iter_->MaterializeColumnAndEvaluate(col_idx, col_pred->second,
+                                                        dst->selection_vector(), &dst_col,
+                                                        &col_pred_evaluated));
+      if (col_pred_evaluated) {
+        evaluated_predicate = true;
+        if (!dst->selection_vector()->AnySelected()) {
+          break;
+        }
+      }
+    } else if (evaluated_predicate && decode_selected_only_) {
+      RETURN_NOT_OK(iter_->MaterializeColumnSelected(col_idx, *dst->selection_vector(),
+                                                     &dst_col));
+    } else {
+      RETURN_NOT_OK(iter_->MaterializeColumn(col_idx, &dst_col));
+    }
+
+    if (dst->pin_cells()) {
+      PinnedCells pinned;
+      if (iter_->GetPinnedCells(col_idx, &pinned)) {
+        dst->SetPinnedCells(col_idx, std::move(pinned));
+      }
+    }
 
     // Evaluate any predicates that apply to this column.
     auto range = preds_by_column_.equal_range(col_idx);
@@ -513,6 +698,7 @@ Status MaterializingIterator::MaterializeBlock(RowBlock *dst) {
       const ColumnRangePredicate &pred = it->second;
 
       pred.Evaluate(dst, dst->selection_vector());
+      evaluated_predicate = true;
 
       // If after evaluating this predicate, the entire row block has now been
       // filtered out, we don't need to materialize other columns at all.
@@ -524,6 +710,14 @@ Status MaterializingIterator::MaterializeBlock(RowBlock *dst) {
     if (short_circuit) {
       break;
     }
+
+    if (col_pred != column_preds_by_column_.end() && !col_pred_evaluated) {
+      col_pred->second.Evaluate(dst_col, dst->selection_vector());
+      evaluated_predicate = true;
+      if (!dst->selection_vector()->AnySelected()) {
+        break;
+      }
+    }
   }
   DVLOG(1) << dst->selection_vector()->CountSelected() << "/"
            << dst->nrows() << " passed predicate";
@@ -548,7 +742,7 @@ Status PredicateEvaluatingIterator::InitAndMaybeWrap(
   shared_ptr<RowwiseIterator> *base_iter, ScanSpec *spec) {
   RETURN_NOT_OK((*base_iter)->Init(spec));
   if (spec != nullptr &&
-      !spec->predicates().empty()) {
+      (!spec->predicates().empty() || !spec->column_predicates().empty())) {
     // Underlying iterator did not accept all predicates. Wrap it.
     shared_ptr<RowwiseIterator> wrapper(
       new PredicateEvaluatingIterator(*base_iter));
@@ -565,6 +759,7 @@ Status PredicateEvaluatingIterator::Init(ScanSpec *spec) {
   // Gather any predicates that the base iterator did not pushdown.
   // This also clears the predicates from the spec.
   predicates_.swap(*(spec->mutable_predicates()));
+  column_predicates_.swap(*(spec->mutable_column_predicates()));
   return Status::OK();
 }
 
@@ -580,6 +775,15 @@ Status PredicateEvaluatingIterator::NextBlock(RowBlock *dst) {
 
     // If after evaluating this predicate, the entire row block has now been
     // filtered out, we don't need to evaluate any further predicates.
+    if (!dst->selection_vector()->AnySelected()) {
+      return Status::OK();
+    }
+  }
+
+  for (const ColumnPredicate& pred : column_predicates_) {
+    int col_idx = dst->schema().find_column(pred.column().name());
+    CHECK_GE(col_idx, 0) << "bad col: " << pred.column().ToString();
+    pred.Evaluate(dst->column_block(col_idx), dst->selection_vector());
     if (!dst->selection_vector()->AnySelected()) {
       break;
     }
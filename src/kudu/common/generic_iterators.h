@@ -25,7 +25,9 @@
 #include <vector>
 
 #include "kudu/common/iterator.h"
+#include "kudu/common/row_comparator.h"
 #include "kudu/common/scan_spec.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/object_pool.h"
 
 namespace kudu {
@@ -40,8 +42,14 @@ class MergeIterator : public RowwiseIterator {
   // TODO: clarify whether schema is just the projection, or must include the merge
   // key columns. It should probably just be the required projection, which must be
   // a subset of the columns in 'iters'.
+  //
+  // Rows are compared and copied with 'comparator', which must have the
+  // same column types as 'schema'. A code-generated comparator may be passed
+  // (see codegen::CompilationManager::RequestRowComparator()); if it is
+  // NULL, an interpreted one is used.
   MergeIterator(const Schema &schema,
-                const std::vector<std::shared_ptr<RowwiseIterator> > &iters);
+                const std::vector<std::shared_ptr<RowwiseIterator> > &iters,
+                gscoped_ptr<RowComparator> comparator = gscoped_ptr<RowComparator>());
 
   // The passed-in iterators should be already initialized.
   Status Init(ScanSpec *spec) OVERRIDE;
@@ -61,8 +69,18 @@ class MergeIterator : public RowwiseIterator {
   Status MaterializeBlock(RowBlock* dst);
   Status InitSubIterators(ScanSpec *spec);
 
+  // Returns true if the next row of 'a' sorts before the next row of 'b'.
+  // Rows with equal keys are ordered by the position of their iterators.
+  bool RowLess(MergeIterState* a, MergeIterState* b) const;
+
+  // Move the iterator at position 'idx' of 'heap_' down until neither of its
+  // children has a smaller next row.
+  void SiftDown(size_t idx);
+
   const Schema schema_;
 
+  gscoped_ptr<RowComparator> comparator_;
+
   bool initted_;
 
   // Holds the subiterators until Init is called.
@@ -70,6 +88,14 @@ class MergeIterator : public RowwiseIterator {
   std::deque<std::shared_ptr<RowwiseIterator> > orig_iters_;
   std::vector<std::shared_ptr<MergeIterState> > iters_;
 
+  // The sub-iterators which have rows left, as a binary min-heap ordered by
+  // RowLess(). Owned by 'iters_'.
+  //
+  // With many inputs, e.g. an ordered scan over a tablet with many rowsets,
+  // this makes finding the smallest row logarithmic rather than linear in
+  // the number of inputs.
+  std::vector<MergeIterState*> heap_;
+
   // When the underlying iterators are initialized, each needs its own
   // copy of the scan spec in order to do its own pushdown calculations, etc.
   // The copies are allocated from this pool so they can be automatically freed
@@ -136,7 +162,8 @@ class UnionIterator : public RowwiseIterator {
 // Predicates which only apply to a single column are pushed down into this iterator.
 // While materializing a block, columns with associated predicates are materialized
 // first, and the predicates evaluated. If the predicates succeed in filtering out
-// an entire batch, then other columns may avoid doing any IO.
+// an entire batch, then other columns may avoid doing any IO. Otherwise, the
+// remaining columns only decode the rows which are still selected.
 class MaterializingIterator : public RowwiseIterator {
  public:
   explicit MaterializingIterator(std::shared_ptr<ColumnwiseIterator> iter);
@@ -164,15 +191,37 @@ class MaterializingIterator : public RowwiseIterator {
 
   Status MaterializeBlock(RowBlock *dst);
 
+  // Pushes down 'pred', merging it with any predicate already pushed down on
+  // the same column.
+  void AddColumnPredicate(size_t col_idx, ColumnPredicate pred);
+
   std::shared_ptr<ColumnwiseIterator> iter_;
 
+  // Range predicates which have no equivalent ColumnPredicate.
   std::unordered_multimap<size_t, ColumnRangePredicate> preds_by_column_;
 
+  // Column predicates, keyed by the projected column index. Range predicates
+  // are turned into column predicates where possible, so that they benefit
+  // from zone maps and evaluation on the encoded data too.
+  std::unordered_map<size_t, ColumnPredicate> column_preds_by_column_;
+
+  // Holds the bounds of the column predicates which range predicates were
+  // turned into.
+  Arena arena_;
+
   // The order in which the columns will be materialized.
   std::vector<size_t> materialization_order_;
 
   // Set only by test code to disallow pushdown.
   bool disallow_pushdown_for_tests_;
+
+  // Whether columns materialized after a predicate has been evaluated should
+  // only decode the rows which are still selected.
+  bool decode_selected_only_;
+
+  // Whether the zone maps of the underlying data should be used to rule out
+  // rows before any columns are materialized.
+  bool use_zone_maps_;
 };
 
 
@@ -187,12 +236,14 @@ class PredicateEvaluatingIterator : public RowwiseIterator {
   // the original iterator and accepts all predicates on its behalf.
   //
   // POSTCONDITION: spec->predicates().empty()
+  // POSTCONDITION: spec->column_predicates().empty()
   // POSTCONDITION: base_iter and its wrapper are initialized
   static Status InitAndMaybeWrap(std::shared_ptr<RowwiseIterator> *base_iter,
                                  ScanSpec *spec);
 
   // Initialize the iterator.
   // POSTCONDITION: spec->predicates().empty()
+  // POSTCONDITION: spec->column_predicates().empty()
   Status Init(ScanSpec *spec) OVERRIDE;
 
   virtual Status NextBlock(RowBlock *dst) OVERRIDE;
@@ -220,6 +271,7 @@ class PredicateEvaluatingIterator : public RowwiseIterator {
 
   std::shared_ptr<RowwiseIterator> base_iter_;
   std::vector<ColumnRangePredicate> predicates_;
+  std::vector<ColumnPredicate> column_predicates_;
 };
 
 } // namespace kudu
@@ -30,6 +30,7 @@
 namespace kudu {
 
 class Arena;
+class ColumnPredicate;
 class RowBlock;
 class ScanSpec;
 
@@ -99,6 +100,78 @@ class ColumnwiseIterator : public virtual IteratorBase {
   // arena, if non-null.
   virtual Status MaterializeColumn(size_t col_idx, ColumnBlock *dst) = 0;
 
+  // Same as MaterializeColumn(), except that only the rows which are set in
+  // 'sel' are guaranteed to be materialized. The cells of unselected rows are
+  // left in an undefined state (though nullable cells will read as NULL), so
+  // callers must not look at them.
+  //
+  // This is used once predicates have been evaluated on some columns, so that
+  // the remaining columns need not decode rows which have already been
+  // filtered out.
+  //
+  // The default implementation materializes every row.
+  virtual Status MaterializeColumnSelected(size_t col_idx,
+                                          const SelectionVector& sel,
+                                          ColumnBlock *dst) {
+    return MaterializeColumn(col_idx, dst);
+  }
+
+  // Same as MaterializeColumn(), except that only the null bitmap of 'dst'
+  // is guaranteed to be materialized. The cells themselves are left in an
+  // undefined state. The column may be materialized again afterwards, e.g.
+  // with MaterializeColumnSelected().
+  //
+  // This is used to evaluate IS NULL and IS NOT NULL predicates without
+  // decoding the values of the column.
+  //
+  // The default implementation materializes every row.
+  virtual Status MaterializeColumnNullBitmap(size_t col_idx, ColumnBlock *dst) {
+    return MaterializeColumn(col_idx, dst);
+  }
+
+  // Same as MaterializeColumnSelected(), except that 'pred', a predicate on
+  // the given column, is evaluated while the column is decoded, against its
+  // encoded form where possible (e.g. against dictionary codes). The bits in
+  // 'sel' of the rows which do not match are cleared, and their cells need
+  // not be materialized.
+  //
+  // Sets '*evaluated' to false if the predicate could not be evaluated this
+  // way, in which case the caller must evaluate it on the materialized
+  // column itself.
+  //
+  // The default implementation never evaluates the predicate.
+  virtual Status MaterializeColumnAndEvaluate(size_t col_idx, const ColumnPredicate& pred,
+                                              SelectionVector *sel, ColumnBlock *dst,
+                                              bool *evaluated) {
+    *evaluated = false;
+    return MaterializeColumnSelected(col_idx, *sel, dst);
+  }
+
+  // Clear the bits in 'sel' of the rows in the current batch which 'pred',
+  // a predicate on the given column, cannot match according to per-block
+  // statistics of the underlying data, such as zone maps. This does not
+  // read the column itself, so if no rows are left selected, the batch need
+  // not be materialized at all.
+  //
+  // The default implementation clears nothing.
+  virtual Status EvaluateZoneMaps(size_t col_idx, const ColumnPredicate& pred,
+                                  SelectionVector *sel) {
+    return Status::OK();
+  }
+
+  // If the given column, as materialized in the current batch, is also stored
+  // in the same in-memory format by the underlying data, e.g. in a cached data
+  // block, sets '*pinned' to those cells and returns true. They hold the same
+  // values as the materialized column for every row which it materialized.
+  //
+  // This lets callers send the cells on, e.g. as an RPC sidecar, without
+  // copying them. Must be called after the column was materialized.
+  //
+  // The default implementation returns false.
+  virtual bool GetPinnedCells(size_t col_idx, PinnedCells* pinned) {
+    return false;
+  }
+
   // Finish the current batch.
   virtual Status FinishBatch() = 0;
 
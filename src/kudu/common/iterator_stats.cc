@@ -27,37 +27,74 @@ using strings::Substitute;
 
 IteratorStats::IteratorStats()
     : data_blocks_read_from_disk(0),
+      data_blocks_prefetched(0),
       bytes_read_from_disk(0),
-      cells_read_from_disk(0) {
+      cells_read_from_disk(0),
+      rowsets_pruned_by_bloom(0),
+      rows_pruned_by_zone_map(0),
+      rowsets_pruned_by_zone_map(0),
+      cells_evaluated_on_dict_codes(0) {
 }
 
 string IteratorStats::ToString() const {
   return Substitute("data_blocks_read_from_disk=$0 "
-                    "bytes_read_from_disk=$1 "
-                    "cells_read_from_disk=$2",
+                    "data_blocks_prefetched=$1 "
+                    "bytes_read_from_disk=$2 "
+                    "cells_read_from_disk=$3 "
+                    "rowsets_pruned_by_bloom=$4 "
+                    "rows_pruned_by_zone_map=$5 "
+                    "rowsets_pruned_by_zone_map=$6 "
+                    "cells_evaluated_on_dict_codes=$7",
                     data_blocks_read_from_disk,
+                    data_blocks_prefetched,
                     bytes_read_from_disk,
-                    cells_read_from_disk);
+                    cells_read_from_disk,
+                    rowsets_pruned_by_bloom,
+                    rows_pruned_by_zone_map,
+                    rowsets_pruned_by_zone_map,
+                    cells_evaluated_on_dict_codes);
+}
+
+double IteratorStats::prefetch_hit_ratio() const {
+  if (data_blocks_read_from_disk == 0) {
+    return 0;
+  }
+  return static_cast<double>(data_blocks_prefetched) / data_blocks_read_from_disk;
 }
 
 void IteratorStats::AddStats(const IteratorStats& other) {
   data_blocks_read_from_disk += other.data_blocks_read_from_disk;
+  data_blocks_prefetched += other.data_blocks_prefetched;
   bytes_read_from_disk += other.bytes_read_from_disk;
   cells_read_from_disk += other.cells_read_from_disk;
+  rowsets_pruned_by_bloom += other.rowsets_pruned_by_bloom;
+  rows_pruned_by_zone_map += other.rows_pruned_by_zone_map;
+  rowsets_pruned_by_zone_map += other.rowsets_pruned_by_zone_map;
+  cells_evaluated_on_dict_codes += other.cells_evaluated_on_dict_codes;
   DCheckNonNegative();
 }
 
 void IteratorStats::SubtractStats(const IteratorStats& other) {
   data_blocks_read_from_disk -= other.data_blocks_read_from_disk;
+  data_blocks_prefetched -= other.data_blocks_prefetched;
   bytes_read_from_disk -= other.bytes_read_from_disk;
   cells_read_from_disk -= other.cells_read_from_disk;
+  rowsets_pruned_by_bloom -= other.rowsets_pruned_by_bloom;
+  rows_pruned_by_zone_map -= other.rows_pruned_by_zone_map;
+  rowsets_pruned_by_zone_map -= other.rowsets_pruned_by_zone_map;
+  cells_evaluated_on_dict_codes -= other.cells_evaluated_on_dict_codes;
   DCheckNonNegative();
 }
 
 void IteratorStats::DCheckNonNegative() const {
   DCHECK_GE(data_blocks_read_from_disk, 0);
+  DCHECK_GE(data_blocks_prefetched, 0);
   DCHECK_GE(bytes_read_from_disk, 0);
   DCHECK_GE(cells_read_from_disk, 0);
+  DCHECK_GE(rowsets_pruned_by_bloom, 0);
+  DCHECK_GE(rows_pruned_by_zone_map, 0);
+  DCHECK_GE(rowsets_pruned_by_zone_map, 0);
+  DCHECK_GE(cells_evaluated_on_dict_codes, 0);
 }
 
 
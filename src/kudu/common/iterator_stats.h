@@ -27,9 +27,17 @@ struct IteratorStats {
 
   std::string ToString() const;
 
+  // Returns the fraction of the data blocks read by the iterator which had
+  // already been read ahead, or 0 if no data blocks were read.
+  double prefetch_hit_ratio() const;
+
   // The number of data blocks read from disk (or cache) by the iterator.
   int64_t data_blocks_read_from_disk;
 
+  // The number of those data blocks which had already been read ahead in the
+  // background by the time the iterator needed them.
+  int64_t data_blocks_prefetched;
+
   // The number of bytes read from disk (or cache) by the iterator.
   int64_t bytes_read_from_disk;
 
@@ -37,6 +45,23 @@ struct IteratorStats {
   // they were decoded/materialized.
   int64_t cells_read_from_disk;
 
+  // The number of rowsets which were skipped without being read because the
+  // scan was bounded to a single primary key which their bloom filters ruled
+  // out.
+  int64_t rowsets_pruned_by_bloom;
+
+  // The number of rows which were ruled out by the zone maps of the data
+  // blocks they belong to, without being read.
+  int64_t rows_pruned_by_zone_map;
+
+  // The number of rowsets which were skipped without being read because
+  // their zone maps showed that no rows could match the scan's predicates.
+  int64_t rowsets_pruned_by_zone_map;
+
+  // The number of cells against which a predicate was evaluated on their
+  // dictionary codes, without copying their strings.
+  int64_t cells_evaluated_on_dict_codes;
+
   // Add statistics contained 'other' to this object (for each field
   // in this object, increment it by the value of the equivalent field
   // in 'other').
@@ -66,6 +66,20 @@ class TestRangePredicateEncoder : public KuduTest {
     spec->AddPredicate(pred);
   }
 
+  template<class T>
+  void AddInListPredicate(ScanSpec* spec, StringPiece col, const vector<T>& vals) {
+    int idx = schema_.find_column(col);
+    CHECK_GE(idx, 0);
+
+    vector<const void*> values;
+    for (T val : vals) {
+      void* val_void = arena_.AllocateBytes(sizeof(val));
+      memcpy(val_void, &val, sizeof(val));
+      values.push_back(val_void);
+    }
+    spec->AddPredicate(ColumnPredicate::InList(schema_.column(idx), &values));
+  }
+
 
  protected:
   Arena arena_;
@@ -151,6 +165,37 @@ TEST_F(CompositeIntKeysTest, TestNonPrefix) {
             spec.ToStringWithSchema(schema_));
 }
 
+// Test that an IN list on the first key column bounds the key range, but is
+// still evaluated since the range includes keys which are not in the list.
+//
+// Predicate: a IN (10, 3, 7)
+TEST_F(CompositeIntKeysTest, TestPrefixInList) {
+  ScanSpec spec;
+  AddInListPredicate<uint8_t>(&spec, "a", { 10, 3, 7 });
+  SCOPED_TRACE(spec.ToStringWithSchema(schema_));
+  ASSERT_NO_FATAL_FAILURE(enc_.EncodeRangePredicates(&spec, true));
+  EXPECT_EQ("PK >= (uint8 a=3, uint8 b=0, uint8 c=0) AND "
+            "PK < (uint8 a=11, uint8 b=0, uint8 c=0)\n"
+            "`a` IN (3, 7, 10)",
+            spec.ToStringWithSchema(schema_));
+}
+
+// Test that an IN list with a single value acts as an equality on the key
+// prefix, allowing a range on the following key column to be pushed.
+//
+// Predicate: a IN (5) AND b >= 3
+TEST_F(CompositeIntKeysTest, TestPrefixSingleValueInList) {
+  ScanSpec spec;
+  AddInListPredicate<uint8_t>(&spec, "a", { 5 });
+  AddPredicate<uint8_t>(&spec, "b", GE, 3);
+  SCOPED_TRACE(spec.ToStringWithSchema(schema_));
+  ASSERT_NO_FATAL_FAILURE(enc_.EncodeRangePredicates(&spec, true));
+  EXPECT_EQ("PK >= (uint8 a=5, uint8 b=3, uint8 c=0) AND "
+            "PK < (uint8 a=6, uint8 b=0, uint8 c=0)\n"
+            "`a` = 5",
+            spec.ToStringWithSchema(schema_));
+}
+
 // Test what happens when an upper bound on a cell is equal to the maximum
 // value for the cell. In this case, the preceding cell is also at the maximum
 // value as well, so we eliminate the upper bound entirely.
@@ -170,6 +170,32 @@ void RangePredicateEncoder::EncodeRangePredicates(ScanSpec *spec, bool erase_pus
   }
 }
 
+namespace {
+
+// Tightens the inclusive bounds '*lower' and '*upper' of a column to include
+// 'lower_bound' and 'upper_bound', either of which may be NULL.
+void TightenBounds(const ColumnSchema& col,
+                   const void* lower_bound, const void* upper_bound,
+                   const void** lower, const void** upper) {
+  if (upper_bound != nullptr) {
+    // If we haven't seen any upper bound, or this upper bound is tighter than
+    // (less than) the one we've seen already, replace it.
+    if (*upper == nullptr || col.type_info()->Compare(upper_bound, *upper) < 0) {
+      *upper = upper_bound;
+    }
+  }
+
+  if (lower_bound != nullptr) {
+    // If we haven't seen any lower bound, or this lower bound is tighter than
+    // (greater than) the one we've seen already, replace it.
+    if (*lower == nullptr || col.type_info()->Compare(lower_bound, *lower) > 0) {
+      *lower = lower_bound;
+    }
+  }
+}
+
+} // anonymous namespace
+
 void RangePredicateEncoder::SimplifyBounds(const ScanSpec& spec,
                                            vector<SimplifiedBounds>* key_bounds) const {
   key_bounds->clear();
@@ -187,24 +213,32 @@ void RangePredicateEncoder::SimplifyBounds(const ScanSpec& spec,
     CHECK(pred.range().has_lower_bound() || pred.range().has_upper_bound());
     (*key_bounds)[idx].orig_predicate_indexes.push_back(i);
 
-    if (pred.range().has_upper_bound()) {
-      // If we haven't seen any upper bound, or this upper bound is tighter than
-      // (less than) the one we've seen already, replace it.
-      if ((*key_bounds)[idx].upper == nullptr ||
-          col.type_info()->Compare(pred.range().upper_bound(),
-                                   (*key_bounds)[idx].upper) < 0) {
-        (*key_bounds)[idx].upper = pred.range().upper_bound();
-      }
+    TightenBounds(col, pred.range().lower_bound(), pred.range().upper_bound(),
+                  &(*key_bounds)[idx].lower, &(*key_bounds)[idx].upper);
+  }
+
+  // Equality and IN list column predicates on key columns also bound the key
+  // range: an IN list can only match keys between its smallest and largest
+  // values. These predicates are never erased from the spec, since the key
+  // range does not exclude the keys between the listed values.
+  for (const ColumnPredicate& pred : spec.column_predicates()) {
+    int idx = key_schema_->find_column(pred.column().name());
+    if (idx == -1 || idx >= key_bounds->size()) {
+      continue;
     }
+    const ColumnSchema& col = key_schema_->column(idx);
 
-    if (pred.range().has_lower_bound()) {
-      // If we haven't seen any lower bound, or this lower bound is tighter than
-      // (greater than) the one we've seen already, replace it.
-      if ((*key_bounds)[idx].lower == nullptr ||
-          col.type_info()->Compare(pred.range().lower_bound(),
-                                   (*key_bounds)[idx].lower) > 0) {
-        (*key_bounds)[idx].lower = pred.range().lower_bound();
-      }
+    switch (pred.predicate_type()) {
+      case PredicateType::Equality:
+        TightenBounds(col, pred.raw_lower(), pred.raw_lower(),
+                      &(*key_bounds)[idx].lower, &(*key_bounds)[idx].upper);
+        break;
+      case PredicateType::InList:
+        TightenBounds(col, pred.raw_values().front(), pred.raw_values().back(),
+                      &(*key_bounds)[idx].lower, &(*key_bounds)[idx].upper);
+        break;
+      default:
+        break;
     }
   }
 }
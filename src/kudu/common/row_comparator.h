@@ -0,0 +1,70 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef KUDU_COMMON_ROW_COMPARATOR_H
+#define KUDU_COMMON_ROW_COMPARATOR_H
+
+#include "kudu/common/row.h"
+#include "kudu/common/rowblock.h"
+#include "kudu/common/schema.h"
+#include "kudu/gutil/macros.h"
+#include "kudu/util/status.h"
+
+namespace kudu {
+
+class Arena;
+
+// Compares the keys of rows of a given schema, and copies such rows, where
+// the rows are held in RowBlocks. Used by the merges of ordered scans and
+// compactions, which do both for every row they produce.
+//
+// This implementation interprets the schema, exactly like Schema::Compare()
+// and CopyRow(). codegen::RowComparator overrides both with code generated
+// for the types of the schema, which avoids branching on the type of every
+// cell.
+class RowComparator {
+ public:
+  // Requires that 'schema' remain valid for the lifetime of this object.
+  explicit RowComparator(const Schema* schema)
+    : schema_(schema) {
+  }
+
+  virtual ~RowComparator() {}
+
+  // Compares the keys of the two rows, which must have the types of the
+  // schema of this comparator. Returns the same as Schema::Compare().
+  virtual int Compare(const RowBlockRow& lhs, const RowBlockRow& rhs) const {
+    return schema_->Compare(lhs, rhs);
+  }
+
+  // Copies all the cells of 'src' into 'dst', which must have the types of
+  // the schema of this comparator. Indirect data is relocated into
+  // 'dst_arena' unless it is NULL. Same as CopyRow().
+  virtual Status Copy(const RowBlockRow& src, RowBlockRow* dst, Arena* dst_arena) const {
+    return CopyRow(src, dst, dst_arena);
+  }
+
+  const Schema* schema() const { return schema_; }
+
+ private:
+  const Schema* const schema_;
+
+  DISALLOW_COPY_AND_ASSIGN(RowComparator);
+};
+
+} // namespace kudu
+
+#endif
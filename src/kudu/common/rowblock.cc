@@ -82,7 +82,9 @@ RowBlock::RowBlock(const Schema &schema,
     row_capacity_(nrows),
     nrows_(nrows),
     arena_(arena),
-    sel_vec_(nrows) {
+    sel_vec_(nrows),
+    pin_cells_(false),
+    has_pinned_cells_(false) {
   CHECK_GT(row_capacity_, 0);
 
   size_t bitmap_size = BitmapSize(row_capacity_);
@@ -110,6 +112,22 @@ void RowBlock::Resize(size_t new_size) {
   CHECK_LE(new_size, row_capacity_);
   nrows_ = new_size;
   sel_vec_.Resize(new_size);
+  if (has_pinned_cells_) {
+    for (PinnedCells& pinned : pinned_cells_) {
+      pinned = PinnedCells();
+    }
+    has_pinned_cells_ = false;
+  }
+}
+
+void RowBlock::SetPinnedCells(size_t col_idx, PinnedCells pinned) {
+  DCHECK(pin_cells_);
+  DCHECK_LT(col_idx, schema_.num_columns());
+  if (pinned_cells_.empty()) {
+    pinned_cells_.resize(schema_.num_columns());
+  }
+  pinned_cells_[col_idx] = std::move(pinned);
+  has_pinned_cells_ = true;
 }
 
 } // namespace kudu
@@ -177,6 +177,13 @@ class RowBlock {
     return columns_data_[col_idx];
   }
 
+  // Return the null bitmap of the given column, or NULL if the column is not
+  // nullable. Like column_data_base_ptr(), this is used by the codegen code.
+  uint8_t* column_null_bitmap_ptr(size_t col_idx) const {
+    DCHECK_LT(col_idx, column_null_bitmaps_.size());
+    return column_null_bitmaps_[col_idx];
+  }
+
   // Return the number of rows in the row block. Note that this includes
   // rows which were filtered out by the selection vector.
   size_t nrows() const { return nrows_; }
@@ -212,6 +219,26 @@ class RowBlock {
     return &sel_vec_;
   }
 
+  // Whether the iterators filling this block should record, for each column
+  // they materialize, the cells of the underlying data that it was copied
+  // from, if those are in the same format. See SetPinnedCells().
+  void set_pin_cells(bool pin_cells) { pin_cells_ = pin_cells; }
+  bool pin_cells() const { return pin_cells_; }
+
+  // Records that column 'col_idx' holds the same values as 'pinned.cells' for
+  // every one of its rows, so that they may be sent on without copying them.
+  // The record is dropped when the block is resized.
+  void SetPinnedCells(size_t col_idx, PinnedCells pinned);
+
+  // Returns the cells recorded for column 'col_idx' with SetPinnedCells(), or
+  // NULL if there are none.
+  const PinnedCells* pinned_cells(size_t col_idx) const {
+    if (!has_pinned_cells_ || pinned_cells_[col_idx].pin == nullptr) {
+      return NULL;
+    }
+    return &pinned_cells_[col_idx];
+  }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(RowBlock);
 
@@ -244,6 +271,12 @@ class RowBlock {
   // Deleted rows or rows which have failed to pass predicates will be zeroed
   // in the bitmap, and thus not returned to the end user.
   SelectionVector sel_vec_;
+
+  bool pin_cells_;
+
+  // Indexed by column, if any were recorded since the block was last resized.
+  std::vector<PinnedCells> pinned_cells_;
+  bool has_pinned_cells_;
 };
 
 // Provides an abstraction to interact with a RowBlock row.
@@ -19,6 +19,7 @@
 
 #include <string>
 
+#include "kudu/common/column_predicate_kernels.h"
 #include "kudu/common/rowblock.h"
 #include "kudu/common/types.h"
 #include "kudu/util/bitmap.h"
@@ -68,12 +69,22 @@ void ColumnRangePredicate::Evaluate(RowBlock* block, SelectionVector* vec) const
 
   ColumnBlock cblock(block->column_block(col_idx, block->nrows()));
 
-  // TODO: this is all rather slow, could probably push down all the way
-  // to the TypeInfo so we only make one virtual call, or use codegen.
-  // Not concerned for now -- plan of record is to eventually embed Impala
-  // expression evaluation somewhere here, so this is just a stub.
+  // Evaluate as much of the block as possible using a vectorized kernel.
+  // The remaining rows, and all rows of types without a kernel, go through
+  // the (slower) virtual TypeInfo comparisons below.
+  predicate_kernels::BoundType bound;
+  if (range_.has_lower_bound() && range_.has_upper_bound()) {
+    bound = predicate_kernels::BoundType::kBetweenInclusive;
+  } else if (range_.has_lower_bound()) {
+    bound = predicate_kernels::BoundType::kLower;
+  } else {
+    bound = predicate_kernels::BoundType::kUpperInclusive;
+  }
+  size_t start_row = predicate_kernels::EvaluateVectorized(
+      cblock, bound, range_.lower_bound(), range_.upper_bound(), vec);
+
   if (cblock.is_nullable()) {
-    for (size_t i = 0; i < block->nrows(); i++) {
+    for (size_t i = start_row; i < block->nrows(); i++) {
       if (!vec->IsRowSelected(i)) continue;
       const void *cell = cblock.nullable_cell_ptr(i);
       if (cell == nullptr || !range_.ContainsCell(cell)) {
@@ -81,7 +92,7 @@ void ColumnRangePredicate::Evaluate(RowBlock* block, SelectionVector* vec) const
       }
     }
   } else {
-    for (size_t i = 0; i < block->nrows(); i++) {
+    for (size_t i = start_row; i < block->nrows(); i++) {
       if (!vec->IsRowSelected(i)) continue;
       const void *cell = cblock.cell_ptr(i);
       if (!range_.ContainsCell(cell)) {
@@ -91,6 +102,24 @@ void ColumnRangePredicate::Evaluate(RowBlock* block, SelectionVector* vec) const
   }
 }
 
+boost::optional<ColumnPredicate> ColumnRangePredicate::ToColumnPredicate(Arena* arena) const {
+  if (range_.IsEquality()) {
+    return ColumnPredicate::Equality(col_, range_.lower_bound());
+  }
+  if (!range_.has_upper_bound()) {
+    return ColumnPredicate::Range(col_, range_.lower_bound(), nullptr);
+  }
+  switch (col_.type_info()->physical_type()) {
+    case FLOAT:
+    case DOUBLE:
+    case BOOL:
+      return boost::none;
+    default:
+      return ColumnPredicate::InclusiveRange(col_, range_.lower_bound(),
+                                             range_.upper_bound(), arena);
+  }
+}
+
 string ColumnRangePredicate::ToString() const {
   if (range_.has_lower_bound() && range_.has_upper_bound()) {
     return StringPrintf("(`%s` BETWEEN %s AND %s)", col_.name().c_str(),
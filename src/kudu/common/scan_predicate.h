@@ -17,10 +17,12 @@
 #ifndef KUDU_COMMON_SCAN_PREDICATE_H
 #define KUDU_COMMON_SCAN_PREDICATE_H
 
+#include <boost/optional.hpp>
 #include <string>
 
 #include <gtest/gtest_prod.h>
 
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/schema.h"
 #include "kudu/util/bitmap.h"
 #include "kudu/util/faststring.h"
@@ -29,6 +31,7 @@ namespace kudu {
 
 using std::string;
 
+class Arena;
 class RowBlock;
 class SelectionVector;
 
@@ -102,6 +105,18 @@ class ColumnRangePredicate {
   // Return the value range for which this predicate passes.
   const ValueRange &range() const { return range_; }
 
+  // Returns the ColumnPredicate which matches the same rows as this
+  // predicate, so that it may be evaluated the ways only ColumnPredicates
+  // are, e.g. with zone maps or on dictionary codes. If the upper bound has
+  // to be made exclusive, the incremented bound is allocated from 'arena',
+  // which must outlive the returned predicate.
+  //
+  // Returns boost::none if there is no such predicate: an inclusive upper
+  // bound can't be made exclusive for floating point and boolean columns,
+  // and a range up to the maximum value also matches all the values but
+  // still filters out nulls.
+  boost::optional<ColumnPredicate> ToColumnPredicate(Arena* arena) const;
+
  private:
   // For Evaluate.
   friend class MaterializingIterator;
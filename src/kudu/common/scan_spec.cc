@@ -18,6 +18,7 @@
 #include "kudu/common/scan_spec.h"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "kudu/gutil/strings/join.h"
@@ -32,6 +33,16 @@ void ScanSpec::AddPredicate(const ColumnRangePredicate &pred) {
   predicates_.push_back(pred);
 }
 
+void ScanSpec::AddPredicate(ColumnPredicate pred) {
+  for (ColumnPredicate& existing : column_predicates_) {
+    if (existing.column().name() == pred.column().name()) {
+      existing.Merge(pred);
+      return;
+    }
+  }
+  column_predicates_.push_back(std::move(pred));
+}
+
 void ScanSpec::SetLowerBoundKey(const EncodedKey* key) {
   if (lower_bound_key_ == nullptr ||
       key->encoded_key().compare(lower_bound_key_->encoded_key()) > 0) {
@@ -85,6 +96,9 @@ string ScanSpec::ToStringWithOptionalSchema(const Schema* s) const {
   for (const ColumnRangePredicate& pred : predicates_) {
     preds.push_back(pred.ToString());
   }
+  for (const ColumnPredicate& pred : column_predicates_) {
+    preds.push_back(pred.ToString());
+  }
   return JoinStrings(preds, "\n");
 }
 
@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/scan_predicate.h"
 #include "kudu/common/encoded_key.h"
 
@@ -41,6 +42,14 @@ class ScanSpec {
 
   void AddPredicate(const ColumnRangePredicate &pred);
 
+  // Add a column predicate which cannot be expressed as a ColumnRangePredicate,
+  // such as an IN list.
+  //
+  // If there is already a column predicate on the same column, the two are
+  // merged. See ColumnPredicate::Merge() for the lifetime requirements this
+  // places on the predicates' values.
+  void AddPredicate(ColumnPredicate pred);
+
   // Set the lower bound (inclusive) primary key for the scan.
   // Does not take ownership of 'key', which must remain valid.
   // If called multiple times, the most restrictive key will be used.
@@ -78,6 +87,20 @@ class ScanSpec {
     return &predicates_;
   }
 
+  // Returns the column predicates in this scan spec. There is at most one
+  // per column.
+  const vector<ColumnPredicate>& column_predicates() const {
+    return column_predicates_;
+  }
+
+  // Return a pointer to the list of column predicates in this scan spec.
+  //
+  // As with mutable_predicates(), this is used during predicate pushdown to
+  // remove predicates which are evaluated lower down the iterator tree.
+  vector<ColumnPredicate>* mutable_column_predicates() {
+    return &column_predicates_;
+  }
+
   const EncodedKey* lower_bound_key() const {
     return lower_bound_key_;
   }
@@ -108,6 +131,7 @@ class ScanSpec {
   std::string ToStringWithOptionalSchema(const Schema* s) const;
 
   vector<ColumnRangePredicate> predicates_;
+  vector<ColumnPredicate> column_predicates_;
   const EncodedKey* lower_bound_key_;
   const EncodedKey* exclusive_upper_bound_key_;
   std::string lower_bound_partition_key_;
@@ -20,6 +20,7 @@
 #include "kudu/common/rowblock.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/wire_protocol.h"
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/status.h"
 #include "kudu/util/stopwatch.h"
 #include "kudu/util/test_macros.h"
@@ -209,7 +210,178 @@ TEST_F(WireProtocolTest, TestColumnarRowBlockToPB) {
   }
 }
 
+// Test serializing blocks in the columnar layout, with a projection which
+// reorders the columns, unselected rows, and NULLs.
+TEST_F(WireProtocolTest, TestRowBlockToColumnarBatch) {
+  Schema projection({ ColumnSchema("col3", UINT32, true /* nullable */),
+                      ColumnSchema("col1", STRING) },
+                    0);
+  Arena arena(1024, 1024 * 1024);
+  RowBlock block(schema_, 10, &arena);
+  ColumnarSerializedBatch batch;
+
+  // Serialize two blocks, so that the second is appended to the first at an
+  // offset which is not a multiple of 8 rows.
+  vector<string> expected_col1;
+  vector<int> expected_col3;  // -1 for NULL.
+  for (int b = 0; b < 2; b++) {
+    FillRowBlockWithTestRows(&block);
+    for (int i = 0; i < block.nrows(); i++) {
+      RowBlockRow row = block.row(i);
+      string val = strings::Substitute("val $0-$1", b, i);
+      ASSERT_TRUE(arena.RelocateSlice(val, reinterpret_cast<Slice*>(row.mutable_cell_ptr(0))));
+      if (i % 3 == 0) {
+        row.cell(2).set_null(true);
+      }
+      if (b == 0 && i % 4 == 1) {
+        block.selection_vector()->SetRowUnselected(i);
+        continue;
+      }
+      expected_col1.push_back(val);
+      expected_col3.push_back(i % 3 == 0 ? -1 : i);
+    }
+    SerializeRowBlockColumnar(block, &projection, &batch);
+  }
+
+  int num_rows = expected_col1.size();
+  ASSERT_EQ(num_rows, batch.num_rows);
+  ASSERT_EQ(2, batch.columns.size());
+
+  // col3: fixed-length and nullable.
+  const ColumnarSerializedBatch::Column& col3 = batch.columns[0];
+  ASSERT_FALSE(col3.varlen_data);
+  ASSERT_TRUE(col3.non_null_bitmap);
+  ASSERT_EQ(num_rows * sizeof(uint32_t), col3.data->size());
+  ASSERT_GE(col3.non_null_bitmap->size(), BitmapSize(num_rows));
+  const uint32_t* col3_data = reinterpret_cast<const uint32_t*>(col3.data->data());
+  for (int i = 0; i < num_rows; i++) {
+    SCOPED_TRACE(i);
+    if (expected_col3[i] == -1) {
+      EXPECT_FALSE(BitmapTest(col3.non_null_bitmap->data(), i));
+    } else {
+      EXPECT_TRUE(BitmapTest(col3.non_null_bitmap->data(), i));
+      EXPECT_EQ(static_cast<uint32_t>(expected_col3[i]), col3_data[i]);
+    }
+  }
+
+  // col1: variable-length and not nullable.
+  const ColumnarSerializedBatch::Column& col1 = batch.columns[1];
+  ASSERT_TRUE(col1.varlen_data);
+  ASSERT_FALSE(col1.non_null_bitmap);
+  ASSERT_EQ((num_rows + 1) * sizeof(uint32_t), col1.data->size());
+  const uint32_t* offsets = reinterpret_cast<const uint32_t*>(col1.data->data());
+  ASSERT_EQ(0U, offsets[0]);
+  ASSERT_EQ(col1.varlen_data->size(), offsets[num_rows]);
+  for (int i = 0; i < num_rows; i++) {
+    Slice val(col1.varlen_data->data() + offsets[i], offsets[i + 1] - offsets[i]);
+    EXPECT_EQ(expected_col1[i], val.ToString());
+  }
+}
+
+// Test that the pinned cells of fully selected row blocks are referenced by
+// the columnar batch rather than copied, up to its limit of chunks.
+TEST_F(WireProtocolTest, TestPinnedCellsToColumnarBatch) {
+  Schema schema({ ColumnSchema("key", UINT32) }, 1);
+  Arena arena(1024, 1024 * 1024);
+  const int kRowsPerBlock = 10;
+  RowBlock block(schema, kRowsPerBlock, &arena);
+  block.set_pin_cells(true);
+  ColumnarSerializedBatch batch;
+  batch.max_data_chunks = 3;
+
+  // The data from which the cells are pinned, e.g. a data block.
+  std::shared_ptr<vector<uint32_t>> pinned_data(new vector<uint32_t>());
+  for (uint32_t i = 0; i < 6 * kRowsPerBlock; i++) {
+    pinned_data->push_back(i);
+  }
+
+  // Serializes rows [start, start + kRowsPerBlock) of 'pinned_data', pinning
+  // them if 'pin' is true, and not selecting the first row if 'skip_first'.
+  vector<uint32_t> expected;
+  auto serialize = [&](int start, bool pin, bool skip_first) {
+    block.Resize(kRowsPerBlock);
+    ASSERT_TRUE(block.pinned_cells(0) == nullptr);
+    block.selection_vector()->SetAllTrue();
+    for (int i = 0; i < kRowsPerBlock; i++) {
+      uint32_t val = (*pinned_data)[start + i];
+      memcpy(block.row(i).mutable_cell_ptr(0), &val, sizeof(val));
+      if (i == 0 && skip_first) {
+        block.selection_vector()->SetRowUnselected(i);
+      } else {
+        expected.push_back(val);
+      }
+    }
+    if (pin) {
+      Slice cells(reinterpret_cast<const uint8_t*>(&(*pinned_data)[start]),
+                  kRowsPerBlock * sizeof(uint32_t));
+      block.SetPinnedCells(0, { cells, pinned_data });
+    }
+    SerializeRowBlockColumnar(block, nullptr, &batch);
+  };
+
+  // Consecutive pinned cells are merged into a single chunk.
+  NO_FATALS(serialize(0, true, false));
+  NO_FATALS(serialize(10, true, false));
+  const ColumnarSerializedBatch::Column& col = batch.columns[0];
+  ASSERT_EQ(1, col.data_chunks.size());
+  ASSERT_EQ(0, col.data->size());
+  ASSERT_EQ(pinned_data->data(), reinterpret_cast<const uint32_t*>(col.data_chunks[0].cells.data()));
+
+  // Cells which are not pinned are copied, and become a chunk of their own
+  // once pinned cells follow them.
+  NO_FATALS(serialize(20, false, false));
+  NO_FATALS(serialize(30, true, false));
+  ASSERT_EQ(3, col.data_chunks.size());
+  ASSERT_EQ(0, col.data->size());
+
+  // Cells of blocks whose rows are not all selected are copied, and so are
+  // pinned cells past the limit of chunks.
+  NO_FATALS(serialize(40, true, true));
+  NO_FATALS(serialize(50, true, false));
+  ASSERT_EQ(3, col.data_chunks.size());
+  ASSERT_EQ((2 * kRowsPerBlock - 1) * sizeof(uint32_t), col.data->size());
+
+  faststring joined;
+  for (const PinnedCells& chunk : col.data_chunks) {
+    joined.append(chunk.cells.data(), chunk.cells.size());
+  }
+  joined.append(col.data->data(), col.data->size());
+  ASSERT_EQ(expected.size(), batch.num_rows);
+  ASSERT_EQ(expected.size() * sizeof(uint32_t), joined.size());
+  ASSERT_EQ(0, memcmp(expected.data(), joined.data(), joined.size()));
+}
+
+// Test serializing a block with no columns in the columnar layout.
+TEST_F(WireProtocolTest, TestBlockWithNoColumnsToColumnarBatch) {
+  Schema empty(std::vector<ColumnSchema>(), 0);
+  Arena arena(1024, 1024 * 1024);
+  RowBlock block(empty, 1000, &arena);
+  block.selection_vector()->SetAllTrue();
+  for (int i = 0; i < 100; i++) {
+    block.selection_vector()->SetRowUnselected(i * 2);
+  }
+
+  ColumnarSerializedBatch batch;
+  SerializeRowBlockColumnar(block, nullptr, &batch);
+  ASSERT_EQ(900, batch.num_rows);
+  ASSERT_TRUE(batch.columns.empty());
+}
+
 #ifdef NDEBUG
+TEST_F(WireProtocolTest, TestRowBlockToColumnarBatchBenchmark) {
+  Arena arena(1024, 1024 * 1024);
+  const int kNumTrials = AllowSlowTests() ? 100 : 10;
+  RowBlock block(schema_, 10000 * kNumTrials, &arena);
+  FillRowBlockWithTestRows(&block);
+
+  LOG_TIMING(INFO, "Converting to columnar batch") {
+    for (int i = 0; i < kNumTrials; i++) {
+      ColumnarSerializedBatch batch;
+      SerializeRowBlockColumnar(block, NULL, &batch);
+    }
+  }
+}
+
 TEST_F(WireProtocolTest, TestColumnarRowBlockToPBBenchmark) {
   Arena arena(1024, 1024 * 1024);
   const int kNumTrials = AllowSlowTests() ? 100 : 10;
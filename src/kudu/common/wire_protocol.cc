@@ -17,6 +17,7 @@
 
 #include "kudu/common/wire_protocol.h"
 
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -557,4 +558,187 @@ void SerializeRowBlock(const RowBlock& block, RowwiseRowBlockPB* rowblock_pb,
   rowblock_pb->set_num_rows(rowblock_pb->num_rows() + num_rows);
 }
 
+// Copy the cells of the selected rows of a fixed-length column to the end of
+// 'dst'. Runs of selected rows are copied with a single memcpy each.
+static void CopyFixedLengthCells(const ColumnBlock& cblock, const SelectionVector& sel,
+                                 size_t num_selected, faststring* dst) {
+  size_t cell_size = cblock.stride();
+  size_t old_size = dst->size();
+  dst->resize(old_size + num_selected * cell_size);
+  uint8_t* out = dst->data() + old_size;
+  const uint8_t* src = cblock.data();
+
+  if (num_selected == cblock.nrows()) {
+    memcpy(out, src, num_selected * cell_size);
+    return;
+  }
+  BitmapIterator selected_row_iter(sel.bitmap(), cblock.nrows());
+  size_t run_size;
+  bool selected;
+  while ((run_size = selected_row_iter.Next(&selected))) {
+    if (selected) {
+      memcpy(out, src, run_size * cell_size);
+      out += run_size * cell_size;
+    }
+    src += run_size * cell_size;
+  }
+}
+
+// Reference 'pinned', the cells of all the rows of a row block, after the
+// cells already in 'dst'. Returns false if it would take more than
+// 'max_chunks' chunks, in which case the cells must be copied instead.
+static bool AppendPinnedCells(const PinnedCells& pinned, int max_chunks,
+                              ColumnarSerializedBatch::Column* dst) {
+  // The cells of consecutive row blocks are usually consecutive cells of the
+  // same data block.
+  if (dst->data->size() == 0 && !dst->data_chunks.empty()) {
+    PinnedCells* last = &dst->data_chunks.back();
+    if (last->pin == pinned.pin &&
+        last->cells.data() + last->cells.size() == pinned.cells.data()) {
+      last->cells = Slice(last->cells.data(), last->cells.size() + pinned.cells.size());
+      return true;
+    }
+  }
+
+  // The cells copied so far become a chunk of their own.
+  int num_new_chunks = dst->data->size() > 0 ? 2 : 1;
+  if (static_cast<int>(dst->data_chunks.size()) + num_new_chunks > max_chunks) {
+    return false;
+  }
+  if (dst->data->size() > 0) {
+    Slice copied(dst->data->data(), dst->data->size());
+    dst->data_chunks.push_back({ copied, std::shared_ptr<const void>(dst->data.release()) });
+    dst->data.reset(new faststring());
+  }
+  dst->data_chunks.push_back(pinned);
+  return true;
+}
+
+// Copy the values of the selected rows of a variable-length column to the
+// end of 'varlen_data', and append the offset at which each value ends to
+// 'offsets'. NULL cells are empty.
+//
+// IS_NULLABLE: true if the column is nullable
+template<bool IS_NULLABLE>
+static void CopyVarlenCells(const ColumnBlock& cblock, const SelectionVector& sel,
+                            faststring* offsets, faststring* varlen_data) {
+  const Slice* cells = reinterpret_cast<const Slice*>(cblock.data());
+  BitmapIterator selected_row_iter(sel.bitmap(), cblock.nrows());
+  size_t run_size;
+  bool selected;
+  size_t row_idx = 0;
+  while ((run_size = selected_row_iter.Next(&selected))) {
+    if (!selected) {
+      row_idx += run_size;
+      continue;
+    }
+    for (size_t end = row_idx + run_size; row_idx < end; row_idx++) {
+      if (!IS_NULLABLE || !cblock.is_null(row_idx)) {
+        varlen_data->append(cells[row_idx].data(), cells[row_idx].size());
+      }
+      DCHECK_LE(varlen_data->size(), std::numeric_limits<uint32_t>::max());
+      uint32_t end_offset = varlen_data->size();
+      offsets->append(&end_offset, sizeof(end_offset));
+    }
+  }
+}
+
+// Copy the non-null bits of the selected rows of a nullable column into
+// 'dst', a bitmap which already holds the bits of 'dst_row' rows.
+static void CopyNonNullBitmap(const ColumnBlock& cblock, const SelectionVector& sel,
+                              size_t num_selected, int64_t dst_row, faststring* dst) {
+  size_t old_size = dst->size();
+  dst->resize(BitmapSize(dst_row + num_selected));
+  memset(dst->data() + old_size, 0, dst->size() - old_size);
+
+  if (num_selected == cblock.nrows() && dst_row % 8 == 0) {
+    // The bitmap can be copied byte by byte.
+    memcpy(dst->data() + dst_row / 8, cblock.null_bitmap(), BitmapSize(num_selected));
+    return;
+  }
+  BitmapIterator selected_row_iter(sel.bitmap(), cblock.nrows());
+  size_t run_size;
+  bool selected;
+  size_t row_idx = 0;
+  while ((run_size = selected_row_iter.Next(&selected))) {
+    if (!selected) {
+      row_idx += run_size;
+      continue;
+    }
+    for (size_t end = row_idx + run_size; row_idx < end; row_idx++) {
+      BitmapChange(dst->data(), dst_row++, !cblock.is_null(row_idx));
+    }
+  }
+}
+
+// Because we use a faststring here, ASAN tests become unbearably slow
+// with the extra verifications.
+ATTRIBUTE_NO_ADDRESS_SAFETY_ANALYSIS
+void SerializeRowBlockColumnar(const RowBlock& block,
+                               const Schema* projection_schema,
+                               ColumnarSerializedBatch* batch) {
+  const Schema& tablet_schema = block.schema();
+  if (projection_schema == nullptr) {
+    projection_schema = &tablet_schema;
+  }
+
+  if (batch->columns.empty()) {
+    batch->columns.resize(projection_schema->num_columns());
+    for (int i = 0; i < projection_schema->num_columns(); i++) {
+      const ColumnSchema& col = projection_schema->column(i);
+      ColumnarSerializedBatch::Column* dst = &batch->columns[i];
+      dst->data.reset(new faststring());
+      if (col.type_info()->physical_type() == BINARY) {
+        dst->varlen_data.reset(new faststring());
+        // The offset at which the first value starts.
+        uint32_t zero = 0;
+        dst->data->append(&zero, sizeof(zero));
+      }
+      if (col.is_nullable()) {
+        dst->non_null_bitmap.reset(new faststring());
+      }
+    }
+  }
+  DCHECK_EQ(batch->columns.size(), projection_schema->num_columns());
+
+  const SelectionVector& sel = *block.selection_vector();
+  size_t num_selected = sel.CountSelected();
+  if (num_selected == 0) {
+    return;
+  }
+
+  for (int proj_schema_idx = 0; proj_schema_idx < projection_schema->num_columns();
+       proj_schema_idx++) {
+    const ColumnSchema& col = projection_schema->column(proj_schema_idx);
+    int t_schema_idx = tablet_schema.find_column(col.name());
+    DCHECK_NE(t_schema_idx, -1) << col.name();
+    ColumnBlock cblock = block.column_block(t_schema_idx);
+    DCHECK_EQ(cblock.is_nullable(), col.is_nullable());
+    ColumnarSerializedBatch::Column* dst = &batch->columns[proj_schema_idx];
+
+    if (dst->varlen_data) {
+      if (cblock.is_nullable()) {
+        CopyVarlenCells<true>(cblock, sel, dst->data.get(), dst->varlen_data.get());
+      } else {
+        CopyVarlenCells<false>(cblock, sel, dst->data.get(), dst->varlen_data.get());
+      }
+    } else {
+      const PinnedCells* pinned = nullptr;
+      if (batch->max_data_chunks > 0 && num_selected == cblock.nrows()) {
+        pinned = block.pinned_cells(t_schema_idx);
+      }
+      if (pinned == nullptr ||
+          pinned->cells.size() != cblock.nrows() * cblock.stride() ||
+          !AppendPinnedCells(*pinned, batch->max_data_chunks, dst)) {
+        CopyFixedLengthCells(cblock, sel, num_selected, dst->data.get());
+      }
+    }
+    if (dst->non_null_bitmap) {
+      CopyNonNullBitmap(cblock, sel, num_selected, batch->num_rows,
+                        dst->non_null_bitmap.get());
+    }
+  }
+  batch->num_rows += num_selected;
+}
+
 } // namespace kudu
@@ -19,16 +19,18 @@
 #ifndef KUDU_COMMON_WIRE_PROTOCOL_H
 #define KUDU_COMMON_WIRE_PROTOCOL_H
 
+#include <memory>
 #include <vector>
 
+#include "kudu/common/columnblock.h"
 #include "kudu/common/wire_protocol.pb.h"
+#include "kudu/util/faststring.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
 
 class ConstContiguousRow;
 class ColumnSchema;
-class faststring;
 class HostPort;
 class RowBlock;
 class RowBlockRow;
@@ -110,6 +112,55 @@ void SerializeRowBlock(const RowBlock& block, RowwiseRowBlockPB* rowblock_pb,
                        const Schema* client_projection_schema,
                        faststring* data_buf, faststring* indirect_data);
 
+// The buffers of a batch of rows serialized in the columnar layout. See
+// ColumnarRowBlockPB for the format of each buffer.
+struct ColumnarSerializedBatch {
+  struct Column {
+    // The cells of a fixed-length column which precede those in 'data'. They
+    // are either pinned cells of the row blocks, which were not copied, or
+    // cells copied into 'data' before those. Always empty for variable-length
+    // columns.
+    std::vector<PinnedCells> data_chunks;
+
+    // The cells of a fixed-length column, or the offsets of the values of a
+    // variable-length column into 'varlen_data'.
+    std::unique_ptr<faststring> data;
+
+    // The values of a variable-length column. NULL for fixed-length columns.
+    std::unique_ptr<faststring> varlen_data;
+
+    // The non-null bitmap of a nullable column. NULL for columns which are not
+    // nullable.
+    std::unique_ptr<faststring> non_null_bitmap;
+  };
+
+  // One entry per column of the projection.
+  std::vector<Column> columns;
+
+  // The number of rows serialized so far.
+  int64_t num_rows = 0;
+
+  // The maximum number of entries of 'data_chunks' per column. If 0, the
+  // pinned cells of the row blocks are ignored, and all cells are copied.
+  int max_data_chunks = 0;
+};
+
+// Encode the given row block into the provided columnar batch, appending to
+// any rows serialized into it previously.
+//
+// Like SerializeRowBlock(), only the selected rows of 'block' are converted,
+// and only the columns of 'client_projection_schema' (or of the block's own
+// schema if it is NULL) are projected. Rather than being transposed into
+// rows, each column is copied straight from the block's ColumnBlocks, so
+// runs of selected fixed-length cells are copied wholesale. If all the rows
+// of the block are selected, the pinned cells of its fixed-length columns, if
+// any, are referenced rather than copied, up to 'batch->max_data_chunks'.
+//
+// The buffers of 'batch' are created on the first call.
+void SerializeRowBlockColumnar(const RowBlock& block,
+                               const Schema* client_projection_schema,
+                               ColumnarSerializedBatch* batch);
+
 // Rewrites the data pointed-to by row data slice 'row_data_slice' by replacing
 // relative indirect data pointers with absolute ones in 'indirect_data_slice'.
 // At the time of this writing, this rewriting is only done for STRING types.
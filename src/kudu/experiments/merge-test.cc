@@ -15,17 +15,23 @@
 // specific language governing permissions and limitations
 // under the License.
 
-#include <boost/lexical_cast.hpp>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <algorithm>
 #include <string>
 #include <vector>
 
+#include "kudu/gutil/endian.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/gutil/stringprintf.h"
 #include "kudu/util/stopwatch.h"
 
-DEFINE_int32(num_lists, 3, "Number of lists to merge");
-DEFINE_int32(num_rows, 100, "Number of entries per list");
+DEFINE_string(num_lists, "2,10,100,1000",
+              "Comma-separated numbers of lists to merge. The merge is run once "
+              "for each number of lists");
+DEFINE_int32(num_rows, 100000, "Total number of entries across all lists");
 DEFINE_int32(num_iters, 5, "Number of times to run merge");
 
 using std::vector;
@@ -77,6 +83,71 @@ void HeapMerge(
   }
 }
 
+// Returns the first 8 bytes of 's' as a big-endian integer, zero-padded,
+// which sorts the same way as 's' unless the prefixes are equal.
+uint64_t EncodePrefix(const string &s) {
+  uint64_t prefix = 0;
+  memcpy(&prefix, s.data(), std::min<size_t>(s.size(), sizeof(prefix)));
+  return BigEndian::ToHost64(prefix);
+}
+
+// Like HeapMerge, but each list caches the encoded prefix of its current
+// entry, so most comparisons are of two integers rather than two strings.
+// This is the approach taken by MergeIterator.
+void PrefixHeapMerge(
+  const vector<vector<MergeType> > &in_lists,
+  vector<MergeType> *out) {
+  typedef vector<MergeType>::const_iterator MergeTypeIter;
+
+  vector<MergeTypeIter> iters;
+  vector<uint64_t> prefixes;
+  vector<size_t> heap;
+  for (const vector<MergeType> &list : in_lists) {
+    iters.push_back(list.begin());
+    prefixes.push_back(EncodePrefix(list.front()));
+    heap.push_back(heap.size());
+  }
+
+  auto less = [&](size_t left, size_t right) {
+    if (prefixes[left] != prefixes[right]) {
+      return prefixes[left] < prefixes[right];
+    }
+    return *iters[left] < *iters[right];
+  };
+  auto sift_down = [&](size_t idx) {
+    size_t list_idx = heap[idx];
+    while (true) {
+      size_t child = 2 * idx + 1;
+      if (child >= heap.size()) break;
+      if (child + 1 < heap.size() && less(heap[child + 1], heap[child])) child++;
+      if (!less(heap[child], list_idx)) break;
+      heap[idx] = heap[child];
+      idx = child;
+    }
+    heap[idx] = list_idx;
+  };
+  for (ssize_t i = static_cast<ssize_t>(heap.size()) / 2 - 1; i >= 0; i--) {
+    sift_down(i);
+  }
+
+  while (!heap.empty()) {
+    size_t min_idx = heap.front();
+    MergeTypeIter &min_iter = iters[min_idx];
+
+    out->push_back(*min_iter);
+
+    min_iter++;
+    if (min_iter == in_lists[min_idx].end()) {
+      heap.front() = heap.back();
+      heap.pop_back();
+      if (heap.empty()) break;
+    } else {
+      prefixes[min_idx] = EncodePrefix(*min_iter);
+    }
+    sift_down(0);
+  }
+}
+
 void SimpleMerge(const vector<vector<MergeType> > &in_lists,
                  vector<MergeType> *out) {
   typedef vector<MergeType>::const_iterator MergeTypeIter;
@@ -102,38 +173,54 @@ void SimpleMerge(const vector<vector<MergeType> > &in_lists,
   }
 }
 
-int main(int argc, char **argv) {
-  google::ParseCommandLineFlags(&argc, &argv, true);
-
-  vector<vector<MergeType> > in_lists;
-  in_lists.resize(FLAGS_num_lists);
-
-  for (int i = 0; i < FLAGS_num_lists; i++) {
-    vector<MergeType> &list = in_lists[i];
-
-    int entry = 0;
-    for (int j = 0; j < FLAGS_num_rows; j++) {
-      entry += rand() % 5;
-      list.push_back(boost::lexical_cast<MergeType>(entry));
-    }
-  }
+typedef void (*MergeFunc)(const vector<vector<MergeType> > &, vector<MergeType> *);
 
+void RunMerge(const char *name, MergeFunc merge,
+              const vector<vector<MergeType> > &in_lists,
+              const vector<MergeType> &expected) {
   for (int i = 0; i < FLAGS_num_iters; i++) {
     vector<MergeType> out;
-    out.reserve(FLAGS_num_lists * FLAGS_num_rows);
+    out.reserve(expected.size());
 
-    LOG_TIMING(INFO, "HeapMerge") {
-      HeapMerge(in_lists, &out);
+    LOG_TIMING(INFO, strings::Substitute("$0 of $1 lists", name, in_lists.size())) {
+      merge(in_lists, &out);
     }
+    CHECK(out == expected) << name << " produced out-of-order results";
   }
+}
 
-  for (int i = 0; i < FLAGS_num_iters; i++) {
-    vector<MergeType> out;
-    out.reserve(FLAGS_num_lists * FLAGS_num_rows);
+int main(int argc, char **argv) {
+  google::ParseCommandLineFlags(&argc, &argv, true);
 
-    LOG_TIMING(INFO, "SimpleMerge") {
-      SimpleMerge(in_lists, &out);
+  vector<string> num_lists_strs = strings::Split(FLAGS_num_lists, ",", strings::SkipEmpty());
+  for (const string &num_lists_str : num_lists_strs) {
+    int num_lists;
+    CHECK(safe_strto32(num_lists_str, &num_lists) && num_lists > 0)
+      << "bad number of lists: " << num_lists_str;
+    int num_rows = std::max(1, FLAGS_num_rows / num_lists);
+
+    vector<vector<MergeType> > in_lists;
+    in_lists.resize(num_lists);
+    vector<MergeType> expected;
+    expected.reserve(num_lists * num_rows);
+
+    for (int i = 0; i < num_lists; i++) {
+      vector<MergeType> &list = in_lists[i];
+
+      int entry = 0;
+      for (int j = 0; j < num_rows; j++) {
+        entry += rand() % 5;
+        // Zero-pad the entries so that they sort as strings the same way
+        // they do as integers.
+        list.push_back(StringPrintf("%010d", entry));
+        expected.push_back(list.back());
+      }
     }
+    std::sort(expected.begin(), expected.end());
+
+    RunMerge("HeapMerge", &HeapMerge, in_lists, expected);
+    RunMerge("PrefixHeapMerge", &PrefixHeapMerge, in_lists, expected);
+    RunMerge("SimpleMerge", &SimpleMerge, in_lists, expected);
   }
 
   return 0;
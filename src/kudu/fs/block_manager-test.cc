@@ -35,6 +35,7 @@
 
 using std::shared_ptr;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 
@@ -404,6 +405,58 @@ TYPED_TEST(BlockManagerTest, ReadAfterDeleteTest) {
   ASSERT_EQ(test_data, data);
 }
 
+TYPED_TEST(BlockManagerTest, ReadBlocksTest) {
+  // Write a few blocks, one after the other.
+  const vector<string> kTestData = { "first block", "second block", "third block" };
+  vector<BlockId> ids;
+  for (const string& test_data : kTestData) {
+    gscoped_ptr<WritableBlock> written_block;
+    ASSERT_OK(this->bm_->CreateBlock(&written_block));
+    ASSERT_OK(written_block->Append(test_data));
+    ASSERT_OK(written_block->Close());
+    ids.push_back(written_block->id());
+  }
+  vector<unique_ptr<ReadableBlock>> blocks;
+  for (const BlockId& id : ids) {
+    gscoped_ptr<ReadableBlock> block;
+    ASSERT_OK(this->bm_->OpenBlock(id, &block));
+    blocks.emplace_back(block.release());
+  }
+  uint8_t scratch[64];
+
+  // Read adjacent and out of order ranges of a block.
+  vector<ReadRange> ranges;
+  ranges.emplace_back(7, 5, scratch);
+  ranges.emplace_back(0, 7, scratch + 5);
+  ASSERT_OK(blocks[1]->ReadV(&ranges));
+  ASSERT_EQ("block", ranges[0].result);
+  ASSERT_EQ("second ", ranges[1].result);
+
+  // Read ranges of all the blocks at once.
+  vector<BlockReadRange> block_ranges;
+  block_ranges.emplace_back(blocks[2].get(), 0, 5, scratch);
+  block_ranges.emplace_back(blocks[0].get(), 6, 5, scratch + 5);
+  block_ranges.emplace_back(blocks[1].get(), 0, 12, scratch + 10);
+  block_ranges.emplace_back(blocks[0].get(), 0, 5, scratch + 22);
+  ASSERT_OK(this->bm_->ReadBlocks(&block_ranges));
+  ASSERT_EQ("third", block_ranges[0].range.result);
+  ASSERT_EQ("block", block_ranges[1].range.result);
+  ASSERT_EQ("second block", block_ranges[2].range.result);
+  ASSERT_EQ("first", block_ranges[3].range.result);
+
+  // Blocks which were deleted while open can still be read.
+  ASSERT_OK(this->bm_->DeleteBlock(ids[0]));
+  ASSERT_OK(this->bm_->ReadBlocks(&block_ranges));
+  ASSERT_EQ("block", block_ranges[1].range.result);
+  ASSERT_EQ("first", block_ranges[3].range.result);
+
+  // A range past the end of its block fails the whole read, even if the
+  // underlying file has more data.
+  block_ranges.emplace_back(blocks[1].get(), 10, 5, scratch + 30);
+  Status s = this->bm_->ReadBlocks(&block_ranges);
+  ASSERT_TRUE(s.IsIOError()) << s.ToString();
+}
+
 TYPED_TEST(BlockManagerTest, CloseTwiceTest) {
   // Create a new block and close it repeatedly.
   gscoped_ptr<WritableBlock> written_block;
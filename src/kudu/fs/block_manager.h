@@ -29,9 +29,11 @@
 #include "kudu/gutil/ref_counted.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/env.h"
 #include "kudu/util/status.h"
 
 DECLARE_bool(block_coalesce_close);
+DECLARE_bool(block_manager_direct_io_reads);
 
 namespace kudu {
 
@@ -152,10 +154,29 @@ class ReadableBlock : public Block {
   virtual Status Read(uint64_t offset, size_t length,
                       Slice* result, uint8_t* scratch) const = 0;
 
+  // Like Read(), for each of the given ranges of the block, whose offsets
+  // are relative to the beginning of the block. Ranges which are adjacent
+  // on disk may be read with a single I/O.
+  virtual Status ReadV(std::vector<ReadRange>* ranges) const = 0;
+
   // Returns the memory usage of this object including the object itself.
   virtual size_t memory_footprint() const = 0;
 };
 
+// A range of a block to read with BlockManager::ReadBlocks().
+struct BlockReadRange {
+  BlockReadRange(const ReadableBlock* block, uint64_t offset, size_t length,
+                 uint8_t* scratch)
+      : block(block),
+        range(offset, length, scratch) {
+  }
+
+  const ReadableBlock* block;
+
+  // The offset of the range is relative to the beginning of 'block'.
+  ReadRange range;
+};
+
 // Provides options and hints for block placement.
 struct CreateBlockOptions {
 };
@@ -232,7 +253,16 @@ class BlockManager {
   // On success, guarantees that outstanding data is durable.
   virtual Status CloseBlocks(const std::vector<WritableBlock*>& blocks) = 0;
 
+  // Reads the given ranges of blocks opened by this block manager.
+  // Effectively like ReadableBlock::ReadV() for each block, but ranges of
+  // different blocks which are adjacent on disk may be read with a single
+  // I/O.
+  virtual Status ReadBlocks(std::vector<BlockReadRange>* ranges) = 0;
+
  protected:
+  // Implements ReadBlocks() with a ReadableBlock::ReadV() call per block.
+  static Status ReadEachBlock(std::vector<BlockReadRange>* ranges);
+
   static const char* kInstanceMetadataFileName;
 };
 
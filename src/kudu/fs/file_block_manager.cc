@@ -386,6 +386,8 @@ class FileReadableBlock : public ReadableBlock {
   virtual Status Read(uint64_t offset, size_t length,
                       Slice* result, uint8_t* scratch) const OVERRIDE;
 
+  virtual Status ReadV(vector<ReadRange>* ranges) const OVERRIDE;
+
   virtual size_t memory_footprint() const OVERRIDE;
 
  private:
@@ -456,6 +458,21 @@ Status FileReadableBlock::Read(uint64_t offset, size_t length,
   return Status::OK();
 }
 
+Status FileReadableBlock::ReadV(vector<ReadRange>* ranges) const {
+  DCHECK(!closed_.Load());
+
+  RETURN_NOT_OK(reader_->ReadV(ranges));
+  if (block_manager_->metrics_) {
+    size_t length = 0;
+    for (const ReadRange& range : *ranges) {
+      length += range.length;
+    }
+    block_manager_->metrics_->total_bytes_read->IncrementBy(length);
+  }
+
+  return Status::OK();
+}
+
 size_t FileReadableBlock::memory_footprint() const {
   DCHECK(reader_);
   return kudu_malloc_usable_size(this) + reader_->memory_footprint();
@@ -714,8 +731,11 @@ Status FileBlockManager::OpenBlock(const BlockId& block_id,
 
   VLOG(1) << "Opening block with id " << block_id.ToString() << " at " << path;
 
-  shared_ptr<RandomAccessFile> reader;
-  RETURN_NOT_OK(env_util::OpenFileForRandom(env_, path, &reader));
+  RandomAccessFileOptions opts;
+  opts.direct_io = FLAGS_block_manager_direct_io_reads;
+  gscoped_ptr<RandomAccessFile> file;
+  RETURN_NOT_OK(env_->NewRandomAccessFile(opts, path, &file));
+  shared_ptr<RandomAccessFile> reader(file.release());
   block->reset(new internal::FileReadableBlock(this, block_id, reader));
   return Status::OK();
 }
@@ -760,5 +780,11 @@ Status FileBlockManager::CloseBlocks(const vector<WritableBlock*>& blocks) {
   return Status::OK();
 }
 
+Status FileBlockManager::ReadBlocks(vector<BlockReadRange>* ranges) {
+  // Every block is a file of its own, so only the ranges of the same block
+  // may be coalesced.
+  return ReadEachBlock(ranges);
+}
+
 } // namespace fs
 } // namespace kudu
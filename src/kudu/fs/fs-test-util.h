@@ -66,6 +66,14 @@ class CountingReadableBlock : public ReadableBlock {
     return Status::OK();
   }
 
+  virtual Status ReadV(std::vector<ReadRange>* ranges) const OVERRIDE {
+    RETURN_NOT_OK(block_->ReadV(ranges));
+    for (const ReadRange& range : *ranges) {
+      *bytes_read_ += range.length;
+    }
+    return Status::OK();
+  }
+
   virtual size_t memory_footprint() const OVERRIDE {
     return block_->memory_footprint();
   }
@@ -176,6 +176,13 @@ class FsManager {
     return JoinPathSegments(GetConsensusMetadataDir(), tablet_id);
   }
 
+  // Return the path where the keys of the blocks in the block cache are
+  // persisted across restarts.
+  std::string GetBlockCacheKeysPath() const {
+    DCHECK(initted_);
+    return JoinPathSegments(canonicalized_metadata_fs_root_, kBlockCacheKeysFileName);
+  }
+
   Env *env() { return env_; }
 
   bool read_only() const {
@@ -241,6 +248,7 @@ class FsManager {
   static const char *kInstanceMetadataMagicNumber;
   static const char *kTabletSuperBlockMagicNumber;
   static const char *kConsensusMetadataDirName;
+  static const char *kBlockCacheKeysFileName;
 
   Env *env_;
 
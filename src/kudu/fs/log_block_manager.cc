@@ -186,6 +186,11 @@ class LogBlockContainer {
   Status ReadData(int64_t offset, size_t length,
                   Slice* result, uint8_t* scratch) const;
 
+  // See RWFile::ReadV(). Ranges which are adjacent in the data file, e.g.
+  // because they belong to blocks written one after the other, are read
+  // with a single I/O.
+  Status ReadDataV(std::vector<ReadRange>* ranges) const;
+
   // Appends 'pb' to this container's metadata file.
   //
   // The on-disk effects of this call are made durable only after SyncMetadata().
@@ -276,6 +281,9 @@ class LogBlockContainer {
   void CheckBlockRecord(const BlockRecordPB& record,
                         uint64_t data_file_size) const;
 
+  // Opens 'direct_data_reader_' if reads should use direct I/O.
+  Status MaybeOpenDirectDataReader();
+
   // The owning block manager. Must outlive the container itself.
   LogBlockManager* const block_manager_;
 
@@ -293,6 +301,10 @@ class LogBlockContainer {
   Mutex data_writer_lock_;
   gscoped_ptr<RWFile> data_file_;
 
+  // The data file opened for direct I/O reads, or NULL if data is read
+  // from 'data_file_'. See --block_manager_direct_io_reads.
+  gscoped_ptr<RandomAccessFile> direct_data_reader_;
+
   // The amount of data written thus far in the container.
   int64_t total_bytes_written_;
 
@@ -361,11 +373,11 @@ Status LogBlockContainer::Create(LogBlockManager* block_manager,
     gscoped_ptr<WritablePBContainerFile> metadata_pb_writer(
         new WritablePBContainerFile(std::move(metadata_writer)));
     RETURN_NOT_OK(metadata_pb_writer->Init(BlockRecordPB()));
-    container->reset(new LogBlockContainer(block_manager,
-                                           instance,
-                                           common_path,
-                                           std::move(metadata_pb_writer),
-                                           std::move(data_file)));
+    gscoped_ptr<LogBlockContainer> new_container(new LogBlockContainer(
+        block_manager, instance, common_path, std::move(metadata_pb_writer),
+        std::move(data_file)));
+    RETURN_NOT_OK(new_container->MaybeOpenDirectDataReader());
+    container->reset(new_container.release());
     VLOG(1) << "Created log block container " << (*container)->ToString();
   }
 
@@ -407,6 +419,7 @@ Status LogBlockContainer::Open(LogBlockManager* block_manager,
                                                                       common_path,
                                                                       std::move(metadata_pb_writer),
                                                                       std::move(data_file)));
+  RETURN_NOT_OK(open_container->MaybeOpenDirectDataReader());
   VLOG(1) << "Opened log block container " << open_container->ToString();
   container->reset(open_container.release());
   return Status::OK();
@@ -509,9 +522,29 @@ Status LogBlockContainer::ReadData(int64_t offset, size_t length,
                                    Slice* result, uint8_t* scratch) const {
   DCHECK_GE(offset, 0);
 
+  if (direct_data_reader_) {
+    return env_util::ReadFully(direct_data_reader_.get(), offset, length, result, scratch);
+  }
   return data_file_->Read(offset, length, result, scratch);
 }
 
+Status LogBlockContainer::ReadDataV(std::vector<ReadRange>* ranges) const {
+  if (direct_data_reader_) {
+    return direct_data_reader_->ReadV(ranges);
+  }
+  return data_file_->ReadV(ranges);
+}
+
+Status LogBlockContainer::MaybeOpenDirectDataReader() {
+  if (!FLAGS_block_manager_direct_io_reads) {
+    return Status::OK();
+  }
+  RandomAccessFileOptions opts;
+  opts.direct_io = true;
+  return block_manager_->env()->NewRandomAccessFile(
+      opts, StrCat(path_, kDataFileSuffix), &direct_data_reader_);
+}
+
 Status LogBlockContainer::AppendMetadata(const BlockRecordPB& pb) {
   lock_guard<Mutex> l(&metadata_pb_writer_lock_);
   return metadata_pb_writer_->Append(pb);
@@ -898,6 +931,21 @@ Status LogWritableBlock::AppendMetadata() {
 // LogReadableBlock
 ////////////////////////////////////////////////////////////
 
+// Returns an error if the range of 'length' bytes at 'offset' is not within
+// the block of 'log_block'.
+static Status CheckReadBounds(const LogBlock* log_block, uint64_t offset, size_t length) {
+  if (PREDICT_FALSE(log_block->length() < offset + length)) {
+    uint64_t read_offset = log_block->offset() + offset;
+    return Status::IOError("Out-of-bounds read",
+                           Substitute("read of [$0-$1) in block [$2-$3)",
+                                      read_offset,
+                                      read_offset + length,
+                                      log_block->offset(),
+                                      log_block->offset() + log_block->length()));
+  }
+  return Status::OK();
+}
+
 // A log-backed block that has been opened for reading.
 //
 // Refers to a LogBlock representing the block's persisted metadata.
@@ -917,6 +965,8 @@ class LogReadableBlock : public ReadableBlock {
   virtual Status Read(uint64_t offset, size_t length,
                       Slice* result, uint8_t* scratch) const OVERRIDE;
 
+  virtual Status ReadV(std::vector<ReadRange>* ranges) const OVERRIDE;
+
   virtual size_t memory_footprint() const OVERRIDE;
 
  private:
@@ -975,16 +1025,32 @@ Status LogReadableBlock::Read(uint64_t offset, size_t length,
                               Slice* result, uint8_t* scratch) const {
   DCHECK(!closed_.Load());
 
-  uint64_t read_offset = log_block_->offset() + offset;
-  if (log_block_->length() < offset + length) {
-    return Status::IOError("Out-of-bounds read",
-                           Substitute("read of [$0-$1) in block [$2-$3)",
-                                      read_offset,
-                                      read_offset + length,
-                                      log_block_->offset(),
-                                      log_block_->offset() + log_block_->length()));
+  RETURN_NOT_OK(CheckReadBounds(log_block_.get(), offset, length));
+  RETURN_NOT_OK(container_->ReadData(log_block_->offset() + offset, length, result, scratch));
+
+  if (container_->metrics()) {
+    container_->metrics()->generic_metrics.total_bytes_read->IncrementBy(length);
+  }
+  return Status::OK();
+}
+
+Status LogReadableBlock::ReadV(std::vector<ReadRange>* ranges) const {
+  DCHECK(!closed_.Load());
+
+  // Read the ranges at their offsets in the container's data file.
+  std::vector<ReadRange> container_ranges;
+  container_ranges.reserve(ranges->size());
+  size_t length = 0;
+  for (const ReadRange& range : *ranges) {
+    RETURN_NOT_OK(CheckReadBounds(log_block_.get(), range.offset, range.length));
+    container_ranges.emplace_back(log_block_->offset() + range.offset, range.length,
+                                  range.scratch);
+    length += range.length;
+  }
+  RETURN_NOT_OK(container_->ReadDataV(&container_ranges));
+  for (size_t i = 0; i < ranges->size(); i++) {
+    (*ranges)[i].result = container_ranges[i].result;
   }
-  RETURN_NOT_OK(container_->ReadData(read_offset, length, result, scratch));
 
   if (container_->metrics()) {
     container_->metrics()->generic_metrics.total_bytes_read->IncrementBy(length);
@@ -1274,6 +1340,62 @@ Status LogBlockManager::CloseBlocks(const std::vector<WritableBlock*>& blocks) {
   return Status::OK();
 }
 
+Status LogBlockManager::ReadBlocks(vector<BlockReadRange>* ranges) {
+  // Group the ranges by container, at their offsets in the container's data
+  // file, so that the ranges of different blocks may be coalesced too.
+  struct ContainerRead {
+    std::vector<ReadRange> ranges;
+
+    // For each of 'ranges', its index in the ranges passed to ReadBlocks().
+    std::vector<size_t> indexes;
+  };
+  unordered_map<LogBlockContainer*, ContainerRead> reads_by_container;
+
+  // The ranges of blocks which are not known anymore, e.g. because they were
+  // deleted while open. They are read through the blocks themselves.
+  vector<BlockReadRange> other_ranges;
+  vector<size_t> other_indexes;
+  {
+    lock_guard<simple_spinlock> l(&lock_);
+    for (size_t i = 0; i < ranges->size(); i++) {
+      const BlockReadRange& r = (*ranges)[i];
+      const scoped_refptr<LogBlock>* lb = FindOrNull(blocks_by_block_id_, r.block->id());
+      if (!lb) {
+        other_ranges.push_back(r);
+        other_indexes.push_back(i);
+        continue;
+      }
+      RETURN_NOT_OK(internal::CheckReadBounds(lb->get(), r.range.offset, r.range.length));
+      ContainerRead* read = &reads_by_container[(*lb)->container()];
+      read->ranges.emplace_back((*lb)->offset() + r.range.offset, r.range.length,
+                                r.range.scratch);
+      read->indexes.push_back(i);
+    }
+  }
+
+  for (auto& e : reads_by_container) {
+    LogBlockContainer* container = e.first;
+    ContainerRead* read = &e.second;
+    RETURN_NOT_OK(container->ReadDataV(&read->ranges));
+    size_t length = 0;
+    for (size_t j = 0; j < read->ranges.size(); j++) {
+      (*ranges)[read->indexes[j]].range.result = read->ranges[j].result;
+      length += read->ranges[j].length;
+    }
+    if (container->metrics()) {
+      container->metrics()->generic_metrics.total_bytes_read->IncrementBy(length);
+    }
+  }
+
+  if (!other_ranges.empty()) {
+    RETURN_NOT_OK(ReadEachBlock(&other_ranges));
+    for (size_t j = 0; j < other_ranges.size(); j++) {
+      (*ranges)[other_indexes[j]].range.result = other_ranges[j].range.result;
+    }
+  }
+  return Status::OK();
+}
+
 int64_t LogBlockManager::CountBlocksForTests() const {
   lock_guard<simple_spinlock> l(&lock_);
   return blocks_by_block_id_.size();
@@ -171,6 +171,8 @@ class LogBlockManager : public BlockManager {
 
   virtual Status CloseBlocks(const std::vector<WritableBlock*>& blocks) OVERRIDE;
 
+  virtual Status ReadBlocks(std::vector<BlockReadRange>* ranges) OVERRIDE;
+
   // Return the number of blocks stored in the block manager.
   int64_t CountBlocksForTests() const;
 
@@ -449,13 +449,14 @@ Status CallResponse::ParseFrom(gscoped_ptr<InboundTransfer> transfer) {
   // Use information from header to extract the payload slices.
   int last = header_.sidecar_offsets_size() - 1;
 
-  if (last >= OutboundTransfer::kMaxPayloadSlices) {
+  if (last >= OutboundTransfer::kMaxSidecars) {
     return Status::Corruption(strings::Substitute(
-        "Received $0 additional payload slices, expected at most %d",
-        last, OutboundTransfer::kMaxPayloadSlices));
+        "Received $0 sidecars, expected at most $1",
+        last + 1, OutboundTransfer::kMaxSidecars));
   }
 
   if (last >= 0) {
+    sidecar_slices_.resize(last + 1);
     serialized_response_ = Slice(entire_message.data(),
                                  header_.sidecar_offsets(0));
     for (int i = 0; i < last; ++i) {
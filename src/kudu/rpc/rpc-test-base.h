@@ -18,6 +18,7 @@
 #define KUDU_RPC_RPC_TEST_BASE_H
 
 #include <algorithm>
+#include <atomic>
 #include <list>
 #include <memory>
 #include <string>
@@ -75,6 +76,10 @@ class GenericCalculatorService : public ServiceIf {
   static const char* kFirstString;
   static const char* kSecondString;
 
+  // The number of sidecars sent by SendTwoStrings which are still pinned,
+  // i.e. which have not been released after their response was sent.
+  static std::atomic<int> num_pinned_sidecars;
+
   GenericCalculatorService() {
   }
 
@@ -100,6 +105,25 @@ class GenericCalculatorService : public ServiceIf {
   static std::string static_service_name() { return kFullServiceName; }
 
  private:
+  // Owns the data of a sidecar sent with RpcSidecar::FromPinnedSlice(),
+  // counting the live pins in 'num_pinned_sidecars'.
+  class CountingSidecarPin {
+   public:
+    explicit CountingSidecarPin(gscoped_ptr<faststring> data)
+        : data_(std::move(data)) {
+      num_pinned_sidecars++;
+    }
+
+    ~CountingSidecarPin() {
+      num_pinned_sidecars--;
+    }
+
+    Slice data() const { return *data_; }
+
+   private:
+    gscoped_ptr<faststring> data_;
+  };
+
   void DoAdd(InboundCall *incoming) {
     Slice param(incoming->serialized_request());
     AddRequestPB req;
@@ -133,8 +157,11 @@ class GenericCalculatorService : public ServiceIf {
     int idx1, idx2;
     CHECK_OK(incoming->AddRpcSidecar(
         make_gscoped_ptr(new RpcSidecar(std::move(first))), &idx1));
+    // Send the second string without copying it, to exercise pinned sidecars.
+    gscoped_ptr<CountingSidecarPin> second_pin(new CountingSidecarPin(std::move(second)));
+    Slice second_data = second_pin->data();
     CHECK_OK(incoming->AddRpcSidecar(
-        make_gscoped_ptr(new RpcSidecar(std::move(second))), &idx2));
+        RpcSidecar::FromPinnedSlice(second_data, std::move(second_pin)), &idx2));
     resp.set_sidecar1(idx1);
     resp.set_sidecar2(idx2);
 
@@ -257,6 +284,8 @@ const char *GenericCalculatorService::kFirstString =
 const char *GenericCalculatorService::kSecondString =
     "2222222222222222222222222222222222222222222222222222222222222222222222";
 
+std::atomic<int> GenericCalculatorService::num_pinned_sidecars(0);
+
 class RpcTestBase : public KuduTest {
  public:
   RpcTestBase()
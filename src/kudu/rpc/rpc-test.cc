@@ -278,6 +278,12 @@ TEST_F(TestRpc, TestRpcSidecar) {
   // Test some larger sidecars to verify that we properly handle the case where
   // we can't write the whole response to the socket in a single call.
   DoTestSidecar(p, 3000 * 1024, 2000 * 1024);
+
+  // The pinned sidecars are released once their responses have been sent.
+  for (int i = 0; i < 1000 && GenericCalculatorService::num_pinned_sidecars > 0; i++) {
+    SleepFor(MonoDelta::FromMilliseconds(10));
+  }
+  ASSERT_EQ(0, GenericCalculatorService::num_pinned_sidecars);
 }
 
 // Test that timeouts are properly handled.
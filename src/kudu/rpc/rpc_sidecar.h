@@ -17,6 +17,8 @@
 #ifndef KUDU_RPC_RPC_SIDECAR_H
 #define KUDU_RPC_RPC_SIDECAR_H
 
+#include <utility>
+
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/util/faststring.h"
 #include "kudu/util/slice.h"
@@ -49,16 +51,61 @@ namespace rpc {
 // RpcController's interface) is able to offer retrieval of the sidecar data
 // through the same indices that were returned by InboundCall (or indirectly
 // through the RpcContext wrapper) on the client side.
+//
+// A sidecar may also reference memory which it does not own, such as a block
+// in the block cache, so that the memory is written to the socket without
+// being copied first. See FromPinnedSlice().
 class RpcSidecar {
  public:
   // Generates a sidecar with the parameter faststring as its data.
-  explicit RpcSidecar(gscoped_ptr<faststring> data) : data_(std::move(data)) {}
+  explicit RpcSidecar(gscoped_ptr<faststring> data)
+      : data_(std::move(data)),
+        slice_(*data_) {
+  }
+
+  // Generates a sidecar which references 'data' without copying it.
+  //
+  // 'pin' is any movable object which keeps 'data' valid for as long as it
+  // lives: e.g. a gscoped_ptr<cfile::BlockCacheHandle>, or a scoped_refptr
+  // to refcounted memory. It is destroyed along with the sidecar, which is
+  // once the response has been written to the socket, or once the
+  // connection has been torn down.
+  template<class Pin>
+  static gscoped_ptr<RpcSidecar> FromPinnedSlice(const Slice& data, Pin pin) {
+    return gscoped_ptr<RpcSidecar>(new RpcSidecar(
+        data, gscoped_ptr<PinHolderBase>(new PinHolder<Pin>(std::move(pin)))));
+  }
 
   // Returns a Slice representation of the sidecar's data.
-  Slice AsSlice() const { return *data_; }
+  Slice AsSlice() const { return slice_; }
 
  private:
+  // Type-erased owner of the pin of a sidecar created with FromPinnedSlice().
+  class PinHolderBase {
+   public:
+    virtual ~PinHolderBase() {}
+  };
+
+  template<class Pin>
+  class PinHolder : public PinHolderBase {
+   public:
+    explicit PinHolder(Pin pin) : pin_(std::move(pin)) {}
+
+   private:
+    Pin pin_;
+  };
+
+  RpcSidecar(const Slice& data, gscoped_ptr<PinHolderBase> pin)
+      : pin_(std::move(pin)),
+        slice_(data) {
+  }
+
+  // Exactly one of 'data_' and 'pin_' is set.
   const gscoped_ptr<faststring> data_;
+  const gscoped_ptr<PinHolderBase> pin_;
+
+  // The data of the sidecar, which either 'data_' or 'pin_' keeps valid.
+  const Slice slice_;
 
   DISALLOW_COPY_AND_ASSIGN(RpcSidecar);
 };
@@ -17,8 +17,10 @@
 
 #include "kudu/rpc/transfer.h"
 
+#include <limits.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -124,14 +126,19 @@ string InboundTransfer::StatusAsString() const {
 
 OutboundTransfer::OutboundTransfer(const std::vector<Slice> &payload,
                                    TransferCallbacks *callbacks)
-  : cur_slice_idx_(0),
+  : payload_slices_(inline_payload_slices_),
+    n_payload_slices_(payload.size()),
+    cur_slice_idx_(0),
     cur_offset_in_slice_(0),
     callbacks_(callbacks),
     aborted_(false) {
   CHECK(!payload.empty());
+  CHECK_LE(n_payload_slices_, kMaxPayloadSlices);
 
-  n_payload_slices_ = payload.size();
-  CHECK_LE(n_payload_slices_, arraysize(payload_slices_));
+  if (n_payload_slices_ > arraysize(inline_payload_slices_)) {
+    heap_payload_slices_.reset(new Slice[n_payload_slices_]);
+    payload_slices_ = heap_payload_slices_.get();
+  }
   for (int i = 0; i < payload.size(); i++) {
     payload_slices_[i] = payload[i];
   }
@@ -154,7 +161,8 @@ void OutboundTransfer::Abort(const Status &status) {
 Status OutboundTransfer::SendBuffer(Socket &socket) {
   CHECK_LT(cur_slice_idx_, n_payload_slices_);
 
-  int n_iovecs = n_payload_slices_ - cur_slice_idx_;
+  // Responses with many sidecars are written with several calls.
+  int n_iovecs = std::min<int>(n_payload_slices_ - cur_slice_idx_, IOV_MAX);
   struct iovec iovec[n_iovecs];
   {
     int offset_in_slice = cur_offset_in_slice_;
@@ -26,6 +26,7 @@
 #include <string>
 #include <vector>
 
+#include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/rpc/rpc_header.pb.h"
 #include "kudu/util/net/sockaddr.h"
 #include "kudu/util/status.h"
@@ -96,7 +97,17 @@ class InboundTransfer {
 // Upon completion of the transfer, a callback is triggered.
 class OutboundTransfer : public boost::intrusive::list_base_hook<> {
  public:
-  enum { kMaxPayloadSlices = 10 };
+  enum {
+    // The maximum number of sidecars which may be attached to a call.
+    kMaxSidecars = 10000,
+
+    // The header and the main message protobuf, plus the sidecars.
+    kMaxPayloadSlices = kMaxSidecars + 2,
+
+    // The number of slices which fit in the transfer itself. Payloads with
+    // more slices are copied to the heap.
+    kMaxInlinePayloadSlices = 10
+  };
 
   // Create a new transfer. The 'payload' slices will be concatenated and
   // written to the socket. When the transfer completes or errors, the
@@ -135,9 +146,13 @@ class OutboundTransfer : public boost::intrusive::list_base_hook<> {
 
  private:
   // Slices to send. Uses an array here instead of a vector to avoid an expensive
-  // vector construction (improved performance a couple percent).
-  Slice payload_slices_[kMaxPayloadSlices];
-  size_t n_payload_slices_;
+  // vector construction (improved performance a couple percent). Points to
+  // 'inline_payload_slices_', or to 'heap_payload_slices_' if there are more
+  // slices than fit inline.
+  Slice* payload_slices_;
+  Slice inline_payload_slices_[kMaxInlinePayloadSlices];
+  gscoped_array<Slice> heap_payload_slices_;
+  const size_t n_payload_slices_;
 
   // The current slice that is being sent.
   int32_t cur_slice_idx_;
@@ -25,7 +25,12 @@
 #include "kudu/tablet/tablet-test-base.h"
 #include "kudu/util/test_util.h"
 
+DECLARE_bool(cfile_set_batch_block_reads);
+DECLARE_bool(consult_bloom_filters);
+DECLARE_bool(materializing_iterator_decode_selected_only);
+DECLARE_bool(materializing_iterator_use_zone_maps);
 DECLARE_int32(cfile_default_block_size);
+DECLARE_int32(cfile_readahead_blocks);
 
 using std::shared_ptr;
 
@@ -69,6 +74,62 @@ class TestCFileSet : public KuduRowSetTest {
     ASSERT_OK(rsw.Finish());
   }
 
+  // Write out a test rowset in which column c1 cycles through the values
+  // [0, 100) in a scattered order, so that a predicate 'c1 < N' selects N% of
+  // the rows spread evenly throughout the rowset. The other columns are as in
+  // WriteTestRowSet().
+  void WriteScatteredTestRowSet(int nrows) {
+    DiskRowSetWriter rsw(rowset_meta_.get(), &schema_,
+                         BloomFilterSizing::BySizeAndFPRate(32*1024, 0.01f));
+
+    ASSERT_OK(rsw.Open());
+
+    RowBuilder rb(schema_);
+    for (int i = 0; i < nrows; i++) {
+      rb.Reset();
+      rb.AddUint32(i * 2);
+      rb.AddUint32((i * 19) % 100);
+      rb.AddUint32(i * 100);
+      ASSERT_OK_FAST(WriteRow(rb.data(), &rsw));
+    }
+    ASSERT_OK(rsw.Finish());
+  }
+
+  // Scan the rowset written by WriteScatteredTestRowSet() with the predicate
+  // 'c1 < selectivity_pct', verifying the other columns of every selected row.
+  void DoTestScatteredScan(const shared_ptr<CFileSet> &fileset,
+                           uint32_t selectivity_pct,
+                           int expected_rows) {
+    shared_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_));
+    gscoped_ptr<RowwiseIterator> iter(new MaterializingIterator(cfile_iter));
+
+    ScanSpec spec;
+    uint32_t upper = selectivity_pct - 1;
+    ColumnRangePredicate pred(schema_.column(1), nullptr, &upper);
+    spec.AddPredicate(pred);
+    ASSERT_OK(iter->Init(&spec));
+
+    Arena arena(1024, 1024);
+    RowBlock block(schema_, 1000, &arena);
+    int selected = 0;
+    while (iter->HasNext()) {
+      ASSERT_OK_FAST(iter->NextBlock(&block));
+      for (size_t i = 0; i < block.nrows(); i++) {
+        if (!block.selection_vector()->IsRowSelected(i)) continue;
+        RowBlockRow row = block.row(i);
+        uint32_t c0 = *schema_.ExtractColumnFromRow<UINT32>(row, 0);
+        uint32_t c1 = *schema_.ExtractColumnFromRow<UINT32>(row, 1);
+        uint32_t c2 = *schema_.ExtractColumnFromRow<UINT32>(row, 2);
+        if (c1 > upper || c2 != c0 * 50) {
+          FAIL() << "Bad row " << schema_.DebugRow(row) << " for predicate "
+                 << pred.ToString();
+        }
+        selected++;
+      }
+    }
+    ASSERT_EQ(expected_rows, selected);
+  }
+
   // Issue a range scan between 'lower' and 'upper', and verify that all result
   // rows indeed fall inside that predicate.
   void DoTestRangeScan(const shared_ptr<CFileSet> &fileset,
@@ -284,6 +345,139 @@ TEST_F(TestCFileSet, TestRangeScan) {
   EXPECT_EQ(stats[2].data_blocks_read_from_disk, 1);
 }
 
+// Test that a scan bounded to a single key skips the rowset when the bloom
+// filter shows that the key is absent.
+TEST_F(TestCFileSet, TestPointScanPrunedByBloom) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset(new CFileSet(rowset_meta_));
+  ASSERT_OK(fileset->Open());
+  Schema key_schema = schema_.CreateKeyProjection();
+
+  // Scan for the given key with an equality predicate, returning the number
+  // of matching rows and whether the rowset was pruned.
+  auto point_scan = [&] (uint32_t key, int* num_rows, bool* pruned) {
+    shared_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_));
+    gscoped_ptr<RowwiseIterator> iter(new MaterializingIterator(cfile_iter));
+    Arena arena(1024, 256 * 1024);
+    RangePredicateEncoder encoder(&key_schema, &arena);
+    ScanSpec spec;
+    spec.AddPredicate(ColumnRangePredicate(schema_.column(0), &key, &key));
+    encoder.EncodeRangePredicates(&spec, true);
+    ASSERT_OK(iter->Init(&spec));
+
+    vector<string> results;
+    ASSERT_OK(IterateToStringList(iter.get(), &results));
+    *num_rows = results.size();
+
+    vector<IteratorStats> stats;
+    iter->GetIteratorStats(&stats);
+    IteratorStats total;
+    for (const IteratorStats& col_stats : stats) {
+      total.AddStats(col_stats);
+    }
+    ASSERT_LE(total.rowsets_pruned_by_bloom, 1);
+    *pruned = total.rowsets_pruned_by_bloom == 1;
+    if (*pruned) {
+      ASSERT_EQ(0, total.data_blocks_read_from_disk);
+    }
+  };
+
+  // The keys are the even numbers, so every odd key is absent. Bloom filters
+  // have false positives, so only most of the absent keys will be pruned.
+  const int kNumProbes = 1000;
+  int num_pruned = 0;
+  for (int i = 0; i < kNumProbes; i++) {
+    int num_rows;
+    bool pruned;
+    NO_FATALS(point_scan(i * 2, &num_rows, &pruned));
+    ASSERT_EQ(1, num_rows);
+    ASSERT_FALSE(pruned);
+
+    NO_FATALS(point_scan(i * 2 + 1, &num_rows, &pruned));
+    ASSERT_EQ(0, num_rows);
+    if (pruned) {
+      num_pruned++;
+    }
+  }
+  LOG(INFO) << "Pruned " << num_pruned << "/" << kNumProbes << " scans of absent keys";
+  ASSERT_GT(num_pruned, kNumProbes * 9 / 10);
+
+  // The bloom filter is not consulted when the flag is off.
+  FLAGS_consult_bloom_filters = false;
+  int num_rows;
+  bool pruned;
+  NO_FATALS(point_scan(1, &num_rows, &pruned));
+  ASSERT_EQ(0, num_rows);
+  ASSERT_FALSE(pruned);
+}
+
+// Test that scans with predicates on a non-key column use the zone maps of
+// the column to skip blocks of rows, and whole rowsets.
+TEST_F(TestCFileSet, TestZoneMapPruning) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset(new CFileSet(rowset_meta_));
+  ASSERT_OK(fileset->Open());
+
+  // Scan with the predicate 'lower <= c1 < upper', returning the matching
+  // rows and the summed iterator stats.
+  auto scan = [&] (uint32_t lower, uint32_t upper, vector<string>* results,
+                   IteratorStats* total) {
+    shared_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_));
+    gscoped_ptr<RowwiseIterator> iter(new MaterializingIterator(cfile_iter));
+    ScanSpec spec;
+    spec.AddPredicate(ColumnPredicate::Range(schema_.column(1), &lower, &upper));
+    ASSERT_OK(iter->Init(&spec));
+    ASSERT_OK(IterateToStringList(iter.get(), results));
+
+    vector<IteratorStats> stats;
+    iter->GetIteratorStats(&stats);
+    *total = IteratorStats();
+    for (const IteratorStats& col_stats : stats) {
+      total->AddStats(col_stats);
+    }
+  };
+
+  // c1 is the row index * 10, so this matches rows [5000, 5010).
+  vector<string> results;
+  IteratorStats with_zone_maps;
+  NO_FATALS(scan(50000, 50100, &results, &with_zone_maps));
+  ASSERT_EQ(10, results.size());
+  EXPECT_EQ("(uint32 c0=10000, uint32 c1=50000, uint32 c2=500000)", results.front());
+  EXPECT_EQ("(uint32 c0=10018, uint32 c1=50090, uint32 c2=500900)", results.back());
+  ASSERT_GT(with_zone_maps.rows_pruned_by_zone_map, kNumRows * 9 / 10);
+
+  FLAGS_materializing_iterator_use_zone_maps = false;
+  IteratorStats without_zone_maps;
+  NO_FATALS(scan(50000, 50100, &results, &without_zone_maps));
+  ASSERT_EQ(10, results.size());
+  ASSERT_EQ(0, without_zone_maps.rows_pruned_by_zone_map);
+  ASSERT_LT(with_zone_maps.data_blocks_read_from_disk,
+            without_zone_maps.data_blocks_read_from_disk);
+  FLAGS_materializing_iterator_use_zone_maps = true;
+
+  // A predicate outside of the range of the column's values prunes the whole
+  // rowset, and one inside of it doesn't.
+  uint32_t too_large = kNumRows * 10;
+  uint32_t present = 500;
+  for (const uint32_t* value : { &too_large, &present }) {
+    gscoped_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_));
+    ASSERT_OK(cfile_iter->Init(nullptr));
+    bool pruned;
+    ASSERT_OK(cfile_iter->PruneWithZoneMap(
+        1, ColumnPredicate::Equality(schema_.column(1), value), &pruned));
+    ASSERT_EQ(value == &too_large, pruned);
+    ASSERT_EQ(!pruned, cfile_iter->HasNext());
+
+    vector<IteratorStats> stats;
+    cfile_iter->GetIteratorStats(&stats);
+    ASSERT_EQ(pruned ? 1 : 0, stats[0].rowsets_pruned_by_zone_map);
+  }
+}
+
 // Several other black-box tests for range scans. These are similar to
 // TestRangeScan above, except don't inspect internal state.
 TEST_F(TestCFileSet, TestRangePredicates2) {
@@ -311,6 +505,127 @@ TEST_F(TestCFileSet, TestRangePredicates2) {
   DoTestRangeScan(fileset, kNumRows * 10, kNoBound);
 }
 
+// Scan with batches which span several data blocks of each column, whose
+// blocks are read all at once, with and without readahead.
+TEST_F(TestCFileSet, TestBatchBlockReads) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset(new CFileSet(rowset_meta_));
+  ASSERT_OK(fileset->Open());
+
+  int64_t expected_blocks_read = -1;
+  for (bool batch_block_reads : { false, true }) {
+    for (int readahead_blocks : { 0, 4 }) {
+      FLAGS_cfile_set_batch_block_reads = batch_block_reads;
+      FLAGS_cfile_readahead_blocks = readahead_blocks;
+      SCOPED_TRACE(Substitute("batch block reads: $0, readahead blocks: $1",
+                              batch_block_reads, readahead_blocks));
+
+      shared_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_));
+      gscoped_ptr<RowwiseIterator> iter(new MaterializingIterator(cfile_iter));
+      ASSERT_OK(iter->Init(nullptr));
+
+      Arena arena(1024, 1024);
+      RowBlock block(schema_, 1000, &arena);
+      int i = 0;
+      while (iter->HasNext()) {
+        ASSERT_OK_FAST(iter->NextBlock(&block));
+        for (size_t j = 0; j < block.nrows(); j++, i++) {
+          RowBlockRow row = block.row(j);
+          ASSERT_EQ(i * 2, *schema_.ExtractColumnFromRow<UINT32>(row, 0));
+          ASSERT_EQ(i * 10, *schema_.ExtractColumnFromRow<UINT32>(row, 1));
+          ASSERT_EQ(i * 100, *schema_.ExtractColumnFromRow<UINT32>(row, 2));
+        }
+      }
+      ASSERT_EQ(kNumRows, i);
+
+      // Every data block is read exactly once either way.
+      vector<IteratorStats> stats;
+      cfile_iter->GetIteratorStats(&stats);
+      int64_t blocks_read = 0;
+      for (const IteratorStats& s : stats) {
+        blocks_read += s.data_blocks_read_from_disk;
+      }
+      if (expected_blocks_read == -1) {
+        expected_blocks_read = blocks_read;
+      }
+      ASSERT_EQ(expected_blocks_read, blocks_read);
+    }
+  }
+}
+
+// Scan with a predicate which rules out all the batches but one: the blocks of
+// the columns without predicates are not read for the batches ruled out,
+// whether they are read all at once or not.
+TEST_F(TestCFileSet, TestBatchBlockReadsWithPredicate) {
+  const int kNumRows = 10000;
+  WriteTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset(new CFileSet(rowset_meta_));
+  ASSERT_OK(fileset->Open());
+  FLAGS_materializing_iterator_use_zone_maps = false;
+  FLAGS_cfile_readahead_blocks = 0;
+
+  uint32_t value = 5000 * 10;
+  vector<IteratorStats> expected_stats;
+  for (bool batch_block_reads : { false, true }) {
+    FLAGS_cfile_set_batch_block_reads = batch_block_reads;
+    SCOPED_TRACE(batch_block_reads);
+
+    ScanSpec spec;
+    spec.AddPredicate(ColumnPredicate::Equality(schema_.column(1), &value));
+    shared_ptr<CFileSet::Iterator> cfile_iter(fileset->NewIterator(&schema_));
+    gscoped_ptr<RowwiseIterator> iter(new MaterializingIterator(cfile_iter));
+    ASSERT_OK(iter->Init(&spec));
+
+    Arena arena(1024, 1024);
+    RowBlock block(schema_, 100, &arena);
+    int num_selected = 0;
+    while (iter->HasNext()) {
+      ASSERT_OK_FAST(iter->NextBlock(&block));
+      num_selected += block.selection_vector()->CountSelected();
+    }
+    ASSERT_EQ(1, num_selected);
+
+    vector<IteratorStats> stats;
+    cfile_iter->GetIteratorStats(&stats);
+    ASSERT_EQ(3, stats.size());
+    // The column with the predicate is read whole, unlike the last column,
+    // which only needs the blocks of the batch which passes the predicate.
+    ASSERT_LT(stats[2].data_blocks_read_from_disk, stats[1].data_blocks_read_from_disk);
+    if (expected_stats.empty()) {
+      expected_stats = stats;
+    }
+    for (int i = 0; i < stats.size(); i++) {
+      SCOPED_TRACE(i);
+      ASSERT_EQ(expected_stats[i].data_blocks_read_from_disk, stats[i].data_blocks_read_from_disk);
+    }
+  }
+}
+
+// Scan with predicates of varying selectivity on a non-key column, with and
+// without skipping the decoding of filtered-out rows in the columns
+// materialized after it.
+TEST_F(TestCFileSet, TestSelectiveMaterialization) {
+  const int kNumRows = AllowSlowTests() ? 1000000 : 100000;
+  WriteScatteredTestRowSet(kNumRows);
+
+  shared_ptr<CFileSet> fileset(new CFileSet(rowset_meta_));
+  ASSERT_OK(fileset->Open());
+
+  for (uint32_t selectivity_pct : { 1, 10, 50 }) {
+    for (bool decode_selected_only : { false, true }) {
+      FLAGS_materializing_iterator_decode_selected_only = decode_selected_only;
+      LOG_TIMING(INFO, Substitute("scanning with $0% selectivity ($1)", selectivity_pct,
+                                  decode_selected_only ? "decoding selected rows only" :
+                                                         "decoding all rows")) {
+        NO_FATALS(DoTestScatteredScan(fileset, selectivity_pct,
+                                      kNumRows / 100 * selectivity_pct));
+      }
+    }
+  }
+}
 
 } // namespace tablet
 } // namespace kudu
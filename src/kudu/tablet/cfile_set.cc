@@ -22,6 +22,8 @@
 #include "kudu/cfile/bloomfile.h"
 #include "kudu/cfile/cfile_util.h"
 #include "kudu/cfile/cfile_writer.h"
+#include "kudu/common/column_predicate.h"
+#include "kudu/common/encoded_key.h"
 #include "kudu/common/scan_spec.h"
 #include "kudu/gutil/dynamic_annotations.h"
 #include "kudu/gutil/map-util.h"
@@ -31,9 +33,20 @@
 #include "kudu/tablet/cfile_set.h"
 #include "kudu/util/flag_tags.h"
 
-DEFINE_bool(consult_bloom_filters, true, "Whether to consult bloom filters on row presence checks");
+DEFINE_bool(consult_bloom_filters, true, "Whether to consult bloom filters on row presence "
+            "checks, and on scans which are bounded to a single primary key");
 TAG_FLAG(consult_bloom_filters, hidden);
 
+DEFINE_bool(cfile_set_batch_block_reads, true,
+            "Whether scans read the data blocks which the columns of a batch need all "
+            "at once, so that blocks which are adjacent on disk are read with a single "
+            "I/O. The blocks of the columns with predicates are not included: those "
+            "are read first, and the blocks of the other columns are only read if "
+            "some rows of the batch pass the predicates. Otherwise, each column reads "
+            "its blocks when it is materialized.");
+TAG_FLAG(cfile_set_batch_block_reads, advanced);
+TAG_FLAG(cfile_set_batch_block_reads, runtime);
+
 namespace kudu {
 namespace tablet {
 
@@ -194,25 +207,43 @@ uint64_t CFileSet::EstimateOnDiskSize() const {
   return ret;
 }
 
+Status CFileSet::CheckBloomFilter(const BloomKeyProbe& probe, bool* consulted,
+                                  bool* maybe_present) const {
+  *consulted = false;
+  *maybe_present = true;
+  if (bloom_reader_ == nullptr || !FLAGS_consult_bloom_filters) {
+    return Status::OK();
+  }
+
+  // Fully open the BloomFileReader if it was lazily opened earlier.
+  //
+  // If it's already initialized, this is a no-op.
+  RETURN_NOT_OK(bloom_reader_->Init());
+
+  *consulted = true;
+  bool present;
+  Status s = bloom_reader_->CheckKeyPresent(probe, &present);
+  if (s.ok()) {
+    *maybe_present = present;
+  } else {
+    LOG(WARNING) << "Unable to query bloom: " << s.ToString()
+                 << " (disabling bloom for this rowset from this point forward)";
+    const_cast<CFileSet *>(this)->bloom_reader_.reset(nullptr);
+    // Continue with the slow path
+  }
+  return Status::OK();
+}
+
 Status CFileSet::FindRow(const RowSetKeyProbe &probe, rowid_t *idx,
                          ProbeStats* stats) const {
-  if (bloom_reader_ != nullptr && FLAGS_consult_bloom_filters) {
-    // Fully open the BloomFileReader if it was lazily opened earlier.
-    //
-    // If it's already initialized, this is a no-op.
-    RETURN_NOT_OK(bloom_reader_->Init());
-
+  bool consulted;
+  bool maybe_present;
+  RETURN_NOT_OK(CheckBloomFilter(probe.bloom_probe(), &consulted, &maybe_present));
+  if (consulted) {
     stats->blooms_consulted++;
-    bool present;
-    Status s = bloom_reader_->CheckKeyPresent(probe.bloom_probe(), &present);
-    if (s.ok() && !present) {
-      return Status::NotFound("not present in bloom filter");
-    } else if (!s.ok()) {
-      LOG(WARNING) << "Unable to query bloom: " << s.ToString()
-                   << " (disabling bloom for this rowset from this point forward)";
-      const_cast<CFileSet *>(this)->bloom_reader_.reset(nullptr);
-      // Continue with the slow path
-    }
+  }
+  if (!maybe_present) {
+    return Status::NotFound("not present in bloom filter");
   }
 
   stats->keys_consulted++;
@@ -300,17 +331,46 @@ Status CFileSet::Iterator::CreateColumnIterators(const ScanSpec* spec) {
 Status CFileSet::Iterator::Init(ScanSpec *spec) {
   CHECK(!initted_);
 
+  // A scan of a single key which the bloom filter rules out doesn't need to
+  // look at the key index, or anything else.
+  if (spec != nullptr) {
+    RETURN_NOT_OK(PruneWithBloomFilter(*spec));
+  }
+
   // Setup Key Iterator
-  CFileIterator *tmp;
-  RETURN_NOT_OK(base_data_->NewKeyIterator(&tmp));
-  key_iter_.reset(tmp);
+  if (!pruned_by_bloom_) {
+    CFileIterator *tmp;
+    RETURN_NOT_OK(base_data_->NewKeyIterator(&tmp));
+    key_iter_.reset(tmp);
+  }
 
   // Setup column iterators.
   RETURN_NOT_OK(CreateColumnIterators(spec));
 
-  // If there is a range predicate on the key column, push that down into an
-  // ordinal range.
-  RETURN_NOT_OK(PushdownRangeScanPredicate(spec));
+  if (pruned_by_bloom_) {
+    lower_bound_idx_ = 0;
+    upper_bound_idx_ = 0;
+  } else {
+    // If there is a range predicate on the key column, push that down into an
+    // ordinal range.
+    RETURN_NOT_OK(PushdownRangeScanPredicate(spec));
+  }
+
+  cols_with_predicates_.assign(col_iters_.size(), false);
+  if (spec != nullptr) {
+    auto add_column = [&](const string& col_name) {
+      int idx = projection_->find_column(col_name);
+      if (idx != -1) {
+        cols_with_predicates_[idx] = true;
+      }
+    };
+    for (const ColumnRangePredicate& pred : spec->predicates()) {
+      add_column(pred.column().name());
+    }
+    for (const ColumnPredicate& pred : spec->column_predicates()) {
+      add_column(pred.column().name());
+    }
+  }
 
   initted_ = true;
 
@@ -321,6 +381,41 @@ Status CFileSet::Iterator::Init(ScanSpec *spec) {
   return Status::OK();
 }
 
+Status CFileSet::Iterator::PruneWithBloomFilter(const ScanSpec& spec) {
+  // The scan is bounded to a single key if the exclusive upper bound is the
+  // successor of a lower bound which covers every key column. The bounds are
+  // set this way when there are equality predicates on all the key columns.
+  const EncodedKey* lower = spec.lower_bound_key();
+  const EncodedKey* upper = spec.exclusive_upper_bound_key();
+  const Schema& tablet_schema = base_data_->tablet_schema();
+  if (lower == nullptr || upper == nullptr ||
+      lower->raw_keys().size() != tablet_schema.num_key_columns()) {
+    return Status::OK();
+  }
+
+  Arena arena(256, 4096);
+  EncodedKeyBuilder builder(&tablet_schema);
+  for (const void* raw_key : lower->raw_keys()) {
+    builder.AddColumnKey(raw_key);
+  }
+  gscoped_ptr<EncodedKey> successor(builder.BuildEncodedKey());
+  if (!EncodedKey::IncrementEncodedKey(tablet_schema, &successor, &arena).ok() ||
+      successor->encoded_key() != upper->encoded_key()) {
+    return Status::OK();
+  }
+
+  bool consulted;
+  bool maybe_present;
+  RETURN_NOT_OK(base_data_->CheckBloomFilter(BloomKeyProbe(lower->encoded_key()),
+                                             &consulted, &maybe_present));
+  pruned_by_bloom_ = !maybe_present;
+  if (pruned_by_bloom_) {
+    VLOG(1) << "Pruned " << base_data_->ToString() << ": key "
+            << lower->Stringify(tablet_schema) << " not present in bloom filter";
+  }
+  return Status::OK();
+}
+
 Status CFileSet::Iterator::PushdownRangeScanPredicate(ScanSpec *spec) {
   CHECK_GT(row_count_, 0);
 
@@ -384,6 +479,7 @@ Status CFileSet::Iterator::PushdownRangeScanPredicate(ScanSpec *spec) {
 void CFileSet::Iterator::Unprepare() {
   prepared_count_ = 0;
   cols_prepared_.assign(col_iters_.size(), false);
+  batch_blocks_read_ = false;
 }
 
 Status CFileSet::Iterator::PrepareBatch(size_t *n) {
@@ -400,6 +496,35 @@ Status CFileSet::Iterator::PrepareBatch(size_t *n) {
   return Status::OK();
 }
 
+Status CFileSet::Iterator::ReadBatchBlocks() {
+  vector<CFileReader::BlockRead> reads;
+  // The number of blocks in 'reads' of each column.
+  vector<size_t> num_reads(col_iters_.size(), 0);
+  for (size_t i = 0; i < col_iters_.size(); i++) {
+    ColumnIterator* col_iter = col_iters_[i];
+    // The columns which need a seek read their first block during the seek.
+    if (cols_prepared_[i] || !col_iter->seeked() || col_iter->GetCurrentOrdinal() != cur_idx_) {
+      continue;
+    }
+    size_t num_reads_before = reads.size();
+    RETURN_NOT_OK(col_iter->GetBatchBlocks(prepared_count_, &reads));
+    num_reads[i] = reads.size() - num_reads_before;
+  }
+  if (reads.empty()) {
+    return Status::OK();
+  }
+
+  RETURN_NOT_OK(CFileReader::ReadBlocks(
+      base_data_->rowset_metadata_->fs_manager()->block_manager(), &reads));
+  auto read = reads.begin();
+  for (size_t i = 0; i < col_iters_.size(); i++) {
+    for (size_t j = 0; j < num_reads[i]; j++, ++read) {
+      col_iters_[i]->AddBatchBlock(read->ptr, std::move(read->block));
+    }
+  }
+  return Status::OK();
+}
+
 
 Status CFileSet::Iterator::PrepareColumn(size_t idx) {
   if (cols_prepared_[idx]) {
@@ -407,6 +532,14 @@ Status CFileSet::Iterator::PrepareColumn(size_t idx) {
     return Status::OK();
   }
 
+  // Unless the batch has been ruled out by the predicates by now, the rest
+  // of the columns are about to be materialized too.
+  if (FLAGS_cfile_set_batch_block_reads && !batch_blocks_read_ &&
+      !cols_with_predicates_[idx]) {
+    batch_blocks_read_ = true;
+    RETURN_NOT_OK(ReadBatchBlocks());
+  }
+
   ColumnIterator* col_iter = col_iters_[idx];
   size_t n = prepared_count_;
 
@@ -451,6 +584,77 @@ Status CFileSet::Iterator::MaterializeColumn(size_t col_idx, ColumnBlock *dst) {
   return iter->Scan(dst);
 }
 
+Status CFileSet::Iterator::MaterializeColumnSelected(size_t col_idx, const SelectionVector& sel,
+                                                     ColumnBlock *dst) {
+  CHECK_EQ(prepared_count_, dst->nrows());
+  DCHECK_LT(col_idx, col_iters_.size());
+
+  RETURN_NOT_OK(PrepareColumn(col_idx));
+  ColumnIterator* iter = col_iters_[col_idx];
+  return iter->ScanSelected(sel, dst);
+}
+
+Status CFileSet::Iterator::MaterializeColumnNullBitmap(size_t col_idx, ColumnBlock *dst) {
+  CHECK_EQ(prepared_count_, dst->nrows());
+  DCHECK_LT(col_idx, col_iters_.size());
+
+  RETURN_NOT_OK(PrepareColumn(col_idx));
+  ColumnIterator* iter = col_iters_[col_idx];
+  return iter->ScanNullBitmap(dst);
+}
+
+Status CFileSet::Iterator::MaterializeColumnAndEvaluate(size_t col_idx,
+                                                        const ColumnPredicate& pred,
+                                                        SelectionVector *sel, ColumnBlock *dst,
+                                                        bool *evaluated) {
+  CHECK_EQ(prepared_count_, dst->nrows());
+  DCHECK_LT(col_idx, col_iters_.size());
+
+  RETURN_NOT_OK(PrepareColumn(col_idx));
+  ColumnIterator* iter = col_iters_[col_idx];
+  return iter->ScanAndEvaluate(pred, sel, dst, evaluated);
+}
+
+Status CFileSet::Iterator::EvaluateZoneMaps(size_t col_idx, const ColumnPredicate& pred,
+                                            SelectionVector *sel) {
+  CHECK_EQ(prepared_count_, sel->nrows());
+  DCHECK_LT(col_idx, col_iters_.size());
+
+  return col_iters_[col_idx]->EvaluateZoneMaps(cur_idx_, pred, sel);
+}
+
+bool CFileSet::Iterator::GetPinnedCells(size_t col_idx, PinnedCells* pinned) {
+  DCHECK_LT(col_idx, col_iters_.size());
+  if (!cols_prepared_[col_idx]) {
+    return false;
+  }
+  return col_iters_[col_idx]->GetPinnedCells(pinned);
+}
+
+Status CFileSet::Iterator::PruneWithZoneMap(size_t col_idx, const ColumnPredicate& pred,
+                                            bool *pruned) {
+  DCHECK(initted_);
+  DCHECK_EQ(prepared_count_, 0);
+  DCHECK_LT(col_idx, col_iters_.size());
+
+  *pruned = false;
+  if (cur_idx_ == upper_bound_idx_) {
+    // Nothing left to prune.
+    return Status::OK();
+  }
+
+  bool may_match;
+  RETURN_NOT_OK(col_iters_[col_idx]->MayMatchAnyRow(pred, &may_match));
+  if (!may_match) {
+    VLOG(1) << "Pruned " << base_data_->ToString() << ": zone map rules out "
+            << pred.ToString();
+    upper_bound_idx_ = cur_idx_;
+    pruned_by_zone_map_ = true;
+    *pruned = true;
+  }
+  return Status::OK();
+}
+
 Status CFileSet::Iterator::FinishBatch() {
   CHECK_GT(prepared_count_, 0);
 
@@ -479,6 +683,15 @@ void CFileSet::Iterator::GetIteratorStats(vector<IteratorStats>* stats) const {
     stats->push_back(iter->io_statistics());
     ANNOTATE_IGNORE_READS_END();
   }
+
+  // Pruned rowsets are counted against the first column only, so that
+  // summing the stats over all columns gives the number of pruned rowsets.
+  if (pruned_by_bloom_ && !stats->empty()) {
+    (*stats)[0].rowsets_pruned_by_bloom++;
+  }
+  if (pruned_by_zone_map_ && !stats->empty()) {
+    (*stats)[0].rowsets_pruned_by_zone_map++;
+  }
 }
 
 } // namespace tablet
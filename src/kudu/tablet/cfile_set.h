@@ -100,6 +100,13 @@ class CFileSet : public std::enable_shared_from_this<CFileSet> {
 
   Status OpenBloomReader();
   Status OpenAdHocIndexReader();
+
+  // Consult the bloom filter for the given key, if there is a bloom filter
+  // and consulting it is enabled. Sets '*consulted' to whether the bloom
+  // filter was used, and '*maybe_present' to false if it showed that the key
+  // is not in this rowset.
+  Status CheckBloomFilter(const BloomKeyProbe& probe, bool* consulted,
+                          bool* maybe_present) const;
   Status LoadMinMaxKeys();
 
   Status NewColumnIterator(ColumnId col_id, CFileReader::CacheControl cache_blocks,
@@ -146,8 +153,29 @@ class CFileSet::Iterator : public ColumnwiseIterator {
 
   virtual Status MaterializeColumn(size_t col_idx, ColumnBlock *dst) OVERRIDE;
 
+  virtual Status MaterializeColumnSelected(size_t col_idx, const SelectionVector& sel,
+                                           ColumnBlock *dst) OVERRIDE;
+
+  virtual Status MaterializeColumnNullBitmap(size_t col_idx, ColumnBlock *dst) OVERRIDE;
+
+  virtual Status MaterializeColumnAndEvaluate(size_t col_idx, const ColumnPredicate& pred,
+                                              SelectionVector *sel, ColumnBlock *dst,
+                                              bool *evaluated) OVERRIDE;
+
+  virtual Status EvaluateZoneMaps(size_t col_idx, const ColumnPredicate& pred,
+                                  SelectionVector *sel) OVERRIDE;
+
+  virtual bool GetPinnedCells(size_t col_idx, PinnedCells* pinned) OVERRIDE;
+
   virtual Status FinishBatch() OVERRIDE;
 
+  // Check the zone map covering the whole of the given column against
+  // 'pred', a predicate on that column. If no row can match, the iterator
+  // is emptied, and '*pruned' is set to true.
+  //
+  // Must be called after Init() and before the first batch is prepared.
+  Status PruneWithZoneMap(size_t col_idx, const ColumnPredicate& pred, bool *pruned);
+
   virtual bool HasNext() const OVERRIDE {
     DCHECK(initted_);
     return cur_idx_ < upper_bound_idx_;
@@ -181,14 +209,22 @@ class CFileSet::Iterator : public ColumnwiseIterator {
       : base_data_(std::move(base_data)),
         projection_(projection),
         initted_(false),
+        pruned_by_bloom_(false),
+        pruned_by_zone_map_(false),
         cur_idx_(0),
-        prepared_count_(0) {
+        prepared_count_(0),
+        batch_blocks_read_(false) {
     CHECK_OK(base_data_->CountRows(&row_count_));
   }
 
   // Fill in col_iters_ for each of the requested columns.
   Status CreateColumnIterators(const ScanSpec* spec);
 
+  // If the scan spec bounds the scan to a single primary key, probe the
+  // rowset's bloom filter for that key, and set pruned_by_bloom_ if the key
+  // is not present.
+  Status PruneWithBloomFilter(const ScanSpec& spec);
+
   // Look for a predicate which can be converted into a range scan using the key
   // column's index. If such a predicate exists, remove it from the scan spec and
   // store it in member fields.
@@ -199,6 +235,10 @@ class CFileSet::Iterator : public ColumnwiseIterator {
   // Prepare the given column if not already prepared.
   Status PrepareColumn(size_t col_idx);
 
+  // Read the data blocks which the columns not prepared yet need for the
+  // prepared batch beyond the blocks they hold already, all at once.
+  Status ReadBatchBlocks();
+
   const std::shared_ptr<CFileSet const> base_data_;
   const Schema* projection_;
 
@@ -208,6 +248,14 @@ class CFileSet::Iterator : public ColumnwiseIterator {
 
   bool initted_;
 
+  // Whether the bloom filter showed that the single key the scan is bounded
+  // to is not in this rowset, in which case none of it is read.
+  bool pruned_by_bloom_;
+
+  // Whether a zone map showed that no row of this rowset matches the scan's
+  // predicates, in which case none of it is read.
+  bool pruned_by_zone_map_;
+
   size_t cur_idx_;
   size_t prepared_count_;
 
@@ -226,6 +274,14 @@ class CFileSet::Iterator : public ColumnwiseIterator {
   // materialized, it doesn't need to be read off disk.
   vector<bool> cols_prepared_;
 
+  // The columns with predicates in the scan spec. They are materialized first,
+  // and may rule out every row of a batch, so the blocks of the other columns
+  // are only read once the first of those is prepared.
+  vector<bool> cols_with_predicates_;
+
+  // Whether ReadBatchBlocks() was called for the prepared batch.
+  bool batch_blocks_read_;
+
 };
 
 } // namespace tablet
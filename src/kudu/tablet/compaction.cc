@@ -24,6 +24,9 @@
 #include <unordered_set>
 #include <vector>
 
+#include "kudu/codegen/compilation_manager.h"
+#include "kudu/codegen/row_comparator.h"
+#include "kudu/common/row_comparator.h"
 #include "kudu/common/wire_protocol.h"
 #include "kudu/consensus/opid_util.h"
 #include "kudu/gutil/macros.h"
@@ -37,6 +40,11 @@
 #include "kudu/tablet/tablet.pb.h"
 #include "kudu/tablet/transactions/write_transaction.h"
 #include "kudu/util/debug/trace_event.h"
+#include "kudu/util/flag_tags.h"
+
+DEFINE_bool(compaction_use_codegen, true, "whether compactions should use code "
+            "generation to compare and copy rows");
+TAG_FLAG(compaction_use_codegen, hidden);
 
 using std::shared_ptr;
 using std::unordered_set;
@@ -47,6 +55,18 @@ namespace tablet {
 
 namespace {
 
+// If codegen is enabled and the comparator for the schema has been compiled,
+// returns a codegen::RowComparator; otherwise makes a regular one.
+gscoped_ptr<RowComparator> GenerateAppropriateComparator(const Schema* schema) {
+  if (FLAGS_compaction_use_codegen) {
+    gscoped_ptr<codegen::RowComparator> actual;
+    if (codegen::CompilationManager::GetSingleton()->RequestRowComparator(schema, &actual)) {
+      return gscoped_ptr<RowComparator>(actual.release());
+    }
+  }
+  return gscoped_ptr<RowComparator>(new RowComparator(schema));
+}
+
 // CompactionInput yielding rows and mutations from a MemRowSet.
 class MemRowSetCompactionInput : public CompactionInput {
  public:
@@ -249,11 +269,11 @@ class MergeCompactionInput : public CompactionInput {
     // row of this block is less than the first row of the other block.
     // In this case, we can remove the other input from the merge until
     // this input's current block has been exhausted.
-    bool Dominates(const MergeState &other, const Schema &schema) const {
+    bool Dominates(const MergeState &other, const RowComparator &comparator) const {
       DCHECK(!empty());
       DCHECK(!other.empty());
 
-      return schema.Compare(pending.back().row, other.next().row) < 0;
+      return comparator.Compare(pending.back().row, other.next().row) < 0;
     }
 
     shared_ptr<CompactionInput> input;
@@ -266,7 +286,8 @@ class MergeCompactionInput : public CompactionInput {
  public:
   MergeCompactionInput(const vector<shared_ptr<CompactionInput> > &inputs,
                        const Schema* schema)
-    : schema_(schema) {
+    : schema_(schema),
+      comparator_(GenerateAppropriateComparator(schema)) {
     for (const shared_ptr<CompactionInput> &input : inputs) {
       gscoped_ptr<MergeState> state(new MergeState);
       state->input = input;
@@ -331,7 +352,7 @@ class MergeCompactionInput : public CompactionInput {
           smallest = state->next();
           continue;
         }
-        int row_comp = schema_->Compare(state->next().row, smallest.row);
+        int row_comp = comparator_->Compare(state->next().row, smallest.row);
         if (row_comp < 0) {
           smallest_idx = i;
           smallest = state->next();
@@ -422,7 +443,7 @@ class MergeCompactionInput : public CompactionInput {
       // valid.
       for (auto it = state->dominated.begin(); it != state->dominated.end(); ++it) {
         MergeState *dominated = *it;
-        if (!state->Dominates(*dominated, *schema_)) {
+        if (!state->Dominates(*dominated, *comparator_)) {
           states_.push_back(dominated);
           it = state->dominated.erase(it);
           --it;
@@ -458,7 +479,7 @@ class MergeCompactionInput : public CompactionInput {
   }
 
   bool TryInsertIntoDominanceList(MergeState *dominator, MergeState *candidate) {
-    if (dominator->Dominates(*candidate, *schema_)) {
+    if (dominator->Dominates(*candidate, *comparator_)) {
       dominator->dominated.push_back(candidate);
       return true;
     } else {
@@ -509,6 +530,8 @@ class MergeCompactionInput : public CompactionInput {
   }
 
   const Schema* schema_;
+  // Compares the keys of rows of 'schema_'.
+  const gscoped_ptr<RowComparator> comparator_;
   vector<MergeState *> states_;
   Arena* prepared_block_arena_;
 };
@@ -750,6 +773,7 @@ Status FlushCompactionInput(CompactionInput* input,
   DCHECK(out->schema().has_column_ids());
 
   RowBlock block(out->schema(), 100, nullptr);
+  gscoped_ptr<RowComparator> copier(GenerateAppropriateComparator(&out->schema()));
 
   uint64_t num_rows_history_truncated = 0;
 
@@ -765,7 +789,7 @@ Status FlushCompactionInput(CompactionInput* input,
       DCHECK(schema->has_column_ids());
 
       RowBlockRow dst_row = block.row(n);
-      RETURN_NOT_OK(CopyRow(input_row.row, &dst_row, reinterpret_cast<Arena*>(NULL)));
+      RETURN_NOT_OK(copier->Copy(input_row.row, &dst_row, reinterpret_cast<Arena*>(NULL)));
 
       DVLOG(2) << "Input Row: " << dst_row.schema()->DebugRow(dst_row) <<
         " RowId: " << input_row.row.row_index() <<
@@ -20,12 +20,16 @@
 #include <string>
 #include <vector>
 
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/iterator.h"
+#include "kudu/common/scan_spec.h"
 #include "kudu/tablet/delta_store.h"
+#include "kudu/util/memory/arena.h"
 #include "kudu/util/status.h"
 
 using std::shared_ptr;
 using std::string;
+using std::vector;
 
 namespace kudu {
 namespace tablet {
@@ -43,6 +47,48 @@ DeltaApplier::~DeltaApplier() {
 Status DeltaApplier::Init(ScanSpec *spec) {
   RETURN_NOT_OK(base_iter_->Init(spec));
   RETURN_NOT_OK(delta_iter_->Init(spec));
+  if (spec != nullptr) {
+    RETURN_NOT_OK(PruneWithZoneMaps(*spec));
+  }
+  return Status::OK();
+}
+
+Status DeltaApplier::PruneWithZoneMaps(const ScanSpec& spec) {
+  if (!base_iter_->HasNext()) {
+    // Already pruned by other means.
+    return Status::OK();
+  }
+  // Range predicates, which is what clients send for comparisons, are
+  // turned into column predicates to be checked against the zone maps too.
+  Arena arena(256, 4096);
+  vector<ColumnPredicate> preds;
+  for (const ColumnRangePredicate& range_pred : spec.predicates()) {
+    boost::optional<ColumnPredicate> pred = range_pred.ToColumnPredicate(&arena);
+    if (pred) {
+      preds.push_back(std::move(*pred));
+    }
+  }
+  preds.insert(preds.end(), spec.column_predicates().begin(), spec.column_predicates().end());
+
+  for (const ColumnPredicate& pred : preds) {
+    int col_idx = schema().find_column(pred.column().name());
+    if (col_idx == Schema::kColumnNotFound) {
+      continue;
+    }
+
+    // The zone maps only describe the base data.
+    bool may_have_updates;
+    RETURN_NOT_OK(delta_iter_->MayHaveUpdates(col_idx, &may_have_updates));
+    if (may_have_updates) {
+      continue;
+    }
+
+    bool pruned;
+    RETURN_NOT_OK(base_iter_->PruneWithZoneMap(col_idx, pred, &pruned));
+    if (pruned) {
+      break;
+    }
+  }
   return Status::OK();
 }
 
@@ -103,5 +149,69 @@ Status DeltaApplier::MaterializeColumn(size_t col_idx, ColumnBlock *dst) {
   return Status::OK();
 }
 
+Status DeltaApplier::MaterializeColumnSelected(size_t col_idx, const SelectionVector& sel,
+                                               ColumnBlock *dst) {
+  DCHECK(!first_prepare_) << "PrepareBatch() must be called at least once";
+
+  // Copy the selected base data. Updates to unselected rows may still be
+  // applied below, but since they overwrite whole cells that is harmless.
+  RETURN_NOT_OK(base_iter_->MaterializeColumnSelected(col_idx, sel, dst));
+
+  // Apply all the updates for this column.
+  RETURN_NOT_OK(delta_iter_->ApplyUpdates(col_idx, dst));
+  return Status::OK();
+}
+
+Status DeltaApplier::MaterializeColumnNullBitmap(size_t col_idx, ColumnBlock *dst) {
+  DCHECK(!first_prepare_) << "PrepareBatch() must be called at least once";
+
+  // Copy the base null bitmap.
+  RETURN_NOT_OK(base_iter_->MaterializeColumnNullBitmap(col_idx, dst));
+
+  // Updates may set or clear the null bit of a cell, so they must be applied
+  // too. This also writes the updated cells, which is harmless.
+  RETURN_NOT_OK(delta_iter_->ApplyUpdates(col_idx, dst));
+  return Status::OK();
+}
+
+Status DeltaApplier::MaterializeColumnAndEvaluate(size_t col_idx, const ColumnPredicate& pred,
+                                                  SelectionVector *sel, ColumnBlock *dst,
+                                                  bool *evaluated) {
+  DCHECK(!first_prepare_) << "PrepareBatch() must be called at least once";
+
+  // Updates may change whether a row matches the predicate, so it can only be
+  // evaluated on the base data if there are none.
+  bool may_have_updates;
+  RETURN_NOT_OK(delta_iter_->MayHaveUpdates(col_idx, &may_have_updates));
+  if (may_have_updates) {
+    *evaluated = false;
+    return MaterializeColumnSelected(col_idx, *sel, dst);
+  }
+  return base_iter_->MaterializeColumnAndEvaluate(col_idx, pred, sel, dst, evaluated);
+}
+
+Status DeltaApplier::EvaluateZoneMaps(size_t col_idx, const ColumnPredicate& pred,
+                                      SelectionVector *sel) {
+  DCHECK(!first_prepare_) << "PrepareBatch() must be called at least once";
+
+  bool may_have_updates;
+  RETURN_NOT_OK(delta_iter_->MayHaveUpdates(col_idx, &may_have_updates));
+  if (may_have_updates) {
+    return Status::OK();
+  }
+  return base_iter_->EvaluateZoneMaps(col_idx, pred, sel);
+}
+
+bool DeltaApplier::GetPinnedCells(size_t col_idx, PinnedCells* pinned) {
+  DCHECK(!first_prepare_) << "PrepareBatch() must be called at least once";
+
+  bool may_have_updates;
+  Status s = delta_iter_->MayHaveUpdates(col_idx, &may_have_updates);
+  if (!s.ok() || may_have_updates) {
+    return false;
+  }
+  return base_iter_->GetPinnedCells(col_idx, pinned);
+}
+
 } // namespace tablet
 } // namespace kudu
@@ -62,6 +62,26 @@ class DeltaApplier : public ColumnwiseIterator {
   virtual Status InitializeSelectionVector(SelectionVector *sel_vec) OVERRIDE;
 
   Status MaterializeColumn(size_t col_idx, ColumnBlock *dst) OVERRIDE;
+
+  Status MaterializeColumnSelected(size_t col_idx, const SelectionVector& sel,
+                                   ColumnBlock *dst) OVERRIDE;
+
+  Status MaterializeColumnNullBitmap(size_t col_idx, ColumnBlock *dst) OVERRIDE;
+
+  // Evaluates the predicate on the base data if the column has no updates in
+  // the current batch. See ColumnwiseIterator::MaterializeColumnAndEvaluate().
+  Status MaterializeColumnAndEvaluate(size_t col_idx, const ColumnPredicate& pred,
+                                      SelectionVector *sel, ColumnBlock *dst,
+                                      bool *evaluated) OVERRIDE;
+
+  // Use the zone maps of the base data to rule out rows, unless the column
+  // may have been updated.
+  Status EvaluateZoneMaps(size_t col_idx, const ColumnPredicate& pred,
+                          SelectionVector *sel) OVERRIDE;
+
+  // Pass the cells of the base data through, unless the column may have been
+  // updated.
+  bool GetPinnedCells(size_t col_idx, PinnedCells* pinned) OVERRIDE;
  private:
   friend class DeltaTracker;
 
@@ -74,6 +94,10 @@ class DeltaApplier : public ColumnwiseIterator {
                std::shared_ptr<DeltaIterator> delta_iter);
   virtual ~DeltaApplier();
 
+  // Skip the whole rowset if the zone map of the base data of a column which
+  // hasn't been updated shows that one of the spec's predicates can't match.
+  Status PruneWithZoneMaps(const ScanSpec& spec);
+
   std::shared_ptr<CFileSet::Iterator> base_iter_;
   std::shared_ptr<DeltaIterator> delta_iter_;
 
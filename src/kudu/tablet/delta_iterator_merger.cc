@@ -71,6 +71,17 @@ Status DeltaIteratorMerger::ApplyDeletes(SelectionVector *sel_vec) {
   return Status::OK();
 }
 
+Status DeltaIteratorMerger::MayHaveUpdates(size_t col_idx, bool *may_have_updates) {
+  *may_have_updates = false;
+  for (const shared_ptr<DeltaIterator> &iter : iters_) {
+    RETURN_NOT_OK(iter->MayHaveUpdates(col_idx, may_have_updates));
+    if (*may_have_updates) {
+      break;
+    }
+  }
+  return Status::OK();
+}
+
 Status DeltaIteratorMerger::CollectMutations(vector<Mutation *> *dst, Arena *arena) {
   for (const shared_ptr<DeltaIterator> &iter : iters_) {
     RETURN_NOT_OK(iter->CollectMutations(dst, arena));
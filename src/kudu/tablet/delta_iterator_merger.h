@@ -52,6 +52,7 @@ class DeltaIteratorMerger : public DeltaIterator {
   virtual Status PrepareBatch(size_t nrows, PrepareFlag flag) OVERRIDE;
   virtual Status ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) OVERRIDE;
   virtual Status ApplyDeletes(SelectionVector *sel_vec) OVERRIDE;
+  virtual Status MayHaveUpdates(size_t col_idx, bool *may_have_updates) OVERRIDE;
   virtual Status CollectMutations(vector<Mutation *> *dst, Arena *arena) OVERRIDE;
   virtual Status FilterColumnIdsAndCollectDeltas(const std::vector<ColumnId>& col_ids,
                                                  vector<DeltaKeyAndUpdate>* out,
@@ -149,6 +149,11 @@ class DeltaIterator {
   // Must have called PrepareBatch() with flag = PREPARE_FOR_APPLY.
   virtual Status ApplyDeletes(SelectionVector *sel_vec) = 0;
 
+  // Set '*may_have_updates' to false if it is known that none of the deltas
+  // update the given column of the projection, so that the column's values
+  // are the same as in the base data. May be called at any time after Init().
+  virtual Status MayHaveUpdates(size_t col_idx, bool *may_have_updates) = 0;
+
   // Collect the mutations associated with each row in the current prepared batch.
   //
   // Each entry in the vector will be treated as a singly linked list of Mutation
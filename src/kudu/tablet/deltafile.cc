@@ -716,6 +716,14 @@ inline Status DeletingVisitor<UNDO>::Visit(const DeltaKey& key,
 }
 
 
+Status DeltaFileIterator::MayHaveUpdates(size_t col_idx, bool *may_have_updates) {
+  // The delta stats are read along with the rest of the file's metadata.
+  RETURN_NOT_OK(dfr_->Init());
+  ColumnId col_id = projection_->column_id(col_idx);
+  *may_have_updates = dfr_->delta_stats().update_count_for_col_id(col_id) > 0;
+  return Status::OK();
+}
+
 Status DeltaFileIterator::ApplyDeletes(SelectionVector *sel_vec) {
   DCHECK_LE(prepared_count_, sel_vec->nrows());
   if (delta_type_ == REDO) {
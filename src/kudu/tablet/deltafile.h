@@ -192,6 +192,7 @@ class DeltaFileIterator : public DeltaIterator {
   Status PrepareBatch(size_t nrows, PrepareFlag flag) OVERRIDE;
   Status ApplyUpdates(size_t col_to_apply, ColumnBlock *dst) OVERRIDE;
   Status ApplyDeletes(SelectionVector *sel_vec) OVERRIDE;
+  Status MayHaveUpdates(size_t col_idx, bool *may_have_updates) OVERRIDE;
   Status CollectMutations(vector<Mutation *> *dst, Arena *arena) OVERRIDE;
   Status FilterColumnIdsAndCollectDeltas(const std::vector<ColumnId>& col_ids,
                                          vector<DeltaKeyAndUpdate>* out,
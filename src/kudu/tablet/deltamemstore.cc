@@ -336,6 +336,13 @@ Status DMSIterator::ApplyDeletes(SelectionVector *sel_vec) {
 }
 
 
+Status DMSIterator::MayHaveUpdates(size_t col_idx, bool *may_have_updates) {
+  // The DMS doesn't track which columns are updated, but it is usually
+  // small or empty.
+  *may_have_updates = !dms_->Empty();
+  return Status::OK();
+}
+
 Status DMSIterator::CollectMutations(vector<Mutation *> *dst, Arena *arena) {
   DCHECK_EQ(prepared_for_, PREPARED_FOR_COLLECT);
   for (const PreparedDelta& src : prepared_deltas_) {
@@ -194,6 +194,8 @@ class DMSIterator : public DeltaIterator {
 
   Status ApplyDeletes(SelectionVector *sel_vec) OVERRIDE;
 
+  Status MayHaveUpdates(size_t col_idx, bool *may_have_updates) OVERRIDE;
+
   Status CollectMutations(vector<Mutation *> *dst, Arena *arena) OVERRIDE;
 
   Status FilterColumnIdsAndCollectDeltas(const vector<ColumnId>& col_ids,
@@ -296,6 +296,52 @@ TEST_F(TestRowSet, TestDMSFlush) {
   }
 }
 
+// Test that the zone maps of the base data are only used to prune a rowset
+// when the predicated column has no updates.
+TEST_F(TestRowSet, TestZoneMapPruningWithUpdates) {
+  WriteTestRowSet();
+  shared_ptr<DiskRowSet> rs;
+  ASSERT_OK(OpenTestRowSet(&rs));
+
+  // Scan for 'val >= n_rows_', which no row of the base data matches.
+  auto scan = [&] (int* num_rows, bool* pruned) {
+    MvccSnapshot snap = MvccSnapshot::CreateSnapshotIncludingAllTransactions();
+    gscoped_ptr<RowwiseIterator> iter;
+    ASSERT_OK(rs->NewRowIterator(&schema_, snap, &iter));
+    uint32_t lower = n_rows_;
+    ScanSpec spec;
+    spec.AddPredicate(ColumnPredicate::Range(schema_.column(1), &lower, nullptr));
+    ASSERT_OK(iter->Init(&spec));
+
+    vector<string> rows;
+    ASSERT_OK(IterateToStringList(iter.get(), &rows));
+    *num_rows = rows.size();
+
+    vector<IteratorStats> stats;
+    iter->GetIteratorStats(&stats);
+    *pruned = stats[0].rowsets_pruned_by_zone_map == 1;
+  };
+
+  int num_rows;
+  bool pruned;
+  NO_FATALS(scan(&num_rows, &pruned));
+  ASSERT_EQ(0, num_rows);
+  ASSERT_TRUE(pruned);
+
+  // Update a row so that it matches. The update is found both while in the
+  // DMS and once flushed to a delta file.
+  OperationResultPB result;
+  ASSERT_OK(UpdateRow(rs.get(), 10, n_rows_ + 1, &result));
+  NO_FATALS(scan(&num_rows, &pruned));
+  ASSERT_EQ(1, num_rows);
+  ASSERT_FALSE(pruned);
+
+  ASSERT_OK(rs->FlushDeltas());
+  NO_FATALS(scan(&num_rows, &pruned));
+  ASSERT_EQ(1, num_rows);
+  ASSERT_FALSE(pruned);
+}
+
 // Test that when a single row is updated multiple times, we can query the
 // historical values using MVCC, even after it is flushed.
 TEST_F(TestRowSet, TestFlushedUpdatesRespectMVCC) {
@@ -17,13 +17,16 @@
 
 #include "kudu/tablet/memrowset.h"
 
+#include <algorithm>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <string>
 #include <vector>
 
 #include "kudu/codegen/compilation_manager.h"
+#include "kudu/codegen/predicate_evaluator.h"
 #include "kudu/codegen/row_projector.h"
+#include "kudu/common/column_predicate.h"
 #include "kudu/common/common.pb.h"
 #include "kudu/common/generic_iterators.h"
 #include "kudu/common/row.h"
@@ -41,6 +44,7 @@ TAG_FLAG(mrs_use_codegen, hidden);
 
 using std::pair;
 using std::shared_ptr;
+using std::vector;
 
 namespace kudu { namespace tablet {
 
@@ -416,6 +420,29 @@ Status MemRowSet::Iterator::Init(ScanSpec *spec) {
     exclusive_upper_bound_.reset(upper_bound);
   }
 
+  // If a generated evaluator for the column predicates is ready, evaluate
+  // them all in a single pass over each block instead of leaving them to a
+  // PredicateEvaluatingIterator, which makes one pass per predicate. The
+  // most selective predicates go first, so that the others are skipped on
+  // the rows they filter out.
+  if (FLAGS_mrs_use_codegen && spec && !spec->column_predicates().empty()) {
+    vector<ColumnPredicate> predicates = spec->column_predicates();
+    std::stable_sort(predicates.begin(), predicates.end(),
+                     [] (const ColumnPredicate& left, const ColumnPredicate& right) {
+                       return SelectivityComparator(left, right) < 0;
+                     });
+    bool all_projected = std::all_of(
+        predicates.begin(), predicates.end(),
+        [&] (const ColumnPredicate& pred) {
+          return projection_->find_column(pred.column().name()) != Schema::kColumnNotFound;
+        });
+    if (all_projected &&
+        codegen::CompilationManager::GetSingleton()->RequestPredicateEvaluator(
+            projection_, predicates, &predicate_evaluator_)) {
+      spec->mutable_column_predicates()->clear();
+    }
+  }
+
   state_ = kScanning;
   return Status::OK();
 }
@@ -473,6 +500,10 @@ Status MemRowSet::Iterator::NextBlock(RowBlock *dst) {
   // Clear unreached bits by resizing
   dst->Resize(fetched);
 
+  if (predicate_evaluator_) {
+    predicate_evaluator_->Evaluate(*dst, dst->selection_vector());
+  }
+
   return Status::OK();
 }
 
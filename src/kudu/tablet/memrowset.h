@@ -38,6 +38,10 @@ namespace kudu {
 
 class MemTracker;
 
+namespace codegen {
+class PredicateEvaluator;
+} // namespace codegen
+
 namespace tablet {
 
 //
@@ -487,6 +491,12 @@ class MemRowSet::Iterator : public RowwiseIterator {
   gscoped_ptr<MRSRowProjector> projector_;
   DeltaProjector delta_projector_;
 
+  // Generated evaluator of the column predicates of the scan spec, if code
+  // generation is enabled and one was ready when the iterator was
+  // initialized. Otherwise, the predicates are left in the scan spec to be
+  // evaluated by a PredicateEvaluatingIterator.
+  gscoped_ptr<codegen::PredicateEvaluator> predicate_evaluator_;
+
   // Temporary buffer used for RowChangeList projection.
   faststring delta_buf_;
 
@@ -59,6 +59,10 @@ Status MultiColumnWriter::Open() {
     // the corresponding rows.
     opts.write_posidx = true;
 
+    // Keep min/max statistics so that scans can skip blocks and whole
+    // rowsets which don't match their predicates.
+    opts.write_zone_maps = true;
+
     /// Set the column storage attributes.
     opts.storage_attributes = col.attributes();
 
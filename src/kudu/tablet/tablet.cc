@@ -28,7 +28,10 @@
 #include <vector>
 
 #include "kudu/cfile/cfile_writer.h"
+#include "kudu/codegen/compilation_manager.h"
+#include "kudu/codegen/row_comparator.h"
 #include "kudu/common/iterator.h"
+#include "kudu/common/row_comparator.h"
 #include "kudu/common/row_changelist.h"
 #include "kudu/common/row_operations.h"
 #include "kudu/common/scan_spec.h"
@@ -73,6 +76,10 @@ DEFINE_bool(tablet_do_dup_key_checks, true,
             "Use at your own risk!");
 TAG_FLAG(tablet_do_dup_key_checks, unsafe);
 
+DEFINE_bool(tablet_ordered_scan_use_codegen, true, "whether ordered scans should "
+            "use code generation to compare and copy rows while merging rowsets");
+TAG_FLAG(tablet_ordered_scan_use_codegen, hidden);
+
 DEFINE_int32(tablet_compaction_budget_mb, 128,
              "Budget for a single compaction");
 TAG_FLAG(tablet_compaction_budget_mb, experimental);
@@ -1796,9 +1803,18 @@ Status Tablet::Iterator::Init(ScanSpec *spec) {
       &projection_, snap_, spec, &iters));
 
   switch (order_) {
-    case ORDERED:
-      iter_.reset(new MergeIterator(projection_, iters));
+    case ORDERED: {
+      // If codegen is enabled and the comparator has been compiled, use it;
+      // otherwise the MergeIterator falls back to an interpreted one.
+      gscoped_ptr<codegen::RowComparator> comparator;
+      if (FLAGS_tablet_ordered_scan_use_codegen) {
+        codegen::CompilationManager::GetSingleton()->RequestRowComparator(
+            &projection_, &comparator);
+      }
+      iter_.reset(new MergeIterator(projection_, iters,
+                                    gscoped_ptr<RowComparator>(comparator.release())));
       break;
+    }
     case UNORDERED:
     default:
       iter_.reset(new UnionIterator(iters));
@@ -84,6 +84,48 @@ METRIC_DEFINE_counter(tablet, scanner_bytes_scanned_from_disk, "Scanner Bytes Sc
                       "and does not include data read from in-memory stores. However, it"
                       "includes both cache misses and cache hits.");
 
+METRIC_DEFINE_counter(tablet, scanner_data_blocks_scanned_from_disk,
+                      "Scanner Data Blocks Scanned From Disk",
+                      kudu::MetricUnit::kBlocks,
+                      "Number of data blocks read by scan requests. This includes "
+                      "both cache misses and cache hits.");
+
+METRIC_DEFINE_counter(tablet, scanner_data_blocks_prefetched,
+                      "Scanner Data Blocks Prefetched",
+                      kudu::MetricUnit::kBlocks,
+                      "Number of the data blocks read by scan requests which had "
+                      "already been read ahead by the time the scan needed them. The "
+                      "ratio to scanner_data_blocks_scanned_from_disk is the prefetch "
+                      "hit ratio.");
+
+METRIC_DEFINE_counter(tablet, scanner_rowsets_pruned_by_bloom,
+                      "Scanner RowSets Pruned By Bloom Filter",
+                      kudu::MetricUnit::kUnits,
+                      "Number of DiskRowSets skipped by scan requests because the scan "
+                      "was bounded to a single primary key which the rowset's bloom "
+                      "filter showed to be absent.");
+
+METRIC_DEFINE_counter(tablet, scanner_rows_pruned_by_zone_map,
+                      "Scanner Rows Pruned By Zone Maps",
+                      kudu::MetricUnit::kRows,
+                      "Number of rows skipped by scan requests without being read because "
+                      "the min/max zone maps of their blocks showed that they could not "
+                      "match the scan's predicates.");
+
+METRIC_DEFINE_counter(tablet, scanner_rowsets_pruned_by_zone_map,
+                      "Scanner RowSets Pruned By Zone Maps",
+                      kudu::MetricUnit::kUnits,
+                      "Number of DiskRowSets skipped by scan requests because the min/max "
+                      "zone map of one of their columns showed that no row could match "
+                      "the scan's predicates.");
+
+METRIC_DEFINE_counter(tablet, scanner_cells_evaluated_on_dict_codes,
+                      "Scanner Cells Evaluated On Dictionary Codes",
+                      kudu::MetricUnit::kCells,
+                      "Number of dictionary-encoded cells against which scan requests "
+                      "evaluated a predicate on their dictionary codes, without copying "
+                      "their strings.");
+
 
 METRIC_DEFINE_counter(tablet, insertions_failed_dup_key, "Duplicate Key Inserts",
                       kudu::MetricUnit::kRows,
@@ -229,6 +271,12 @@ TabletMetrics::TabletMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(scanner_rows_scanned),
     MINIT(scanner_cells_scanned_from_disk),
     MINIT(scanner_bytes_scanned_from_disk),
+    MINIT(scanner_data_blocks_scanned_from_disk),
+    MINIT(scanner_data_blocks_prefetched),
+    MINIT(scanner_rowsets_pruned_by_bloom),
+    MINIT(scanner_rows_pruned_by_zone_map),
+    MINIT(scanner_rowsets_pruned_by_zone_map),
+    MINIT(scanner_cells_evaluated_on_dict_codes),
     MINIT(scans_started),
     MINIT(bloom_lookups),
     MINIT(key_file_lookups),
@@ -56,6 +56,12 @@ struct TabletMetrics {
   scoped_refptr<Counter> scanner_rows_scanned;
   scoped_refptr<Counter> scanner_cells_scanned_from_disk;
   scoped_refptr<Counter> scanner_bytes_scanned_from_disk;
+  scoped_refptr<Counter> scanner_data_blocks_scanned_from_disk;
+  scoped_refptr<Counter> scanner_data_blocks_prefetched;
+  scoped_refptr<Counter> scanner_rowsets_pruned_by_bloom;
+  scoped_refptr<Counter> scanner_rows_pruned_by_zone_map;
+  scoped_refptr<Counter> scanner_rowsets_pruned_by_zone_map;
+  scoped_refptr<Counter> scanner_cells_evaluated_on_dict_codes;
   scoped_refptr<Counter> scans_started;
 
   // Probe stats
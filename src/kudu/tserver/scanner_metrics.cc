@@ -30,6 +30,24 @@ METRIC_DEFINE_histogram(server, scanner_duration,
                         "Histogram of the duration of active scanners on this tablet.",
                         60000000LU, 2);
 
+METRIC_DEFINE_counter(server, scanner_sidecar_bytes_before_compression,
+                      "Scan Sidecar Bytes Before Compression",
+                      kudu::MetricUnit::kBytes,
+                      "Number of bytes of scan response sidecars handed to a compression "
+                      "codec, for scans which negotiated sidecar compression");
+
+METRIC_DEFINE_counter(server, scanner_sidecar_bytes_saved_by_compression,
+                      "Scan Sidecar Bytes Saved By Compression",
+                      kudu::MetricUnit::kBytes,
+                      "Number of bytes by which compression shrank the scan response "
+                      "sidecars sent to clients");
+
+METRIC_DEFINE_counter(server, scanner_sidecar_compression_cpu_time,
+                      "Scan Sidecar Compression CPU Time",
+                      kudu::MetricUnit::kMicroseconds,
+                      "Total user and system CPU time spent compressing scan response "
+                      "sidecars");
+
 namespace kudu {
 
 namespace tserver {
@@ -37,7 +55,13 @@ namespace tserver {
 ScannerMetrics::ScannerMetrics(const scoped_refptr<MetricEntity>& metric_entity)
     : scanners_expired(
           METRIC_scanners_expired.Instantiate(metric_entity)),
-      scanner_duration(METRIC_scanner_duration.Instantiate(metric_entity)) {
+      scanner_duration(METRIC_scanner_duration.Instantiate(metric_entity)),
+      scanner_sidecar_bytes_before_compression(
+          METRIC_scanner_sidecar_bytes_before_compression.Instantiate(metric_entity)),
+      scanner_sidecar_bytes_saved_by_compression(
+          METRIC_scanner_sidecar_bytes_saved_by_compression.Instantiate(metric_entity)),
+      scanner_sidecar_compression_cpu_time(
+          METRIC_scanner_sidecar_compression_cpu_time.Instantiate(metric_entity)) {
 }
 
 void ScannerMetrics::SubmitScannerDuration(const MonoTime& time_started) {
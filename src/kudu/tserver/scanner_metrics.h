@@ -43,6 +43,12 @@ struct ScannerMetrics {
 
   // Keeps track of the duration of scanners.
   scoped_refptr<Histogram> scanner_duration;
+
+  // Keep track of the compression of scan response sidecars: the bytes
+  // handed to the codecs, the bytes saved, and the CPU time spent.
+  scoped_refptr<Counter> scanner_sidecar_bytes_before_compression;
+  scoped_refptr<Counter> scanner_sidecar_bytes_saved_by_compression;
+  scoped_refptr<Counter> scanner_sidecar_compression_cpu_time;
 };
 
 } // namespace tserver
@@ -187,6 +187,8 @@ Scanner::Scanner(string id, const scoped_refptr<TabletPeer>& tablet_peer,
       call_seq_id_(0),
       start_time_(MonoTime::Now(MonoTime::COARSE)),
       metrics_(metrics),
+      row_format_flags_(0),
+      sidecar_compression_(NO_COMPRESSION),
       arena_(1024, 1024 * 1024) {
   UpdateAccessTime();
 }
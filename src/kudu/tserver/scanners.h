@@ -24,6 +24,8 @@
 #include <utility>
 #include <vector>
 
+#include "kudu/common/aggregate.h"
+#include "kudu/common/common.pb.h"
 #include "kudu/common/iterator_stats.h"
 #include "kudu/gutil/gscoped_ptr.h"
 #include "kudu/gutil/macros.h"
@@ -94,6 +96,11 @@ class ScannerManager {
   // Iterate through scanners and remove any which are past their TTL.
   void RemoveExpiredScanners();
 
+  // Returns the scanner metrics, or NULL if there are none.
+  ScannerMetrics* metrics() const {
+    return metrics_.get();
+  }
+
  private:
   FRIEND_TEST(ScannerTest, TestExpire);
 
@@ -270,6 +277,38 @@ class Scanner {
     already_reported_stats_ = stats;
   }
 
+  // Set the aggregates which the scan computes instead of returning rows.
+  void set_aggregators(std::vector<std::unique_ptr<Aggregator>> aggregators) {
+    aggregators_ = std::move(aggregators);
+  }
+
+  // Returns the aggregates which the scan computes instead of returning
+  // rows, if any. Each holds the partial result over the rows scanned since
+  // it was last reset.
+  const std::vector<std::unique_ptr<Aggregator>>& aggregators() const {
+    return aggregators_;
+  }
+
+  // Set the layout in which rows are returned, a bitfield of RowFormatFlags
+  // values from the new scan request.
+  void set_row_format_flags(uint64_t flags) {
+    row_format_flags_ = flags;
+  }
+
+  uint64_t row_format_flags() const {
+    return row_format_flags_;
+  }
+
+  // Set the codec with which the sidecars of the scan responses are
+  // compressed, as negotiated with the client.
+  void set_sidecar_compression(CompressionType compression) {
+    sidecar_compression_ = compression;
+  }
+
+  CompressionType sidecar_compression() const {
+    return sidecar_compression_;
+  }
+
  private:
   friend class ScannerManager;
 
@@ -312,6 +351,15 @@ class Scanner {
 
   gscoped_ptr<RowwiseIterator> iter_;
 
+  // The aggregates computed by the scan, if any. See aggregators().
+  std::vector<std::unique_ptr<Aggregator>> aggregators_;
+
+  // See set_row_format_flags().
+  uint64_t row_format_flags_;
+
+  // See set_sidecar_compression().
+  CompressionType sidecar_compression_;
+
   AutoReleasePool autorelease_pool_;
 
   // Arena used for allocations which must last as long as the scanner
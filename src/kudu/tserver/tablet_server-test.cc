@@ -23,6 +23,7 @@
 #include "kudu/server/hybrid_clock.h"
 #include "kudu/server/server_base.pb.h"
 #include "kudu/server/server_base.proxy.h"
+#include "kudu/tablet/tablet_metrics.h"
 #include "kudu/util/crc.h"
 #include "kudu/util/curl_util.h"
 #include "kudu/util/url-coding.h"
@@ -48,6 +49,7 @@ DEFINE_int32(single_threaded_insert_latency_bench_insert_rows, 1000,
              "Number of rows to insert in the testing phase of the single threaded"
              " tablet server insert latency micro-benchmark");
 
+DECLARE_int32(cfile_default_block_size);
 DECLARE_int32(scanner_batch_size_rows);
 DECLARE_int32(metrics_retirement_age_ms);
 DECLARE_string(block_manager);
@@ -1509,6 +1511,223 @@ TEST_F(TabletServerTest, TestScanWithEncodedPredicates) {
             results.back());
 }
 
+// Test that the range predicates sent by clients prune blocks and rowsets
+// with the zone maps of a non-key column.
+TEST_F(TabletServerTest, TestScanWithPredicatesPrunedByZoneMaps) {
+  // Small blocks, so that a narrow range only matches a few of them.
+  FLAGS_cfile_default_block_size = 1024;
+  const int kNumRows = 10000;
+  InsertTestRowsDirect(0, kNumRows);
+  ASSERT_OK(tablet_peer_->tablet()->Flush());
+
+  // Scans with the range predicate 'lower <= int_val [<= upper]'.
+  auto scan = [&] (int32_t lower, const int32_t* upper, vector<string>* results) {
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+    NewScanRequestPB* scan = req.mutable_new_scan_request();
+    scan->set_tablet_id(kTabletId);
+    req.set_batch_size_bytes(0);
+    ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+    ColumnRangePredicatePB* pred = scan->add_range_predicates();
+    pred->mutable_column()->CopyFrom(scan->projected_columns(1));
+    pred->mutable_lower_bound()->append(reinterpret_cast<const char*>(&lower), sizeof(lower));
+    if (upper != nullptr) {
+      pred->mutable_upper_bound()->append(reinterpret_cast<const char*>(upper),
+                                          sizeof(*upper));
+    }
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    ASSERT_FALSE(resp.has_error()) << resp.ShortDebugString();
+    results->clear();
+    NO_FATALS(DrainScannerToStrings(resp.scanner_id(), schema_, results));
+  };
+  const tablet::TabletMetrics* metrics = tablet_peer_->tablet()->metrics();
+
+  // int_val is twice the key, so this matches the keys [500, 510).
+  vector<string> results;
+  int32_t upper = 1019;
+  NO_FATALS(scan(1000, &upper, &results));
+  ASSERT_EQ(10, results.size());
+  EXPECT_EQ("(int32 key=500, int32 int_val=1000, string string_val=hello 500)",
+            results.front());
+  EXPECT_EQ("(int32 key=509, int32 int_val=1018, string string_val=hello 509)",
+            results.back());
+  ASSERT_GT(metrics->scanner_rows_pruned_by_zone_map->value(), kNumRows / 2);
+  ASSERT_EQ(0, metrics->scanner_rowsets_pruned_by_zone_map->value());
+
+  // No row has an int_val this large: the rowset is skipped altogether.
+  NO_FATALS(scan(kNumRows * 2, nullptr, &results));
+  ASSERT_EQ(0, results.size());
+  ASSERT_EQ(1, metrics->scanner_rowsets_pruned_by_zone_map->value());
+}
+
+// Test that a range predicate sent by a client on a dictionary-encoded string
+// column is evaluated on the dictionary codes.
+TEST_F(TabletServerTest, TestScanWithStringPredicateOnDictCodes) {
+  const char* kDictTabletId = "DictTablet";
+  ColumnStorageAttributes dict_storage;
+  dict_storage.encoding = DICT_ENCODING;
+  const Schema schema({ ColumnSchema("key", INT32),
+                        ColumnSchema("string_val", STRING, false, nullptr, nullptr,
+                                     dict_storage) }, 1);
+  ASSERT_OK(mini_server_->AddTestTablet("DictTable", kDictTabletId, schema));
+  ASSERT_OK(WaitForTabletRunning(kDictTabletId));
+  scoped_refptr<TabletPeer> tablet_peer;
+  ASSERT_TRUE(mini_server_->server()->tablet_manager()->LookupTablet(kDictTabletId,
+                                                                     &tablet_peer));
+
+  const int kNumRows = 100;
+  tablet::LocalTabletWriter writer(tablet_peer->tablet(), &schema);
+  KuduPartialRow row(&schema);
+  for (int i = 0; i < kNumRows; i++) {
+    ASSERT_OK(row.SetInt32(0, i));
+    ASSERT_OK(row.SetStringCopy(1, Substitute("val $0", i % 10)));
+    ASSERT_OK(writer.Insert(row));
+  }
+  ASSERT_OK(tablet_peer->tablet()->Flush());
+
+  // The predicate 'val 3' <= string_val <= 'val 4'.
+  ScanRequestPB req;
+  ScanResponsePB resp;
+  RpcController rpc;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kDictTabletId);
+  req.set_batch_size_bytes(0);
+  ASSERT_OK(SchemaToColumnPBs(schema, scan->mutable_projected_columns()));
+  ColumnRangePredicatePB* pred = scan->add_range_predicates();
+  pred->mutable_column()->CopyFrom(scan->projected_columns(1));
+  pred->set_lower_bound("val 3");
+  pred->set_upper_bound("val 4");
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  ASSERT_FALSE(resp.has_error()) << resp.ShortDebugString();
+
+  vector<string> results;
+  NO_FATALS(DrainScannerToStrings(resp.scanner_id(), schema, &results));
+  ASSERT_EQ(kNumRows / 5, results.size());
+  EXPECT_EQ("(int32 key=3, string string_val=val 3)", results.front());
+  EXPECT_EQ("(int32 key=94, string string_val=val 4)", results.back());
+  ASSERT_EQ(kNumRows,
+            tablet_peer->tablet()->metrics()->scanner_cells_evaluated_on_dict_codes->value());
+}
+
+// Test that the tablet server acknowledges the column predicates it enforces,
+// which is what tells the client that it doesn't predate them.
+TEST_F(TabletServerTest, TestScanWithColumnPredicates) {
+  InsertTestRowsDirect(0, 10);
+
+  ScanRequestPB req;
+  ScanResponsePB resp;
+  RpcController rpc;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  req.set_batch_size_bytes(0);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  ColumnPredicatePB* pred = scan->add_column_predicates();
+  pred->mutable_column()->CopyFrom(scan->projected_columns(0));
+  for (int32_t key : { 7, 3, 42 }) {
+    pred->mutable_in_list()->add_values(reinterpret_cast<const char*>(&key), sizeof(key));
+  }
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  ASSERT_FALSE(resp.has_error()) << resp.ShortDebugString();
+  ASSERT_TRUE(resp.column_predicates_enforced());
+
+  vector<string> results;
+  NO_FATALS(DrainScannerToStrings(resp.scanner_id(), schema_, &results));
+  ASSERT_EQ(2, results.size());
+  EXPECT_EQ("(int32 key=3, int32 int_val=6, string string_val=hello 3)", results[0]);
+  EXPECT_EQ("(int32 key=7, int32 int_val=14, string string_val=hello 7)", results[1]);
+
+  // Without column predicates, there is nothing to acknowledge.
+  scan->clear_column_predicates();
+  resp.Clear();
+  rpc.Reset();
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  ASSERT_FALSE(resp.has_error()) << resp.ShortDebugString();
+  ASSERT_FALSE(resp.has_column_predicates_enforced());
+  results.clear();
+  NO_FATALS(DrainScannerToStrings(resp.scanner_id(), schema_, &results));
+  ASSERT_EQ(10, results.size());
+}
+
+// Test that columnar scans of flushed, unchanged, non-nullable columns send
+// their cells straight from the data blocks, as several sidecars, to clients
+// which accept it, and that the cells are those scanned.
+TEST_F(TabletServerTest, TestColumnarScanWithDataChunks) {
+  const int kNumRows = 1000;
+  InsertTestRowsDirect(0, kNumRows);
+  ASSERT_OK(tablet_peer_->tablet()->Flush());
+
+  Schema projection({ ColumnSchema("key", INT32), ColumnSchema("int_val", INT32) }, 1);
+  for (bool chunks : { true, false }) {
+    SCOPED_TRACE(chunks);
+    uint64_t flags = COLUMNAR_LAYOUT | (chunks ? COLUMNAR_DATA_CHUNKS : NO_FLAGS);
+    ScanRequestPB req;
+    ScanResponsePB resp;
+    RpcController rpc;
+    NewScanRequestPB* scan = req.mutable_new_scan_request();
+    scan->set_tablet_id(kTabletId);
+    scan->set_row_format_flags(flags);
+    ASSERT_OK(SchemaToColumnPBs(projection, scan->mutable_projected_columns()));
+    req.set_batch_size_bytes(1024 * 1024);
+    ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+    ASSERT_FALSE(resp.has_error()) << resp.ShortDebugString();
+    ASSERT_FALSE(resp.has_more_results());
+    ASSERT_EQ(kNumRows, resp.columnar_data().num_rows());
+    ASSERT_EQ(2, resp.columnar_data().columns_size());
+
+    for (int col = 0; col < 2; col++) {
+      SCOPED_TRACE(col);
+      const ColumnarRowBlockPB::Column& col_pb = resp.columnar_data().columns(col);
+      faststring cells;
+      Slice sidecar;
+      if (chunks) {
+        ASSERT_FALSE(col_pb.has_data_sidecar());
+        ASSERT_GT(col_pb.data_chunk_sidecars_size(), 0);
+        for (int idx : col_pb.data_chunk_sidecars()) {
+          ASSERT_OK(rpc.GetSidecar(idx, &sidecar));
+          cells.append(sidecar.data(), sidecar.size());
+        }
+      } else {
+        ASSERT_EQ(0, col_pb.data_chunk_sidecars_size());
+        ASSERT_OK(rpc.GetSidecar(col_pb.data_sidecar(), &sidecar));
+        cells.append(sidecar.data(), sidecar.size());
+      }
+      ASSERT_EQ(kNumRows * sizeof(int32_t), cells.size());
+      const int32_t* vals = reinterpret_cast<const int32_t*>(cells.data());
+      for (int i = 0; i < kNumRows; i++) {
+        ASSERT_EQ(col == 0 ? i : i * 2, vals[i]) << "row " << i;
+      }
+    }
+  }
+}
+
+// Test that the responses of a scan with aggregates carry their partial
+// results rather than rows: the client tells tablet servers which predate
+// aggregates apart by the rows they return instead.
+TEST_F(TabletServerTest, TestScanWithAggregates) {
+  InsertTestRowsDirect(0, 10);
+
+  ScanRequestPB req;
+  ScanResponsePB resp;
+  RpcController rpc;
+  NewScanRequestPB* scan = req.mutable_new_scan_request();
+  scan->set_tablet_id(kTabletId);
+  ASSERT_OK(SchemaToColumnPBs(schema_, scan->mutable_projected_columns()));
+  AggregatePB* count = scan->add_aggregates();
+  count->set_function(AggregatePB::COUNT);
+  AggregatePB* sum = scan->add_aggregates();
+  sum->set_function(AggregatePB::SUM);
+  sum->set_column_idx(1);
+  ASSERT_OK(proxy_->Scan(req, &resp, &rpc));
+  ASSERT_FALSE(resp.has_error()) << resp.ShortDebugString();
+  ASSERT_FALSE(resp.has_more_results());
+  ASSERT_FALSE(resp.has_data());
+  ASSERT_FALSE(resp.has_columnar_data());
+  ASSERT_EQ(2, resp.aggregate_results_size());
+  ASSERT_EQ(10, resp.aggregate_results(0).count());
+  ASSERT_EQ(10, resp.aggregate_results(1).count());
+  ASSERT_EQ(90, resp.aggregate_results(1).int_sum());
+}
 
 // Test requesting more rows from a scanner which doesn't exist
 TEST_F(TabletServerTest, TestBadScannerID) {
@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "kudu/cfile/block_cache.h"
+#include "kudu/cfile/block_cache_warmer.h"
 #include "kudu/fs/fs_manager.h"
 #include "kudu/gutil/strings/substitute.h"
 #include "kudu/rpc/service_if.h"
@@ -54,7 +55,8 @@ TabletServer::TabletServer(const TabletServerOptions& opts)
     tablet_manager_(new TSTabletManager(fs_manager_.get(), this, metric_registry())),
     scanner_manager_(new ScannerManager(metric_entity())),
     path_handlers_(new TabletServerPathHandlers(this)),
-    maintenance_manager_(new MaintenanceManager(MaintenanceManager::DEFAULT_OPTIONS)) {
+    maintenance_manager_(new MaintenanceManager(MaintenanceManager::DEFAULT_OPTIONS)),
+    block_cache_warmer_(new cfile::BlockCacheWarmer(fs_manager_.get())) {
 }
 
 TabletServer::~TabletServer() {
@@ -90,6 +92,11 @@ Status TabletServer::Init() {
   RETURN_NOT_OK(ServerBase::Init());
   RETURN_NOT_OK(path_handlers_->Register(web_server_.get()));
 
+  // The block manager is open now: the warm-up reads blocks in the
+  // background while the tablets bootstrap.
+  RETURN_NOT_OK_PREPEND(block_cache_warmer_->Start(),
+                        "Could not start warming the block cache up");
+
   heartbeater_.reset(new Heartbeater(opts_, this));
 
   RETURN_NOT_OK_PREPEND(tablet_manager_->Init(),
@@ -137,6 +144,7 @@ void TabletServer::Shutdown() {
     maintenance_manager_->Shutdown();
     WARN_NOT_OK(heartbeater_->Stop(), "Failed to stop TS Heartbeat thread");
     ServerBase::Shutdown();
+    block_cache_warmer_->Shutdown();
     tablet_manager_->Shutdown();
   }
 
@@ -37,6 +37,10 @@ namespace kudu {
 
 class MaintenanceManager;
 
+namespace cfile {
+class BlockCacheWarmer;
+} // namespace cfile
+
 namespace tserver {
 
 class Heartbeater;
@@ -87,6 +91,10 @@ class TabletServer : public server::ServerBase {
     return maintenance_manager_.get();
   }
 
+  cfile::BlockCacheWarmer* block_cache_warmer() {
+    return block_cache_warmer_.get();
+  }
+
  private:
   friend class TabletServerTestBase;
 
@@ -117,6 +125,10 @@ class TabletServer : public server::ServerBase {
   // The maintenance manager for this tablet server
   std::shared_ptr<MaintenanceManager> maintenance_manager_;
 
+  // Warms the block cache up with the blocks cached before the last restart,
+  // and persists the blocks cached now for the next one.
+  gscoped_ptr<cfile::BlockCacheWarmer> block_cache_warmer_;
+
   DISALLOW_COPY_AND_ASSIGN(TabletServer);
 };
 
@@ -23,6 +23,8 @@
 #include <string>
 #include <vector>
 
+#include "kudu/cfile/compression_codec.h"
+#include "kudu/common/aggregate.h"
 #include "kudu/common/iterator.h"
 #include "kudu/common/schema.h"
 #include "kudu/common/wire_protocol.h"
@@ -32,11 +34,14 @@
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/escaping.h"
+#include "kudu/gutil/strings/split.h"
 #include "kudu/rpc/rpc_context.h"
 #include "kudu/rpc/rpc_sidecar.h"
+#include "kudu/rpc/transfer.h"
 #include "kudu/server/hybrid_clock.h"
 #include "kudu/tablet/tablet_bootstrap.h"
 #include "kudu/tserver/remote_bootstrap_service.h"
+#include "kudu/tserver/scanner_metrics.h"
 #include "kudu/tablet/metadata.pb.h"
 #include "kudu/tablet/tablet_peer.h"
 #include "kudu/tablet/tablet_metrics.h"
@@ -55,6 +60,7 @@
 #include "kudu/util/monotime.h"
 #include "kudu/util/status.h"
 #include "kudu/util/status_callback.h"
+#include "kudu/util/stopwatch.h"
 #include "kudu/util/trace.h"
 
 DEFINE_int32(scanner_default_batch_size_bytes, 1024 * 1024,
@@ -73,6 +79,35 @@ DEFINE_int32(scanner_batch_size_rows, 100,
 TAG_FLAG(scanner_batch_size_rows, advanced);
 TAG_FLAG(scanner_batch_size_rows, runtime);
 
+DEFINE_string(scanner_sidecar_compression_codecs, "lz4,snappy",
+              "Comma-separated list of the codecs with which the tablet server "
+              "agrees to compress the sidecars of scan responses, if the client "
+              "accepts them. The client's order of preference is honored. If "
+              "empty, scan responses are never compressed.");
+TAG_FLAG(scanner_sidecar_compression_codecs, advanced);
+
+static bool ValidateSidecarCompressionCodecs(const char* flagname, const std::string& value) {
+  std::vector<std::string> codecs = strings::Split(value, ",", strings::SkipEmpty());
+  for (const std::string& codec : codecs) {
+    kudu::CompressionType type = kudu::cfile::GetCompressionCodecType(codec);
+    if (type == kudu::NO_COMPRESSION || type == kudu::DEFAULT_COMPRESSION) {
+      LOG(ERROR) << "Invalid value for " << flagname << ": unknown codec '" << codec << "'";
+      return false;
+    }
+  }
+  return true;
+}
+static bool dummy_sidecar_compression_codecs = google::RegisterFlagValidator(
+    &FLAGS_scanner_sidecar_compression_codecs, &ValidateSidecarCompressionCodecs);
+
+DEFINE_bool(scanner_send_pinned_cells, true,
+            "Whether the cells of fixed-length columns of columnar scans which "
+            "are read unchanged from cached data blocks are sent straight from "
+            "those blocks, rather than copied into the response first. Only "
+            "applies to uncompressed responses to clients which accept them.");
+TAG_FLAG(scanner_send_pinned_cells, advanced);
+TAG_FLAG(scanner_send_pinned_cells, runtime);
+
 // Fault injection flags.
 DEFINE_int32(scanner_inject_latency_on_each_batch_ms, 0,
              "If set, the scanner will pause the specified number of milliesconds "
@@ -108,6 +143,7 @@ using consensus::VoteResponsePB;
 using google::protobuf::RepeatedPtrField;
 using rpc::RpcContext;
 using std::shared_ptr;
+using std::unique_ptr;
 using std::vector;
 using strings::Substitute;
 using tablet::AlterSchemaTransactionState;
@@ -301,6 +337,24 @@ class ScanResultCollector {
   virtual void HandleRowBlock(const Schema* client_projection_schema,
                               const RowBlock& row_block) = 0;
 
+  // Used instead of HandleRowBlock() if the scan computes aggregates rather
+  // than returning rows: handles the partial results of the aggregates over
+  // the rows scanned for the response.
+  virtual void HandleAggregates(const vector<unique_ptr<Aggregator>>& aggregators) = 0;
+
+  // Sets the layout in which rows are returned, a bitfield of RowFormatFlags
+  // values. Called before any rows are handled. Collectors which do not
+  // return rows ignore it.
+  virtual void set_row_format_flags(uint64_t flags) {}
+
+  // Sets the codec with which the sidecars of the response are compressed.
+  // Collectors which do not return rows ignore it.
+  virtual void set_sidecar_compression(CompressionType compression) {}
+
+  // Returns true if the row blocks passed to HandleRowBlock() should record
+  // the pinned cells of their columns. See RowBlock::set_pin_cells().
+  virtual bool ShouldPinCells() const { return false; }
+
   // Returns number of times HandleRowBlock() was called.
   virtual int BlocksProcessed() const = 0;
 
@@ -333,6 +387,146 @@ void SetLastRow(const RowBlock& row_block, faststring* last_primary_key) {
   }
 }
 
+// Returns the codec with which to compress the sidecars of the responses to
+// the given scan: the first of the codecs accepted by the client which is
+// also enabled by --scanner_sidecar_compression_codecs, or NO_COMPRESSION.
+CompressionType NegotiateSidecarCompression(const NewScanRequestPB& scan_pb) {
+  if (scan_pb.accepted_sidecar_compression_size() == 0) {
+    return NO_COMPRESSION;
+  }
+  vector<string> enabled = strings::Split(FLAGS_scanner_sidecar_compression_codecs, ",",
+                                          strings::SkipEmpty());
+  for (int type : scan_pb.accepted_sidecar_compression()) {
+    for (const string& codec : enabled) {
+      if (cfile::GetCompressionCodecType(codec) == type) {
+        return static_cast<CompressionType>(type);
+      }
+    }
+  }
+  return NO_COMPRESSION;
+}
+
+// Adds sidecars to a scan response, compressing each of them with the
+// negotiated codec first. A sidecar which does not shrink is sent as is.
+// The uncompressed size of each sidecar, or 0 if it was sent as is, is
+// recorded in the response, and the compression is accounted for in the
+// scanner metrics on Finish().
+class ScanSidecarWriter {
+ public:
+  ScanSidecarWriter(CompressionType compression, ScannerMetrics* metrics,
+                    ScanResponsePB* resp, rpc::RpcContext* context)
+      : codec_(nullptr),
+        metrics_(metrics),
+        resp_(resp),
+        context_(context),
+        cpu_timer_(Stopwatch::THIS_THREAD),
+        bytes_before_compression_(0),
+        bytes_saved_(0) {
+    if (compression != NO_COMPRESSION &&
+        cfile::GetCompressionCodec(compression, &codec_).ok() && codec_ != nullptr) {
+      resp_->set_sidecar_compression(compression);
+    } else {
+      codec_ = nullptr;
+    }
+  }
+
+  // Adds 'data' to the response as a sidecar and sets '*idx' to its index.
+  Status Add(gscoped_ptr<faststring> data, int* idx) {
+    if (codec_ != nullptr) {
+      size_t uncompressed_size = data->size();
+      gscoped_ptr<faststring> compressed(
+          new faststring(codec_->MaxCompressedLength(uncompressed_size)));
+      size_t compressed_size;
+      cpu_timer_.resume();
+      Status s = codec_->Compress(Slice(*data), compressed->data(), &compressed_size);
+      cpu_timer_.stop();
+      RETURN_NOT_OK_PREPEND(s, "Unable to compress scan response sidecar");
+      bytes_before_compression_ += uncompressed_size;
+      if (compressed_size < uncompressed_size) {
+        compressed->resize(compressed_size);
+        data = std::move(compressed);
+        bytes_saved_ += uncompressed_size - compressed_size;
+        resp_->add_uncompressed_sidecar_sizes(uncompressed_size);
+      } else {
+        resp_->add_uncompressed_sidecar_sizes(0);
+      }
+    }
+    RETURN_NOT_OK(context_->AddRpcSidecar(make_gscoped_ptr(
+        new rpc::RpcSidecar(std::move(data))), idx));
+    DCHECK(codec_ == nullptr || *idx == resp_->uncompressed_sidecar_sizes_size() - 1);
+    return Status::OK();
+  }
+
+  // Adds the cells of 'pinned' to the response as a sidecar, without copying
+  // them unless they are to be compressed, and sets '*idx' to its index.
+  Status AddPinned(const PinnedCells& pinned, int* idx) {
+    if (codec_ != nullptr) {
+      gscoped_ptr<faststring> data(new faststring());
+      data->append(pinned.cells.data(), pinned.cells.size());
+      return Add(std::move(data), idx);
+    }
+    return context_->AddRpcSidecar(rpc::RpcSidecar::FromPinnedSlice(pinned.cells, pinned.pin),
+                                   idx);
+  }
+
+  // Records the work done in the scanner metrics, if any.
+  void Finish() {
+    if (codec_ == nullptr || metrics_ == nullptr) {
+      return;
+    }
+    CpuTimes cpu = cpu_timer_.elapsed();
+    metrics_->scanner_sidecar_bytes_before_compression->IncrementBy(bytes_before_compression_);
+    metrics_->scanner_sidecar_bytes_saved_by_compression->IncrementBy(bytes_saved_);
+    metrics_->scanner_sidecar_compression_cpu_time->IncrementBy(
+        (cpu.user + cpu.system) / 1000);
+  }
+
+ private:
+  const cfile::CompressionCodec* codec_;
+  ScannerMetrics* const metrics_;
+  ScanResponsePB* const resp_;
+  rpc::RpcContext* const context_;
+  Stopwatch cpu_timer_;
+  int64_t bytes_before_compression_;
+  int64_t bytes_saved_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanSidecarWriter);
+};
+
+// Adds the buffers of a batch of rows serialized in the columnar layout to the
+// response as sidecars, and records their indices in 'columnar_pb'.
+Status AddColumnarSidecars(ColumnarSerializedBatch* batch,
+                           ScanSidecarWriter* writer,
+                           ColumnarRowBlockPB* columnar_pb) {
+  columnar_pb->set_num_rows(batch->num_rows);
+  for (ColumnarSerializedBatch::Column& col : batch->columns) {
+    ColumnarRowBlockPB::Column* col_pb = columnar_pb->add_columns();
+    int idx;
+    if (col.data_chunks.empty()) {
+      RETURN_NOT_OK(writer->Add(gscoped_ptr<faststring>(col.data.release()), &idx));
+      col_pb->set_data_sidecar(idx);
+    } else {
+      for (const PinnedCells& chunk : col.data_chunks) {
+        RETURN_NOT_OK(writer->AddPinned(chunk, &idx));
+        col_pb->add_data_chunk_sidecars(idx);
+      }
+      if (col.data->size() > 0) {
+        RETURN_NOT_OK(writer->Add(gscoped_ptr<faststring>(col.data.release()), &idx));
+        col_pb->add_data_chunk_sidecars(idx);
+      }
+    }
+    if (col.varlen_data) {
+      RETURN_NOT_OK(writer->Add(gscoped_ptr<faststring>(col.varlen_data.release()), &idx));
+      col_pb->set_varlen_data_sidecar(idx);
+    }
+    if (col.non_null_bitmap) {
+      RETURN_NOT_OK(writer->Add(gscoped_ptr<faststring>(col.non_null_bitmap.release()), &idx));
+      col_pb->set_non_null_bitmap_sidecar(idx);
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 // Copies the scan result to the given row block PB and data buffers.
@@ -345,10 +539,20 @@ void SetLastRow(const RowBlock& row_block, faststring* last_primary_key) {
 // server-side scan and thus never need to return the actual data.)
 class ScanResultCopier : public ScanResultCollector {
  public:
-  ScanResultCopier(RowwiseRowBlockPB* rowblock_pb, faststring* rows_data, faststring* indirect_data)
+  // The maximum number of sidecars over which the cells of a column may be
+  // split, so that runs of pinned cells need not be copied.
+  static const int kMaxColumnarDataChunks = 16;
+
+  ScanResultCopier(RowwiseRowBlockPB* rowblock_pb, faststring* rows_data, faststring* indirect_data,
+                   ColumnarSerializedBatch* columnar_data,
+                   RepeatedPtrField<AggregateResultPB>* aggregate_results)
       : rowblock_pb_(DCHECK_NOTNULL(rowblock_pb)),
         rows_data_(DCHECK_NOTNULL(rows_data)),
         indirect_data_(DCHECK_NOTNULL(indirect_data)),
+        columnar_data_(DCHECK_NOTNULL(columnar_data)),
+        aggregate_results_(DCHECK_NOTNULL(aggregate_results)),
+        row_format_flags_(NO_FLAGS),
+        sidecar_compression_(NO_COMPRESSION),
         blocks_processed_(0),
         num_rows_returned_(0) {
   }
@@ -357,16 +561,73 @@ class ScanResultCopier : public ScanResultCollector {
                               const RowBlock& row_block) OVERRIDE {
     blocks_processed_++;
     num_rows_returned_ += row_block.selection_vector()->CountSelected();
-    SerializeRowBlock(row_block, rowblock_pb_, client_projection_schema,
-                      rows_data_, indirect_data_);
+    if (columnar()) {
+      // Each chunk takes a sidecar of its own, of which a call may only have
+      // so many.
+      int max_sidecars_per_column = 3 + kMaxColumnarDataChunks;
+      int num_columns = client_projection_schema != nullptr ?
+          client_projection_schema->num_columns() : row_block.schema().num_columns();
+      columnar_data_->max_data_chunks =
+          ShouldPinCells() &&
+          num_columns * max_sidecars_per_column <= rpc::OutboundTransfer::kMaxSidecars ?
+          kMaxColumnarDataChunks : 0;
+      SerializeRowBlockColumnar(row_block, client_projection_schema, columnar_data_);
+    } else {
+      SerializeRowBlock(row_block, rowblock_pb_, client_projection_schema,
+                        rows_data_, indirect_data_);
+    }
     SetLastRow(row_block, &last_primary_key_);
   }
 
+  virtual void HandleAggregates(const vector<unique_ptr<Aggregator>>& aggregators) OVERRIDE {
+    aggregate_results_->Clear();
+    for (const unique_ptr<Aggregator>& aggregator : aggregators) {
+      aggregator->ToPB(aggregate_results_->Add());
+    }
+  }
+
+  virtual void set_row_format_flags(uint64_t flags) OVERRIDE {
+    row_format_flags_ = flags;
+  }
+
+  virtual void set_sidecar_compression(CompressionType compression) OVERRIDE {
+    sidecar_compression_ = compression;
+  }
+
+  CompressionType sidecar_compression() const {
+    return sidecar_compression_;
+  }
+
+  // Returns true if rows are copied into the columnar batch rather than the
+  // row block PB.
+  bool columnar() const {
+    return row_format_flags_ & COLUMNAR_LAYOUT;
+  }
+
+  // Pinned cells are only sent uncompressed, to clients which accept the
+  // cells of a column in several sidecars.
+  virtual bool ShouldPinCells() const OVERRIDE {
+    return columnar() && (row_format_flags_ & COLUMNAR_DATA_CHUNKS) &&
+        sidecar_compression_ == NO_COMPRESSION && FLAGS_scanner_send_pinned_cells;
+  }
+
   virtual int BlocksProcessed() const OVERRIDE { return blocks_processed_; }
 
   // Returns number of bytes buffered to return.
   virtual int64_t ResponseSize() const OVERRIDE {
-    return rows_data_->size() + indirect_data_->size();
+    if (!columnar()) {
+      return rows_data_->size() + indirect_data_->size();
+    }
+    int64_t size = 0;
+    for (const ColumnarSerializedBatch::Column& col : columnar_data_->columns) {
+      for (const PinnedCells& chunk : col.data_chunks) {
+        size += chunk.cells.size();
+      }
+      size += col.data->size();
+      if (col.varlen_data) size += col.varlen_data->size();
+      if (col.non_null_bitmap) size += col.non_null_bitmap->size();
+    }
+    return size;
   }
 
   virtual const faststring& last_primary_key() const OVERRIDE {
@@ -381,6 +642,10 @@ class ScanResultCopier : public ScanResultCollector {
   RowwiseRowBlockPB* const rowblock_pb_;
   faststring* const rows_data_;
   faststring* const indirect_data_;
+  ColumnarSerializedBatch* const columnar_data_;
+  RepeatedPtrField<AggregateResultPB>* const aggregate_results_;
+  uint64_t row_format_flags_;
+  CompressionType sidecar_compression_;
   int blocks_processed_;
   int64_t num_rows_returned_;
   faststring last_primary_key_;
@@ -414,6 +679,10 @@ class ScanResultChecksummer : public ScanResultCollector {
     SetLastRow(row_block, &encoded_last_row_);
   }
 
+  virtual void HandleAggregates(const vector<unique_ptr<Aggregator>>& aggregators) OVERRIDE {
+    LOG(DFATAL) << "Checksum scans do not compute aggregates";
+  }
+
   virtual int BlocksProcessed() const OVERRIDE { return blocks_processed_; }
 
   // Returns a constant -- we only return checksum based on a time budget.
@@ -1000,7 +1269,9 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
   gscoped_ptr<faststring> rows_data(new faststring(batch_size_bytes * 11 / 10));
   gscoped_ptr<faststring> indirect_data(new faststring(batch_size_bytes * 11 / 10));
   RowwiseRowBlockPB data;
-  ScanResultCopier collector(&data, rows_data.get(), indirect_data.get());
+  ColumnarSerializedBatch columnar_data;
+  ScanResultCopier collector(&data, rows_data.get(), indirect_data.get(), &columnar_data,
+                             resp->mutable_aggregate_results());
 
   bool has_more_results = false;
   TabletServerErrorPB::Code error_code;
@@ -1028,6 +1299,9 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
     if (scan_timestamp != Timestamp::kInvalidTimestamp) {
       resp->set_snap_timestamp(scan_timestamp.ToUint64());
     }
+    if (scan_pb.column_predicates_size() > 0) {
+      resp->set_column_predicates_enforced(true);
+    }
   } else if (req->has_scanner_id()) {
     Status s = HandleContinueScanRequest(req, &collector, &has_more_results, &error_code);
     if (PREDICT_FALSE(!s.ok())) {
@@ -1043,21 +1317,37 @@ void TabletServiceImpl::Scan(const ScanRequestPB* req,
 
   DVLOG(2) << "Blocks processed: " << collector.BlocksProcessed();
   if (collector.BlocksProcessed() > 0) {
-    resp->mutable_data()->CopyFrom(data);
-
-    // Add sidecar data to context and record the returned indices.
-    int rows_idx;
-    CHECK_OK(context->AddRpcSidecar(make_gscoped_ptr(
-        new rpc::RpcSidecar(std::move(rows_data))), &rows_idx));
-    resp->mutable_data()->set_rows_sidecar(rows_idx);
-
-    // Add indirect data as a sidecar, if applicable.
-    if (indirect_data->size() > 0) {
-      int indirect_idx;
-      CHECK_OK(context->AddRpcSidecar(make_gscoped_ptr(
-          new rpc::RpcSidecar(std::move(indirect_data))), &indirect_idx));
-      resp->mutable_data()->set_indirect_data_sidecar(indirect_idx);
+    ScanSidecarWriter sidecars(collector.sidecar_compression(),
+                               server_->scanner_manager()->metrics(), resp, context);
+    Status s;
+    if (collector.columnar()) {
+      s = AddColumnarSidecars(&columnar_data, &sidecars, resp->mutable_columnar_data());
+    } else {
+      resp->mutable_data()->CopyFrom(data);
+
+      // Add sidecar data to context and record the returned indices.
+      bool has_indirect_data = indirect_data->size() > 0;
+      int rows_idx;
+      s = sidecars.Add(std::move(rows_data), &rows_idx);
+      if (s.ok()) {
+        resp->mutable_data()->set_rows_sidecar(rows_idx);
+      }
+
+      // Add indirect data as a sidecar, if applicable.
+      if (s.ok() && has_indirect_data) {
+        int indirect_idx;
+        s = sidecars.Add(std::move(indirect_data), &indirect_idx);
+        if (s.ok()) {
+          resp->mutable_data()->set_indirect_data_sidecar(indirect_idx);
+        }
+      }
     }
+    if (PREDICT_FALSE(!s.ok())) {
+      SetupErrorAndRespond(resp->mutable_error(), s, TabletServerErrorPB::UNKNOWN_ERROR,
+                           context);
+      return;
+    }
+    sidecars.Finish();
 
     // Set the last row found by the collector.
     // We could have an empty batch if all the remaining rows are filtered by the predicate,
@@ -1113,6 +1403,11 @@ void TabletServiceImpl::Checksum(const ChecksumRequestPB* req,
   if (req->has_new_request()) {
     scan_req.mutable_new_scan_request()->CopyFrom(req->new_request());
     const NewScanRequestPB& new_req = req->new_request();
+    if (PREDICT_FALSE(new_req.aggregates_size() > 0)) {
+      context->RespondFailure(Status::InvalidArgument(
+                              "Checksum scans cannot compute aggregates"));
+      return;
+    }
     scoped_refptr<TabletPeer> tablet_peer;
     if (!LookupTabletPeerOrRespond(server_->tablet_manager(), new_req.tablet_id(), resp, context,
                                    &tablet_peer)) {
@@ -1285,6 +1580,47 @@ static Status SetupScanSpec(const NewScanRequestPB& scan_pb,
     ret->AddPredicate(pred);
   }
 
+  // Then the other column predicates.
+  for (const ColumnPredicatePB& pred_pb : scan_pb.column_predicates()) {
+    ColumnSchema col(ColumnSchemaFromPB(pred_pb.column()));
+    if (projection.find_column(col.name()) == -1 &&
+        !ContainsKey(missing_col_names, col.name())) {
+      missing_cols->push_back(col);
+      InsertOrDie(&missing_col_names, col.name());
+    }
+
+    boost::optional<ColumnPredicate> pred;
+    switch (pred_pb.predicate_case()) {
+      case ColumnPredicatePB::kInList: {
+        vector<const void*> values;
+        for (const string& value_pb : pred_pb.in_list().values()) {
+          const void* value;
+          RETURN_NOT_OK(ExtractPredicateValue(col, value_pb, scanner->arena(), &value));
+          values.push_back(value);
+        }
+        pred = ColumnPredicate::InList(col, &values);
+        break;
+      }
+      case ColumnPredicatePB::kIsNotNull: {
+        pred = ColumnPredicate::IsNotNull(col);
+        break;
+      }
+      case ColumnPredicatePB::kIsNull: {
+        pred = ColumnPredicate::IsNull(col);
+        break;
+      }
+      default:
+        return Status::InvalidArgument(
+            string("Invalid predicate ") + pred_pb.ShortDebugString() +
+            ": unknown predicate type.");
+    }
+    if (VLOG_IS_ON(3)) {
+      VLOG(3) << "Parsed predicate " << pred->ToString()
+              << " from " << scan_pb.ShortDebugString();
+    }
+    ret->AddPredicate(std::move(*pred));
+  }
+
   // When doing an ordered scan, we need to include the key columns to be able to encode
   // the last row key for the scan response.
   if (scan_pb.order_mode() == kudu::ORDERED &&
@@ -1367,6 +1703,30 @@ Status TabletServiceImpl::HandleNewScanRequest(TabletPeer* tablet_peer,
     return s;
   }
 
+  // Set up the aggregates, if any. They refer to columns of the client's
+  // projection, which come first in the iterator's projection too.
+  vector<unique_ptr<Aggregator>> aggregators;
+  if (scan_pb.aggregates_size() > 0) {
+    if (scan_pb.order_mode() == ORDERED) {
+      // The responses of an aggregating scan carry no rows, so they have no
+      // last primary key to resume an ordered scan from.
+      *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+      return Status::InvalidArgument("Cannot compute aggregates in an ordered scan");
+    }
+    for (const AggregatePB& aggregate_pb : scan_pb.aggregates()) {
+      gscoped_ptr<Aggregator> aggregator;
+      s = Aggregator::Create(aggregate_pb, projection, &aggregator);
+      if (PREDICT_FALSE(!s.ok())) {
+        *error_code = TabletServerErrorPB::INVALID_SCAN_SPEC;
+        return s;
+      }
+      aggregators.emplace_back(aggregator.release());
+    }
+  }
+  scanner->set_aggregators(std::move(aggregators));
+  scanner->set_row_format_flags(scan_pb.row_format_flags());
+  scanner->set_sidecar_compression(NegotiateSidecarCompression(scan_pb));
+
   // Store the original projection.
   gscoped_ptr<Schema> orig_projection(new Schema(projection));
   scanner->set_client_projection_schema(std::move(orig_projection));
@@ -1506,6 +1866,8 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
   }
   scanner->IncrementCallSeqId();
   scanner->UpdateAccessTime();
+  result_collector->set_row_format_flags(scanner->row_format_flags());
+  result_collector->set_sidecar_compression(scanner->sidecar_compression());
 
   RowwiseIterator* iter = scanner->iter();
 
@@ -1515,6 +1877,7 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
   Arena arena(32 * 1024, 1 * 1024 * 1024);
   RowBlock block(scanner->iter()->schema(),
                  FLAGS_scanner_batch_size_rows, &arena);
+  block.set_pin_cells(scanner->aggregators().empty() && result_collector->ShouldPinCells());
 
   // TODO: in the future, use the client timeout to set a budget. For now,
   // just use a half second, which should be plenty to amortize call overhead.
@@ -1522,6 +1885,11 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
   MonoTime deadline = MonoTime::Now(MonoTime::COARSE);
   deadline.AddDelta(MonoDelta::FromMilliseconds(budget_ms));
 
+  // If the scan computes aggregates, the rows are aggregated rather than
+  // returned, and only the partial results over this response's rows are
+  // sent back.
+  const vector<unique_ptr<Aggregator>>& aggregators = scanner->aggregators();
+
   int64_t rows_scanned = 0;
   while (iter->HasNext()) {
     if (PREDICT_FALSE(FLAGS_scanner_inject_latency_on_each_batch_ms > 0)) {
@@ -1540,7 +1908,13 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
       // The collector will separately count the number of rows actually returned to
       // the client.
       rows_scanned += block.nrows();
-      result_collector->HandleRowBlock(scanner->client_projection_schema(), block);
+      if (aggregators.empty()) {
+        result_collector->HandleRowBlock(scanner->client_projection_schema(), block);
+      } else {
+        for (const unique_ptr<Aggregator>& aggregator : aggregators) {
+          aggregator->Add(block);
+        }
+      }
     }
 
     int64_t response_size = result_collector->ResponseSize();
@@ -1562,6 +1936,13 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
     }
   }
 
+  if (!aggregators.empty()) {
+    result_collector->HandleAggregates(aggregators);
+    for (const unique_ptr<Aggregator>& aggregator : aggregators) {
+      aggregator->Reset();
+    }
+  }
+
   // Update metrics based on this scan request.
   scoped_refptr<TabletPeer> tablet_peer = scanner->tablet_peer();
   shared_ptr<Tablet> tablet;
@@ -1594,6 +1975,18 @@ Status TabletServiceImpl::HandleContinueScanRequest(const ScanRequestPB* req,
       delta_stats.cells_read_from_disk);
   tablet->metrics()->scanner_bytes_scanned_from_disk->IncrementBy(
       delta_stats.bytes_read_from_disk);
+  tablet->metrics()->scanner_data_blocks_scanned_from_disk->IncrementBy(
+      delta_stats.data_blocks_read_from_disk);
+  tablet->metrics()->scanner_data_blocks_prefetched->IncrementBy(
+      delta_stats.data_blocks_prefetched);
+  tablet->metrics()->scanner_rowsets_pruned_by_bloom->IncrementBy(
+      delta_stats.rowsets_pruned_by_bloom);
+  tablet->metrics()->scanner_rows_pruned_by_zone_map->IncrementBy(
+      delta_stats.rows_pruned_by_zone_map);
+  tablet->metrics()->scanner_rowsets_pruned_by_zone_map->IncrementBy(
+      delta_stats.rowsets_pruned_by_zone_map);
+  tablet->metrics()->scanner_cells_evaluated_on_dict_codes->IncrementBy(
+      delta_stats.cells_evaluated_on_dict_codes);
 
   scanner->UpdateAccessTime();
   *has_more_results = !req->close_scanner() && iter->HasNext();
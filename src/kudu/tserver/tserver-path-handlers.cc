@@ -23,9 +23,11 @@
 #include <string>
 #include <vector>
 
+#include "kudu/cfile/block_cache_warmer.h"
 #include "kudu/consensus/log_anchor_registry.h"
 #include "kudu/consensus/quorum_util.h"
 #include "kudu/gutil/map-util.h"
+#include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/human_readable.h"
 #include "kudu/gutil/strings/join.h"
 #include "kudu/gutil/strings/numbers.h"
@@ -100,6 +102,10 @@ Status TabletServerPathHandlers::Register(Webserver* server) {
     "/maintenance-manager", "",
     boost::bind(&TabletServerPathHandlers::HandleMaintenanceManagerPage, this, _1, _2),
     true /* styled */, false /* is_on_nav_bar */);
+  server->RegisterPathHandler(
+    "/block-cache-warmup", "",
+    boost::bind(&TabletServerPathHandlers::HandleBlockCacheWarmupPage, this, _1, _2),
+    true /* styled */, false /* is_on_nav_bar */);
 
   return Status::OK();
 }
@@ -447,6 +453,9 @@ string TabletServerPathHandlers::ScannerToHtml(const Scanner& scanner) const {
     for (const ColumnRangePredicate& pred : scanner.spec().predicates()) {
       other_preds.push_back(pred.ToString());
     }
+    for (const ColumnPredicate& pred : scanner.spec().column_predicates()) {
+      other_preds.push_back(pred.ToString());
+    }
     string other_pred_str = JoinStrings(other_preds, "\n");
     html << Substitute("<td>$0</td><td>$1</td></tr>\n",
                        EscapeForHtmlToString(range_pred_str),
@@ -463,6 +472,7 @@ string TabletServerPathHandlers::IteratorStatsToHtml(const Schema& projection,
        << "<th>Blocks read from disk</th>"
        << "<th>Bytes read from disk</th>"
        << "<th>Cells read from disk</th>"
+       << "<th>Prefetch hit ratio</th>"
        << "</tr>\n";
   for (size_t idx = 0; idx < stats.size(); idx++) {
     // We use 'title' attributes so that if the user hovers over the value, they get a
@@ -472,6 +482,7 @@ string TabletServerPathHandlers::IteratorStatsToHtml(const Schema& projection,
                        "<td title=\"$1\">$2</td>"
                        "<td title=\"$3\">$4</td>"
                        "<td title=\"$5\">$6</td>"
+                       "<td title=\"$7 of $2 blocks\">$8</td>"
                        "</tr>\n",
                        EscapeForHtmlToString(projection.column(idx).name()), // $0
                        HumanReadableInt::ToString(stats[idx].data_blocks_read_from_disk), // $1
@@ -479,7 +490,9 @@ string TabletServerPathHandlers::IteratorStatsToHtml(const Schema& projection,
                        HumanReadableNumBytes::ToString(stats[idx].bytes_read_from_disk), // $3
                        stats[idx].bytes_read_from_disk, // $4
                        HumanReadableInt::ToString(stats[idx].cells_read_from_disk), // $5
-                       stats[idx].cells_read_from_disk); // $6
+                       stats[idx].cells_read_from_disk, // $6
+                       stats[idx].data_blocks_prefetched, // $7
+                       StringPrintf("%.2f", stats[idx].prefetch_hit_ratio())); // $8
   }
   html << "</table>\n";
   return html.str();
@@ -497,6 +510,9 @@ void TabletServerPathHandlers::HandleDashboardsPage(const Webserver::WebRequest&
   *output << GetDashboardLine("maintenance-manager", "Maintenance Manager",
                               "List of operations that are currently running and those "
                               "that are registered.");
+  *output << GetDashboardLine("block-cache-warmup", "Block Cache Warm-up",
+                              "Progress of the warm-up of the block cache with the blocks "
+                              "cached before the last restart.");
 }
 
 string TabletServerPathHandlers::GetDashboardLine(const std::string& link,
@@ -566,5 +582,37 @@ void TabletServerPathHandlers::HandleMaintenanceManagerPage(const Webserver::Web
   *output << "</table>\n";
 }
 
+void TabletServerPathHandlers::HandleBlockCacheWarmupPage(const Webserver::WebRequest& req,
+                                                          std::stringstream* output) {
+  cfile::BlockCacheWarmer::Progress progress = tserver_->block_cache_warmer()->GetProgress();
+
+  *output << "<h1>Block Cache Warm-up</h1>\n";
+  if (!progress.started) {
+    *output << "<p>Warming the block cache up is disabled, see "
+            << "--block_cache_keys_save_interval_secs.</p>\n";
+    return;
+  }
+
+  MonoDelta elapsed = progress.done ?
+      progress.duration :
+      MonoTime::Now(MonoTime::FINE).GetDeltaSince(progress.start_time);
+  double elapsed_secs = elapsed.ToSeconds();
+  *output << "<table class='table table-striped'>\n";
+  *output << Substitute("  <tr><td>Status</td><td>$0</td></tr>\n",
+                        progress.done ? "Done" : "In progress");
+  *output << Substitute("  <tr><td>Blocks loaded</td><td>$0 / $1</td></tr>\n",
+                        progress.blocks_loaded, progress.blocks_total);
+  *output << Substitute("  <tr><td>Blocks skipped</td><td>$0</td></tr>\n",
+                        progress.blocks_skipped);
+  *output << Substitute("  <tr><td>Bytes loaded</td><td>$0</td></tr>\n",
+                        HumanReadableNumBytes::ToString(progress.bytes_loaded));
+  *output << Substitute("  <tr><td>Elapsed</td><td>$0</td></tr>\n",
+                        HumanReadableElapsedTime::ToShortString(elapsed_secs));
+  *output << Substitute("  <tr><td>Throughput</td><td>$0/s</td></tr>\n",
+                        HumanReadableNumBytes::ToString(
+                            elapsed_secs > 0 ? progress.bytes_loaded / elapsed_secs : 0));
+  *output << "</table>\n";
+}
+
 } // namespace tserver
 } // namespace kudu
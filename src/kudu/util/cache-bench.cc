@@ -0,0 +1,132 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Benchmarks of concurrent cache lookups, comparing the LRU cache, whose
+// lookups lock a shard, with the clock cache, whose lookups are lock-free.
+
+#include <atomic>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/cache.h"
+#include "kudu/util/coding.h"
+#include "kudu/util/faststring.h"
+#include "kudu/util/monotime.h"
+#include "kudu/util/random.h"
+#include "kudu/util/stopwatch.h"
+#include "kudu/util/test_util.h"
+
+DEFINE_double(cache_bench_seconds, 0,
+              "Number of seconds each thread count is benchmarked for. "
+              "If 0, picks a duration based on whether slow tests are allowed.");
+DEFINE_int32(cache_bench_max_threads, 64,
+             "Maximum number of threads looking up entries concurrently. The "
+             "benchmark runs with every power of two up to this number.");
+DEFINE_int32(cache_bench_num_keys, 16 * 1024,
+             "Number of entries in the cache, which lookups pick at random.");
+
+using std::string;
+using std::vector;
+using strings::Substitute;
+
+namespace kudu {
+
+class CacheBench : public KuduTest,
+                   public CacheDeleter {
+ public:
+  virtual void Delete(const Slice& key, void* v) OVERRIDE {
+  }
+
+ protected:
+  static string EncodeKey(int k) {
+    faststring result;
+    PutFixed32(&result, k);
+    return result.ToString();
+  }
+
+  // Inserts all the keys into 'cache', which must be large enough for them.
+  void Fill(Cache* cache) {
+    for (int i = 0; i < FLAGS_cache_bench_num_keys; i++) {
+      cache->Release(cache->Insert(EncodeKey(i), nullptr, 1, this));
+    }
+  }
+
+  // Looks up random keys of 'cache' from 'num_threads' threads for
+  // 'seconds', and returns the number of lookups per second.
+  double LookupThroughput(Cache* cache, int num_threads, double seconds) {
+    std::atomic<bool> stop(false);
+    std::atomic<int64_t> total_lookups(0);
+    vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t]() {
+        Random rng(SeedRandom() + t);
+        vector<string> keys;
+        for (int i = 0; i < 1024; i++) {
+          keys.push_back(EncodeKey(rng.Uniform(FLAGS_cache_bench_num_keys)));
+        }
+        int64_t lookups = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+          for (const string& key : keys) {
+            Cache::Handle* h = cache->Lookup(key, Cache::EXPECT_IN_CACHE);
+            CHECK(h != nullptr);
+            cache->Release(h);
+          }
+          lookups += keys.size();
+        }
+        total_lookups += lookups;
+      });
+    }
+
+    Stopwatch sw;
+    sw.start();
+    SleepFor(MonoDelta::FromSeconds(seconds));
+    stop = true;
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    sw.stop();
+    return total_lookups / sw.elapsed().wall_seconds();
+  }
+};
+
+// Measure the throughput of lookups of entries which are all cached, with
+// an increasing number of threads.
+TEST_F(CacheBench, LookupThroughput) {
+  const double kSeconds = FLAGS_cache_bench_seconds > 0 ?
+      FLAGS_cache_bench_seconds : (AllowSlowTests() ? 2 : 0.1);
+  const size_t kCapacity = FLAGS_cache_bench_num_keys * 2;
+
+  gscoped_ptr<Cache> lru(NewLRUCache(DRAM_CACHE, kCapacity, "cache_bench"));
+  gscoped_ptr<Cache> clock(NewClockCache(kCapacity, "cache_bench", 1));
+  NO_FATALS(Fill(lru.get()));
+  NO_FATALS(Fill(clock.get()));
+
+  for (int num_threads = 1; num_threads <= FLAGS_cache_bench_max_threads; num_threads *= 2) {
+    double lru_throughput = LookupThroughput(lru.get(), num_threads, kSeconds);
+    double clock_throughput = LookupThroughput(clock.get(), num_threads, kSeconds);
+    LOG(INFO) << Substitute("$0 threads: LRU $1 lookups/sec, CLOCK $2 lookups/sec ($3x)",
+                            num_threads, lru_throughput, clock_throughput,
+                            clock_throughput / lru_throughput);
+  }
+}
+
+} // namespace kudu
@@ -5,19 +5,28 @@
 #include <glog/logging.h>
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
 #include <memory>
-
+#include <set>
+#include <thread>
 #include <vector>
+
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/cache.h"
 #include "kudu/util/coding.h"
 #include "kudu/util/mem_tracker.h"
 #include "kudu/util/metrics.h"
+#include "kudu/util/random.h"
 #include "kudu/util/test_util.h"
 
 #if defined(__linux__)
 DECLARE_string(nvm_cache_path);
 #endif // defined(__linux__)
 
+METRIC_DECLARE_counter(block_cache_high_priority_hits);
+METRIC_DECLARE_counter(block_cache_normal_priority_misses);
+
 namespace kudu {
 
 // Conversions between numeric keys/values and the types expected by Cache.
@@ -33,8 +42,16 @@ static int DecodeKey(const Slice& k) {
 static void* EncodeValue(uintptr_t v) { return reinterpret_cast<void*>(v); }
 static int DecodeValue(void* v) { return reinterpret_cast<uintptr_t>(v); }
 
+// The implementations of Cache which are tested.
+enum TestCacheType {
+  DRAM_LRU,
+  DRAM_SLRU,
+  NVM_LRU,
+  DRAM_CLOCK
+};
+
 class CacheTest : public KuduTest,
-                  public ::testing::WithParamInterface<CacheType>,
+                  public ::testing::WithParamInterface<TestCacheType>,
                   public CacheDeleter {
  public:
 
@@ -48,6 +65,7 @@ class CacheTest : public KuduTest,
   std::shared_ptr<MemTracker> mem_tracker_;
   gscoped_ptr<Cache> cache_;
   MetricRegistry metric_registry_;
+  scoped_refptr<MetricEntity> metric_entity_;
 
   static const int kCacheSize = 14*1024*1024;
 
@@ -60,22 +78,35 @@ class CacheTest : public KuduTest,
     }
 #endif // defined(__linux__)
 
-    cache_.reset(NewLRUCache(GetParam(), kCacheSize, "cache_test"));
-
-    MemTracker::FindTracker("cache_test-sharded_lru_cache", &mem_tracker_);
+    switch (GetParam()) {
+      case DRAM_LRU:
+        cache_.reset(NewLRUCache(DRAM_CACHE, kCacheSize, "cache_test"));
+        MemTracker::FindTracker("cache_test-sharded_lru_cache", &mem_tracker_);
+        break;
+      case DRAM_SLRU:
+        cache_.reset(NewScanResistantCache(kCacheSize, "cache_test"));
+        MemTracker::FindTracker("cache_test-sharded_lru_cache", &mem_tracker_);
+        break;
+      case NVM_LRU:
+        cache_.reset(NewLRUCache(NVM_CACHE, kCacheSize, "cache_test"));
+        break;
+      case DRAM_CLOCK:
+        cache_.reset(NewClockCache(kCacheSize, "cache_test", kCacheSize / 1000));
+        MemTracker::FindTracker("cache_test-clock_cache", &mem_tracker_);
+        break;
+    }
     // Since nvm cache does not have memtracker due to the use of
     // tcmalloc for this we only check for it in the DRAM case.
-    if (GetParam() == DRAM_CACHE) {
+    if (GetParam() != NVM_LRU) {
       ASSERT_TRUE(mem_tracker_.get());
     }
 
-    scoped_refptr<MetricEntity> entity = METRIC_ENTITY_server.Instantiate(
-        &metric_registry_, "test");
-    cache_->SetMetrics(entity);
+    metric_entity_ = METRIC_ENTITY_server.Instantiate(&metric_registry_, "test");
+    cache_->SetMetrics(metric_entity_);
   }
 
-  int Lookup(int key) {
-    Cache::Handle* handle = cache_->Lookup(EncodeKey(key), Cache::EXPECT_IN_CACHE);
+  int Lookup(int key, Cache::Priority priority = Cache::NORMAL_PRIORITY) {
+    Cache::Handle* handle = cache_->Lookup(EncodeKey(key), Cache::EXPECT_IN_CACHE, priority);
     const int r = (handle == nullptr) ? -1 : DecodeValue(cache_->Value(handle));
     if (handle != nullptr) {
       cache_->Release(handle);
@@ -83,20 +114,34 @@ class CacheTest : public KuduTest,
     return r;
   }
 
-  void Insert(int key, int value, int charge = 1) {
+  void Insert(int key, int value, int charge = 1,
+              Cache::Priority priority = Cache::NORMAL_PRIORITY) {
     cache_->Release(cache_->Insert(EncodeKey(key), EncodeValue(value), charge,
-                                   this));
+                                   this, priority));
   }
 
   void Erase(int key) {
     cache_->Erase(EncodeKey(key));
   }
+
+  // Inserts 'num_entries' entries, looking each up many times right after
+  // inserting it, so that the SLRU policy only admits entries used as much.
+  void InsertFrequentlyUsed(int num_entries, int charge) {
+    for (int i = 0; i < num_entries; i++) {
+      Insert(i, 1000 + i, charge);
+      for (int j = 0; j < 15; j++) {
+        Lookup(i);
+      }
+    }
+  }
 };
 
 #if defined(__linux__)
-INSTANTIATE_TEST_CASE_P(CacheTypes, CacheTest, ::testing::Values(DRAM_CACHE, NVM_CACHE));
+INSTANTIATE_TEST_CASE_P(CacheTypes, CacheTest,
+                        ::testing::Values(DRAM_LRU, DRAM_SLRU, NVM_LRU, DRAM_CLOCK));
 #else
-INSTANTIATE_TEST_CASE_P(CacheTypes, CacheTest, ::testing::Values(DRAM_CACHE));
+INSTANTIATE_TEST_CASE_P(CacheTypes, CacheTest,
+                        ::testing::Values(DRAM_LRU, DRAM_SLRU, DRAM_CLOCK));
 #endif // defined(__linux__)
 
 TEST_P(CacheTest, TrackMemory) {
@@ -177,6 +222,10 @@ TEST_P(CacheTest, EntriesArePinned) {
 }
 
 TEST_P(CacheTest, EvictionPolicy) {
+  if (GetParam() == DRAM_SLRU) {
+    LOG(INFO) << "The SLRU policy does not admit new entries in place of used ones";
+    return;
+  }
   Insert(100, 101);
   Insert(200, 201);
 
@@ -220,10 +269,220 @@ TEST_P(CacheTest, HeavyEntries) {
   ASSERT_LE(cached_weight, kCacheSize + kCacheSize/10);
 }
 
+// Test that high priority entries are evicted after normal priority ones, as
+// long as they fit in the high priority capacity.
+TEST_P(CacheTest, HighPriorityEntries) {
+  if (GetParam() != DRAM_LRU) {
+    LOG(INFO) << "Only DRAM LRU caches support priorities";
+    return;
+  }
+  const int kNumElems = 1000;
+  const int kSizePerElem = kCacheSize / kNumElems;
+  const int kNumHighPriority = kNumElems / 16;
+
+  for (size_t high_priority_capacity : { 0, kCacheSize / 4 }) {
+    SCOPED_TRACE(high_priority_capacity);
+    cache_.reset(NewLRUCache(DRAM_CACHE, kCacheSize, "cache_test", high_priority_capacity));
+    metric_entity_ = METRIC_ENTITY_server.Instantiate(
+        &metric_registry_, strings::Substitute("test_$0", high_priority_capacity));
+    cache_->SetMetrics(metric_entity_);
+
+    for (int i = 0; i < kNumHighPriority; i++) {
+      Insert(i, 1000 + i, kSizePerElem, Cache::HIGH_PRIORITY);
+    }
+    for (int i = 0; i < 2 * kNumElems; i++) {
+      Insert(10000 + i, i, kSizePerElem);
+    }
+
+    if (high_priority_capacity == 0) {
+      ASSERT_EQ(-1, Lookup(0, Cache::HIGH_PRIORITY));
+      continue;
+    }
+    // Hits count towards the priority of the entries, whatever the lookups expect.
+    for (int i = 0; i < kNumHighPriority; i++) {
+      ASSERT_EQ(1000 + i, Lookup(i));
+    }
+    ASSERT_EQ(-1, Lookup(10000));
+    ASSERT_EQ(kNumHighPriority,
+              METRIC_block_cache_high_priority_hits.Instantiate(metric_entity_)->value());
+    ASSERT_EQ(1, METRIC_block_cache_normal_priority_misses.Instantiate(metric_entity_)->value());
+  }
+}
+
+TEST_P(CacheTest, VisitEntries) {
+  const int kNumEntries = 100;
+  for (int i = 0; i < kNumEntries; i++) {
+    Insert(i, 1000 + i);
+  }
+  Erase(0);
+
+  std::set<int> visited;
+  cache_->VisitEntries([&](const Slice& key, void* value) {
+      ASSERT_EQ(1000 + DecodeKey(key), DecodeValue(value));
+      ASSERT_TRUE(visited.insert(DecodeKey(key)).second);
+    });
+  ASSERT_EQ(kNumEntries - 1, visited.size());
+  ASSERT_EQ(0, visited.count(0));
+}
+
+// Test that DRAM LRU caches visit their entries without locking the shards,
+// in batches, so that the visitor may call back into the cache.
+TEST_P(CacheTest, VisitEntriesInBatches) {
+  if (GetParam() != DRAM_LRU && GetParam() != DRAM_SLRU) {
+    LOG(INFO) << "Only DRAM LRU caches visit their entries in batches";
+    return;
+  }
+  // Several batches per shard.
+  const int kNumEntries = 20000;
+  for (int i = 0; i < kNumEntries; i++) {
+    Insert(i, 1000 + i);
+  }
+
+  std::set<int> visited;
+  cache_->VisitEntries([&](const Slice& key, void* value) {
+      ASSERT_EQ(1000 + DecodeKey(key), DecodeValue(value));
+      ASSERT_TRUE(visited.insert(DecodeKey(key)).second);
+      ASSERT_EQ(-1, Lookup(kNumEntries));
+    });
+  ASSERT_EQ(kNumEntries, visited.size());
+}
+
+// Test that an entry which the SLRU policy does not admit lives as long as the
+// handle returned by the insert, and is deleted once when it is released.
+TEST_P(CacheTest, SlruRejectedInsert) {
+  if (GetParam() != DRAM_SLRU) {
+    LOG(INFO) << "Only SLRU caches reject inserts";
+    return;
+  }
+  const int kCharge = kCacheSize / 100;
+  NO_FATALS(InsertFrequentlyUsed(400, kCharge));
+
+  // The new key was never looked up, unlike the entries it would evict.
+  const int kKey = 100000;
+  Cache::Handle* h = cache_->Insert(EncodeKey(kKey), EncodeValue(kKey + 1), kCharge, this);
+  ASSERT_TRUE(h != nullptr);
+  ASSERT_EQ(kKey + 1, DecodeValue(cache_->Value(h)));
+  ASSERT_EQ(-1, Lookup(kKey));
+  ASSERT_EQ(0, std::count(deleted_keys_.begin(), deleted_keys_.end(), kKey));
+
+  cache_->Release(h);
+  ASSERT_EQ(1, std::count(deleted_keys_.begin(), deleted_keys_.end(), kKey));
+  ASSERT_EQ(1, std::count(deleted_values_.begin(), deleted_values_.end(), kKey + 1));
+}
+
+// Test that the SLRU policy always admits an entry which replaces another one
+// with the same key, even when the cache is full, so that lookups never
+// return the old value.
+TEST_P(CacheTest, SlruReplaceWhenFull) {
+  if (GetParam() != DRAM_SLRU) {
+    LOG(INFO) << "Only SLRU caches reject inserts";
+    return;
+  }
+  const int kCharge = kCacheSize / 100;
+  const int kNumEntries = 400;
+  NO_FATALS(InsertFrequentlyUsed(kNumEntries, kCharge));
+
+  int key = 0;
+  while (key < kNumEntries && Lookup(key) == -1) {
+    key++;
+  }
+  ASSERT_LT(key, kNumEntries);
+  Insert(key, 2000 + key, kCharge);
+  ASSERT_EQ(2000 + key, Lookup(key));
+  ASSERT_EQ(1, std::count(deleted_values_.begin(), deleted_values_.end(), 1000 + key));
+}
+
 TEST_P(CacheTest, NewId) {
   uint64_t a = cache_->NewId();
   uint64_t b = cache_->NewId();
   ASSERT_NE(a, b);
 }
 
+// A deleter which counts the entries deleted, from any thread.
+class CountingDeleter : public CacheDeleter {
+ public:
+  CountingDeleter() : num_deleted_(0) {}
+
+  virtual void Delete(const Slice& key, void* v) OVERRIDE {
+    num_deleted_++;
+  }
+
+  int64_t num_deleted() const { return num_deleted_; }
+
+ private:
+  std::atomic<int64_t> num_deleted_;
+};
+
+// Test that the lock-free lookups of the clock cache only ever return the
+// value of their key, and that every entry is deleted exactly once, while
+// other threads insert, erase and evict entries concurrently.
+TEST_P(CacheTest, ClockCacheConcurrentAccess) {
+  if (GetParam() != DRAM_CLOCK) {
+    LOG(INFO) << "Only clock caches have lock-free lookups";
+    return;
+  }
+  const int kNumThreads = 16;
+  const int kNumKeys = 4000;
+  const int kCharge = 1000;
+  const int kOpsPerThread = AllowSlowTests() ? 1000000 : 100000;
+
+  CountingDeleter deleter;
+  std::atomic<int64_t> num_inserted(0);
+  // Only a quarter of the keys fit in the cache.
+  cache_.reset(NewClockCache(kNumKeys * kCharge / 4, "cache_test", kCharge));
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      Random rng(SeedRandom() + t);
+      for (int i = 0; i < kOpsPerThread; i++) {
+        const int key = rng.Uniform(kNumKeys);
+        switch (rng.Uniform(10)) {
+          case 0:
+            cache_->Release(cache_->Insert(EncodeKey(key), EncodeValue(key), kCharge,
+                                           &deleter));
+            num_inserted++;
+            break;
+          case 1:
+            cache_->Erase(EncodeKey(key));
+            break;
+          default: {
+            Cache::Handle* h = cache_->Lookup(EncodeKey(key), Cache::EXPECT_IN_CACHE);
+            if (h != nullptr) {
+              CHECK_EQ(key, DecodeValue(cache_->Value(h)));
+              cache_->Release(h);
+            }
+            break;
+          }
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_LT(deleter.num_deleted(), num_inserted);
+  cache_.reset();
+  ASSERT_EQ(num_inserted, deleter.num_deleted());
+}
+
+// Test that the clock cache keeps admitting entries which are much smaller
+// than the estimated charge its table was sized for, by evicting entries
+// once the table is full even though the capacity is not.
+TEST_P(CacheTest, ClockCacheSmallEntries) {
+  if (GetParam() != DRAM_CLOCK) {
+    LOG(INFO) << "Only clock caches have a fixed number of slots";
+    return;
+  }
+  // The table is sized for about 1000 entries, while the capacity fits
+  // 'kCacheSize' entries of charge 1.
+  const int kNumEntries = 20000;
+  for (int i = 0; i < kNumEntries; i++) {
+    Insert(i, 1000 + i);
+    ASSERT_EQ(1000 + i, Lookup(i));
+  }
+  ASSERT_GT(deleted_keys_.size(), kNumEntries / 2);
+}
+
 }  // namespace kudu
@@ -2,13 +2,16 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <glog/logging.h>
 #include <memory>
 #include <stdlib.h>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "kudu/gutil/atomic_refcount.h"
+#include "kudu/gutil/bits.h"
 #include "kudu/gutil/hash/city.h"
 #include "kudu/gutil/stl_util.h"
 #include "kudu/gutil/strings/substitute.h"
@@ -37,6 +40,30 @@ using std::vector;
 
 typedef simple_spinlock MutexType;
 
+// The eviction policies of a cache shard. See NewLRUCache() and
+// NewScanResistantCache().
+enum EvictionPolicy {
+  LRU_POLICY,
+  SLRU_POLICY
+};
+
+// The segments of a cache shard which an entry may be in.
+enum Segment {
+  // The entry was inserted and not looked up since. This is the only segment
+  // of LRU caches for normal priority entries.
+  PROBATIONARY_SEGMENT,
+
+  // The entry was looked up at least once after being inserted.
+  PROTECTED_SEGMENT,
+
+  // The entry has high priority, and fits in the high priority capacity.
+  HIGH_PRIORITY_SEGMENT,
+
+  // The entry was not admitted into the cache: it only lives as long as the
+  // handle returned by Insert().
+  UNCACHED_SEGMENT
+};
+
 // LRU cache implementation
 
 // An entry is a variable length heap-allocated structure.  Entries
@@ -51,6 +78,8 @@ struct LRUHandle {
   size_t key_length;
   Atomic32 refs;
   uint32_t hash;      // Hash of key(); used for fast sharding and comparisons
+  uint8_t segment;    // The Segment of the cache the entry is in.
+  uint8_t priority;   // The Cache::Priority of the entry.
   uint8_t key_data[1];   // Beginning of key
 
   Slice key() const {
@@ -150,69 +179,206 @@ class HandleTable {
   }
 };
 
+// A count-min sketch of the number of times keys were looked up recently,
+// from which the SLRU policy decides whether to admit new entries.
+//
+// The counters are halved after every 10 increments per counter of a row,
+// so that the estimates favor recent lookups.
+class FrequencySketch {
+ public:
+  // 'width' is the number of counters per row, and must be a power of 2.
+  explicit FrequencySketch(size_t width)
+      : width_(width),
+        counters_(kDepth * width, 0),
+        num_increments_(0),
+        sample_size_(10 * width) {
+    DCHECK_EQ(0, width & (width - 1));
+  }
+
+  void Increment(uint32_t hash) {
+    for (int row = 0; row < kDepth; row++) {
+      uint8_t* counter = &counters_[Index(hash, row)];
+      if (*counter < kMaxCount) {
+        (*counter)++;
+      }
+    }
+    if (++num_increments_ >= sample_size_) {
+      for (uint8_t& counter : counters_) {
+        counter /= 2;
+      }
+      num_increments_ /= 2;
+    }
+  }
+
+  int Estimate(uint32_t hash) const {
+    int estimate = kMaxCount;
+    for (int row = 0; row < kDepth; row++) {
+      estimate = std::min<int>(estimate, counters_[Index(hash, row)]);
+    }
+    return estimate;
+  }
+
+ private:
+  static const int kDepth = 4;
+  static const uint8_t kMaxCount = 15;
+
+  size_t Index(uint32_t hash, int row) const {
+    static const uint64_t kSeeds[kDepth] = {
+      0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL,
+      0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL
+    };
+    uint64_t h = hash * kSeeds[row];
+    return row * width_ + ((h >> 32) & (width_ - 1));
+  }
+
+  const size_t width_;
+  vector<uint8_t> counters_;
+  size_t num_increments_;
+  const size_t sample_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(FrequencySketch);
+};
+
 // A single shard of sharded cache.
+//
+// With the LRU policy, entries are evicted in least recently used order.
+//
+// With the SLRU policy, the shard is segmented: entries are inserted into the
+// probationary segment, and move to the protected segment when looked up.
+// The protected segment takes up to kProtectedRatio of the capacity; its
+// least recently used entries move back to the probationary segment beyond
+// that. Entries are evicted from the probationary segment first, so entries
+// which are only used once, e.g. by a scan, do not evict the entries which
+// are used repeatedly. In addition, once the shard is full, a new entry is
+// only admitted if its key was looked up at least as frequently as the key
+// of the entry it would evict, according to a FrequencySketch.
+//
+// With either policy, high priority entries go to the high priority segment
+// when inserted or looked up, if the shard has a high priority capacity. Its
+// least recently used entries move to the probationary segment beyond that
+// capacity, and it is the last segment entries are evicted from.
 class LRUCache {
  public:
-  explicit LRUCache(MemTracker* tracker);
+  LRUCache(MemTracker* tracker, EvictionPolicy policy);
   ~LRUCache();
 
   // Separate from constructor so caller can easily make an array of LRUCache
-  void SetCapacity(size_t capacity) { capacity_ = capacity; }
+  void SetCapacity(size_t capacity, size_t high_priority_capacity);
 
   void SetMetrics(CacheMetrics* metrics) { metrics_ = metrics; }
 
   // Like Cache methods, but with an extra "hash" parameter.
   Cache::Handle* Insert(const Slice& key, uint32_t hash,
                         void* value, size_t charge,
-                        CacheDeleter* deleter);
-  Cache::Handle* Lookup(const Slice& key, uint32_t hash, bool caching);
+                        CacheDeleter* deleter, Cache::Priority priority);
+  Cache::Handle* Lookup(const Slice& key, uint32_t hash, bool caching,
+                        Cache::Priority priority);
   void Release(Cache::Handle* handle);
   void Erase(const Slice& key, uint32_t hash);
+  void VisitEntries(const Cache::EntryVisitor& visitor);
 
  private:
+  // The share of the capacity of an SLRU shard which its protected segment
+  // may take.
+  static constexpr double kProtectedRatio = 0.8;
+
+  // The maximum number of entries VisitEntries() references at once.
+  static const int kVisitBatchSize = 256;
+
   void LRU_Remove(LRUHandle* e);
+  // Makes 'e' the newest entry of the segment it is in.
   void LRU_Append(LRUHandle* e);
+  // Returns the segment which 'e' goes to when looked up.
+  Segment SegmentAfterLookup(const LRUHandle* e) const;
+  // Returns the next entry to evict, or NULL if the shard is empty.
+  LRUHandle* NextVictim();
+  // Moves the oldest entries of the protected and high priority segments to
+  // the probationary segment until these segments fit in their capacities.
+  void DemoteEntries();
+  // Returns true if an entry with the given hash and charge should be
+  // admitted into the shard.
+  bool Admit(uint32_t hash, size_t charge);
   // Just reduce the reference count by 1.
   // Return true if last reference
   bool Unref(LRUHandle* e);
   // Call deleter and free
   void FreeEntry(LRUHandle* e);
 
+  const EvictionPolicy policy_;
+
   // Initialized before use.
   size_t capacity_;
+  size_t protected_capacity_;
+  size_t high_priority_capacity_;
 
   // mutex_ protects the following state.
   MutexType mutex_;
   size_t usage_;
+  size_t protected_usage_;
+  size_t high_priority_usage_;
 
-  // Dummy head of LRU list.
+  // Dummy head of LRU list of the probationary segment.
   // lru.prev is newest entry, lru.next is oldest entry.
   LRUHandle lru_;
 
+  // Dummy head of LRU list of the protected segment, which is empty with
+  // the LRU policy.
+  LRUHandle protected_;
+
+  // Dummy head of LRU list of the high priority segment.
+  LRUHandle high_priority_;
+
   HandleTable table_;
 
+  // Only used with the SLRU policy.
+  gscoped_ptr<FrequencySketch> sketch_;
+
   MemTracker* mem_tracker_;
 
   CacheMetrics* metrics_;
 };
 
-LRUCache::LRUCache(MemTracker* tracker)
- : usage_(0),
+LRUCache::LRUCache(MemTracker* tracker, EvictionPolicy policy)
+ : policy_(policy),
+   capacity_(0),
+   protected_capacity_(0),
+   high_priority_capacity_(0),
+   usage_(0),
+   protected_usage_(0),
+   high_priority_usage_(0),
    mem_tracker_(tracker),
    metrics_(nullptr) {
-  // Make empty circular linked list
+  // Make empty circular linked lists
   lru_.next = &lru_;
   lru_.prev = &lru_;
+  protected_.next = &protected_;
+  protected_.prev = &protected_;
+  high_priority_.next = &high_priority_;
+  high_priority_.prev = &high_priority_;
 }
 
 LRUCache::~LRUCache() {
-  for (LRUHandle* e = lru_.next; e != &lru_; ) {
-    LRUHandle* next = e->next;
-    DCHECK_EQ(e->refs, 1);  // Error if caller has an unreleased handle
-    if (Unref(e)) {
-      FreeEntry(e);
+  for (LRUHandle* head : { &lru_, &protected_, &high_priority_ }) {
+    for (LRUHandle* e = head->next; e != head; ) {
+      LRUHandle* next = e->next;
+      DCHECK_EQ(e->refs, 1);  // Error if caller has an unreleased handle
+      if (Unref(e)) {
+        FreeEntry(e);
+      }
+      e = next;
     }
-    e = next;
+  }
+}
+
+void LRUCache::SetCapacity(size_t capacity, size_t high_priority_capacity) {
+  capacity_ = capacity;
+  high_priority_capacity_ = std::min(high_priority_capacity, capacity);
+  if (policy_ == SLRU_POLICY) {
+    protected_capacity_ = capacity * kProtectedRatio;
+    // Size the sketch for about one counter per 4KB of capacity, which is
+    // plenty for cached cfile blocks.
+    size_t width = std::min<size_t>(std::max<size_t>(capacity / 4096, 256), 1 << 22);
+    sketch_.reset(new FrequencySketch(1ULL << Bits::Log2Ceiling64(width)));
   }
 }
 
@@ -227,7 +393,9 @@ void LRUCache::FreeEntry(LRUHandle* e) {
   mem_tracker_->Release(e->charge);
   if (PREDICT_TRUE(metrics_)) {
     metrics_->cache_usage->DecrementBy(e->charge);
-    metrics_->evictions->Increment();
+    if (e->segment != UNCACHED_SEGMENT) {
+      metrics_->evictions->Increment();
+    }
   }
   free(e);
 }
@@ -236,18 +404,72 @@ void LRUCache::LRU_Remove(LRUHandle* e) {
   e->next->prev = e->prev;
   e->prev->next = e->next;
   usage_ -= e->charge;
+  if (e->segment == PROTECTED_SEGMENT) {
+    protected_usage_ -= e->charge;
+  } else if (e->segment == HIGH_PRIORITY_SEGMENT) {
+    high_priority_usage_ -= e->charge;
+  }
 }
 
 void LRUCache::LRU_Append(LRUHandle* e) {
-  // Make "e" newest entry by inserting just before lru_
-  e->next = &lru_;
-  e->prev = lru_.prev;
+  // Make "e" newest entry by inserting just before the head of its list
+  LRUHandle* head = &lru_;
+  if (e->segment == PROTECTED_SEGMENT) {
+    head = &protected_;
+    protected_usage_ += e->charge;
+  } else if (e->segment == HIGH_PRIORITY_SEGMENT) {
+    head = &high_priority_;
+    high_priority_usage_ += e->charge;
+  }
+  e->next = head;
+  e->prev = head->prev;
   e->prev->next = e;
   e->next->prev = e;
   usage_ += e->charge;
 }
 
-Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash, bool caching) {
+Segment LRUCache::SegmentAfterLookup(const LRUHandle* e) const {
+  if (e->priority == Cache::HIGH_PRIORITY && high_priority_capacity_ > 0) {
+    return HIGH_PRIORITY_SEGMENT;
+  }
+  return policy_ == SLRU_POLICY ? PROTECTED_SEGMENT : PROBATIONARY_SEGMENT;
+}
+
+LRUHandle* LRUCache::NextVictim() {
+  for (LRUHandle* head : { &lru_, &protected_, &high_priority_ }) {
+    if (head->next != head) {
+      return head->next;
+    }
+  }
+  return nullptr;
+}
+
+void LRUCache::DemoteEntries() {
+  while (protected_usage_ > protected_capacity_ && protected_.next != &protected_) {
+    LRUHandle* e = protected_.next;
+    LRU_Remove(e);
+    e->segment = PROBATIONARY_SEGMENT;
+    LRU_Append(e);
+  }
+  while (high_priority_usage_ > high_priority_capacity_ &&
+         high_priority_.next != &high_priority_) {
+    LRUHandle* e = high_priority_.next;
+    LRU_Remove(e);
+    e->segment = PROBATIONARY_SEGMENT;
+    LRU_Append(e);
+  }
+}
+
+bool LRUCache::Admit(uint32_t hash, size_t charge) {
+  if (usage_ + charge <= capacity_) {
+    return true;
+  }
+  LRUHandle* victim = NextVictim();
+  return victim == nullptr || sketch_->Estimate(hash) >= sketch_->Estimate(victim->hash);
+}
+
+Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash, bool caching,
+                                Cache::Priority priority) {
   LRUHandle* e;
   {
     lock_guard<MutexType> l(&mutex_);
@@ -255,7 +477,12 @@ Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash, bool caching) {
     if (e != nullptr) {
       base::RefCountInc(&e->refs);
       LRU_Remove(e);
+      e->segment = SegmentAfterLookup(e);
       LRU_Append(e);
+      DemoteEntries();
+    }
+    if (policy_ == SLRU_POLICY) {
+      sketch_->Increment(hash);
     }
   }
 
@@ -276,6 +503,16 @@ Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash, bool caching) {
         metrics_->cache_misses->Increment();
       }
     }
+    // Hits count towards the priority of the entry, which may differ from the
+    // one the caller expected.
+    if (was_hit) {
+      priority = static_cast<Cache::Priority>(e->priority);
+    }
+    if (priority == Cache::HIGH_PRIORITY) {
+      (was_hit ? metrics_->high_priority_hits : metrics_->high_priority_misses)->Increment();
+    } else {
+      (was_hit ? metrics_->normal_priority_hits : metrics_->normal_priority_misses)->Increment();
+    }
   }
 
   return reinterpret_cast<Cache::Handle*>(e);
@@ -291,7 +528,7 @@ void LRUCache::Release(Cache::Handle* handle) {
 
 Cache::Handle* LRUCache::Insert(
     const Slice& key, uint32_t hash, void* value, size_t charge,
-    CacheDeleter *deleter) {
+    CacheDeleter *deleter, Cache::Priority priority) {
 
   LRUHandle* e = reinterpret_cast<LRUHandle*>(
       malloc(sizeof(LRUHandle)-1 + key.size()));
@@ -303,6 +540,9 @@ Cache::Handle* LRUCache::Insert(
   e->key_length = key.size();
   e->hash = hash;
   e->refs = 2;  // One from LRUCache, one for the returned handle
+  e->priority = priority;
+  e->segment = priority == Cache::HIGH_PRIORITY && high_priority_capacity_ > 0 ?
+      HIGH_PRIORITY_SEGMENT : PROBATIONARY_SEGMENT;
   memcpy(e->key_data, key.data(), key.size());
   mem_tracker_->Consume(charge);
   if (PREDICT_TRUE(metrics_)) {
@@ -313,6 +553,19 @@ Cache::Handle* LRUCache::Insert(
   {
     lock_guard<MutexType> l(&mutex_);
 
+    // High priority entries are always admitted, and so are entries which
+    // replace another one with the same key, so that lookups never return
+    // stale values.
+    if (policy_ == SLRU_POLICY &&
+        priority != Cache::HIGH_PRIORITY &&
+        table_.Lookup(key, hash) == nullptr &&
+        !Admit(hash, charge)) {
+      e->segment = UNCACHED_SEGMENT;
+      e->refs = 1;  // Only the returned handle
+      e->next = e->prev = nullptr;
+      return reinterpret_cast<Cache::Handle*>(e);
+    }
+
     LRU_Append(e);
 
     LRUHandle* old = table_.Insert(e);
@@ -324,13 +577,14 @@ Cache::Handle* LRUCache::Insert(
       }
     }
 
-    while (usage_ > capacity_ && lru_.next != &lru_) {
-      LRUHandle* old = lru_.next;
-      LRU_Remove(old);
-      table_.Remove(old->key(), old->hash);
-      if (Unref(old)) {
-        old->next = to_remove_head;
-        to_remove_head = old;
+    DemoteEntries();
+    LRUHandle* victim;
+    while (usage_ > capacity_ && (victim = NextVictim()) != nullptr) {
+      LRU_Remove(victim);
+      table_.Remove(victim->key(), victim->hash);
+      if (Unref(victim)) {
+        victim->next = to_remove_head;
+        to_remove_head = victim;
       }
     }
   }
@@ -364,6 +618,56 @@ void LRUCache::Erase(const Slice& key, uint32_t hash) {
   }
 }
 
+void LRUCache::VisitEntries(const Cache::EntryVisitor& visitor) {
+  // Visit the segments in the reverse order of eviction, each from its
+  // newest entry.
+  const std::pair<LRUHandle*, Segment> segments[] = {
+    { &high_priority_, HIGH_PRIORITY_SEGMENT },
+    { &protected_, PROTECTED_SEGMENT },
+    { &lru_, PROBATIONARY_SEGMENT }
+  };
+  // The entries are referenced in batches with the mutex held, and visited
+  // after releasing it, so that the visit does not block the shard. The last
+  // entry of a batch stays referenced, and the next batch starts from it if
+  // it is still in the same segment.
+  LRUHandle* batch[kVisitBatchSize];
+  for (const auto& segment : segments) {
+    LRUHandle* head = segment.first;
+    LRUHandle* cursor = nullptr;
+    int n;
+    do {
+      n = 0;
+      {
+        lock_guard<MutexType> l(&mutex_);
+        LRUHandle* e = head->prev;
+        if (cursor != nullptr) {
+          bool in_segment = cursor->segment == segment.second &&
+              table_.Lookup(cursor->key(), cursor->hash) == cursor;
+          // Otherwise, the rest of the segment is not visited.
+          e = in_segment ? cursor->prev : head;
+        }
+        for (; e != head && n < kVisitBatchSize; e = e->prev) {
+          base::RefCountInc(&e->refs);
+          batch[n++] = e;
+        }
+      }
+      if (cursor != nullptr && Unref(cursor)) {
+        FreeEntry(cursor);
+      }
+      cursor = n > 0 ? batch[n - 1] : nullptr;
+      for (int i = 0; i < n; i++) {
+        visitor(batch[i]->key(), batch[i]->value);
+        if (batch[i] != cursor && Unref(batch[i])) {
+          FreeEntry(batch[i]);
+        }
+      }
+    } while (n == kVisitBatchSize);
+    if (cursor != nullptr && Unref(cursor)) {
+      FreeEntry(cursor);
+    }
+  }
+}
+
 static const int kNumShardBits = 4;
 static const int kNumShards = 1 << kNumShardBits;
 
@@ -385,7 +689,8 @@ class ShardedLRUCache : public Cache {
   }
 
  public:
-  explicit ShardedLRUCache(size_t capacity, const string& id)
+  ShardedLRUCache(size_t capacity, const string& id, EvictionPolicy policy,
+                  size_t high_priority_capacity)
       : last_id_(0) {
     // A cache is often a singleton, so:
     // 1. We reuse its MemTracker if one already exists, and
@@ -394,9 +699,11 @@ class ShardedLRUCache : public Cache {
         -1, strings::Substitute("$0-sharded_lru_cache", id));
 
     const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
+    const size_t high_priority_per_shard =
+        (high_priority_capacity + (kNumShards - 1)) / kNumShards;
     for (int s = 0; s < kNumShards; s++) {
-      gscoped_ptr<LRUCache> shard(new LRUCache(mem_tracker_.get()));
-      shard->SetCapacity(per_shard);
+      gscoped_ptr<LRUCache> shard(new LRUCache(mem_tracker_.get(), policy));
+      shard->SetCapacity(per_shard, high_priority_per_shard);
       shards_.push_back(shard.release());
     }
   }
@@ -406,13 +713,14 @@ class ShardedLRUCache : public Cache {
   }
 
   virtual Handle* Insert(const Slice& key, void* value, size_t charge,
-                         CacheDeleter* deleter) OVERRIDE {
+                         CacheDeleter* deleter, Priority priority) OVERRIDE {
     const uint32_t hash = HashSlice(key);
-    return shards_[Shard(hash)]->Insert(key, hash, value, charge, deleter);
+    return shards_[Shard(hash)]->Insert(key, hash, value, charge, deleter, priority);
   }
-  virtual Handle* Lookup(const Slice& key, CacheBehavior caching) OVERRIDE {
+  virtual Handle* Lookup(const Slice& key, CacheBehavior caching,
+                         Priority priority) OVERRIDE {
     const uint32_t hash = HashSlice(key);
-    return shards_[Shard(hash)]->Lookup(key, hash, caching == EXPECT_IN_CACHE);
+    return shards_[Shard(hash)]->Lookup(key, hash, caching == EXPECT_IN_CACHE, priority);
   }
   virtual void Release(Handle* handle) OVERRIDE {
     LRUHandle* h = reinterpret_cast<LRUHandle*>(handle);
@@ -437,6 +745,12 @@ class ShardedLRUCache : public Cache {
     }
   }
 
+  virtual void VisitEntries(const EntryVisitor& visitor) OVERRIDE {
+    for (LRUCache* cache : shards_) {
+      cache->VisitEntries(visitor);
+    }
+  }
+
   virtual uint8_t* Allocate(int bytes) OVERRIDE {
     DCHECK_GE(bytes, 0);
     return new uint8_t[bytes];
@@ -455,10 +769,11 @@ class ShardedLRUCache : public Cache {
 
 }  // end anonymous namespace
 
-Cache* NewLRUCache(CacheType type, size_t capacity, const string& id) {
+Cache* NewLRUCache(CacheType type, size_t capacity, const string& id,
+                   size_t high_priority_capacity) {
   switch (type) {
     case DRAM_CACHE:
-      return new ShardedLRUCache(capacity, id);
+      return new ShardedLRUCache(capacity, id, LRU_POLICY, high_priority_capacity);
 #if !defined(__APPLE__)
     case NVM_CACHE:
       return NewLRUNvmCache(capacity, id);
@@ -468,4 +783,9 @@ Cache* NewLRUCache(CacheType type, size_t capacity, const string& id) {
   }
 }
 
+Cache* NewScanResistantCache(size_t capacity, const string& id,
+                             size_t high_priority_capacity) {
+  return new ShardedLRUCache(capacity, id, SLRU_POLICY, high_priority_capacity);
+}
+
 }  // namespace kudu
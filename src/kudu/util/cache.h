@@ -18,6 +18,7 @@
 #ifndef KUDU_UTIL_CACHE_H_
 #define KUDU_UTIL_CACHE_H_
 
+#include <boost/function.hpp>
 #include <stdint.h>
 #include <string>
 
@@ -38,7 +39,36 @@ enum CacheType {
 
 // Create a new cache with a fixed size capacity.  This implementation
 // of Cache uses a least-recently-used eviction policy.
-Cache* NewLRUCache(CacheType type, size_t capacity, const std::string& id);
+//
+// 'high_priority_capacity' bytes of the capacity are reserved for high
+// priority entries: see Cache::Priority. NVM caches do not support
+// priorities, and treat all entries the same.
+Cache* NewLRUCache(CacheType type, size_t capacity, const std::string& id,
+                   size_t high_priority_capacity = 0);
+
+// Create a new DRAM cache with a fixed size capacity, whose eviction policy
+// resists scans: entries which are looked up again after being inserted are
+// evicted after the entries which are not, and once the cache is full, new
+// entries are only admitted if their keys were looked up at least as
+// frequently as the keys of the entries they would evict. This way, inserting
+// many entries which are only used once does not flush the entries which are
+// used repeatedly.
+//
+// 'high_priority_capacity' is as for NewLRUCache(). High priority entries are
+// always admitted.
+Cache* NewScanResistantCache(size_t capacity, const std::string& id,
+                             size_t high_priority_capacity = 0);
+
+// Create a new DRAM cache with a fixed size capacity, whose lookups and
+// releases do not take any lock, so that they scale with the number of
+// threads which use the cache concurrently. Entries are evicted with the
+// CLOCK algorithm, which approximates LRU. Inserts and erases are still
+// serialized per shard.
+//
+// The hash table of the cache is sized for entries of 'estimated_charge'
+// bytes. Once it is full, new entries are not admitted into the cache: they
+// only live until their handles are released. Priorities are not supported.
+Cache* NewClockCache(size_t capacity, const std::string& id, size_t estimated_charge);
 
 // Callback interface for deleting a value stored in the cache.
 // This is called when an inserted entry is no longer needed.
@@ -62,12 +92,26 @@ class Cache {
   // Opaque handle to an entry stored in the cache.
   struct Handle { };
 
+  // The priority of an entry, which is given when it is inserted.
+  //
+  // High priority entries are only evicted once there are no normal priority
+  // entries left, as long as they fit in the high priority capacity of the
+  // cache. Beyond that capacity, the least recently used high priority
+  // entries are evicted like normal priority ones, until they are looked up
+  // again.
+  enum Priority {
+    NORMAL_PRIORITY,
+    HIGH_PRIORITY
+  };
+
   // Insert a mapping from key->value into the cache and assign it
   // the specified charge against the total cache capacity.
   //
   // Returns a handle that corresponds to the mapping.  The caller
   // must call this->Release(handle) when the returned mapping is no
-  // longer needed.
+  // longer needed. Depending on the eviction policy of the cache, the
+  // mapping may not be admitted into the cache at all, in which case it
+  // only lives as long as the returned handle.
   //
   // Note that the 'key' Slice is copied into the internal storage of
   // the cache. The caller may free or mutate the key data freely
@@ -77,7 +121,13 @@ class Cache {
   // value will be passed to "deleter". The deleter callback must remain
   // valid until it is called.
   virtual Handle* Insert(const Slice& key, void* value, size_t charge,
-                         CacheDeleter* deleter) = 0;
+                         CacheDeleter* deleter, Priority priority) = 0;
+
+  // Same as above, with a normal priority.
+  Handle* Insert(const Slice& key, void* value, size_t charge,
+                 CacheDeleter* deleter) {
+    return Insert(key, value, charge, deleter, NORMAL_PRIORITY);
+  }
 
   // Passing EXPECT_IN_CACHE will increment the hit/miss metrics that track the number of times
   // blocks were requested that the users were hoping to get the block from the cache, along with
@@ -94,7 +144,16 @@ class Cache {
   // Else return a handle that corresponds to the mapping.  The caller
   // must call this->Release(handle) when the returned mapping is no
   // longer needed.
-  virtual Handle* Lookup(const Slice& key, CacheBehavior caching) = 0;
+  //
+  // 'priority' is the priority the caller would insert the entry with, and
+  // is only used for metrics: misses count towards it, while hits count
+  // towards the priority of the entry found.
+  virtual Handle* Lookup(const Slice& key, CacheBehavior caching, Priority priority) = 0;
+
+  // Same as above, with a normal priority.
+  Handle* Lookup(const Slice& key, CacheBehavior caching) {
+    return Lookup(key, caching, NORMAL_PRIORITY);
+  }
 
   // Release a mapping returned by a previous Lookup().
   // REQUIRES: handle must not have been released yet.
@@ -121,6 +180,17 @@ class Cache {
   // Pass a metric entity in order to start recoding metrics.
   virtual void SetMetrics(const scoped_refptr<MetricEntity>& metric_entity) = 0;
 
+  // Calls 'visitor' with the key and value of each entry of the cache. Within
+  // a shard, entries which are evicted last are visited first, if the cache
+  // keeps track of it.
+  //
+  // The visit is only an approximate snapshot: entries inserted, looked up
+  // or evicted concurrently may be visited twice or not at all. Depending on
+  // the cache, the visitor may be called with a shard locked: it must not
+  // call back into the cache.
+  typedef boost::function<void(const Slice& key, void* value)> EntryVisitor;
+  virtual void VisitEntries(const EntryVisitor& visitor) = 0;
+
   // Allocate 'bytes' bytes from the cache's memory pool.
   //
   // It is possible that this will return NULL if the cache is above its capacity
@@ -45,10 +45,44 @@ METRIC_DEFINE_counter(server, block_cache_hits_caching,
                       "Use this number instead of cache_hits when trying to determine how "
                       "efficient the cache is");
 
+METRIC_DEFINE_counter(server, block_cache_normal_priority_hits,
+                      "Block Cache Normal Priority Hits", kudu::MetricUnit::kBlocks,
+                      "Number of lookups of normal priority blocks, such as data blocks, "
+                      "that found a block");
+METRIC_DEFINE_counter(server, block_cache_normal_priority_misses,
+                      "Block Cache Normal Priority Misses", kudu::MetricUnit::kBlocks,
+                      "Number of lookups of normal priority blocks, such as data blocks, "
+                      "that didn't yield a block");
+METRIC_DEFINE_counter(server, block_cache_high_priority_hits,
+                      "Block Cache High Priority Hits", kudu::MetricUnit::kBlocks,
+                      "Number of lookups of high priority blocks, such as index and "
+                      "bloom filter blocks, that found a block");
+METRIC_DEFINE_counter(server, block_cache_high_priority_misses,
+                      "Block Cache High Priority Misses", kudu::MetricUnit::kBlocks,
+                      "Number of lookups of high priority blocks, such as index and "
+                      "bloom filter blocks, that didn't yield a block");
+
 METRIC_DEFINE_gauge_uint64(server, block_cache_usage, "Block Cache Memory Usage",
                            kudu::MetricUnit::kBytes,
                            "Memory consumed by the block cache");
 
+METRIC_DEFINE_counter(server, block_cache_compressed_tier_inserts,
+                      "Block Cache Compressed Tier Inserts", kudu::MetricUnit::kBlocks,
+                      "Number of compressed blocks inserted in the compressed tier of "
+                      "the block cache");
+METRIC_DEFINE_counter(server, block_cache_compressed_tier_hits,
+                      "Block Cache Compressed Tier Hits", kudu::MetricUnit::kBlocks,
+                      "Number of blocks missing from the block cache whose compressed "
+                      "data was found in its compressed tier");
+METRIC_DEFINE_counter(server, block_cache_compressed_tier_misses,
+                      "Block Cache Compressed Tier Misses", kudu::MetricUnit::kBlocks,
+                      "Number of blocks missing from the block cache whose compressed "
+                      "data was not found in its compressed tier either");
+METRIC_DEFINE_gauge_uint64(server, block_cache_compressed_tier_usage,
+                           "Block Cache Compressed Tier Memory Usage",
+                           kudu::MetricUnit::kBytes,
+                           "Memory consumed by the compressed tier of the block cache");
+
 namespace kudu {
 
 #define MINIT(member, x) member(METRIC_##x.Instantiate(entity))
@@ -61,7 +95,15 @@ CacheMetrics::CacheMetrics(const scoped_refptr<MetricEntity>& entity)
     MINIT(cache_hits_caching, block_cache_hits_caching),
     MINIT(cache_misses, block_cache_misses),
     MINIT(cache_misses_caching, block_cache_misses_caching),
-    GINIT(cache_usage, block_cache_usage) {
+    MINIT(normal_priority_hits, block_cache_normal_priority_hits),
+    MINIT(normal_priority_misses, block_cache_normal_priority_misses),
+    MINIT(high_priority_hits, block_cache_high_priority_hits),
+    MINIT(high_priority_misses, block_cache_high_priority_misses),
+    GINIT(cache_usage, block_cache_usage),
+    MINIT(compressed_tier_inserts, block_cache_compressed_tier_inserts),
+    MINIT(compressed_tier_hits, block_cache_compressed_tier_hits),
+    MINIT(compressed_tier_misses, block_cache_compressed_tier_misses),
+    GINIT(compressed_tier_usage, block_cache_compressed_tier_usage) {
 }
 #undef MINIT
 #undef GINIT
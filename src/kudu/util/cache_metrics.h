@@ -40,7 +40,20 @@ struct CacheMetrics {
   scoped_refptr<Counter> cache_misses;
   scoped_refptr<Counter> cache_misses_caching;
 
+  // Hits and misses of the lookups of entries of each Cache::Priority.
+  scoped_refptr<Counter> normal_priority_hits;
+  scoped_refptr<Counter> normal_priority_misses;
+  scoped_refptr<Counter> high_priority_hits;
+  scoped_refptr<Counter> high_priority_misses;
+
   scoped_refptr<AtomicGauge<uint64_t> > cache_usage;
+
+  // Metrics of the compressed tier of the block cache, if any. They are
+  // recorded by the block cache itself rather than by a Cache implementation.
+  scoped_refptr<Counter> compressed_tier_inserts;
+  scoped_refptr<Counter> compressed_tier_hits;
+  scoped_refptr<Counter> compressed_tier_misses;
+  scoped_refptr<AtomicGauge<uint64_t> > compressed_tier_usage;
 };
 
 } // namespace kudu
@@ -0,0 +1,605 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// A cache whose lookups and releases do not take any lock.
+//
+// Each shard of the cache is an open-addressing hash table with a fixed
+// number of slots. The state of a slot, the number of references to its
+// entry and the access bit of the entry are packed into a single atomic
+// word, so that a lookup acquires a reference to an entry with a single
+// atomic increment, and a release drops it with a single atomic decrement.
+// Slots are never freed while the cache exists, so lookups can safely probe
+// slots which are being modified concurrently.
+//
+// Inserts and erases are serialized per shard. Entries are evicted with the
+// CLOCK algorithm: a hand sweeps the slots, clearing the access bits which
+// are set, and evicting the first unreferenced entry whose access bit is
+// clear.
+
+#include <algorithm>
+#include <atomic>
+#include <glog/logging.h>
+#include <memory>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "kudu/gutil/bits.h"
+#include "kudu/gutil/hash/city.h"
+#include "kudu/gutil/stl_util.h"
+#include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/cache.h"
+#include "kudu/util/cache_metrics.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/logging.h"
+#include "kudu/util/mem_tracker.h"
+#include "kudu/util/metrics.h"
+
+namespace kudu {
+
+namespace {
+
+using std::atomic;
+using std::shared_ptr;
+using std::vector;
+
+typedef simple_spinlock MutexType;
+
+// An entry of the cache, whose key is stored inline.
+struct ClockHandle {
+  void* value;
+  CacheDeleter* deleter;
+  size_t charge;
+  size_t key_length;
+  // Chains entries removed from the cache until they are freed.
+  ClockHandle* next_to_free;
+  uint32_t hash;
+  bool detached;      // True if the entry was not admitted into the table.
+  uint8_t priority;   // The Cache::Priority of the entry, only used for metrics.
+  uint8_t key_data[1];   // Beginning of key
+
+  Slice key() const {
+    return Slice(key_data, key_length);
+  }
+};
+
+// The layout of Slot::meta.
+//
+// The lowest 32 bits are the number of references to the entry in the slot.
+// Lookups may transiently add references to slots of any state, which they
+// drop right away if the slot does not hold the entry they look for, so
+// state transitions other than from EMPTY or to exclusive ownership are made
+// with atomic additions, which preserve these references.
+const uint64_t kRefsMask = (1ULL << 32) - 1;
+// Set when the entry is looked up, cleared by the clock hand.
+const uint64_t kAccessedBit = 1ULL << 59;
+// Set for the slots of entries which were not admitted into the table.
+const uint64_t kDetachedBit = 1ULL << 60;
+const int kStateShift = 61;
+const uint64_t kStateMask = 3ULL << kStateShift;
+// The slot holds no entry.
+const uint64_t kStateEmpty = 0;
+// The slot is owned exclusively by a thread which fills or empties it.
+const uint64_t kStateExclusive = 1ULL << kStateShift;
+// The slot holds an entry which lookups may return.
+const uint64_t kStateVisible = 2ULL << kStateShift;
+// The slot holds an entry which was erased or replaced, and is freed once the
+// last reference to it is released.
+const uint64_t kStateInvisible = 3ULL << kStateShift;
+
+// A slot of the hash table of a shard.
+struct Slot {
+  Slot()
+      : meta(kStateEmpty),
+        displacements(0),
+        hash(0),
+        handle(nullptr) {
+  }
+
+  atomic<uint64_t> meta;
+
+  // The number of entries whose probe sequence goes past this slot. Lookups
+  // stop probing at the first slot without displacements.
+  atomic<uint32_t> displacements;
+
+  // The hash of the entry in the slot, which lookups check before acquiring
+  // a reference, so that they do not write to the slots of other keys. It is
+  // only a hint, which may be stale.
+  atomic<uint32_t> hash;
+
+  // The entry in the slot. Only valid while holding a reference to a visible
+  // or invisible entry, or exclusive ownership of the slot.
+  ClockHandle* handle;
+};
+
+// The maximum share of the slots of a table which are expected to be used,
+// which keeps probe sequences short.
+const double kMaxLoadFactor = 0.7;
+
+// A single shard of the cache.
+class ClockCacheShard {
+ public:
+  ClockCacheShard(MemTracker* tracker, size_t capacity, size_t num_slots);
+  ~ClockCacheShard();
+
+  void SetMetrics(CacheMetrics* metrics) { metrics_ = metrics; }
+
+  // Like Cache methods, but with an extra "hash" parameter.
+  Cache::Handle* Insert(const Slice& key, uint32_t hash, void* value, size_t charge,
+                        CacheDeleter* deleter, Cache::Priority priority);
+  Cache::Handle* Lookup(const Slice& key, uint32_t hash, bool caching,
+                        Cache::Priority priority);
+  void Release(Cache::Handle* handle);
+  void Erase(const Slice& key, uint32_t hash);
+  void VisitEntries(const Cache::EntryVisitor& visitor);
+
+ private:
+  // Returns the slot of the visible entry with the given key, with a
+  // reference to it acquired, or NULL if there is none.
+  Slot* FindAndRef(const Slice& key, uint32_t hash);
+
+  // Drops a reference to the entry in 'slot'. If it was the last reference to
+  // an invisible entry, removes the entry from the table, and returns it so
+  // that it is freed with FreeEntry(). Otherwise returns NULL.
+  ClockHandle* Unref(Slot* slot);
+
+  // Makes the visible entry of 'slot', to which a reference is held,
+  // invisible, and drops the reference. See Unref() for the return value.
+  ClockHandle* MakeInvisibleAndUnref(Slot* slot);
+
+  // Puts 'h' into a free slot of the table, with a reference to it acquired,
+  // and returns the slot. Returns NULL if the table is full.
+  //
+  // Requires 'mutex_'.
+  Slot* Place(ClockHandle* h);
+
+  // Removes the entry of 'slot', which must be exclusively owned, from the
+  // table, and returns it.
+  ClockHandle* RemoveFromTable(Slot* slot);
+
+  // Evicts entries until the usage of the shard fits in its capacity and a
+  // slot is left for a new entry within the maximum load factor, or until no
+  // entry can be evicted. The entries evicted are chained to '*to_free_head'.
+  //
+  // Both limits are needed: the table is sized from the estimated charge of
+  // the entries, so entries smaller than estimated fill the table before
+  // they fill the capacity.
+  //
+  // Requires 'mutex_'.
+  void EvictLocked(ClockHandle** to_free_head);
+
+  // Decrements the displacements of the 'count' slots from 'start' onwards.
+  void DecrementDisplacements(size_t start, size_t count);
+
+  // Calls the deleter of 'h' and frees it.
+  void FreeEntry(ClockHandle* h);
+
+  const size_t capacity_;
+  const size_t num_slots_;
+  const size_t slot_mask_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // The number of slots which may hold entries before evictions start.
+  const size_t max_occupied_slots_;
+
+  // The number of slots which hold entries, including the invisible ones
+  // which are still referenced.
+  atomic<size_t> occupied_slots_;
+
+  // The charge of the entries in the table, including the invisible ones
+  // which are still referenced.
+  atomic<size_t> usage_;
+
+  // Serializes inserts, erases and evictions.
+  MutexType mutex_;
+
+  // The next slot the clock hand looks at. Protected by 'mutex_'.
+  size_t clock_hand_;
+
+  MemTracker* mem_tracker_;
+
+  CacheMetrics* metrics_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClockCacheShard);
+};
+
+ClockCacheShard::ClockCacheShard(MemTracker* tracker, size_t capacity, size_t num_slots)
+    : capacity_(capacity),
+      num_slots_(num_slots),
+      slot_mask_(num_slots - 1),
+      slots_(new Slot[num_slots]),
+      max_occupied_slots_(num_slots * kMaxLoadFactor),
+      occupied_slots_(0),
+      usage_(0),
+      clock_hand_(0),
+      mem_tracker_(tracker),
+      metrics_(nullptr) {
+  DCHECK_EQ(0, num_slots & slot_mask_);
+}
+
+ClockCacheShard::~ClockCacheShard() {
+  for (size_t i = 0; i < num_slots_; i++) {
+    Slot* slot = &slots_[i];
+    uint64_t meta = slot->meta.load(std::memory_order_acquire);
+    DCHECK_EQ(0, meta & kRefsMask);  // Error if caller has an unreleased handle
+    if ((meta & kStateMask) != kStateEmpty) {
+      FreeEntry(slot->handle);
+    }
+  }
+}
+
+Slot* ClockCacheShard::FindAndRef(const Slice& key, uint32_t hash) {
+  size_t idx = hash & slot_mask_;
+  for (size_t probes = 0; probes < num_slots_; probes++) {
+    Slot* slot = &slots_[idx];
+    if (slot->hash.load(std::memory_order_relaxed) == hash) {
+      uint64_t meta = slot->meta.fetch_add(1, std::memory_order_acquire);
+      if ((meta & kStateMask) == kStateVisible &&
+          slot->handle->hash == hash &&
+          slot->handle->key() == key) {
+        return slot;
+      }
+      ClockHandle* to_free = Unref(slot);
+      if (PREDICT_FALSE(to_free != nullptr)) {
+        FreeEntry(to_free);
+      }
+    }
+    if (slot->displacements.load(std::memory_order_relaxed) == 0) {
+      break;
+    }
+    idx = (idx + 1) & slot_mask_;
+  }
+  return nullptr;
+}
+
+ClockHandle* ClockCacheShard::Unref(Slot* slot) {
+  uint64_t meta = slot->meta.fetch_sub(1, std::memory_order_acq_rel) - 1;
+  DCHECK_NE(kRefsMask, meta & kRefsMask);
+  if ((meta & kStateMask) != kStateInvisible || (meta & kRefsMask) != 0) {
+    return nullptr;
+  }
+  // Whichever thread dropped the last reference and takes ownership first
+  // removes the entry.
+  if (!slot->meta.compare_exchange_strong(meta, (meta & ~kStateMask) | kStateExclusive,
+                                          std::memory_order_acq_rel)) {
+    return nullptr;
+  }
+  if (meta & kDetachedBit) {
+    ClockHandle* h = slot->handle;
+    delete slot;
+    return h;
+  }
+  return RemoveFromTable(slot);
+}
+
+ClockHandle* ClockCacheShard::MakeInvisibleAndUnref(Slot* slot) {
+  slot->meta.fetch_add(kStateInvisible - kStateVisible, std::memory_order_acq_rel);
+  return Unref(slot);
+}
+
+Slot* ClockCacheShard::Place(ClockHandle* h) {
+  size_t idx = h->hash & slot_mask_;
+  for (size_t probes = 0; probes < num_slots_; probes++) {
+    Slot* slot = &slots_[idx];
+    uint64_t expected = kStateEmpty;
+    if (slot->meta.compare_exchange_strong(expected, kStateExclusive,
+                                           std::memory_order_acquire)) {
+      slot->handle = h;
+      slot->hash.store(h->hash, std::memory_order_relaxed);
+      occupied_slots_.fetch_add(1, std::memory_order_relaxed);
+      // Publish the entry, with the reference of the caller.
+      slot->meta.fetch_add(kStateVisible - kStateExclusive + 1, std::memory_order_release);
+      return slot;
+    }
+    slot->displacements.fetch_add(1, std::memory_order_relaxed);
+    idx = (idx + 1) & slot_mask_;
+  }
+  DecrementDisplacements(h->hash & slot_mask_, num_slots_);
+  return nullptr;
+}
+
+ClockHandle* ClockCacheShard::RemoveFromTable(Slot* slot) {
+  ClockHandle* h = slot->handle;
+  size_t idx = slot - slots_.get();
+  size_t home = h->hash & slot_mask_;
+  DecrementDisplacements(home, (idx - home) & slot_mask_);
+  usage_.fetch_sub(h->charge, std::memory_order_relaxed);
+  occupied_slots_.fetch_sub(1, std::memory_order_relaxed);
+  slot->handle = nullptr;
+  // Empty the slot, leaving the transient references of lookups, if any.
+  slot->meta.fetch_and(kRefsMask, std::memory_order_release);
+  return h;
+}
+
+void ClockCacheShard::EvictLocked(ClockHandle** to_free_head) {
+  // Two sweeps clear all the access bits, after which only referenced
+  // entries are left.
+  for (size_t steps = 0;
+       (usage_.load(std::memory_order_relaxed) > capacity_ ||
+        occupied_slots_.load(std::memory_order_relaxed) >= max_occupied_slots_) &&
+       steps < 2 * num_slots_;
+       steps++) {
+    Slot* slot = &slots_[clock_hand_++ & slot_mask_];
+    uint64_t meta = slot->meta.load(std::memory_order_relaxed);
+    if ((meta & kStateMask) != kStateVisible || (meta & kRefsMask) != 0) {
+      continue;
+    }
+    if (meta & kAccessedBit) {
+      slot->meta.fetch_and(~kAccessedBit, std::memory_order_relaxed);
+      continue;
+    }
+    if (slot->meta.compare_exchange_strong(meta, kStateExclusive,
+                                           std::memory_order_acq_rel)) {
+      ClockHandle* h = RemoveFromTable(slot);
+      h->next_to_free = *to_free_head;
+      *to_free_head = h;
+    }
+  }
+}
+
+void ClockCacheShard::DecrementDisplacements(size_t start, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    slots_[(start + i) & slot_mask_].displacements.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void ClockCacheShard::FreeEntry(ClockHandle* h) {
+  h->deleter->Delete(h->key(), h->value);
+  mem_tracker_->Release(h->charge);
+  if (PREDICT_TRUE(metrics_)) {
+    metrics_->cache_usage->DecrementBy(h->charge);
+    if (!h->detached) {
+      metrics_->evictions->Increment();
+    }
+  }
+  free(h);
+}
+
+Cache::Handle* ClockCacheShard::Lookup(const Slice& key, uint32_t hash, bool caching,
+                                       Cache::Priority priority) {
+  Slot* slot = FindAndRef(key, hash);
+  if (slot != nullptr &&
+      !(slot->meta.load(std::memory_order_relaxed) & kAccessedBit)) {
+    slot->meta.fetch_or(kAccessedBit, std::memory_order_relaxed);
+  }
+
+  if (metrics_) {
+    metrics_->lookups->Increment();
+    bool was_hit = (slot != nullptr);
+    if (was_hit) {
+      if (caching) {
+        metrics_->cache_hits_caching->Increment();
+      } else {
+        metrics_->cache_hits->Increment();
+      }
+    } else {
+      if (caching) {
+        metrics_->cache_misses_caching->Increment();
+      } else {
+        metrics_->cache_misses->Increment();
+      }
+    }
+    if (was_hit) {
+      priority = static_cast<Cache::Priority>(slot->handle->priority);
+    }
+    if (priority == Cache::HIGH_PRIORITY) {
+      (was_hit ? metrics_->high_priority_hits : metrics_->high_priority_misses)->Increment();
+    } else {
+      (was_hit ? metrics_->normal_priority_hits : metrics_->normal_priority_misses)->Increment();
+    }
+  }
+
+  return reinterpret_cast<Cache::Handle*>(slot);
+}
+
+void ClockCacheShard::Release(Cache::Handle* handle) {
+  ClockHandle* to_free = Unref(reinterpret_cast<Slot*>(handle));
+  if (to_free != nullptr) {
+    FreeEntry(to_free);
+  }
+}
+
+Cache::Handle* ClockCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
+                                       size_t charge, CacheDeleter* deleter,
+                                       Cache::Priority priority) {
+  ClockHandle* h = reinterpret_cast<ClockHandle*>(
+      malloc(sizeof(ClockHandle) - 1 + key.size()));
+  h->value = value;
+  h->deleter = deleter;
+  h->charge = charge;
+  h->key_length = key.size();
+  h->next_to_free = nullptr;
+  h->hash = hash;
+  h->detached = false;
+  h->priority = priority;
+  memcpy(h->key_data, key.data(), key.size());
+  mem_tracker_->Consume(charge);
+  if (PREDICT_TRUE(metrics_)) {
+    metrics_->cache_usage->IncrementBy(charge);
+    metrics_->inserts->Increment();
+  }
+
+  ClockHandle* to_free_head = nullptr;
+  Slot* slot;
+  {
+    lock_guard<MutexType> l(&mutex_);
+
+    // Replace the entry with the same key, if any.
+    Slot* old = FindAndRef(key, hash);
+    if (old != nullptr) {
+      to_free_head = MakeInvisibleAndUnref(old);
+    }
+
+    usage_.fetch_add(charge, std::memory_order_relaxed);
+    EvictLocked(&to_free_head);
+    slot = Place(h);
+    if (PREDICT_FALSE(slot == nullptr)) {
+      usage_.fetch_sub(charge, std::memory_order_relaxed);
+    }
+  }
+
+  // Free the entries outside of the mutex for performance reasons.
+  while (to_free_head != nullptr) {
+    ClockHandle* next = to_free_head->next_to_free;
+    FreeEntry(to_free_head);
+    to_free_head = next;
+  }
+
+  if (PREDICT_FALSE(slot == nullptr)) {
+    // The table is full: the entry only lives as long as the returned handle.
+    KLOG_EVERY_N_SECS(WARNING, 60) << "Clock cache table full, not caching new entries";
+    h->detached = true;
+    slot = new Slot();
+    slot->handle = h;
+    slot->hash.store(hash, std::memory_order_relaxed);
+    slot->meta.store(kStateInvisible | kDetachedBit | 1, std::memory_order_release);
+  }
+  return reinterpret_cast<Cache::Handle*>(slot);
+}
+
+void ClockCacheShard::Erase(const Slice& key, uint32_t hash) {
+  ClockHandle* to_free = nullptr;
+  {
+    lock_guard<MutexType> l(&mutex_);
+    Slot* slot = FindAndRef(key, hash);
+    if (slot != nullptr) {
+      to_free = MakeInvisibleAndUnref(slot);
+    }
+  }
+  if (to_free != nullptr) {
+    FreeEntry(to_free);
+  }
+}
+
+void ClockCacheShard::VisitEntries(const Cache::EntryVisitor& visitor) {
+  // Like lookups, take a reference to each entry while visiting it, so that
+  // the visit does not block the shard.
+  for (size_t i = 0; i < num_slots_; i++) {
+    Slot* slot = &slots_[i];
+    uint64_t meta = slot->meta.fetch_add(1, std::memory_order_acquire);
+    if ((meta & kStateMask) == kStateVisible) {
+      visitor(slot->handle->key(), slot->handle->value);
+    }
+    ClockHandle* to_free = Unref(slot);
+    if (to_free != nullptr) {
+      FreeEntry(to_free);
+    }
+  }
+}
+
+static const int kNumShardBits = 4;
+static const int kNumShards = 1 << kNumShardBits;
+
+class ShardedClockCache : public Cache {
+ private:
+  shared_ptr<MemTracker> mem_tracker_;
+  gscoped_ptr<CacheMetrics> metrics_;
+  vector<ClockCacheShard*> shards_;
+  MutexType id_mutex_;
+  uint64_t last_id_;
+
+  static inline uint32_t HashSlice(const Slice& s) {
+    return util_hash::CityHash64(
+      reinterpret_cast<const char *>(s.data()), s.size());
+  }
+
+  static uint32_t Shard(uint32_t hash) {
+    return hash >> (32 - kNumShardBits);
+  }
+
+ public:
+  ShardedClockCache(size_t capacity, const string& id, size_t estimated_charge)
+      : last_id_(0) {
+    // See ShardedLRUCache.
+    mem_tracker_ = MemTracker::FindOrCreateTracker(
+        -1, strings::Substitute("$0-clock_cache", id));
+
+    const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
+    const size_t entries_per_shard = per_shard / std::max<size_t>(estimated_charge, 1) + 1;
+    const size_t slots_per_shard = 1ULL << Bits::Log2Ceiling64(
+        std::max<size_t>(entries_per_shard / kMaxLoadFactor, 16));
+    for (int s = 0; s < kNumShards; s++) {
+      shards_.push_back(new ClockCacheShard(mem_tracker_.get(), per_shard, slots_per_shard));
+    }
+  }
+
+  virtual ~ShardedClockCache() {
+    STLDeleteElements(&shards_);
+  }
+
+  // Priorities are only kept for metrics: all entries are evicted in CLOCK order.
+  virtual Handle* Insert(const Slice& key, void* value, size_t charge,
+                         CacheDeleter* deleter, Priority priority) OVERRIDE {
+    const uint32_t hash = HashSlice(key);
+    return shards_[Shard(hash)]->Insert(key, hash, value, charge, deleter, priority);
+  }
+  virtual Handle* Lookup(const Slice& key, CacheBehavior caching,
+                         Priority priority) OVERRIDE {
+    const uint32_t hash = HashSlice(key);
+    return shards_[Shard(hash)]->Lookup(key, hash, caching == EXPECT_IN_CACHE, priority);
+  }
+  virtual void Release(Handle* handle) OVERRIDE {
+    Slot* slot = reinterpret_cast<Slot*>(handle);
+    shards_[Shard(slot->handle->hash)]->Release(handle);
+  }
+  virtual void Erase(const Slice& key) OVERRIDE {
+    const uint32_t hash = HashSlice(key);
+    shards_[Shard(hash)]->Erase(key, hash);
+  }
+  virtual void* Value(Handle* handle) OVERRIDE {
+    return reinterpret_cast<Slot*>(handle)->handle->value;
+  }
+  virtual uint64_t NewId() OVERRIDE {
+    lock_guard<MutexType> l(&id_mutex_);
+    return ++(last_id_);
+  }
+
+  virtual void SetMetrics(const scoped_refptr<MetricEntity>& entity) OVERRIDE {
+    metrics_.reset(new CacheMetrics(entity));
+    for (ClockCacheShard* shard : shards_) {
+      shard->SetMetrics(metrics_.get());
+    }
+  }
+
+  virtual void VisitEntries(const EntryVisitor& visitor) OVERRIDE {
+    for (ClockCacheShard* shard : shards_) {
+      shard->VisitEntries(visitor);
+    }
+  }
+
+  virtual uint8_t* Allocate(int bytes) OVERRIDE {
+    DCHECK_GE(bytes, 0);
+    return new uint8_t[bytes];
+  }
+
+  virtual void Free(uint8_t* ptr) OVERRIDE {
+    delete[] ptr;
+  }
+
+  virtual uint8_t* MoveToHeap(uint8_t* ptr, int size) OVERRIDE {
+    // Our allocated pointers are always on the heap.
+    return ptr;
+  }
+};
+
+}  // anonymous namespace
+
+Cache* NewClockCache(size_t capacity, const string& id, size_t estimated_charge) {
+  return new ShardedClockCache(capacity, id, estimated_charge);
+}
+
+}  // namespace kudu
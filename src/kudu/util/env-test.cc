@@ -49,6 +49,7 @@
 
 namespace kudu {
 
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -135,6 +136,36 @@ class TestEnv : public KuduTest {
     ASSERT_NO_FATAL_FAILURE(VerifyTestData(s, offset));
   }
 
+  // Reads ranges of 'file', of 'file_size' bytes of test data, with
+  // ReadV(): out of order, adjacent, overlapping and empty ones.
+  template<class File>
+  void ReadVAndVerifyTestData(const File& file, size_t file_size) {
+    const vector<pair<uint64_t, size_t>> kRanges = {
+      { 5000, 1000 }, { 0, 100 }, { 100, 200 }, { 300, 4096 },
+      { 250, 100 }, { 6000, 0 }, { file_size - 10, 10 }
+    };
+    gscoped_ptr<uint8_t[]> scratch(new uint8_t[file_size]);
+    uint8_t* dst = scratch.get();
+    vector<ReadRange> ranges;
+    for (const auto& r : kRanges) {
+      ranges.emplace_back(r.first, r.second, dst);
+      dst += r.second;
+    }
+    ASSERT_OK(file.ReadV(&ranges));
+    for (const ReadRange& range : ranges) {
+      ASSERT_EQ(range.length, range.result.size());
+      ASSERT_NO_FATAL_FAILURE(VerifyTestData(range.result, range.offset));
+    }
+
+    // A range past the end of the file fails the whole read.
+    ranges.clear();
+    ranges.emplace_back(0, 100, scratch.get());
+    ranges.emplace_back(file_size - 100, 200, scratch.get() + 100);
+    Status s = file.ReadV(&ranges);
+    ASSERT_TRUE(s.IsIOError()) << s.ToString();
+    ASSERT_STR_CONTAINS(s.ToString(), "EOF");
+  }
+
   void TestAppendVector(size_t num_slices, size_t slice_size, size_t iterations,
                         bool fast, bool pre_allocate, const WritableFileOptions& opts) {
     const string kTestPath = GetTestPath("test_env_appendvec_read_append");
@@ -417,6 +448,63 @@ TEST_F(TestEnv, TestReadFully) {
   ASSERT_STR_CONTAINS(status.ToString(), "EOF");
 }
 
+TEST_F(TestEnv, TestReadV) {
+  const string kTestPath = GetTestPath("test");
+  const int kFileSize = 64 * 1024;
+  WriteTestFile(env_.get(), kTestPath, kFileSize);
+  ASSERT_NO_FATAL_FAILURE();
+
+  shared_ptr<RandomAccessFile> raf;
+  ASSERT_OK(env_util::OpenFileForRandom(env_.get(), kTestPath, &raf));
+  ASSERT_NO_FATAL_FAILURE(ReadVAndVerifyTestData(*raf, kFileSize));
+
+  gscoped_ptr<RWFile> rwf;
+  RWFileOptions opts;
+  opts.mode = Env::OPEN_EXISTING;
+  ASSERT_OK(env_->NewRWFile(opts, kTestPath, &rwf));
+  ASSERT_NO_FATAL_FAILURE(ReadVAndVerifyTestData(*rwf, kFileSize));
+
+  // The default implementation, which reads the ranges one by one, must
+  // behave the same, including with short reads.
+  gscoped_ptr<Env> mem(NewMemEnv(Env::Default()));
+  WriteTestFile(mem.get(), kTestPath, kFileSize);
+  ASSERT_NO_FATAL_FAILURE();
+  ASSERT_OK(env_util::OpenFileForRandom(mem.get(), kTestPath, &raf));
+  ShortReadRandomAccessFile sr_raf(raf);
+  ASSERT_NO_FATAL_FAILURE(ReadVAndVerifyTestData(sr_raf, kFileSize));
+}
+
+// Test direct reads at offsets and of lengths which are not aligned to the
+// filesystem's block size. If the filesystem of the test directory does not
+// support direct I/O, this exercises the fallback to buffered reads instead.
+TEST_F(TestEnv, TestDirectIORead) {
+  const string kTestPath = GetTestPath("test");
+  const int kFileSize = 64 * 1024 + 123;
+  WriteTestFile(env_.get(), kTestPath, kFileSize);
+  ASSERT_NO_FATAL_FAILURE();
+
+  RandomAccessFileOptions opts;
+  opts.direct_io = true;
+  gscoped_ptr<RandomAccessFile> raf;
+  ASSERT_OK(env_->NewRandomAccessFile(opts, kTestPath, &raf));
+  uint64_t size;
+  ASSERT_OK(raf->Size(&size));
+  ASSERT_EQ(kFileSize, size);
+
+  ASSERT_NO_FATAL_FAILURE(ReadAndVerifyTestData(raf.get(), 0, 4096));
+  ASSERT_NO_FATAL_FAILURE(ReadAndVerifyTestData(raf.get(), 17, 10000));
+  ASSERT_NO_FATAL_FAILURE(ReadAndVerifyTestData(raf.get(), 4095, 2));
+  ASSERT_NO_FATAL_FAILURE(ReadAndVerifyTestData(raf.get(), kFileSize - 200, 200));
+  ASSERT_NO_FATAL_FAILURE(ReadVAndVerifyTestData(*raf, kFileSize));
+
+  // Reading past EOF fails like a buffered read does.
+  gscoped_ptr<uint8_t[]> scratch(new uint8_t[200]);
+  Slice s;
+  Status status = env_util::ReadFully(raf.get(), kFileSize - 100, 200, &s, scratch.get());
+  ASSERT_TRUE(status.IsIOError()) << status.ToString();
+  ASSERT_STR_CONTAINS(status.ToString(), "EOF");
+}
+
 TEST_F(TestEnv, TestAppendVector) {
   WritableFileOptions opts;
   LOG(INFO) << "Testing AppendVector() only, NO pre-allocation";
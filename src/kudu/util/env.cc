@@ -3,8 +3,13 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include "kudu/util/env.h"
+
+#include "kudu/gutil/strings/substitute.h"
 #include "kudu/util/faststring.h"
 
+using std::vector;
+using strings::Substitute;
+
 namespace kudu {
 
 Env::~Env() {
@@ -16,12 +21,49 @@ SequentialFile::~SequentialFile() {
 RandomAccessFile::~RandomAccessFile() {
 }
 
+Status RandomAccessFile::ReadV(vector<ReadRange>* ranges) const {
+  for (ReadRange& range : *ranges) {
+    uint64_t offset = range.offset;
+    size_t rem = range.length;
+    uint8_t* dst = range.scratch;
+    while (rem > 0) {
+      Slice this_result;
+      RETURN_NOT_OK(Read(offset, rem, &this_result, dst));
+      DCHECK_LE(this_result.size(), rem);
+      if (this_result.size() == 0) {
+        return Status::IOError(Substitute("EOF trying to read $0 bytes at offset $1",
+                                          range.length, range.offset));
+      }
+      if (this_result.size() == range.length) {
+        // The whole range was read at once, possibly without a copy.
+        range.result = this_result;
+        break;
+      }
+      this_result.relocate(dst);
+      dst += this_result.size();
+      rem -= this_result.size();
+      offset += this_result.size();
+      if (rem == 0) {
+        range.result = Slice(range.scratch, range.length);
+      }
+    }
+  }
+  return Status::OK();
+}
+
 WritableFile::~WritableFile() {
 }
 
 RWFile::~RWFile() {
 }
 
+Status RWFile::ReadV(vector<ReadRange>* ranges) const {
+  for (ReadRange& range : *ranges) {
+    RETURN_NOT_OK(Read(range.offset, range.length, &range.result, range.scratch));
+  }
+  return Status::OK();
+}
+
 FileLock::~FileLock() {
 }
 
@@ -20,6 +20,7 @@
 
 #include "kudu/gutil/callback_forward.h"
 #include "kudu/gutil/gscoped_ptr.h"
+#include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 
 namespace kudu {
@@ -28,7 +29,6 @@ class FileLock;
 class RandomAccessFile;
 class RWFile;
 class SequentialFile;
-class Slice;
 class WritableFile;
 
 struct RandomAccessFileOptions;
@@ -290,6 +290,25 @@ class SequentialFile {
   virtual const std::string& filename() const = 0;
 };
 
+// A range of a file to read with ReadV(), and the buffer to read it into.
+struct ReadRange {
+  ReadRange(uint64_t offset, size_t length, uint8_t* scratch)
+      : offset(offset),
+        length(length),
+        scratch(scratch) {
+  }
+
+  uint64_t offset;
+  size_t length;
+
+  // Must be at least 'length' bytes in size.
+  uint8_t* scratch;
+
+  // Set by ReadV() to the data that was read, which may point into 'scratch',
+  // so 'scratch' must be live when 'result' is used.
+  Slice result;
+};
+
 // A file abstraction for randomly reading the contents of a file.
 class RandomAccessFile {
  public:
@@ -308,6 +327,18 @@ class RandomAccessFile {
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       uint8_t *scratch) const = 0;
 
+  // Reads exactly the given ranges of the file, setting the 'result' of
+  // each range. The ranges may be in any order, and may overlap.
+  //
+  // Unlike Read(), returns an IOError if the end of the file is reached
+  // before all of a range is read.
+  //
+  // Implementations may read ranges which are adjacent in the file with
+  // a single I/O. The default implementation reads the ranges one by one.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual Status ReadV(std::vector<ReadRange>* ranges) const;
+
   // Returns the size of the file
   virtual Status Size(uint64_t *size) const = 0;
 
@@ -334,7 +365,14 @@ struct WritableFileOptions {
 
 // Options specified when a file is opened for random access.
 struct RandomAccessFileOptions {
-  RandomAccessFileOptions() {}
+  RandomAccessFileOptions()
+    : direct_io(false) {
+  }
+
+  // Read the file with direct I/O, bypassing the OS page cache, where the
+  // platform and filesystem support it. Reads of any offset and length are
+  // allowed nonetheless: they go through temporary aligned buffers.
+  bool direct_io;
 };
 
 // A file abstraction for sequential writing.  The implementation
@@ -430,6 +468,10 @@ class RWFile {
   virtual Status Read(uint64_t offset, size_t length,
                       Slice* result, uint8_t* scratch) const = 0;
 
+  // Like Read(), for each of the given ranges of the file. See
+  // RandomAccessFile::ReadV().
+  virtual Status ReadV(std::vector<ReadRange>* ranges) const;
+
   // Writes 'data' to the file position given by 'offset'.
   virtual Status Write(uint64_t offset, const Slice& data) = 0;
 
@@ -19,6 +19,8 @@
 #include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
+
+#include <algorithm>
 #include <vector>
 
 #include "kudu/gutil/atomicops.h"
@@ -26,6 +28,7 @@
 #include "kudu/gutil/callback.h"
 #include "kudu/gutil/map-util.h"
 #include "kudu/gutil/strings/substitute.h"
+#include "kudu/util/alignment.h"
 #include "kudu/util/debug/trace_event.h"
 #include "kudu/util/env.h"
 #include "kudu/util/errno.h"
@@ -203,6 +206,88 @@ static Status DoOpen(const string& filename, Env::CreateMode mode, int* fd) {
   return Status::OK();
 }
 
+// Reads exactly 'length' bytes of 'fd' at 'offset' into the buffers of the
+// 'iovcnt' elements of 'iov', which may be modified.
+static Status DoPreadv(int fd, const string& filename, uint64_t offset, size_t length,
+                       struct iovec* iov, int iovcnt) {
+  size_t rem = length;
+  while (rem > 0) {
+#if defined(__linux__)
+    ssize_t r = preadv(fd, iov, iovcnt, offset);
+#else
+    ssize_t r = pread(fd, iov->iov_base, iov->iov_len, offset);
+#endif
+    if (PREDICT_FALSE(r < 0)) {
+      return IOError(filename, errno);
+    }
+    if (PREDICT_FALSE(r == 0)) {
+      return Status::IOError(Substitute("EOF trying to read $0 bytes at offset $1",
+                                        rem, offset));
+    }
+    size_t n = r;
+    offset += n;
+    rem -= n;
+
+    // Skip the buffers which were filled, and the part of the last one which
+    // was filled, if any.
+    while (iovcnt > 0 && n >= iov->iov_len) {
+      n -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (n > 0) {
+      iov->iov_base = reinterpret_cast<uint8_t*>(iov->iov_base) + n;
+      iov->iov_len -= n;
+    }
+  }
+  return Status::OK();
+}
+
+// Implements RandomAccessFile::ReadV() and RWFile::ReadV() for 'fd'.
+//
+// The ranges are read in the order of their offsets, and each run of ranges
+// which are adjacent in the file is read with a single preadv() call.
+static Status DoReadV(int fd, const string& filename, vector<ReadRange>* ranges) {
+  ThreadRestrictions::AssertIOAllowed();
+  vector<ReadRange*> sorted;
+  sorted.reserve(ranges->size());
+  for (ReadRange& range : *ranges) {
+    sorted.push_back(&range);
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const ReadRange* a, const ReadRange* b) {
+    return a->offset < b->offset;
+  });
+
+  static const size_t kIovMaxElements = IOV_MAX;
+  vector<struct iovec> iov;
+  size_t i = 0;
+  while (i < sorted.size()) {
+    uint64_t run_offset = sorted[i]->offset;
+    size_t run_length = 0;
+    iov.clear();
+    size_t j = i;
+    do {
+      ReadRange* range = sorted[j];
+      if (range->length > 0) {
+        struct iovec v;
+        v.iov_base = range->scratch;
+        v.iov_len = range->length;
+        iov.push_back(v);
+      }
+      run_length += range->length;
+      j++;
+    } while (j < sorted.size() &&
+             sorted[j]->offset == run_offset + run_length &&
+             iov.size() < kIovMaxElements);
+
+    RETURN_NOT_OK(DoPreadv(fd, filename, run_offset, run_length, iov.data(), iov.size()));
+    for (; i < j; i++) {
+      sorted[i]->result = Slice(sorted[i]->scratch, sorted[i]->length);
+    }
+  }
+  return Status::OK();
+}
+
 class PosixSequentialFile: public SequentialFile {
  private:
   std::string filename_;
@@ -243,7 +328,7 @@ class PosixSequentialFile: public SequentialFile {
 
 // pread() based random-access
 class PosixRandomAccessFile: public RandomAccessFile {
- private:
+ protected:
   std::string filename_;
   int fd_;
 
@@ -265,6 +350,10 @@ class PosixRandomAccessFile: public RandomAccessFile {
     return s;
   }
 
+  virtual Status ReadV(vector<ReadRange>* ranges) const OVERRIDE {
+    return DoReadV(fd_, filename_, ranges);
+  }
+
   virtual Status Size(uint64_t *size) const OVERRIDE {
     TRACE_EVENT1("io", "PosixRandomAccessFile::Size", "path", filename_);
     ThreadRestrictions::AssertIOAllowed();
@@ -283,6 +372,64 @@ class PosixRandomAccessFile: public RandomAccessFile {
   }
 };
 
+#if defined(__linux__)
+// A PosixRandomAccessFile whose file descriptor was opened with O_DIRECT.
+//
+// Direct reads must be of whole, aligned sectors into aligned memory, so
+// each read goes through a temporary aligned buffer which is copied into
+// the caller's scratch. The copy is cheap compared to the I/O, and the data
+// is not cached by the OS.
+class PosixDirectRandomAccessFile : public PosixRandomAccessFile {
+ public:
+  // The alignment required by direct I/O on all the filesystems we support.
+  static const size_t kAlignment = 4096;
+
+  PosixDirectRandomAccessFile(std::string fname, int fd)
+      : PosixRandomAccessFile(std::move(fname), fd) {
+  }
+
+  virtual Status Read(uint64_t offset, size_t n, Slice* result,
+                      uint8_t *scratch) const OVERRIDE {
+    ThreadRestrictions::AssertIOAllowed();
+    uint64_t aligned_offset = KUDU_ALIGN_DOWN(offset, kAlignment);
+    size_t aligned_length = KUDU_ALIGN_UP(offset + n, kAlignment) - aligned_offset;
+    void* buf;
+    if (PREDICT_FALSE(posix_memalign(&buf, kAlignment, aligned_length) != 0)) {
+      return Status::RuntimeError(Substitute("Unable to allocate $0 bytes for direct read",
+                                             aligned_length));
+    }
+    gscoped_ptr<uint8_t, FreeDeleter> buf_deleter(reinterpret_cast<uint8_t*>(buf));
+
+    // Read until the end of the range or of the file, whichever comes first.
+    // A short read means the end of the file was reached.
+    size_t done = 0;
+    while (done < aligned_length) {
+      ssize_t r = pread(fd_, reinterpret_cast<uint8_t*>(buf) + done,
+                        aligned_length - done, aligned_offset + done);
+      if (PREDICT_FALSE(r < 0)) {
+        *result = Slice(scratch, 0);
+        return IOError(filename_, errno);
+      }
+      done += r;
+      if (r == 0 || done % kAlignment != 0) {
+        break;
+      }
+    }
+
+    size_t skip = offset - aligned_offset;
+    size_t copied = done > skip ? std::min(n, done - skip) : 0;
+    memcpy(scratch, reinterpret_cast<uint8_t*>(buf) + skip, copied);
+    *result = Slice(scratch, copied);
+    return Status::OK();
+  }
+
+  virtual Status ReadV(vector<ReadRange>* ranges) const OVERRIDE {
+    // Read the ranges one by one, through aligned buffers.
+    return RandomAccessFile::ReadV(ranges);
+  }
+};
+#endif
+
 // Use non-memory mapped POSIX files to write data to a file.
 //
 // TODO (perf) investigate zeroing a pre-allocated allocated area in
@@ -519,6 +666,10 @@ class PosixRWFile : public RWFile {
     return Status::OK();
   }
 
+  virtual Status ReadV(vector<ReadRange>* ranges) const OVERRIDE {
+    return DoReadV(fd_, filename_, ranges);
+  }
+
   virtual Status Write(uint64_t offset, const Slice& data) OVERRIDE {
     ThreadRestrictions::AssertIOAllowed();
     ssize_t written = pwrite(fd_, data.data(), data.size(), offset);
@@ -689,6 +840,21 @@ class PosixEnv : public Env {
                                      gscoped_ptr<RandomAccessFile>* result) OVERRIDE {
     TRACE_EVENT1("io", "PosixEnv::NewRandomAccessFile", "path", fname);
     ThreadRestrictions::AssertIOAllowed();
+#if defined(__linux__)
+    if (opts.direct_io) {
+      int fd = open(fname.c_str(), O_RDONLY | O_DIRECT);
+      if (fd >= 0) {
+        result->reset(new PosixDirectRandomAccessFile(fname, fd));
+        return Status::OK();
+      }
+      if (errno != EINVAL) {
+        return IOError(fname, errno);
+      }
+      // The filesystem does not support direct I/O.
+      KLOG_FIRST_N(WARNING, 1) << "Unable to open " << fname << " for direct I/O, "
+                               << "reading it through the page cache instead";
+    }
+#endif
     int fd = open(fname.c_str(), O_RDONLY);
     if (fd < 0) {
       return IOError(fname, errno);
@@ -84,6 +84,7 @@ struct LRUHandle {
   size_t key_length;
   Atomic32 refs;
   uint32_t hash;      // Hash of key(); used for fast sharding and comparisons
+  uint8_t priority;   // The Cache::Priority of the entry, only used for metrics.
   uint8_t key_data[1];   // Beginning of key
 
   Slice key() const {
@@ -197,10 +198,12 @@ class NvmLRUCache {
   // Like Cache methods, but with an extra "hash" parameter.
   Cache::Handle* Insert(const Slice& key, uint32_t hash,
                         void* value, size_t charge,
-                        CacheDeleter* deleter);
-  Cache::Handle* Lookup(const Slice& key, uint32_t hash, bool caching);
+                        CacheDeleter* deleter, Cache::Priority priority);
+  Cache::Handle* Lookup(const Slice& key, uint32_t hash, bool caching,
+                        Cache::Priority priority);
   void Release(Cache::Handle* handle);
   void Erase(const Slice& key, uint32_t hash);
+  void VisitEntries(const Cache::EntryVisitor& visitor);
   void* AllocateAndRetry(size_t size);
 
  private:
@@ -330,7 +333,8 @@ void NvmLRUCache::NvmLRU_Append(LRUHandle* e) {
   usage_ += e->charge;
 }
 
-Cache::Handle* NvmLRUCache::Lookup(const Slice& key, uint32_t hash, bool caching) {
+Cache::Handle* NvmLRUCache::Lookup(const Slice& key, uint32_t hash, bool caching,
+                                   Cache::Priority priority) {
  LRUHandle* e;
   {
     lock_guard<MutexType> l(&mutex_);
@@ -361,6 +365,14 @@ Cache::Handle* NvmLRUCache::Lookup(const Slice& key, uint32_t hash, bool caching
         metrics_->cache_misses->Increment();
       }
     }
+    if (was_hit) {
+      priority = static_cast<Cache::Priority>(e->priority);
+    }
+    if (priority == Cache::HIGH_PRIORITY) {
+      (was_hit ? metrics_->high_priority_hits : metrics_->high_priority_misses)->Increment();
+    } else {
+      (was_hit ? metrics_->normal_priority_hits : metrics_->normal_priority_misses)->Increment();
+    }
   }
 
   return reinterpret_cast<Cache::Handle*>(e);
@@ -394,7 +406,7 @@ void NvmLRUCache::FreeLRUEntries(LRUHandle* to_free_head) {
 
 Cache::Handle* NvmLRUCache::Insert(const Slice& key, uint32_t hash,
                                    void* value, size_t charge,
-                                   CacheDeleter* deleter) {
+                                   CacheDeleter* deleter, Cache::Priority priority) {
   // Account for nvm key memory.
   LRUHandle* e = reinterpret_cast<LRUHandle*>(
       AllocateAndRetry(sizeof(LRUHandle) - 1 /* sizeof(LRUHandle::key_data) */ + key.size()));
@@ -415,6 +427,7 @@ Cache::Handle* NvmLRUCache::Insert(const Slice& key, uint32_t hash,
   e->refs = 2;  // One from LRUCache, one for the returned handle
   e->key_length = key.size();
   e->deleter = deleter;
+  e->priority = priority;
   if (PREDICT_TRUE(metrics_)) {
     metrics_->cache_usage->IncrementBy(e->charge);
     metrics_->inserts->Increment();
@@ -463,6 +476,14 @@ void NvmLRUCache::Erase(const Slice& key, uint32_t hash) {
     FreeEntry(e);
   }
 }
+
+void NvmLRUCache::VisitEntries(const Cache::EntryVisitor& visitor) {
+  lock_guard<MutexType> l(&mutex_);
+  for (LRUHandle* e = lru_.prev; e != &lru_; e = e->prev) {
+    visitor(e->key(), e->value);
+  }
+}
+
 static const int kNumShardBits = 4;
 static const int kNumShards = 1 << kNumShardBits;
 
@@ -504,14 +525,16 @@ class ShardedLRUCache : public Cache {
     vmem_delete(vmp_);
   }
 
+  // Priorities are only kept for metrics: all entries are evicted in LRU order.
   virtual Handle* Insert(const Slice& key, void* value, size_t charge,
-                         CacheDeleter* deleter) OVERRIDE {
+                         CacheDeleter* deleter, Priority priority) OVERRIDE {
     const uint32_t hash = HashSlice(key);
-    return shards_[Shard(hash)]->Insert(key, hash, value, charge, deleter);
+    return shards_[Shard(hash)]->Insert(key, hash, value, charge, deleter, priority);
   }
-  virtual Handle* Lookup(const Slice& key, CacheBehavior caching) OVERRIDE {
+  virtual Handle* Lookup(const Slice& key, CacheBehavior caching,
+                         Priority priority) OVERRIDE {
     const uint32_t hash = HashSlice(key);
-    return shards_[Shard(hash)]->Lookup(key, hash, caching == EXPECT_IN_CACHE);
+    return shards_[Shard(hash)]->Lookup(key, hash, caching == EXPECT_IN_CACHE, priority);
   }
   virtual void Release(Handle* handle) OVERRIDE {
     LRUHandle* h = reinterpret_cast<LRUHandle*>(handle);
@@ -534,6 +557,11 @@ class ShardedLRUCache : public Cache {
       cache->SetMetrics(metrics_.get());
     }
   }
+  virtual void VisitEntries(const EntryVisitor& visitor) OVERRIDE {
+    for (NvmLRUCache* cache : shards_) {
+      cache->VisitEntries(visitor);
+    }
+  }
   virtual uint8_t* Allocate(int size) OVERRIDE {
     // Try allocating from each of the shards -- if vmem is tight,
     // this can cause eviction, so we might have better luck in different
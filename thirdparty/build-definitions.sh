@@ -205,11 +205,19 @@ build_zlib() {
 
 build_lz4() {
   cd $LZ4_DIR
-  CFLAGS="$EXTRA_CFLAGS" cmake -DCMAKE_BUILD_TYPE=release \
+  # The static library is linked into the client's shared object.
+  CFLAGS="$EXTRA_CFLAGS -fPIC" cmake -DCMAKE_BUILD_TYPE=release \
     -DBUILD_TOOLS=0 -DCMAKE_INSTALL_PREFIX:PATH=$PREFIX cmake_unofficial/
   make -j$PARALLEL install
 }
 
+build_zstd() {
+  cd $ZSTD_DIR/lib
+  # Only the static library is used, so it may be linked into shared objects.
+  CFLAGS="$EXTRA_CFLAGS -fPIC" make -j$PARALLEL libzstd.a
+  make PREFIX=$PREFIX install
+}
+
 build_bitshuffle() {
   cd $BITSHUFFLE_DIR
   # bitshuffle depends on lz4, therefore set the flag I$PREFIX/include
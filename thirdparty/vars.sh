@@ -53,6 +53,9 @@ SNAPPY_DIR=$TP_DIR/snappy-$SNAPPY_VERSION
 LZ4_VERSION=r130
 LZ4_DIR=$TP_DIR/lz4-lz4-$LZ4_VERSION
 
+ZSTD_VERSION=1.3.0
+ZSTD_DIR=$TP_DIR/zstd-$ZSTD_VERSION
+
 # from https://github.com/kiyo-masui/bitshuffle
 # Hash of git: c5c928fe7d4bc5b9391748a8dd29de5a89c3c94a
 BITSHUFFLE_VERSION=c5c928f